@@ -1,5 +1,6 @@
 #include "brick.h"
 #include "graphics.h"
+#include "software_rasterizer.h"
 #include "ball.h"
 #include "assertions_console.h"
 
@@ -19,7 +20,7 @@ void Brick::render( Graphics &gfx ) const cond_noex
 {
 	if ( !m_bDestroyed )
 	{
-		gfx.drawRectangle( m_rect.calcScaled( -s_margin ), m_color );
+		gfx.softwareRasterizer().fillRect( m_rect.calcScaled( -s_margin ), m_color );
 	}
 }
 
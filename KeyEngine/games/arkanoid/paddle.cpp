@@ -2,6 +2,7 @@
 #include "ball.h"
 #include "rectangle.h"
 #include "graphics.h"
+#include "software_rasterizer.h"
 
 
 namespace dx = DirectX;
@@ -24,10 +25,10 @@ Paddle::Paddle( const dx::XMFLOAT2 &pos,
 void Paddle::render( Graphics &gfx ) const cond_noex
 {
 	RectangleF rect = this->rect();
-	gfx.drawRectangle( rect, m_wingColor );
+	gfx.softwareRasterizer().fillRect( rect, m_wingColor );
 	rect.getLeft() += s_wingWidth;
 	rect.getRight() -= s_wingWidth;
-	gfx.drawRectangle( rect, m_color );
+	gfx.softwareRasterizer().fillRect( rect, m_color );
 }
 
 bool Paddle::doBallCollision( Ball &ball )
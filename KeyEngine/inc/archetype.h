@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "entity_defines.h"
+#include "non_copyable.h"
+
+
+using ComponentTypeId = std::uint32_t;
+using ComponentMask = std::uint64_t;
+
+///=============================================================
+/// \class	ComponentRegistry
+/// \author	KeyC0de
+/// \date	17/10/2026 16:40
+/// \brief	hands out a dense id (< s_maxComponentTypes) to every component type on first use & stores how to move/destroy it
+/// \brief	components must be nothrow move constructible & aligned to at most s_maxAlignment bytes
+///=============================================================
+class ComponentRegistry final
+{
+public:
+	static constexpr unsigned s_maxComponentTypes = 64u;
+	static constexpr std::size_t s_maxAlignment = 64u;
+
+	struct TypeInfo final
+	{
+		std::size_t m_size;
+		std::size_t m_alignment;
+		/// \brief	move constructs *pDst from *pSrc & destroys *pSrc
+		void ( *m_pfnRelocate )( void *pDst, void *pSrc ) noexcept;
+		void ( *m_pfnDestroy )( void *p ) noexcept;
+	};
+public:
+	/// \brief	const T & T share the same id
+	template<typename T>
+	static ComponentTypeId getId()
+	{
+		return getIdImpl<std::remove_cv_t<T>>();
+	}
+
+	template<typename ... Ts>
+	static ComponentMask getMask()
+	{
+		return ( ComponentMask{0} | ... | ( ComponentMask{1} << getId<Ts>() ) );
+	}
+
+	static const TypeInfo& getInfo( const ComponentTypeId id ) noexcept;
+private:
+	static ComponentTypeId registerType( const TypeInfo &info );
+
+	template<typename T>
+	static ComponentTypeId getIdImpl()
+	{
+		static_assert( std::is_nothrow_move_constructible_v<T>, "Components must be nothrow move constructible!" );
+		static_assert( alignof( T ) <= s_maxAlignment, "Component alignment is too large!" );
+		static const ComponentTypeId id = registerType( TypeInfo{sizeof( T ), alignof( T ), &relocate<T>, &destroy<T>} );
+		return id;
+	}
+
+	template<typename T>
+	static void relocate( void *pDst, void *pSrc ) noexcept
+	{
+		T *pSrcT = static_cast<T*>( pSrc );
+		new( pDst ) T( std::move( *pSrcT ) );
+		pSrcT->~T();
+	}
+
+	template<typename T>
+	static void destroy( void *p ) noexcept
+	{
+		static_cast<T*>( p )->~T();
+	}
+};
+
+
+///=============================================================
+/// \class	Archetype
+/// \author	KeyC0de
+/// \date	17/10/2026 16:40
+/// \brief	stores every entity that has exactly the same set of components
+/// \brief	entities are packed into fixed size chunks; inside a chunk every component (& the EntityIds) is a contiguous column (SoA)
+/// \brief	rows are kept dense: removing a row moves the archetype's last row into the hole
+/// \brief	rows are numbered globally, row r lives in chunk r / getChunkCapacity()
+///=============================================================
+class Archetype final
+	: public NonCopyableAndNonMovable
+{
+public:
+	static constexpr std::size_t s_chunkSize = 16384u;	// bytes
+	static constexpr std::uint32_t s_noEdge = 0xFFFFFFFFu;
+private:
+	struct ChunkDeleter final
+	{
+		void operator()( unsigned char *p ) const noexcept;
+	};
+
+	ComponentMask m_mask;
+	std::vector<ComponentTypeId> m_componentTypes;
+	std::vector<std::size_t> m_columnOffsets;		// per m_componentTypes entry
+	std::int8_t m_columnOf[ComponentRegistry::s_maxComponentTypes];	// -1 if the component isn't part of this archetype
+	std::size_t m_chunkCapacity;
+	std::vector<std::unique_ptr<unsigned char, ChunkDeleter>> m_chunks;
+	std::size_t m_count = 0;
+	/// \brief	archetype index reached by adding/removing component c - cached by the EntityManager
+	std::uint32_t m_edges[ComponentRegistry::s_maxComponentTypes];
+public:
+	explicit Archetype( const ComponentMask mask );
+	/// \brief	destroys the components of every live row; the chunks themselves only free raw storage
+	~Archetype() noexcept;
+
+	/// \brief	appends a row for the entity; its components are left unconstructed
+	std::uint32_t allocateRow( const EntityId id );
+	/// \brief	removes the row by relocating the last row into it
+	/// \brief	the row's components must have been destroyed or relocated already
+	/// \brief	returns the id of the entity that now occupies `row`, or s_invalidEntityId if it was the last row
+	EntityId removeRow( const std::uint32_t row ) noexcept;
+	void destroyRowComponents( const std::uint32_t row ) noexcept;
+	/// \brief	relocates the row's shared components into dst's dstRow & destroys the rest
+	void relocateRowTo( const std::uint32_t row, Archetype &dst, const std::uint32_t dstRow ) noexcept;
+
+	bool hasComponent( const ComponentTypeId id ) const noexcept;
+	void* getComponent( const ComponentTypeId id, const std::uint32_t row ) noexcept;
+	EntityId getEntityId( const std::uint32_t row ) const noexcept;
+
+	ComponentMask getMask() const noexcept;
+	std::size_t getCount() const noexcept;
+	std::size_t getChunkCapacity() const noexcept;
+	std::size_t getChunkCount() const noexcept;
+	/// \brief	number of live rows in the chunk
+	std::size_t getChunkRowCount( const std::size_t chunkIndex ) const noexcept;
+	/// \brief	start of the component's column in the chunk
+	void* getColumn( const ComponentTypeId id, const std::size_t chunkIndex ) noexcept;
+	const EntityId* getEntityIds( const std::size_t chunkIndex ) const noexcept;
+	std::uint32_t getEdge( const ComponentTypeId id ) const noexcept;
+	void setEdge( const ComponentTypeId id, const std::uint32_t archetypeIndex ) noexcept;
+private:
+	unsigned char* getComponentAddress( const std::size_t column, const std::uint32_t row ) noexcept;
+};
\ No newline at end of file
@@ -27,6 +27,8 @@ protected:
 	/// \brief	bind RTV or DSV and other bindables shared by all Pass objects
 	/// \brief	call this function as the first thing you do on a child class's run function
 	void bind( Graphics &gfx ) const cond_noex;
+	/// \brief	rebinds the Pass bindables; the render surfaces are always bound by the Passes that use them
+	void bindSharedState( Graphics &gfx ) const cond_noex override;
 	void validate() override;
 
 	template<class T>
@@ -1,28 +1,190 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
 #include <unordered_map>
 #include "bindable.h"
 
 
+///=============================================================
+/// \class	BindableRegistry
+/// \author	KeyC0de
+/// \date	2026/10/17 21:10
+/// \brief	shares Bindables of the same type that have the same uid (T::calcUid)
+/// \brief	every Bindable type gets its own table keyed by the 64bit hash of the uid, so a hit needs no dynamic cast
+/// \brief	the uid is stored next to the Bindable & compared on every hit to tell hash collisions apart
+/// \brief	fetch is thread safe; a miss constructs the Bindable outside the lock - if another thread inserted the same uid meanwhile its Bindable is returned
+/// \brief	garbageCollect is a single pass over every table; each call starts a new generation & unreferenced Bindables survive it if they were fetched in the generation that just ended
+///=============================================================
 class BindableRegistry final
 {
-	std::unordered_map<std::string, std::shared_ptr<IBindable>> m_bindableMap;
+	class ITable
+	{
+	public:
+		virtual ~ITable() noexcept = default;
+
+		virtual std::size_t getCount() = 0;
+		virtual std::size_t getGarbageCount() = 0;
+		virtual void garbageCollect( const std::uint32_t endedGeneration ) = 0;
+	};
+
+	template<class T>
+	class Table final
+		: public ITable
+	{
+		struct Entry final
+		{
+			std::string m_uid;
+			std::shared_ptr<T> m_pBindable;
+			std::atomic<std::uint32_t> m_lastFetchGeneration;
+
+			Entry( std::string uid,
+				std::shared_ptr<T> pBindable,
+				const std::uint32_t generation )
+				:
+				m_uid{std::move( uid )},
+				m_pBindable{std::move( pBindable )},
+				m_lastFetchGeneration{generation}
+			{
+
+			}
+		};
+
+		struct PrehashedKey final
+		{
+			std::size_t operator()( const std::uint64_t hash ) const noexcept
+			{
+				return static_cast<std::size_t>( hash );
+			}
+		};
+
+		std::shared_mutex m_mutex;
+		std::unordered_multimap<std::uint64_t, Entry, PrehashedKey> m_entries;
+	public:
+		Table()
+		{
+			registerTable( *this );
+		}
+
+		std::shared_ptr<T> find( const std::uint64_t hash,
+			const std::string &uid,
+			const std::uint32_t generation )
+		{
+			std::shared_lock<std::shared_mutex> lock{m_mutex};
+			return findLocked( hash, uid, generation );
+		}
+
+		/// \brief	returns the Bindable already registered under uid if there is one, pBindable otherwise
+		std::shared_ptr<T> insert( const std::uint64_t hash,
+			std::string uid,
+			std::shared_ptr<T> pBindable,
+			const std::uint32_t generation )
+		{
+			std::unique_lock<std::shared_mutex> lock{m_mutex};
+			if ( std::shared_ptr<T> pExisting = findLocked( hash, uid, generation ) )
+			{
+				return pExisting;
+			}
+			m_entries.emplace( std::piecewise_construct, std::forward_as_tuple( hash ), std::forward_as_tuple( std::move( uid ), pBindable, generation ) );
+			return pBindable;
+		}
+
+		std::size_t getCount() override
+		{
+			std::shared_lock<std::shared_mutex> lock{m_mutex};
+			return m_entries.size();
+		}
+
+		std::size_t getGarbageCount() override
+		{
+			std::shared_lock<std::shared_mutex> lock{m_mutex};
+			std::size_t nGarbage = 0;
+			for ( const auto &[hash, entry] : m_entries )
+			{
+				if ( entry.m_pBindable.use_count() <= 1 )
+				{
+					++nGarbage;
+				}
+			}
+			return nGarbage;
+		}
+
+		void garbageCollect( const std::uint32_t endedGeneration ) override
+		{
+			// fetches take the lock as well, so use counts can't go up while we're iterating
+			std::unique_lock<std::shared_mutex> lock{m_mutex};
+			for ( auto it = m_entries.begin(); it != m_entries.end(); )
+			{
+				const Entry &entry = it->second;
+				if ( entry.m_pBindable.use_count() <= 1 && entry.m_lastFetchGeneration.load( std::memory_order_relaxed ) != endedGeneration )
+				{
+					it = m_entries.erase( it );
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+	private:
+		std::shared_ptr<T> findLocked( const std::uint64_t hash,
+			const std::string &uid,
+			const std::uint32_t generation )
+		{
+			const auto [first, last] = m_entries.equal_range( hash );
+			for ( auto it = first; it != last; ++it )
+			{
+				Entry &entry = it->second;
+				if ( entry.m_uid == uid )
+				{
+					entry.m_lastFetchGeneration.store( generation, std::memory_order_relaxed );
+					return entry.m_pBindable;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	static inline std::atomic<std::uint32_t> s_generation{0u};
+	static inline std::mutex s_tablesMutex;
+	static inline std::vector<ITable*> s_tables;
 public:
 	template<class T, typename... TArgs>
 	static std::shared_ptr<T> fetch( Graphics &gfx,
 		TArgs&&... args ) cond_noex
 	{
 		static_assert( std::is_base_of<IBindable, T>::value, "T must be a IBindable!" );
-		return getInstance().fetch_impl<T>( gfx, std::forward<TArgs>( args )... );
+		return fetch_impl<T>( gfx, std::forward<TArgs>( args )... );
+	}
+
+	/// \brief	the Bindable fetch would return for these args if it's registered already, nullptr otherwise; never constructs one
+	/// \brief	lets callers skip preparing the data a Bindable is constructed from
+	template<class T, typename... TArgs>
+	static std::shared_ptr<T> find( TArgs&&... args )
+	{
+		static_assert( std::is_base_of<IBindable, T>::value, "T must be a IBindable!" );
+		const std::string uid = T::calcUid( args... );
+		return getTable<T>().find( hashUid( uid ), uid, s_generation.load( std::memory_order_relaxed ) );
 	}
 
 	static std::size_t getInstanceCount()
 	{
 #if defined _DEBUG && !defined NDEBUG
-		const auto &instance = getInstance();
-		return instance.m_bindableMap.size();
+		std::lock_guard<std::mutex> lg{s_tablesMutex};
+		std::size_t nInstances = 0;
+		for ( ITable *pTable : s_tables )
+		{
+			nInstances += pTable->getCount();
+		}
+		return nInstances;
 #else
 		return 0ull;
 #endif
@@ -31,14 +193,11 @@ public:
 	static std::size_t getGarbageCount()
 	{
 #if defined _DEBUG && !defined NDEBUG
-		const auto &instance = getInstance();
-		size_t nGarbagePtrs = 0;
-		for ( const auto &elem : instance.m_bindableMap )
+		std::lock_guard<std::mutex> lg{s_tablesMutex};
+		std::size_t nGarbagePtrs = 0;
+		for ( ITable *pTable : s_tables )
 		{
-			if ( elem.second.use_count() <= 1 )
-			{
-				++nGarbagePtrs;
-			}
+			nGarbagePtrs += pTable->getGarbageCount();
 		}
 		return nGarbagePtrs;
 #else
@@ -46,40 +205,67 @@ public:
 #endif
 	}
 
+	/// \brief	releases every Bindable only the registry refers to, unless it was fetched since the previous collection
 	static void garbageCollect()
 	{
-		auto &instance = BindableRegistry::getInstance();
-		for ( std::unordered_map<std::string, std::shared_ptr<IBindable>>::iterator it = instance.m_bindableMap.begin(); it != instance.m_bindableMap.end(); ++it )
+		const std::uint32_t endedGeneration = s_generation.fetch_add( 1u, std::memory_order_relaxed );
+		std::lock_guard<std::mutex> lg{s_tablesMutex};
+		for ( ITable *pTable : s_tables )
 		{
-			if ( it->second.use_count() <= 1 )
-			{
-				instance.m_bindableMap.erase( it );
-				it = instance.m_bindableMap.begin();
-			}
+			pTable->garbageCollect( endedGeneration );
 		}
 	}
 private:
 	template<class T, typename... TArgs>
-	std::shared_ptr<T> fetch_impl( Graphics &gfx,
+	static std::shared_ptr<T> fetch_impl( Graphics &gfx,
 		TArgs&&... args ) cond_noex
 	{
-		const std::string bindableId = T::calcUid( std::forward<TArgs>( args )... );
-		const auto /*std::unordered_map<std::string, std::shared_ptr<IBindable>>::const_iterator*/ elem = m_bindableMap.find( bindableId );
-		if ( elem == m_bindableMap.cend() )
+		Table<T> &table = getTable<T>();
+		std::string uid = T::calcUid( args... );
+		const std::uint64_t hash = hashUid( uid );
+		const std::uint32_t generation = s_generation.load( std::memory_order_relaxed );
+		if ( std::shared_ptr<T> pBindable = table.find( hash, uid, generation ) )
 		{
-			std::shared_ptr<T> bindable = std::make_shared<T>( gfx, std::forward<TArgs>( args )... );
-			m_bindableMap[bindableId] = bindable;
-			return bindable;
-		}
-		else
-		{
-			return std::dynamic_pointer_cast<T>( elem->second );
+			return pBindable;
 		}
+		return table.insert( hash, std::move( uid ), std::make_shared<T>( gfx, std::forward<TArgs>( args )... ), generation );
+	}
+
+	template<class T>
+	static Table<T>& getTable()
+	{
+		static Table<T> table;
+		return table;
+	}
+
+	static void registerTable( ITable &table )
+	{
+		std::lock_guard<std::mutex> lg{s_tablesMutex};
+		s_tables.push_back( &table );
 	}
 
-	static BindableRegistry& getInstance()
+	/// \brief	64bit multiply - xorshift hash, 8 bytes at a time; uids are long paths & FNV-1a's byte at a time chain cost more than the table lookup
+	static std::uint64_t hashUid( const std::string &uid ) noexcept
 	{
-		static BindableRegistry instance;
-		return instance;
+		constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+		std::uint64_t hash = uid.size() * multiplier;
+		const char *pData = uid.data();
+		std::size_t nBytes = uid.size();
+		for ( ; nBytes >= 8; pData += 8, nBytes -= 8 )
+		{
+			std::uint64_t word;
+			std::memcpy( &word, pData, 8 );
+			hash = ( hash ^ word ) * multiplier;
+			hash ^= hash >> 32;
+		}
+		if ( nBytes > 0 )
+		{
+			std::uint64_t word = 0;
+			std::memcpy( &word, pData, nBytes );
+			hash = ( hash ^ word ) * multiplier;
+			hash ^= hash >> 32;
+		}
+		hash *= multiplier;
+		return hash ^ ( hash >> 29 );
 	}
 };
\ No newline at end of file
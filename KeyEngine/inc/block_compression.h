@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "color.h"
+
+
+// CPU block compression of BGRA8 texels into the D3D BCn formats, 4x4 texel blocks of 8 or 16 bytes
+// BC1: rgb 565 endpoints & 2bit indices, opaque (4 color mode only)
+// BC3: BC1's color block preceded by a BC4 style alpha block
+// BC4: one channel (red) with 8bit endpoints & 3bit indices, BC5: two BC4 blocks for red & green (a normal map's x & y)
+// BC7-lite: mode 6 only, a single subset of rgba 7777 + pbit endpoints & 4bit indices
+// endpoints come from the channels' bounding box (Fast) or principal axis (Normal & High) & are refined by least squares fits on their indices
+// the decoder is for validation: it matches the encoder's interpolation which is within D3D's tolerance of what GPUs return
+namespace bc
+{
+
+enum class Format : std::uint32_t
+{
+	BGRA8,		// uncompressed
+	BC1,
+	BC3,
+	BC4,
+	BC5,
+	BC7,
+};
+
+enum class Quality : std::uint32_t
+{
+	Fast,
+	Normal,
+	High,
+};
+
+enum class Usage : std::uint32_t
+{
+	Color,
+	NormalMap,
+	Mask,		// heightmaps & masks, only red is kept
+};
+
+/// \brief	BC1 for opaque colors & BC3 for colors with alpha (BC7 for both at Quality::High), BC5 for normal maps & BC4 for masks
+Format chooseFormat( const Usage usage, const bool bAlpha, const Quality quality ) noexcept;
+bool isCompressed( const Format format ) noexcept;
+/// \brief	bytes per 4x4 block, or per texel for BGRA8
+unsigned getBlockSize( const Format format ) noexcept;
+/// \brief	bytes per row of blocks (or of texels)
+std::size_t calcRowPitch( const unsigned width, const Format format ) noexcept;
+std::size_t calcSize( const unsigned width, const unsigned height, const Format format ) noexcept;
+/// \brief	pTexels are width x height tightly packed; edge blocks are padded by repeating the last row & column
+/// \brief	rows of blocks are encoded in parallel on the ThreadPoolJ
+void encode( const ColorBGRA *pTexels, const unsigned width, const unsigned height, const Format format, const Quality quality, std::uint8_t *pBlocks );
+/// \brief	BC4 decodes to (r, 0, 0, 255) & BC5 to (r, g, 0, 255) like D3D samples them
+void decode( const std::uint8_t *pBlocks, const unsigned width, const unsigned height, const Format format, ColorBGRA *pTexels );
+/// \brief	PSNR in dB over the channels the format keeps: rgb for BC1, r for BC4, rg for BC5 & rgba otherwise
+double calcPsnr( const ColorBGRA *pA, const ColorBGRA *pB, const std::size_t nTexels, const Format format ) noexcept;
+
+
+}//namespace bc
\ No newline at end of file
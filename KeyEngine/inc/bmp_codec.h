@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <array>
+#include "winner.h"
+#include "color.h"
+#include "non_copyable.h"
+
+
+namespace bmp
+{
+
+struct Header final
+{
+	unsigned width;
+	unsigned height;
+	unsigned bitCount;			// 8 (palettized), 16, 24 or 32
+	bool bTopDown;				// the first row in the file is the top row of the image
+	std::size_t dataOffset;		// of the first row in the file
+	std::size_t rowStride;		// bytes per row in the file, including the padding to 4 bytes
+	std::uint32_t redMask;
+	std::uint32_t greenMask;
+	std::uint32_t blueMask;
+	std::uint32_t alphaMask;	// 0 if there is no alpha channel, as in 32 bit BI_RGB files whose every 4th byte is 0
+};
+
+///=============================================================
+/// \class	BmpReader
+/// \author	KeyC0de
+/// \date	2026/10/17 23:20
+/// \brief	maps a .bmp file into memory & decodes whole rows of it to BGRA8 texels
+/// \brief	supports uncompressed 8 bit palettized, 16 bit (555, 565 or bitfields), 24 bit & 32 bit (BGRA or bitfields) files, top-down or bottom-up
+/// \brief	rows can be decoded one at a time in any order (eg. to stream huge heightmaps) - only the pages touched are ever read from disk,
+/// \brief		except for 32 bit BI_RGB files which are scanned up to their first texel with a non zero alpha byte; if there is none alpha is ignored
+/// \brief	24 bit rows are swizzled 4 texels at a time with SSSE3 (if the CPU supports it), 16 bit 555/565 rows 8 texels at a time with SSE2
+/// \brief	channels narrower than 8 bits are expanded by bit replication; a missing alpha channel decodes to 255
+///=============================================================
+class BmpReader final
+	: public NonCopyable
+{
+	struct Channel final
+	{
+		unsigned shift;
+		unsigned nBits;	// 0 means the channel isn't present
+	};
+
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	HANDLE m_hMapping = nullptr;
+	const std::uint8_t *m_pData = nullptr;
+	std::size_t m_nBytes = 0;
+	Header m_header;
+	std::array<Channel, 4> m_channels;	// b, g, r, a
+	std::array<ColorBGRA, 256> m_palette;
+public:
+	/// \brief	throws a UtilException if the file can't be opened or isn't a supported .bmp
+	explicit BmpReader( const std::string &filename );
+	~BmpReader() noexcept;
+	BmpReader( BmpReader &&rhs ) noexcept;
+	BmpReader& operator=( BmpReader &&rhs ) noexcept;
+
+	const Header& getHeader() const noexcept;
+	unsigned getWidth() const noexcept;
+	unsigned getHeight() const noexcept;
+	/// \brief	decodes row y (0 is the top row) into width texels
+	void readRow( const unsigned y, ColorBGRA *pOut ) const noexcept;
+	/// \brief	decodes rows [firstRow, firstRow + nRows) top to bottom; rows are width texels apart in pOut
+	void readRows( const unsigned firstRow, const unsigned nRows, ColorBGRA *pOut ) const noexcept;
+	/// \brief	decodes the whole image, top row first
+	void read( ColorBGRA *pOut ) const noexcept;
+private:
+	void parseHeader();
+	bool hasNonZeroAlpha() const noexcept;
+	void close() noexcept;
+	void decodeRow( const std::uint8_t *pRow, ColorBGRA *pOut ) const noexcept;
+	void decodeRowBitfields( const std::uint8_t *pRow, ColorBGRA *pOut ) const noexcept;
+};
+
+/// \brief	encodes the image (top row first) into a bottom-up 24 or 32 bit .bmp & writes it with a single call; 24 bit drops alpha
+/// \brief	throws a UtilException if the file can't be written
+void write( const std::string &filename, const unsigned width, const unsigned height, const ColorBGRA *pTexels, const unsigned bitCount = 24u );
+
+
+}//namespace bmp
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <string>
-#include <fstream>
 #include <functional>
 #include <vector>
 #include "winner.h"
@@ -20,7 +19,7 @@ class VBuffer;
 /// \author	KeyC0de
 /// \date	2022/11/19 14:15
 /// \brief	BMPs BGRA color order if bit count is 32bit, or BGR if 24bit
-/// \brief	Windows only, as Linux doesn't provide facets/locales for basic_fstream of "unsigned char"
+/// \brief	all file i/o goes through bmp::BmpReader & bmp::write
 ///=============================================================
 class BmpLoader final
 {
@@ -69,26 +68,21 @@ private:
 	int m_width = 0;
 	int m_height = 0;
 	std::string m_filename;
-	unsigned short m_bitCount;
-	BITMAPFILEHEADER m_bmpFileHeader;
-	BITMAPINFOHEADER m_bmpInfoHeader;
-	using ufstream = std::basic_fstream<unsigned char, std::char_traits<unsigned char>>;
-	ufstream m_file;
+	unsigned short m_bitCount = 24;
 public:
 	BmpLoader() = default;
-	/// \brief	store sprite (.bmp format) from file into data structure
+	/// \brief	reads the .bmp header of filename, the texels are decoded on demand by readData
 	BmpLoader( const std::string& filename );
 	BmpLoader( const BmpLoader& rhs ) = delete;
 	BmpLoader& operator=( const BmpLoader& rhs ) = delete;
-	BmpLoader( BmpLoader&& rhs ) noexcept;
-	BmpLoader& operator=( BmpLoader&& rhs ) noexcept;
+	BmpLoader( BmpLoader&& rhs ) noexcept = default;
+	BmpLoader& operator=( BmpLoader&& rhs ) noexcept = default;
 
 	int getWidth() const noexcept;
 	int getHeight() const noexcept;
 	unsigned short getBitCount() const noexcept;
-	/// \brief	writing after reading requires flushing of the file stream
-	void flush() noexcept;
 	bool applyPerlinNoise( const std::string &filename = "" );
+	/// \brief	decodes the whole image, top row first, into `img` as BGRA texels whatever the bit count of the file; `_24bit` views the same B G R bytes
 	void readData( _Inout_ ImageData *img, const std::string &filename = "" );
 	/// \brief	goes through the image data and divides each height value so that the terrain doesn't look too spikey
 	void normalizeHeightmap( _Inout_ ImageData *img, const double value ) noexcept;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <array>
 #include <DirectXMath.h>
 #include "model.h"
 #include "rendering_channel.h"
@@ -69,7 +70,7 @@ public:
 	DirectX::XMVECTOR getUp() const noexcept;
 	float getFovRadians() const noexcept;
 	const std::string& getName() const noexcept;
-	std::vector<DirectX::XMFLOAT4> getFrustumPlanes() const noexcept;
+	std::array<DirectX::XMFLOAT4, 6> getFrustumPlanes() const noexcept;
 	void displayImguiWidgets( Graphics &gfx ) noexcept;
 	void onWindowResize( Graphics &gfx );
 	void setTethered( const bool bTethered ) cond_noex;
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "thread_poolj.h"
+
+
+namespace ren
+{
+
+///=============================================================
+/// \class	ICommandListBackend
+/// \author	KeyC0de
+/// \date	2026/10/17 20:40
+/// \brief	API agnostic interface to a set of command lists that are recorded on worker threads & replayed on the immediate context
+/// \brief	command list `index` is only ever touched by a single thread at a time
+///=============================================================
+class ICommandListBackend
+{
+public:
+	virtual ~ICommandListBackend() noexcept = default;
+
+	/// \brief	makes sure command lists [0, nCommandLists) exist; called on the immediate thread before recording
+	virtual void reserve( const std::size_t nCommandLists ) = 0;
+	/// \brief	the calling thread's commands go to command list `index` until finishRecording
+	virtual void beginRecording( const std::size_t index ) = 0;
+	/// \brief	closes command list `index`, the calling thread's commands go to the immediate context again
+	virtual void finishRecording( const std::size_t index ) = 0;
+	/// \brief	replays command list `index` on the immediate context
+	/// \brief	the immediate context's state is reset to the default afterwards
+	virtual void execute( const std::size_t index ) = 0;
+};
+
+
+///=============================================================
+/// \class	NullCommandListBackend
+/// \author	KeyC0de
+/// \date	2026/10/17 20:40
+/// \brief	headless backend; commands are plain integers submitted by the caller
+/// \brief	useful to validate the recording & replay order without a GPU
+///=============================================================
+class NullCommandListBackend final
+	: public ICommandListBackend
+{
+	static inline thread_local std::vector<std::uint32_t> *s_pRecordingList = nullptr;
+
+	std::vector<std::vector<std::uint32_t>> m_commandLists;
+	std::vector<std::uint32_t> m_immediateCommands;
+	unsigned m_nStateResets = 0u;
+public:
+	void reserve( const std::size_t nCommandLists ) override;
+	void beginRecording( const std::size_t index ) override;
+	void finishRecording( const std::size_t index ) override;
+	void execute( const std::size_t index ) override;
+
+	/// \brief	appends to the calling thread's command list or straight to the immediate context if it isn't recording
+	void submit( const std::uint32_t command );
+	/// \brief	commands in the order the immediate context would have issued them to the GPU
+	const std::vector<std::uint32_t>& getImmediateCommands() const noexcept;
+	/// \brief	number of times the immediate context's state was reset by executing a command list
+	unsigned getNumStateResets() const noexcept;
+	void clear() noexcept;
+};
+
+
+///=============================================================
+/// \class	CommandListScheduler
+/// \author	KeyC0de
+/// \date	2026/10/17 20:40
+/// \brief	runs an ordered sequence of tasks (eg. Passes) with the same outcome as running them one by one on the immediate context
+/// \brief	recordable tasks are recorded into their own command list in parallel on the ThreadPoolJ
+/// \brief	then every task is visited in order: recorded tasks have their command list executed, the rest run on the immediate context
+/// \brief	a task may rely on state left behind by the tasks before it; a context that didn't run those tasks
+/// \brief		(every command list & the immediate context after executing a command list) gets that state rebound first via bindSharedState
+///=============================================================
+class CommandListScheduler final
+{
+	ICommandListBackend &m_backend;
+	unsigned m_nMaxRecordingThreads;
+	std::vector<std::size_t> m_recordedTasks;
+public:
+	CommandListScheduler( ICommandListBackend &backend, const unsigned nMaxRecordingThreads );
+
+	/// \brief	isRecordable( i ): task i can be recorded on any thread
+	/// \brief	runTask( i ): issues task i's commands on the calling thread's current context
+	/// \brief	bindSharedState( i ): rebinds the state task i leaves behind for the tasks after it on the current context
+	/// \brief	returns the number of tasks that were recorded
+	template<typename TIsRecordable, typename TRunTask, typename TBindSharedState>
+	std::size_t run( const std::size_t nTasks,
+		const TIsRecordable &isRecordable,
+		const TRunTask &runTask,
+		const TBindSharedState &bindSharedState )
+	{
+		m_recordedTasks.clear();
+		for ( std::size_t i = 0; i < nTasks; ++i )
+		{
+			if ( isRecordable( i ) )
+			{
+				m_recordedTasks.push_back( i );
+			}
+		}
+
+		// a single command list can't overlap with anything, it would only add the replay overhead
+		const std::size_t nRecorded = m_recordedTasks.size();
+		if ( nRecorded < 2 )
+		{
+			for ( std::size_t i = 0; i < nTasks; ++i )
+			{
+				runTask( i );
+			}
+			return 0;
+		}
+
+		m_backend.reserve( nRecorded );
+		const std::size_t grainSize = ( nRecorded + m_nMaxRecordingThreads - 1 ) / m_nMaxRecordingThreads;
+		ThreadPoolJ::getInstance().parallelFor( 0, nRecorded, grainSize,
+			[&] ( const std::size_t first, const std::size_t last )
+			{
+				for ( std::size_t list = first; list < last; ++list )
+				{
+					const std::size_t task = m_recordedTasks[list];
+					m_backend.beginRecording( list );
+					for ( std::size_t i = 0; i < task; ++i )
+					{
+						bindSharedState( i );
+					}
+					runTask( task );
+					m_backend.finishRecording( list );
+				}
+			} );
+
+		std::size_t list = 0;
+		bool bImmediateStateLost = false;
+		for ( std::size_t task = 0; task < nTasks; ++task )
+		{
+			if ( list < nRecorded && m_recordedTasks[list] == task )
+			{
+				m_backend.execute( list++ );
+				bImmediateStateLost = true;
+				continue;
+			}
+
+			if ( bImmediateStateLost )
+			{
+				for ( std::size_t i = 0; i < task; ++i )
+				{
+					bindSharedState( i );
+				}
+				bImmediateStateLost = false;
+			}
+			runTask( task );
+		}
+
+		// leave the immediate context as if every task had run on it
+		if ( bImmediateStateLost )
+		{
+			for ( std::size_t i = 0; i < nTasks; ++i )
+			{
+				bindSharedState( i );
+			}
+		}
+		return nRecorded;
+	}
+};
+
+
+}//namespace ren
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include "key_wrl.h"
 #include "bindable.h"
 #include "dynamic_constant_buffer.h"
@@ -13,17 +16,29 @@ class Graphics;
 class IConstantBufferEx
 	: public IBindable
 {
+	static inline std::mutex s_dirtyBuffersMutex;
+	static inline std::vector<IConstantBufferEx*> s_dirtyBuffers;
 protected:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pD3dCb;
 	unsigned m_slot;
+	std::atomic<bool> m_bDirty{false};
 protected:
 	static void setBufferDesc( D3D11_BUFFER_DESC &d3dBufDesc, const unsigned byteWidth );
 protected:
 	IConstantBufferEx( Graphics &gfx, const unsigned slot, const con::CBElement &layoutRoot, const con::CBuffer *pBuf );
+	~IConstantBufferEx() noexcept;
 
 	void update( Graphics &gfx, const con::CBuffer &buf );
+	/// \brief	the cpu side buffer is uploaded on the next bind or the next updateDirtyBuffers, whichever comes first
+	void markDirty();
+	void updateIfDirty( Graphics &gfx );
 public:
+	/// \brief	uploads every dirty buffer on the immediate context; the Renderer calls it before running the Passes
+	/// \brief	Passes recorded on worker threads thus only bind constant buffers, never upload them
+	/// \brief		- concurrent uploads would race & an upload recorded in one command list is missed by the lists replayed before it
+	static void updateDirtyBuffers( Graphics &gfx );
 	virtual const con::CBElement& getCbRootElement() const noexcept = 0;
+	virtual const con::CBuffer& getBuffer() const noexcept = 0;
 };
 
 class IVertexShaderConstantBufferEx
@@ -50,7 +65,6 @@ class ConstantBufferEx final
 {
 	static_assert( std::is_base_of_v<IConstantBufferEx, T>, "T is not IConstantBufferEx!" );
 
-	bool m_bDirty = false;
 	con::CBuffer m_cb;
 public:
 	// empty cb
@@ -84,7 +98,7 @@ public:
 		return m_cb;
 	}
 
-	const con::CBuffer& getBuffer() const noexcept
+	const con::CBuffer& getBuffer() const noexcept override
 	{
 		return m_cb;
 	}
@@ -92,16 +106,12 @@ public:
 	void setBuffer( const con::CBuffer &cb )
 	{
 		m_cb.copyFrom( cb );
-		m_bDirty = true;
+		T::markDirty();
 	}
 
 	void bind( Graphics &gfx ) cond_noex override
 	{
-		if ( m_bDirty )
-		{
-			T::update( gfx, m_cb );
-			m_bDirty = false;
-		}
+		T::updateIfDirty( gfx );
 		T::bind( gfx );
 	}
 
@@ -110,7 +120,7 @@ public:
 	{
 		if ( ev.visit( m_cb ) )
 		{
-			m_bDirty = true;
+			T::markDirty();
 		}
 	}
 #endif
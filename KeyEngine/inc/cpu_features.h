@@ -0,0 +1,22 @@
+#pragma once
+
+
+namespace util
+{
+
+/// \brief	instruction set extensions of the running CPU, for the code paths that dispatch at runtime rather than on the build's /arch
+struct CpuFeatures final
+{
+	bool bSsse3 = false;
+	bool bSse41 = false;
+	bool bAvx2 = false;	// includes the OS saving the ymm registers
+};
+
+/// \brief	queried with cpuid on first use
+const CpuFeatures& getCpuFeatures() noexcept;
+/// \brief	turns off the features that are false in `enabled` until the next call, the CPU's missing features stay off
+/// \brief	eg. to test & benchmark the fallback paths
+void restrictCpuFeatures( const CpuFeatures &enabled ) noexcept;
+
+
+}//namespace util
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "non_copyable.h"
+#include "color.h"
+
+
+///=============================================================
+/// \class	CpuFramebuffer
+/// \author	KeyC0de
+/// \date	2026/10/18 14:20
+/// \brief	the 2d path's CPU color buffer, tracking which of its tiles are drawn into every frame in bitmasks
+/// \brief	beginFrame zeroes only the tiles drawn the last time the back buffer was drawn into, instead of the whole buffer
+/// \brief	endFrame merges the tiles that may differ from the previously uploaded frame, those drawn in this or the previous frame, into upload rects
+/// \brief	optionally double buffered: the front buffer & its upload rects stay untouched until the next endFrame, so the next frame can be drawn while it's uploaded
+/// \brief	has no GPU dependencies, Texture::update uploads the rects of the front buffer
+///=============================================================
+class CpuFramebuffer final
+	: NonCopyableAndNonMovable
+{
+public:
+	static constexpr unsigned s_tileSize = 64u;
+	static constexpr std::size_t s_maxUploadRects = 128u;	// each rect is a separate upload, past this many a rect per row of tiles is uploaded instead
+
+	/// \brief	in pixels, right & bottom are exclusive
+	struct Rect final
+	{
+		unsigned left;
+		unsigned top;
+		unsigned right;
+		unsigned bottom;
+	};
+private:
+	static constexpr std::size_t s_nFrameMasks = 3u;	// this frame's & the previous 2 frames'
+
+	unsigned m_width;
+	unsigned m_height;
+	unsigned m_nTilesX;
+	unsigned m_nTilesY;
+	unsigned m_nBuffers;
+	unsigned m_back = 0u;
+	unsigned m_front = 0u;
+	std::size_t m_frame = 0u;
+	bool m_bFullUpload = true;		// the GPU texture's initial contents aren't known
+	std::array<std::vector<ColorBGRA>, 2> m_buffers;
+	std::array<std::vector<std::uint64_t>, s_nFrameMasks> m_frameMasks;	// a bit per tile, row major
+	std::vector<std::uint64_t> m_uploadMask;
+	std::vector<Rect> m_uploadRects;
+	std::vector<std::size_t> m_lastRectAt;	// per tile column, the index of the last upload rect whose left edge is there
+public:
+	CpuFramebuffer( const unsigned width, const unsigned height, const bool bDoubleBuffered = false );
+
+	/// \brief	starts drawing the next frame into the back buffer
+	void beginFrame() noexcept;
+	/// \brief	the frame is drawn; the back buffer becomes the front buffer & its upload rects are calculated
+	void endFrame();
+	ColorBGRA getPixel( const int x, const int y ) const noexcept;
+	void putPixel( const int x, const int y, const ColorBGRA color ) noexcept;
+	/// \brief	marks the tiles under rect as drawn into, for writes straight to the back buffer
+	void markDirty( const Rect &rect ) noexcept;
+	ColorBGRA* getBackBuffer() noexcept;
+	const ColorBGRA* getFrontBuffer() const noexcept;
+	/// \brief	of the front buffer, in pixels
+	const std::vector<Rect>& getUploadRects() const noexcept;
+	/// \brief	whether the tile was drawn into this frame
+	bool isTileDirty( const unsigned tileX, const unsigned tileY ) const noexcept;
+	unsigned getWidth() const noexcept;
+	unsigned getHeight() const noexcept;
+	unsigned getTileCountX() const noexcept;
+	unsigned getTileCountY() const noexcept;
+private:
+	std::vector<std::uint64_t>& getFrameMask( const std::size_t nFramesAgo ) noexcept;
+	const std::vector<std::uint64_t>& getFrameMask( const std::size_t nFramesAgo ) const noexcept;
+	void markTile( const unsigned tileX, const unsigned tileY ) noexcept;
+	/// \brief	the upload mask's runs of tiles, or a span per row of tiles, merged with those above them into rects; in tiles
+	void buildUploadRects( const bool bRowSpans );
+	/// \brief	calls f( tileLeft, tileRight, tileY ) for every horizontal run of set tiles, tileRight is exclusive
+	template<typename F>
+	void forEachTileRun( const std::vector<std::uint64_t> &mask, F &&f ) const
+	{
+		for ( unsigned ty = 0; ty < m_nTilesY; ++ty )
+		{
+			unsigned tx = 0;
+			while ( tx < m_nTilesX )
+			{
+				if ( !isTileSet( mask, tx, ty ) )
+				{
+					++tx;
+					continue;
+				}
+				const unsigned left = tx;
+				do
+				{
+					++tx;
+				} while ( tx < m_nTilesX && isTileSet( mask, tx, ty ) );
+				f( left, tx, ty );
+			}
+		}
+	}
+
+	bool isTileSet( const std::vector<std::uint64_t> &mask, const unsigned tileX, const unsigned tileY ) const noexcept
+	{
+		const std::size_t index = static_cast<std::size_t>( tileY ) * m_nTilesX + tileX;
+		return ( mask[index / 64] >> ( index % 64 ) & 1u ) != 0;
+	}
+};
\ No newline at end of file
@@ -10,6 +10,7 @@ class Cube
 	: public Mesh
 {
 	static inline constexpr const char *s_geometryTag = "$cube";
+	static inline std::weak_ptr<IBindable> s_pTexturedSpecularPscb;	// shared by all textured Cubes, st. their opaque Material can be instanced
 public:
 	Cube( Graphics &gfx, const float initialScale = 1.0f, const std::variant<DirectX::XMFLOAT4, std::string> &colorOrTexturePath = "assets/models/brick_wall/brick_wall_diffuse.jpg" );
 };
\ No newline at end of file
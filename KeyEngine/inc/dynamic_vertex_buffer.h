@@ -52,6 +52,17 @@ public:
 #undef X
 	};
 
+	// per-instance elements are fed from the instance buffer bound at s_instanceInputSlot & advance once per instance instead of once per vertex
+	enum InstanceElementType
+	{
+		InstanceTransform,		// row major float4x4 world matrix, occupies semantic indices 0..3
+		InstanceFloat4Color,
+	};
+	static constexpr unsigned s_instanceInputSlot = 1u;
+private:
+	std::vector<std::pair<InstanceElementType, size_t>> m_instanceElements;	// type & byte offset inside an instance's data
+public:
+
 	template<ILEementType>
 	struct ElementProperties;
 
@@ -228,6 +239,11 @@ public:
 	std::vector<D3D11_INPUT_ELEMENT_DESC> getD3DInputElementDescs() const cond_noex;
 	std::string calcSignature() const cond_noex;
 	bool hasType( const ILEementType& type ) const noexcept;
+	/// \brief	appends a per-instance element; the per vertex elements, size & offsets are unaffected
+	VertexInputLayout& addInstance( const InstanceElementType type ) cond_noex;
+	bool hasInstanceElements() const noexcept;
+	/// \brief	bytes of per-instance data for a single instance
+	size_t getInstanceSizeInBytes() const noexcept;
 };//VertexInputLayout
 
 
@@ -318,7 +334,10 @@ public:
 	VBuffer( VertexInputLayout layout, const size_t vertexCount = 0u ) cond_noex;
 	VBuffer( VertexInputLayout layout, const aiMesh &mesh );
 	const char* data() const cond_noex;
+	/// \brief	for bulk writers that fill every vertex in place, laid out as getLayout() describes
+	char* data() cond_noex;
 	const VertexInputLayout& getLayout() const noexcept;
+	/// \brief	grows or shrinks to newVertexCount vertices, shrinking drops the last ones
 	void resize( const size_t newVertexCount ) cond_noex;
 	size_t getVertexCount() const cond_noex;
 	size_t getSizeInBytes() const cond_noex;
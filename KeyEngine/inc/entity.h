@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include "entity_defines.h"
+#include "message_queue_bus_dispatcher.h"
 
 
 class EntityManager;
@@ -58,8 +59,16 @@ public:
 	const std::vector<Entity*>& getChildren() const noexcept;
 	bool hasChildren() const noexcept;
 	int getChildrenCount() const noexcept;
-	void onMessageReceived( std::unique_ptr<class Message> msg );
-	void sendMessage( class Message *msg ) const noexcept;
+	void onMessageReceived( Message &msg );
+	/// \brief	posts a Message with payload T( args... ) (or none if T is void) to the MessageDispatcher
+	/// \brief	returns false if the MessageBus is full
+	template<typename T = void, typename ... TArgs>
+	bool sendMessage( const Message::Type type,
+		Entity *pRecipient,
+		TArgs&&... args ) const
+	{
+		return MessageDispatcher::getInstance().post<T>( type, const_cast<Entity*>( this ), pRecipient, std::forward<TArgs>( args )... );
+	}
 	inline bool operator==( const Entity *rhs ) const noexcept;
 	inline bool operator!=( const Entity *rhs ) const noexcept;
 	inline bool operator==( const Entity &rhs ) const noexcept;
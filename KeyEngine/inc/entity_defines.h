@@ -10,4 +10,24 @@ using EntityIndex = std::uint16_t;
 #elif _64_BIT_ENTITY
 using EntityId = std::uint64_t;
 using EntityIndex = std::uint32_t;
-#endif
\ No newline at end of file
+#endif
+
+/// \brief	an EntityId is {version, index}, each half the width of the id
+constexpr unsigned s_entityIndexBits = sizeof( EntityIndex ) * 8u;
+constexpr EntityId s_invalidEntityId = ~EntityId{0};
+
+constexpr EntityId makeEntityId( const EntityIndex version,
+	const EntityIndex index ) noexcept
+{
+	return ( static_cast<EntityId>( version ) << s_entityIndexBits ) | index;
+}
+
+constexpr EntityIndex getEntityIndex( const EntityId id ) noexcept
+{
+	return static_cast<EntityIndex>( id );
+}
+
+constexpr EntityIndex getEntityVersion( const EntityId id ) noexcept
+{
+	return static_cast<EntityIndex>( id >> s_entityIndexBits );
+}
\ No newline at end of file
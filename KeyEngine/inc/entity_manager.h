@@ -3,8 +3,12 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include "entity_defines.h"
 #include "non_copyable.h"
+#include "archetype.h"
+#include "thread_poolj.h"
+#include "gameplay_exception.h"
 
 
 class Entity;
@@ -13,16 +17,38 @@ class Entity;
 /// \class	EntityManager
 /// \author	KeyC0de
 /// \date	2019/12/09 16:06
-/// \brief	EntityManager owns all the Entities
+/// \brief	EntityManager owns all the Entities & their components
+/// \brief	components are stored per Archetype (set of component types) in contiguous SoA chunks
+/// \brief	adding/removing a component moves the entity's row to the matching Archetype
+/// \brief	queries (forEach, parallelForEach) visit only the Archetypes that contain all the requested components
+/// \brief	structural changes (spawn, recycle, add/remove component) must not happen while a query is running
 ///=============================================================
 class EntityManager final
 	: public NonCopyable
 {
 	static inline EntityManager *s_pInstance;
 
+	struct EntityLocation final
+	{
+		std::uint32_t m_archetype = 0;
+		std::uint32_t m_row = 0;
+		std::uint32_t m_bucketSlot = 0;
+		bool m_bAlive = false;
+	};
+
+	struct ChunkRef final
+	{
+		std::uint32_t m_archetype;
+		std::uint32_t m_chunk;
+	};
+
 	std::vector<std::unique_ptr<Entity>> m_entities;
+	std::vector<EntityLocation> m_locations;	// per EntityIndex
 	std::vector<EntityIndex> m_freelist;
 	std::vector<size_t> m_worldEntitiesIndices;
+	std::vector<std::unique_ptr<Archetype>> m_archetypes;	// [0] is the empty archetype
+	std::unordered_map<ComponentMask, std::uint32_t> m_archetypeIndices;
+	std::vector<ChunkRef> m_queryChunks;
 
 	///=============================================================
 	/// \class	Bucket
@@ -40,8 +66,11 @@ class EntityManager final
 		Bucket( int categoryId );
 
 		int getCategoryId() const noexcept;
-		void appendEntity( Entity *pEnt );
-		void removeEntity( Entity *pEnt ) cond_noex;
+		/// \brief	returns the slot of the Entity in the Bucket
+		std::uint32_t appendEntity( Entity *pEnt );
+		/// \brief	swaps the last Entity into the slot; returns that Entity or nullptr if the slot was the last one
+		Entity* removeEntity( const std::uint32_t slot ) cond_noex;
+		const std::vector<Entity*>& getEntities() const noexcept;
 		//void sort();
 	};
 	Bucket m_statics{1};
@@ -57,12 +86,177 @@ public:
 	EntityIndex getAliveEntityCount();
 	/// \brief	also checks if the entity is valid if its not valid (has died) returns nullptr
 	Entity* getEntityById( EntityId entId );
-	/// \brief	recycle the entity's index/id st the slot can be used DOain
-	/// \brief	#TODO: NOT WORKING ATM
+	bool isAlive( const EntityId entId ) const noexcept;
+	/// \brief	destroys the entity & its components, the index/id is recycled st the slot can be used again with a new version
 	void recycleEntityId( EntityId entId );
 	Bucket& getBucket( int categoryId );
 	/// \brief	gets the current world
 	Entity* world();
+
+	/// \brief	constructs T( args... ), replacing the existing component of that type if there is one
+	template<typename T, typename ... TArgs>
+	T& addComponent( const EntityId entId,
+		TArgs&&... args )
+	{
+		const ComponentTypeId typeId = ComponentRegistry::getId<T>();
+		EntityLocation &location = getLocation( entId );
+		Archetype &src = *m_archetypes[location.m_archetype];
+		if ( src.hasComponent( typeId ) )
+		{
+			T *pComponent = static_cast<T*>( src.getComponent( typeId, location.m_row ) );
+			*pComponent = makeComponent<T>( std::forward<TArgs>( args )... );
+			return *pComponent;
+		}
+
+		T component = makeComponent<T>( std::forward<TArgs>( args )... );
+		const std::uint32_t dstIndex = getArchetypeEdge( location.m_archetype, typeId );
+		migrate( entId, location, dstIndex );
+		T *pComponent = static_cast<T*>( m_archetypes[dstIndex]->getComponent( typeId, location.m_row ) );
+		new( pComponent ) T( std::move( component ) );
+		return *pComponent;
+	}
+
+	/// \brief	returns false if the entity didn't have the component
+	template<typename T>
+	bool removeComponent( const EntityId entId )
+	{
+		const ComponentTypeId typeId = ComponentRegistry::getId<T>();
+		EntityLocation &location = getLocation( entId );
+		if ( !m_archetypes[location.m_archetype]->hasComponent( typeId ) )
+		{
+			return false;
+		}
+		migrate( entId, location, getArchetypeEdge( location.m_archetype, typeId ) );
+		return true;
+	}
+
+	/// \brief	returns nullptr if the entity doesn't have the component
+	/// \brief	the pointer is invalidated by any structural change
+	template<typename T>
+	T* getComponent( const EntityId entId )
+	{
+		const ComponentTypeId typeId = ComponentRegistry::getId<T>();
+		EntityLocation &location = getLocation( entId );
+		Archetype &archetype = *m_archetypes[location.m_archetype];
+		if ( !archetype.hasComponent( typeId ) )
+		{
+			return nullptr;
+		}
+		return static_cast<T*>( archetype.getComponent( typeId, location.m_row ) );
+	}
+
+	template<typename T>
+	bool hasComponent( const EntityId entId )
+	{
+		return m_archetypes[getLocation( entId ).m_archetype]->hasComponent( ComponentRegistry::getId<T>() );
+	}
+
+	/// \brief	calls f( EntityId, Ts&... ) for every entity that has all the components Ts
+	/// \brief	use `const T` for read only access
+	template<typename ... Ts, typename TFunc>
+	void forEach( const TFunc &f )
+	{
+		const ComponentMask mask = ComponentRegistry::getMask<Ts...>();
+		for ( auto &pArchetype : m_archetypes )
+		{
+			if ( ( pArchetype->getMask() & mask ) != mask )
+			{
+				continue;
+			}
+			for ( std::size_t chunk = 0; chunk < pArchetype->getChunkCount(); ++chunk )
+			{
+				processChunk<Ts...>( *pArchetype, chunk, f );
+			}
+		}
+	}
+
+	/// \brief	like forEach but chunks are distributed across the ThreadPoolJ
+	/// \brief	f is called concurrently & must only touch the components it is handed (and thread safe state)
+	template<typename ... Ts, typename TFunc>
+	void parallelForEach( const TFunc &f )
+	{
+		const ComponentMask mask = ComponentRegistry::getMask<Ts...>();
+		m_queryChunks.clear();
+		for ( std::uint32_t i = 0; i < m_archetypes.size(); ++i )
+		{
+			Archetype &archetype = *m_archetypes[i];
+			if ( ( archetype.getMask() & mask ) != mask )
+			{
+				continue;
+			}
+			for ( std::uint32_t chunk = 0; chunk < archetype.getChunkCount(); ++chunk )
+			{
+				m_queryChunks.push_back( {i, chunk} );
+			}
+		}
+
+		ThreadPoolJ::getInstance().parallelFor( 0, m_queryChunks.size(), 1,
+			[this, &f] ( const std::size_t first, const std::size_t last )
+			{
+				for ( std::size_t i = first; i < last; ++i )
+				{
+					const ChunkRef &ref = m_queryChunks[i];
+					processChunk<Ts...>( *m_archetypes[ref.m_archetype], ref.m_chunk, f );
+				}
+			} );
+	}
+
+	/// \brief	number of entities that have all the components Ts
+	template<typename ... Ts>
+	std::size_t count()
+	{
+		const ComponentMask mask = ComponentRegistry::getMask<Ts...>();
+		std::size_t n = 0;
+		for ( auto &pArchetype : m_archetypes )
+		{
+			if ( ( pArchetype->getMask() & mask ) == mask )
+			{
+				n += pArchetype->getCount();
+			}
+		}
+		return n;
+	}
 private:
 	EntityManager();
+
+	EntityLocation& getLocation( const EntityId entId );
+	/// \brief	index of the archetype that differs from `archetypeIndex` by component `typeId`, created on demand
+	std::uint32_t getArchetypeEdge( const std::uint32_t archetypeIndex, const ComponentTypeId typeId );
+	/// \brief	moves the entity's row to another archetype; components not in the destination are destroyed, new ones are left unconstructed
+	void migrate( const EntityId entId, EntityLocation &location, const std::uint32_t dstIndex );
+	void addToBucket( Entity &entity, EntityLocation &location );
+	void removeFromBucket( Entity &entity, EntityLocation &location );
+
+	template<typename T, typename ... TArgs>
+	static T makeComponent( TArgs&&... args )
+	{
+		if constexpr ( std::is_aggregate_v<T> )
+		{
+			return T{std::forward<TArgs>( args )...};
+		}
+		else
+		{
+			return T( std::forward<TArgs>( args )... );
+		}
+	}
+
+	template<typename ... Ts, typename TFunc>
+	static void processChunk( Archetype &archetype,
+		const std::size_t chunk,
+		const TFunc &f )
+	{
+		processRows( archetype.getEntityIds( chunk ), archetype.getChunkRowCount( chunk ), f, static_cast<Ts*>( archetype.getColumn( ComponentRegistry::getId<Ts>(), chunk ) )... );
+	}
+
+	template<typename TFunc, typename ... Ts>
+	static void processRows( const EntityId *pIds,
+		const std::size_t nRows,
+		const TFunc &f,
+		Ts *...pColumns )
+	{
+		for ( std::size_t i = 0; i < nRows; ++i )
+		{
+			f( pIds[i], pColumns[i]... );
+		}
+	}
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "non_copyable.h"
+
+
+///=============================================================
+/// \class	FrameArena
+/// \author	KeyC0de
+/// \date	2026/10/17 22:10
+/// \brief	linear (bump) allocator for data that only lives until the arena is reset, usable as a std::pmr::memory_resource
+/// \brief	deallocate is a no-op; everything is released at once by reset
+/// \brief	allocations that don't fit are served by the upstream resource & released on reset
+/// \brief		the next reset then grows the buffer so that the same load fits without going upstream again
+/// \brief	debug builds fill fresh allocations with 0xCD & released memory with 0xDD
+/// \brief		and put guard bytes after every allocation, which are checked on reset to detect overruns
+///=============================================================
+class FrameArena final
+	: public std::pmr::memory_resource,
+	public NonCopyableAndNonMovable
+{
+	static constexpr std::size_t s_minAlignment = alignof( std::max_align_t );
+#if defined _DEBUG && !defined NDEBUG
+	static constexpr std::size_t s_guardSize = 16u;
+	static constexpr unsigned char s_guardByte = 0xFD;
+	static constexpr unsigned char s_allocatedByte = 0xCD;
+	static constexpr unsigned char s_releasedByte = 0xDD;
+	static constexpr std::size_t s_maxTrackedGuards = 4096u;
+#endif
+
+	struct Overflow final
+	{
+		Overflow *m_pNext;
+		std::size_t m_nBytes;
+		std::size_t m_alignment;
+	};
+
+	std::pmr::memory_resource *m_pUpstream;
+	std::unique_ptr<std::byte[]> m_pBuffer;
+	std::size_t m_capacity;
+	std::size_t m_offset = 0;
+	Overflow *m_pOverflows = nullptr;
+	std::size_t m_nOverflowBytes = 0;
+	std::size_t m_nOverflows = 0;
+	std::size_t m_highWaterMark = 0;
+#if defined _DEBUG && !defined NDEBUG
+	std::vector<std::size_t> m_guardOffsets;	// reserved up front so tracking never allocates
+#endif
+public:
+	struct Stats final
+	{
+		std::size_t m_capacity;
+		std::size_t m_nBytesUsed;		// in the buffer since the last reset
+		std::size_t m_nOverflowBytes;	// served by the upstream resource since the last reset
+		std::size_t m_nOverflows;
+		std::size_t m_highWaterMark;	// most bytes requested between two resets
+	};
+public:
+	explicit FrameArena( const std::size_t capacity, std::pmr::memory_resource *pUpstream = std::pmr::new_delete_resource() );
+	~FrameArena() noexcept;
+
+	/// \brief	releases every allocation; the buffer grows here if the previous cycle overflowed
+	void reset();
+	Stats getStats() const noexcept;
+	std::size_t getCapacity() const noexcept;
+private:
+	void* do_allocate( const std::size_t nBytes, const std::size_t alignment ) override;
+	void do_deallocate( void *p, const std::size_t nBytes, const std::size_t alignment ) override;
+	bool do_is_equal( const std::pmr::memory_resource &rhs ) const noexcept override;
+
+	void* allocateOverflow( const std::size_t nBytes, const std::size_t alignment );
+	void releaseOverflows() noexcept;
+	void checkGuards() const;
+};
+
+
+///=============================================================
+/// \class	FrameAllocator
+/// \author	KeyC0de
+/// \date	2026/10/17 22:10
+/// \brief	singleton class
+/// \brief	s_nFramesInFlight sets of FrameArenas, one FrameArena per thread in each set
+/// \brief	threads allocate from their own FrameArena of the current frame without locking
+/// \brief	endFrame moves on to the next set & resets it, so frame data stays valid for s_nFramesInFlight - 1 more frames
+/// \brief		(eg. while the GPU still reads buffers filled from it)
+/// \brief	endFrame must not run while other threads are allocating
+/// \brief	a thread's slot is freed when it exits, to be reused by a later thread along with its FrameArenas; at most s_maxThreads threads can hold one at a time
+/// \brief	example usage:
+/// \brief		std::pmr::vector<ILightSource*> lights{&FrameAllocator::getInstance().getThreadArena()};
+///=============================================================
+class FrameAllocator final
+	: public NonCopyableAndNonMovable
+{
+public:
+	static constexpr unsigned s_nFramesInFlight = 3u;
+	static constexpr std::size_t s_maxThreads = 128u;
+	static constexpr std::size_t s_initialArenaCapacity = 256u * 1024u;
+private:
+	/// \brief	the calling thread's index into m_threadArenas, given back to the FrameAllocator when the thread exits
+	struct ThreadSlot final
+	{
+		std::size_t m_index = s_maxThreads;
+
+		~ThreadSlot() noexcept;
+	};
+
+	static thread_local ThreadSlot s_threadSlot;
+
+	std::mutex m_mu;
+	std::vector<std::array<std::unique_ptr<FrameArena>, s_nFramesInFlight>> m_threadArenas;
+	std::size_t m_nSlots = 0u;				// slots ever taken, the rows endFrame resets
+	std::vector<std::size_t> m_freeSlots;	// of threads that exited
+	std::atomic<unsigned> m_frame{0u};
+private:
+	FrameAllocator();
+public:
+	static FrameAllocator& getInstance();
+
+	/// \brief	the calling thread's FrameArena for the current frame; created on the thread's first call
+	FrameArena& getThreadArena();
+	/// \brief	call once per frame after the frame's work has been submitted
+	void endFrame();
+	unsigned getFrameSlot() const noexcept;
+private:
+	/// \brief	throws if s_maxThreads threads already hold a slot
+	std::size_t getThreadIndex();
+	void releaseThreadSlot( const std::size_t index ) noexcept;
+};
\ No newline at end of file
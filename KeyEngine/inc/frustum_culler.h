@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <DirectXMath.h>
+#include "non_copyable.h"
+
+
+///=============================================================
+/// \class	FrustumCuller
+/// \author	KeyC0de
+/// \date	17/10/2026 15:20
+/// \brief	singleton class
+/// \brief	keeps the world space AABBs of all Meshes in a structure-of-arrays buffer & culls them all in one pass per frame
+/// \brief	boxes are tested 8 at a time with AVX or 4 at a time with SSE against the 6 frustum planes
+/// \brief	the output is a visibility bitset indexed by culling slot
+/// \brief	large scenes are split across the ThreadPoolJ in chunks of whole bitset words
+/// \brief	Meshes acquire a slot on construction & refresh their world AABB whenever their Node's transform changes
+///=============================================================
+class FrustumCuller final
+	: public NonCopyableAndNonMovable
+{
+	static constexpr std::size_t s_parallelThreshold = 8192u;	// boxes
+	static constexpr std::size_t s_wordsPerTask = 32u;			// 2048 boxes per task
+	static constexpr float s_unboundedExtent = 1e30f;			// large but finite so plane distances never become inf - inf
+public:
+	static constexpr std::uint32_t s_invalidSlot = 0xFFFFFFFFu;
+private:
+	// SoA, always padded to a multiple of 64 boxes; padding & free slots hold inverted (empty) boxes which are always culled
+	std::vector<float> m_minX;
+	std::vector<float> m_minY;
+	std::vector<float> m_minZ;
+	std::vector<float> m_maxX;
+	std::vector<float> m_maxY;
+	std::vector<float> m_maxZ;
+	std::vector<std::uint64_t> m_visibility;
+	std::vector<std::uint32_t> m_freeSlots;
+	std::size_t m_nSlots = 0;
+private:
+	FrustumCuller() = default;
+public:
+	static FrustumCuller& getInstance();
+
+	std::uint32_t acquireSlot();
+	void releaseSlot( const std::uint32_t slot ) noexcept;
+	/// \brief	transforms the local space AABB by the world matrix (Arvo's method) & stores it
+	void setBounds( const std::uint32_t slot, const DirectX::XMFLOAT3 &localMin, const DirectX::XMFLOAT3 &localMax, const DirectX::XMFLOAT4X4 &worldTransform ) noexcept;
+	/// \brief	culls all boxes against the 6 inward-facing frustum planes {A,B,C,D}
+	void cull( const std::array<DirectX::XMFLOAT4, 6> &frustumPlanes );
+	/// \brief	marks every slot visible (eg. when culling is disabled)
+	void setAllVisible() noexcept;
+	bool isVisible( const std::uint32_t slot ) const noexcept;
+	std::size_t getSlotCount() const noexcept;
+
+	/// \brief	scalar reference test; true if the box is entirely behind one of the planes
+	static bool isAabbCulled( const DirectX::XMFLOAT4 *frustumPlanes, const DirectX::XMFLOAT3 &bmin, const DirectX::XMFLOAT3 &bmax ) noexcept;
+private:
+	/// \brief	culls boxes [firstWord * 64, lastWord * 64)
+	void cullRange( const DirectX::XMFLOAT4 *frustumPlanes, const std::size_t firstWord, const std::size_t lastWord ) noexcept;
+	void grow();
+};
\ No newline at end of file
@@ -17,7 +17,9 @@ TriangleMesh makeSphereTesselated( std::optional<ver::VertexInputLayout> layout
 TriangleMesh makePlanarGrid( const int length = 2, const int width = 2, int nDivisionsX = 1, int nDivisionsY = 1 );
 TriangleMesh makePlanarGridTextured( const int length = 2, const int width = 2, int nDivisionsX = 1, int nDivisionsY = 1 );
 /// \brief	engine unit is cm, terrain has to be relatively large without consuming a vast amount of memory with indices and vertices, so we multiply its area by `terrainAreaUnitMultiplier`
-TriangleMesh makePlanarGridTexturedFromHeighmap( const std::string &filename, const int normalizeAmount = 4, const int terrainAreaUnitMultiplier = 10, const int length = 2, const int width = 2, int nDivisionsX = 1, int nDivisionsY = 1 );
+/// \brief	the heightmap's blue channel is resampled over the whole grid (nearest or bilinear) & the normals are smoothed from the central differences of the heights
+/// \brief	rows of vertices are built 4 at a time with SSE across the ThreadPoolJ
+TriangleMesh makePlanarGridTexturedFromHeighmap( const std::string &filename, const int normalizeAmount = 4, const int terrainAreaUnitMultiplier = 10, const int length = 2, const int width = 2, int nDivisionsX = 1, int nDivisionsY = 1, const bool bBilinearFiltering = false );
 TriangleMesh makeCameraFrustum( const float width, const float height, const float nearZ, const float farZ, const float verticalFov );
 TriangleMesh makeCameraWidget();
 
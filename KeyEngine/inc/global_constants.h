@@ -9,3 +9,4 @@
 constexpr size_t g_nFramesPerShadowUpdate = 4ull;
 constexpr unsigned g_modelVscbSlot = 0u;
 constexpr unsigned g_modelPscbSlot = g_modelVscbSlot;
+constexpr float g_alphaTestCutoff = 0.05f;	// the HAS_ALPHA pixel shaders clip below it
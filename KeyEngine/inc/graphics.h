@@ -32,6 +32,8 @@ class TextureOffscreenDS;
 class Window;
 class Camera;
 class RectangleF;
+class CpuFramebuffer;
+class SoftwareRasterizer;
 
 namespace ren
 {
@@ -75,9 +77,18 @@ class Graphics final
 		IDXGIAdapter* getAdapter() const noexcept;
 		void getVRamDetails() const noexcept;
 	};
+
+	struct DeferredContext final
+	{
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_pContext;
+		Microsoft::WRL::ComPtr<ID3D11CommandList> m_pCommandList;
+		DirectX::XMMATRIX m_projection;
+		DirectX::XMMATRIX m_view;
+	};
 private:
 	static inline D3D_FEATURE_LEVEL s_featureLevel;
 	static inline std::vector<Adapter> s_adapters;
+	static inline thread_local DeferredContext *s_pRecordingContext = nullptr;	// null when the thread issues commands on the immediate context
 private:
 	unsigned m_width;
 	unsigned m_height;
@@ -105,8 +116,7 @@ private:
 	DirectX::XMMATRIX m_projection;
 	DirectX::XMMATRIX m_view;
 	size_t m_currentFrame = 0u;
-	std::vector<ID3D11DeviceContext*> m_deferredContexts;
-	std::vector<ID3D11CommandList*> m_commandLists;
+	std::vector<std::unique_ptr<DeferredContext>> m_deferredContexts;
 	std::unique_ptr<ren::Renderer> m_pRenderer;
 	ren::Renderer3d* m_pRenderer3d;
 	ren::Renderer2d* m_pRenderer2d;
@@ -124,9 +134,12 @@ public:
 	void beginFrame() noexcept;
 	void endFrame();
 	void draw( const unsigned count ) cond_noex;
-	void drawIndexed( const unsigned count ) cond_noex;
-	void drawIndexedInstanced( const unsigned indexCount, const unsigned instanceCount ) cond_noex;
-	ColorBGRA*& cpuBuffer();
+	void drawIndexed( const unsigned count, const unsigned startIndex = 0u, const int baseVertex = 0 ) cond_noex;
+	/// \brief	firstInstance offsets the reads of per-instance data in the bound instance buffer
+	void drawIndexedInstanced( const unsigned indexCount, const unsigned instanceCount, const unsigned firstInstance = 0u, const unsigned startIndex = 0u ) cond_noex;
+	CpuFramebuffer& cpuFramebuffer();
+	/// \brief	2d mode, its queued primitives are drawn into the CpuFramebuffer by runRenderer
+	SoftwareRasterizer& softwareRasterizer();
 	void setViewMatrix( const DirectX::XMMATRIX &cam ) noexcept;
 	void setProjectionMatrix( const DirectX::XMMATRIX &proj ) noexcept;
 	const DirectX::XMMATRIX& getViewMatrix() const noexcept;
@@ -158,11 +171,18 @@ public:
 	/// \brief	returns true if fullscreen application, false otherwise
 	bool getDisplayMode() const noexcept;
 	bool& getDisplayMode();
-	/// \brief	probably should call this when the Model is being loaded not when pass->run() -> Job->run()
-	void recordDeferredCommandList();
-	/// \brief		ExecuteCommandList must be executed on the immediate context for recorded commands to be run on the GPU
-	void playbackDeferredCommandList();
+	/// \brief	creates deferred contexts until there are at least nContexts of them
+	void reserveDeferredContexts( const std::size_t nContexts );
+	/// \brief	binds & draw calls of the calling thread are recorded on deferred context `index` until finishRecording
+	/// \brief	the view & projection matrices are per context, they start off as the immediate context's
+	void beginRecording( const std::size_t index ) cond_noex;
+	void finishRecording( const std::size_t index ) cond_noex;
+	/// \brief	ExecuteCommandList must be executed on the immediate context for recorded commands to be run on the GPU
+	/// \brief	the immediate context's state is reset to the default afterwards
+	void executeCommandList( const std::size_t index ) cond_noex;
 private:
+	/// \brief	the deferred context the calling thread records on, or the immediate context
+	ID3D11DeviceContext* getCurrentContext() noexcept;
 	/// \brief	present the frame to DWM
 	void present();
 	void interrogateDirectxFeatures();
@@ -172,9 +192,11 @@ private:
 #endif
 private:
 	/// d2d via d3d Interoperability
-	ColorBGRA *m_pCpuBuffer = nullptr;
+	std::unique_ptr<CpuFramebuffer> m_pCpuFramebuffer;
+	std::unique_ptr<SoftwareRasterizer> m_pSoftwareRasterizer;
 public:
 	ColorBGRA getPixel( const int x, const int y ) const noexcept;
+	/// \brief	writes immediately, under the SoftwareRasterizer's primitives that are still queued; flush it first to draw on top of them
 	void putPixel( const int x, const int y, const ColorBGRA color );
 	void putPixel( const int x, const int y, const int r, const int g, const int b );
 	/// \brief	uses the Bresenham algorithm to draw lines, ie. connect 2d positions together by drawing straight lines between them
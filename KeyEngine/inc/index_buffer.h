@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "key_wrl.h"
 #include "bindable.h"
+#include "mesh_optimizer.h"
 
 
 class Graphics;
@@ -13,14 +15,26 @@ class IndexBuffer
 {
 	std::string m_tag;
 	unsigned m_count;
+	unsigned m_indexSize;	// 2 or 4 bytes
+	std::vector<mesh_opt::Lod> m_lods;	// the ranges of the LODs the indices hold, empty for a single LOD
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pIndexBuffer;
 public:
 	IndexBuffer( Graphics &gfx, const std::vector<unsigned> &indices );
 	IndexBuffer( Graphics &gfx, const std::string &tag, const std::vector<unsigned> &indices );
+	/// \brief	16 bit indices, for meshes of up to 0xFFFF vertices
+	IndexBuffer( Graphics &gfx, const std::string &tag, const std::vector<std::uint16_t> &indices );
+	/// \brief	count indices of indexSize (2 or 4) bytes straight from pIndices, eg. a memory mapped cooked model
+	/// \brief	pLods are the ranges of the nLods LODs in them, if there's more than one; they're kept with the indices they refer to
+	IndexBuffer( Graphics &gfx, const std::string &tag, const void *pIndices, const unsigned count, const unsigned indexSize, const mesh_opt::Lod *pLods = nullptr, const unsigned nLods = 0u );
 
 	void bind( Graphics &gfx ) cond_noex override;
 	unsigned getIndexCount() const noexcept;
+	const std::vector<mesh_opt::Lod>& getLods() const noexcept;
 	static std::shared_ptr<IndexBuffer> fetch( Graphics &gfx, const std::string &tag, const std::vector<unsigned> &indices );
+	static std::shared_ptr<IndexBuffer> fetch( Graphics &gfx, const std::string &tag, const std::vector<std::uint16_t> &indices );
+	static std::shared_ptr<IndexBuffer> fetch( Graphics &gfx, const std::string &tag, const void *pIndices, const unsigned count, const unsigned indexSize, const mesh_opt::Lod *pLods = nullptr, const unsigned nLods = 0u );
+	/// \brief	the IndexBuffer fetch returns for tag if it's in the BindableRegistry already, nullptr otherwise
+	static std::shared_ptr<IndexBuffer> find( const std::string &tag );
 	template<typename ...TArgsIgnored>
 	static std::string calcUid( const std::string &tag,
 		TArgsIgnored &&... )
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <DirectXMath.h>
+
+
+namespace ren
+{
+
+///=============================================================
+/// \class	InstanceBatcher
+/// \author	KeyC0de
+/// \date	2026/10/17 20:05
+/// \brief	groups the Jobs of a RenderQueuePass that can be drawn with a single instanced draw call
+/// \brief	Jobs are added in draw order with a batch key (equal keys = same geometry & same Material state) & their world transform
+/// \brief	build() forms a Batch for every key shared by 2+ Jobs & packs their transforms contiguously, batch by batch
+/// \brief	a Batch is drawn in place of its first Job, the remaining Jobs of the Batch are skipped
+/// \brief	pure CPU bookkeeping, no GPU resources are touched
+///=============================================================
+class InstanceBatcher final
+{
+public:
+	static constexpr std::uint32_t s_notBatched = 0xFFFFFFFFu;
+
+	struct Batch final
+	{
+		std::uint32_t m_firstJob;		// the Job the Batch is drawn in place of
+		std::uint32_t m_firstInstance;	// index into getInstanceData()
+		std::uint32_t m_nInstances;
+	};
+private:
+	struct Candidate final
+	{
+		std::uint64_t m_key;
+		std::uint32_t m_jobIndex;
+		DirectX::XMFLOAT4X4 m_worldTransform;
+	};
+
+	std::vector<Candidate> m_candidates;
+	std::unordered_map<std::uint64_t, std::uint32_t> m_keyToBatch;
+	std::vector<Batch> m_batches;
+	std::vector<std::uint32_t> m_jobBatches;	// per Job index: its Batch or s_notBatched
+	std::vector<DirectX::XMFLOAT4X4> m_instanceData;
+public:
+	void clear() noexcept;
+	/// \brief	call in draw order; key 0 is reserved for Jobs that can't be instanced
+	void add( const std::uint64_t key, const std::uint32_t jobIndex, const DirectX::XMFLOAT4X4 &worldTransform );
+	/// \brief	nJobs is the number of Jobs in the queue, batched or not
+	void build( const std::size_t nJobs );
+	/// \brief	the Batch the Job was assigned to, or s_notBatched if it is drawn on its own
+	std::uint32_t getBatch( const std::uint32_t jobIndex ) const noexcept;
+	const std::vector<Batch>& getBatches() const noexcept;
+	/// \brief	world transforms (row major, untransposed) of all batched instances
+	const std::vector<DirectX::XMFLOAT4X4>& getInstanceData() const noexcept;
+};
+
+
+}//namespace ren
\ No newline at end of file
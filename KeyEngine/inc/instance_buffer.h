@@ -0,0 +1,31 @@
+#pragma once
+
+#include "key_wrl.h"
+#include "bindable.h"
+
+
+class Graphics;
+
+///=============================================================
+/// \class	InstanceBuffer
+/// \author	KeyC0de
+/// \date	2026/10/17 20:05
+/// \brief	dynamic vertex buffer holding per-instance data, bound at ver::VertexInputLayout::s_instanceInputSlot
+/// \brief	rewritten in full (discarding the previous contents) on every update & grown geometrically when too small
+///=============================================================
+class InstanceBuffer
+	: public IBindable
+{
+	unsigned m_stride;
+	unsigned m_capacity = 0u;	// in instances
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pInstanceBuffer;
+public:
+	InstanceBuffer( Graphics &gfx, const unsigned stride, const unsigned initialCapacity = 256u );
+
+	/// \brief	uploads nInstances * stride bytes from pData
+	void update( Graphics &gfx, const void *pData, const unsigned nInstances ) cond_noex;
+	void bind( Graphics &gfx ) cond_noex override;
+	unsigned getStride() const noexcept;
+private:
+	void createBuffer( Graphics &gfx, const unsigned capacity );
+};
\ No newline at end of file
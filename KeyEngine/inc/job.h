@@ -16,8 +16,16 @@ public:
 	Job( const Mesh *pMesh, const Material *pMaterial );
 
 	/// \brief	1. binds mesh
-	/// \brief	2. executes draw call
-	void run( Graphics &gfx ) const cond_noex;
+	/// \brief	2. binds material
+	/// \brief	3. executes the Mesh's draw call(s)
+	/// \brief	bindables that pPreviousJob has just bound are not bound again
+	/// \return	the number of binds skipped
+	unsigned run( Graphics &gfx, const Job *pPreviousJob = nullptr ) const cond_noex;
+	/// \brief	draws nInstances instances of this Job's Mesh & Material at the Mesh's LOD lod with one draw call
+	/// \brief	the per-instance data (starting at firstInstance) & the instanced transforms VSCB must be bound already
+	void runInstanced( Graphics &gfx, const unsigned nInstances, const unsigned firstInstance, const unsigned lod ) const cond_noex;
+	const Mesh* getMesh() const noexcept;
+	const Material* getMaterial() const noexcept;
 };
 
 
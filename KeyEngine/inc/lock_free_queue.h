@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include "non_copyable.h"
+#include "assertions_console.h"
+
+
+///=============================================================
+/// \class	WorkStealingDeque
+/// \author	KeyC0de
+/// \date	17/10/2026 12:10
+/// \brief	fixed capacity Chase-Lev deque
+/// \brief	the owning thread pushes & pops at the bottom (LIFO), any other thread may steal from the top (FIFO)
+/// \brief	ref: "Correct and Efficient Work-Stealing for Weak Memory Models", Le, Pop, Cohen, Zappa Nardelli - 2013
+/// \brief	T must be trivially copyable (typically a pointer)
+///=============================================================
+template<typename T>
+class WorkStealingDeque final
+	: public NonCopyableAndNonMovable
+{
+	static_assert( std::is_trivially_copyable_v<T>, "WorkStealingDeque elements must be trivially copyable!" );
+
+	alignas( 64 ) std::atomic<std::int64_t> m_top{0};
+	alignas( 64 ) std::atomic<std::int64_t> m_bottom{0};
+	std::int64_t m_mask;
+	std::unique_ptr<std::atomic<T>[]> m_buffer;
+public:
+	/// \brief	capacity must be a power of 2
+	explicit WorkStealingDeque( const std::size_t capacity )
+		:
+		m_mask{static_cast<std::int64_t>( capacity ) - 1},
+		m_buffer{std::make_unique<std::atomic<T>[]>( capacity )}
+	{
+		ASSERT( capacity > 0 && ( capacity & ( capacity - 1 ) ) == 0, "Capacity must be a power of 2!" );
+	}
+
+	/// \brief	owner only; returns false if the deque is full
+	bool push( const T item ) noexcept
+	{
+		const std::int64_t b = m_bottom.load( std::memory_order_relaxed );
+		const std::int64_t t = m_top.load( std::memory_order_acquire );
+		if ( b - t > m_mask )
+		{
+			return false;
+		}
+		m_buffer[b & m_mask].store( item, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		m_bottom.store( b + 1, std::memory_order_relaxed );
+		return true;
+	}
+
+	/// \brief	owner only
+	bool pop( T &out ) noexcept
+	{
+		const std::int64_t b = m_bottom.load( std::memory_order_relaxed ) - 1;
+		m_bottom.store( b, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		std::int64_t t = m_top.load( std::memory_order_relaxed );
+		if ( t > b )
+		{
+			// empty
+			m_bottom.store( b + 1, std::memory_order_relaxed );
+			return false;
+		}
+
+		out = m_buffer[b & m_mask].load( std::memory_order_relaxed );
+		if ( t == b )
+		{
+			// last item - race against thieves for it
+			const bool bWon = m_top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+			m_bottom.store( b + 1, std::memory_order_relaxed );
+			return bWon;
+		}
+		return true;
+	}
+
+	/// \brief	any thread
+	bool steal( T &out ) noexcept
+	{
+		std::int64_t t = m_top.load( std::memory_order_acquire );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		const std::int64_t b = m_bottom.load( std::memory_order_acquire );
+		if ( t >= b )
+		{
+			return false;
+		}
+
+		const T item = m_buffer[t & m_mask].load( std::memory_order_relaxed );
+		if ( !m_top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+		{
+			// lost the race to another thief or the owner
+			return false;
+		}
+		out = item;
+		return true;
+	}
+
+	/// \brief	approximate when called concurrently
+	bool isEmpty() const noexcept
+	{
+		return m_bottom.load( std::memory_order_relaxed ) <= m_top.load( std::memory_order_relaxed );
+	}
+};
+
+
+///=============================================================
+/// \class	BoundedMpmcQueue
+/// \author	KeyC0de
+/// \date	17/10/2026 12:10
+/// \brief	fixed capacity lock-free multi-producer/multi-consumer FIFO queue
+/// \brief	ref: Dmitry Vyukov's bounded MPMC queue
+/// \brief	every cell carries a sequence number which tells producers & consumers whose turn it is
+/// \brief	capacity must be a power of 2
+///=============================================================
+template<typename T>
+class BoundedMpmcQueue final
+	: public NonCopyableAndNonMovable
+{
+	struct Cell final
+	{
+		std::atomic<std::size_t> m_sequence;
+		T m_data;
+	};
+
+	std::size_t m_mask;
+	std::unique_ptr<Cell[]> m_cells;
+	alignas( 64 ) std::atomic<std::size_t> m_enqueuePos{0};
+	alignas( 64 ) std::atomic<std::size_t> m_dequeuePos{0};
+public:
+	explicit BoundedMpmcQueue( const std::size_t capacity )
+		:
+		m_mask{capacity - 1},
+		m_cells{std::make_unique<Cell[]>( capacity )}
+	{
+		ASSERT( capacity > 1 && ( capacity & ( capacity - 1 ) ) == 0, "Capacity must be a power of 2!" );
+		for ( std::size_t i = 0; i < capacity; ++i )
+		{
+			m_cells[i].m_sequence.store( i, std::memory_order_relaxed );
+		}
+	}
+
+	/// \brief	returns false if the queue is full
+	template<typename U>
+	bool tryPush( U &&data ) noexcept( std::is_nothrow_assignable_v<T&, U&&> )
+	{
+		Cell *cell;
+		std::size_t pos = m_enqueuePos.load( std::memory_order_relaxed );
+		while ( true )
+		{
+			cell = &m_cells[pos & m_mask];
+			const std::size_t seq = cell->m_sequence.load( std::memory_order_acquire );
+			const std::intptr_t diff = static_cast<std::intptr_t>( seq ) - static_cast<std::intptr_t>( pos );
+			if ( diff == 0 )
+			{
+				if ( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					break;
+				}
+			}
+			else if ( diff < 0 )
+			{
+				return false;
+			}
+			else
+			{
+				pos = m_enqueuePos.load( std::memory_order_relaxed );
+			}
+		}
+		cell->m_data = std::forward<U>( data );
+		cell->m_sequence.store( pos + 1, std::memory_order_release );
+		return true;
+	}
+
+	/// \brief	returns false if the queue is empty
+	bool tryPop( T &out ) noexcept( std::is_nothrow_move_assignable_v<T> )
+	{
+		Cell *cell;
+		std::size_t pos = m_dequeuePos.load( std::memory_order_relaxed );
+		while ( true )
+		{
+			cell = &m_cells[pos & m_mask];
+			const std::size_t seq = cell->m_sequence.load( std::memory_order_acquire );
+			const std::intptr_t diff = static_cast<std::intptr_t>( seq ) - static_cast<std::intptr_t>( pos + 1 );
+			if ( diff == 0 )
+			{
+				if ( m_dequeuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					break;
+				}
+			}
+			else if ( diff < 0 )
+			{
+				return false;
+			}
+			else
+			{
+				pos = m_dequeuePos.load( std::memory_order_relaxed );
+			}
+		}
+		out = std::move( cell->m_data );
+		cell->m_sequence.store( pos + m_mask + 1, std::memory_order_release );
+		return true;
+	}
+
+	/// \brief	approximate when called concurrently
+	bool isEmpty() const noexcept
+	{
+		return m_dequeuePos.load( std::memory_order_relaxed ) >= m_enqueuePos.load( std::memory_order_relaxed );
+	}
+};
\ No newline at end of file
@@ -1,65 +1,377 @@
 #pragma once
 
-#include <list>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <functional>
 #include <unordered_map>
-#include <iostream>
 
 
 //=============================================================
 //	\class	LRUCache
 //	\author	KeyC0de
 //	\date	2022/02/22 23:34
-//	\brief	A data structure which can store a max amount of key-value pairs
-//			the list stores the data
-//			to find them fast a hash table stores references to each value in the cache
+//	\brief	A thread safe key-value cache bounded by entry count and by the total bytes of its values
+//			when either bound is exceeded the least recently used entries are evicted
+//			keys are spread over independently locked shards; each shard keeps its entries in an array
+//			with an intrusive doubly linked recency list threaded through it (indices, no per entry allocation)
+//			& a hash table that maps keys to array slots
+//			values are handed out as shared_ptr<const TValue> so they stay alive while in use even if they get evicted
+//			the budgets are global: every use is stamped from a cache wide clock & eviction takes the oldest of the shards' tails
+//			the bounds hold whenever no put is in progress
 //=============================================================
-template<typename T>
+template<typename TKey, typename TValue, typename THash = std::hash<TKey>>
 class LRUCache
 {
-	std::list<T> m_list;
-	std::unordered_map<T, typename std::list<T>::const_iterator> m_map;
-	int m_maxSize;
+	static constexpr std::uint32_t s_null = std::numeric_limits<std::uint32_t>::max();
 public:
-	LRUCache( int maxSize )
+	struct Stats final
+	{
+		std::uint64_t m_nHits = 0;
+		std::uint64_t m_nMisses = 0;
+		std::uint64_t m_nEvictions = 0;
+		std::size_t m_nEntries = 0;
+		std::size_t m_nBytes = 0;
+	};
+private:
+	struct Node final
+	{
+		TKey m_key;
+		std::shared_ptr<const TValue> m_pValue;
+		std::size_t m_nBytes;
+		std::uint64_t m_lastUse;
+		std::uint32_t m_prev;	// towards the most recently used
+		std::uint32_t m_next;	// towards the least recently used
+	};
+
+	struct alignas( 64 ) Shard final
+	{
+		std::mutex m_mu;
+		std::vector<Node> m_nodes;
+		std::vector<std::uint32_t> m_freeNodes;
+		std::unordered_map<TKey, std::uint32_t, THash> m_index;
+		std::uint32_t m_head = s_null;	// most recently used
+		std::uint32_t m_tail = s_null;	// least recently used
+		// the tail's m_lastUse, readable without the lock when looking for the oldest tail
+		std::atomic<std::uint64_t> m_tailLastUse{std::numeric_limits<std::uint64_t>::max()};
+		std::size_t m_nBytes = 0;
+		std::uint64_t m_nHits = 0;
+		std::uint64_t m_nMisses = 0;
+		std::uint64_t m_nEvictions = 0;
+	};
+
+	THash m_hasher;
+	std::size_t m_nShards;
+	std::size_t m_maxEntries;
+	std::size_t m_maxBytes;
+	std::unique_ptr<Shard[]> m_shards;
+	std::atomic<std::uint64_t> m_clock{0};
+	std::atomic<std::size_t> m_nEntries{0};
+	std::atomic<std::size_t> m_nBytes{0};
+public:
+	//	nShards is rounded up to a power of 2; use 1 for single threaded use
+	LRUCache( const std::size_t maxEntries,
+		const std::size_t maxBytes = std::numeric_limits<std::size_t>::max(),
+		const std::size_t nShards = 8u )
 		:
-		m_maxSize{maxSize}
+		m_nShards{roundUpToPowerOf2( nShards )},
+		m_maxEntries{std::max<std::size_t>( 1u, maxEntries )},
+		m_maxBytes{maxBytes},
+		m_shards{std::make_unique<Shard[]>( m_nShards )}
 	{
 
 	}
 
 	//===================================================
-	//	\function	find
-	//	\brief	refers element x with in the LRU cache
+	//	\function	get
+	//	\brief	returns the value & marks it as the most recently used, or nullptr if it's not cached
 	//	\date	2022/07/30 21:08
-	void find( T x )
+	std::shared_ptr<const TValue> get( const TKey &key )
 	{
-		if ( m_map.find( x ) == m_map.end() )
+		Shard &shard = getShard( key );
+		std::lock_guard<std::mutex> lg{shard.m_mu};
+		const auto it = shard.m_index.find( key );
+		if ( it == shard.m_index.end() )
 		{
-			// not present in cache
-			if ( m_list.size() == m_maxSize )
+			++shard.m_nMisses;
+			return nullptr;
+		}
+		++shard.m_nHits;
+		moveToFront( shard, it->second );
+		return shard.m_nodes[it->second].m_pValue;
+	}
+
+	//===================================================
+	//	\function	put
+	//	\brief	inserts or replaces the value of key, nBytes is what the value counts against the byte budget
+	//	\brief	returns false if the value alone exceeds the byte budget; it isn't cached then
+	//	\brief	otherwise the least recently used entries of all shards are evicted until the cache is within its budgets
+	//	\date	2026/10/17 21:30
+	bool put( const TKey &key,
+		std::shared_ptr<const TValue> pValue,
+		const std::size_t nBytes )
+	{
+		if ( nBytes > m_maxBytes )
+		{
+			return false;
+		}
+
+		{
+			Shard &shard = getShard( key );
+			std::lock_guard<std::mutex> lg{shard.m_mu};
+			const auto [it, bInserted] = shard.m_index.try_emplace( key, s_null );
+			if ( bInserted )
+			{
+				it->second = allocateNode( shard, key, std::move( pValue ), nBytes );
+				pushFront( shard, it->second );
+				m_nEntries.fetch_add( 1u, std::memory_order_relaxed );
+			}
+			else
+			{
+				Node &node = shard.m_nodes[it->second];
+				shard.m_nBytes -= node.m_nBytes;
+				m_nBytes.fetch_sub( node.m_nBytes, std::memory_order_relaxed );
+				node.m_pValue = std::move( pValue );
+				node.m_nBytes = nBytes;
+				moveToFront( shard, it->second );
+			}
+			shard.m_nBytes += nBytes;
+			m_nBytes.fetch_add( nBytes, std::memory_order_relaxed );
+		}
+
+		// a single shard lock is held at a time, so concurrent puts can't deadlock
+		while ( m_nEntries.load( std::memory_order_relaxed ) > m_maxEntries || m_nBytes.load( std::memory_order_relaxed ) > m_maxBytes )
+		{
+			if ( !evictLeastRecentlyUsed() )
 			{
-				// cache is full so delete least recently used element
-				T last = m_list.back();
-				m_list.pop_back();
-				m_map.erase( last );
+				break;
 			}
 		}
+		return true;
+	}
+
+	//===================================================
+	//	\function	getOrLoad
+	//	\brief	on a miss calls `load( key )`, which returns std::pair<std::shared_ptr<const TValue>, std::size_t bytes>, & caches the result
+	//	\brief	load runs without holding the lock, so concurrent misses on the same key may both load it - the last one is kept
+	//	\date	2026/10/17 21:30
+	template<typename TLoad>
+	std::shared_ptr<const TValue> getOrLoad( const TKey &key,
+		const TLoad &load )
+	{
+		if ( std::shared_ptr<const TValue> pValue = get( key ) )
+		{
+			return pValue;
+		}
+		auto [pValue, nBytes] = load( key );
+		if ( pValue )
+		{
+			put( key, pValue, nBytes );
+		}
+		return pValue;
+	}
+
+	bool erase( const TKey &key )
+	{
+		Shard &shard = getShard( key );
+		std::lock_guard<std::mutex> lg{shard.m_mu};
+		const auto it = shard.m_index.find( key );
+		if ( it == shard.m_index.end() )
+		{
+			return false;
+		}
+		const std::uint32_t index = it->second;
+		shard.m_index.erase( it );
+		unlink( shard, index );
+		freeNode( shard, index );
+		return true;
+	}
+
+	void clear()
+	{
+		for ( std::size_t i = 0; i < m_nShards; ++i )
+		{
+			Shard &shard = m_shards[i];
+			std::lock_guard<std::mutex> lg{shard.m_mu};
+			m_nEntries.fetch_sub( shard.m_index.size(), std::memory_order_relaxed );
+			m_nBytes.fetch_sub( shard.m_nBytes, std::memory_order_relaxed );
+			shard.m_nodes.clear();
+			shard.m_freeNodes.clear();
+			shard.m_index.clear();
+			shard.m_head = s_null;
+			shard.m_tail = s_null;
+			publishTailLastUse( shard );
+			shard.m_nBytes = 0;
+		}
+	}
+
+	Stats getStats() const
+	{
+		Stats stats;
+		for ( std::size_t i = 0; i < m_nShards; ++i )
+		{
+			Shard &shard = m_shards[i];
+			std::lock_guard<std::mutex> lg{shard.m_mu};
+			stats.m_nHits += shard.m_nHits;
+			stats.m_nMisses += shard.m_nMisses;
+			stats.m_nEvictions += shard.m_nEvictions;
+			stats.m_nEntries += shard.m_index.size();
+			stats.m_nBytes += shard.m_nBytes;
+		}
+		return stats;
+	}
+private:
+	static std::size_t roundUpToPowerOf2( const std::size_t n ) noexcept
+	{
+		std::size_t p = 1;
+		while ( p < n )
+		{
+			p <<= 1;
+		}
+		return p;
+	}
+
+	Shard& getShard( const TKey &key ) const
+	{
+		// std::hash of integers is the identity, mix the bits before picking a shard
+		std::uint64_t h = static_cast<std::uint64_t>( m_hasher( key ) );
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return m_shards[static_cast<std::size_t>( h ) & ( m_nShards - 1 )];
+	}
+
+	std::uint32_t allocateNode( Shard &shard,
+		const TKey &key,
+		std::shared_ptr<const TValue> pValue,
+		const std::size_t nBytes )
+	{
+		if ( !shard.m_freeNodes.empty() )
+		{
+			const std::uint32_t index = shard.m_freeNodes.back();
+			shard.m_freeNodes.pop_back();
+			shard.m_nodes[index] = Node{key, std::move( pValue ), nBytes, 0u, s_null, s_null};
+			return index;
+		}
+		shard.m_nodes.push_back( Node{key, std::move( pValue ), nBytes, 0u, s_null, s_null} );
+		return static_cast<std::uint32_t>( shard.m_nodes.size() - 1 );
+	}
+
+	void freeNode( Shard &shard,
+		const std::uint32_t index )
+	{
+		Node &node = shard.m_nodes[index];
+		shard.m_nBytes -= node.m_nBytes;
+		m_nBytes.fetch_sub( node.m_nBytes, std::memory_order_relaxed );
+		m_nEntries.fetch_sub( 1u, std::memory_order_relaxed );
+		node.m_pValue.reset();
+		node.m_nBytes = 0;
+		shard.m_freeNodes.push_back( index );
+	}
+
+	void pushFront( Shard &shard,
+		const std::uint32_t index ) noexcept
+	{
+		Node &node = shard.m_nodes[index];
+		// stamped under the shard's lock, so every shard's recency list is ordered by m_lastUse
+		node.m_lastUse = m_clock.fetch_add( 1u, std::memory_order_relaxed );
+		node.m_prev = s_null;
+		node.m_next = shard.m_head;
+		if ( shard.m_head != s_null )
+		{
+			shard.m_nodes[shard.m_head].m_prev = index;
+		}
+		shard.m_head = index;
+		if ( shard.m_tail == s_null )
+		{
+			shard.m_tail = index;
+			publishTailLastUse( shard );
+		}
+	}
+
+	static void unlink( Shard &shard,
+		const std::uint32_t index ) noexcept
+	{
+		Node &node = shard.m_nodes[index];
+		if ( node.m_prev != s_null )
+		{
+			shard.m_nodes[node.m_prev].m_next = node.m_next;
+		}
+		else
+		{
+			shard.m_head = node.m_next;
+		}
+
+		if ( node.m_next != s_null )
+		{
+			shard.m_nodes[node.m_next].m_prev = node.m_prev;
+		}
 		else
 		{
-			m_list.erase( m_map[x] );
+			shard.m_tail = node.m_prev;
+			publishTailLastUse( shard );
 		}
+	}
 
-		// update reference
-		m_list.push_front( x );
-		m_map[x] = m_list.cbegin();
+	static void publishTailLastUse( Shard &shard ) noexcept
+	{
+		shard.m_tailLastUse.store( shard.m_tail == s_null ? std::numeric_limits<std::uint64_t>::max() : shard.m_nodes[shard.m_tail].m_lastUse, std::memory_order_relaxed );
+	}
+
+	void moveToFront( Shard &shard,
+		const std::uint32_t index ) noexcept
+	{
+		if ( shard.m_head != index )
+		{
+			unlink( shard, index );
+			pushFront( shard, index );
+		}
+		else
+		{
+			shard.m_nodes[index].m_lastUse = m_clock.fetch_add( 1u, std::memory_order_relaxed );
+			if ( shard.m_tail == index )
+			{
+				publishTailLastUse( shard );
+			}
+		}
 	}
 
-	void display()
+	//	\brief	evicts the oldest of the shards' least recently used entries; returns false if the cache is empty
+	bool evictLeastRecentlyUsed()
 	{
-		for ( auto it = m_list.cbegin(); it != m_list.cend(); ++it )
+		Shard *pOldest = nullptr;
+		std::uint64_t oldestUse = std::numeric_limits<std::uint64_t>::max();
+		for ( std::size_t i = 0; i < m_nShards; ++i )
+		{
+			const std::uint64_t tailLastUse = m_shards[i].m_tailLastUse.load( std::memory_order_relaxed );
+			if ( tailLastUse < oldestUse )
+			{
+				oldestUse = tailLastUse;
+				pOldest = &m_shards[i];
+			}
+		}
+		if ( pOldest == nullptr )
+		{
+			return false;
+		}
+
+		// another thread may have used or evicted that tail meanwhile; the shard's new tail is nearly as old
+		std::lock_guard<std::mutex> lg{pOldest->m_mu};
+		if ( pOldest->m_tail == s_null )
 		{
-			std::cout << ( *it ) << " ";
+			return true;
 		}
-		std::cout << std::endl;
+		const std::uint32_t index = pOldest->m_tail;
+		pOldest->m_index.erase( pOldest->m_nodes[index].m_key );
+		unlink( *pOldest, index );
+		freeNode( *pOldest, index );
+		++pOldest->m_nEvictions;
+		return true;
 	}
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include "bindable.h"
@@ -23,6 +24,15 @@ class Material
 	std::string m_targetPassName;
 	ren::RenderQueuePass *m_pTargetPass = nullptr;
 	std::vector<std::shared_ptr<IBindable>> m_bindables;
+	std::vector<std::uint8_t> m_bindSkippable;	// per m_bindables entry: shared state that need not be rebound if the previous Job bound it
+	std::uint32_t m_shaderSortId = 0u;	// hash of the shaders, consecutive Jobs with the same shaders are grouped by the RenderQueuePass
+	std::uint32_t m_textureSortId = 0u;
+	std::uint64_t m_bindablesHash = 0u;
+	bool m_bHasClonedBindables = false;
+	int m_vertexShaderIndex = -1;
+	int m_inputLayoutIndex = -1;
+	std::shared_ptr<IBindable> m_pInstancedVertexShader;	// substitute the VertexShader & InputLayout in instanced draws
+	std::shared_ptr<IBindable> m_pInstancedInputLayout;
 public:
 	/// \function	Material	||	\date	2024/04/25 13:55
 	/// \brief	the channels is a bitwise mask (rendering_channel.h) which corresponds to the Rendering channel(s) used for this Material
@@ -37,7 +47,8 @@ public:
 
 	void addBindable( std::shared_ptr<IBindable> pBindable ) noexcept;
 	void render( const Mesh &mesh, const size_t channels ) const noexcept;
-	void bind( Graphics &gfx ) const cond_noex;
+	/// \brief	bindables that pPreviousMaterial has just bound are skipped, unless they carry per Mesh state; returns the number of skipped binds
+	unsigned bind( Graphics &gfx, const Material *pPreviousMaterial = nullptr ) const cond_noex;
 	bool isEnabled() const noexcept;
 	void setEnabled( const bool b ) noexcept;
 	void setEnabled( const size_t channels, const bool bEnabled ) noexcept;
@@ -50,4 +61,13 @@ public:
 	std::vector<std::shared_ptr<IBindable>>& getBindables();
 	const std::vector<std::shared_ptr<IBindable>>& getBindables() const noexcept;
 	size_t getChannelMask() const noexcept;
+	std::uint32_t getShaderSortId() const noexcept;
+	std::uint32_t getTextureSortId() const noexcept;
+	/// \brief	opts the Material in to instanced draws; the InputLayout must have per-instance elements (ver::VertexInputLayout::addInstance)
+	void setInstancing( std::shared_ptr<IBindable> pInstancedVertexShader, std::shared_ptr<IBindable> pInstancedInputLayout ) noexcept;
+	/// \brief	0 if the Material can't be instanced, otherwise Materials with the same key bind the same state
+	/// \brief	Materials holding per Mesh (cloned) bindables can't be instanced
+	std::uint64_t getInstancingKey() const noexcept;
+	/// \brief	binds all bindables, with the instanced VertexShader & InputLayout in place of the regular ones
+	void bindInstanced( Graphics &gfx ) const cond_noex;
 };
\ No newline at end of file
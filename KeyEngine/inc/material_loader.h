@@ -1,16 +1,17 @@
 #pragma once
 
 #include <filesystem>
+#include <string>
 #include <vector>
+#include <DirectXMath.h>
 #include "dynamic_vertex_buffer.h"
+#include "mesh_optimizer.h"
 
 
 struct aiMaterial;
 struct aiMesh;
 class Graphics;
 class Material;
-class VertexBuffer;
-class IndexBuffer;
 
 ///=============================================================
 /// \class	MaterialLoader
@@ -21,18 +22,43 @@ class IndexBuffer;
 ///=============================================================
 class MaterialLoader final
 {
+public:
+	/// \brief	everything the Materials are built from, importer agnostic so it can be cooked
+	struct Desc final
+	{
+		std::string name;
+		std::string diffuseTexture;		// relative to the model's directory, empty if there's none
+		std::string specularTexture;
+		std::string normalTexture;
+		DirectX::XMFLOAT4 diffuseColor{0.45f, 0.45f, 0.85f, 1.0f};
+		DirectX::XMFLOAT3 specularColor{0.18f, 0.18f, 0.18f};
+		float specularGloss = 8.0f;
+	};
+
+	struct Geometry final
+	{
+		ver::VBuffer vertices;
+		std::vector<unsigned> indices;		// all the LODs' indices, one after the other
+		std::vector<mesh_opt::Lod> lods;
+	};
+private:
 	ver::VertexInputLayout m_vertexLayout;
 	std::string m_modelPath;
-	std::string m_name;
+	Desc m_desc;
 	std::vector<Material> m_materials;
 public:
 	MaterialLoader( Graphics &gfx, const aiMaterial &aimaterial, const std::filesystem::path &modelPath ) cond_noex;
+	MaterialLoader( Graphics &gfx, Desc desc, const std::filesystem::path &modelPath ) cond_noex;
 
-	std::shared_ptr<VertexBuffer> makeVertexBuffer( Graphics &gfx, const aiMesh &aimesh, float scale = 1.0f ) const cond_noex;
-	std::shared_ptr<IndexBuffer> makeIndexBuffer( Graphics &gfx, const aiMesh &aimesh ) const cond_noex;
+	/// \brief	extracts aimesh's vertices (scaled) & indices & runs them through the mesh_opt stages (deduplication, vertex cache, overdraw & vertex fetch ordering)
+	/// \brief	then appends its simplified LODs
+	Geometry makeGeometry( const aiMesh &aimesh, const float scale = 1.0f, const mesh_opt::LodSettings &lodSettings = {} ) const cond_noex;
 	std::vector<Material> getMaterial() const noexcept;
+	const Desc& getDesc() const noexcept;
+	const ver::VertexInputLayout& getVertexLayout() const noexcept;
+	std::string calcMeshTag( const std::string &meshName ) const noexcept;
 private:
-	std::string calcMeshTag( const aiMesh &mesh ) const noexcept;
+	static Desc makeDesc( const aiMaterial &aimaterial );
 	ver::VBuffer makeVertexBuffer_impl( const aiMesh &aimesh ) const noexcept;
 	std::vector<unsigned> makeIndexBuffer_impl( const aiMesh &aimesh ) const noexcept;
 };
\ No newline at end of file
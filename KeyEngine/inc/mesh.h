@@ -3,9 +3,12 @@
 #include <DirectXMath.h>
 #include <memory>
 #include <optional>
+#include <atomic>
 #include "material.h"
 #include "rendering_channel.h"
 #include "transform_vscb.h"
+#include "frustum_culler.h"
+#include "mesh_optimizer.h"
 #ifndef FINAL_RELEASE
 #	include "imgui_visitors.h"
 #endif
@@ -18,7 +21,6 @@ class Graphics;
 class MaterialLoader;
 class IBindable;
 class Node;
-struct aiMesh;
 
 namespace ren
 {
@@ -30,19 +32,27 @@ namespace ver
 class VBuffer;
 }
 
+namespace model_cache
+{
+struct MeshData;
+}
+
 class Mesh
 {
 	float m_distanceFromActiveCamera = 0.0f;
 	mutable bool m_bRenderedThisFrame = false;
 protected:
 	unsigned m_meshId = 0u;
+	std::uint32_t m_cullingSlot = FrustumCuller::s_invalidSlot;
 	Node *m_pNode = nullptr;
-	std::pair<DirectX::XMFLOAT3, DirectX::XMFLOAT3> m_aabb{{0, 0, 0},{0, 0, 0}};	// #TODO: Collision mesh needs to be recalculated if the object is rotated, scaled or animated
+	std::pair<DirectX::XMFLOAT3, DirectX::XMFLOAT3> m_aabb{{0, 0, 0},{0, 0, 0}};	// local space; its world space version is refreshed in the FrustumCuller whenever the Node's transform changes
 	std::shared_ptr<VertexBuffer> m_pVertexBuffer;
 	std::shared_ptr<IndexBuffer> m_pIndexBuffer;
 	std::shared_ptr<PrimitiveTopology> m_pPrimitiveTopology;
 	std::unique_ptr<TransformVSCB> m_pTransformVscb;
 	std::vector<Material> m_materials;
+	std::vector<mesh_opt::Lod> m_lods;	// empty for single LOD Meshes, which draw their whole index buffer
+	mutable std::atomic<unsigned> m_lod{0u};	// the LOD picked by the last selection, of any pass; a pass only keeps it while it's within its hysteresis band
 
 	struct ColorPSCB
 	{
@@ -68,8 +78,9 @@ public:
 	/// \brief	defctor to be called by subclasses
 	Mesh() = default;
 #pragma warning( default : 26495 )
-	/// \brief	ctor for imported models, creates bounding box & meshId
-	Mesh( Graphics &gfx, const MaterialLoader &mat, const aiMesh &aimesh, const float initialScale = 1.0f );
+	/// \brief	ctor for imported & cooked models, the buffers are uploaded straight from meshData's (already scaled) blobs
+	/// \brief	unless they're in the BindableRegistry already, in which case the blobs aren't read & may be null
+	Mesh( Graphics &gfx, const MaterialLoader &mat, const model_cache::MeshData &meshData );
 	virtual ~Mesh() noexcept;
 	Mesh( const Mesh &rhs ) = delete;
 	Mesh& operator=( const Mesh &rhs ) = delete;
@@ -78,9 +89,18 @@ public:
 
 	void setNode( Node &node );
 	void update( const float dt, const float lerpBetweenFrames ) cond_noex;
-	void render( const size_t channels = rch::all ) const noexcept;
+	virtual void render( const size_t channels = rch::all ) const noexcept;
 	/// \brief called by Job::run
-	void bind( Graphics &gfx ) const cond_noex;
+	/// \brief	the vertex & index buffers that pPreviousMesh has just bound are skipped; returns the number of skipped binds
+	unsigned bind( Graphics &gfx, const Mesh *pPreviousMesh = nullptr ) const cond_noex;
+	/// \brief	binds the buffers & topology without the per Mesh transform, for instanced draws
+	void bindGeometry( Graphics &gfx ) const cond_noex;
+	/// \brief	issues the draw call(s) of a bound Mesh, by default all indices of the LOD selected for the pass at once
+	virtual void draw( Graphics &gfx ) const cond_noex;
+	/// \brief	Meshes with equal keys share vertex & index buffers and topology
+	std::uint64_t getGeometryKey() const noexcept;
+	/// \brief	picks the LOD by the Mesh's projected size in the view & projection gfx holds, so every pass (eg. each shadow map) gets its own
+	unsigned selectLod( const Graphics &gfx ) const noexcept;
 
 	template<typename T, typename = std::enable_if_t<std::is_base_of_v<IBindable, T>>>
 	std::optional<T*> findBindable() noexcept
@@ -119,7 +139,9 @@ public:
 #ifndef FINAL_RELEASE
 	void accept( IImGuiConstantBufferVisitor &ev );
 #endif
-	unsigned getIndicesCount() const cond_noex;
+	/// \brief	of the given LOD, 0 being the full detail mesh
+	unsigned getIndicesCount( const unsigned lod = 0u ) const cond_noex;
+	unsigned getStartIndex( const unsigned lod = 0u ) const noexcept;
 	void connectMaterialsToRenderer( ren::Renderer &r );
 	float getDistanceFromActiveCamera() const noexcept;
 	bool isRenderedThisFrame() const noexcept;
@@ -130,10 +152,12 @@ public:
 	unsigned getMeshId() const noexcept;
 protected:
 	float getDistanceFromActiveCamera( const DirectX::XMFLOAT3 &pos ) const noexcept;
-	void setMeshId() noexcept;
+	/// \brief	also acquires the Mesh's FrustumCuller slot
+	void setMeshId();
 private:
 	void setDistanceFromActiveCamera() noexcept;
-	void createAabb( const aiMesh &aiMesh );
 	/// \brief	returns true if the Mesh is culled this frame by the active camera and false otherwise
+	/// \brief	the actual culling is done for all Meshes at once by the FrustumCuller at the start of the frame
 	bool isFrustumCulled() const noexcept;
-};
+	void updateCullingBounds() const noexcept;
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+// import time optimization of indexed triangle lists, pure CPU code
+// the vertices are opaque blobs of `stride` bytes, only overdraw ordering needs to know where the float3 position is inside them
+// ACMR (average cache miss ratio) = post transform vertex cache misses / triangles, measured on a FIFO cache of s_fifoCacheSize entries
+//	3 means no reuse at all, ~0.5 is the lower bound for a regular grid
+// LODs are coarser index lists over the same vertices, appended after the full detail one in a single index buffer
+//	their error is relative to the mesh's largest extent, so error * the mesh's size on screen is the error on screen
+namespace mesh_opt
+{
+
+static constexpr unsigned s_fifoCacheSize = 16u;
+// LRU cache size Forsyth's scores are tuned for
+static constexpr unsigned s_lruCacheSize = 32u;
+// overdraw ordering may raise the ACMR by up to this factor
+static constexpr float s_overdrawAcmrThreshold = 1.05f;
+// a LOD is dropped unless it has at most this fraction of the previous LOD's triangles
+static constexpr float s_minLodReduction = 0.85f;
+// LOD selection: the largest projected error allowed, in pixels of the view's render target
+static constexpr float s_lodMaxPixelError = 2.0f;
+// & the band around it, as a fraction, within which the current LOD is kept
+static constexpr float s_lodHysteresis = 0.25f;
+
+struct StepReport final
+{
+	const char *name;
+	float acmrBefore;
+	float acmrAfter;
+	std::size_t vertexBytesBefore;
+	std::size_t vertexBytesAfter;
+	std::size_t indexBytesBefore;
+	std::size_t indexBytesAfter;
+};
+
+struct Lod final
+{
+	unsigned startIndex;
+	unsigned nIndices;
+	float error;
+};
+
+/// \brief	a vertex attribute that simplification tries to keep continuous
+struct Attribute final
+{
+	std::size_t offset;
+	unsigned nComponents;	// floats
+	float weight;
+};
+
+struct LodSettings final
+{
+	unsigned nLods = 4u;			// including the full detail one
+	float reduction = 0.5f;			// triangle count of each LOD relative to the previous one
+	float targetError = 0.02f;		// relative to the mesh's extent; simplification stops short of the triangle target rather than exceed it
+	float normalWeight = 0.01f;
+	float texcoordWeight = 0.01f;
+};
+
+float calcAcmr( const unsigned *indices, const std::size_t nIndices, const std::size_t nVertices, const unsigned cacheSize = s_fifoCacheSize );
+/// \brief	merges bitwise identical vertices, compacting pVertices & remapping indices
+/// \return	the new vertex count
+std::size_t deduplicateVertices( char *pVertices, const std::size_t nVertices, const std::size_t stride, unsigned *indices, const std::size_t nIndices );
+/// \brief	reorders the triangles for the post transform vertex cache with Tom Forsyth's linear-speed greedy algorithm
+void optimizeVertexCache( unsigned *indices, const std::size_t nIndices, const std::size_t nVertices );
+/// \brief	Sander, Nehab & Barczak's "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw":
+/// \brief		splits the cache optimized triangles into clusters at cache flushes & wherever a cluster reaches threshold * its hard cluster's ACMR,
+/// \brief		then sorts the clusters so the ones facing away from the mesh's centroid, which tend to occlude the rest, are drawn first
+void optimizeOverdraw( unsigned *indices, const std::size_t nIndices, const char *pVertices, const std::size_t nVertices, const std::size_t stride, const std::size_t positionOffset, const float threshold = s_overdrawAcmrThreshold );
+/// \brief	renumbers the vertices in order of first use so fetching them walks memory linearly; unreferenced vertices are dropped
+/// \return	the new vertex count
+std::size_t optimizeVertexFetch( char *pVertices, const std::size_t nVertices, const std::size_t stride, unsigned *indices, const std::size_t nIndices );
+/// \brief	whether 16 bit indices can address nVertices vertices
+bool canUse16BitIndices( const std::size_t nVertices ) noexcept;
+/// \brief	runs all of the above in order on the vertices & their triangle list, compacting pVertices
+/// \brief		nVertices receives the new vertex count
+/// \return	one report per step, the last of which is the index format choice
+std::vector<StepReport> optimize( char *pVertices, std::size_t &nVertices, const std::size_t stride, const std::size_t positionOffset, std::vector<unsigned> &indices );
+/// \brief	quadric error metric simplification (Garland & Heckbert) by half edge collapses onto existing vertices, so the vertices are left untouched
+/// \brief		vertices on edges with a single triangle - the mesh's borders & attribute seams - are locked
+/// \brief		attribute differences across an edge raise the cost of collapsing it, they don't count towards the error
+/// \return	the new index count; pResultError receives the largest error of a collapse that was made
+std::size_t simplify( unsigned *indices, const std::size_t nIndices, const char *pVertices, const std::size_t nVertices, const std::size_t stride, const std::size_t positionOffset, const std::size_t targetIndexCount, const float targetError, const Attribute *pAttributes = nullptr, const std::size_t nAttributes = 0, float *pResultError = nullptr );
+/// \brief	appends settings.nLods - 1 vertex cache optimized LODs to indices, fewer if simplification stalls at the error target
+/// \return	all LODs, the first being the original indices
+std::vector<Lod> generateLods( std::vector<unsigned> &indices, const char *pVertices, const std::size_t nVertices, const std::size_t stride, const std::size_t positionOffset, const Attribute *pAttributes, const std::size_t nAttributes, const LodSettings &settings = {} );
+/// \brief	the coarsest LOD whose error projected on screen is within maxPixelError, keeping currentLod while within the hysteresis band around it
+/// \brief	pixelSize is the mesh's largest extent on screen, in pixels
+unsigned selectLod( const Lod *pLods, const std::size_t nLods, const float pixelSize, const unsigned currentLod, const float maxPixelError = s_lodMaxPixelError, const float hysteresis = s_lodHysteresis ) noexcept;
+
+}//namespace mesh_opt
\ No newline at end of file
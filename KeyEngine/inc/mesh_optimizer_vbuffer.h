@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include "mesh_optimizer.h"
+
+
+namespace ver
+{
+
+class VBuffer;
+
+}
+
+// mesh_opt for ver::VBuffers, kept apart so that mesh_optimizer itself doesn't depend on the vertex layout's DirectXMath types
+namespace mesh_opt
+{
+
+/// \brief	optimize on vb, which must hold a Position3D element, shrinking it to the vertices left
+/// \return	one report per step, the last of which is the index format choice
+std::vector<StepReport> optimize( ver::VBuffer &vb, std::vector<unsigned> &indices );
+/// \brief	generateLods for vb's layout, its Normal & first Texture2D elements if any are the attributes
+std::vector<Lod> generateLods( const ver::VBuffer &vb, std::vector<unsigned> &indices, const LodSettings &settings = {} );
+
+}//namespace mesh_opt
\ No newline at end of file
@@ -1,22 +1,28 @@
 #pragma once
 
-#include <memory>
-#include <vector>
+#include <cstddef>
+#include <type_traits>
 #include "non_copyable.h"
 
 
 class Entity;
-class Operation;
+class MessageBus;
 
 ///=============================================================
 /// \class	Message
 /// \author	KeyC0de
 /// \date	2019/12/09 13:23
-/// \brief	The Message - Enveloppe, move-only type
+/// \brief	The Message - Enveloppe
+/// \brief	Messages live in place inside the MessageBus's ring buffer cells, hence they can neither be copied nor moved; only the MessageBus relocates them, when it compacts the ring
+/// \brief	a Message carries an optional typed payload of any type T:
+/// \brief		small payloads (up to s_inlinePayloadSize bytes) are constructed inline in the Message
+/// \brief		larger ones go to a block from the MessageBus's payload pool (or the heap if the pool is exhausted)
+/// \brief	getPayload<T>() returns nullptr if the Message carries no payload or a payload of a different type
 ///=============================================================
-class Message
-	: public NonCopyable
+class Message final
+	: public NonCopyableAndNonMovable
 {
+	friend class MessageBus;
 public:
 	enum Type
 	{
@@ -26,90 +32,66 @@ public:
 		Greet,
 		PhysicsCollision
 	};
+
+	static constexpr std::size_t s_inlinePayloadSize = 48u;
+	static constexpr std::size_t s_inlinePayloadAlignment = 16u;
 private:
+	enum PayloadStorage : unsigned char
+	{
+		None,
+		Inline,
+		Pooled,
+		Heap
+	};
+
+	alignas( s_inlinePayloadAlignment ) unsigned char m_inlinePayload[s_inlinePayloadSize];
+	void *m_pPayload = nullptr;
+	const void *m_pPayloadTag = nullptr;
+	void ( *m_pfnDestroyPayload )( void *pPayload ) = nullptr;
+	/// \brief	moves an inline payload to another Message's inline storage & destroys the source; nullptr if it can be memcpy-ed
+	void ( *m_pfnRelocatePayload )( void *pDst, void *pSrc ) = nullptr;
+	Entity *m_pSender = nullptr;
+	Entity *m_pRecipient = nullptr;
+	Message::Type m_type = Idle;
+	PayloadStorage m_payloadStorage = None;
 	bool m_bHandled = false;
-	Entity *m_pSender;
-	std::vector<Entity*> m_recipients;
-	Message::Type m_type;
+private:
+	/// \brief	a unique address per payload type, used to check getPayload<T>() requests
+	template<typename T>
+	static const void* getPayloadTag() noexcept
+	{
+		static const char tag = 0;
+		return &tag;
+	}
 public:
-	Message( Entity *srcId, const std::vector<Entity*> &destId, const Message::Type type );
-	Message( Message &&rhs ) noexcept;
-	Message& operator=( Message &&rhs ) noexcept;
-	virtual ~Message() noexcept;
+	/// \brief	Messages are only filled in by the MessageBus
+	Message() = default;
+	~Message() noexcept = default;
 
-	const Message::Type getType() const noexcept;
-	const Entity* getSender() noexcept;
-	const std::vector<Entity*>& getRecipients() noexcept;
+	Message::Type getType() const noexcept;
+	Entity* getSender() const noexcept;
+	Entity* getRecipient() const noexcept;
 	bool isHandled() const noexcept;
 	void setHandled( const bool b ) noexcept;
-};
-
-
-///=============================================================
-/// \class	MessageCall
-/// \author	KeyC0de
-/// \date	2019/12/10 3:01
-/// \brief	a Message with arbitrary callable object
-///=============================================================
-class MessageCall
-	:
-	public Message
-{
-	std::unique_ptr<Operation> m_pFunc;
-public:
-	MessageCall( Entity *psrc, const std::vector<Entity*> &pDests, Message::Type type, std::unique_ptr<Operation> df );
-	MessageCall( MessageCall &&rhs ) noexcept;
-	MessageCall& operator=( MessageCall &&rhs ) noexcept;
-	virtual ~MessageCall() noexcept = default;
-
-	Operation* getCallable() const noexcept;
-};
-
-
-///=============================================================
-/// \class	MessageData<T>
-/// \author	KeyC0de
-/// \date	2019/12/10 3:01
-/// \brief	a Message with arbitrary data payload T
-///=============================================================
-template<class T>
-class MessageData
-	:
-	public Message
-{
-	std::unique_ptr<T> m_pPayload;
-public:
-	template<typename ... TParams>
-	MessageData( Entity *src,
-		const std::vector<Entity*> &pDests,
-		Message::Type type,
-		TParams&&... args )
-		:
-		Message{src, pDests, type},
-		m_pPayload{std::make_unique<T>( std::forward<TParams>( args )... )}
-	{
-
-	}
-
-	virtual ~MessageData() noexcept = default;
-
-	MessageData( MessageData &&rhs ) noexcept
-		:
-		Message{std::move( rhs )},
-		m_pPayload{std::move( rhs.m_pPayload )}
-	{
-
-	}
+	bool hasPayload() const noexcept;
 
-	MessageData& operator=( MessageData &&rhs ) noexcept
+	template<typename T>
+	T* getPayload() noexcept
 	{
-		Message::operator=( std::move( rhs ) );
-		std::swap( m_pPayload, rhs.m_pPayload );
-		return *this;
+		if ( m_pPayloadTag != getPayloadTag<std::decay_t<T>>() )
+		{
+			return nullptr;
+		}
+		return static_cast<T*>( m_pPayload );
 	}
 
-	T* getPayload() const noexcept
+	template<typename T>
+	const T* getPayload() const noexcept
 	{
-		return m_pPayload.get();
+		if ( m_pPayloadTag != getPayloadTag<std::decay_t<T>>() )
+		{
+			return nullptr;
+		}
+		return static_cast<const T*>( m_pPayload );
 	}
 };
\ No newline at end of file
@@ -1,57 +1,275 @@
 #pragma once
 
-#include <vector>
-#include <mutex>
-#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "non_copyable.h"
+#include "lock_free_queue.h"
+#include "message.h"
 
 
-class Message;
+class Entity;
 class MessageDispatcher;
 
 ///=============================================================
 /// \class	MessageBus
 /// \author	KeyC0de
 /// \date	2019/12/09 4:51
-/// \brief	thread safe event queue built from a Vector
-/// \brief	enqueue or dequeue whenever, wherever, we'll be together
-/// \brief	it pa-owns its contents (Messages)
-/// \brief	move only
+/// \brief	bounded lock-free multi-producer/single-consumer event queue
+/// \brief	a ring buffer of Message cells, each carrying a sequence number (Vyukov style) which tells producers & the consumer whose turn it is
+/// \brief	producers claim a cell, construct the Message & its payload in place & publish it; any thread may post
+/// \brief	the single consumer (the MessageDispatcher's thread) visits published Messages in FIFO order
+/// \brief	filtered consumption leaves non matching Messages queued in order; the pending Messages are then shifted towards the tail over the handled ones,
+/// \brief		so the handled cells gather at the head & are recycled, & a Message nobody asks for cannot pin the ring
+/// \brief	payloads that do not fit inline in the Message use fixed size blocks from a pool, so steady state posting allocates nothing
 /// \brief	accessible only from the MessageDispatcher friend class
 ///=============================================================
 class MessageBus final
-	: public NonCopyable
+	: public NonCopyableAndNonMovable
 {
 	friend class MessageDispatcher;
-
-	// #TODO: Change vector of unique_ptr to Message to vector of objects of type Message
-	std::vector<std::unique_ptr<Message>> m_vec;
-	std::size_t m_size = 0;
-	mutable std::mutex m_mu;
-	std::condition_variable m_cond;
+public:
+	static constexpr std::size_t s_payloadBlockSize = 256u;
+	static constexpr std::size_t s_payloadBlockAlignment = 64u;
 private:
-	MessageBus() = default;
-	MessageBus( const int initialCapacity );
+	struct alignas( 64 ) Cell final
+	{
+		std::atomic<std::size_t> m_sequence;
+		Message m_msg;
+	};
+
+	std::size_t m_mask;
+	std::unique_ptr<Cell[]> m_cells;
+	std::size_t m_nPayloadBlocks;
+	std::unique_ptr<unsigned char[]> m_payloadBlocksMemory;
+	unsigned char *m_pPayloadBlocks;
+	BoundedMpmcQueue<std::uint32_t> m_freePayloadBlocks;
+	alignas( 64 ) std::atomic<std::size_t> m_enqueuePos{0};
+	alignas( 64 ) std::atomic<std::size_t> m_dequeuePos{0};
+	std::atomic<std::size_t> m_nHeapPayloads{0};	// payloads that got no pool block
 private:
-	void removeFrontByBackSwap();
-public:
-	MessageBus( MessageBus &&rhs ) noexcept;
-	MessageBus& operator=( MessageBus &&rhs ) noexcept;
-
-	/// \brief	push_back() : enqueue at the back
-	void enqueue( Message *msg );
-	/// \brief	pop_front() : dequeue messages from the front
-	std::unique_ptr<Message> dequeue();
-	const Message* peekFront() const noexcept;
-	const Message* peekBack() const noexcept;
-	explicit operator bool();
-	Message* operator[]( const std::size_t index );
-	const Message* operator[]( const std::size_t index ) const;
+	/// \brief	capacity is rounded up to a power of 2
+	explicit MessageBus( const std::size_t capacity );
+	~MessageBus() noexcept;
+
+	/// \brief	returns nullptr if the bus is full
+	Cell* claimCell( std::size_t &pos ) noexcept;
+	void publish( Cell &cell, const std::size_t pos ) noexcept;
+	void* acquirePayloadBlock() noexcept;
+	void releasePayloadBlock( void *pBlock ) noexcept;
+	void releasePayload( Message &msg ) noexcept;
+	/// \brief	moves src's contents & payload into dst, whose payload must already be released; src is left handled & empty
+	void relocate( Message &dst, Message &src ) noexcept;
+
+	template<typename T, typename ... TArgs>
+	static T* constructAt( void *p, TArgs&&... args )
+	{
+		if constexpr ( std::is_aggregate_v<T> )
+		{
+			return new( p ) T{std::forward<TArgs>( args )...};
+		}
+		else
+		{
+			return new( p ) T( std::forward<TArgs>( args )... );
+		}
+	}
+
+	template<typename T>
+	static void destroyInPlace( void *p ) noexcept
+	{
+		static_cast<T*>( p )->~T();
+	}
+
+	template<typename T>
+	static void relocateInPlace( void *pDst,
+		void *pSrc ) noexcept
+	{
+		new( pDst ) T( std::move( *static_cast<T*>( pSrc ) ) );
+		static_cast<T*>( pSrc )->~T();
+	}
+
+	template<typename T>
+	static void destroyOnHeap( void *p ) noexcept
+	{
+		delete static_cast<T*>( p );
+	}
+
+	template<typename T, typename ... TArgs>
+	void emplacePayload( Message &msg, TArgs&&... args )
+	{
+		constexpr bool bTrivial = std::is_trivially_destructible_v<T>;
+		constexpr bool bRelocatable = std::is_trivially_copyable_v<T> || std::is_nothrow_move_constructible_v<T>;
+		// inline payloads move along with their Message when the ring is compacted
+		if constexpr ( sizeof( T ) <= Message::s_inlinePayloadSize && alignof( T ) <= Message::s_inlinePayloadAlignment && bRelocatable )
+		{
+			msg.m_pPayload = constructAt<T>( msg.m_inlinePayload, std::forward<TArgs>( args )... );
+			msg.m_payloadStorage = Message::Inline;
+			msg.m_pfnDestroyPayload = bTrivial ? nullptr : &destroyInPlace<T>;
+			msg.m_pfnRelocatePayload = std::is_trivially_copyable_v<T> ? nullptr : &relocateInPlace<T>;
+		}
+		else
+		{
+			void *pBlock = nullptr;
+			if constexpr ( sizeof( T ) <= s_payloadBlockSize && alignof( T ) <= s_payloadBlockAlignment )
+			{
+				pBlock = acquirePayloadBlock();
+			}
+
+			if ( pBlock != nullptr )
+			{
+				try
+				{
+					msg.m_pPayload = constructAt<T>( pBlock, std::forward<TArgs>( args )... );
+				}
+				catch ( ... )
+				{
+					releasePayloadBlock( pBlock );
+					throw;
+				}
+				msg.m_payloadStorage = Message::Pooled;
+				msg.m_pfnDestroyPayload = bTrivial ? nullptr : &destroyInPlace<T>;
+			}
+			else
+			{
+				// too large for a pool block or the pool is exhausted
+				if constexpr ( std::is_aggregate_v<T> )
+				{
+					msg.m_pPayload = new T{std::forward<TArgs>( args )...};
+				}
+				else
+				{
+					msg.m_pPayload = new T( std::forward<TArgs>( args )... );
+				}
+				msg.m_payloadStorage = Message::Heap;
+				msg.m_pfnDestroyPayload = &destroyOnHeap<T>;
+				m_nHeapPayloads.fetch_add( 1u, std::memory_order_relaxed );
+			}
+		}
+		msg.m_pPayloadTag = Message::getPayloadTag<T>();
+	}
+
+	/// \brief	any thread; T = void posts a Message without a payload
+	/// \brief	returns false if the bus is full
+	template<typename T, typename ... TArgs>
+	bool post( const Message::Type type,
+		Entity *pSender,
+		Entity *pRecipient,
+		TArgs&&... args )
+	{
+		std::size_t pos;
+		Cell *pCell = claimCell( pos );
+		if ( pCell == nullptr )
+		{
+			return false;
+		}
+
+		Message &msg = pCell->m_msg;
+		msg.m_type = type;
+		msg.m_pSender = pSender;
+		msg.m_pRecipient = pRecipient;
+		msg.m_bHandled = false;
+		msg.m_pPayload = nullptr;
+		msg.m_pPayloadTag = nullptr;
+		msg.m_pfnDestroyPayload = nullptr;
+		msg.m_pfnRelocatePayload = nullptr;
+		msg.m_payloadStorage = Message::None;
+		if constexpr ( !std::is_void_v<T> )
+		{
+			try
+			{
+				emplacePayload<T>( msg, std::forward<TArgs>( args )... );
+			}
+			catch ( ... )
+			{
+				// the cell is already claimed, so it must still be published to not stall the consumer
+				msg.m_bHandled = true;
+				publish( *pCell, pos );
+				throw;
+			}
+		}
+		publish( *pCell, pos );
+		return true;
+	}
+
+	/// \brief	consumer only
+	/// \brief	calls f( msg ) in FIFO order for up to maxCount unhandled Messages that satisfy pred( msg ) & marks them handled
+	/// \brief	only Messages already published when the call begins are visited; Messages posted from within f wait for the next call
+	/// \brief	then the visited Messages that are still pending are shifted towards the tail, preserving their order, & the cells freed ahead of them are recycled
+	/// \brief	returns the number of dispatched Messages
+	template<typename TPred, typename TFunc>
+	std::size_t consume( const TPred &pred,
+		const TFunc &f,
+		const std::size_t maxCount )
+	{
+		const std::size_t end = m_enqueuePos.load( std::memory_order_acquire );
+		const std::size_t head = m_dequeuePos.load( std::memory_order_relaxed );
+		std::size_t nDispatched = 0;
+		std::size_t nHandled = 0;
+		std::size_t last = head;
+		for ( ; last != end && nDispatched < maxCount; ++last )
+		{
+			Cell &cell = m_cells[last & m_mask];
+			if ( cell.m_sequence.load( std::memory_order_acquire ) != last + 1 )
+			{
+				// claimed but not yet published
+				break;
+			}
+
+			Message &msg = cell.m_msg;
+			if ( !msg.m_bHandled && pred( msg ) )
+			{
+				f( msg );
+				msg.m_bHandled = true;
+				++nDispatched;
+			}
+
+			if ( msg.m_bHandled )
+			{
+				releasePayload( msg );
+				++nHandled;
+			}
+		}
+
+		if ( nHandled == 0 )
+		{
+			return nDispatched;
+		}
+
+		// [head, last) is published & owned by the consumer until its cells are recycled
+		std::size_t newHead = last;
+		for ( std::size_t pos = last; pos != head; )
+		{
+			--pos;
+			Message &msg = m_cells[pos & m_mask].m_msg;
+			if ( !msg.m_bHandled )
+			{
+				--newHead;
+				if ( newHead != pos )
+				{
+					relocate( m_cells[newHead & m_mask].m_msg, msg );
+				}
+			}
+		}
+		for ( std::size_t pos = head; pos != newHead; ++pos )
+		{
+			m_cells[pos & m_mask].m_sequence.store( pos + m_mask + 1, std::memory_order_release );
+		}
+		m_dequeuePos.store( newHead, std::memory_order_release );
+		return nDispatched;
+	}
+
+	/// \brief	consumer only; discards every published Message
+	void clear();
+	/// \brief	number of Messages in the ring, including handled ones published after the last consume
 	std::size_t getSize() const noexcept;
 	std::size_t getCapacity() const noexcept;
 	bool isEmpty() const noexcept;
-	void clear();
+	/// \brief	number of payloads allocated on the heap so far, because they're too large for a pool block or the pool was exhausted
+	std::size_t getHeapPayloadCount() const noexcept;
 };
 
 
@@ -61,27 +279,45 @@ public:
 /// \date	2019/12/09 17:15
 /// \brief	Meyer's singleton class
 /// \brief	owns & manages the MessageBus/Queue
+/// \brief	Messages can be posted from any thread, dispatching must be done from a single thread
+/// \brief	each Message has a single recipient; post once per recipient to reach several
 ///=============================================================
 class MessageDispatcher final
-	: public NonCopyable
+	: public NonCopyableAndNonMovable
 {
+	static constexpr std::size_t s_defaultCapacity = 16384u;
+
 	MessageBus m_mb;
 private:
-	MessageDispatcher( const int initialCapacity );
+	explicit MessageDispatcher( const std::size_t capacity );
 public:
 	~MessageDispatcher() noexcept = default;
-	MessageDispatcher( MessageDispatcher &&rhs ) noexcept;
-	MessageDispatcher& operator=( MessageDispatcher &&rhs ) noexcept;
-
-	static MessageDispatcher& getInstance( const int initialCapacity = 100 );
-	/// \brief	add new message to the MessageBus
-	void addMessage( Message *msg );
-	/// \brief	dispatch all pending messages
-	void dispatchAll();
-	// #TODO: dispatchByEventType
-	// #TODO: dispatchEventsTargetedTo( specific actor )
+
+	/// \brief	the capacity is only taken into account on the first call
+	static MessageDispatcher& getInstance( const std::size_t capacity = s_defaultCapacity );
+
+	/// \brief	add a new message with payload T( args... ) to the MessageBus
+	/// \brief	returns false if the MessageBus is full
+	template<typename T, typename ... TArgs>
+	bool post( const Message::Type type,
+		Entity *pSender,
+		Entity *pRecipient,
+		TArgs&&... args )
+	{
+		return m_mb.post<T>( type, pSender, pRecipient, std::forward<TArgs>( args )... );
+	}
+
+	/// \brief	add a new message without a payload to the MessageBus
+	bool post( const Message::Type type, Entity *pSender, Entity *pRecipient );
+	/// \brief	dispatch all pending messages, or up to maxCount of them
+	std::size_t dispatchAll( const std::size_t maxCount = ~std::size_t{0} );
+	/// \brief	dispatch pending messages of the given type; other messages stay queued in order
+	std::size_t dispatchByEventType( const Message::Type type, const std::size_t maxCount = ~std::size_t{0} );
+	/// \brief	dispatch pending messages addressed to pRecipient; other messages stay queued in order
+	std::size_t dispatchEventsTargetedTo( const Entity *pRecipient, const std::size_t maxCount = ~std::size_t{0} );
 	void clear();
 
 	std::size_t getSize() const noexcept;
 	std::size_t getCapacity() const noexcept;
+	std::size_t getHeapPayloadCount() const noexcept;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "color.h"
+#include "block_compression.h"
+
+
+class Bitmap;
+
+// CPU mip chain generation for BGRA8 Bitmaps, level by level with separable SIMD filters on float texels
+// every level is filtered from the previous level's float texels, not from its 8bit encoding
+// sRGB colors are linearized before filtering & re-encoded afterwards, normal maps are renormalized on every level
+// cutout textures keep the coverage of alpha >= alphaCutoff of level 0 on all levels by scaling each level's alpha (Castano, "Computing Alpha Mipmaps")
+// levels can be block compressed once filtered, BC1/BC3 (BC7 at Quality::High) for colors, BC5 for normal maps & BC4 for masks, if level 0's sizes are multiples of 4
+// the chains can be cooked next to their source image, named after a hash of the Settings & only used if their version, Settings & source content hash all match
+namespace mip_gen
+{
+
+// bump whenever the cooked layout or the generated texels change
+static constexpr std::uint32_t s_version = 2u;
+
+enum class Filter : std::uint32_t
+{
+	Box,		// exact 2x2 average for even sizes
+	Kaiser,		// Kaiser windowed sinc, radius 3 & alpha 4
+	Lanczos,	// Lanczos 3
+};
+
+struct Settings final
+{
+	Filter filter = Filter::Kaiser;
+	bool bSrgb = true;			// rgb is sRGB encoded, alpha is always linear
+	bool bNormalMap = false;	// rgb is a [-1,1] normal, like Bitmap::colorToVector's; bSrgb is ignored
+	bool bMask = false;			// a linear mask or height in red, the only channel kept if compressed; bSrgb is ignored
+	bool bWrap = true;			// tiling textures wrap around their edges, the rest clamp
+	float alphaCutoff = 0.0f;	// in (0,1) for alpha tested textures, 0 disables coverage preservation
+	bool bCompress = false;		// ignored unless level 0's sizes are multiples of 4
+	bc::Quality quality = bc::Quality::Normal;
+};
+
+struct Level final
+{
+	unsigned width;
+	unsigned height;
+	std::size_t offset;		// of the level's first byte in MipChain::data
+	std::size_t rowPitch;	// bytes per row of texels, or of blocks
+};
+
+struct MipChain final
+{
+	bc::Format format = bc::Format::BGRA8;
+	bool bAlpha = false;			// whether any texel of level 0 isn't opaque
+	std::vector<Level> levels;
+	std::vector<std::uint8_t> data;	// every level's rows tightly packed, level 0 first
+
+	const std::uint8_t* getLevel( const std::size_t i ) const noexcept;
+};
+
+/// \brief	levels of a full chain down to 1x1
+unsigned calcMipCount( const unsigned width, const unsigned height ) noexcept;
+std::vector<Level> calcLevels( const unsigned width, const unsigned height, const bc::Format format = bc::Format::BGRA8 );
+/// \brief	pTexels is level 0, width x height texels in rows pitch bytes apart
+MipChain generate( const ColorBGRA *pTexels, const unsigned width, const unsigned height, const std::size_t pitch, const Settings &settings = {} );
+/// \brief	generate & loadOrCook on Bitmaps are in mip_generator_bitmap.cpp
+MipChain generate( const Bitmap &bitmap, const Settings &settings = {} );
+/// \brief	path of the cooked mip chain of sourcePath generated with these Settings
+std::string calcCookedPath( const std::string &sourcePath, const Settings &settings );
+/// \brief	returns false if there's no cooked file at cookedPath, or it's corrupt or stale (other version, Settings or source hash)
+bool readCooked( const std::string &cookedPath, const std::uint64_t sourceHash, const Settings &settings, MipChain &chain ) noexcept;
+/// \brief	writes to a temporary file first & renames it over cookedPath so a crash never leaves a half written cooked file behind
+/// \return	false if the file couldn't be written, the chain is then simply generated again next time
+bool writeCooked( const std::string &cookedPath, const std::uint64_t sourceHash, const Settings &settings, const MipChain &chain ) noexcept;
+/// \brief	the pre-cook step: generates & cooks the chain of the image at path unless an up to date one is already cooked
+/// \brief	returns the chain either way
+MipChain loadOrCook( const std::string &path, const Settings &settings = {} );
+
+
+}//namespace mip_gen
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <filesystem>
 #include <string>
@@ -13,6 +14,7 @@
 class Graphics;
 class Mesh;
 class Node;
+class TransformHierarchy;
 class ModelWindow;
 struct aiMesh;
 struct aiMaterial;
@@ -23,12 +25,19 @@ namespace ren
 class Renderer;
 }
 
+namespace model_cache
+{
+class CookedModel;
+class CookedModelWriter;
+}
+
 class Model
 {
 	int m_nNodes = 0;
 	int m_nMeshNodes = 0;
 	std::string m_name;
 	std::unique_ptr<Node> m_pRoot;
+	std::unique_ptr<TransformHierarchy> m_pTransformHierarchy;	// flattened matrices of the m_pRoot tree
 	std::vector<std::unique_ptr<Mesh>> m_meshes;	// m_meshes[0] is the Mesh attached to m_pRoot Node
 #ifndef FINAL_RELEASE
 	ImguiPerModelNodeVisitor m_imguiVisitor;
@@ -84,5 +93,11 @@ public:
 	const Mesh* const getMesh( const int index = 0 ) const noexcept;
 	Mesh* const getMesh( const int index = 0 );
 private:
-	std::unique_ptr<Node> parseModelNodeGraph( Node *pParent, const aiNode &node, int imguiNodeId, const float initialScale ) cond_noex;
+	/// \brief	builds the Model from its cooked file, returns false if there's no up to date one
+	bool loadCooked( Graphics &gfx, const std::string &path, const std::string &cookedPath, const std::uint64_t sourceHash, const float initialScale );
+	/// \brief	imports the Model with Assimp & cooks it for the next load
+	void importModel( Graphics &gfx, const std::string &path, const std::string &cookedPath, const std::uint64_t sourceHash, const float initialScale );
+	std::unique_ptr<Node> parseModelNodeGraph( Node *pParent, const aiNode &node, int imguiNodeId, const float initialScale, model_cache::CookedModelWriter &writer ) cond_noex;
+	/// \brief	nodeIndex walks the cooked depth first node array
+	std::unique_ptr<Node> parseCookedNodeGraph( Node *pParent, const model_cache::CookedModel &cooked, unsigned &nodeIndex, int imguiNodeId, const float initialScale ) cond_noex;
 };
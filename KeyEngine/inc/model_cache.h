@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <DirectXMath.h>
+#include "winner.h"
+#include "non_copyable.h"
+#include "material_loader.h"
+#include "mesh_optimizer.h"
+
+
+// cooked models: an imported Model's node graph, material descriptions & final (optimized, scaled) vertex & index blobs in one flat binary file
+// that is memory mapped on load, so the buffers are uploaded straight from the mapping & Assimp is never touched
+// a cooked file sits next to its source, named after a hash of the import options; it's only used if its version, options, checksum & the content hashes
+//	of its source & of every other file the import read (material libraries, external buffers, textures) all match
+namespace model_cache
+{
+
+// bump whenever the layout or the import time processing (mesh_opt passes & LodSettings) changes
+static constexpr std::uint32_t s_version = 4u;
+
+/// \brief	a view of one mesh's upload ready data; the pointers are only valid as long as their owner (a CookedModel or the importer's buffers)
+struct MeshData final
+{
+	std::string_view name;
+	unsigned materialIndex;
+	std::string_view layoutSignature;	// VertexInputLayout::calcSignature of the vertices
+	const void *pVertices;
+	unsigned nVertices;
+	unsigned vertexStride;
+	const void *pIndices;
+	unsigned nIndices;
+	unsigned indexSize;					// 2 or 4 bytes
+	DirectX::XMFLOAT3 aabbMin;
+	DirectX::XMFLOAT3 aabbMax;
+	const mesh_opt::Lod *pLods;			// ranges of the indices, the first being the full detail mesh
+	unsigned nLods;
+};
+
+struct NodeData final
+{
+	std::string_view name;
+	DirectX::XMFLOAT4X4 transform;		// local, row major like Assimp's & not yet scaled
+	const std::uint32_t *pMeshes;
+	unsigned nMeshes;
+	unsigned nChildren;					// nodes are stored depth first, a Node's children follow it
+};
+
+/// \brief	64 bit hash of the whole file, throws a UtilException if it can't be read
+std::uint64_t hashFile( const std::string &filename );
+/// \brief	64 bit hash of the files' contents in order; a file that can't be read hashes differently to any that can
+std::uint64_t hashFiles( const std::vector<std::string> &filenames ) noexcept;
+/// \brief	path of the cooked version of sourcePath imported with these options
+std::string calcCookedPath( const std::string &sourcePath, const unsigned importerFlags, const float scale );
+
+///=============================================================
+/// \class	CookedModel
+/// \author	KeyC0de
+/// \date	2026/10/18 13:30
+/// \brief	read only view of a memory mapped cooked model file, every getter returns views into the mapping
+///=============================================================
+class CookedModel final
+	: public NonCopyable
+{
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	HANDLE m_hMapping = nullptr;
+	const std::uint8_t *m_pData = nullptr;
+	std::size_t m_nBytes = 0;
+	unsigned m_nMaterials = 0;
+	unsigned m_nMeshes = 0;
+	unsigned m_nNodes = 0;
+public:
+	/// \brief	returns nullptr if there's no cooked file at cookedPath, or it's corrupt (checksum mismatch) or stale (other version, options, source hash or dependency contents)
+	static std::unique_ptr<CookedModel> open( const std::string &cookedPath, const std::uint64_t sourceHash, const unsigned importerFlags, const float scale ) noexcept;
+
+	CookedModel() = default;
+	~CookedModel() noexcept;
+
+	unsigned getMaterialCount() const noexcept;
+	unsigned getMeshCount() const noexcept;
+	unsigned getNodeCount() const noexcept;
+	MaterialLoader::Desc getMaterial( const unsigned i ) const;
+	MeshData getMesh( const unsigned i ) const noexcept;
+	NodeData getNode( const unsigned i ) const noexcept;
+private:
+	bool map( const std::string &cookedPath ) noexcept;
+	/// \brief	checks the header, the checksum & that every record, string & blob lies inside the file
+	bool validate( const std::uint64_t sourceHash, const unsigned importerFlags, const float scale ) const noexcept;
+	void close() noexcept;
+};
+
+///=============================================================
+/// \class	CookedModelWriter
+/// \author	KeyC0de
+/// \date	2026/10/18 13:30
+/// \brief	gathers a Model while it's imported & writes it as a cooked file
+/// \brief	nodes must be added depth first; meshes are copied so the sources can go away right after
+///=============================================================
+class CookedModelWriter final
+{
+	struct PendingMesh final
+	{
+		std::string name;
+		std::string layoutSignature;
+		unsigned materialIndex;
+		unsigned nVertices;
+		unsigned vertexStride;
+		unsigned nIndices;
+		unsigned indexSize;
+		std::vector<std::uint8_t> vertices;
+		std::vector<std::uint8_t> indices;
+		DirectX::XMFLOAT3 aabbMin;
+		DirectX::XMFLOAT3 aabbMax;
+		std::vector<mesh_opt::Lod> lods;
+	};
+
+	struct PendingNode final
+	{
+		std::string name;
+		DirectX::XMFLOAT4X4 transform;
+		std::vector<std::uint32_t> meshes;
+		unsigned nChildren;
+	};
+
+	std::vector<MaterialLoader::Desc> m_materials;
+	std::vector<PendingMesh> m_meshes;
+	std::vector<PendingNode> m_nodes;
+	std::vector<std::string> m_dependencies;
+public:
+	void addMaterial( const MaterialLoader::Desc &desc );
+	void addMesh( const MeshData &mesh );
+	void addNode( const std::string_view name, const DirectX::XMFLOAT4X4 &transform, const unsigned *pMeshes, const unsigned nMeshes, const unsigned nChildren );
+	/// \brief	a file other than the source that the import read; the cooked file goes stale when its contents change
+	void addDependency( const std::string &path );
+	/// \brief	writes to a temporary file first & renames it over cookedPath so a crash never leaves a half written cooked file behind
+	/// \return	false if the file couldn't be written, the Model is then simply imported again next time
+	bool write( const std::string &cookedPath, const std::uint64_t sourceHash, const unsigned importerFlags, const float scale ) const noexcept;
+};
+
+
+}//namespace model_cache
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <DirectXMath.h>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <string>
@@ -11,13 +12,14 @@
 
 class Model;
 class Mesh;
+class TransformHierarchy;
 
 class Node
 {
 	friend class Model;
+	friend class TransformHierarchy;
 	//friend std::unique_ptr<Node> std::make_unique<Node>();
 
-	bool m_bTransformNeedsUpdate = true;
 	int m_imguiId;
 	std::string m_name;
 	DirectX::XMFLOAT3 m_scale;
@@ -26,15 +28,15 @@ class Node
 	DirectX::XMFLOAT3 m_scalePrev;
 	DirectX::XMFLOAT3 m_rotPrev;
 	DirectX::XMFLOAT3 m_posPrev;
-	DirectX::XMFLOAT4X4 m_localTransform;
-	DirectX::XMFLOAT4X4 m_worldTransform;
+	TransformHierarchy *m_pTransformHierarchy = nullptr;	// owned by the Model, holds the local & world matrices
+	std::uint32_t m_hierarchyIndex = 0;
 	Node* m_pParent;
 	std::vector<std::unique_ptr<Node>> m_children;
 	std::vector<Mesh*> m_meshes;
 private:
-	void update( const float dt, const DirectX::XMMATRIX &parentWorldTransform, const float lerpBetweenFrames, const bool bEnableSmoothMovement = false ) cond_noex;
 	void addChild( std::unique_ptr<Node> pChild ) cond_noex;
-	void invalidateChildrenTransform() noexcept;
+	/// \brief	flags the Node for the next TransformHierarchy::update, which also refreshes all its descendants
+	void invalidateTransform() noexcept;
 	void setWorldTransform( const DirectX::XMMATRIX &worldTransform ) cond_noex;
 public:
 	Node( Node *pParent, const int imguiId, const std::string &name, const DirectX::XMMATRIX &localTransform, std::vector<Mesh*> meshes );
@@ -57,6 +59,7 @@ public:
 	void rotateRel( const DirectX::XMFLOAT3 &rotAnglesRadians ) cond_noex;
 	void setTranslation( const DirectX::XMFLOAT3 &pos ) cond_noex;
 	void translateRel( const DirectX::XMFLOAT3 &pos ) cond_noex;
+	/// \brief	recomputes the local matrix from scale, rotation & translation into the TransformHierarchy
 	void updateLocalTransform( const float dt, const float lerpBetweenFrames, const bool bEnableSmoothMovement = false ) cond_noex;
 	DirectX::XMMATRIX getWorldTransform() const noexcept;
 	DirectX::XMFLOAT4X4 getWorldTransform4x4() const noexcept;
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
 #include "non_copyable.h"
 
 
@@ -8,104 +14,194 @@
 /// \class	ObjectPool
 /// \author	Nikos Lazaridis (KeyC0de)
 /// \date	3-Oct-19
-/// \brief	Pool Allocator
+/// \brief	Pool Allocator for objects of type T
+/// \brief	storage is carved out of chunks; when every chunk is in use a new chunk, twice the size of the last one, is added
+/// \brief	each thread keeps its own free list per pool & exchanges objects with the pool's global free list in batches
+/// \brief		so allocate/deallocate only take the pool's lock once every s_batchSize calls
+/// \brief	objects may be deallocated on any thread
+/// \brief	the chunks are released once the pool & every thread that used it are gone
 ///=============================================================
 template<typename T>
 class ObjectPool final
 	: public NonCopyable
 {
+	static constexpr std::size_t s_batchSize = 32u;
+	static constexpr std::size_t s_maxChunkSize = 65536u;	// objects
+
 	union Object
 	{
 		std::aligned_storage_t<sizeof( T ), alignof( T )> m_storage;
 		Object *m_pNext;
 	};
 
-	std::unique_ptr<Object[]> m_pool;
-	Object *m_pNextFree;
-	std::size_t m_nObjs;
-public:
-	using value_type = T;
-	using pointer = T*;
+	struct Core final
+	{
+		std::mutex m_mu;
+		std::vector<std::unique_ptr<Object[]>> m_chunks;
+		Object *m_pNextFree = nullptr;
+		std::size_t m_nextChunkSize;
+		std::size_t m_capacity = 0;
+		std::ptrdiff_t m_nLive = 0;
+		std::size_t m_highWaterMark = 0;
 
-	/// \brief	ctor creates the pool given the amount of objects it will hold
-	explicit ObjectPool( const std::size_t nObjs )
-		:
-		m_pool{std::make_unique<Object[]>( nObjs )},
-		m_pNextFree{nullptr},
-		m_nObjs(nObjs)
+		Core( const std::size_t initialChunkSize )
+			:
+			m_nextChunkSize{std::max<std::size_t>( initialChunkSize, 1u )}
+		{
+
+		}
+
+		/// \brief	call with the lock held
+		void applyLiveDelta( const std::ptrdiff_t delta ) noexcept
+		{
+			m_nLive += delta;
+			if ( m_nLive > static_cast<std::ptrdiff_t>( m_highWaterMark ) )
+			{
+				m_highWaterMark = static_cast<std::size_t>( m_nLive );
+			}
+		}
+	};
+
+	struct ThreadCache final
 	{
-		for ( int i = 1; i < nObjs; ++i )
+		std::shared_ptr<Core> m_pCore;
+		Object *m_pNextFree = nullptr;
+		std::size_t m_nFree = 0;
+		std::ptrdiff_t m_nLiveDelta = 0;	// allocations - deallocations not yet reported to the Core
+
+		ThreadCache( std::shared_ptr<Core> pCore ) noexcept
+			:
+			m_pCore{std::move( pCore )}
 		{
-			m_pool[i - 1].m_pNext = &m_pool[i];
+
 		}
 
-		m_pNextFree = &m_pool[0];
-	}
+		ThreadCache( ThreadCache &&rhs ) noexcept
+			:
+			m_pCore{std::move( rhs.m_pCore )},
+			m_pNextFree{rhs.m_pNextFree},
+			m_nFree{rhs.m_nFree},
+			m_nLiveDelta{rhs.m_nLiveDelta}
+		{
+			rhs.m_pNextFree = nullptr;
+			rhs.m_nFree = 0;
+			rhs.m_nLiveDelta = 0;
+		}
 
-	~ObjectPool() noexcept = default;
+		ThreadCache& operator=( ThreadCache &&rhs ) noexcept
+		{
+			std::swap( m_pCore, rhs.m_pCore );
+			std::swap( m_pNextFree, rhs.m_pNextFree );
+			std::swap( m_nFree, rhs.m_nFree );
+			std::swap( m_nLiveDelta, rhs.m_nLiveDelta );
+			return *this;
+		}
 
-	ObjectPool( ObjectPool &&rhs ) noexcept
-		:
-		m_pool{std::move( rhs.m_pool )},
-		m_pNextFree{rhs.m_pNextFree},
-		m_nObjs{rhs.getSize()}
-	{
-		rhs.m_pNextFree = nullptr;
-	}
+		/// \brief	hands every cached object back to the Core on thread exit
+		~ThreadCache() noexcept
+		{
+			if ( m_pCore )
+			{
+				std::lock_guard<std::mutex> lg{m_pCore->m_mu};
+				giveBack( m_nFree );
+			}
+		}
 
-	ObjectPool& operator=( ObjectPool &&rhs ) noexcept
-	{
-		ObjectPool tmp{std::move( rhs )};
-		std::swap( *this, tmp );
-		return *this;
-	}
+		/// \brief	call with the Core's lock held
+		void giveBack( std::size_t nObjs ) noexcept
+		{
+			m_pCore->applyLiveDelta( m_nLiveDelta );
+			m_nLiveDelta = 0;
+			while ( nObjs-- > 0 && m_pNextFree != nullptr )
+			{
+				Object *pObj = m_pNextFree;
+				m_pNextFree = pObj->m_pNext;
+				pObj->m_pNext = m_pCore->m_pNextFree;
+				m_pCore->m_pNextFree = pObj;
+				--m_nFree;
+			}
+		}
+	};
 
-	template <typename U>
-	struct rebind
+	static inline thread_local std::vector<ThreadCache> s_threadCaches;
+
+	std::shared_ptr<Core> m_pCore;
+public:
+	struct Stats final
 	{
-		using otherAllocator = ObjectPool<U>;
+		std::size_t m_capacity;			// objects across all chunks
+		std::size_t m_nLive;			// allocated & not yet deallocated, exact to within 2 * s_batchSize per thread
+		std::size_t m_highWaterMark;	// most live objects observed, at the same precision as m_nLive
+		std::size_t m_nChunks;
 	};
-
-	T* address( T &r ) const noexcept
+public:
+	/// \brief	the shared pool used by PoolAllocator<T>
+	/// \brief	never destroyed so that containers with static storage duration can still deallocate on exit
+	static ObjectPool& getShared()
 	{
-		return &r;
+		static ObjectPool *const pPool = new ObjectPool{1024u};
+		return *pPool;
 	}
-
-	const T* address( const T &r ) const noexcept
+public:
+	/// \brief	ctor creates the pool given the amount of objects its first chunk will hold
+	explicit ObjectPool( const std::size_t initialChunkSize )
+		:
+		m_pCore{std::make_shared<Core>( initialChunkSize )}
 	{
-		return &r;
+
 	}
 
-	// add object to the list
+	~ObjectPool() noexcept = default;
+	ObjectPool( ObjectPool &&rhs ) noexcept = default;
+	ObjectPool& operator=( ObjectPool &&rhs ) noexcept = default;
+
 	[[nodiscard]]
 	T* allocate()
 	{
-		if ( m_pNextFree == nullptr )
+		ThreadCache &cache = getThreadCache();
+		if ( cache.m_pNextFree == nullptr )
 		{
-			throw std::bad_alloc{};
+			refill( cache );
 		}
 
-		const auto currentObj = m_pNextFree;
-		m_pNextFree = currentObj->m_pNext;
-
-		return reinterpret_cast<T*>( &currentObj->m_storage );
+		Object *pObj = cache.m_pNextFree;
+		cache.m_pNextFree = pObj->m_pNext;
+		--cache.m_nFree;
+		++cache.m_nLiveDelta;
+		return reinterpret_cast<T*>( &pObj->m_storage );
 	}
 
-	// remove object from the list
-	void deallocate( T *p,
-		[[maybe_unused]] std::size_t count = 0 ) noexcept
+	void deallocate( T *p ) noexcept
 	{
-		const auto o = reinterpret_cast<Object*>( p );
-		o->m_pNext = m_pNextFree;
-		m_pNextFree = o;
+		ThreadCache &cache = getThreadCache();
+		Object *pObj = reinterpret_cast<Object*>( p );
+		pObj->m_pNext = cache.m_pNextFree;
+		cache.m_pNextFree = pObj;
+		++cache.m_nFree;
+		--cache.m_nLiveDelta;
+		// keep a batch around so alternating allocate/deallocate doesn't hit the lock
+		if ( cache.m_nFree >= 2 * s_batchSize )
+		{
+			std::lock_guard<std::mutex> lg{m_pCore->m_mu};
+			cache.giveBack( s_batchSize );
+		}
 	}
 
-	// pass ctor args
+	/// \brief	constructs T in pool storage from perfectly forwarded ctor args
 	template<typename... TArgs>
 	[[nodiscard]]
-	T* construct( TArgs... args )
+	T* construct( TArgs&&... args )
 	{
-		return new ( allocate() ) T{std::forward<TArgs>( args )...};
+		T *p = allocate();
+		try
+		{
+			return new( p ) T{std::forward<TArgs>( args )...};
+		}
+		catch ( ... )
+		{
+			deallocate( p );
+			throw;
+		}
 	}
 
 	void destroy( T *p ) noexcept
@@ -119,22 +215,134 @@ public:
 		deallocate( p );
 	}
 
-	std::size_t getSize() noexcept
+	Stats getStats() const
 	{
-		return m_nObjs;
+		std::lock_guard<std::mutex> lg{m_pCore->m_mu};
+		return {m_pCore->m_capacity, static_cast<std::size_t>( std::max<std::ptrdiff_t>( m_pCore->m_nLive, 0 ) ), m_pCore->m_highWaterMark, m_pCore->m_chunks.size()};
+	}
+
+	std::size_t getSize() const noexcept
+	{
+		return getStats().m_capacity;
+	}
+private:
+	ThreadCache& getThreadCache()
+	{
+		const Core *pCore = m_pCore.get();
+		for ( ThreadCache &cache : s_threadCaches )
+		{
+			if ( cache.m_pCore.get() == pCore )
+			{
+				return cache;
+			}
+		}
+
+		// drop the caches of pools that have been destroyed since this thread last looked
+		s_threadCaches.erase( std::remove_if( s_threadCaches.begin(), s_threadCaches.end(),
+			[] ( const ThreadCache &cache )
+			{
+				return cache.m_pCore.use_count() == 1;
+			} ), s_threadCaches.end() );
+		return s_threadCaches.emplace_back( m_pCore );
+	}
+
+	void refill( ThreadCache &cache )
+	{
+		Core &core = *m_pCore;
+		std::lock_guard<std::mutex> lg{core.m_mu};
+		core.applyLiveDelta( cache.m_nLiveDelta + 1 );	// + the allocation that is about to happen
+		cache.m_nLiveDelta = -1;
+		if ( core.m_pNextFree == nullptr )
+		{
+			grow( core );
+		}
+
+		for ( std::size_t i = 0; i < s_batchSize && core.m_pNextFree != nullptr; ++i )
+		{
+			Object *pObj = core.m_pNextFree;
+			core.m_pNextFree = pObj->m_pNext;
+			pObj->m_pNext = cache.m_pNextFree;
+			cache.m_pNextFree = pObj;
+			++cache.m_nFree;
+		}
+	}
+
+	/// \brief	call with the lock held
+	static void grow( Core &core )
+	{
+		const std::size_t nObjs = core.m_nextChunkSize;
+		auto pChunk = std::make_unique<Object[]>( nObjs );
+		for ( std::size_t i = 1; i < nObjs; ++i )
+		{
+			pChunk[i - 1].m_pNext = &pChunk[i];
+		}
+		pChunk[nObjs - 1].m_pNext = core.m_pNextFree;
+		core.m_pNextFree = &pChunk[0];
+
+		core.m_chunks.emplace_back( std::move( pChunk ) );
+		core.m_capacity += nObjs;
+		core.m_nextChunkSize = std::min( nObjs * 2, s_maxChunkSize );
+	}
+};
+
+
+///=============================================================
+/// \class	PoolAllocator
+/// \author	KeyC0de
+/// \date	2026/10/17 21:50
+/// \brief	stateless std Allocator that takes single objects from ObjectPool<T>::getShared()
+/// \brief	node based containers (std::list, std::map, ..) get every node from the pool
+/// \brief	array allocations (eg. std::vector's) are forwarded to std::allocator
+/// \brief	not final: standard library containers derive from their allocator (EBO)
+///=============================================================
+template<typename T>
+class PoolAllocator
+{
+public:
+	using value_type = T;
+	using is_always_equal = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+
+	PoolAllocator() noexcept = default;
+
+	template<typename U>
+	PoolAllocator( const PoolAllocator<U> & ) noexcept
+	{
+
+	}
+
+	[[nodiscard]]
+	T* allocate( const std::size_t n )
+	{
+		if ( n == 1 )
+		{
+			return ObjectPool<T>::getShared().allocate();
+		}
+		return std::allocator<T>{}.allocate( n );
+	}
+
+	void deallocate( T *p,
+		const std::size_t n ) noexcept
+	{
+		if ( n == 1 )
+		{
+			ObjectPool<T>::getShared().deallocate( p );
+			return;
+		}
+		std::allocator<T>{}.deallocate( p, n );
 	}
 };
 
-template <class T, class Other>
-bool operator==( const ObjectPool<T>& lhs,
-	const ObjectPool<Other>& rhs ) noexcept
+template<class T, class U>
+bool operator==( const PoolAllocator<T> &,
+	const PoolAllocator<U> & ) noexcept
 {
-	return lhs.m_pool == rhs.m_pool;
+	return true;
 }
 
-template <class T, class Other>
-bool operator!=( const ObjectPool<T>& lhs,
-	const ObjectPool<Other>& rhs ) noexcept
+template<class T, class U>
+bool operator!=( const PoolAllocator<T> &,
+	const PoolAllocator<U> & ) noexcept
 {
-	return lhs.m_pool != rhs.m_pool;
+	return false;
 }
\ No newline at end of file
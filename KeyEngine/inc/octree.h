@@ -1,41 +1,112 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
+#include <utility>
 #include <DirectXMath.h>
 
 
-using OctreeData = DirectX::XMFLOAT3;
-
 ///=============================================================
 /// \class	Octree
-/// \link	https://github.com/brandonpelfrey/SimpleOctree
-/// \author	brandonpelfrey
-/// \brief	Octree
-/// \brief	The tree has up to 8 children and can additionally store data (m_data),
-/// \brief		Children follow a predictable pattern to make accesses simple.
-/// \brief		- means less than 'm_center' in that dimension, + means greater than.
+/// \author	KeyC0de
+/// \date	17/10/2026 14:02
+/// \brief	linear (pointer-free) point Octree
+/// \brief	Nodes live in one contiguous array, the 8 children of an interior node are stored back to back & referenced by index
+/// \brief	Children follow a predictable pattern to make accesses simple.
+/// \brief		- means less than the node center in that dimension, + means greater than.
 /// \brief	child:	0 1 2 3 4 5 6 7
 /// \brief	x:      - - - - + + + +
 /// \brief	y:      - - + + - - + +
 /// \brief	z:      - + - + - + - +
+/// \brief	every item is assigned a 30 bit Morton code (10 bits per axis) inside the root bounds, the child index at every depth is just 3 bits of it
+/// \brief	leaves hold up to `leafCapacity` items in a bucket; at `maxDepth` buckets are chained so duplicate points never split forever
+/// \brief	`build` sorts all points by Morton code & builds the tree top-down in O(n log n); nodes & buckets end up in Morton order
+/// \brief	items are referred to by the ItemId returned from `insert` (or their index in the array passed to `build`)
+/// \brief	items must lie inside the root bounds
 ///=============================================================
 class Octree final
 {
-	DirectX::XMFLOAT3 m_center;	// the physical spatial center of this octree octant
-	DirectX::XMFLOAT3 m_half;	// half the width,height,depth of this octant
-	Octree *m_children[8];
-	OctreeData *m_data;
+public:
+	using ItemId = std::uint32_t;
+	static constexpr std::uint32_t s_invalid = 0xFFFFFFFFu;
+	static constexpr unsigned s_mortonLevels = 10u;
 private:
-	/// \brief	determine which octant of the tree contains point
-	int getOctantContainingPoint( const DirectX::XMFLOAT3 &point ) const;
-	bool isLeafNode() const;
+	struct Node final
+	{
+		DirectX::XMFLOAT3 m_center;
+		std::uint32_t m_parent = s_invalid;
+		std::uint32_t m_firstChild = s_invalid;		// s_invalid for leaves
+		std::uint32_t m_firstBucket = s_invalid;	// leaves only
+		std::uint32_t m_count = 0;					// number of items in this subtree
+		std::uint32_t m_depth = 0;
+
+		bool isLeaf() const noexcept;
+	};
+
+	unsigned m_leafCapacity;
+	unsigned m_maxDepth;
+	DirectX::XMFLOAT3 m_min;
+	DirectX::XMFLOAT3 m_quantizationScale;
+	DirectX::XMFLOAT3 m_halfExtents[s_mortonLevels + 1];	// per depth
+	std::vector<Node> m_nodes;
+	std::vector<std::uint32_t> m_freeNodeBlocks;
+	std::vector<ItemId> m_bucketItems;			// m_leafCapacity ItemIds per bucket
+	std::vector<std::uint32_t> m_bucketNext;	// chaining of overflown max depth leaves
+	std::vector<std::uint32_t> m_freeBuckets;
+	std::vector<DirectX::XMFLOAT3> m_positions;	// per ItemId
+	std::vector<std::uint32_t> m_codes;
+	std::vector<std::uint32_t> m_itemLeaf;
+	std::vector<std::uint32_t> m_itemSlot;
+	std::vector<ItemId> m_freeItemIds;
+	std::vector<ItemId> m_scratch;
+	std::size_t m_nItems = 0;
 public:
-	Octree( const DirectX::XMFLOAT3 &center, const DirectX::XMFLOAT3 &halfDim );
-	Octree( const Octree &rhs );
-	~Octree();
+	/// \brief	leafCapacity is the bucket size of a leaf before it splits
+	/// \brief	maxDepth is clamped to s_mortonLevels
+	Octree( const DirectX::XMFLOAT3 &center, const DirectX::XMFLOAT3 &halfDim, const unsigned leafCapacity = 16u, const unsigned maxDepth = s_mortonLevels );
 
-	void insert( OctreeData *node );
-	/// \brief	recursively query the tree for Entities within a bounding box {bmin,bmax}
-	void getEntitiesWithinBBox( const DirectX::XMFLOAT3 &bmin, const DirectX::XMFLOAT3 &bmax, std::vector<OctreeData*>& resultsOut );
+	/// \brief	discards everything & bulk builds the tree from `points`; item i gets ItemId i
+	void build( const std::vector<DirectX::XMFLOAT3> &points );
+	void clear();
+	ItemId insert( const DirectX::XMFLOAT3 &position );
+	/// \brief	returns false if the id does not refer to a live item
+	bool remove( const ItemId id );
+	/// \brief	cheap if the item stays inside its current leaf, otherwise it is relocated keeping its ItemId
+	void move( const ItemId id, const DirectX::XMFLOAT3 &newPosition );
+
+	const DirectX::XMFLOAT3& getPosition( const ItemId id ) const noexcept;
+	std::size_t getItemCount() const noexcept;
+	std::size_t getNodeCount() const noexcept;
+
+	/// \brief	query the tree for items within a bounding box {bmin,bmax}
+	void getEntitiesWithinBBox( const DirectX::XMFLOAT3 &bmin, const DirectX::XMFLOAT3 &bmax, std::vector<ItemId> &resultsOut ) const;
+	void getEntitiesWithinSphere( const DirectX::XMFLOAT3 &center, const float radius, std::vector<ItemId> &resultsOut ) const;
+	/// \brief	items closer than `hitRadius` to the ray segment [origin, origin + dir * maxDistance]
+	/// \brief	results are {id, distance along the ray} sorted front to back; dir must be normalized
+	void raycast( const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &dir, const float maxDistance, const float hitRadius, std::vector<std::pair<ItemId, float>> &resultsOut ) const;
+	/// \brief	up to k items nearest to `point`, sorted nearest first
+	void getKNearest( const DirectX::XMFLOAT3 &point, const std::size_t k, std::vector<ItemId> &resultsOut ) const;
+private:
+	std::uint32_t calcMortonCode( const DirectX::XMFLOAT3 &p ) const noexcept;
+	static unsigned getChildIndex( const std::uint32_t code, const unsigned parentDepth ) noexcept;
+	static bool isSameCell( const std::uint32_t codeA, const std::uint32_t codeB, const unsigned depth ) noexcept;
+	void getNodeBounds( const Node &node, DirectX::XMFLOAT3 &bmin, DirectX::XMFLOAT3 &bmax ) const noexcept;
+	ItemId allocateItemId();
+	std::uint32_t allocateBucket();
+	std::uint32_t allocateChildren( const std::uint32_t parentIndex );
+	void buildNode( const std::uint32_t nodeIndex, const std::vector<std::pair<std::uint32_t, ItemId>> &sorted, const std::size_t begin, const std::size_t end );
+	ItemId& getLeafItem( const Node &leaf, const std::uint32_t slot );
+	ItemId getLeafItem( const Node &leaf, const std::uint32_t slot ) const;
+	/// \brief	appends to the leaf's bucket chain, does not touch ancestor counts
+	void appendToLeaf( const std::uint32_t leafIndex, const ItemId id );
+	/// \brief	moves the leaf's items to m_scratch & releases its buckets
+	void detachLeafItems( const std::uint32_t leafIndex );
+	void insertItem( const ItemId id );
+	void removeItem( const ItemId id );
+	void split( const std::uint32_t leafIndex );
+	/// \brief	turn the interior node back into a leaf if its items fit into a single bucket
+	void tryCollapse( std::uint32_t nodeIndex );
+	template<typename TFunc>
+	void forEachLeafItem( const Node &leaf, const TFunc &f ) const;
 };
\ No newline at end of file
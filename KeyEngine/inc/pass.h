@@ -33,6 +33,12 @@ public:
 	/// \brief	binds bindables & executes draw calls
 	virtual void run( Graphics &gfx ) const cond_noex = 0;
 	virtual void reset() cond_noex = 0;
+	/// \brief	rebinds the state this Pass leaves behind for the Passes that follow it on a context that didn't run this Pass
+	/// \brief	eg. a deferred context recording a later Pass or the immediate context after it executed a command list
+	virtual void bindSharedState( Graphics &gfx ) const cond_noex;
+	/// \brief	true if the Pass can be recorded on a deferred context by a worker thread
+	/// \brief	ie. run() only depends on the Pass's own CPU state & on the shared state of the Passes before it
+	virtual bool isRecordable() const noexcept;
 	const std::string& getName() const noexcept;
 	const std::vector<std::unique_ptr<IBinder>>& getBinders() const;
 	const std::vector<std::unique_ptr<ILinker>>& getLinkers() const;
@@ -1,18 +1,73 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <array>
 
 
+///=============================================================
+/// \class	PerlinNoise
+/// \author	KeyC0de
+/// \date	2026/10/17 22:40
+/// \brief	Ken Perlin's improved noise with single sample & batch evaluation
+/// \brief	float batches run 8 samples per AVX2 register if the CPU supports AVX2 or 4 per SSE2 register otherwise, double batches run one sample at a time
+/// \brief	every batch result is bit identical to the scalar `sample` of the same point; perlin_noise.cpp & perlin_noise_avx2.cpp
+/// \brief		are built with /fp:precise so that the compiler doesn't reassociate or contract floating point operations
+/// \brief	all values are in [0, 1]
+///=============================================================
 class PerlinNoise final
 {
-	std::vector<int> m_permutationVec;
- public:
-	 /// \brief	generate a new permutation vector based on the value of seed
+public:
+	enum class FractalType
+	{
+		None,		// a single octave
+		Fbm,		// fractional Brownian motion: sum of octaves
+		Ridged,		// sum of ( 1 - |octave| )^2, sharp crests
+		Turbulence,	// sum of |octave|, billowy
+	};
+
+	struct Fractal final
+	{
+		FractalType type = FractalType::None;
+		unsigned nOctaves = 1u;
+		double frequency = 1.0;
+		double lacunarity = 2.0;	// frequency multiplier per octave, must be an integer for tileable noise
+		double gain = 0.5;			// amplitude multiplier per octave
+		double warpStrength = 0.0;	// displaces x & y by this much times a noise lookup before sampling; 0 disables domain warping
+		unsigned tilePeriod = 0u;	// noise repeats every tilePeriod / frequency units in x & y; 0 or 256 (the lattice size) disables tiling
+	};
+
+	/// \brief	sample (i, j, k) of a grid is at ( x0 + i * dx, y0 + j * dy, z0 + k * dz ) & is stored at out[( k * height + j ) * width + i]
+	struct Grid final
+	{
+		unsigned width;
+		unsigned height;
+		unsigned depth = 1u;
+		double x0 = 0.0;
+		double y0 = 0.0;
+		double z0 = 0.0;
+		double dx = 1.0;
+		double dy = 1.0;
+		double dz = 1.0;
+	};
+private:
+	std::array<int, 512> m_permutation;	// the shuffled [0, 255] twice, so lattice hashes never need to wrap
+public:
+	/// \brief	generate a new permutation vector based on the value of seed, 0 seeds with the current time
 	PerlinNoise( unsigned int seed = 0 );
 
 	/// \brief	get a noise value, for 2D images z can have any value
-	double noise( double x, double y, double z );
+	double noise( double x, double y, double z ) const noexcept;
+	/// \brief	scalar reference of the batch functions
+	template<typename T>
+	T sample( const T x, const T y, const T z, const Fractal &fractal = {} ) const noexcept;
+	/// \brief	samples the n points ( xs[i], ys[i], zs[i] ) into out[i]
+	template<typename T>
+	void sample( const T *xs, const T *ys, const T *zs, T *out, const std::size_t n, const Fractal &fractal = {} ) const noexcept;
+	/// \brief	fills a 2D (depth 1) or 3D grid; bParallel splits the rows across the ThreadPoolJ
+	template<typename T>
+	void fillGrid( T *out, const Grid &grid, const Fractal &fractal = {}, const bool bParallel = false ) const;
 private:
-	double fade( const double t );
-	double grad( const int hash, const double x, const double y, const double z );
+	/// \brief	samples the grid rows [firstRow, lastRow) where row r is row r % height of slice r / height
+	template<typename T>
+	void fillGridRows( T *out, const Grid &grid, const Fractal &fractal, const std::size_t firstRow, const std::size_t lastRow ) const noexcept;
 };
\ No newline at end of file
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <immintrin.h>
+#include "perlin_noise.h"
+
+
+// PerlinNoise's sampling kernels, shared by perlin_noise.cpp & perlin_noise_avx2.cpp only
+
+namespace perlin_noise_avx2
+{
+
+/// \brief	sample & sampleRow of perlin_noise_avx2.cpp, which is compiled for AVX2; call them only if util::getCpuFeatures().bAvx2
+/// \brief	they sample the first n - n % 8 points & return how many that is
+std::size_t sample( const int *perm, const float *xs, const float *ys, const float *zs, float *out, const std::size_t n, const PerlinNoise::Fractal &fractal ) noexcept;
+std::size_t sampleRow( const int *perm, const float *xs, const float y, const float z, float *out, const std::size_t n, const PerlinNoise::Fractal &fractal ) noexcept;
+
+
+}//namespace perlin_noise_avx2
+
+//	internal linkage, so that each of the two translation units keeps its own copy compiled for its own instruction set
+//		(the linker would otherwise keep just one copy of every inline function, possibly an AVX2 one that the SSE2 path then calls)
+//		for the same reason nothing here calls std:: templates like std::min
+namespace
+{
+
+//	Lanes types wrap a SIMD register of T (or a single T) behind the same static interface, so that Kernel below
+//		performs the very same operations in the very same order for every lane width
+
+template<typename TScalar>
+struct ScalarLanes final
+{
+	using T = TScalar;
+	using V = TScalar;
+	static constexpr std::size_t s_nLanes = 1u;
+
+	static V load( const T *p ) noexcept { return *p; }
+	static void store( T *p, const V a ) noexcept { *p = a; }
+	static V set1( const T t ) noexcept { return t; }
+	static V add( const V a, const V b ) noexcept { return a + b; }
+	static V sub( const V a, const V b ) noexcept { return a - b; }
+	static V mul( const V a, const V b ) noexcept { return a * b; }
+	static V abs( const V a ) noexcept { return std::abs( a ); }
+	static V floor( const V a ) noexcept { return std::floor( a ); }
+	static void toInt( const V a, int *p ) noexcept { *p = static_cast<int>( a ); }
+
+	/// \brief	dot product of the gradient selected by the lower 4 bits of hash with {x, y, z}
+	static V grad( const int *hash, const V x, const V y, const V z ) noexcept
+	{
+		const int h = *hash;
+		const V u = h < 8 ?
+			x :
+			y;
+		const V v = h < 4 ?
+			y :
+			h == 12 || h == 14 ? x : z;
+		return ( ( h & 1 ) == 0 ? u : -u ) + ( ( h & 2 ) == 0 ? v : -v );
+	}
+};
+
+struct Sse2Float final
+{
+	using T = float;
+	using V = __m128;
+	static constexpr std::size_t s_nLanes = 4u;
+
+	static V load( const T *p ) noexcept { return _mm_loadu_ps( p ); }
+	static void store( T *p, const V a ) noexcept { _mm_storeu_ps( p, a ); }
+	static V set1( const T t ) noexcept { return _mm_set1_ps( t ); }
+	static V add( const V a, const V b ) noexcept { return _mm_add_ps( a, b ); }
+	static V sub( const V a, const V b ) noexcept { return _mm_sub_ps( a, b ); }
+	static V mul( const V a, const V b ) noexcept { return _mm_mul_ps( a, b ); }
+	static V abs( const V a ) noexcept { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ); }
+
+	/// \brief	exact for |a| < 2^31, which is all Perlin lattice coordinates can be anyway
+	static V floor( const V a ) noexcept
+	{
+		const V t = _mm_cvtepi32_ps( _mm_cvttps_epi32( a ) );
+		return _mm_sub_ps( t, _mm_and_ps( _mm_cmpgt_ps( t, a ), _mm_set1_ps( 1.0f ) ) );
+	}
+
+	static void toInt( const V a, int *p ) noexcept { _mm_storeu_si128( reinterpret_cast<__m128i*>( p ), _mm_cvttps_epi32( a ) ); }
+
+	static V grad( const int *hash, const V x, const V y, const V z ) noexcept
+	{
+		const __m128i h = _mm_loadu_si128( reinterpret_cast<const __m128i*>( hash ) );
+		const V bUx = _mm_castsi128_ps( _mm_cmplt_epi32( h, _mm_set1_epi32( 8 ) ) );
+		const V bVy = _mm_castsi128_ps( _mm_cmplt_epi32( h, _mm_set1_epi32( 4 ) ) );
+		const V bVx = _mm_castsi128_ps( _mm_or_si128( _mm_cmpeq_epi32( h, _mm_set1_epi32( 12 ) ), _mm_cmpeq_epi32( h, _mm_set1_epi32( 14 ) ) ) );
+		const V u = select( bUx, x, y );
+		const V v = select( bVy, y, select( bVx, x, z ) );
+		// move hash bits 0 & 1 to the sign bit
+		const V uSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 1 ) ), 31 ) );
+		const V vSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 2 ) ), 30 ) );
+		return _mm_add_ps( _mm_xor_ps( u, uSign ), _mm_xor_ps( v, vSign ) );
+	}
+
+	static V select( const V mask, const V a, const V b ) noexcept { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+};
+
+//	PerlinNoise::Fractal converted to the sample precision once per call
+template<typename T>
+struct Params final
+{
+	PerlinNoise::FractalType type;
+	unsigned nOctaves;
+	T frequency;
+	T lacunarity;
+	T gain;
+	T warpStrength;
+	int tilePeriod;
+	T normalization = 1;	// 1 / sum of the octave amplitudes
+
+	Params( const PerlinNoise::Fractal &fractal ) noexcept
+		:
+		type{fractal.type},
+		nOctaves{fractal.type == PerlinNoise::FractalType::None || fractal.nOctaves == 0u ? 1u : fractal.nOctaves},
+		frequency{static_cast<T>( fractal.frequency )},
+		lacunarity{static_cast<T>( fractal.lacunarity )},
+		gain{static_cast<T>( fractal.gain )},
+		warpStrength{static_cast<T>( fractal.warpStrength )},
+		tilePeriod{fractal.tilePeriod == 0u || fractal.tilePeriod > 256u ? 256 : static_cast<int>( fractal.tilePeriod )}
+	{
+		if ( type == PerlinNoise::FractalType::None )
+		{
+			return;
+		}
+
+		T amplitude = 1;
+		T amplitudeSum = 0;
+		for ( unsigned i = 0; i < nOctaves; ++i )
+		{
+			amplitudeSum += amplitude;
+			amplitude *= gain;
+		}
+		normalization = 1 / amplitudeSum;
+	}
+};
+
+template<class L>
+struct Kernel final
+{
+	using T = typename L::T;
+	using V = typename L::V;
+	static constexpr std::size_t s_nLanes = L::s_nLanes;
+
+	static int wrap( const int i,
+		const int period ) noexcept
+	{
+		if ( period == 256 )
+		{
+			return i & 255;
+		}
+		const int m = i % period;
+		return m < 0 ?
+			m + period :
+			m;
+	}
+
+	static V fade( const V t ) noexcept
+	{
+		// t * t * t * ( t * ( t * 6 - 15 ) + 10 )
+		return L::mul( L::mul( L::mul( t, t ), t ), L::add( L::mul( t, L::sub( L::mul( t, L::set1( 6 ) ), L::set1( 15 ) ) ), L::set1( 10 ) ) );
+	}
+
+	static V lerp( const V a,
+		const V b,
+		const V t ) noexcept
+	{
+		return L::add( a, L::mul( t, L::sub( b, a ) ) );
+	}
+
+	/// \brief	Perlin noise in [-1, 1]; the lattice wraps every `period` cells in x & y & every 256 cells in z
+	static V signedNoise( const int *perm,
+		V x,
+		V y,
+		V z,
+		const int period ) noexcept
+	{
+		// find the unit cube that contains the point & the relative x, y, z of the point in it
+		const V fx = L::floor( x );
+		const V fy = L::floor( y );
+		const V fz = L::floor( z );
+		alignas( 32 ) int cubeX[s_nLanes];
+		alignas( 32 ) int cubeY[s_nLanes];
+		alignas( 32 ) int cubeZ[s_nLanes];
+		L::toInt( fx, cubeX );
+		L::toInt( fy, cubeY );
+		L::toInt( fz, cubeZ );
+		x = L::sub( x, fx );
+		y = L::sub( y, fy );
+		z = L::sub( z, fz );
+
+		// hash the coordinates of the 8 cube corners, index is 0bZYX
+		alignas( 32 ) int hashes[8][s_nLanes];
+		for ( std::size_t i = 0; i < s_nLanes; ++i )
+		{
+			const int x0 = wrap( cubeX[i], period );
+			const int x1 = wrap( cubeX[i] + 1, period );
+			const int y0 = wrap( cubeY[i], period );
+			const int y1 = wrap( cubeY[i] + 1, period );
+			const int z0 = cubeZ[i] & 255;
+			const int z1 = ( cubeZ[i] + 1 ) & 255;
+			const int a0 = perm[x0];
+			const int a1 = perm[x1];
+			const int b00 = perm[a0 + y0];
+			const int b10 = perm[a1 + y0];
+			const int b01 = perm[a0 + y1];
+			const int b11 = perm[a1 + y1];
+			hashes[0][i] = perm[b00 + z0] & 15;
+			hashes[1][i] = perm[b10 + z0] & 15;
+			hashes[2][i] = perm[b01 + z0] & 15;
+			hashes[3][i] = perm[b11 + z0] & 15;
+			hashes[4][i] = perm[b00 + z1] & 15;
+			hashes[5][i] = perm[b10 + z1] & 15;
+			hashes[6][i] = perm[b01 + z1] & 15;
+			hashes[7][i] = perm[b11 + z1] & 15;
+		}
+
+		const V u = fade( x );
+		const V v = fade( y );
+		const V w = fade( z );
+		const V one = L::set1( 1 );
+		const V xm1 = L::sub( x, one );
+		const V ym1 = L::sub( y, one );
+		const V zm1 = L::sub( z, one );
+
+		// blend the results from the 8 corners of the cube
+		return lerp(
+			lerp(
+				lerp( L::grad( hashes[0], x, y, z ), L::grad( hashes[1], xm1, y, z ), u ),
+				lerp( L::grad( hashes[2], x, ym1, z ), L::grad( hashes[3], xm1, ym1, z ), u ),
+				v ),
+			lerp(
+				lerp( L::grad( hashes[4], x, y, zm1 ), L::grad( hashes[5], xm1, y, zm1 ), u ),
+				lerp( L::grad( hashes[6], x, ym1, zm1 ), L::grad( hashes[7], xm1, ym1, zm1 ), u ),
+				v ),
+			w );
+	}
+
+	static V sample( const int *perm,
+		V x,
+		V y,
+		const V z,
+		const Params<T> &params ) noexcept
+	{
+		if ( params.warpStrength != 0 )
+		{
+			const V frequency = L::set1( params.frequency );
+			const V fx = L::mul( x, frequency );
+			const V fy = L::mul( y, frequency );
+			const V fz = L::mul( z, frequency );
+			// arbitrary offsets decorrelate the two displacements
+			const V warpX = signedNoise( perm, L::add( fx, L::set1( static_cast<T>( 5.2 ) ) ), L::add( fy, L::set1( static_cast<T>( 1.3 ) ) ), fz, params.tilePeriod );
+			const V warpY = signedNoise( perm, L::add( fx, L::set1( static_cast<T>( 1.7 ) ) ), L::add( fy, L::set1( static_cast<T>( 9.2 ) ) ), fz, params.tilePeriod );
+			const V strength = L::set1( params.warpStrength );
+			x = L::add( x, L::mul( strength, warpX ) );
+			y = L::add( y, L::mul( strength, warpY ) );
+		}
+
+		if ( params.type == PerlinNoise::FractalType::None )
+		{
+			const V frequency = L::set1( params.frequency );
+			const V n = signedNoise( perm, L::mul( x, frequency ), L::mul( y, frequency ), L::mul( z, frequency ), params.tilePeriod );
+			return L::mul( L::add( n, L::set1( 1 ) ), L::set1( static_cast<T>( 0.5 ) ) );
+		}
+
+		V sum = L::set1( 0 );
+		T amplitude = 1;
+		T frequency = params.frequency;
+		int period = params.tilePeriod;
+		for ( unsigned i = 0; i < params.nOctaves; ++i )
+		{
+			const V octaveFrequency = L::set1( frequency );
+			const V n = signedNoise( perm, L::mul( x, octaveFrequency ), L::mul( y, octaveFrequency ), L::mul( z, octaveFrequency ), period );
+			V octave;
+			switch ( params.type )
+			{
+			case PerlinNoise::FractalType::Ridged:
+			{
+				const V ridge = L::sub( L::set1( 1 ), L::abs( n ) );
+				octave = L::mul( ridge, ridge );
+				break;
+			}
+			case PerlinNoise::FractalType::Turbulence:
+				octave = L::abs( n );
+				break;
+			default:
+				octave = n;
+				break;
+			}
+			sum = L::add( sum, L::mul( L::set1( amplitude ), octave ) );
+			amplitude *= params.gain;
+			frequency *= params.lacunarity;
+			const int nextPeriod = static_cast<int>( period * params.lacunarity );
+			period = nextPeriod < 256 ?
+				nextPeriod :
+				256;
+		}
+
+		sum = L::mul( sum, L::set1( params.normalization ) );
+		if ( params.type == PerlinNoise::FractalType::Fbm )
+		{
+			return L::mul( L::add( sum, L::set1( 1 ) ), L::set1( static_cast<T>( 0.5 ) ) );
+		}
+		return sum;
+	}
+};
+
+/// \brief	samples the first n - n % L::s_nLanes points ( xs[i], ys[i], zs[i] ) into out[i] & returns how many that is
+template<class L>
+std::size_t sampleLanes( const int *perm,
+	const typename L::T *xs,
+	const typename L::T *ys,
+	const typename L::T *zs,
+	typename L::T *out,
+	const std::size_t n,
+	const Params<typename L::T> &params ) noexcept
+{
+	std::size_t i = 0;
+	for ( ; i + L::s_nLanes <= n; i += L::s_nLanes )
+	{
+		L::store( out + i, Kernel<L>::sample( perm, L::load( xs + i ), L::load( ys + i ), L::load( zs + i ), params ) );
+	}
+	return i;
+}
+
+/// \brief	sampleLanes of the points ( xs[i], y, z )
+template<class L>
+std::size_t sampleRowLanes( const int *perm,
+	const typename L::T *xs,
+	const typename L::T y,
+	const typename L::T z,
+	typename L::T *out,
+	const std::size_t n,
+	const Params<typename L::T> &params ) noexcept
+{
+	const typename L::V vy = L::set1( y );
+	const typename L::V vz = L::set1( z );
+	std::size_t i = 0;
+	for ( ; i + L::s_nLanes <= n; i += L::s_nLanes )
+	{
+		L::store( out + i, Kernel<L>::sample( perm, L::load( xs + i ), vy, vz, params ) );
+	}
+	return i;
+}
+
+
+}// namespace
\ No newline at end of file
@@ -1,29 +1,68 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
+#include <memory>
 #include "bindable_pass.h"
 #include "job.h"
+#include "instance_batcher.h"
+#include "render_queue_sort.h"
 
 
+class InstanceBuffer;
+class InstancedTransformVSCB;
+
 namespace ren
 {
 
+///=============================================================
+/// \class	RenderQueuePass
+/// \author	KeyC0de
+/// \date	2026/10/17 19:10
+/// \brief	a Pass that draws the Jobs submitted to it by Materials each frame
+/// \brief	every Job gets a 64bit sort key on submission
+/// \brief		opaque:			[shader id 24 | texture id 16 | depth 24] - state changes minimized first, then front to back
+/// \brief		transparent:	[~depth 24 | shader id 24 | texture id 16] - back to front
+/// \brief	the keys are radix sorted once per frame & bindables shared by consecutive Jobs are not rebound
+/// \brief	in opaque Passes, Jobs of instanced Materials that share geometry & Material state are merged into one instanced draw
+/// \brief		of the finest LOD any of them needs, which is selected on every run since each run may have its own view (eg. shadow map faces)
+/// \brief	with multithreaded rendering enabled RenderQueuePasses are recorded into command lists in parallel
+///=============================================================
 class RenderQueuePass
 	: public IBindablePass
 {
 	bool m_bTransparent;
-	std::vector<std::pair<Job, float>> m_jobs;
+	std::vector<Job> m_jobs;
+	mutable std::vector<SortEntry> m_sortEntries;
+	mutable std::vector<SortEntry> m_sortScratch;
+	mutable bool m_bSorted = true;
+	mutable unsigned m_nSkippedBinds = 0u;
+	mutable unsigned m_nDrawCalls = 0u;
+	mutable InstanceBatcher m_instanceBatcher;
+	mutable std::vector<unsigned> m_batchLods;	// per Batch: the finest LOD any of its Meshes needs in the current run
+	mutable std::unique_ptr<InstanceBuffer> m_pInstanceBuffer;
+	mutable std::unique_ptr<InstancedTransformVSCB> m_pInstancedTransformVscb;
 public:
 	RenderQueuePass( const std::string &name, const std::vector<std::shared_ptr<IBindable>> &bindables = {}, const bool bTransparentMeshPass = false );
+	~RenderQueuePass() noexcept;
 
 	void addJob( Job job, const float meshDistanceFromActiveCamera ) noexcept;
 	/// \brief	call RenderQueuePass::run from derivedPassClass::run as a final task
 	/// \brief	first binds common/shared Pass bindables, then binds individual Mesh bindables (Job), then binds Material bindables (Job), then executes draw call
 	void run( Graphics &gfx ) const cond_noex override;
 	void reset() cond_noex override;
+	/// \brief	Jobs only touch their own Meshes' & Materials' bindables so any RenderQueuePass can be recorded on a worker thread
+	bool isRecordable() const noexcept override;
 	size_t getNumMeshes() const noexcept;
+	/// \brief	number of redundant binds skipped by the last run
+	unsigned getNumSkippedBinds() const noexcept;
+	/// \brief	number of draw calls issued by the last run; less than getNumMeshes() when Jobs were instanced
+	unsigned getNumDrawCalls() const noexcept;
 private:
-	void sortJobs();
+	std::uint64_t makeSortKey( const Job &job, const float meshDistanceFromActiveCamera ) const noexcept;
+	void sortJobs() const;
+	/// \brief	batches the sorted Jobs & uploads the instance data
+	void formInstanceBatches( Graphics &gfx ) const;
 };
 
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+
+namespace ren
+{
+
+// the RenderQueuePass's Job ordering & bind bookkeeping, free of GPU resources
+
+static constexpr std::size_t s_radixSortThreshold = 256u;	// below this many Jobs std::stable_sort is faster
+
+struct SortEntry final
+{
+	std::uint64_t m_key;
+	std::uint32_t m_jobIndex;
+};
+
+/// \brief	[shader id 24 | texture id 16 | depth 24] - state changes minimized first, then front to back
+std::uint64_t makeOpaqueSortKey( const std::uint32_t shaderId, const std::uint32_t textureId, const float distance ) noexcept;
+/// \brief	[~depth 24 | shader id 24 | texture id 16] - back to front
+std::uint64_t makeTransparentSortKey( const std::uint32_t shaderId, const std::uint32_t textureId, const float distance ) noexcept;
+/// \brief	stable sorts the entries by ascending key; LSD radix sort (8 bit digits) from s_radixSortThreshold entries up, std::stable_sort below
+/// \brief	scratch is resized as needed & can be reused across calls
+void sortByKey( std::vector<SortEntry> &entries, std::vector<SortEntry> &scratch );
+
+/// \brief	calls bind( *bindables[i] ) for every entry, except skippable ones that pPreviousBindables holds too - the previous Job left them bound
+/// \return	the number of skipped binds
+template<typename TBindable, typename TBindFunc>
+unsigned bindSkippingShared( const std::vector<std::shared_ptr<TBindable>> &bindables,
+	const std::vector<std::uint8_t> &skippable,
+	const std::vector<std::shared_ptr<TBindable>> *pPreviousBindables,
+	const TBindFunc &bind )
+{
+	unsigned nSkippedBinds = 0u;
+	for ( std::size_t i = 0; i < bindables.size(); ++i )
+	{
+		bool bBoundAlready = false;
+		if ( pPreviousBindables != nullptr && skippable[i] )
+		{
+			for ( const auto &pPrevious : *pPreviousBindables )
+			{
+				if ( pPrevious == bindables[i] )
+				{
+					bBoundAlready = true;
+					break;
+				}
+			}
+		}
+
+		if ( bBoundAlready )
+		{
+			++nSkippedBinds;
+			continue;
+		}
+		bind( *bindables[i] );
+	}
+	return nSkippedBinds;
+}
+
+
+}//namespace ren
\ No newline at end of file
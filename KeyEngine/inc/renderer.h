@@ -23,6 +23,8 @@ class IPass;
 class RenderQueuePass;
 class ILinker;
 class IBinder;
+class ICommandListBackend;
+class CommandListScheduler;
 
 class Renderer
 {
@@ -30,6 +32,9 @@ class Renderer
 	std::vector<std::unique_ptr<IPass>> m_passes;
 	std::vector<std::unique_ptr<IBinder>> m_globalBinders;
 	std::vector<std::unique_ptr<ILinker>> m_globalLinkers;
+	std::vector<IPass*> m_activePasses;
+	std::unique_ptr<ICommandListBackend> m_pCommandListBackend;
+	std::unique_ptr<CommandListScheduler> m_pCommandListScheduler;
 protected:
 	bool m_bUsesOffscreen;
 	std::unique_ptr<IPass> m_pFinalPostProcessPass;
@@ -39,6 +44,7 @@ public:
 	Renderer( Graphics &gfx, const bool drawToOffscreen );
 	virtual ~Renderer() noexcept;
 
+	/// \brief	with multithreaded rendering the recordable Passes are recorded on worker threads & replayed in Pass order
 	void run( Graphics &gfx ) cond_noex;
 	virtual void recreate( Graphics &gfx );
 	virtual void reset() noexcept;
@@ -53,6 +59,7 @@ protected:
 	IPass& getPass( const std::string &name );
 private:
 	void validateBindersLinkage();
+	void runPassesMultithreaded( Graphics &gfx ) cond_noex;
 	/// \brief	links pass's binders to their linkers
 	void linkPassBinders( IPass &pass );
 	/// \brief	If there's a final post process pass (Pass that renders directly to the Back Buffer) then swap the render targets, ie.
@@ -86,7 +93,7 @@ public:
 	void dumpShadowCubeMap( Graphics &gfx, const std::string &path );
 	/// \brief	binds active camera to all Passes that need it
 	void setActiveCamera( const Camera &cam );
-	void bindShadowCastingLights( Graphics &gfx, const std::vector<ILightSource*> &shadowCastingLights );
+	void bindShadowCastingLights( Graphics &gfx, const std::pmr::vector<ILightSource*> &shadowCastingLights );
 private:
 	void showShadowDumpImguiWindow( Graphics &gfx ) noexcept;
 	void showGaussianBlurImguiWindow( Graphics &gfx ) noexcept;
@@ -36,6 +36,7 @@ class SettingsManager final
 		bool bAllowWindowResize = false;
 		bool bEnableFrustumCuling = true;
 		bool bEnableSmoothMovement = true;
+		bool bDoubleBufferedCpuFramebuffer = false;
 		std::string sSkyboxFileName = "";
 		std::string sFontName = "myComicSansMSSpriteFont";
 	} m_settings;
@@ -65,6 +65,8 @@ class ShadowPass
 	std::vector<ILightSource*> m_shadowCastingLights;
 	std::shared_ptr<TextureArrayOffscreenDS> m_pOffscreenDsvMapArray;			// shadow maps for Directional/Spot lights
 	std::shared_ptr<CubeTextureArrayOffscreenDS> m_pOffscreenDsvCubemapArray;	// shadow cube maps for Point lights
+	unsigned m_nShadowMaps = 0u;		// lights m_pOffscreenDsvMapArray was last created for
+	unsigned m_nShadowCubeMaps = 0u;	// lights m_pOffscreenDsvCubemapArray was last created for
 public:
 	static unsigned getResolution() noexcept;
 public:
@@ -73,8 +75,10 @@ public:
 	/// \brief	update the light's -camera- view Proj Matrix for projective texture shadow cube mapping
 	//				then render the depth buffer to texture 6 times
 	void run( Graphics &gfx ) const cond_noex override;
+	/// \brief	the globals & light CBs are read by the shaders of the Passes that follow
+	void bindSharedState( Graphics &gfx ) const cond_noex override;
 	/// \brief	populate shadow casting lights for this frame and setup their offscreen shadow maps for rendering into
-	void bindShadowCastingLights( Graphics &gfx, const std::vector<ILightSource*> &shadowCastingLights );
+	void bindShadowCastingLights( Graphics &gfx, const std::pmr::vector<ILightSource*> &shadowCastingLights );
 	/// \brief	currently only dumping shadow map of the first registered shadow casting light
 	void dumpShadowMap( Graphics &gfx, const std::string &path ) const;
 	void dumpShadowCubeMap( Graphics &gfx, const std::string &path ) const;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "non_copyable.h"
+#include "color.h"
+
+
+class Bitmap;
+class CpuFramebuffer;
+class RectangleF;
+
+///=============================================================
+/// \class	SoftwareRasterizer
+/// \author	KeyC0de
+/// \date	2026/10/18 18:05
+/// \brief	queues 2d primitives & rasterizes them into a CpuFramebuffer's back buffer on flush
+/// \brief	primitives are binned into the framebuffer's tiles, which are rasterized in parallel on the ThreadPoolJ
+/// \brief		each tile draws its primitives in submission order, so the output doesn't depend on the thread count
+/// \brief	4 pixels at a time with SSE: edge functions for triangles, distances for circles & lines, 8bit "over" blending
+/// \brief	coordinates are in pixels with pixel centers at +0.5; aliased primitives cover the pixels whose center they contain; triangles use the top-left rule on vertices snapped to 1/256 pixel, so shared edges are watertight
+/// \brief	anti-aliased primitives cover pixels by their distance to the edge, over a 1 pixel wide ramp
+/// \brief	sprite Bitmaps aren't copied, they must outlive the flush
+///=============================================================
+class SoftwareRasterizer final
+	: NonCopyableAndNonMovable
+{
+public:
+	enum class BlendMode : std::uint8_t
+	{
+		Opaque,		// alpha is written as is, unless anti-aliasing coverage blends the edges
+		Alpha,		// src over dst by the color's (or texel's) alpha
+	};
+private:
+	enum class CommandType : std::uint8_t
+	{
+		Rect,
+		Triangle,
+		Circle,
+		Line,
+		Sprite,
+	};
+
+	struct Command final
+	{
+		CommandType type;
+		BlendMode blend;
+		bool bAntiAliased;
+		ColorBGRA color;			// the sprite's tint
+		int bounds[4];				// covered pixels: left, top, right & bottom (exclusive), clipped to the framebuffer
+		float params[9];			// Rect: left, top, right, bottom; Triangle: 3 vertices; Circle: center, radius; Line: 2 end points, half width; Sprite: the Rect's & the source texel rect
+		const Bitmap *pBitmap;
+	};
+
+	CpuFramebuffer &m_framebuffer;
+	std::vector<Command> m_commands;
+	std::vector<std::uint32_t> m_tileCommandOffsets;	// the commands of tile i are at m_tileCommands[m_tileCommandOffsets[i], m_tileCommandOffsets[i + 1])
+	std::vector<std::uint32_t> m_tileCommands;
+	std::vector<std::uint32_t> m_activeTiles;
+public:
+	SoftwareRasterizer( CpuFramebuffer &framebuffer );
+
+	void fillRect( const float left, const float top, const float right, const float bottom, const ColorBGRA color, const BlendMode blend = BlendMode::Opaque, const bool bAntiAliased = false );
+	void fillRect( const RectangleF &rect, const ColorBGRA color, const BlendMode blend = BlendMode::Opaque, const bool bAntiAliased = false );
+	/// \brief	either winding
+	void fillTriangle( const float x0, const float y0, const float x1, const float y1, const float x2, const float y2, const ColorBGRA color, const BlendMode blend = BlendMode::Opaque, const bool bAntiAliased = false );
+	void fillCircle( const float centerX, const float centerY, const float radius, const ColorBGRA color, const BlendMode blend = BlendMode::Opaque, const bool bAntiAliased = false );
+	/// \brief	a line with round caps
+	void drawLine( const float x0, const float y0, const float x1, const float y1, const ColorBGRA color, const float width = 1.0f, const BlendMode blend = BlendMode::Opaque, const bool bAntiAliased = false );
+	/// \brief	a textured quad, nearest sampled from the whole Bitmap; its texels are modulated by tint
+	void drawSprite( const Bitmap &bitmap, const float left, const float top, const float right, const float bottom, const BlendMode blend = BlendMode::Alpha, const ColorBGRA tint = ColorBGRA{255, 255, 255, 255} );
+	/// \brief	a textured quad, nearest sampled from the srcWidth x srcHeight texels at srcLeft, srcTop of the Bitmap, eg. a sprite sheet frame
+	void drawSprite( const Bitmap &bitmap, const unsigned srcLeft, const unsigned srcTop, const unsigned srcWidth, const unsigned srcHeight, const float left, const float top, const float right, const float bottom, const BlendMode blend = BlendMode::Alpha, const ColorBGRA tint = ColorBGRA{255, 255, 255, 255} );
+	/// \brief	bins & rasterizes the queued primitives, marking their tiles dirty in the framebuffer
+	void flush();
+	std::size_t getQueuedCount() const noexcept;
+private:
+	/// \brief	clips bounds to the framebuffer & queues the command unless it's empty or any of its params isn't finite
+	void queue( Command &command, const float left, const float top, const float right, const float bottom );
+	void rasterizeTile( const unsigned tileIndex ) const noexcept;
+};
\ No newline at end of file
@@ -1,22 +1,41 @@
 #pragma once
 
 #include <variant>
+#include <memory>
+#include <array>
 #include <DirectXMath.h>
 #include "mesh.h"
+#include "terrain_quadtree.h"
 
 
 class Graphics;
 
+///=============================================================
+/// \class	Terrain
+/// \author	KeyC0de
+/// \date	2026/10/18 00:20
+/// \brief	heightmapped grid split into chunks of s_chunkQuads x s_chunkQuads quads, kept in a TerrainQuadtree
+/// \brief	every draw (ie. every pass, eg. the camera's & each shadow casting light's) picks each chunk's LOD by its distance & screen space error
+/// \brief		from the pass' own view & projection, chunks outside that view's frustum aren't drawn
+/// \brief	all chunks share one vertex buffer (a vertex block per chunk) & one index buffer (the index sets of all LODs & stitch variants)
+///=============================================================
 class Terrain
 	: public Mesh
 {
 	static inline constexpr const char *s_geometryTag = "$terrainGrid";
-	int m_quadWidth = 0;	// #TODO:
-	int m_quadHeight = 0;	// #TODO:
+	static constexpr int s_chunkQuads = 32;
+	static constexpr unsigned s_nLods = 6u;	// down to a single quad per chunk
+	static constexpr float s_maxPixelError = 2.0f;
+	std::unique_ptr<TerrainQuadtree> m_pQuadtree;
 public:
 	/// \brief	length and width is in meters (even though the base units of the engine is cm)
 	Terrain( Graphics &gfx, const float initialScale = 1.0f, const std::variant<DirectX::XMFLOAT4, std::string> &colorOrTexturePath = "assets/models/brick_wall/brick_wall_diffuse.jpg", const std::string &heightMapfilename = "", const int length = 100, const int width = 100, const int normalizeAmount = 4, const int terrainAreaUnitMultiplier = 10 );
+	/// \brief	selects the visible chunks & their LODs for the Graphics' current view & projection, then draws each with the index set of its LOD & stitched edges
+	void draw( Graphics &gfx ) const cond_noex override;
+	const TerrainQuadtree& getQuadtree() const noexcept;
 private:
+	/// \brief	the viewport height is read on every call, so it follows window resizes; localPlanes receives the frustum planes
+	TerrainQuadtree::SelectionParams makeSelectionParams( const Graphics &gfx, std::array<DirectX::XMFLOAT4, 6> &localPlanes ) const noexcept;
 	/// \brief	transforms each vertex's position by the specified matrix
 	void transformVerticesPosition( ver::VBuffer &vb, const DirectX::XMMATRIX &matrix ) noexcept;
 };
\ No newline at end of file
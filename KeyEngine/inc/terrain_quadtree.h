@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <DirectXMath.h>
+
+
+///=============================================================
+/// \class	TerrainQuadtree
+/// \author	KeyC0de
+/// \date	2026/10/18 00:10
+/// \brief	CPU side of the chunked terrain: splits a regular heightfield into square chunks of chunkQuads x chunkQuads quads
+/// \brief		& keeps them in a quadtree of AABBs for hierarchical frustum culling
+/// \brief	every chunk has its own (chunkQuads + 1)^2 vertex block, vertex (i, j) of chunk c is vertex c * getChunkVertexCount() + j * ( chunkQuads + 1 ) + i
+/// \brief	LOD l skips every 2^l - 1 vertices; its index sets are shared by all chunks (drawn with a base vertex) & come in 16 variants,
+/// \brief		one per combination of edges bordering a one LOD coarser neighbour; on those edges the odd vertices collapse onto their even neighbour
+/// \brief		so both chunks share the same edge & no cracks open
+/// \brief	the heightfield lies on the xy plane with heights along z, like the planar grids of the geometry namespace
+/// \brief	all of it is plain math, no Graphics needed
+///=============================================================
+class TerrainQuadtree final
+{
+public:
+	static constexpr unsigned s_maxLods = 8u;
+
+	/// \brief	stitch mask bits, set when the neighbour across that edge is one LOD coarser
+	enum Edge : unsigned
+	{
+		Left = 1u << 0,		// x = 0
+		Right = 1u << 1,	// x = chunkQuads
+		Bottom = 1u << 2,	// y = 0
+		Top = 1u << 3,		// y = chunkQuads
+	};
+	static constexpr unsigned s_nStitchMasks = 16u;
+
+	struct Chunk final
+	{
+		unsigned x;		// in chunks
+		unsigned y;
+		DirectX::XMFLOAT3 aabbMin;
+		DirectX::XMFLOAT3 aabbMax;
+		std::array<float, s_maxLods> geometricErrors;	// max height deviation from the full detail surface per LOD, non decreasing
+	};
+
+	struct IndexRange final
+	{
+		unsigned startIndex;
+		unsigned nIndices;
+	};
+
+	struct Selection final
+	{
+		unsigned chunk;
+		unsigned lod;
+		unsigned stitchMask;
+	};
+
+	struct SelectionParams final
+	{
+		DirectX::XMFLOAT3 viewPosition;						// in the heightfield's space
+		float projectionScale;								// viewportHeight / ( 2 * tan( fovY / 2 ) ), turns error / distance into pixels
+		float maxPixelError = 2.0f;							// the coarsest LOD whose error projects to at most this many pixels is picked
+		const DirectX::XMFLOAT4 *pFrustumPlanes = nullptr;	// 6 inward facing planes in the heightfield's space; nullptr disables culling
+		bool bOrthographic = false;							// projectionScale is then in pixels per unit, at any distance
+	};
+
+	struct SelectionResult final
+	{
+		std::vector<unsigned> lods;				// per chunk, culled ones included
+		std::vector<Selection> selection;		// the visible chunks
+	};
+private:
+	struct Node final
+	{
+		DirectX::XMFLOAT3 aabbMin;
+		DirectX::XMFLOAT3 aabbMax;
+		unsigned firstChild;	// children are consecutive
+		unsigned nChildren;		// 0 for leaves
+		unsigned chunk;			// leaves only
+	};
+
+	unsigned m_nChunksX;
+	unsigned m_nChunksY;
+	unsigned m_chunkQuads;
+	unsigned m_nLods;
+	std::vector<Chunk> m_chunks;
+	std::vector<Node> m_nodes;	// m_nodes[0] is the root
+	std::vector<unsigned> m_indices;
+	std::vector<IndexRange> m_indexRanges;	// [lod * s_nStitchMasks + stitchMask]
+	SelectionResult m_lastSelection;
+public:
+	/// \brief	heights holds ( nChunksX * chunkQuads + 1 ) x ( nChunksY * chunkQuads + 1 ) values, row y first; vertex (x, y) is at ( x0 + x * dx, y0 + y * dy, height )
+	/// \brief	chunkQuads must be a power of two & nLods at most log2( chunkQuads ) + 1
+	TerrainQuadtree( const float *heights, const unsigned nChunksX, const unsigned nChunksY, const unsigned chunkQuads, const unsigned nLods, const float x0, const float y0, const float dx, const float dy );
+
+	/// \brief	picks every chunk's LOD from its distance & screen space error, limits neighbouring LODs to 1 apart, then culls
+	/// \brief	returns the visible chunks; valid until the next call
+	const std::vector<Selection>& select( const SelectionParams &params );
+	/// \brief	the same into the caller's result, eg. one per view that's rendered; concurrent calls are safe
+	void select( const SelectionParams &params, SelectionResult &result ) const;
+	/// \brief	the result of the last select
+	const std::vector<Selection>& getSelection() const noexcept;
+	/// \brief	the triangle list indices of all LODs & stitch variants, relative to a chunk's first vertex
+	const std::vector<unsigned>& getIndices() const noexcept;
+	const IndexRange& getIndexRange( const unsigned lod, const unsigned stitchMask ) const noexcept;
+	const std::vector<Chunk>& getChunks() const noexcept;
+	unsigned getChunkVertexCount() const noexcept;
+	unsigned getChunkQuads() const noexcept;
+	unsigned getLodCount() const noexcept;
+	/// \brief	the LOD select picked for every chunk (culled ones included) last time
+	const std::vector<unsigned>& getLods() const noexcept;
+private:
+	void computeChunk( const float *heights, const unsigned chunkX, const unsigned chunkY, const float x0, const float y0, const float dx, const float dy );
+	/// \brief	builds the subtree over chunks [cx0, cx1) x [cy0, cy1) into m_nodes[nodeIndex]
+	void buildNode( const unsigned nodeIndex, const unsigned cx0, const unsigned cy0, const unsigned cx1, const unsigned cy1 );
+	void buildIndices();
+	void cullNode( const unsigned nodeIndex, const DirectX::XMFLOAT4 *pFrustumPlanes, SelectionResult &result ) const;
+};
\ No newline at end of file
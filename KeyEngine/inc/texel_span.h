@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+
+// converts 32bit BGRA texels to one [-1,1] float array per color channel & back, for TextureProcessor's spans
+//	texel_span.cpp has the SSE2 & scalar paths, texel_span_avx2.cpp the AVX2 one
+
+namespace texel_span
+{
+
+/// \brief	same mapping as Bitmap::colorToVector, 8 texels at a time if the CPU supports AVX2 or 4 otherwise
+void unpack( const std::uint32_t *pTexels, const unsigned count, float *pR, float *pG, float *pB ) noexcept;
+/// \brief	same mapping as Bitmap::vectorToColor but saturated, the alpha of the texels is kept
+void pack( const float *pR, const float *pG, const float *pB, const unsigned count, std::uint32_t *pTexels ) noexcept;
+
+
+}//namespace texel_span
+
+namespace texel_span_avx2
+{
+
+/// \brief	unpack & pack of texel_span_avx2.cpp, which is compiled for AVX2; call them only if util::getCpuFeatures().bAvx2
+/// \brief	they convert the first count - count % 8 texels & return how many that is
+unsigned unpack( const std::uint32_t *pTexels, const unsigned count, float *pR, float *pG, float *pB ) noexcept;
+unsigned pack( const float *pR, const float *pG, const float *pB, const unsigned count, std::uint32_t *pTexels ) noexcept;
+
+
+}//namespace texel_span_avx2
\ No newline at end of file
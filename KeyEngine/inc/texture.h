@@ -4,41 +4,54 @@
 #include <vector>
 #include "bindable.h"
 #include "bitmap.h"
+#include "texture_processor.h"
 #include "render_target_view.h"
 #include "depth_stencil_view.h"
 
 
 class Graphics;
 
-using TextureOp = DirectX::XMVECTOR(*)(Bitmap::Texel);
+/// \brief	what a Texture's image holds, it decides how the Texture's mips are filtered
+enum class TextureContent
+{
+	Color,		// sRGB colors that tile & are alpha tested at g_alphaTestCutoff
+	Specular,	// sRGB specular colors that tile, with the gloss in alpha
+	NormalMap,	// tangent space normals that tile
+	Mask,		// a linear mask or height in red that tiles; compressed to BC4, which samples as (r, 0, 0, 1)
+	Ui,			// an sRGB image stretched once over a UI element, clamped at its edges & alpha blended
+};
 
 class Texture
 	: public IBindable
 {
 	bool m_bAlpha = false;
 	bool m_bDynamic = false;
+	TextureContent m_content = TextureContent::Color;
 	std::string m_path;
 	unsigned m_width;
 	unsigned m_height;
 	unsigned int m_slot;
-	TextureOp m_op = nullptr;
+	TexelSpanOp m_op = nullptr;
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> m_pTex;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_pD3dSrv;
 public:
-	Texture( Graphics &gfx, const std::string &filepath, const unsigned slot, TextureOp op = nullptr );
-	/// \brief	Texture constructor with dynamic CPU per frame update
-	Texture( Graphics &gfx, const unsigned width, const unsigned height, const unsigned slot, TextureOp op = nullptr );
+	/// \brief	uploads the whole mip chain of the image, cooked next to it on first load (unless op is set)
+	/// \brief	normal maps are renormalized per level, the rest are filtered as sRGB; only TextureContent::Color keeps its alpha tested coverage
+	Texture( Graphics &gfx, const std::string &filepath, const unsigned slot, TexelSpanOp op = nullptr, const TextureContent content = TextureContent::Color );
+	/// \brief	Texture constructor with dynamic CPU per frame update, from Graphics' CpuFramebuffer
+	Texture( Graphics &gfx, const unsigned width, const unsigned height, const unsigned slot, TexelSpanOp op = nullptr );
 
 	void paintTextureWithBitmap( Graphics &gfx, ID3D11Texture2D *tex, const Bitmap &bitmap, const D3D11_BOX *destPortion = nullptr );
 	void bind( Graphics &gfx ) cond_noex override;
+	/// \brief	uploads the CpuFramebuffer's upload rects, once after every CpuFramebuffer::endFrame
 	void update( Graphics &gfx ) cond_noex;
 	bool hasAlpha() const noexcept;
 	const std::string& getPath() const noexcept;
 	unsigned getWidth() const noexcept;
 	unsigned getHeight() const noexcept;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& getD3dSrv();
-	static std::shared_ptr<Texture> fetch( Graphics &gfx, const std::string &filepath, const unsigned slot, TextureOp op = nullptr );
-	static std::string calcUid( const std::string &filepath, const unsigned slot, TextureOp op = nullptr );
+	static std::shared_ptr<Texture> fetch( Graphics &gfx, const std::string &filepath, const unsigned slot, TexelSpanOp op = nullptr, const TextureContent content = TextureContent::Color );
+	static std::string calcUid( const std::string &filepath, const unsigned slot, TexelSpanOp op = nullptr, const TextureContent content = TextureContent::Color );
 	std::string getUid() const noexcept override;
 	unsigned getSlot() const noexcept;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <d3d11.h>
+#include "block_compression.h"
 
 
 enum BindFlags : unsigned
@@ -49,6 +50,9 @@ const D3D11_TEXTURE2D_DESC createTextureDescriptor( const unsigned width, const
 
 const DXGI_FORMAT getFormatRtv( const RenderTargetViewMode mode );
 
+/// \brief	DXGI format of a (cooked) texture's texels or blocks
+const DXGI_FORMAT getFormatTexture( const bc::Format format );
+
 /// \brief	Use when creating the texture descriptor
 /// \brief	DS format for D3D11_TEXTURE2D_DESC creation
 /// \brief	_TYPELESS is actually a float type
@@ -1,24 +1,60 @@
 #pragma once
 
 #include <string>
+#include <algorithm>
 #include "bitmap.h"
+#include "thread_poolj.h"
 
 
 using TextureOp = DirectX::XMVECTOR(*)(Bitmap::Texel);
 
+/// \brief	count consecutive texels of row y starting at column x, unpacked to one [-1,1] float array per channel
+struct TexelSpan final
+{
+	float *r;
+	float *g;
+	float *b;
+	unsigned x;
+	unsigned y;
+	unsigned count;
+};
+
+using TexelSpanOp = void(*)( const TexelSpan &span );
+
 class TextureProcessor final
 {
+	static constexpr unsigned s_spanLength = 256u;	// 3 float arrays of it stay in L1
+
 	template<typename F>
 	static void transformFile( const std::string &pathIn,
 		const std::string &pathOut,
-		F &&f )
+		const F &f )
 	{
 		auto bitmap = Bitmap::loadFromFile( pathIn );
-		TextureProcessor::transformBitmap( bitmap, f );
+		TextureProcessor::transformRows( bitmap, f );
 		bitmap.save( pathOut );
 	}
 
+	template<typename F>
+	static void parallelForRows( const unsigned height,
+		const F &f )
+	{
+		ThreadPoolJ::getInstance().parallelFor( 0u, height, 0u,
+			[&f] ( const std::size_t first, const std::size_t last )
+			{
+				for ( std::size_t y = first; y < last; ++y )
+				{
+					f( static_cast<unsigned>( y ) );
+				}
+			} );
+	}
+
 	static const unsigned calculateNumberOfMipMaps( const unsigned width, const unsigned height ) noexcept;
+	/// \brief	same mapping as Bitmap::colorToVector, 8 texels at a time if the CPU supports AVX2 or 4 otherwise; texel_span.h
+	static void unpackSpan( const Bitmap::Texel *pTexels, const unsigned count, float *pR, float *pG, float *pB ) noexcept;
+	/// \brief	same mapping as Bitmap::vectorToColor but saturated, the alpha of the texels is kept
+	static void packSpan( const float *pR, const float *pG, const float *pB, const unsigned count, Bitmap::Texel *pTexels ) noexcept;
+	static void flipGreenChannel( Bitmap::Texel *pTexels, const unsigned count ) noexcept;
 public:
 	static void flipModelNormalMapsGreenChannel( const std::string &objPath );
 	/// \brief	flips the normal map green channel of given texture
@@ -26,6 +62,7 @@ public:
 	static void validateNormalMap( const std::string &pathIn, const float thresholdMin, const float thresholdMax );
 	static void makeStripes( const std::string &pathOut, const int size, const int stripeWidth );
 	/// \brief	apply function f at every Texel in the Bitmap
+	/// \brief	per Texel fallback of transformSpans, f is called in row order on the calling thread
 	static void transformBitmap( Bitmap &bitmap, TextureOp f );
 	template<typename F>
 	static void transformBitmap( Bitmap &bitmap,
@@ -42,4 +79,66 @@ public:
 			}
 		}
 	}
+
+	/// \brief	calls f( pRow, width, y ) for every row of raw texels, rows are split among the ThreadPoolJ workers
+	/// \brief	f must be thread safe; it may only touch its own row
+	template<typename F>
+	static void transformRows( Bitmap &bitmap,
+		const F &f )
+	{
+		const unsigned width = bitmap.getWidth();
+		const unsigned pitch = bitmap.getPitch();
+		Byte *pBytes = reinterpret_cast<Byte*>( bitmap.data() );
+		parallelForRows( bitmap.getHeight(),
+			[&f, width, pitch, pBytes] ( const unsigned y )
+			{
+				f( reinterpret_cast<Bitmap::Texel*>( pBytes + static_cast<std::size_t>( y ) * pitch ), width, y );
+			} );
+	}
+
+	/// \brief	the batch version of transformBitmap: every row is unpacked to floats in TexelSpans which f modifies in place & are then packed back
+	/// \brief	f must be thread safe, spans of different rows run concurrently
+	template<typename F>
+	static void transformSpans( Bitmap &bitmap,
+		const F &f )
+	{
+		transformRows( bitmap,
+			[&f] ( Bitmap::Texel *pRow, const unsigned width, const unsigned y )
+			{
+				alignas( 32 ) float r[s_spanLength];
+				alignas( 32 ) float g[s_spanLength];
+				alignas( 32 ) float b[s_spanLength];
+				for ( unsigned x = 0; x < width; x += s_spanLength )
+				{
+					const unsigned count = std::min( s_spanLength, width - x );
+					unpackSpan( pRow + x, count, r, g, b );
+					f( TexelSpan{r, g, b, x, y, count} );
+					packSpan( r, g, b, count, pRow + x );
+				}
+			} );
+	}
+
+	/// \brief	read only transformSpans
+	template<typename F>
+	static void visitSpans( const Bitmap &bitmap,
+		const F &f )
+	{
+		const unsigned width = bitmap.getWidth();
+		const unsigned pitch = bitmap.getPitch();
+		const Byte *pBytes = reinterpret_cast<const Byte*>( bitmap.getData() );
+		parallelForRows( bitmap.getHeight(),
+			[&f, width, pitch, pBytes] ( const unsigned y )
+			{
+				const Bitmap::Texel *pRow = reinterpret_cast<const Bitmap::Texel*>( pBytes + static_cast<std::size_t>( y ) * pitch );
+				alignas( 32 ) float r[s_spanLength];
+				alignas( 32 ) float g[s_spanLength];
+				alignas( 32 ) float b[s_spanLength];
+				for ( unsigned x = 0; x < width; x += s_spanLength )
+				{
+					const unsigned count = std::min( s_spanLength, width - x );
+					unpackSpan( pRow + x, count, r, g, b );
+					f( TexelSpan{r, g, b, x, y, count} );
+				}
+			} );
+	}
 };
\ No newline at end of file
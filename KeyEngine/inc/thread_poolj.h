@@ -1,11 +1,22 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <queue>
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <tuple>
+#include <new>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <initializer_list>
 #include "jthread/jthread.h"
 #include "jthread/stop_token.h"
+#include "lock_free_queue.h"
 #include "non_copyable.h"
 #include "key_exception.h"
 
@@ -14,41 +25,178 @@
 /// \class	ThreadPoolJ
 /// \author	KeyC0de
 /// \date	25/9/2019 3:55
-/// \brief	A class which encapsulates a Queue of Tasks & a Pool of threads and dispatches work on demand
-/// \brief		ie. upon an incoming Task - callable object - a thread is dispatched to execute it
+/// \brief	A work-stealing scheduler which dispatches Tasks - callable objects - to a Pool of threads
 /// \brief		singleton class
-/// \brief	move only
+/// \brief	every worker owns a lock-free Chase-Lev deque; it pops its own Tasks LIFO and steals FIFO from a random victim when it runs dry
+/// \brief	Tasks submitted from threads outside the pool go through a bounded lock-free injection queue
+/// \brief	idle workers park on their own condition variable & are woken one at a time, there is no global lock
+/// \brief	Tasks live in pool-owned slots (no std::function/std::bind, no heap allocation for small callables)
+/// \brief	enqueue returns a TaskHandle which can be waited on or used as a dependency for continuations
 /// \brief	Leverages jthread facilities - interruptibility.
-/// \brief	The functions you enqueue to ThreadPoolJ must have a first argument of `stop_token`
+/// \brief	The functions you enqueue to ThreadPoolJ must have a first argument of `stop_token`, it is signalled on `stop()`
 /// \brief
 /// \brief	WARNING: Remember to call resetInstance before you terminate your program
 /// \brief	example usage:
 /// \brief		threadPool.enqueue( &doNothing );
 /// \brief		threadPool.enqueue( &func_async::doNothingForEverUntilStoppedProperly );
-/// \brief		threadPool.enqueue( &func1 );
-/// \brief		threadPool.enqueue( &func_async::doPeriodically, &func2, 1000, false );
+/// \brief		auto h = threadPool.enqueue( &func1 );
+/// \brief		threadPool.enqueueAfter( h, &func_async::doPeriodically, &func2, 1000, false );
+/// \brief		threadPool.parallelFor( 0, n, 0, [&] ( const std::size_t first, const std::size_t last ) { ... } );
 ///=============================================================
 class ThreadPoolJ final
-	: public NonCopyable
+	: public NonCopyableAndNonMovable
 {
-	using Task = std::function<void(nonstd::stop_token)>;
+	static constexpr std::size_t s_maxWorkers = 64u;				// one bit per worker in the idle mask
+	static constexpr std::size_t s_tasksPerWorker = 512u;			// Task slots owned by each worker
+	static constexpr std::size_t s_tasksExternal = 4096u;			// Task slots shared by threads outside the pool
+	static constexpr std::size_t s_dequeCapacity = 1024u;
+	static constexpr std::size_t s_injectionQueueCapacity = 4096u;
+	static constexpr unsigned s_spinsBeforeParking = 64u;
+public:
+	class TaskHandle;
+
+	class Task final
+		: public NonCopyableAndNonMovable
+	{
+		friend class ThreadPoolJ;
+		friend class TaskHandle;
+
+		static constexpr std::size_t s_inlineBytes = 64u;
+		static constexpr std::size_t s_maxContinuations = 8u;
+		static constexpr unsigned s_stateBits = 3u;
+		static constexpr std::uint64_t s_stateMask = ( 1u << s_stateBits ) - 1u;
+
+		enum State : std::uint64_t
+		{
+			Free,
+			Pending,	// waiting on dependencies or queued
+			Running,
+			Finished,
+			Cancelled,
+		};
+
+		std::atomic<std::uint64_t> m_genState{0};	// ( generation << s_stateBits ) | State
+		std::atomic<int> m_nPendingDependencies{0};
+		std::atomic_flag m_continuationLock = ATOMIC_FLAG_INIT;
+		unsigned m_nContinuations = 0;
+		std::array<Task*, s_maxContinuations> m_continuations{};
+		void (*m_pfnInvoke)( Task &task, nonstd::stop_token st ) = nullptr;
+		void (*m_pfnDestroy)( Task &task ) = nullptr;
+		alignas( std::max_align_t ) unsigned char m_storage[s_inlineBytes];
+	private:
+		static constexpr std::uint64_t packGenState( const std::uint64_t generation, const State state ) noexcept
+		{
+			return ( generation << s_stateBits ) | state;
+		}
+
+		static constexpr std::uint64_t getGeneration( const std::uint64_t genState ) noexcept
+		{
+			return genState >> s_stateBits;
+		}
+
+		static constexpr State getState( const std::uint64_t genState ) noexcept
+		{
+			return static_cast<State>( genState & s_stateMask );
+		}
+
+		template<typename TCallable, typename... TArgs>
+		void emplace( TCallable &&f,
+			TArgs &&...args )
+		{
+			using Payload = std::tuple<std::decay_t<TCallable>, std::decay_t<TArgs>...>;
+			if constexpr ( sizeof( Payload ) <= s_inlineBytes && alignof( Payload ) <= alignof( std::max_align_t ) )
+			{
+				::new( static_cast<void*>( m_storage ) ) Payload( std::forward<TCallable>( f ), std::forward<TArgs>( args )... );
+				m_pfnInvoke = [] ( Task &task, nonstd::stop_token st ) -> void
+					{
+						invokePayload( *std::launder( reinterpret_cast<Payload*>( task.m_storage ) ), st );
+					};
+				m_pfnDestroy = [] ( Task &task ) -> void
+					{
+						std::launder( reinterpret_cast<Payload*>( task.m_storage ) )->~Payload();
+					};
+			}
+			else
+			{
+				// oversized callables spill to the heap
+				Payload *pPayload = new Payload( std::forward<TCallable>( f ), std::forward<TArgs>( args )... );
+				::new( static_cast<void*>( m_storage ) ) Payload*( pPayload );
+				m_pfnInvoke = [] ( Task &task, nonstd::stop_token st ) -> void
+					{
+						invokePayload( **std::launder( reinterpret_cast<Payload**>( task.m_storage ) ), st );
+					};
+				m_pfnDestroy = [] ( Task &task ) -> void
+					{
+						delete *std::launder( reinterpret_cast<Payload**>( task.m_storage ) );
+					};
+			}
+		}
+
+		template<typename TPayload>
+		static void invokePayload( TPayload &payload,
+			nonstd::stop_token &st )
+		{
+			std::apply( [&st] ( auto &f, auto &...args ) -> void
+				{
+					std::invoke( f, st, args... );
+				}, payload );
+		}
+
+		void destroyPayload() noexcept;
+		void lockContinuations() noexcept;
+		void unlockContinuations() noexcept;
+	public:
+		Task() = default;
+	};
+
+	class TaskHandle final
+	{
+		friend class ThreadPoolJ;
+
+		Task *m_pTask = nullptr;
+		std::uint64_t m_generation = 0;
+	private:
+		TaskHandle( Task *pTask, const std::uint64_t generation ) noexcept;
+	public:
+		TaskHandle() = default;
+
+		bool isValid() const noexcept;
+		/// \brief	a Task is done once it has finished executing or has been cancelled
+		/// \brief	an invalid handle is always done
+		bool isDone() const noexcept;
+	};
+private:
+	struct alignas( 64 ) Worker final
+		: public NonCopyableAndNonMovable
+	{
+		WorkStealingDeque<Task*> m_deque{s_dequeCapacity};
+		std::mutex m_parkMu;
+		std::condition_variable m_parkCond;
+		bool m_bNotified = false;
+		std::size_t m_taskCursor = 0;
+		std::uint32_t m_rngState;
+
+		explicit Worker( const std::uint32_t seed );
+	};
 
 	static inline ThreadPoolJ *s_pInstance;
 	static inline std::recursive_mutex s_mu;
+	static inline thread_local ThreadPoolJ *s_pCurrentPool = nullptr;
+	static inline thread_local std::size_t s_currentWorkerIndex = 0;
 
-	bool m_bEnabled = false;
+	std::atomic<bool> m_bEnabled{false};
+	std::size_t m_nThreads;
+	nonstd::stop_source m_stopSource;
 	std::vector<nonstd::jthread> m_pool;
-	std::queue<Task> m_tasks;
-	std::condition_variable m_cond;
-	std::mutex m_mu;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::unique_ptr<Task[]> m_tasks;
+	std::atomic<std::size_t> m_externalTaskCursor{0};
+	BoundedMpmcQueue<Task*> m_injectionQueue{s_injectionQueueCapacity};
+	alignas( 64 ) std::atomic<std::uint64_t> m_idleMask{0};
 private:
 	explicit ThreadPoolJ( const std::size_t nthreads, const bool bStart );
 public:
 	~ThreadPoolJ() noexcept;
-	ThreadPoolJ( const ThreadPoolJ &rhs ) = delete;
-	ThreadPoolJ& operator=( const ThreadPoolJ &rhs ) = delete;
-	ThreadPoolJ( ThreadPoolJ &&rhs ) noexcept;
-	ThreadPoolJ& operator=( ThreadPoolJ &&rhs ) noexcept;
 
 	static ThreadPoolJ& getInstance( const std::size_t nThreads = 4u, const bool bEnabled = true );
 	static void resetInstance() noexcept;
@@ -57,30 +205,123 @@ public:
 	void start();
 	void stop() noexcept;
 	bool isEnabled() const noexcept;
+	std::size_t getThreadCount() const noexcept;
+
+	template<typename TCallable, typename... TArgs>
+	TaskHandle enqueue( TCallable &&f,
+		TArgs &&...args )
+	{
+		return enqueueAfter( std::initializer_list<TaskHandle>{}, std::forward<TCallable>( f ), std::forward<TArgs>( args )... );
+	}
+
+	/// \brief	continuation; the Task is scheduled only once its dependency is done
+	template<typename TCallable, typename... TArgs>
+	TaskHandle enqueueAfter( const TaskHandle &dependency,
+		TCallable &&f,
+		TArgs &&...args )
+	{
+		return enqueueAfter( std::initializer_list<TaskHandle>{dependency}, std::forward<TCallable>( f ), std::forward<TArgs>( args )... );
+	}
 
+	/// \brief	the Task is scheduled only once all of its dependencies are done
 	template<typename TCallable, typename... TArgs>
-	void enqueue( TCallable &&f,
+	TaskHandle enqueueAfter( std::initializer_list<TaskHandle> dependencies,
+		TCallable &&f,
 		TArgs &&...args )
 	{
-		if ( m_bEnabled )
+		if ( !isEnabled() )
 		{
-			auto task = std::bind( std::move( f ), std::placeholders::_1, std::forward<TArgs>( args )... );
+			THROW_KEY_EXCEPTION( "Cannot enqueue tasks in an inactive Thread Pool!" );
+		}
+
+		Task &task = allocateTask();
+		task.emplace( std::forward<TCallable>( f ), std::forward<TArgs>( args )... );
+		const TaskHandle handle{&task, Task::getGeneration( task.m_genState.load( std::memory_order_relaxed ) )};
+		submit( task, dependencies );
+		return handle;
+	}
+
+	/// \brief	blocks until the Task is done
+	/// \brief	when called from a worker thread, other Tasks are executed in the meantime so the pool cannot deadlock on itself
+	void wait( const TaskHandle &handle );
+
+	/// \brief	calls `f( first, last )` over consecutive sub-ranges of [begin, end) of at most `grainSize` indices in parallel
+	/// \brief	blocks until the whole range has been processed; the calling thread takes part in the work
+	/// \brief	grainSize of 0 picks one based on the thread count
+	/// \brief	runs serially on the calling thread if the pool is disabled or the range is too small to split
+	template<typename TFunc>
+	void parallelFor( const std::size_t begin,
+		const std::size_t end,
+		std::size_t grainSize,
+		const TFunc &f )
+	{
+		if ( end <= begin )
+		{
+			return;
+		}
+
+		const std::size_t count = end - begin;
+		if ( grainSize == 0 )
+		{
+			grainSize = std::max<std::size_t>( 1u, count / ( ( m_nThreads + 1 ) * 4 ) );
+		}
+		const std::size_t nChunks = ( count + grainSize - 1 ) / grainSize;
+		if ( nChunks < 2 || !isEnabled() )
+		{
+			f( begin, end );
+			return;
+		}
+
+		// chunks are claimed dynamically so it does not matter how many helpers actually get to run
+		std::atomic<std::size_t> nextChunk{0};
+		auto runChunks = [&] () -> void
 			{
-				std::unique_lock<std::mutex> ul{m_mu};
-				m_tasks.emplace( std::move( task ) );
-			}
+				for ( std::size_t chunk = nextChunk.fetch_add( 1, std::memory_order_relaxed ); chunk < nChunks; chunk = nextChunk.fetch_add( 1, std::memory_order_relaxed ) )
+				{
+					const std::size_t first = begin + chunk * grainSize;
+					f( first, std::min( first + grainSize, end ) );
+				}
+			};
 
-			m_cond.notify_one();
+		const std::size_t nHelpers = std::min( nChunks - 1, m_nThreads );
+		std::array<TaskHandle, s_maxWorkers> helpers;
+		for ( std::size_t i = 0; i < nHelpers; ++i )
+		{
+			Task &task = allocateTask();
+			task.emplace( [&runChunks] ( nonstd::stop_token ) -> void
+				{
+					runChunks();
+				} );
+			helpers[i] = TaskHandle{&task, Task::getGeneration( task.m_genState.load( std::memory_order_relaxed ) )};
+			submit( task, std::initializer_list<TaskHandle>{} );
 		}
-		else
+
+		runChunks();
+
+		// helpers which haven't started yet are cancelled, the rest are finishing their last chunk
+		for ( std::size_t i = 0; i < nHelpers; ++i )
 		{
-			THROW_KEY_EXCEPTION( "Cannot enqueue tasks in an inactive Thread Pool!" );
+			cancelOrWait( helpers[i] );
 		}
 	}
 private:
 	void enable() noexcept;
 	void disable() noexcept;
 	void run();
+	void threadMain( const std::size_t workerIndex );
+	Worker* getCurrentWorker() const noexcept;
+	Task& allocateTask();
+	/// \brief	registers the dependencies of a freshly allocated Task and schedules it if they are all done
+	void submit( Task &task, std::initializer_list<TaskHandle> dependencies );
+	/// \brief	returns false if the dependency is already done
+	bool addContinuation( const TaskHandle &dependency, Task &dependent );
+	void schedule( Task &task );
+	Task* findTask( Worker *pWorker );
+	void execute( Task &task );
+	void retire( Task &task );
+	void park( Worker &worker, const std::size_t workerIndex );
+	void wakeOne() noexcept;
+	void cancelOrWait( const TaskHandle &handle );
 };
 
 
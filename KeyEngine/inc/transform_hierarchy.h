@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "non_copyable.h"
+
+
+class Node;
+
+///=============================================================
+/// \class	TransformHierarchy
+/// \author	KeyC0de
+/// \date	17/10/2026 18:05
+/// \brief	flattened transform hierarchy of a Model's Node tree
+/// \brief	Nodes are stored in pre-order, so every parent precedes its children & the subtree of node i is [i, m_subtreeEnds[i])
+/// \brief	local & world matrices live in contiguous arrays indexed by the Node's hierarchy index
+/// \brief	changing a Node's transform only flags that Node dirty; update is a single linear pass that recomputes
+/// \brief		the dirty Nodes' local matrices & the world matrices of every Node whose own or any ancestor's transform changed
+/// \brief	large hierarchies have the subtrees of the root's children updated in parallel on the ThreadPoolJ
+///=============================================================
+class TransformHierarchy final
+	: public NonCopyableAndNonMovable
+{
+	static constexpr std::size_t s_parallelThreshold = 512u;	// Nodes
+public:
+	static constexpr std::uint32_t s_noParent = 0xFFFFFFFFu;
+private:
+	std::vector<Node*> m_nodes;
+	std::vector<std::uint32_t> m_parents;
+	std::vector<std::uint32_t> m_subtreeEnds;
+	std::vector<DirectX::XMFLOAT4X4> m_localTransforms;
+	std::vector<DirectX::XMFLOAT4X4> m_worldTransforms;
+	std::vector<std::uint8_t> m_dirty;			// local transform changed since the last update
+	std::vector<std::uint8_t> m_worldChanged;	// world transform was recomputed in the current update
+public:
+	/// \brief	(re)assigns hierarchy indices to root & all its descendants; every Node starts dirty
+	void build( Node &root );
+	void markDirty( const std::uint32_t index ) noexcept;
+	void update( const float dt, const float lerpBetweenFrames, const bool bEnableSmoothMovement = false ) cond_noex;
+
+	void setLocalTransform( const std::uint32_t index, const DirectX::XMMATRIX &localTransform ) noexcept;
+	/// \brief	overrides the world transform until the Node is dirtied again
+	void setWorldTransform( const std::uint32_t index, const DirectX::XMMATRIX &worldTransform ) noexcept;
+	const DirectX::XMFLOAT4X4& getWorldTransform( const std::uint32_t index ) const noexcept;
+	std::size_t getNodeCount() const noexcept;
+private:
+	void addNode( Node &node, const std::uint32_t parentIndex );
+	/// \brief	updates nodes [first, last); their parents must precede them or already be up to date
+	void updateRange( const std::uint32_t first, const std::uint32_t last, const float dt, const float lerpBetweenFrames, const bool bEnableSmoothMovement ) cond_noex;
+};
\ No newline at end of file
@@ -64,3 +64,16 @@ public:
 private:
 	static con::RawLayout calcCbLayout();
 };
+
+/// \brief	TransformVSCB for instanced draws; every instance carries its own world transform as per-instance data
+/// \brief	so world is identity and worldView & worldViewProjection hold the view & view-projection matrices
+class InstancedTransformVSCB
+	: public TransformVSCB
+{
+public:
+	InstancedTransformVSCB( Graphics &gfx, const unsigned slot );
+
+	void bind( Graphics &gfx ) cond_noex override;
+	std::unique_ptr<IBindableCloning> clone() const noexcept override;
+	std::unique_ptr<IBindableCloning> clone() noexcept override;
+};
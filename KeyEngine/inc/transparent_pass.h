@@ -27,6 +27,8 @@ public:
 	TransparentPass( Graphics &gfx, const std::string &name );
 
 	void run( Graphics &gfx ) const cond_noex override;
+	/// \brief	also makes the active camera's matrices current for the Passes that follow
+	void bindSharedState( Graphics &gfx ) const cond_noex override;
 	void setActiveCamera( const Camera &cam ) noexcept;
 };
 
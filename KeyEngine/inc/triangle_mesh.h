@@ -11,6 +11,7 @@ struct TriangleMesh final
 
 	TriangleMesh() = default;
 	TriangleMesh( const ver::VBuffer &vertices, const std::vector<unsigned> &indices, const bool bMultimesh = false );
+	TriangleMesh( ver::VBuffer &&vertices, std::vector<unsigned> &&indices, const bool bMultimesh = false );
 
 	void transform( const DirectX::XMMATRIX &matrix );
 	void setFlatShadedIndependentNormals() cond_noex;
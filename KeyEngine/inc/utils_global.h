@@ -10,8 +10,9 @@
 // __declspec( noalias ): declares that the function does not modify memory outside the first level of indirection from the function's parameters. That is, the parameters are the only reference to the outside world the function has.
 #	define noaliasing __declspec( noalias )
 #elif defined __unix__ || defined __unix || defined __APPLE__ && defined __MACH__
-#	define restricted __restrict__
-#	define noaliasing __restrict__
+// __restrict__ only qualifies pointers, the gcc counterpart of __declspec( restrict ) on a function is __attribute__(( malloc ))
+#	define restricted __attribute__(( malloc ))
+#	define noaliasing
 #endif
 
 #define FORCE_CRASH	int *var = nullptr;\
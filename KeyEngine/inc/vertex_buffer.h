@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include "key_wrl.h"
 #include "bindable.h"
@@ -18,10 +19,15 @@ class VertexBuffer
 public:
 	VertexBuffer( Graphics &gfx, const ver::VBuffer &vb );
 	VertexBuffer( Graphics &gfx, const std::string &tag, const ver::VBuffer &vb );
+	/// \brief	uploads nVertices vertices laid out as `layout` straight from pVertices, eg. a memory mapped cooked model
+	VertexBuffer( Graphics &gfx, const std::string &tag, const ver::VertexInputLayout &layout, const void *pVertices, const std::size_t nVertices );
 
 	void bind( Graphics &gfx ) cond_noex override;
 	const ver::VertexInputLayout& getLayout() const noexcept;
 	static std::shared_ptr<VertexBuffer> fetch( Graphics &gfx, const std::string &tag, const ver::VBuffer &vb );
+	static std::shared_ptr<VertexBuffer> fetch( Graphics &gfx, const std::string &tag, const ver::VertexInputLayout &layout, const void *pVertices, const std::size_t nVertices );
+	/// \brief	the VertexBuffer fetch returns for tag if it's in the BindableRegistry already, nullptr otherwise
+	static std::shared_ptr<VertexBuffer> find( const std::string &tag );
 	template<typename... TArgsIgnored>
 	static std::string calcUid( const std::string &tag,
 		TArgsIgnored &&... )
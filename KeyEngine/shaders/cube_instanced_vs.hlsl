@@ -0,0 +1,56 @@
+#include "hlsli/globals_vscb.hlsli"
+#include "hlsli/transforms_vscb.hlsli"
+#include "hlsli/light_vscb.hlsli"
+
+
+// instanced variant of cube_vs: the world transform comes per instance, TransformsVSCB holds identity, view & view-projection
+struct VSIn
+{
+	float3 pos : Position;
+	float3 nrm : Normal;
+	float2 tc : TexCoord;
+	row_major float4x4 instanceWorld : InstanceTransform;
+};
+
+struct VSOut
+{
+	float3 viewSpacePos : PositionViewSpace;
+	float3 viewSpaceNormal : Normal;
+	float2 tc : TexCoord;
+	float4 posLightSpace[MAX_LIGHTS] : PositionLightSpace;
+	float4 pos : SV_Position;
+};
+
+VSOut main( VSIn input )
+{
+	const float4 inputPos = float4(input.pos, 1.0f);
+	const float4 worldPos = mul( inputPos, input.instanceWorld );
+
+	VSOut output;
+	output.viewSpacePos = (float3) mul( worldPos, cb_worldView );
+	output.viewSpaceNormal = mul( mul( input.nrm, (float3x3) input.instanceWorld ), (float3x3) cb_worldView );
+	output.tc = input.tc;
+	output.pos = mul( worldPos, cb_worldViewProjection );
+
+	float4 localPosLightSpace[MAX_LIGHTS];
+	int nNonPointLights = cb_nLights - cb_nPointLights;
+	int i = 0;
+	for ( i = 0; i < cb_nLights && i < MAX_LIGHTS; ++i )
+	{
+		if (i < nNonPointLights)
+		{
+			localPosLightSpace[i] = convertVertexPosToNonPointLightSpace(worldPos, cb_world, i);
+		}
+		else
+		{
+			localPosLightSpace[i] = convertVertexPosToPointLightSpace(worldPos, cb_world, i);
+		}
+	}
+	[unroll]
+	for ( i = 0; i < cb_nLights && i < MAX_LIGHTS; ++i )
+	{
+		output.posLightSpace[i] = localPosLightSpace[i];
+	}
+
+	return output;
+}
\ No newline at end of file
@@ -65,7 +65,11 @@ float3 calculateNormalMapNormal( const in float3 tangentViewSpace,
 	// sample normal map
 	const float3 normalMapNormal = normalMap.Sample( sampl, tc ).xyz;
 	// convert normal ranges from uv space[0,1] into 3d space[-1,1]
-	const float3 tangentSpaceNormal = normalMapNormal * 2.0f - 1.0f;
+	const float3 storedNormal = normalMapNormal * 2.0f - 1.0f;
+	// BC5 normal maps only store x & y & sample blue as 0, so z of their unit length normals is reconstructed; BGRA8 normal maps keep their stored z
+	const float3 tangentSpaceNormal = normalMapNormal.z > 0.0f ?
+		storedNormal :
+		float3( storedNormal.xy, sqrt( saturate( 1.0f - dot( storedNormal.xy, storedNormal.xy ) ) ) );
 	// convert normal map normals from tangent space into normal (clip) space
 	return normalize( mul( tangentSpaceNormal, tbn ) );
 }
@@ -0,0 +1,242 @@
+#include "archetype.h"
+#include <mutex>
+#include "assertions_console.h"
+#include "gameplay_exception.h"
+
+
+namespace
+{
+
+struct ComponentTypeTable final
+{
+	std::mutex m_mu;
+	ComponentTypeId m_nTypes = 0;
+	ComponentRegistry::TypeInfo m_infos[ComponentRegistry::s_maxComponentTypes];
+};
+
+ComponentTypeTable& getComponentTypeTable()
+{
+	static ComponentTypeTable table{};
+	return table;
+}
+
+std::size_t alignUp( const std::size_t offset,
+	const std::size_t alignment ) noexcept
+{
+	return ( offset + alignment - 1 ) & ~( alignment - 1 );
+}
+
+}// namespace
+
+ComponentTypeId ComponentRegistry::registerType( const TypeInfo &info )
+{
+	auto &table = getComponentTypeTable();
+	std::lock_guard<std::mutex> lg{table.m_mu};
+	if ( table.m_nTypes == s_maxComponentTypes )
+	{
+		THROW_GAMEPLAY_EXCEPTION( "Too many component types!" );
+	}
+	table.m_infos[table.m_nTypes] = info;
+	return table.m_nTypes++;
+}
+
+const ComponentRegistry::TypeInfo& ComponentRegistry::getInfo( const ComponentTypeId id ) noexcept
+{
+	// entries are written once, before their id is handed out
+	return getComponentTypeTable().m_infos[id];
+}
+
+
+void Archetype::ChunkDeleter::operator()( unsigned char *p ) const noexcept
+{
+	::operator delete[]( p, std::align_val_t{ComponentRegistry::s_maxAlignment} );
+}
+
+Archetype::Archetype( const ComponentMask mask )
+	:
+	m_mask{mask}
+{
+	for ( auto &column : m_columnOf )
+	{
+		column = -1;
+	}
+	for ( auto &edge : m_edges )
+	{
+		edge = s_noEdge;
+	}
+
+	std::size_t rowSize = sizeof( EntityId );
+	for ( ComponentTypeId id = 0; id < ComponentRegistry::s_maxComponentTypes; ++id )
+	{
+		if ( mask & ( ComponentMask{1} << id ) )
+		{
+			m_columnOf[id] = static_cast<std::int8_t>( m_componentTypes.size() );
+			m_componentTypes.push_back( id );
+			rowSize += ComponentRegistry::getInfo( id ).m_size;
+		}
+	}
+
+	// largest capacity whose columns, each aligned for its type, fit in a chunk
+	m_chunkCapacity = s_chunkSize / rowSize;
+	m_columnOffsets.resize( m_componentTypes.size() );
+	while ( true )
+	{
+		ASSERT( m_chunkCapacity > 0, "Entity too large for an Archetype chunk!" );
+		std::size_t offset = sizeof( EntityId ) * m_chunkCapacity;
+		for ( std::size_t c = 0; c < m_componentTypes.size(); ++c )
+		{
+			const auto &info = ComponentRegistry::getInfo( m_componentTypes[c] );
+			offset = alignUp( offset, info.m_alignment );
+			m_columnOffsets[c] = offset;
+			offset += info.m_size * m_chunkCapacity;
+		}
+		if ( offset <= s_chunkSize )
+		{
+			break;
+		}
+		--m_chunkCapacity;
+	}
+}
+
+Archetype::~Archetype() noexcept
+{
+	for ( std::size_t row = 0; row < m_count; ++row )
+	{
+		destroyRowComponents( static_cast<std::uint32_t>( row ) );
+	}
+}
+
+std::uint32_t Archetype::allocateRow( const EntityId id )
+{
+	if ( m_count == m_chunks.size() * m_chunkCapacity )
+	{
+		m_chunks.emplace_back( static_cast<unsigned char*>( ::operator new[]( s_chunkSize, std::align_val_t{ComponentRegistry::s_maxAlignment} ) ) );
+	}
+	const std::uint32_t row = static_cast<std::uint32_t>( m_count++ );
+	reinterpret_cast<EntityId*>( m_chunks[row / m_chunkCapacity].get() )[row % m_chunkCapacity] = id;
+	return row;
+}
+
+EntityId Archetype::removeRow( const std::uint32_t row ) noexcept
+{
+	ASSERT( row < m_count, "Invalid row!" );
+	const std::uint32_t last = static_cast<std::uint32_t>( m_count - 1 );
+	EntityId movedId = s_invalidEntityId;
+	if ( row != last )
+	{
+		for ( std::size_t c = 0; c < m_componentTypes.size(); ++c )
+		{
+			ComponentRegistry::getInfo( m_componentTypes[c] ).m_pfnRelocate( getComponentAddress( c, row ), getComponentAddress( c, last ) );
+		}
+		movedId = getEntityId( last );
+		reinterpret_cast<EntityId*>( m_chunks[row / m_chunkCapacity].get() )[row % m_chunkCapacity] = movedId;
+	}
+	--m_count;
+
+	// keep one spare chunk around so an entity bouncing on a chunk boundary doesn't allocate
+	if ( m_chunks.size() > 1 && m_count + 2 * m_chunkCapacity <= m_chunks.size() * m_chunkCapacity )
+	{
+		m_chunks.pop_back();
+	}
+	return movedId;
+}
+
+void Archetype::destroyRowComponents( const std::uint32_t row ) noexcept
+{
+	for ( std::size_t c = 0; c < m_componentTypes.size(); ++c )
+	{
+		ComponentRegistry::getInfo( m_componentTypes[c] ).m_pfnDestroy( getComponentAddress( c, row ) );
+	}
+}
+
+void Archetype::relocateRowTo( const std::uint32_t row,
+	Archetype &dst,
+	const std::uint32_t dstRow ) noexcept
+{
+	for ( std::size_t c = 0; c < m_componentTypes.size(); ++c )
+	{
+		const ComponentTypeId id = m_componentTypes[c];
+		const auto &info = ComponentRegistry::getInfo( id );
+		if ( dst.hasComponent( id ) )
+		{
+			info.m_pfnRelocate( dst.getComponent( id, dstRow ), getComponentAddress( c, row ) );
+		}
+		else
+		{
+			info.m_pfnDestroy( getComponentAddress( c, row ) );
+		}
+	}
+}
+
+bool Archetype::hasComponent( const ComponentTypeId id ) const noexcept
+{
+	return m_columnOf[id] >= 0;
+}
+
+void* Archetype::getComponent( const ComponentTypeId id,
+	const std::uint32_t row ) noexcept
+{
+	ASSERT( hasComponent( id ), "Archetype lacks this component!" );
+	return getComponentAddress( m_columnOf[id], row );
+}
+
+EntityId Archetype::getEntityId( const std::uint32_t row ) const noexcept
+{
+	return getEntityIds( row / m_chunkCapacity )[row % m_chunkCapacity];
+}
+
+ComponentMask Archetype::getMask() const noexcept
+{
+	return m_mask;
+}
+
+std::size_t Archetype::getCount() const noexcept
+{
+	return m_count;
+}
+
+std::size_t Archetype::getChunkCapacity() const noexcept
+{
+	return m_chunkCapacity;
+}
+
+std::size_t Archetype::getChunkCount() const noexcept
+{
+	return ( m_count + m_chunkCapacity - 1 ) / m_chunkCapacity;
+}
+
+std::size_t Archetype::getChunkRowCount( const std::size_t chunkIndex ) const noexcept
+{
+	const std::size_t first = chunkIndex * m_chunkCapacity;
+	return m_count - first < m_chunkCapacity ? m_count - first : m_chunkCapacity;
+}
+
+void* Archetype::getColumn( const ComponentTypeId id,
+	const std::size_t chunkIndex ) noexcept
+{
+	ASSERT( hasComponent( id ), "Archetype lacks this component!" );
+	return m_chunks[chunkIndex].get() + m_columnOffsets[m_columnOf[id]];
+}
+
+const EntityId* Archetype::getEntityIds( const std::size_t chunkIndex ) const noexcept
+{
+	return reinterpret_cast<const EntityId*>( m_chunks[chunkIndex].get() );
+}
+
+std::uint32_t Archetype::getEdge( const ComponentTypeId id ) const noexcept
+{
+	return m_edges[id];
+}
+
+void Archetype::setEdge( const ComponentTypeId id,
+	const std::uint32_t archetypeIndex ) noexcept
+{
+	m_edges[id] = archetypeIndex;
+}
+
+unsigned char* Archetype::getComponentAddress( const std::size_t column,
+	const std::uint32_t row ) noexcept
+{
+	const auto &info = ComponentRegistry::getInfo( m_componentTypes[column] );
+	return m_chunks[row / m_chunkCapacity].get() + m_columnOffsets[column] + info.m_size * ( row % m_chunkCapacity );
+}
\ No newline at end of file
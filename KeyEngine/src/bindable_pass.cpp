@@ -37,6 +37,14 @@ void IBindablePass::bind( Graphics &gfx ) const cond_noex
 	}
 }
 
+void IBindablePass::bindSharedState( Graphics &gfx ) const cond_noex
+{
+	for ( auto &b : m_bindables )
+	{
+		b->bind( gfx );
+	}
+}
+
 void IBindablePass::validate()
 {
 	IPass::validate();
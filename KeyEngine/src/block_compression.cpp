@@ -0,0 +1,1177 @@
+#include "block_compression.h"
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <immintrin.h>
+#include "thread_poolj.h"
+#include "assertions_console.h"
+
+
+namespace bc
+{
+
+namespace
+{
+
+// the interpolation weight of every index value
+constexpr float s_colorWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+constexpr float s_channelWeights[8] = {0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f};
+constexpr int s_bc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+/// \brief	a 4x4 block's channels as floats in [0,255], texel i is at row i / 4 & column i % 4
+struct Block final
+{
+	alignas( 16 ) float r[16];
+	alignas( 16 ) float g[16];
+	alignas( 16 ) float b[16];
+	alignas( 16 ) float a[16];
+};
+
+void loadBlock( const ColorBGRA *pTexels,
+	const unsigned width,
+	const unsigned height,
+	const unsigned bx,
+	const unsigned by,
+	Block &block ) noexcept
+{
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		const unsigned x = std::min( bx * 4 + i % 4, width - 1 );
+		const unsigned y = std::min( by * 4 + i / 4, height - 1 );
+		const ColorBGRA col = pTexels[static_cast<std::size_t>( y ) * width + x];
+		block.r[i] = col.getRed();
+		block.g[i] = col.getGreen();
+		block.b[i] = col.getBlue();
+		block.a[i] = col.getAlpha();
+	}
+}
+
+void store64( std::uint8_t *p,
+	const std::uint64_t bits ) noexcept
+{
+	std::memcpy( p, &bits, sizeof( bits ) );
+}
+
+std::uint64_t load64( const std::uint8_t *p ) noexcept
+{
+	std::uint64_t bits;
+	std::memcpy( &bits, p, sizeof( bits ) );
+	return bits;
+}
+
+float horizontalSum( const __m128 v ) noexcept
+{
+	alignas( 16 ) float lanes[4];
+	_mm_store_ps( lanes, v );
+	return ( lanes[0] + lanes[1] ) + ( lanes[2] + lanes[3] );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// endpoints, for any number of channels
+void calcBoundingBoxEndpoints( const float *const *ppChannels,
+	const unsigned nChannels,
+	float *pE0,
+	float *pE1 ) noexcept
+{
+	for ( unsigned c = 0; c < nChannels; ++c )
+	{
+		const auto [pMin, pMax] = std::minmax_element( ppChannels[c], ppChannels[c] + 16 );
+		// inset by 1/16th of the range, the extremes are rarely worth an endpoint each
+		const float inset = ( *pMax - *pMin ) / 16.0f;
+		pE0[c] = *pMax - inset;
+		pE1[c] = *pMin + inset;
+	}
+}
+
+/// \brief	the extremes of the texels' projection on their principal axis, which is found by power iteration on their covariance
+void calcPrincipalAxisEndpoints( const float *const *ppChannels,
+	const unsigned nChannels,
+	float *pE0,
+	float *pE1 ) noexcept
+{
+	float mean[4]{};
+	for ( unsigned c = 0; c < nChannels; ++c )
+	{
+		for ( unsigned i = 0; i < 16; ++i )
+		{
+			mean[c] += ppChannels[c][i];
+		}
+		mean[c] /= 16.0f;
+	}
+	float covariance[4][4]{};
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		for ( unsigned c0 = 0; c0 < nChannels; ++c0 )
+		{
+			for ( unsigned c1 = c0; c1 < nChannels; ++c1 )
+			{
+				covariance[c0][c1] += ( ppChannels[c0][i] - mean[c0] ) * ( ppChannels[c1][i] - mean[c1] );
+			}
+		}
+	}
+	float axis[4];
+	for ( unsigned c0 = 0; c0 < nChannels; ++c0 )
+	{
+		for ( unsigned c1 = 0; c1 < c0; ++c1 )
+		{
+			covariance[c0][c1] = covariance[c1][c0];
+		}
+		axis[c0] = 1.0f;
+	}
+	for ( int iteration = 0; iteration < 8; ++iteration )
+	{
+		float next[4]{};
+		float maxComponent = 0.0f;
+		for ( unsigned c0 = 0; c0 < nChannels; ++c0 )
+		{
+			for ( unsigned c1 = 0; c1 < nChannels; ++c1 )
+			{
+				next[c0] += covariance[c0][c1] * axis[c1];
+			}
+			maxComponent = std::max( maxComponent, std::abs( next[c0] ) );
+		}
+		if ( maxComponent < 1e-6f )
+		{
+			// (nearly) flat block
+			break;
+		}
+		for ( unsigned c = 0; c < nChannels; ++c )
+		{
+			axis[c] = next[c] / maxComponent;
+		}
+	}
+
+	float tMin = FLT_MAX;
+	float tMax = -FLT_MAX;
+	float axisLengthSq = 0.0f;
+	for ( unsigned c = 0; c < nChannels; ++c )
+	{
+		axisLengthSq += axis[c] * axis[c];
+	}
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		float t = 0.0f;
+		for ( unsigned c = 0; c < nChannels; ++c )
+		{
+			t += ( ppChannels[c][i] - mean[c] ) * axis[c];
+		}
+		tMin = std::min( tMin, t );
+		tMax = std::max( tMax, t );
+	}
+	for ( unsigned c = 0; c < nChannels; ++c )
+	{
+		pE0[c] = std::clamp( mean[c] + axis[c] * tMax / axisLengthSq, 0.0f, 255.0f );
+		pE1[c] = std::clamp( mean[c] + axis[c] * tMin / axisLengthSq, 0.0f, 255.0f );
+	}
+}
+
+/// \brief	least squares endpoints for the texels' current indices; returns false if the indices don't determine them
+bool refineEndpoints( const float *const *ppChannels,
+	const unsigned nChannels,
+	const std::uint8_t *pIndices,
+	const float *pIndexWeights,
+	float *pE0,
+	float *pE1 ) noexcept
+{
+	float aa = 0.0f;
+	float ab = 0.0f;
+	float bb = 0.0f;
+	float ax[4]{};
+	float bx[4]{};
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		const float t = pIndexWeights[pIndices[i]];
+		const float s = 1.0f - t;
+		aa += s * s;
+		ab += s * t;
+		bb += t * t;
+		for ( unsigned c = 0; c < nChannels; ++c )
+		{
+			ax[c] += s * ppChannels[c][i];
+			bx[c] += t * ppChannels[c][i];
+		}
+	}
+	const float det = aa * bb - ab * ab;
+	if ( std::abs( det ) < 1e-4f )
+	{
+		return false;
+	}
+	for ( unsigned c = 0; c < nChannels; ++c )
+	{
+		pE0[c] = std::clamp( ( bb * ax[c] - ab * bx[c] ) / det, 0.0f, 255.0f );
+		pE1[c] = std::clamp( ( aa * bx[c] - ab * ax[c] ) / det, 0.0f, 255.0f );
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// BC1 color blocks
+std::uint16_t to565( const float *pRgb ) noexcept
+{
+	const unsigned r = static_cast<unsigned>( pRgb[0] * ( 31.0f / 255.0f ) + 0.5f );
+	const unsigned g = static_cast<unsigned>( pRgb[1] * ( 63.0f / 255.0f ) + 0.5f );
+	const unsigned b = static_cast<unsigned>( pRgb[2] * ( 31.0f / 255.0f ) + 0.5f );
+	return static_cast<std::uint16_t>( r << 11 | g << 5 | b );
+}
+
+void expand565( const std::uint16_t c,
+	int *pRgb ) noexcept
+{
+	const int r = c >> 11;
+	const int g = ( c >> 5 ) & 63;
+	const int b = c & 31;
+	pRgb[0] = r << 3 | r >> 2;
+	pRgb[1] = g << 2 | g >> 4;
+	pRgb[2] = b << 3 | b >> 2;
+}
+
+/// \brief	c0, c1, 2/3 c0 + 1/3 c1 & 1/3 c0 + 2/3 c1; or in the 3 color mode c0, c1, 1/2 (c0 + c1) & transparent black
+void calcColorPalette( const std::uint16_t c0,
+	const std::uint16_t c1,
+	const bool bFourColors,
+	int palette[4][3] ) noexcept
+{
+	expand565( c0, palette[0] );
+	expand565( c1, palette[1] );
+	for ( int c = 0; c < 3; ++c )
+	{
+		if ( bFourColors )
+		{
+			palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+			palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+		}
+		else
+		{
+			palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2;
+			palette[3][c] = 0;
+		}
+	}
+}
+
+/// \brief	the nearest palette color of every texel, 4 texels at a time; returns the block's squared error
+float selectColorIndices( const Block &block,
+	const int palette[4][3],
+	std::uint8_t *pIndices ) noexcept
+{
+	__m128 pr[4];
+	__m128 pg[4];
+	__m128 pb[4];
+	for ( int k = 0; k < 4; ++k )
+	{
+		pr[k] = _mm_set1_ps( float( palette[k][0] ) );
+		pg[k] = _mm_set1_ps( float( palette[k][1] ) );
+		pb[k] = _mm_set1_ps( float( palette[k][2] ) );
+	}
+	__m128 error = _mm_setzero_ps();
+	for ( unsigned i = 0; i < 16; i += 4 )
+	{
+		const __m128 r = _mm_load_ps( block.r + i );
+		const __m128 g = _mm_load_ps( block.g + i );
+		const __m128 b = _mm_load_ps( block.b + i );
+		const auto calcDistance = [&] ( const int k ) -> __m128
+			{
+				const __m128 dr = _mm_sub_ps( r, pr[k] );
+				const __m128 dg = _mm_sub_ps( g, pg[k] );
+				const __m128 db = _mm_sub_ps( b, pb[k] );
+				return _mm_add_ps( _mm_add_ps( _mm_mul_ps( dr, dr ), _mm_mul_ps( dg, dg ) ), _mm_mul_ps( db, db ) );
+			};
+		__m128 best = calcDistance( 0 );
+		__m128i bestIndex = _mm_setzero_si128();
+		for ( int k = 1; k < 4; ++k )
+		{
+			const __m128 distance = calcDistance( k );
+			const __m128i closer = _mm_castps_si128( _mm_cmplt_ps( distance, best ) );
+			best = _mm_min_ps( best, distance );
+			bestIndex = _mm_or_si128( _mm_andnot_si128( closer, bestIndex ), _mm_and_si128( closer, _mm_set1_epi32( k ) ) );
+		}
+		error = _mm_add_ps( error, best );
+		alignas( 16 ) std::int32_t indices[4];
+		_mm_store_si128( reinterpret_cast<__m128i*>( indices ), bestIndex );
+		for ( unsigned j = 0; j < 4; ++j )
+		{
+			pIndices[i + j] = static_cast<std::uint8_t>( indices[j] );
+		}
+	}
+	return horizontalSum( error );
+}
+
+/// \brief	for every 8bit value the 5 & 6 bit endpoint pairs whose 2/3 e0 + 1/3 e1 interpolant lands closest to it
+/// \brief	so that flat blocks aren't limited to 565's precision
+struct SingleColorTables final
+{
+	std::uint8_t endpoints5[256][2];
+	std::uint8_t endpoints6[256][2];
+
+	SingleColorTables() noexcept
+	{
+		fill( 5, endpoints5 );
+		fill( 6, endpoints6 );
+	}
+
+	static void fill( const int nBits,
+		std::uint8_t table[256][2] ) noexcept
+	{
+		const int nValues = 1 << nBits;
+		const auto expand = [nBits] ( const int q ) -> int
+			{
+				return q << ( 8 - nBits ) | q >> ( 2 * nBits - 8 );
+			};
+		for ( int v = 0; v < 256; ++v )
+		{
+			int bestError = INT_MAX;
+			for ( int q0 = 0; q0 < nValues; ++q0 )
+			{
+				for ( int q1 = 0; q1 < nValues; ++q1 )
+				{
+					const int e0 = expand( q0 );
+					const int e1 = expand( q1 );
+					// of equally close pairs the one with the closest endpoints is the least sensitive to the GPU's interpolation
+					const int error = std::abs( ( 2 * e0 + e1 ) / 3 - v ) * 256 + std::abs( e0 - e1 );
+					if ( error < bestError )
+					{
+						bestError = error;
+						table[v][0] = static_cast<std::uint8_t>( q0 );
+						table[v][1] = static_cast<std::uint8_t>( q1 );
+					}
+				}
+			}
+		}
+	}
+};
+
+bool isFlatColorBlock( const Block &block ) noexcept
+{
+	for ( unsigned i = 1; i < 16; ++i )
+	{
+		if ( block.r[i] != block.r[0] || block.g[i] != block.g[0] || block.b[i] != block.b[0] )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::uint64_t encodeFlatColorBlock( const Block &block ) noexcept
+{
+	static const SingleColorTables s_tables;
+	const int r = static_cast<int>( block.r[0] );
+	const int g = static_cast<int>( block.g[0] );
+	const int b = static_cast<int>( block.b[0] );
+	std::uint16_t c0 = static_cast<std::uint16_t>( s_tables.endpoints5[r][0] << 11 | s_tables.endpoints6[g][0] << 5 | s_tables.endpoints5[b][0] );
+	std::uint16_t c1 = static_cast<std::uint16_t>( s_tables.endpoints5[r][1] << 11 | s_tables.endpoints6[g][1] << 5 | s_tables.endpoints5[b][1] );
+	// every texel is 2/3 c0 + 1/3 c1, which is index 3 once they're swapped to keep the 4 color mode
+	std::uint64_t index = 2;
+	if ( c0 < c1 )
+	{
+		std::swap( c0, c1 );
+		index = 3;
+	}
+	else if ( c0 == c1 )
+	{
+		index = 0;
+	}
+	return c0 | static_cast<std::uint64_t>( c1 ) << 16 | ( index * 0x55555555ull ) << 32;
+}
+
+/// \brief	quantizes the endpoints, c0 > c1 keeps BC1 in its 4 color mode, & picks the indices
+std::uint64_t packColorBlock( const Block &block,
+	const float *pE0,
+	const float *pE1,
+	std::uint8_t *pIndices,
+	float &error ) noexcept
+{
+	std::uint16_t c0 = to565( pE0 );
+	std::uint16_t c1 = to565( pE1 );
+	if ( c0 < c1 )
+	{
+		std::swap( c0, c1 );
+	}
+	// c0 == c1 makes all 4 palette entries equal, so every index is 0 whatever mode it's decoded in
+	int palette[4][3];
+	calcColorPalette( c0, c1, true, palette );
+	error = selectColorIndices( block, palette, pIndices );
+
+	std::uint64_t indexBits = 0;
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		indexBits |= static_cast<std::uint64_t>( pIndices[i] ) << ( 2 * i );
+	}
+	return c0 | static_cast<std::uint64_t>( c1 ) << 16 | indexBits << 32;
+}
+
+std::uint64_t encodeColorBlock( const Block &block,
+	const Quality quality ) noexcept
+{
+	if ( isFlatColorBlock( block ) )
+	{
+		return encodeFlatColorBlock( block );
+	}
+
+	const float *channels[3] = {block.r, block.g, block.b};
+	float e0[3];
+	float e1[3];
+	if ( quality == Quality::Fast )
+	{
+		calcBoundingBoxEndpoints( channels, 3u, e0, e1 );
+	}
+	else
+	{
+		calcPrincipalAxisEndpoints( channels, 3u, e0, e1 );
+	}
+
+	std::uint8_t indices[16];
+	float error;
+	std::uint64_t bits = packColorBlock( block, e0, e1, indices, error );
+	const int nRefinements = quality == Quality::Fast ?
+		0 :
+		( quality == Quality::Normal ? 1 : 8 );
+	for ( int i = 0; i < nRefinements && error > 0.0f; ++i )
+	{
+		// the indices refer to the endpoints as packed, so refine those
+		int palette[4][3];
+		calcColorPalette( static_cast<std::uint16_t>( bits ), static_cast<std::uint16_t>( bits >> 16 ), true, palette );
+		for ( int c = 0; c < 3; ++c )
+		{
+			e0[c] = float( palette[0][c] );
+			e1[c] = float( palette[1][c] );
+		}
+		if ( !refineEndpoints( channels, 3u, indices, s_colorWeights, e0, e1 ) )
+		{
+			break;
+		}
+		std::uint8_t refinedIndices[16];
+		float refinedError;
+		const std::uint64_t refinedBits = packColorBlock( block, e0, e1, refinedIndices, refinedError );
+		if ( refinedError >= error )
+		{
+			break;
+		}
+		bits = refinedBits;
+		error = refinedError;
+		std::memcpy( indices, refinedIndices, sizeof( indices ) );
+	}
+	return bits;
+}
+
+void decodeColorBlock( const std::uint8_t *pBlock,
+	const bool bAlwaysFourColors,
+	ColorBGRA *pTexels ) noexcept
+{
+	const std::uint64_t bits = load64( pBlock );
+	const auto c0 = static_cast<std::uint16_t>( bits );
+	const auto c1 = static_cast<std::uint16_t>( bits >> 16 );
+	const bool bFourColors = bAlwaysFourColors || c0 > c1;
+	int palette[4][3];
+	calcColorPalette( c0, c1, bFourColors, palette );
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		const unsigned index = ( bits >> ( 32 + 2 * i ) ) & 3;
+		const Byte alpha = !bFourColors && index == 3 ?
+			0 :
+			255;
+		pTexels[i] = ColorBGRA{static_cast<Byte>( palette[index][0] ), static_cast<Byte>( palette[index][1] ), static_cast<Byte>( palette[index][2] ), alpha};
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// BC4 channel blocks, also BC3's alpha & BC5's halves
+/// \brief	e0 > e1: e0, e1 & 6 values in between; otherwise e0, e1, 4 values in between, 0 & 255
+void calcChannelPalette( const int e0,
+	const int e1,
+	int palette[8] ) noexcept
+{
+	palette[0] = e0;
+	palette[1] = e1;
+	if ( e0 > e1 )
+	{
+		for ( int k = 1; k <= 6; ++k )
+		{
+			palette[k + 1] = ( ( 7 - k ) * e0 + k * e1 + 3 ) / 7;
+		}
+	}
+	else
+	{
+		for ( int k = 1; k <= 4; ++k )
+		{
+			palette[k + 1] = ( ( 5 - k ) * e0 + k * e1 + 2 ) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+std::uint64_t packChannelBlock( const float *pValues,
+	const int e0,
+	const int e1,
+	std::uint8_t *pIndices,
+	float &error ) noexcept
+{
+	int palette[8];
+	calcChannelPalette( e0, e1, palette );
+	// the 8 value mode's palette is ordered e0, 2..7, e1: the texels' projections on it only need their rounding checked
+	static constexpr std::uint8_t s_orderedIndices[8] = {0, 2, 3, 4, 5, 6, 7, 1};
+	const float scale = e0 > e1 ?
+		7.0f / float( e1 - e0 ) :
+		0.0f;
+	error = 0.0f;
+	std::uint64_t indexBits = 0;
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		float best = FLT_MAX;
+		if ( e0 > e1 )
+		{
+			const int position = std::clamp( static_cast<int>( ( pValues[i] - float( e0 ) ) * scale + 0.5f ), 0, 7 );
+			for ( int p = std::max( position - 1, 0 ); p <= std::min( position + 1, 7 ); ++p )
+			{
+				const float d = pValues[i] - float( palette[s_orderedIndices[p]] );
+				if ( d * d < best )
+				{
+					best = d * d;
+					pIndices[i] = s_orderedIndices[p];
+				}
+			}
+		}
+		else
+		{
+			for ( std::uint8_t k = 0; k < 8; ++k )
+			{
+				const float d = pValues[i] - float( palette[k] );
+				if ( d * d < best )
+				{
+					best = d * d;
+					pIndices[i] = k;
+				}
+			}
+		}
+		error += best;
+		indexBits |= static_cast<std::uint64_t>( pIndices[i] ) << ( 3 * i );
+	}
+	return static_cast<std::uint64_t>( e0 ) | static_cast<std::uint64_t>( e1 ) << 8 | indexBits << 16;
+}
+
+std::uint64_t encodeChannelBlock( const float *pValues,
+	const Quality quality ) noexcept
+{
+	const auto [pMin, pMax] = std::minmax_element( pValues, pValues + 16 );
+	const int minValue = static_cast<int>( *pMin );
+	const int maxValue = static_cast<int>( *pMax );
+
+	std::uint8_t indices[16];
+	float error;
+	std::uint64_t bits = packChannelBlock( pValues, maxValue, minValue, indices, error );
+	if ( quality == Quality::Fast || error == 0.0f )
+	{
+		return bits;
+	}
+
+	// the 6 value mode spends its interpolants on the texels that aren't 0 or 255
+	int innerMin = 255;
+	int innerMax = 0;
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		const int v = static_cast<int>( pValues[i] );
+		if ( v != 0 && v != 255 )
+		{
+			innerMin = std::min( innerMin, v );
+			innerMax = std::max( innerMax, v );
+		}
+	}
+	if ( innerMin <= innerMax && ( minValue == 0 || maxValue == 255 ) )
+	{
+		std::uint8_t innerIndices[16];
+		float innerError;
+		const std::uint64_t innerBits = packChannelBlock( pValues, innerMin, innerMax, innerIndices, innerError );
+		if ( innerError < error )
+		{
+			bits = innerBits;
+			error = innerError;
+			std::memcpy( indices, innerIndices, sizeof( indices ) );
+		}
+	}
+
+	const int nRefinements = quality == Quality::Normal ?
+		1 :
+		4;
+	const float *channels[1] = {pValues};
+	for ( int i = 0; i < nRefinements && error > 0.0f; ++i )
+	{
+		float e0 = float( bits & 0xFF );
+		float e1 = float( ( bits >> 8 ) & 0xFF );
+		// only the 8 value mode's weights are linear in the endpoints
+		if ( e0 <= e1 || !refineEndpoints( channels, 1u, indices, s_channelWeights, &e0, &e1 ) )
+		{
+			break;
+		}
+		const int refinedE0 = static_cast<int>( e0 + 0.5f );
+		const int refinedE1 = static_cast<int>( e1 + 0.5f );
+		if ( refinedE0 <= refinedE1 )
+		{
+			break;
+		}
+		std::uint8_t refinedIndices[16];
+		float refinedError;
+		const std::uint64_t refinedBits = packChannelBlock( pValues, refinedE0, refinedE1, refinedIndices, refinedError );
+		if ( refinedError >= error )
+		{
+			break;
+		}
+		bits = refinedBits;
+		error = refinedError;
+		std::memcpy( indices, refinedIndices, sizeof( indices ) );
+	}
+	return bits;
+}
+
+void decodeChannelBlock( const std::uint8_t *pBlock,
+	Byte *pValues ) noexcept
+{
+	const std::uint64_t bits = load64( pBlock );
+	int palette[8];
+	calcChannelPalette( static_cast<int>( bits & 0xFF ), static_cast<int>( ( bits >> 8 ) & 0xFF ), palette );
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		pValues[i] = static_cast<Byte>( palette[( bits >> ( 16 + 3 * i ) ) & 7] );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// BC7 mode 6 blocks
+class BitWriter final
+{
+	std::uint8_t *m_p;
+	unsigned m_pos = 0;
+public:
+	BitWriter( std::uint8_t *p ) noexcept
+		:
+		m_p{p}
+	{
+		std::memset( m_p, 0, 16 );
+	}
+
+	void write( const unsigned value,
+		const unsigned nBits ) noexcept
+	{
+		for ( unsigned i = 0; i < nBits; ++i, ++m_pos )
+		{
+			m_p[m_pos >> 3] |= static_cast<std::uint8_t>( ( ( value >> i ) & 1u ) << ( m_pos & 7 ) );
+		}
+	}
+};
+
+class BitReader final
+{
+	const std::uint8_t *m_p;
+	unsigned m_pos = 0;
+public:
+	BitReader( const std::uint8_t *p ) noexcept
+		:
+		m_p{p}
+	{
+
+	}
+
+	unsigned read( const unsigned nBits ) noexcept
+	{
+		unsigned value = 0;
+		for ( unsigned i = 0; i < nBits; ++i, ++m_pos )
+		{
+			value |= ( ( m_p[m_pos >> 3] >> ( m_pos & 7 ) ) & 1u ) << i;
+		}
+		return value;
+	}
+};
+
+/// \brief	7 bits per channel & a shared pbit as the lowest bit, the pbit which lands closer to e is chosen
+void quantizeBc7Endpoint( const float *pE,
+	unsigned *pQuantized,
+	unsigned &pbit,
+	int *pValues ) noexcept
+{
+	float bestError = FLT_MAX;
+	for ( unsigned p = 0; p < 2; ++p )
+	{
+		unsigned quantized[4];
+		float error = 0.0f;
+		for ( int c = 0; c < 4; ++c )
+		{
+			quantized[c] = static_cast<unsigned>( std::clamp( static_cast<int>( std::lround( ( pE[c] - p ) / 2.0f ) ), 0, 127 ) );
+			const float d = float( quantized[c] << 1 | p ) - pE[c];
+			error += d * d;
+		}
+		if ( error < bestError )
+		{
+			bestError = error;
+			pbit = p;
+			for ( int c = 0; c < 4; ++c )
+			{
+				pQuantized[c] = quantized[c];
+				pValues[c] = static_cast<int>( quantized[c] << 1 | p );
+			}
+		}
+	}
+}
+
+void calcBc7Palette( const int *pV0,
+	const int *pV1,
+	int palette[16][4] ) noexcept
+{
+	for ( int k = 0; k < 16; ++k )
+	{
+		for ( int c = 0; c < 4; ++c )
+		{
+			palette[k][c] = ( ( 64 - s_bc7Weights[k] ) * pV0[c] + s_bc7Weights[k] * pV1[c] + 32 ) >> 6;
+		}
+	}
+}
+
+/// \brief	every texel against all 16 palette entries, 4 entries at a time
+float selectBc7Indices( const Block &block,
+	const int palette[16][4],
+	std::uint8_t *pIndices ) noexcept
+{
+	alignas( 16 ) float pr[16];
+	alignas( 16 ) float pg[16];
+	alignas( 16 ) float pb[16];
+	alignas( 16 ) float pa[16];
+	for ( int k = 0; k < 16; ++k )
+	{
+		pr[k] = float( palette[k][0] );
+		pg[k] = float( palette[k][1] );
+		pb[k] = float( palette[k][2] );
+		pa[k] = float( palette[k][3] );
+	}
+	float error = 0.0f;
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		const __m128 r = _mm_set1_ps( block.r[i] );
+		const __m128 g = _mm_set1_ps( block.g[i] );
+		const __m128 b = _mm_set1_ps( block.b[i] );
+		const __m128 a = _mm_set1_ps( block.a[i] );
+		__m128 best = _mm_set1_ps( FLT_MAX );
+		__m128i bestIndex = _mm_setzero_si128();
+		for ( int k = 0; k < 16; k += 4 )
+		{
+			const __m128 dr = _mm_sub_ps( r, _mm_load_ps( pr + k ) );
+			const __m128 dg = _mm_sub_ps( g, _mm_load_ps( pg + k ) );
+			const __m128 db = _mm_sub_ps( b, _mm_load_ps( pb + k ) );
+			const __m128 da = _mm_sub_ps( a, _mm_load_ps( pa + k ) );
+			const __m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dr, dr ), _mm_mul_ps( dg, dg ) ), _mm_add_ps( _mm_mul_ps( db, db ), _mm_mul_ps( da, da ) ) );
+			const __m128i closer = _mm_castps_si128( _mm_cmplt_ps( distance, best ) );
+			best = _mm_min_ps( best, distance );
+			bestIndex = _mm_or_si128( _mm_andnot_si128( closer, bestIndex ), _mm_and_si128( closer, _mm_setr_epi32( k, k + 1, k + 2, k + 3 ) ) );
+		}
+		alignas( 16 ) float distances[4];
+		alignas( 16 ) std::int32_t indices[4];
+		_mm_store_ps( distances, best );
+		_mm_store_si128( reinterpret_cast<__m128i*>( indices ), bestIndex );
+		unsigned lane = 0;
+		for ( unsigned j = 1; j < 4; ++j )
+		{
+			if ( distances[j] < distances[lane] || ( distances[j] == distances[lane] && indices[j] < indices[lane] ) )
+			{
+				lane = j;
+			}
+		}
+		pIndices[i] = static_cast<std::uint8_t>( indices[lane] );
+		error += distances[lane];
+	}
+	return error;
+}
+
+/// \brief	Fast quality: each texel's index from its projection on the endpoints' segment
+float projectBc7Indices( const Block &block,
+	const int *pV0,
+	const int *pV1,
+	const int palette[16][4],
+	std::uint8_t *pIndices ) noexcept
+{
+	float d[4];
+	float lengthSq = 0.0f;
+	for ( int c = 0; c < 4; ++c )
+	{
+		d[c] = float( pV1[c] - pV0[c] );
+		lengthSq += d[c] * d[c];
+	}
+	const float *channels[4] = {block.r, block.g, block.b, block.a};
+	float error = 0.0f;
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		float t = 0.0f;
+		for ( int c = 0; c < 4; ++c )
+		{
+			t += ( channels[c][i] - pV0[c] ) * d[c];
+		}
+		const float weight = lengthSq > 0.0f ?
+			std::clamp( t / lengthSq, 0.0f, 1.0f ) * 64.0f :
+			0.0f;
+		std::uint8_t index = 0;
+		while ( index < 15 && float( s_bc7Weights[index + 1] + s_bc7Weights[index] ) * 0.5f < weight )
+		{
+			++index;
+		}
+		pIndices[i] = index;
+		for ( int c = 0; c < 4; ++c )
+		{
+			const float diff = channels[c][i] - float( palette[index][c] );
+			error += diff * diff;
+		}
+	}
+	return error;
+}
+
+struct Bc7Candidate final
+{
+	unsigned quantized[2][4];
+	unsigned pbits[2];
+	int values[2][4];
+	std::uint8_t indices[16];
+	float error;
+};
+
+void evalBc7Candidate( const Block &block,
+	const float *pE0,
+	const float *pE1,
+	const Quality quality,
+	Bc7Candidate &candidate ) noexcept
+{
+	quantizeBc7Endpoint( pE0, candidate.quantized[0], candidate.pbits[0], candidate.values[0] );
+	quantizeBc7Endpoint( pE1, candidate.quantized[1], candidate.pbits[1], candidate.values[1] );
+	int palette[16][4];
+	calcBc7Palette( candidate.values[0], candidate.values[1], palette );
+	candidate.error = quality == Quality::Fast ?
+		projectBc7Indices( block, candidate.values[0], candidate.values[1], palette, candidate.indices ) :
+		selectBc7Indices( block, palette, candidate.indices );
+}
+
+void encodeBc7Block( const Block &block,
+	const Quality quality,
+	std::uint8_t *pOut ) noexcept
+{
+	const float *channels[4] = {block.r, block.g, block.b, block.a};
+	float e0[4];
+	float e1[4];
+	if ( quality == Quality::Fast )
+	{
+		calcBoundingBoxEndpoints( channels, 4u, e0, e1 );
+	}
+	else
+	{
+		calcPrincipalAxisEndpoints( channels, 4u, e0, e1 );
+	}
+
+	Bc7Candidate best;
+	evalBc7Candidate( block, e0, e1, quality, best );
+	const int nRefinements = quality == Quality::Fast ?
+		0 :
+		( quality == Quality::Normal ? 1 : 6 );
+	float weights[16];
+	for ( int k = 0; k < 16; ++k )
+	{
+		weights[k] = s_bc7Weights[k] / 64.0f;
+	}
+	for ( int i = 0; i < nRefinements && best.error > 0.0f; ++i )
+	{
+		if ( !refineEndpoints( channels, 4u, best.indices, weights, e0, e1 ) )
+		{
+			break;
+		}
+		Bc7Candidate refined;
+		evalBc7Candidate( block, e0, e1, quality, refined );
+		if ( refined.error >= best.error )
+		{
+			break;
+		}
+		best = refined;
+	}
+
+	// the anchor (texel 0) index is stored without its top bit, so it must be < 8; the weights are symmetric so swapping the endpoints mirrors the indices
+	if ( best.indices[0] >= 8 )
+	{
+		for ( int c = 0; c < 4; ++c )
+		{
+			std::swap( best.quantized[0][c], best.quantized[1][c] );
+		}
+		std::swap( best.pbits[0], best.pbits[1] );
+		for ( auto &index : best.indices )
+		{
+			index = static_cast<std::uint8_t>( 15 - index );
+		}
+	}
+
+	BitWriter writer{pOut};
+	writer.write( 1u << 6, 7u );
+	for ( int c = 0; c < 4; ++c )
+	{
+		writer.write( best.quantized[0][c], 7u );
+		writer.write( best.quantized[1][c], 7u );
+	}
+	writer.write( best.pbits[0], 1u );
+	writer.write( best.pbits[1], 1u );
+	writer.write( best.indices[0], 3u );
+	for ( unsigned i = 1; i < 16; ++i )
+	{
+		writer.write( best.indices[i], 4u );
+	}
+}
+
+/// \brief	mode 6 only, other modes decode to transparent black like reserved modes do
+void decodeBc7Block( const std::uint8_t *pBlock,
+	ColorBGRA *pTexels ) noexcept
+{
+	BitReader reader{pBlock};
+	if ( reader.read( 7u ) != 1u << 6 )
+	{
+		std::fill_n( pTexels, 16, ColorBGRA{0u} );
+		return;
+	}
+	int quantized[2][4];
+	for ( int c = 0; c < 4; ++c )
+	{
+		quantized[0][c] = static_cast<int>( reader.read( 7u ) );
+		quantized[1][c] = static_cast<int>( reader.read( 7u ) );
+	}
+	const int pbits[2] = {static_cast<int>( reader.read( 1u ) ), static_cast<int>( reader.read( 1u ) )};
+	int values[2][4];
+	for ( int e = 0; e < 2; ++e )
+	{
+		for ( int c = 0; c < 4; ++c )
+		{
+			values[e][c] = quantized[e][c] << 1 | pbits[e];
+		}
+	}
+	int palette[16][4];
+	calcBc7Palette( values[0], values[1], palette );
+	for ( unsigned i = 0; i < 16; ++i )
+	{
+		const unsigned index = reader.read( i == 0 ? 3u : 4u );
+		pTexels[i] = ColorBGRA{static_cast<Byte>( palette[index][0] ), static_cast<Byte>( palette[index][1] ), static_cast<Byte>( palette[index][2] ), static_cast<Byte>( palette[index][3] )};
+	}
+}
+
+
+}//namespace
+
+Format chooseFormat( const Usage usage,
+	const bool bAlpha,
+	const Quality quality ) noexcept
+{
+	switch ( usage )
+	{
+	case Usage::NormalMap:
+		return Format::BC5;
+	case Usage::Mask:
+		return Format::BC4;
+	default:
+		if ( quality == Quality::High )
+		{
+			return Format::BC7;
+		}
+		return bAlpha ?
+			Format::BC3 :
+			Format::BC1;
+	}
+}
+
+bool isCompressed( const Format format ) noexcept
+{
+	return format != Format::BGRA8;
+}
+
+unsigned getBlockSize( const Format format ) noexcept
+{
+	switch ( format )
+	{
+	case Format::BC1:
+	case Format::BC4:
+		return 8u;
+	case Format::BC3:
+	case Format::BC5:
+	case Format::BC7:
+		return 16u;
+	default:
+		return static_cast<unsigned>( sizeof( ColorBGRA ) );
+	}
+}
+
+std::size_t calcRowPitch( const unsigned width,
+	const Format format ) noexcept
+{
+	return isCompressed( format ) ?
+		static_cast<std::size_t>( ( width + 3 ) / 4 ) * getBlockSize( format ) :
+		static_cast<std::size_t>( width ) * getBlockSize( format );
+}
+
+std::size_t calcSize( const unsigned width,
+	const unsigned height,
+	const Format format ) noexcept
+{
+	return calcRowPitch( width, format ) * ( isCompressed( format ) ?
+		( height + 3 ) / 4 :
+		height );
+}
+
+void encode( const ColorBGRA *pTexels,
+	const unsigned width,
+	const unsigned height,
+	const Format format,
+	const Quality quality,
+	std::uint8_t *pBlocks )
+{
+	if ( !isCompressed( format ) )
+	{
+		std::memcpy( pBlocks, pTexels, calcSize( width, height, format ) );
+		return;
+	}
+
+	const unsigned nBlocksX = ( width + 3 ) / 4;
+	const unsigned blockSize = getBlockSize( format );
+	ThreadPoolJ::getInstance().parallelFor( 0u, ( height + 3 ) / 4, 0u,
+		[&] ( const std::size_t first, const std::size_t last )
+		{
+			Block block;
+			for ( std::size_t by = first; by < last; ++by )
+			{
+				std::uint8_t *pOut = pBlocks + by * nBlocksX * blockSize;
+				for ( unsigned bx = 0; bx < nBlocksX; ++bx, pOut += blockSize )
+				{
+					loadBlock( pTexels, width, height, bx, static_cast<unsigned>( by ), block );
+					switch ( format )
+					{
+					case Format::BC1:
+						store64( pOut, encodeColorBlock( block, quality ) );
+						break;
+					case Format::BC3:
+						store64( pOut, encodeChannelBlock( block.a, quality ) );
+						store64( pOut + 8, encodeColorBlock( block, quality ) );
+						break;
+					case Format::BC4:
+						store64( pOut, encodeChannelBlock( block.r, quality ) );
+						break;
+					case Format::BC5:
+						store64( pOut, encodeChannelBlock( block.r, quality ) );
+						store64( pOut + 8, encodeChannelBlock( block.g, quality ) );
+						break;
+					case Format::BC7:
+						encodeBc7Block( block, quality, pOut );
+						break;
+					default:
+						ASSERT( false, "Unknown block compression format!" );
+					}
+				}
+			}
+		} );
+}
+
+void decode( const std::uint8_t *pBlocks,
+	const unsigned width,
+	const unsigned height,
+	const Format format,
+	ColorBGRA *pTexels )
+{
+	if ( !isCompressed( format ) )
+	{
+		std::memcpy( pTexels, pBlocks, calcSize( width, height, format ) );
+		return;
+	}
+
+	const unsigned nBlocksX = ( width + 3 ) / 4;
+	const unsigned nBlocksY = ( height + 3 ) / 4;
+	const unsigned blockSize = getBlockSize( format );
+	for ( unsigned by = 0; by < nBlocksY; ++by )
+	{
+		for ( unsigned bx = 0; bx < nBlocksX; ++bx )
+		{
+			const std::uint8_t *pBlock = pBlocks + ( static_cast<std::size_t>( by ) * nBlocksX + bx ) * blockSize;
+			ColorBGRA texels[16];
+			Byte reds[16];
+			Byte greens[16];
+			switch ( format )
+			{
+			case Format::BC1:
+				decodeColorBlock( pBlock, false, texels );
+				break;
+			case Format::BC3:
+				decodeColorBlock( pBlock + 8, true, texels );
+				decodeChannelBlock( pBlock, reds );
+				for ( unsigned i = 0; i < 16; ++i )
+				{
+					texels[i] = ColorBGRA{texels[i].getRed(), texels[i].getGreen(), texels[i].getBlue(), reds[i]};
+				}
+				break;
+			case Format::BC4:
+				decodeChannelBlock( pBlock, reds );
+				for ( unsigned i = 0; i < 16; ++i )
+				{
+					texels[i] = ColorBGRA{reds[i], 0, 0, 255};
+				}
+				break;
+			case Format::BC5:
+				decodeChannelBlock( pBlock, reds );
+				decodeChannelBlock( pBlock + 8, greens );
+				for ( unsigned i = 0; i < 16; ++i )
+				{
+					texels[i] = ColorBGRA{reds[i], greens[i], 0, 255};
+				}
+				break;
+			case Format::BC7:
+				decodeBc7Block( pBlock, texels );
+				break;
+			default:
+				ASSERT( false, "Unknown block compression format!" );
+			}
+
+			for ( unsigned i = 0; i < 16; ++i )
+			{
+				const unsigned x = bx * 4 + i % 4;
+				const unsigned y = by * 4 + i / 4;
+				if ( x < width && y < height )
+				{
+					pTexels[static_cast<std::size_t>( y ) * width + x] = texels[i];
+				}
+			}
+		}
+	}
+}
+
+double calcPsnr( const ColorBGRA *pA,
+	const ColorBGRA *pB,
+	const std::size_t nTexels,
+	const Format format ) noexcept
+{
+	// byte shifts of the kept channels within the BGRA dword
+	unsigned shifts[4] = {16u, 8u, 0u, 24u};
+	unsigned nChannels = 4u;
+	switch ( format )
+	{
+	case Format::BC1:
+		nChannels = 3u;
+		break;
+	case Format::BC4:
+		nChannels = 1u;
+		break;
+	case Format::BC5:
+		nChannels = 2u;
+		break;
+	default:
+		break;
+	}
+	double sumSq = 0.0;
+	for ( std::size_t i = 0; i < nTexels; ++i )
+	{
+		for ( unsigned c = 0; c < nChannels; ++c )
+		{
+			const double d = double( ( pA[i].m_dword >> shifts[c] ) & 0xFF ) - double( ( pB[i].m_dword >> shifts[c] ) & 0xFF );
+			sumSq += d * d;
+		}
+	}
+	const double mse = sumSq / ( double( nTexels ) * nChannels );
+	return mse == 0.0 ?
+		std::numeric_limits<double>::infinity() :
+		10.0 * std::log10( 255.0 * 255.0 / mse );
+}
+
+
+}//namespace bc
\ No newline at end of file
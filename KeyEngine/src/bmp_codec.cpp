@@ -0,0 +1,610 @@
+#include "bmp_codec.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <immintrin.h>
+#include "utils.h"
+#include "cpu_features.h"
+#include "util_exception.h"
+#include "assertions_console.h"
+
+
+namespace bmp
+{
+
+namespace
+{
+
+constexpr std::size_t s_fileHeaderSize = 14u;
+constexpr std::size_t s_infoHeaderSize = 40u;
+constexpr std::uint32_t s_compressionRgb = 0u;
+constexpr std::uint32_t s_compressionBitfields = 3u;
+constexpr std::uint32_t s_compressionAlphaBitfields = 6u;
+constexpr std::uint32_t s_pixelsPerMeter = 0x0B13;	// 72 dpi
+
+std::uint16_t readU16( const std::uint8_t *p ) noexcept
+{
+	return static_cast<std::uint16_t>( p[0] | ( p[1] << 8 ) );
+}
+
+std::uint32_t readU32( const std::uint8_t *p ) noexcept
+{
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( static_cast<std::uint32_t>( p[3] ) << 24 );
+}
+
+void writeU16( std::uint8_t *p,
+	const std::uint16_t value ) noexcept
+{
+	p[0] = static_cast<std::uint8_t>( value );
+	p[1] = static_cast<std::uint8_t>( value >> 8 );
+}
+
+void writeU32( std::uint8_t *p,
+	const std::uint32_t value ) noexcept
+{
+	p[0] = static_cast<std::uint8_t>( value );
+	p[1] = static_cast<std::uint8_t>( value >> 8 );
+	p[2] = static_cast<std::uint8_t>( value >> 16 );
+	p[3] = static_cast<std::uint8_t>( value >> 24 );
+}
+
+unsigned countTrailingZeros( std::uint32_t mask ) noexcept
+{
+	if ( mask == 0 )
+	{
+		return 0;
+	}
+	unsigned n = 0;
+	while ( ( mask & 1u ) == 0 )
+	{
+		mask >>= 1;
+		++n;
+	}
+	return n;
+}
+
+unsigned countBits( std::uint32_t mask ) noexcept
+{
+	unsigned n = 0;
+	while ( mask != 0 )
+	{
+		mask &= mask - 1;
+		++n;
+	}
+	return n;
+}
+
+/// \brief	expands an nBits wide value to 8 bits by repeating its bits, so 0 maps to 0 & the maximum to 255
+unsigned expandTo8Bits( const unsigned value,
+	const unsigned nBits ) noexcept
+{
+	if ( nBits >= 8 )
+	{
+		return value >> ( nBits - 8 );
+	}
+
+	unsigned result = 0;
+	for ( int shift = 8 - static_cast<int>( nBits ); shift > -static_cast<int>( nBits ); shift -= nBits )
+	{
+		result |= shift >= 0 ?
+			value << shift :
+			value >> -shift;
+	}
+	return result & 0xFFu;
+}
+
+void decodeRow24( const std::uint8_t *pRow,
+	ColorBGRA *pOut,
+	const unsigned width ) noexcept
+{
+	unsigned x = 0;
+	if ( util::getCpuFeatures().bSsse3 )
+	{
+		// BGR BGR BGR BGR -> BGRA BGRA BGRA BGRA; the 16 byte loads stay inside the row's 3 * width bytes
+		const __m128i shuffle = _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+		const __m128i alpha = _mm_set1_epi32( 0xFF000000 );
+		for ( ; x + 6 <= width; x += 4 )
+		{
+			const __m128i bgr = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow + 3 * x ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pOut + x ), _mm_or_si128( _mm_shuffle_epi8( bgr, shuffle ), alpha ) );
+		}
+	}
+	for ( ; x < width; ++x )
+	{
+		const std::uint8_t *p = pRow + 3 * x;
+		pOut[x] = ColorBGRA{0xFF000000u | ( p[2] << 16 ) | ( p[1] << 8 ) | p[0]};
+	}
+}
+
+void encodeRow24( const ColorBGRA *pRow,
+	std::uint8_t *pOut,
+	const unsigned width ) noexcept
+{
+	unsigned x = 0;
+	if ( util::getCpuFeatures().bSsse3 )
+	{
+		// BGRA BGRA BGRA BGRA -> BGR BGR BGR BGR; the 16 byte stores stay inside the row's 3 * width bytes
+		const __m128i shuffle = _mm_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+		for ( ; x + 6 <= width; x += 4 )
+		{
+			const __m128i bgra = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow + x ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pOut + 3 * x ), _mm_shuffle_epi8( bgra, shuffle ) );
+		}
+	}
+	for ( ; x < width; ++x )
+	{
+		const std::uint32_t bgra = pRow[x].m_dword;
+		std::uint8_t *p = pOut + 3 * x;
+		p[0] = static_cast<std::uint8_t>( bgra );
+		p[1] = static_cast<std::uint8_t>( bgra >> 8 );
+		p[2] = static_cast<std::uint8_t>( bgra >> 16 );
+	}
+}
+
+/// \brief	32 bit BGRX rows, the X byte is ignored
+void decodeRow32Opaque( const std::uint8_t *pRow,
+	ColorBGRA *pOut,
+	const unsigned width ) noexcept
+{
+	unsigned x = 0;
+	const __m128i alpha = _mm_set1_epi32( 0xFF000000 );
+	for ( ; x + 4 <= width; x += 4 )
+	{
+		const __m128i bgrx = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow + 4 * x ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( pOut + x ), _mm_or_si128( bgrx, alpha ) );
+	}
+	for ( ; x < width; ++x )
+	{
+		pOut[x] = ColorBGRA{readU32( pRow + 4 * x ) | 0xFF000000u};
+	}
+}
+
+/// \brief	SSE2 16 bit decode of 8 texels at a time; each channel must be 4 to 8 bits wide
+unsigned decodeRow16Simd( const std::uint8_t *pRow,
+	ColorBGRA *pOut,
+	const unsigned width,
+	const unsigned bShift,
+	const unsigned bBits,
+	const unsigned gShift,
+	const unsigned gBits,
+	const unsigned rShift,
+	const unsigned rBits ) noexcept
+{
+	// c8 = ( c << ( 8 - nBits ) ) | ( c >> ( 2 * nBits - 8 ) ) is the bit replication for 4 <= nBits <= 8
+	const auto expand = [] ( const __m128i texels, const unsigned shift, const unsigned nBits ) -> __m128i
+		{
+			const __m128i c = _mm_and_si128( _mm_srl_epi16( texels, _mm_cvtsi32_si128( shift ) ), _mm_set1_epi16( static_cast<short>( ( 1u << nBits ) - 1 ) ) );
+			return _mm_or_si128( _mm_sll_epi16( c, _mm_cvtsi32_si128( 8 - nBits ) ), _mm_srl_epi16( c, _mm_cvtsi32_si128( 2 * nBits - 8 ) ) );
+		};
+
+	unsigned x = 0;
+	const __m128i opaque = _mm_set1_epi16( static_cast<short>( 0xFF00 ) );
+	for ( ; x + 8 <= width; x += 8 )
+	{
+		const __m128i texels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow + 2 * x ) );
+		const __m128i b = expand( texels, bShift, bBits );
+		const __m128i g = expand( texels, gShift, gBits );
+		const __m128i r = expand( texels, rShift, rBits );
+		const __m128i bg = _mm_or_si128( b, _mm_slli_epi16( g, 8 ) );
+		const __m128i ra = _mm_or_si128( r, opaque );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( pOut + x ), _mm_unpacklo_epi16( bg, ra ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( pOut + x + 4 ), _mm_unpackhi_epi16( bg, ra ) );
+	}
+	return x;
+}
+
+}// namespace
+
+
+BmpReader::BmpReader( const std::string &filename )
+{
+	try
+	{
+		m_hFile = CreateFileW( util::s2ws( filename ).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+		if ( m_hFile == INVALID_HANDLE_VALUE )
+		{
+			THROW_UTIL_EXCEPTION( "Failed to open \"" + filename + "\"!" );
+		}
+
+		LARGE_INTEGER size{};
+		if ( !GetFileSizeEx( m_hFile, &size ) || size.QuadPart < static_cast<LONGLONG>( s_fileHeaderSize + s_infoHeaderSize ) )
+		{
+			THROW_UTIL_EXCEPTION( "\"" + filename + "\" is not a .bmp file!" );
+		}
+		m_nBytes = static_cast<std::size_t>( size.QuadPart );
+
+		m_hMapping = CreateFileMappingW( m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( m_hMapping == nullptr )
+		{
+			THROW_UTIL_EXCEPTION( "Failed to map \"" + filename + "\"!" );
+		}
+		m_pData = static_cast<const std::uint8_t*>( MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 ) );
+		if ( m_pData == nullptr )
+		{
+			THROW_UTIL_EXCEPTION( "Failed to map \"" + filename + "\"!" );
+		}
+
+		parseHeader();
+	}
+	catch ( ... )
+	{
+		close();
+		throw;
+	}
+}
+
+BmpReader::~BmpReader() noexcept
+{
+	close();
+}
+
+BmpReader::BmpReader( BmpReader &&rhs ) noexcept
+	:
+	m_hFile{rhs.m_hFile},
+	m_hMapping{rhs.m_hMapping},
+	m_pData{rhs.m_pData},
+	m_nBytes{rhs.m_nBytes},
+	m_header{rhs.m_header},
+	m_channels{rhs.m_channels},
+	m_palette{rhs.m_palette}
+{
+	rhs.m_hFile = INVALID_HANDLE_VALUE;
+	rhs.m_hMapping = nullptr;
+	rhs.m_pData = nullptr;
+	rhs.m_nBytes = 0;
+}
+
+BmpReader& BmpReader::operator=( BmpReader &&rhs ) noexcept
+{
+	std::swap( m_hFile, rhs.m_hFile );
+	std::swap( m_hMapping, rhs.m_hMapping );
+	std::swap( m_pData, rhs.m_pData );
+	std::swap( m_nBytes, rhs.m_nBytes );
+	std::swap( m_header, rhs.m_header );
+	std::swap( m_channels, rhs.m_channels );
+	std::swap( m_palette, rhs.m_palette );
+	return *this;
+}
+
+const Header& BmpReader::getHeader() const noexcept
+{
+	return m_header;
+}
+
+unsigned BmpReader::getWidth() const noexcept
+{
+	return m_header.width;
+}
+
+unsigned BmpReader::getHeight() const noexcept
+{
+	return m_header.height;
+}
+
+void BmpReader::readRow( const unsigned y,
+	ColorBGRA *pOut ) const noexcept
+{
+	ASSERT( y < m_header.height, "Row out of range!" );
+	const std::size_t fileRow = m_header.bTopDown ?
+		y :
+		m_header.height - 1 - y;
+	decodeRow( m_pData + m_header.dataOffset + fileRow * m_header.rowStride, pOut );
+}
+
+void BmpReader::readRows( const unsigned firstRow,
+	const unsigned nRows,
+	ColorBGRA *pOut ) const noexcept
+{
+	for ( unsigned y = 0; y < nRows; ++y )
+	{
+		readRow( firstRow + y, pOut + static_cast<std::size_t>( y ) * m_header.width );
+	}
+}
+
+void BmpReader::read( ColorBGRA *pOut ) const noexcept
+{
+	readRows( 0, m_header.height, pOut );
+}
+
+void BmpReader::parseHeader()
+{
+	// BITMAPFILEHEADER (14 bytes) followed by a BITMAPINFOHEADER (40 bytes) or one of its extensions (V4/V5: 108/124 bytes)
+	// bitfield masks follow a 40 byte header & are part of the larger ones, so they are always at offset 54
+	// the palette follows the info header
+	const std::uint8_t *p = m_pData;
+	if ( p[0] != 'B' || p[1] != 'M' )
+	{
+		THROW_UTIL_EXCEPTION( "Not a .bmp file!" );
+	}
+
+	const std::size_t dataOffset = readU32( p + 10 );
+	const std::uint32_t infoHeaderSize = readU32( p + 14 );
+	const std::int32_t width = static_cast<std::int32_t>( readU32( p + 18 ) );
+	const std::int32_t height = static_cast<std::int32_t>( readU32( p + 22 ) );
+	const unsigned bitCount = readU16( p + 28 );
+	const std::uint32_t compression = readU32( p + 30 );
+	const std::uint32_t nColorsUsed = readU32( p + 46 );
+
+	if ( infoHeaderSize < s_infoHeaderSize )
+	{
+		THROW_UTIL_EXCEPTION( "OS/2 .bmp headers are not supported!" );
+	}
+	if ( width <= 0 || height == 0 || height == INT32_MIN )
+	{
+		THROW_UTIL_EXCEPTION( "Invalid .bmp dimensions!" );
+	}
+	if ( compression != s_compressionRgb && compression != s_compressionBitfields && compression != s_compressionAlphaBitfields )
+	{
+		THROW_UTIL_EXCEPTION( "Compressed .bmp files are not supported!" );
+	}
+	if ( bitCount != 8 && bitCount != 16 && bitCount != 24 && bitCount != 32 )
+	{
+		THROW_UTIL_EXCEPTION( "Unsupported .bmp bit count " + std::to_string( bitCount ) + "!" );
+	}
+
+	m_header.width = static_cast<unsigned>( width );
+	m_header.height = static_cast<unsigned>( height < 0 ? -height : height );
+	m_header.bitCount = bitCount;
+	m_header.bTopDown = height < 0;
+	m_header.dataOffset = dataOffset;
+	m_header.rowStride = ( ( static_cast<std::size_t>( m_header.width ) * bitCount + 31 ) / 32 ) * 4;
+
+	// the last row's padding may be missing
+	const std::size_t rowBytes = ( static_cast<std::size_t>( m_header.width ) * bitCount + 7 ) / 8;
+	if ( dataOffset + m_header.rowStride * ( m_header.height - 1 ) + rowBytes > m_nBytes )
+	{
+		THROW_UTIL_EXCEPTION( "Truncated .bmp file!" );
+	}
+
+	// channel masks
+	if ( bitCount == 16 )
+	{
+		m_header.redMask = 0x7C00;
+		m_header.greenMask = 0x03E0;
+		m_header.blueMask = 0x001F;
+		m_header.alphaMask = 0;
+	}
+	else
+	{
+		m_header.redMask = 0x00FF0000;
+		m_header.greenMask = 0x0000FF00;
+		m_header.blueMask = 0x000000FF;
+		m_header.alphaMask = bitCount == 32 ?
+			0xFF000000 :
+			0;
+	}
+
+	// many writers leave the 4th byte of BI_RGB 32 bit texels 0, meaning opaque; alpha is only trusted if some texel's isn't 0
+	//	the scan stops at the first such texel, otherwise it reads the whole file
+	if ( bitCount == 32 && compression == s_compressionRgb && !hasNonZeroAlpha() )
+	{
+		m_header.alphaMask = 0;
+	}
+
+	if ( compression != s_compressionRgb )
+	{
+		if ( bitCount != 16 && bitCount != 32 )
+		{
+			THROW_UTIL_EXCEPTION( "Bitfields are only valid for 16 & 32 bit .bmp files!" );
+		}
+		const bool bAlphaMask = compression == s_compressionAlphaBitfields || infoHeaderSize >= 56;
+		if ( s_fileHeaderSize + s_infoHeaderSize + ( bAlphaMask ? 16 : 12 ) > m_nBytes )
+		{
+			THROW_UTIL_EXCEPTION( "Truncated .bmp file!" );
+		}
+		m_header.redMask = readU32( p + 54 );
+		m_header.greenMask = readU32( p + 58 );
+		m_header.blueMask = readU32( p + 62 );
+		m_header.alphaMask = bAlphaMask ?
+			readU32( p + 66 ) :
+			0;
+	}
+
+	const std::uint32_t masks[4] = {m_header.blueMask, m_header.greenMask, m_header.redMask, m_header.alphaMask};
+	for ( int i = 0; i < 4; ++i )
+	{
+		m_channels[i] = Channel{countTrailingZeros( masks[i] ), countBits( masks[i] )};
+	}
+
+	// palette of RGBQUADs: B G R reserved
+	m_palette.fill( ColorBGRA{0xFF000000u} );
+	if ( bitCount == 8 )
+	{
+		const std::size_t paletteOffset = s_fileHeaderSize + infoHeaderSize;
+		std::size_t nColors = nColorsUsed == 0 || nColorsUsed > 256 ?
+			256 :
+			nColorsUsed;
+		nColors = std::min( nColors, ( std::min( dataOffset, m_nBytes ) - std::min( paletteOffset, m_nBytes ) ) / 4 );
+		for ( std::size_t i = 0; i < nColors; ++i )
+		{
+			const std::uint8_t *pColor = p + paletteOffset + 4 * i;
+			m_palette[i] = ColorBGRA{0xFF000000u | ( pColor[2] << 16 ) | ( pColor[1] << 8 ) | pColor[0]};
+		}
+	}
+}
+
+bool BmpReader::hasNonZeroAlpha() const noexcept
+{
+	for ( unsigned y = 0; y < m_header.height; ++y )
+	{
+		const std::uint8_t *pRow = m_pData + m_header.dataOffset + y * m_header.rowStride;
+		// a row's worth of alpha bytes at a time, so the loop vectorizes
+		std::uint8_t alpha = 0;
+		for ( unsigned x = 0; x < m_header.width; ++x )
+		{
+			alpha |= pRow[4 * x + 3];
+		}
+		if ( alpha != 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void BmpReader::close() noexcept
+{
+	if ( m_pData != nullptr )
+	{
+		UnmapViewOfFile( m_pData );
+		m_pData = nullptr;
+	}
+	if ( m_hMapping != nullptr )
+	{
+		CloseHandle( m_hMapping );
+		m_hMapping = nullptr;
+	}
+	if ( m_hFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( m_hFile );
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+void BmpReader::decodeRow( const std::uint8_t *pRow,
+	ColorBGRA *pOut ) const noexcept
+{
+	const unsigned width = m_header.width;
+	switch ( m_header.bitCount )
+	{
+	case 8:
+	{
+		for ( unsigned x = 0; x < width; ++x )
+		{
+			pOut[x] = m_palette[pRow[x]];
+		}
+		break;
+	}
+	case 24:
+	{
+		decodeRow24( pRow, pOut, width );
+		break;
+	}
+	case 32:
+	{
+		if ( m_header.blueMask == 0x000000FF && m_header.greenMask == 0x0000FF00 && m_header.redMask == 0x00FF0000 )
+		{
+			if ( m_header.alphaMask == 0xFF000000 )
+			{
+				std::memcpy( pOut, pRow, static_cast<std::size_t>( width ) * sizeof( ColorBGRA ) );
+				break;
+			}
+			if ( m_header.alphaMask == 0 )
+			{
+				decodeRow32Opaque( pRow, pOut, width );
+				break;
+			}
+		}
+		decodeRowBitfields( pRow, pOut );
+		break;
+	}
+	default:
+	{
+		const auto &[b, g, r, a] = m_channels;
+		const auto bSimdable = [] ( const Channel &channel )
+			{
+				return channel.nBits >= 4 && channel.nBits <= 8 && channel.shift + channel.nBits <= 16;
+			};
+		unsigned x = 0;
+		if ( a.nBits == 0 && bSimdable( b ) && bSimdable( g ) && bSimdable( r ) )
+		{
+			x = decodeRow16Simd( pRow, pOut, width, b.shift, b.nBits, g.shift, g.nBits, r.shift, r.nBits );
+		}
+		if ( x < width )
+		{
+			decodeRowBitfields( pRow, pOut );
+		}
+		break;
+	}
+	}
+}
+
+void BmpReader::decodeRowBitfields( const std::uint8_t *pRow,
+	ColorBGRA *pOut ) const noexcept
+{
+	const auto channel = [] ( const std::uint32_t texel, const Channel &c ) -> unsigned
+		{
+			if ( c.nBits == 0 )
+			{
+				return 0xFFu;
+			}
+			const std::uint32_t mask = c.nBits >= 32 ?
+				0xFFFFFFFFu :
+				( 1u << c.nBits ) - 1;
+			return expandTo8Bits( ( texel >> c.shift ) & mask, c.nBits );
+		};
+
+	const bool b16Bits = m_header.bitCount == 16;
+	for ( unsigned x = 0; x < m_header.width; ++x )
+	{
+		const std::uint32_t texel = b16Bits ?
+			readU16( pRow + 2 * x ) :
+			readU32( pRow + 4 * x );
+		pOut[x] = ColorBGRA{( channel( texel, m_channels[3] ) << 24 ) | ( channel( texel, m_channels[2] ) << 16 ) | ( channel( texel, m_channels[1] ) << 8 ) | channel( texel, m_channels[0] )};
+	}
+}
+
+
+void write( const std::string &filename,
+	const unsigned width,
+	const unsigned height,
+	const ColorBGRA *pTexels,
+	const unsigned bitCount /*= 24u*/ )
+{
+	ASSERT( bitCount == 24 || bitCount == 32, "Only 24 & 32 bit .bmp files can be written!" );
+	const std::size_t rowStride = ( ( static_cast<std::size_t>( width ) * bitCount + 31 ) / 32 ) * 4;
+	const std::size_t dataOffset = s_fileHeaderSize + s_infoHeaderSize;
+	const std::size_t nBytes = dataOffset + rowStride * height;
+	if ( nBytes > 0xFFFFFFFFu )
+	{
+		THROW_UTIL_EXCEPTION( "Image too large for a .bmp file!" );
+	}
+
+	// zero initialized, so the row padding is already in place
+	std::vector<std::uint8_t> file( nBytes );
+	std::uint8_t *p = file.data();
+	p[0] = 'B';
+	p[1] = 'M';
+	writeU32( p + 2, static_cast<std::uint32_t>( nBytes ) );
+	writeU32( p + 10, static_cast<std::uint32_t>( dataOffset ) );
+	writeU32( p + 14, static_cast<std::uint32_t>( s_infoHeaderSize ) );
+	writeU32( p + 18, width );
+	writeU32( p + 22, height );	// positive: bottom-up
+	writeU16( p + 26, 1 );		// color planes
+	writeU16( p + 28, static_cast<std::uint16_t>( bitCount ) );
+	writeU32( p + 30, s_compressionRgb );
+	writeU32( p + 34, static_cast<std::uint32_t>( rowStride * height ) );
+	writeU32( p + 38, s_pixelsPerMeter );
+	writeU32( p + 42, s_pixelsPerMeter );
+
+	for ( unsigned y = 0; y < height; ++y )
+	{
+		const ColorBGRA *pRow = pTexels + static_cast<std::size_t>( height - 1 - y ) * width;
+		std::uint8_t *pOut = p + dataOffset + y * rowStride;
+		if ( bitCount == 24 )
+		{
+			encodeRow24( pRow, pOut, width );
+		}
+		else
+		{
+			std::memcpy( pOut, pRow, static_cast<std::size_t>( width ) * sizeof( ColorBGRA ) );
+		}
+	}
+
+	HANDLE hFile = CreateFileW( util::s2ws( filename ).c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		THROW_UTIL_EXCEPTION( "Failed to create \"" + filename + "\"!" );
+	}
+	DWORD nWritten = 0;
+	const BOOL bWritten = WriteFile( hFile, file.data(), static_cast<DWORD>( nBytes ), &nWritten, nullptr );
+	CloseHandle( hFile );
+	if ( !bWritten || nWritten != nBytes )
+	{
+		THROW_UTIL_EXCEPTION( "Failed to write \"" + filename + "\"!" );
+	}
+}
+
+
+}//namespace bmp
\ No newline at end of file
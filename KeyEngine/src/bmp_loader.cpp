@@ -1,4 +1,5 @@
 #include "bmp_loader.h"
+#include "bmp_codec.h"
 #include "utils.h"
 #include "math_utils.h"
 #include "key_random.h"
@@ -9,11 +10,8 @@
 
 BmpLoader::BmpLoader( const std::string& filename )
 	:
-	m_filename{filename},
-	m_file{filename, std::ios::out | std::ios::in | std::ios::binary}
+	m_filename{filename}
 {
-	ASSERT( m_file, "File is missing!" );
-
 	/// <image url="%Pictures%/bitmap file structure.png" scale="1" opacity="1" />
 	// .bmp file Implementation details:
 	// first 3 bytes are:
@@ -64,52 +62,16 @@ BmpLoader::BmpLoader( const std::string& filename )
 	// in a zig-zag pattern
 	//
 	// Also note that if the image height is negative the order is reversed (ie the bytes we start reading from belong to the top left pixel,
-	// We could examine this by checking the height value of the file first and the code here doesn't account for this.
+	// bmp::BmpReader accounts for this & always hands out the top row first.
 	//
 	// bitmap data is read/written from bottom line to the top by default
 	//
 	// example completed: "my_first_image.bmp"
 
-	ASSERT( sizeof BITMAPFILEHEADER == 14, "Invalid BITMAPFILEHEADER!" );
-	m_file.read( reinterpret_cast<unsigned char*>( &m_bmpFileHeader ), sizeof m_bmpFileHeader );
-	// m_bmpFileHeader.bfType		// the file type; must be "BM".
-	// m_bmpFileHeader.bfSize		//	size of the bitmap file
-
-	m_file.read( reinterpret_cast<unsigned char*>( &m_bmpInfoHeader ), sizeof m_bmpInfoHeader );
-	ASSERT( sizeof BITMAPINFOHEADER == 40, "Invalid BITMAPFILEHEADER" );
-
-	// m_bmpInfoHeader.biBitCount	// bits per pixel
-	// biWidth = width of the bitmap, in pixels
-	// biHeight = height of the bitmap, in pixels
-	m_bitCount = m_bmpInfoHeader.biBitCount;
-	ASSERT( m_bitCount == 24 || m_bitCount == 32, "Invalid bits/pixel!" );
-	ASSERT( m_bmpInfoHeader.biCompression == BI_RGB, "No RGB compression!" );
-
-	m_width = m_bmpInfoHeader.biWidth;
-	m_height = m_bmpInfoHeader.biHeight;
-
-	flush();
-}
-
-BmpLoader::BmpLoader( BmpLoader &&rhs ) noexcept
-	:
-	m_width{rhs.m_width},
-	m_height{rhs.m_height},
-	m_filename{rhs.m_filename},
-	m_bitCount{rhs.m_bitCount},
-	m_bmpFileHeader{rhs.m_bmpFileHeader},
-	m_bmpInfoHeader{rhs.m_bmpInfoHeader},
-	m_file{std::move( rhs.m_file ) }
-{
-	rhs.m_width = 0;
-	rhs.m_height = 0;
-}
-
-BmpLoader& BmpLoader::operator=( BmpLoader &&rhs ) noexcept
-{
-	BmpLoader tmp{std::move( rhs )};
-	std::swap( *this, tmp );
-	return *this;
+	const bmp::BmpReader reader{filename};
+	m_bitCount = static_cast<unsigned short>( reader.getHeader().bitCount );
+	m_width = static_cast<int>( reader.getWidth() );
+	m_height = static_cast<int>( reader.getHeight() );
 }
 
 int BmpLoader::getWidth() const noexcept
@@ -127,32 +89,27 @@ unsigned short BmpLoader::getBitCount() const noexcept
 	return m_bitCount;
 }
 
-void BmpLoader::flush() noexcept
-{
-	m_file.flush();
-	m_file.close();
-}
-
 bool BmpLoader::applyPerlinNoise( const std::string &filename /*= ""*/ )
 {
-	if ( m_bitCount == 32 )
-	{
-		ASSERT( false, "BmpLoader not ready for 32 bit depth BGRA file loading!" );
-		return false;
-	}
-
 	const size_t numImageElements = m_width * m_height;
 	ImageData *img = new ImageData[numImageElements];
 
-	auto perlin = [] ( const double x, const double y ) -> double
+	static const PerlinNoise perlinNoise;
+	static KeyRandom r;
+	static const auto moreRandom = r.getRandomIntInRange( 64, 256 );
+	static const auto lessRandom = r.getRandomIntInRange( 8, 32 );
+
+	// sample the whole image in one go, the filter only looks its pixel up
+	std::vector<float> noise( numImageElements );
+	const PerlinNoise::Grid grid{static_cast<unsigned>( m_width ), static_cast<unsigned>( m_height ), 1u, 0.0, 0.0, static_cast<double>( moreRandom ), 1.0 / m_width, 1.0 / m_height};
+	perlinNoise.fillGrid( noise.data(), grid, {}, true );
+
+	auto perlin = [this, &noise] ( const double x, const double y ) -> double
 	{
-		static PerlinNoise perlin;
-		static KeyRandom r;
-		static auto moreRandom = r.getRandomIntInRange( 64, 256 );
-		static auto lessRandom = r.getRandomIntInRange( 8, 32 );
+		const std::size_t pixel = static_cast<std::size_t>( y * m_height + 0.5 ) * m_width + static_cast<std::size_t>( x * m_width + 0.5 );
 
 		// wood like structure
-		double n = lessRandom * perlin.noise( x, y, moreRandom );
+		double n = lessRandom * noise[pixel];
 		return ( n - floor( n ) ) * 255.0;
 	};
 
@@ -182,67 +139,10 @@ bool BmpLoader::applyPerlinNoise( const std::string &filename /*= ""*/ )
 void BmpLoader::readData( _Inout_ ImageData *img,
 	const std::string &filename /*= ""*/ )
 {
-	m_file.open( filename == "" ? m_filename : filename, std::ios::in | std::ios::binary );
-
-	// test for reverse row order and control
-	// y loop accordingly
-	int yStart;
-	int yEnd;
-	int dy;
-	if ( m_bmpInfoHeader.biHeight < 0 )
-	{
-		m_height = -m_bmpInfoHeader.biHeight;
-		yStart = 0;
-		yEnd = m_height;
-		dy = 1;
-	}
-	else
-	{
-		m_height = m_bmpInfoHeader.biHeight;
-		yStart = m_height - 1;
-		yEnd = -1;
-		dy = -1;
-	}
-
-	m_file.seekg( m_bmpFileHeader.bfOffBits );
-	const int padding = ( 4 - ( m_width * 3 ) % 4 ) % 4;
-	const bool b32Bits = m_bitCount == 32ui16;
-
-	// visit every pixel of the image and assign a color generated with Perlin noise
-	for ( int y = yStart; y != yEnd; y += dy )
-	{
-		for ( int x = 0; x < m_width; ++x )
-		{
-			const unsigned char blue = (unsigned char) m_file.get();
-			const unsigned char green = (unsigned char) m_file.get();
-			const unsigned char red = (unsigned char) m_file.get();
-
-			auto &ar = img[y * m_width + x];
-
-			if ( !b32Bits )
-			{
-				ar._24bit.b = blue;
-				ar._24bit.g = green;
-				ar._24bit.r = red;
-			}
-			else
-			{
-				const unsigned char alpha = (unsigned char) m_file.get();
-				ar._32bit = ColorBGRA{red, green, blue, alpha};
-			}
-
-			if ( b32Bits )
-			{
-				m_file.seekg( 1, std::ios::cur );
-			}
-		}
-		if ( !b32Bits )
-		{
-			m_file.seekg( padding, std::ios::cur );
-		}
-	}
-
-	flush();
+	static_assert( sizeof( ImageData ) == sizeof( ColorBGRA ), "ImageData must alias ColorBGRA!" );
+	const bmp::BmpReader reader{filename == "" ? m_filename : filename};
+	ASSERT( static_cast<int>( reader.getWidth() ) == m_width && static_cast<int>( reader.getHeight() ) == m_height, "Image dimensions mismatch!" );
+	reader.read( reinterpret_cast<ColorBGRA*>( img ) );
 }
 
 void BmpLoader::generateData( _Inout_ ImageData *img,
@@ -252,40 +152,11 @@ void BmpLoader::generateData( _Inout_ ImageData *img,
 {
 	if ( bTransform )
 	{
-		m_file.open( filename == "" ? m_filename : filename, std::ios::in | std::ios::binary );
-	}
-	else
-	{
-		// trick" open file for writing but don't write anything, just read from it - all reads (like `file.get()`) will read nada values
-		m_file.open( filename == "" ? m_filename : filename, std::ios::out | std::ios::binary );
+		readData( img, filename );
 	}
 
-	// test for reverse row order and control
-	// y loop accordingly
-	int yStart;
-	int yEnd;
-	int dy;
-	if ( m_bmpInfoHeader.biHeight < 0 )
-	{
-		m_height = -m_bmpInfoHeader.biHeight;
-		yStart = 0;
-		yEnd = m_height;
-		dy = 1;
-	}
-	else
-	{
-		m_height = m_bmpInfoHeader.biHeight;
-		yStart = m_height - 1;
-		yEnd = -1;
-		dy = -1;
-	}
-
-	m_file.seekg( m_bmpFileHeader.bfOffBits );
-	const int padding = ( 4 - ( m_width * 3 ) % 4 ) % 4;
-	const bool b32Bits = m_bitCount == 32ui16;
-
-	// visit every pixel of the image and assign a color generated with Perlin noise
-	for ( int i = yStart; i != yEnd; i += dy )
+	// visit every pixel of the image and assign a color generated by the filters
+	for ( int i = 0; i < m_height; ++i )
 	{
 		for ( int j = 0; j < m_width; ++j )
 		{
@@ -299,35 +170,19 @@ void BmpLoader::generateData( _Inout_ ImageData *img,
 				val *= filter( x, y );
 			}
 
-			const unsigned char blue = util::mapToByte( m_file.get() * val );
-			const unsigned char green = util::mapToByte( m_file.get() * val );
-			const unsigned char red = util::mapToByte( m_file.get() * val );
-
 			auto &ar = img[i * m_width + j];
-			if ( !b32Bits )
+			if ( bTransform )
 			{
-				ar._24bit.b = blue;
-				ar._24bit.g = green;
-				ar._24bit.r = red;
+				const ColorBGRA texel = ar._32bit;
+				ar._32bit = ColorBGRA{util::mapToByte( texel.getRed() * val ), util::mapToByte( texel.getGreen() * val ), util::mapToByte( texel.getBlue() * val ), util::mapToByte( texel.getAlpha() * val )};
 			}
 			else
 			{
-				const unsigned char alpha = util::mapToByte( m_file.get() * val );
-				ar._32bit = ColorBGRA{red, green, blue, alpha};
-			}
-
-			if ( b32Bits )
-			{
-				m_file.seekg( 1, std::ios::cur );
+				const unsigned char value = util::mapToByte( val );
+				ar._32bit = ColorBGRA{value, value, value, 255};
 			}
 		}
-		if ( !b32Bits )
-		{
-			m_file.seekg( padding, std::ios::cur );
-		}
 	}
-
-	flush();
 }
 
 void BmpLoader::transformData( _Inout_ ImageData *img,
@@ -340,105 +195,7 @@ void BmpLoader::transformData( _Inout_ ImageData *img,
 void BmpLoader::writeData( ImageData *img,
 	const std::string &filename /*= ""*/ )
 {
-	m_file.open( filename == "" ? m_filename : filename, std::ios::out | std::ios::binary );
-
-	unsigned char fileHeader[14] =
-	{
-		'B','M',		// magic
-		0,0,0,0,		// size in bytes
-		0,0,			// app data
-		0,0,			// app data
-		40 + 14,0,0,0	// start of data offset
-	};
-
-	unsigned char infoHeader[40] =
-	{
-		40,0,0,0,		// infoHeader hd size
-		0,0,0,0,		// width
-		0,0,0,0,		// heigth
-		1,0,			// number color planes
-		24,0,			// bits per pixel
-		0,0,0,0,		// compression is none
-		0,0,0,0,		// image bits size
-		0x13,0x0B,0,0,	// horz resoluition in pixel / m
-		0x13,0x0B,0,0,	// vert resolutions (0x03C3 = 96 dpi, 0x0B13 = 72 dpi)
-		0,0,0,0,		// colors in pallete
-		0,0,0,0,		// important colors
-	};
-
-	int w = m_width;
-	int h = m_height;
-
-	// padding is for the case of of 24 bit depth only
-	int paddingSize  = ( 4 - ( w * 3 ) % 4 ) % 4;
-	int sizeData = w * h *3 + h * paddingSize;
-	int sizeAll  = sizeData + sizeof( fileHeader ) + sizeof( infoHeader );
-
-	fileHeader[2] = (unsigned char)( sizeAll );
-	fileHeader[3] = (unsigned char)( sizeAll >> 8);
-	fileHeader[4] = (unsigned char)( sizeAll >> 16);
-	fileHeader[5] = (unsigned char)( sizeAll >> 24);
-
-	infoHeader[4] = (unsigned char)( w );
-	infoHeader[5] = (unsigned char)( w >> 8);
-	infoHeader[6] = (unsigned char)( w >> 16);
-	infoHeader[7] = (unsigned char)( w >> 24);
-
-	infoHeader[8] = (unsigned char)( h );
-	infoHeader[9] = (unsigned char)( h >> 8);
-	infoHeader[10] = (unsigned char)( h >> 16);
-	infoHeader[11] = (unsigned char)( h >> 24);
-
-	infoHeader[20] = (unsigned char)( sizeData );
-	infoHeader[21] = (unsigned char)( sizeData >> 8);
-	infoHeader[22] = (unsigned char)( sizeData >> 16);
-	infoHeader[23] = (unsigned char)( sizeData >> 24);
-
-	m_file.write( fileHeader, sizeof( fileHeader ) );
-	m_file.write( infoHeader, sizeof( infoHeader ) );
-
-	const bool b32Bits = m_bitCount == 32ui16;
-
-	unsigned char padding[3] = { 0, 0, 0 };
-
-	for ( int y = 0; y < h; ++y )
-	{
-		for ( int x = 0; x < w; ++x )
-		{
-			if ( !b32Bits )
-			{
-				const auto element = img[y * m_width + x]._24bit;
-				const unsigned char texel[3] =
-				{
-					element.b,
-					element.g,
-					element.r
-				};
-
-				m_file.write( texel, 3 );
-			}
-			else
-			{
-				const auto element = img[y * m_width + x]._32bit;
-				const unsigned char texel[4] =
-				{
-					element.getBlue(),
-					element.getRed(),
-					element.getRed(),
-					element.getAlpha()
-				};
-
-				m_file.write( texel, 4 );
-			}
-		}
-
-		if ( !b32Bits )
-		{
-			m_file.write( padding, paddingSize );
-		}
-	}
-
-	flush();
+	bmp::write( filename == "" ? m_filename : filename, static_cast<unsigned>( m_width ), static_cast<unsigned>( m_height ), reinterpret_cast<const ColorBGRA*>( img ), m_bitCount == 32 ? 32u : 24u );
 }
 
 void BmpLoader::normalizeHeightmap( _Inout_ ImageData *img,
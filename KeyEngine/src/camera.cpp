@@ -222,11 +222,11 @@ const std::string& Camera::getName() const noexcept
 	return m_name;
 }
 
-std::vector<dx::XMFLOAT4> Camera::getFrustumPlanes() const noexcept
+std::array<dx::XMFLOAT4, 6> Camera::getFrustumPlanes() const noexcept
 {
 	// x, y, z, and w represent A, B, C and D in the plane equation
 	// where ABC are the xyz of the planes normal, and D is the plane constant
-	std::vector<dx::XMFLOAT4> frustumPlanes( 6 );
+	std::array<dx::XMFLOAT4, 6> frustumPlanes{};
 
 	dx::XMFLOAT4X4 viewProj{};	// Left-Handed
 	dx::XMStoreFloat4x4( &viewProj, getViewMatrix() * getPerspectiveProjectionMatrix() );
@@ -0,0 +1,82 @@
+#include "command_list.h"
+#include "assertions_console.h"
+
+
+namespace ren
+{
+
+void NullCommandListBackend::reserve( const std::size_t nCommandLists )
+{
+	if ( m_commandLists.size() < nCommandLists )
+	{
+		m_commandLists.resize( nCommandLists );
+	}
+}
+
+void NullCommandListBackend::beginRecording( const std::size_t index )
+{
+	ASSERT( index < m_commandLists.size(), "Command list index out of range!" );
+	ASSERT( s_pRecordingList == nullptr, "This thread is already recording!" );
+	m_commandLists[index].clear();
+	s_pRecordingList = &m_commandLists[index];
+}
+
+void NullCommandListBackend::finishRecording( const std::size_t index )
+{
+	ASSERT( s_pRecordingList == &m_commandLists[index], "This thread is not recording this command list!" );
+	s_pRecordingList = nullptr;
+}
+
+void NullCommandListBackend::execute( const std::size_t index )
+{
+	ASSERT( s_pRecordingList == nullptr, "Command lists must be executed on the immediate context!" );
+	auto &commandList = m_commandLists[index];
+	m_immediateCommands.insert( m_immediateCommands.end(), commandList.begin(), commandList.end() );
+	commandList.clear();
+	++m_nStateResets;
+}
+
+void NullCommandListBackend::submit( const std::uint32_t command )
+{
+	if ( s_pRecordingList != nullptr )
+	{
+		s_pRecordingList->push_back( command );
+	}
+	else
+	{
+		m_immediateCommands.push_back( command );
+	}
+}
+
+const std::vector<std::uint32_t>& NullCommandListBackend::getImmediateCommands() const noexcept
+{
+	return m_immediateCommands;
+}
+
+unsigned NullCommandListBackend::getNumStateResets() const noexcept
+{
+	return m_nStateResets;
+}
+
+void NullCommandListBackend::clear() noexcept
+{
+	for ( auto &commandList : m_commandLists )
+	{
+		commandList.clear();
+	}
+	m_immediateCommands.clear();
+	m_nStateResets = 0u;
+}
+
+
+CommandListScheduler::CommandListScheduler( ICommandListBackend &backend,
+	const unsigned nMaxRecordingThreads )
+	:
+	m_backend(backend),
+	m_nMaxRecordingThreads{std::max( nMaxRecordingThreads, 1u )}
+{
+
+}
+
+
+}//namespace ren
\ No newline at end of file
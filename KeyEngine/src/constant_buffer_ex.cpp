@@ -1,4 +1,5 @@
 #include "constant_buffer_ex.h"
+#include <algorithm>
 #include "graphics.h"
 #include "os_utils.h"
 #include "dxgi_info_queue.h"
@@ -27,6 +28,12 @@ IConstantBufferEx::IConstantBufferEx( Graphics &gfx,
 	}
 }
 
+IConstantBufferEx::~IConstantBufferEx() noexcept
+{
+	std::lock_guard<std::mutex> lg{s_dirtyBuffersMutex};
+	s_dirtyBuffers.erase( std::remove( s_dirtyBuffers.begin(), s_dirtyBuffers.end(), this ), s_dirtyBuffers.end() );
+}
+
 void IConstantBufferEx::setBufferDesc( D3D11_BUFFER_DESC &d3dBufDesc,
 	const unsigned byteWidth )
 {
@@ -53,6 +60,34 @@ void IConstantBufferEx::update( Graphics &gfx,
 	getDeviceContext( gfx )->Unmap( m_pD3dCb.Get(), 0u );
 }
 
+void IConstantBufferEx::markDirty()
+{
+	if ( !m_bDirty.exchange( true ) )
+	{
+		std::lock_guard<std::mutex> lg{s_dirtyBuffersMutex};
+		s_dirtyBuffers.push_back( this );
+	}
+}
+
+void IConstantBufferEx::updateIfDirty( Graphics &gfx )
+{
+	if ( m_bDirty.exchange( false ) )
+	{
+		update( gfx, getBuffer() );
+	}
+}
+
+void IConstantBufferEx::updateDirtyBuffers( Graphics &gfx )
+{
+	std::lock_guard<std::mutex> lg{s_dirtyBuffersMutex};
+	// buffers already uploaded by a bind since they were marked are clean by now
+	for ( IConstantBufferEx *pCb : s_dirtyBuffers )
+	{
+		pCb->updateIfDirty( gfx );
+	}
+	s_dirtyBuffers.clear();
+}
+
 
 void IVertexShaderConstantBufferEx::bind( Graphics &gfx ) cond_noex
 {
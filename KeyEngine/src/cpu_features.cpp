@@ -0,0 +1,69 @@
+#include "cpu_features.h"
+#if defined _MSC_VER
+#	include <intrin.h>
+#endif
+
+
+namespace util
+{
+
+namespace
+{
+
+CpuFeatures queryCpuFeatures() noexcept
+{
+	CpuFeatures features;
+#if defined _MSC_VER
+	int info[4];
+	__cpuid( info, 0 );
+	const int maxLeaf = info[0];
+	__cpuid( info, 1 );
+	features.bSsse3 = ( info[2] & ( 1 << 9 ) ) != 0;
+	features.bSse41 = ( info[2] & ( 1 << 19 ) ) != 0;
+	// AVX2 registers are only usable if the OS saves them on context switches: OSXSAVE set & XCR0 has the SSE & AVX state bits
+	const bool bOsYmm = ( info[2] & ( 1 << 27 ) ) != 0 && ( _xgetbv( 0 ) & 6 ) == 6;
+	if ( maxLeaf >= 7 && bOsYmm )
+	{
+		__cpuidex( info, 7, 0 );
+		features.bAvx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	features.bSsse3 = __builtin_cpu_supports( "ssse3" );
+	features.bSse41 = __builtin_cpu_supports( "sse4.1" );
+	features.bAvx2 = __builtin_cpu_supports( "avx2" );
+#endif
+	return features;
+}
+
+CpuFeatures& getDetectedCpuFeatures() noexcept
+{
+	static CpuFeatures s_detected = queryCpuFeatures();
+	return s_detected;
+}
+
+CpuFeatures& getEnabledCpuFeatures() noexcept
+{
+	static CpuFeatures s_enabled = getDetectedCpuFeatures();
+	return s_enabled;
+}
+
+
+}// namespace
+
+const CpuFeatures& getCpuFeatures() noexcept
+{
+	return getEnabledCpuFeatures();
+}
+
+void restrictCpuFeatures( const CpuFeatures &enabled ) noexcept
+{
+	const CpuFeatures &detected = getDetectedCpuFeatures();
+	CpuFeatures &features = getEnabledCpuFeatures();
+	features.bSsse3 = detected.bSsse3 && enabled.bSsse3;
+	features.bSse41 = detected.bSse41 && enabled.bSse41;
+	features.bAvx2 = detected.bAvx2 && enabled.bAvx2;
+}
+
+
+}//namespace util
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "cpu_framebuffer.h"
+#include <algorithm>
+#include <cstring>
+#include "assertions_console.h"
+
+
+CpuFramebuffer::CpuFramebuffer( const unsigned width,
+	const unsigned height,
+	const bool bDoubleBuffered /*= false*/ )
+	:
+	m_width{width},
+	m_height{height},
+	m_nTilesX{( width + s_tileSize - 1 ) / s_tileSize},
+	m_nTilesY{( height + s_tileSize - 1 ) / s_tileSize},
+	m_nBuffers{bDoubleBuffered ? 2u : 1u}
+{
+	ASSERT( width > 0 && height > 0, "Empty CPU framebuffer!" );
+	for ( unsigned i = 0; i < m_nBuffers; ++i )
+	{
+		m_buffers[i].resize( static_cast<std::size_t>( width ) * height );
+	}
+	const std::size_t nMaskWords = ( static_cast<std::size_t>( m_nTilesX ) * m_nTilesY + 63 ) / 64;
+	for ( auto &mask : m_frameMasks )
+	{
+		mask.assign( nMaskWords, 0u );
+	}
+	m_uploadMask.assign( nMaskWords, 0u );
+	m_lastRectAt.assign( m_nTilesX, 0u );
+}
+
+void CpuFramebuffer::beginFrame() noexcept
+{
+	++m_frame;
+	m_back = static_cast<unsigned>( m_frame % m_nBuffers );
+	// this frame's mask slot last held the mask of s_nFrameMasks frames ago
+	auto &frameMask = getFrameMask( 0u );
+	std::fill( frameMask.begin(), frameMask.end(), 0u );
+
+	// the back buffer was last drawn into m_nBuffers frames ago, only those tiles aren't zero
+	ColorBGRA *pBack = m_buffers[m_back].data();
+	forEachTileRun( getFrameMask( m_nBuffers ),
+		[this, pBack] ( const unsigned tileLeft, const unsigned tileRight, const unsigned tileY )
+		{
+			const unsigned left = tileLeft * s_tileSize;
+			const std::size_t nBytes = static_cast<std::size_t>( std::min( tileRight * s_tileSize, m_width ) - left ) * sizeof( ColorBGRA );
+			const unsigned bottom = std::min( ( tileY + 1 ) * s_tileSize, m_height );
+			for ( unsigned y = tileY * s_tileSize; y < bottom; ++y )
+			{
+				std::memset( pBack + static_cast<std::size_t>( y ) * m_width + left, 0, nBytes );
+			}
+		} );
+}
+
+void CpuFramebuffer::endFrame()
+{
+	m_front = m_back;
+	m_uploadRects.clear();
+	if ( m_bFullUpload )
+	{
+		m_uploadRects.push_back( Rect{0u, 0u, m_width, m_height} );
+		m_bFullUpload = false;
+		return;
+	}
+
+	// the uploaded frame & this one only differ in the tiles drawn into in either of them, the rest are zero in both
+	const auto &frameMask = getFrameMask( 0u );
+	const auto &previousFrameMask = getFrameMask( 1u );
+	for ( std::size_t i = 0; i < m_uploadMask.size(); ++i )
+	{
+		m_uploadMask[i] = frameMask[i] | previousFrameMask[i];
+	}
+
+	buildUploadRects( false );
+	if ( m_uploadRects.size() > s_maxUploadRects )
+	{
+		buildUploadRects( true );
+	}
+	for ( Rect &rect : m_uploadRects )
+	{
+		rect.left *= s_tileSize;
+		rect.top *= s_tileSize;
+		rect.right = std::min( rect.right * s_tileSize, m_width );
+		rect.bottom = std::min( rect.bottom * s_tileSize, m_height );
+	}
+}
+
+void CpuFramebuffer::buildUploadRects( const bool bRowSpans )
+{
+	m_uploadRects.clear();
+	// runs of tiles in a row extend the rect above them if it spans the same tiles
+	const auto addRun = [this] ( const unsigned tileLeft, const unsigned tileRight, const unsigned tileY )
+		{
+			// a stale index can only match a rect that's extendable all the same
+			std::size_t &above = m_lastRectAt[tileLeft];
+			if ( above < m_uploadRects.size() )
+			{
+				Rect &rect = m_uploadRects[above];
+				if ( rect.left == tileLeft && rect.right == tileRight && rect.bottom == tileY )
+				{
+					rect.bottom = tileY + 1;
+					return;
+				}
+			}
+			above = m_uploadRects.size();
+			m_uploadRects.push_back( Rect{tileLeft, tileY, tileRight, tileY + 1} );
+		};
+	if ( !bRowSpans )
+	{
+		forEachTileRun( m_uploadMask, addRun );
+		return;
+	}
+
+	// a single run per row, from its first set tile to its last
+	unsigned spanLeft = 0;
+	unsigned spanRight = 0;
+	unsigned spanY = 0;
+	forEachTileRun( m_uploadMask,
+		[&] ( const unsigned tileLeft, const unsigned tileRight, const unsigned tileY )
+		{
+			if ( spanRight > 0 && tileY != spanY )
+			{
+				addRun( spanLeft, spanRight, spanY );
+				spanRight = 0;
+			}
+			if ( spanRight == 0 )
+			{
+				spanLeft = tileLeft;
+				spanY = tileY;
+			}
+			spanRight = tileRight;
+		} );
+	if ( spanRight > 0 )
+	{
+		addRun( spanLeft, spanRight, spanY );
+	}
+}
+
+ColorBGRA CpuFramebuffer::getPixel( const int x,
+	const int y ) const noexcept
+{
+	ASSERT( x >= 0 && x < (int) m_width && y >= 0 && y < (int) m_height, "Pixel out of the CPU framebuffer!" );
+	return m_buffers[m_back][static_cast<std::size_t>( m_width ) * y + x];
+}
+
+void CpuFramebuffer::putPixel( const int x,
+	const int y,
+	const ColorBGRA color ) noexcept
+{
+	ASSERT( x >= 0 && x < (int) m_width && y >= 0 && y < (int) m_height, "Pixel out of the CPU framebuffer!" );
+	m_buffers[m_back][static_cast<std::size_t>( m_width ) * y + x] = color;
+	markTile( static_cast<unsigned>( x ) / s_tileSize, static_cast<unsigned>( y ) / s_tileSize );
+}
+
+void CpuFramebuffer::markDirty( const Rect &rect ) noexcept
+{
+	const unsigned right = std::min( rect.right, m_width );
+	const unsigned bottom = std::min( rect.bottom, m_height );
+	if ( rect.left >= right || rect.top >= bottom )
+	{
+		return;
+	}
+	for ( unsigned ty = rect.top / s_tileSize; ty <= ( bottom - 1 ) / s_tileSize; ++ty )
+	{
+		for ( unsigned tx = rect.left / s_tileSize; tx <= ( right - 1 ) / s_tileSize; ++tx )
+		{
+			markTile( tx, ty );
+		}
+	}
+}
+
+ColorBGRA* CpuFramebuffer::getBackBuffer() noexcept
+{
+	return m_buffers[m_back].data();
+}
+
+const ColorBGRA* CpuFramebuffer::getFrontBuffer() const noexcept
+{
+	return m_buffers[m_front].data();
+}
+
+const std::vector<CpuFramebuffer::Rect>& CpuFramebuffer::getUploadRects() const noexcept
+{
+	return m_uploadRects;
+}
+
+bool CpuFramebuffer::isTileDirty( const unsigned tileX,
+	const unsigned tileY ) const noexcept
+{
+	ASSERT( tileX < m_nTilesX && tileY < m_nTilesY, "Tile out of the CPU framebuffer!" );
+	return isTileSet( getFrameMask( 0u ), tileX, tileY );
+}
+
+unsigned CpuFramebuffer::getWidth() const noexcept
+{
+	return m_width;
+}
+
+unsigned CpuFramebuffer::getHeight() const noexcept
+{
+	return m_height;
+}
+
+unsigned CpuFramebuffer::getTileCountX() const noexcept
+{
+	return m_nTilesX;
+}
+
+unsigned CpuFramebuffer::getTileCountY() const noexcept
+{
+	return m_nTilesY;
+}
+
+std::vector<std::uint64_t>& CpuFramebuffer::getFrameMask( const std::size_t nFramesAgo ) noexcept
+{
+	return m_frameMasks[( m_frame + s_nFrameMasks - nFramesAgo ) % s_nFrameMasks];
+}
+
+const std::vector<std::uint64_t>& CpuFramebuffer::getFrameMask( const std::size_t nFramesAgo ) const noexcept
+{
+	return m_frameMasks[( m_frame + s_nFrameMasks - nFramesAgo ) % s_nFrameMasks];
+}
+
+void CpuFramebuffer::markTile( const unsigned tileX,
+	const unsigned tileY ) noexcept
+{
+	const std::size_t index = static_cast<std::size_t>( tileY ) * m_nTilesX + tileX;
+	getFrameMask( 0u )[index / 64] |= std::uint64_t{1} << ( index % 64 );
+}
\ No newline at end of file
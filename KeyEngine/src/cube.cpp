@@ -127,13 +127,26 @@ Cube::Cube( Graphics &gfx,
 
 			opaque.addBindable( PixelShader::fetch( gfx, "cube_ps.cso" ) );
 
-			con::RawLayout cbLayout;
-			cbLayout.add<con::Float3>( "cb_modelSpecularColor" );
-			cbLayout.add<con::Float>( "cb_modelSpecularGloss" );
-			auto cb = con::CBuffer( std::move( cbLayout ) );
-			cb["cb_modelSpecularColor"] = dx::XMFLOAT3{1.0f, 1.0f, 1.0f};
-			cb["cb_modelSpecularGloss"] = 128.0f;
-			opaque.addBindable( std::make_shared<PixelShaderConstantBufferEx>( gfx, 0u, cb ) );
+			std::shared_ptr<IBindable> pSpecularPscb = s_pTexturedSpecularPscb.lock();
+			if ( !pSpecularPscb )
+			{
+				con::RawLayout cbLayout;
+				cbLayout.add<con::Float3>( "cb_modelSpecularColor" );
+				cbLayout.add<con::Float>( "cb_modelSpecularGloss" );
+				auto cb = con::CBuffer( std::move( cbLayout ) );
+				cb["cb_modelSpecularColor"] = dx::XMFLOAT3{1.0f, 1.0f, 1.0f};
+				cb["cb_modelSpecularGloss"] = 128.0f;
+				pSpecularPscb = std::make_shared<PixelShaderConstantBufferEx>( gfx, 0u, cb );
+				s_pTexturedSpecularPscb = pSpecularPscb;
+			}
+			opaque.addBindable( std::move( pSpecularPscb ) );
+
+			// textured Cubes of the same size are drawn instanced
+			auto pInstancedVs = VertexShader::fetch( gfx, "cube_instanced_vs.cso" );
+			auto instancedLayout = cube.m_vb.getLayout();
+			instancedLayout.addInstance( ver::VertexInputLayout::InstanceTransform );
+			auto pInstancedInputLayout = InputLayout::fetch( gfx, instancedLayout, *pInstancedVs );
+			opaque.setInstancing( std::move( pInstancedVs ), std::move( pInstancedInputLayout ) );
 		}
 
 		opaque.addBindable( RasterizerState::fetch( gfx, RasterizerState::RasterizerMode::DefaultRS, RasterizerState::FillMode::Solid, RasterizerState::FaceMode::Front ) );
@@ -4,6 +4,32 @@
 namespace ver
 {
 
+namespace
+{
+
+struct InstanceElementProperties final
+{
+	const char *hlslSemantic;
+	DXGI_FORMAT dxgiFormat;
+	unsigned nRows;		// one D3D11_INPUT_ELEMENT_DESC per row
+	size_t rowSize;
+	const char *tag;
+};
+
+constexpr InstanceElementProperties getInstanceElementProperties( const VertexInputLayout::InstanceElementType type ) noexcept
+{
+	switch ( type )
+	{
+	case VertexInputLayout::InstanceTransform:
+		return {"InstanceTransform", DXGI_FORMAT_R32G32B32A32_FLOAT, 4u, sizeof( DirectX::XMFLOAT4 ), "Iw"};
+	case VertexInputLayout::InstanceFloat4Color:
+		return {"InstanceColor", DXGI_FORMAT_R32G32B32A32_FLOAT, 1u, sizeof( DirectX::XMFLOAT4 ), "Ic"};
+	}
+	return {"Invalid", DXGI_FORMAT_UNKNOWN, 0u, 0u, "INV"};
+}
+
+}// namespace
+
 const VertexInputLayout::ILElement& VertexInputLayout::getElementByIndex( const size_t i ) const cond_noex
 {
 	return m_vertexLayoutElements[i];
@@ -50,6 +76,14 @@ std::vector<D3D11_INPUT_ELEMENT_DESC> VertexInputLayout::getD3DInputElementDescs
 	{
 		desc.push_back( e.getD3dDesc() );
 	}
+	for ( const auto &[type, offset] : m_instanceElements )
+	{
+		const auto properties = getInstanceElementProperties( type );
+		for ( unsigned row = 0; row < properties.nRows; ++row )
+		{
+			desc.push_back( {properties.hlslSemantic, row, properties.dxgiFormat, s_instanceInputSlot, static_cast<unsigned>( offset + row * properties.rowSize ), D3D11_INPUT_PER_INSTANCE_DATA, 1u} );
+		}
+	}
 	return desc;
 }
 
@@ -60,9 +94,42 @@ std::string VertexInputLayout::calcSignature() const cond_noex
 	{
 		tag += e.getTag();
 	}
+	for ( const auto &instanceElement : m_instanceElements )
+	{
+		tag += getInstanceElementProperties( instanceElement.first ).tag;
+	}
 	return tag;
 }
 
+VertexInputLayout& VertexInputLayout::addInstance( const InstanceElementType type ) cond_noex
+{
+	for ( const auto &instanceElement : m_instanceElements )
+	{
+		if ( instanceElement.first == type )
+		{
+			return *this;
+		}
+	}
+	m_instanceElements.emplace_back( type, getInstanceSizeInBytes() );
+	return *this;
+}
+
+bool VertexInputLayout::hasInstanceElements() const noexcept
+{
+	return !m_instanceElements.empty();
+}
+
+size_t VertexInputLayout::getInstanceSizeInBytes() const noexcept
+{
+	if ( m_instanceElements.empty() )
+	{
+		return 0u;
+	}
+	const auto &[type, offset] = m_instanceElements.back();
+	const auto properties = getInstanceElementProperties( type );
+	return offset + properties.nRows * properties.rowSize;
+}
+
 namespace lookups
 {
 
@@ -175,10 +242,9 @@ VBuffer::VBuffer( VertexInputLayout layout,
 
 void VBuffer::resize( const size_t newVertexCount ) cond_noex
 {
-	const auto vertexCount = getVertexCount();
-	if ( vertexCount < newVertexCount )
+	if ( newVertexCount != getVertexCount() )
 	{
-		m_data.resize( getSizeInBytes() + m_vertexLayout.getSizeInBytes() * ( newVertexCount - vertexCount ) );
+		m_data.resize( m_vertexLayout.getSizeInBytes() * newVertexCount );
 	}
 }
 
@@ -187,6 +253,11 @@ const char* VBuffer::data() const cond_noex
 	return m_data.data();
 }
 
+char* VBuffer::data() cond_noex
+{
+	return m_data.data();
+}
+
 
 VBuffer::VBuffer( VertexInputLayout vertLayout,
 	const aiMesh &aimesh )
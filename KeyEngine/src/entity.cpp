@@ -79,11 +79,7 @@ void Entity::printInfo() const noexcept
 
 EntityId Entity::getId() const noexcept
 {
-#ifdef _32_BIT_ENTITY
-	return ( m_version << 16 ) | m_index;
-#elif _64_BIT_ENTITY
-	return ( (EntityId) m_version << 32 ) | m_index;
-#endif
+	return makeEntityId( m_version, m_index );
 }
 
 const std::string& Entity::getName() const noexcept
@@ -131,14 +127,14 @@ int Entity::getChildrenCount() const noexcept
 	return (int) m_children.size();
 }
 
-void Entity::onMessageReceived( std::unique_ptr<Message> msg )
+void Entity::onMessageReceived( Message &msg )
 {
-	auto pDataMsg = dynamic_cast<MessageCall*>( msg.get() );
-
-	auto callback = pDataMsg->getCallable();
-	(*callback)();
+	if ( auto *ppCallback = msg.getPayload<std::unique_ptr<Operation>>() )
+	{
+		( **ppCallback )();
+	}
 
-	switch ( pDataMsg->getType() )
+	switch ( msg.getType() )
 	{
 	case Message::Type::Damage:
 	{
@@ -168,13 +164,7 @@ void Entity::onMessageReceived( std::unique_ptr<Message> msg )
 		break;
 	}
 	}
-	pDataMsg->setHandled( true );
-}
-
-void Entity::sendMessage( Message *msg ) const noexcept
-{
-	auto &md = MessageDispatcher::getInstance();
-	md.addMessage( msg );
+	msg.setHandled( true );
 }
 
 inline bool Entity::operator==( const Entity *rhs ) const noexcept
@@ -1,6 +1,7 @@
 #include "entity_manager.h"
 #include "entity.h"
 #include "gameplay_exception.h"
+#include "assertions_console.h"
 
 
 EntityManager::Bucket::Bucket( int categoryId )
@@ -15,20 +16,36 @@ int EntityManager::Bucket::getCategoryId() const noexcept
 	return m_categoryId;
 }
 
-void EntityManager::Bucket::appendEntity( Entity *pEnt )
+std::uint32_t EntityManager::Bucket::appendEntity( Entity *pEnt )
 {
 	m_pEntities.emplace_back( pEnt );
+	return static_cast<std::uint32_t>( m_pEntities.size() - 1 );
 }
 
-void EntityManager::Bucket::removeEntity( Entity *pEnt ) cond_noex
+Entity* EntityManager::Bucket::removeEntity( const std::uint32_t slot ) cond_noex
 {
-	auto it = std::find( m_pEntities.begin(), m_pEntities.end(), pEnt );
-	m_pEntities.erase( it );
+	ASSERT( slot < m_pEntities.size(), "Invalid Bucket slot!" );
+	Entity *pMoved = nullptr;
+	if ( slot != m_pEntities.size() - 1 )
+	{
+		pMoved = m_pEntities.back();
+		m_pEntities[slot] = pMoved;
+	}
+	m_pEntities.pop_back();
+	return pMoved;
+}
+
+const std::vector<Entity*>& EntityManager::Bucket::getEntities() const noexcept
+{
+	return m_pEntities;
 }
 
 EntityManager::EntityManager()
 {
 	m_entities.reserve( 1000 );
+	m_locations.reserve( 1000 );
+	m_archetypes.emplace_back( std::make_unique<Archetype>( ComponentMask{0} ) );
+	m_archetypeIndices.emplace( ComponentMask{0}, 0u );
 }
 
 EntityManager& EntityManager::getInstance()
@@ -45,6 +62,7 @@ void EntityManager::resetInstance()
 	if ( s_pInstance != nullptr )
 	{
 		delete s_pInstance;
+		s_pInstance = nullptr;
 	}
 }
 
@@ -55,52 +73,34 @@ EntityId EntityManager::spawnEntity( const std::string &name,
 	EntityIndex index;
 	if ( m_freelist.empty() )
 	{
-		index = static_cast<EntityIndex>( m_entities.size() );
-		auto p = std::make_unique<Entity>( Entity{1, index, name, static_cast<Entity::Category>( categoryId ), pParent} );
-		m_entities.emplace_back( std::move( p ) );
-
-		// If the entity is of a specific category add it to the appropriate Bucket
-		switch( categoryId )
-		{
-		case 1:
-		{
-			m_statics.appendEntity( p.get() );
-			break;
-		}
-		case 2:
-		{
-			m_bullets.appendEntity( p.get() );
-			break;
-		}
-		case 3:
-		{
-			m_ragDolls.appendEntity( p.get() );
-			break;
-		}
-		case 4:
-		{
-			m_npcs.appendEntity( p.get() );
-			break;
-		}
-		case 5:
-		{
-			m_mounts.appendEntity( p.get() );
-			break;
-		}
-		default :	// UNCATEGORIZED - 0
+		if ( m_entities.size() > static_cast<EntityIndex>( ~EntityIndex{0} ) )
 		{
-			break;
+			THROW_GAMEPLAY_EXCEPTION( "Ran out of Entity indices!" );
 		}
-		}//switch
+		index = static_cast<EntityIndex>( m_entities.size() );
+		m_entities.emplace_back( std::make_unique<Entity>( Entity{1, index, name, static_cast<Entity::Category>( categoryId ), pParent} ) );
+		m_locations.emplace_back();
 	}
-	else	// if there are dead entities
+	else	// if there are dead entities reuse their slot, its version has already been bumped
 	{
 		index = m_freelist.back();
-		//m_entities[index].push_back( Entity() );
-		//m_freelist.push_back( m_entities.size() - 1 );
 		m_freelist.pop_back();
+		Entity &entity = *m_entities[index];
+		entity.m_name = name;
+		entity.m_category = static_cast<Entity::Category>( categoryId );
+		entity.m_pParent = pParent;
+		entity.m_children.clear();
 	}
-	return ( m_entities[index]->m_version << 16 ) | index;
+
+	Entity &entity = *m_entities[index];
+	const EntityId id = entity.getId();
+	EntityLocation &location = m_locations[index];
+	location.m_archetype = 0;
+	location.m_row = m_archetypes[0]->allocateRow( id );
+	location.m_bAlive = true;
+	// If the entity is of a specific category add it to the appropriate Bucket
+	addToBucket( entity, location );
+	return id;
 }
 
 EntityIndex EntityManager::getAliveEntityCount()
@@ -110,20 +110,38 @@ EntityIndex EntityManager::getAliveEntityCount()
 
 Entity *EntityManager::getEntityById( EntityId entId )
 {
-	EntityIndex index = entId & 0xFFFF;
-	EntityIndex version = entId >> 16;
-	if ( index < m_entities.size()
-		&& m_entities[index]->m_version == version )
+	if ( !isAlive( entId ) )
 	{
-		return m_entities[index].get();
+		return nullptr;
 	}
-	return nullptr;
+	return m_entities[getEntityIndex( entId )].get();
+}
+
+bool EntityManager::isAlive( const EntityId entId ) const noexcept
+{
+	const EntityIndex index = getEntityIndex( entId );
+	return index < m_entities.size()
+		&& m_locations[index].m_bAlive
+		&& m_entities[index]->m_version == getEntityVersion( entId );
 }
 
 void EntityManager::recycleEntityId( EntityId entId )
 {
-	EntityIndex index = entId & 0xFFFF;
-	++m_entities[index]->m_version;
+	EntityLocation &location = getLocation( entId );
+	const EntityIndex index = getEntityIndex( entId );
+	Entity &entity = *m_entities[index];
+
+	Archetype &archetype = *m_archetypes[location.m_archetype];
+	archetype.destroyRowComponents( location.m_row );
+	const EntityId movedId = archetype.removeRow( location.m_row );
+	if ( movedId != s_invalidEntityId )
+	{
+		m_locations[getEntityIndex( movedId )].m_row = location.m_row;
+	}
+	removeFromBucket( entity, location );
+
+	location.m_bAlive = false;
+	++entity.m_version;
 	m_freelist.emplace_back( index );
 }
 
@@ -167,4 +185,81 @@ Entity* EntityManager::world()
 {
 	// current world Entity index is always @ index 0 of m_worldEntitiesIndices
 	return m_entities[m_worldEntitiesIndices[0]].get();
+}
+
+EntityManager::EntityLocation& EntityManager::getLocation( const EntityId entId )
+{
+	if ( !isAlive( entId ) )
+	{
+		THROW_GAMEPLAY_EXCEPTION( "Invalid or dead Entity!" );
+	}
+	return m_locations[getEntityIndex( entId )];
+}
+
+std::uint32_t EntityManager::getArchetypeEdge( const std::uint32_t archetypeIndex,
+	const ComponentTypeId typeId )
+{
+	const std::uint32_t cached = m_archetypes[archetypeIndex]->getEdge( typeId );
+	if ( cached != Archetype::s_noEdge )
+	{
+		return cached;
+	}
+
+	const ComponentMask mask = m_archetypes[archetypeIndex]->getMask() ^ ( ComponentMask{1} << typeId );
+	std::uint32_t dstIndex;
+	const auto it = m_archetypeIndices.find( mask );
+	if ( it != m_archetypeIndices.end() )
+	{
+		dstIndex = it->second;
+	}
+	else
+	{
+		dstIndex = static_cast<std::uint32_t>( m_archetypes.size() );
+		m_archetypes.emplace_back( std::make_unique<Archetype>( mask ) );
+		m_archetypeIndices.emplace( mask, dstIndex );
+	}
+	m_archetypes[archetypeIndex]->setEdge( typeId, dstIndex );
+	m_archetypes[dstIndex]->setEdge( typeId, archetypeIndex );
+	return dstIndex;
+}
+
+void EntityManager::migrate( const EntityId entId,
+	EntityLocation &location,
+	const std::uint32_t dstIndex )
+{
+	Archetype &src = *m_archetypes[location.m_archetype];
+	Archetype &dst = *m_archetypes[dstIndex];
+	const std::uint32_t dstRow = dst.allocateRow( entId );
+	src.relocateRowTo( location.m_row, dst, dstRow );
+	const EntityId movedId = src.removeRow( location.m_row );
+	if ( movedId != s_invalidEntityId )
+	{
+		m_locations[getEntityIndex( movedId )].m_row = location.m_row;
+	}
+	location.m_archetype = dstIndex;
+	location.m_row = dstRow;
+}
+
+void EntityManager::addToBucket( Entity &entity,
+	EntityLocation &location )
+{
+	if ( entity.m_category == Entity::UNCATEGORIZED || entity.m_category == Entity::CLEANUP )
+	{
+		return;
+	}
+	location.m_bucketSlot = getBucket( entity.m_category ).appendEntity( &entity );
+}
+
+void EntityManager::removeFromBucket( Entity &entity,
+	EntityLocation &location )
+{
+	if ( entity.m_category == Entity::UNCATEGORIZED || entity.m_category == Entity::CLEANUP )
+	{
+		return;
+	}
+	Entity *pMoved = getBucket( entity.m_category ).removeEntity( location.m_bucketSlot );
+	if ( pMoved != nullptr )
+	{
+		m_locations[pMoved->m_index].m_bucketSlot = location.m_bucketSlot;
+	}
 }
\ No newline at end of file
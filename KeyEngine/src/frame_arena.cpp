@@ -0,0 +1,246 @@
+#include "frame_arena.h"
+#include <cstring>
+#include <algorithm>
+#include "key_exception.h"
+#include "assertions_console.h"
+
+
+namespace
+{
+
+constexpr std::size_t alignUp( const std::size_t n,
+	const std::size_t alignment ) noexcept
+{
+	return ( n + alignment - 1 ) & ~( alignment - 1 );
+}
+
+}// namespace
+
+
+FrameArena::FrameArena( const std::size_t capacity,
+	std::pmr::memory_resource *pUpstream )
+	:
+	m_pUpstream{pUpstream},
+	m_pBuffer{std::make_unique<std::byte[]>( alignUp( capacity, s_minAlignment ) )},
+	m_capacity{alignUp( capacity, s_minAlignment )}
+{
+#if defined _DEBUG && !defined NDEBUG
+	m_guardOffsets.reserve( s_maxTrackedGuards );
+	std::memset( m_pBuffer.get(), s_releasedByte, m_capacity );
+#endif
+}
+
+FrameArena::~FrameArena() noexcept
+{
+	releaseOverflows();
+}
+
+void FrameArena::reset()
+{
+	checkGuards();
+#if defined _DEBUG && !defined NDEBUG
+	std::memset( m_pBuffer.get(), s_releasedByte, m_offset );
+	m_guardOffsets.clear();
+#endif
+	const std::size_t nBytesRequested = m_offset + m_nOverflowBytes;
+	m_highWaterMark = std::max( m_highWaterMark, nBytesRequested );
+	releaseOverflows();
+	m_offset = 0;
+
+	// this cycle didn't fit, make room for it so the following ones stay off the upstream resource
+	if ( m_nOverflows > 0 )
+	{
+		m_capacity = alignUp( std::max( m_capacity * 2, nBytesRequested + nBytesRequested / 2 ), s_minAlignment );
+		m_pBuffer = std::make_unique<std::byte[]>( m_capacity );
+#if defined _DEBUG && !defined NDEBUG
+		std::memset( m_pBuffer.get(), s_releasedByte, m_capacity );
+#endif
+	}
+	m_nOverflowBytes = 0;
+	m_nOverflows = 0;
+}
+
+FrameArena::Stats FrameArena::getStats() const noexcept
+{
+	return {m_capacity, m_offset, m_nOverflowBytes, m_nOverflows, std::max( m_highWaterMark, m_offset + m_nOverflowBytes )};
+}
+
+std::size_t FrameArena::getCapacity() const noexcept
+{
+	return m_capacity;
+}
+
+void* FrameArena::do_allocate( const std::size_t nBytes,
+	const std::size_t alignment )
+{
+	const std::uintptr_t base = reinterpret_cast<std::uintptr_t>( m_pBuffer.get() );
+	const std::size_t offset = alignUp( base + m_offset, alignment ) - base;
+	std::size_t end = offset + nBytes;
+#if defined _DEBUG && !defined NDEBUG
+	end += s_guardSize;
+#endif
+	if ( end > m_capacity || end < offset )
+	{
+		return allocateOverflow( nBytes, alignment );
+	}
+
+	std::byte *p = m_pBuffer.get() + offset;
+	m_offset = end;
+#if defined _DEBUG && !defined NDEBUG
+	std::memset( p, s_allocatedByte, nBytes );
+	std::memset( p + nBytes, s_guardByte, s_guardSize );
+	if ( m_guardOffsets.size() < m_guardOffsets.capacity() )
+	{
+		m_guardOffsets.push_back( offset + nBytes );
+	}
+#endif
+	return p;
+}
+
+void FrameArena::do_deallocate( void *p,
+	const std::size_t nBytes,
+	const std::size_t alignment )
+{
+	pass_;
+}
+
+bool FrameArena::do_is_equal( const std::pmr::memory_resource &rhs ) const noexcept
+{
+	return this == &rhs;
+}
+
+void* FrameArena::allocateOverflow( const std::size_t nBytes,
+	const std::size_t alignment )
+{
+	// the header sits right before the returned memory, padded to keep it aligned
+	const std::size_t blockAlignment = std::max( alignment, alignof( Overflow ) );
+	const std::size_t headerSize = alignUp( sizeof( Overflow ), blockAlignment );
+	void *pBlock = m_pUpstream->allocate( headerSize + nBytes, blockAlignment );
+
+	Overflow *pOverflow = static_cast<Overflow*>( pBlock );
+	pOverflow->m_pNext = m_pOverflows;
+	pOverflow->m_nBytes = headerSize + nBytes;
+	pOverflow->m_alignment = blockAlignment;
+	m_pOverflows = pOverflow;
+	m_nOverflowBytes += nBytes;
+	++m_nOverflows;
+
+	std::byte *p = static_cast<std::byte*>( pBlock ) + headerSize;
+#if defined _DEBUG && !defined NDEBUG
+	std::memset( p, s_allocatedByte, nBytes );
+#endif
+	return p;
+}
+
+void FrameArena::releaseOverflows() noexcept
+{
+	while ( m_pOverflows != nullptr )
+	{
+		Overflow *pOverflow = m_pOverflows;
+		m_pOverflows = pOverflow->m_pNext;
+		m_pUpstream->deallocate( pOverflow, pOverflow->m_nBytes, pOverflow->m_alignment );
+	}
+}
+
+void FrameArena::checkGuards() const
+{
+#if defined _DEBUG && !defined NDEBUG
+	for ( const std::size_t offset : m_guardOffsets )
+	{
+		const std::byte *pGuard = m_pBuffer.get() + offset;
+		for ( std::size_t i = 0; i < s_guardSize; ++i )
+		{
+			ASSERT( pGuard[i] == std::byte{s_guardByte}, "FrameArena allocation overrun detected!" );
+		}
+	}
+#endif
+}
+
+
+thread_local FrameAllocator::ThreadSlot FrameAllocator::s_threadSlot;
+
+FrameAllocator::ThreadSlot::~ThreadSlot() noexcept
+{
+	if ( m_index != s_maxThreads )
+	{
+		FrameAllocator::getInstance().releaseThreadSlot( m_index );
+	}
+}
+
+FrameAllocator::FrameAllocator()
+	:
+	m_threadArenas(s_maxThreads)
+{
+	m_freeSlots.reserve( s_maxThreads );
+}
+
+FrameAllocator& FrameAllocator::getInstance()
+{
+	static FrameAllocator instance{};
+	return instance;
+}
+
+FrameArena& FrameAllocator::getThreadArena()
+{
+	const std::size_t threadIndex = getThreadIndex();
+	// only the owning thread creates its row, under the lock so endFrame doesn't see it half made
+	auto &arenas = m_threadArenas[threadIndex];
+	const unsigned frame = m_frame.load( std::memory_order_relaxed );
+	if ( arenas[frame] == nullptr )
+	{
+		std::lock_guard<std::mutex> lg{m_mu};
+		for ( auto &pArena : arenas )
+		{
+			pArena = std::make_unique<FrameArena>( s_initialArenaCapacity );
+		}
+	}
+	return *arenas[frame];
+}
+
+void FrameAllocator::endFrame()
+{
+	std::lock_guard<std::mutex> lg{m_mu};
+	const unsigned nextFrame = ( m_frame.load( std::memory_order_relaxed ) + 1 ) % s_nFramesInFlight;
+	for ( std::size_t i = 0; i < m_nSlots; ++i )
+	{
+		if ( m_threadArenas[i][nextFrame] != nullptr )
+		{
+			m_threadArenas[i][nextFrame]->reset();
+		}
+	}
+	m_frame.store( nextFrame, std::memory_order_relaxed );
+}
+
+unsigned FrameAllocator::getFrameSlot() const noexcept
+{
+	return m_frame.load( std::memory_order_relaxed );
+}
+
+std::size_t FrameAllocator::getThreadIndex()
+{
+	if ( s_threadSlot.m_index == s_maxThreads )
+	{
+		std::lock_guard<std::mutex> lg{m_mu};
+		if ( !m_freeSlots.empty() )
+		{
+			s_threadSlot.m_index = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else if ( m_nSlots < s_maxThreads )
+		{
+			s_threadSlot.m_index = m_nSlots++;
+		}
+		else
+		{
+			THROW_KEY_EXCEPTION( "Too many threads use the FrameAllocator!" );
+		}
+	}
+	return s_threadSlot.m_index;
+}
+
+void FrameAllocator::releaseThreadSlot( const std::size_t index ) noexcept
+{
+	// the slot's FrameArenas stay, the frame data allocated from them lives on until they're reset
+	std::lock_guard<std::mutex> lg{m_mu};
+	m_freeSlots.push_back( index );
+}
\ No newline at end of file
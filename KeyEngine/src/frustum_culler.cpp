@@ -0,0 +1,233 @@
+#include "frustum_culler.h"
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+#include "thread_poolj.h"
+#include "assertions_console.h"
+
+
+namespace dx = DirectX;
+
+FrustumCuller& FrustumCuller::getInstance()
+{
+	static FrustumCuller instance{};
+	return instance;
+}
+
+std::uint32_t FrustumCuller::acquireSlot()
+{
+	if ( m_freeSlots.empty() )
+	{
+		grow();
+	}
+	const std::uint32_t slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+	// unbounded & visible until its bounds are set
+	m_minX[slot] = m_minY[slot] = m_minZ[slot] = -s_unboundedExtent;
+	m_maxX[slot] = m_maxY[slot] = m_maxZ[slot] = s_unboundedExtent;
+	m_visibility[slot / 64] |= std::uint64_t{1} << ( slot % 64 );
+	return slot;
+}
+
+void FrustumCuller::releaseSlot( const std::uint32_t slot ) noexcept
+{
+	if ( slot == s_invalidSlot )
+	{
+		return;
+	}
+	m_minX[slot] = m_minY[slot] = m_minZ[slot] = FLT_MAX;
+	m_maxX[slot] = m_maxY[slot] = m_maxZ[slot] = -FLT_MAX;
+	m_visibility[slot / 64] &= ~( std::uint64_t{1} << ( slot % 64 ) );
+	m_freeSlots.push_back( slot );
+}
+
+void FrustumCuller::setBounds( const std::uint32_t slot,
+	const dx::XMFLOAT3 &localMin,
+	const dx::XMFLOAT3 &localMax,
+	const dx::XMFLOAT4X4 &worldTransform ) noexcept
+{
+	ASSERT( slot < m_nSlots, "Invalid culling slot!" );
+	const float center[3] = {( localMin.x + localMax.x ) * 0.5f, ( localMin.y + localMax.y ) * 0.5f, ( localMin.z + localMax.z ) * 0.5f};
+	const float extent[3] = {( localMax.x - localMin.x ) * 0.5f, ( localMax.y - localMin.y ) * 0.5f, ( localMax.z - localMin.z ) * 0.5f};
+
+	// row vectors: p' = p * M
+	float worldCenter[3];
+	float worldExtent[3];
+	for ( int j = 0; j < 3; ++j )
+	{
+		worldCenter[j] = worldTransform.m[3][j];
+		worldExtent[j] = 0.0f;
+		for ( int i = 0; i < 3; ++i )
+		{
+			worldCenter[j] += center[i] * worldTransform.m[i][j];
+			worldExtent[j] += extent[i] * std::abs( worldTransform.m[i][j] );
+		}
+	}
+
+	m_minX[slot] = worldCenter[0] - worldExtent[0];
+	m_minY[slot] = worldCenter[1] - worldExtent[1];
+	m_minZ[slot] = worldCenter[2] - worldExtent[2];
+	m_maxX[slot] = worldCenter[0] + worldExtent[0];
+	m_maxY[slot] = worldCenter[1] + worldExtent[1];
+	m_maxZ[slot] = worldCenter[2] + worldExtent[2];
+}
+
+void FrustumCuller::cull( const std::array<dx::XMFLOAT4, 6> &frustumPlanes )
+{
+	const std::size_t nWords = m_visibility.size();
+	if ( m_nSlots < s_parallelThreshold )
+	{
+		cullRange( frustumPlanes.data(), 0, nWords );
+		return;
+	}
+
+	// chunks are whole bitset words so no two threads ever write the same word
+	ThreadPoolJ::getInstance().parallelFor( 0, nWords, s_wordsPerTask,
+		[this, &frustumPlanes] ( const std::size_t firstWord, const std::size_t lastWord )
+		{
+			cullRange( frustumPlanes.data(), firstWord, lastWord );
+		} );
+}
+
+void FrustumCuller::setAllVisible() noexcept
+{
+	for ( auto &word : m_visibility )
+	{
+		word = ~std::uint64_t{0};
+	}
+}
+
+bool FrustumCuller::isVisible( const std::uint32_t slot ) const noexcept
+{
+	if ( slot == s_invalidSlot )
+	{
+		return true;
+	}
+	return ( m_visibility[slot / 64] >> ( slot % 64 ) ) & 1u;
+}
+
+std::size_t FrustumCuller::getSlotCount() const noexcept
+{
+	return m_nSlots;
+}
+
+bool FrustumCuller::isAabbCulled( const dx::XMFLOAT4 *frustumPlanes,
+	const dx::XMFLOAT3 &bmin,
+	const dx::XMFLOAT3 &bmax ) noexcept
+{
+	for ( int i = 0; i < 6; ++i )
+	{
+		const dx::XMFLOAT4 &plane = frustumPlanes[i];
+		// AABB vertex furthest along the direction the plane normal is facing
+		const float x = plane.x < 0.0f ? bmin.x : bmax.x;
+		const float y = plane.y < 0.0f ? bmin.y : bmax.y;
+		const float z = plane.z < 0.0f ? bmin.z : bmax.z;
+		// if even that vertex is behind the plane then the entire bounding box is
+		if ( plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FrustumCuller::cullRange( const dx::XMFLOAT4 *frustumPlanes,
+	const std::size_t firstWord,
+	const std::size_t lastWord ) noexcept
+{
+	// the plane normal is the same for the whole batch, so picking the positive vertex is just picking the min or max array per axis
+	const float *px[6];
+	const float *py[6];
+	const float *pz[6];
+	for ( int i = 0; i < 6; ++i )
+	{
+		px[i] = frustumPlanes[i].x < 0.0f ? m_minX.data() : m_maxX.data();
+		py[i] = frustumPlanes[i].y < 0.0f ? m_minY.data() : m_maxY.data();
+		pz[i] = frustumPlanes[i].z < 0.0f ? m_minZ.data() : m_maxZ.data();
+	}
+
+#if defined __AVX__
+	__m256 planeX[6];
+	__m256 planeY[6];
+	__m256 planeZ[6];
+	__m256 planeW[6];
+	for ( int i = 0; i < 6; ++i )
+	{
+		planeX[i] = _mm256_set1_ps( frustumPlanes[i].x );
+		planeY[i] = _mm256_set1_ps( frustumPlanes[i].y );
+		planeZ[i] = _mm256_set1_ps( frustumPlanes[i].z );
+		planeW[i] = _mm256_set1_ps( frustumPlanes[i].w );
+	}
+	const __m256 zero = _mm256_setzero_ps();
+
+	for ( std::size_t word = firstWord; word < lastWord; ++word )
+	{
+		std::uint64_t bits = 0;
+		for ( std::size_t batch = 0; batch < 64; batch += 8 )
+		{
+			const std::size_t b = word * 64 + batch;
+			__m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+			for ( int i = 0; i < 6; ++i )
+			{
+				__m256 d = _mm256_add_ps( _mm256_mul_ps( planeX[i], _mm256_loadu_ps( px[i] + b ) ), planeW[i] );
+				d = _mm256_add_ps( _mm256_mul_ps( planeY[i], _mm256_loadu_ps( py[i] + b ) ), d );
+				d = _mm256_add_ps( _mm256_mul_ps( planeZ[i], _mm256_loadu_ps( pz[i] + b ) ), d );
+				inside = _mm256_and_ps( inside, _mm256_cmp_ps( d, zero, _CMP_GE_OQ ) );
+			}
+			bits |= static_cast<std::uint64_t>( _mm256_movemask_ps( inside ) ) << batch;
+		}
+		m_visibility[word] = bits;
+	}
+#else
+	__m128 planeX[6];
+	__m128 planeY[6];
+	__m128 planeZ[6];
+	__m128 planeW[6];
+	for ( int i = 0; i < 6; ++i )
+	{
+		planeX[i] = _mm_set1_ps( frustumPlanes[i].x );
+		planeY[i] = _mm_set1_ps( frustumPlanes[i].y );
+		planeZ[i] = _mm_set1_ps( frustumPlanes[i].z );
+		planeW[i] = _mm_set1_ps( frustumPlanes[i].w );
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for ( std::size_t word = firstWord; word < lastWord; ++word )
+	{
+		std::uint64_t bits = 0;
+		for ( std::size_t batch = 0; batch < 64; batch += 4 )
+		{
+			const std::size_t b = word * 64 + batch;
+			__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+			for ( int i = 0; i < 6; ++i )
+			{
+				__m128 d = _mm_add_ps( _mm_mul_ps( planeX[i], _mm_loadu_ps( px[i] + b ) ), planeW[i] );
+				d = _mm_add_ps( _mm_mul_ps( planeY[i], _mm_loadu_ps( py[i] + b ) ), d );
+				d = _mm_add_ps( _mm_mul_ps( planeZ[i], _mm_loadu_ps( pz[i] + b ) ), d );
+				inside = _mm_and_ps( inside, _mm_cmpge_ps( d, zero ) );
+			}
+			bits |= static_cast<std::uint64_t>( _mm_movemask_ps( inside ) ) << batch;
+		}
+		m_visibility[word] = bits;
+	}
+#endif
+}
+
+void FrustumCuller::grow()
+{
+	// add another 64 slots (one bitset word)
+	const std::size_t oldCount = m_nSlots;
+	m_nSlots += 64;
+	m_minX.resize( m_nSlots, FLT_MAX );
+	m_minY.resize( m_nSlots, FLT_MAX );
+	m_minZ.resize( m_nSlots, FLT_MAX );
+	m_maxX.resize( m_nSlots, -FLT_MAX );
+	m_maxY.resize( m_nSlots, -FLT_MAX );
+	m_maxZ.resize( m_nSlots, -FLT_MAX );
+	m_visibility.resize( m_nSlots / 64, 0u );
+	// hand out lower slots first
+	for ( std::size_t slot = m_nSlots; slot-- > oldCount; )
+	{
+		m_freeSlots.push_back( static_cast<std::uint32_t>( slot ) );
+	}
+}
\ No newline at end of file
@@ -21,6 +21,9 @@
 #include "line.h"
 #include "plane.h"
 #include "global_constants.h"
+#include "frustum_culler.h"
+#include "thread_poolj.h"
+#include "frame_arena.h"
 #ifndef FINAL_RELEASE
 #	include "imgui/imgui.h"
 #	include "imgui_visitors.h"
@@ -456,10 +459,15 @@ void Sandbox3d::update( Graphics &gfx,
 
 	m_terrain.update( dt, lerpBetweenFrames, settings.bEnableSmoothMovement );
 
-	for ( auto &model : m_models )
-	{
-		model.update( dt, lerpBetweenFrames, settings.bEnableSmoothMovement );
-	}
+	// Models' transform hierarchies are independent of each other
+	ThreadPoolJ::getInstance().parallelFor( 0, m_models.size(), 1,
+		[&] ( const std::size_t first, const std::size_t last )
+		{
+			for ( std::size_t i = first; i < last; ++i )
+			{
+				m_models[i].update( dt, lerpBetweenFrames, settings.bEnableSmoothMovement );
+			}
+		} );
 
 	auto &mouse = m_mainWindow.getMouse();
 	gui::Point ui_point{mouse.getX(), mouse.getY()};
@@ -473,8 +481,21 @@ void Sandbox3d::updateFixed( const float dt )
 
 void Sandbox3d::render( Graphics &gfx )
 {
+	static const auto &settings = s_settingsMan.getSettings();
+
 	gfx.beginFrame();
 
+	// cull every Mesh in one batch, Meshes then just look up their visibility bit
+	auto &frustumCuller = FrustumCuller::getInstance();
+	if ( settings.bEnableFrustumCuling )
+	{
+		frustumCuller.cull( s_cameraMan.getActiveCamera().getFrustumPlanes() );
+	}
+	else
+	{
+		frustumCuller.setAllVisible();
+	}
+
 	s_cameraMan.render( rch::opaque | rch::wireframe );
 
 	for ( auto &pLight : m_lights )
@@ -492,7 +513,7 @@ void Sandbox3d::render( Graphics &gfx )
 	{
 		static const auto &settings = s_settingsMan.getSettings();
 
-		std::vector<ILightSource*> shadowCastingUnculledLights;
+		std::pmr::vector<ILightSource*> shadowCastingUnculledLights{&FrameAllocator::getInstance().getThreadArena()};
 		shadowCastingUnculledLights.reserve( settings.iMaxShadowCastingDynamicLights );
 		for ( const auto &pLight : m_lights )
 		{
@@ -3,9 +3,13 @@
 #include "geometry.h"
 #include <DirectXMath.h>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
 #include "math_utils.h"
 #include "assertions_console.h"
-#include "bmp_loader.h"
+#include "bmp_codec.h"
+#include "thread_poolj.h"
 
 
 namespace dx = DirectX;
@@ -410,7 +414,8 @@ TriangleMesh makePlanarGridTexturedFromHeighmap( const std::string &filename,
 	const int length /*= 2*/,
 	const int width /*= 2*/,
 	int nDivisionsX /*= 1*/,
-	int nDivisionsY /*= 1*/ )
+	int nDivisionsY /*= 1*/,
+	const bool bBilinearFiltering /*= false*/ )
 {
 	ASSERT( length >= 2, "Length has to be greater than 1!" );
 	ASSERT( width >= 2, "Width has to be greater than 1!" );
@@ -424,92 +429,190 @@ TriangleMesh makePlanarGridTexturedFromHeighmap( const std::string &filename,
 		nDivisionsY = 2;
 	}
 
-	const int nVerticesX = nDivisionsX + 1;
-	const int nVerticesY = nDivisionsY + 1;
-
-	// setup the heightmap
-	BmpLoader bmp{filename};
-	const size_t imageWidth = bmp.getWidth();
-	const size_t imageHeight = bmp.getHeight();
-	const size_t numImageElements = imageWidth * imageHeight;
-	BmpLoader::ImageData *img = new BmpLoader::ImageData[numImageElements];
-
-	ASSERT( bmp.getBitCount() == 24, "Not made to handle non-24bit width heightmaps!" );	// #TODO: rework this into a try catch exception where you release `img`
+	const std::size_t nVerticesX = static_cast<std::size_t>( nDivisionsX ) + 1;
+	const std::size_t nVerticesY = static_cast<std::size_t>( nDivisionsY ) + 1;
+	auto &threadPool = ThreadPoolJ::getInstance();
+
+	// decode the heightmap, rows are independent of each other
+	const bmp::BmpReader heightmap{filename};
+	const unsigned imageWidth = heightmap.getWidth();
+	const unsigned imageHeight = heightmap.getHeight();
+	std::vector<ColorBGRA> texels( static_cast<std::size_t>( imageWidth ) * imageHeight );
+	threadPool.parallelFor( 0u, imageHeight, 0u,
+		[&] ( const std::size_t first, const std::size_t last )
+		{
+			heightmap.readRows( static_cast<unsigned>( first ), static_cast<unsigned>( last - first ), texels.data() + first * imageWidth );
+		} );
 
-	bmp.readData( img );
-	if ( normalizeAmount )
+	// resample the image over the whole grid, grid row 0 is the top row of the image
+	// the height grid is padded with a clamped border so the central differences of the normals need no special cases at the edges
+	const std::size_t paddedWidth = nVerticesX + 2;
+	std::vector<float> heights( paddedWidth * ( nVerticesY + 2 ) );
 	{
-		bmp.normalizeHeightmap( img, normalizeAmount );
-	}
+		const float heightScale = normalizeAmount > 0 ? 1.0f / normalizeAmount : 1.0f;
+		const float imageDx = float( imageWidth - 1 ) / float( nDivisionsX );
+		const float imageDy = float( imageHeight - 1 ) / float( nDivisionsY );
+		const auto texelHeight = [&] ( const unsigned x, const unsigned y ) -> float
+			{
+				return float( texels[static_cast<std::size_t>( y ) * imageWidth + x].getBlue() ) * heightScale;
+			};
 
-	const int imageDx = 3 * ( std::max( util::floor( (float) imageWidth / nVerticesX ), 1 ) );	// * 3 because the height value is replicated 3 times in this 24bit heightmap
+		threadPool.parallelFor( 0u, nVerticesY, 0u,
+			[&] ( const std::size_t first, const std::size_t last )
+			{
+				for ( std::size_t y = first; y < last; ++y )
+				{
+					float *pRow = heights.data() + ( y + 1 ) * paddedWidth + 1;
+					const float fy = float( y ) * imageDy;
+					if ( bBilinearFiltering )
+					{
+						const unsigned y0 = std::min( static_cast<unsigned>( fy ), imageHeight - 1 );
+						const unsigned y1 = std::min( y0 + 1, imageHeight - 1 );
+						const float ty = fy - float( y0 );
+						for ( std::size_t x = 0; x < nVerticesX; ++x )
+						{
+							const float fx = float( x ) * imageDx;
+							const unsigned x0 = std::min( static_cast<unsigned>( fx ), imageWidth - 1 );
+							const unsigned x1 = std::min( x0 + 1, imageWidth - 1 );
+							const float tx = fx - float( x0 );
+							const float top = texelHeight( x0, y0 ) + ( texelHeight( x1, y0 ) - texelHeight( x0, y0 ) ) * tx;
+							const float bottom = texelHeight( x0, y1 ) + ( texelHeight( x1, y1 ) - texelHeight( x0, y1 ) ) * tx;
+							pRow[x] = top + ( bottom - top ) * ty;
+						}
+					}
+					else
+					{
+						const unsigned iy = std::min( static_cast<unsigned>( fy + 0.5f ), imageHeight - 1 );
+						for ( std::size_t x = 0; x < nVerticesX; ++x )
+						{
+							pRow[x] = texelHeight( std::min( static_cast<unsigned>( float( x ) * imageDx + 0.5f ), imageWidth - 1 ), iy );
+						}
+					}
+					pRow[-1] = pRow[0];
+					pRow[nVerticesX] = pRow[nVerticesX - 1];
+				}
+			} );
+		std::copy_n( heights.data() + paddedWidth, paddedWidth, heights.data() );
+		std::copy_n( heights.data() + nVerticesY * paddedWidth, paddedWidth, heights.data() + ( nVerticesY + 1 ) * paddedWidth );
+	}
+	texels = std::vector<ColorBGRA>{};
 
 	// setup the Input Layout
 	ver::VertexInputLayout layout;
 	layout.add( ver::VertexInputLayout::Position3D );
 	layout.add( ver::VertexInputLayout::Normal );
 	layout.add( ver::VertexInputLayout::Texture2D );
+	ASSERT( layout.fetch<ver::VertexInputLayout::Position3D>().getOffset() == 0 && layout.fetch<ver::VertexInputLayout::Normal>().getOffset() == 3 * sizeof( float ) && layout.fetch<ver::VertexInputLayout::Texture2D>().getOffset() == 6 * sizeof( float ) && layout.getSizeInBytes() == 8 * sizeof( float ), "The vertices are written as packed P3N3T2!" );
 
-	// setup the vb
-	ver::VBuffer vb{std::move( layout )};
+	// setup the vb, sized once & filled in place
+	// add the height to the z coordinate (and not to the y - height) because the grid is not created on the x-y plane - we will pass an initialRotation to it upon creation
+	// the normal of the heightfield z = h(x, y) facing -z is normalize( dh/dx, dh/dy, -1 ), taken from the central differences of the heights
+	ver::VBuffer vb{std::move( layout ), nVerticesX * nVerticesY};
 	{
+		float *pVertices = reinterpret_cast<float*>( vb.data() );
+		const float multiplier = float( terrainAreaUnitMultiplier );
 		const float halfLength = length / 2.0f;
 		const float halfWidth = width / 2.0f;
 		const float segmentLength = length / float( nDivisionsX );
 		const float segmentWidth = width / float( nDivisionsY );
 		const float du = 1.0f / float( nDivisionsX );	// u & v range /in [0,1]
 		const float dv = 1.0f / float( nDivisionsY );
+		const float invTwoDx = 1.0f / ( 2.0f * segmentLength * multiplier );
+		const float invTwoDy = 1.0f / ( 2.0f * segmentWidth * multiplier );
 
-		for ( int y = 0; y < nVerticesY; ++y )
-		{
-			const float yPos = float( y ) * segmentWidth - halfWidth;
-			const float vPos = 1.0f - float( y ) * dv;
-			for ( int x = 0; x < nVerticesX; ++x )
+		threadPool.parallelFor( 0u, nVerticesY, 0u,
+			[&] ( const std::size_t first, const std::size_t last )
 			{
-				const float xPos = float( x ) * segmentLength - halfLength;
-				const float uPos = float( x ) * du;
-
-				const float heightValue = static_cast<uint8_t>(img[y * imageWidth + x * imageDx]._24bit.b);
-
-				// add the heightValue to the z coordinate (and not to the y - height) because the grid is not created on the x-y plane - we will pass an initialRotation to it upon creation
-				vb.emplaceVertex( DirectX::XMFLOAT3{xPos * terrainAreaUnitMultiplier, yPos * terrainAreaUnitMultiplier, heightValue}, DirectX::XMFLOAT3{0.0f, 0.0f, -1.0f}, DirectX::XMFLOAT2{uPos, vPos} );
-			}
-		}
+				const __m128 lanes = _mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f );
+				const __m128 one = _mm_set1_ps( 1.0f );
+				const __m128 signBit = _mm_set1_ps( -0.0f );
+				const __m128 segmentLength4 = _mm_set1_ps( segmentLength );
+				const __m128 halfLength4 = _mm_set1_ps( halfLength );
+				const __m128 multiplier4 = _mm_set1_ps( multiplier );
+				const __m128 invTwoDx4 = _mm_set1_ps( invTwoDx );
+				const __m128 invTwoDy4 = _mm_set1_ps( invTwoDy );
+				const __m128 du4 = _mm_set1_ps( du );
+				for ( std::size_t y = first; y < last; ++y )
+				{
+					const float yPos = ( float( y ) * segmentWidth - halfWidth ) * multiplier;
+					const float vPos = 1.0f - float( y ) * dv;
+					const float *pRow = heights.data() + ( y + 1 ) * paddedWidth + 1;
+					const float *pPreviousRow = pRow - paddedWidth;
+					const float *pNextRow = pRow + paddedWidth;
+					float *pOut = pVertices + y * nVerticesX * 8;
+
+					// 4 vertices at a time: computed as SoA, transposed to 2 AoS halves per vertex
+					std::size_t x = 0;
+					for ( ; x + 4 <= nVerticesX; x += 4, pOut += 32 )
+					{
+						const __m128 xs = _mm_add_ps( _mm_set1_ps( float( x ) ), lanes );
+						const __m128 hx = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pRow + x + 1 ), _mm_loadu_ps( pRow + x - 1 ) ), invTwoDx4 );
+						const __m128 hy = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( pNextRow + x ), _mm_loadu_ps( pPreviousRow + x ) ), invTwoDy4 );
+						const __m128 invNormalLength = _mm_div_ps( one, _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( hx, hx ), _mm_mul_ps( hy, hy ) ), one ) ) );
+
+						__m128 px = _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( xs, segmentLength4 ), halfLength4 ), multiplier4 );
+						__m128 py = _mm_set1_ps( yPos );
+						__m128 pz = _mm_loadu_ps( pRow + x );
+						__m128 nx = _mm_mul_ps( hx, invNormalLength );
+						_MM_TRANSPOSE4_PS( px, py, pz, nx );
+						__m128 ny = _mm_mul_ps( hy, invNormalLength );
+						__m128 nz = _mm_xor_ps( invNormalLength, signBit );
+						__m128 u = _mm_mul_ps( xs, du4 );
+						__m128 v = _mm_set1_ps( vPos );
+						_MM_TRANSPOSE4_PS( ny, nz, u, v );
+
+						_mm_storeu_ps( pOut, px );
+						_mm_storeu_ps( pOut + 4, ny );
+						_mm_storeu_ps( pOut + 8, py );
+						_mm_storeu_ps( pOut + 12, nz );
+						_mm_storeu_ps( pOut + 16, pz );
+						_mm_storeu_ps( pOut + 20, u );
+						_mm_storeu_ps( pOut + 24, nx );
+						_mm_storeu_ps( pOut + 28, v );
+					}
+					for ( ; x < nVerticesX; ++x, pOut += 8 )
+					{
+						const float hx = ( pRow[x + 1] - pRow[x - 1] ) * invTwoDx;
+						const float hy = ( pNextRow[x] - pPreviousRow[x] ) * invTwoDy;
+						const float invNormalLength = 1.0f / std::sqrt( hx * hx + hy * hy + 1.0f );
+						pOut[0] = ( float( x ) * segmentLength - halfLength ) * multiplier;
+						pOut[1] = yPos;
+						pOut[2] = pRow[x];
+						pOut[3] = hx * invNormalLength;
+						pOut[4] = hy * invNormalLength;
+						pOut[5] = -invNormalLength;
+						pOut[6] = float( x ) * du;
+						pOut[7] = vPos;
+					}
+				}
+			} );
 	}
 
-	// heightmap has been read so delete the memory consumed by its associated image data array
-	delete[] img;
-
-	// setup the indices
-	std::vector<unsigned> indices;
-	indices.reserve( nDivisionsX * nDivisionsY * 6 );
-	const auto calcCoords = [nVerticesX] ( const size_t x, const size_t y )
-	{
-		return (unsigned)( y * nVerticesX + x );
-	};
-
-	for ( size_t y = 0; y < nDivisionsY; ++y )
-	{
-		for ( size_t x = 0; x < nDivisionsX; ++x )
+	// setup the indices, each quad needs 6
+	std::vector<unsigned> indices( static_cast<std::size_t>( nDivisionsX ) * nDivisionsY * 6 );
+	threadPool.parallelFor( 0u, static_cast<std::size_t>( nDivisionsY ), 0u,
+		[&] ( const std::size_t first, const std::size_t last )
 		{
-			const std::array<unsigned, 4> indexArray =
+			for ( std::size_t y = first; y < last; ++y )
 			{
-				calcCoords( x, y ),
-				calcCoords( x + 1, y ),
-				calcCoords( x, y + 1 ),
-				calcCoords( x + 1, y + 1 )
-			};
-			// each quad needs 6 indices
-			indices.push_back( indexArray[0] );
-			indices.push_back( indexArray[2] );
-			indices.push_back( indexArray[1] );
-			indices.push_back( indexArray[1] );
-			indices.push_back( indexArray[2] );
-			indices.push_back( indexArray[3] );
-		}
-	}
+				unsigned *pOut = indices.data() + y * nDivisionsX * 6;
+				for ( std::size_t x = 0; x < static_cast<std::size_t>( nDivisionsX ); ++x, pOut += 6 )
+				{
+					const unsigned a = static_cast<unsigned>( y * nVerticesX + x );
+					const unsigned b = a + 1;
+					const unsigned c = a + static_cast<unsigned>( nVerticesX );
+					const unsigned d = c + 1;
+					pOut[0] = a;
+					pOut[1] = c;
+					pOut[2] = b;
+					pOut[3] = b;
+					pOut[4] = c;
+					pOut[5] = d;
+				}
+			}
+		} );
 
-	return {vb, indices};
+	return {std::move( vb ), std::move( indices )};
 }
 
 TriangleMesh makeCameraWidget()
@@ -17,11 +17,14 @@
 #include "graphics_mode.h"
 #include "rectangle.h"
 #include "texture.h"
+#include "cpu_framebuffer.h"
+#include "software_rasterizer.h"
 #include "math_utils.h"
 #include "renderer.h"
 #include "camera_manager.h"
 #include "camera.h"
 #include "vtune_itt_domain.h"
+#include "frame_arena.h"
 
 #pragma comment( lib, "dxgi.lib" )
 #pragma comment( lib, "d3d11.lib" )
@@ -101,7 +104,6 @@ Graphics::Graphics( const HWND hWnd,
 	if ( settings.bMultithreadedRendering )
 	{
 		m_deferredContexts.reserve( settings.nRenderingThreads );
-		m_commandLists.reserve( settings.nRenderingThreads );
 	}
 
 	// create factory, adapter, device, device rendering context(s), front|back buffers swap chain, output device
@@ -229,7 +231,8 @@ Graphics::Graphics( const HWND hWnd,
 	}
 	else
 	{
-		m_pCpuBuffer = static_cast<ColorBGRA*>( _aligned_malloc( sizeof( ColorBGRA ) * width * height, 16u ) );
+		m_pCpuFramebuffer = std::make_unique<CpuFramebuffer>( width, height, settings.bDoubleBufferedCpuFramebuffer );
+		m_pSoftwareRasterizer = std::make_unique<SoftwareRasterizer>( *m_pCpuFramebuffer );
 	}
 
 	if ( settings.bVSync )
@@ -251,8 +254,8 @@ Graphics::~Graphics()
 	}
 	else
 	{
-		_aligned_free( m_pCpuBuffer );
-		m_pCpuBuffer = nullptr;
+		m_pSoftwareRasterizer.reset();
+		m_pCpuFramebuffer.reset();
 	}
 	cleanState();
 #if defined _DEBUG && !defined NDEBUG
@@ -401,6 +404,12 @@ size_t Graphics::getFrameNum() const noexcept
 
 void Graphics::runRenderer() noexcept
 {
+	if constexpr ( gph_mode::get() == gph_mode::_2D )
+	{
+		// the frame is drawn, its changes are uploaded by the 2d pass
+		m_pSoftwareRasterizer->flush();
+		m_pCpuFramebuffer->endFrame();
+	}
 	m_pRenderer->run( *this );
 }
 
@@ -473,13 +482,9 @@ void Graphics::cleanState() noexcept
 	{
 		clearShaderSlots();
 		m_pImmediateContext->ClearState();	// release all bindable state and set a default state
-		for ( auto dc : m_commandLists )
+		for ( auto &pDeferredContext : m_deferredContexts )
 		{
-			if ( dc )
-			{
-				m_pImmediateContext->FinishCommandList( FALSE, &dc );
-				dc->Release();
-			}
+			pDeferredContext->m_pCommandList.Reset();	// drop command lists that were never executed
 		}
 		m_pImmediateContext->Flush();		// flush any remaining commands
 	}
@@ -510,8 +515,7 @@ void Graphics::beginFrame() noexcept
 	}
 	else
 	{
-		static size_t cpuBuffer2dSize = (size_t)m_width * m_height * sizeof ColorBGRA;
-		memset( m_pCpuBuffer, 0u, cpuBuffer2dSize );
+		m_pCpuFramebuffer->beginFrame();
 	}
 	PROFILE_VTUNE_ITT_TASK_END;
 }
@@ -519,6 +523,7 @@ void Graphics::beginFrame() noexcept
 void Graphics::endFrame()
 {
 	m_pRenderer->reset();
+	FrameAllocator::getInstance().endFrame();
 	PROFILE_VTUNE_ITT_TASK_BEGIN( pStrIttEndRendering );
 	if constexpr ( gph_mode::get() == gph_mode::_3D )
 	{
@@ -577,66 +582,73 @@ void Graphics::present()
 
 void Graphics::draw( const unsigned count ) cond_noex
 {
-	m_pImmediateContext->Draw( count, 0u );
+	getCurrentContext()->Draw( count, 0u );
 	DXGI_GET_QUEUE_INFO_GFX;
 }
 
-void Graphics::drawIndexed( const unsigned count ) cond_noex
+void Graphics::drawIndexed( const unsigned count,
+	const unsigned startIndex /*= 0u*/,
+	const int baseVertex /*= 0*/ ) cond_noex
 {
 	PROFILE_VTUNE_ITT_TASK_BEGIN( pStrIttDrawIndexed );
-	SettingsManager &setMan = SettingsManager::getInstance();
-	if ( setMan.getSettings().bMultithreadedRendering )
-	{
-		playbackDeferredCommandList();
-	}
-	else
-	{
-		m_pImmediateContext->DrawIndexed( count, 0u, 0u );
-	}
+	getCurrentContext()->DrawIndexed( count, startIndex, baseVertex );
 	DXGI_GET_QUEUE_INFO_GFX;
 	PROFILE_VTUNE_ITT_TASK_END;
 }
 
 void Graphics::drawIndexedInstanced( const unsigned indexCount,
-	const unsigned instanceCount ) cond_noex
+	const unsigned instanceCount,
+	const unsigned firstInstance /*= 0u*/,
+	const unsigned startIndex /*= 0u*/ ) cond_noex
 {
 	PROFILE_VTUNE_ITT_TASK_BEGIN( pStrIttDrawIndexedInstanced );
-	SettingsManager &setMan = SettingsManager::getInstance();
-	if ( setMan.getSettings().bMultithreadedRendering )
-	{
-
-	}
-	else
-	{
-		//m_pImmediateContext->DrawIndexedInstanced();
-	}
+	getCurrentContext()->DrawIndexedInstanced( indexCount, instanceCount, startIndex, 0, firstInstance );
 	DXGI_GET_QUEUE_INFO_GFX;
 	PROFILE_VTUNE_ITT_TASK_END;
 }
 
-ColorBGRA*& Graphics::cpuBuffer()
+CpuFramebuffer& Graphics::cpuFramebuffer()
+{
+	return *m_pCpuFramebuffer;
+}
+
+SoftwareRasterizer& Graphics::softwareRasterizer()
 {
-	return m_pCpuBuffer;
+	return *m_pSoftwareRasterizer;
 }
 
 void Graphics::setViewMatrix( const dx::XMMATRIX &cam ) noexcept
 {
+	if ( s_pRecordingContext != nullptr )
+	{
+		s_pRecordingContext->m_view = cam;
+		return;
+	}
 	m_view = cam;
 }
 
 void Graphics::setProjectionMatrix( const dx::XMMATRIX &proj ) noexcept
 {
+	if ( s_pRecordingContext != nullptr )
+	{
+		s_pRecordingContext->m_projection = proj;
+		return;
+	}
 	m_projection = proj;
 }
 
 const dx::XMMATRIX& Graphics::getViewMatrix() const noexcept
 {
-	return m_view;
+	return s_pRecordingContext != nullptr ?
+		s_pRecordingContext->m_view :
+		m_view;
 }
 
 const dx::XMMATRIX& Graphics::getProjectionMatrix() const noexcept
 {
-	return m_projection;
+	return s_pRecordingContext != nullptr ?
+		s_pRecordingContext->m_projection :
+		m_projection;
 }
 
 unsigned Graphics::getClientWidth() const noexcept
@@ -761,24 +773,57 @@ bool& Graphics::getDisplayMode()
 	return m_bFullscreenMode;
 }
 
-void Graphics::recordDeferredCommandList()
+void Graphics::reserveDeferredContexts( const std::size_t nContexts )
 {
-	//HRESULT hres;
-	//hres = m_pDevice->CreateDeferredContext( 0, &pDeferredContexts );
-	//// Use the deferred context to render:
-	//float ClearColor[4] = { 0.0f, 0.125f, 0.3f, 1.0f };
-	//pDeferredContexts->ClearRenderTargetView( pRenderTargetView, ClearColor );
-	//// Add additional rendering commands
-	//// ...
-	//hres = pDeferredContexts->FinishCommandList( FALSE, &pCommandList);
+	HRESULT hres;
+	while ( m_deferredContexts.size() < nContexts )
+	{
+		auto pDeferredContext = std::make_unique<DeferredContext>();
+		hres = m_pDevice->CreateDeferredContext( 0u, &pDeferredContext->m_pContext );
+		ASSERT_HRES_IF_FAILED;
+#if defined _DEBUG && !defined NDEBUG
+		const std::string deferredContextName = "DeferredContext#" + std::to_string( m_deferredContexts.size() );
+		pDeferredContext->m_pContext->SetPrivateData( WKPDID_D3DDebugObjectName, (UINT) deferredContextName.size(), deferredContextName.c_str() );
+#endif
+		m_deferredContexts.emplace_back( std::move( pDeferredContext ) );
+	}
 }
 
-void Graphics::playbackDeferredCommandList()
+void Graphics::beginRecording( const std::size_t index ) cond_noex
 {
-	//if( pCommandList )
-	//{
-	//	m_pImmediateContext->ExecuteCommandList( pCommandList, TRUE );
-	//}
+	ASSERT( index < m_deferredContexts.size(), "Deferred context index out of range!" );
+	ASSERT( s_pRecordingContext == nullptr, "This thread is already recording!" );
+	DeferredContext &deferredContext = *m_deferredContexts[index];
+	deferredContext.m_view = m_view;
+	deferredContext.m_projection = m_projection;
+	s_pRecordingContext = &deferredContext;
+}
+
+void Graphics::finishRecording( const std::size_t index ) cond_noex
+{
+	DeferredContext &deferredContext = *m_deferredContexts[index];
+	ASSERT( s_pRecordingContext == &deferredContext, "This thread is not recording on this deferred context!" );
+	// FALSE: the deferred context starts the next recording from the default state, same as the immediate context after ExecuteCommandList
+	HRESULT hres = deferredContext.m_pContext->FinishCommandList( FALSE, &deferredContext.m_pCommandList );
+	ASSERT_HRES_IF_FAILED;
+	s_pRecordingContext = nullptr;
+}
+
+void Graphics::executeCommandList( const std::size_t index ) cond_noex
+{
+	ASSERT( s_pRecordingContext == nullptr, "Command lists must be executed on the immediate context!" );
+	DeferredContext &deferredContext = *m_deferredContexts[index];
+	ASSERT( deferredContext.m_pCommandList, "Nothing was recorded!" );
+	m_pImmediateContext->ExecuteCommandList( deferredContext.m_pCommandList.Get(), FALSE );
+	DXGI_GET_QUEUE_INFO_GFX;
+	deferredContext.m_pCommandList.Reset();
+}
+
+ID3D11DeviceContext* Graphics::getCurrentContext() noexcept
+{
+	return s_pRecordingContext != nullptr ?
+		s_pRecordingContext->m_pContext.Get() :
+		m_pImmediateContext.Get();
 }
 
 void Graphics::createFactory()
@@ -897,22 +942,14 @@ void Graphics::d3d11DebugReport()
 ColorBGRA Graphics::getPixel( const int x,
 	const int y ) const noexcept
 {
-	ASSERT( x >= 0, "!( x >= 0 )" );
-	ASSERT( x < (int) m_width, "!( x < width )" );
-	ASSERT( y >= 0, "!( y >= 0)" );
-	ASSERT( y < (int) m_height, "!( y < height )" );
-	return m_pCpuBuffer[m_width * y + x];
+	return m_pCpuFramebuffer->getPixel( x, y );
 }
 
 void Graphics::putPixel( const int x,
 	const int y,
 	const ColorBGRA color )
 {
-	ASSERT( x >= 0, "!( x >= 0 )" );
-	ASSERT( x < (int) m_width, "!( x < width )" );
-	ASSERT( y >= 0, "!( y >= 0)" );
-	ASSERT( y < (int) m_height, "!( y < height )" );
-	m_pCpuBuffer[m_width * y + x] = color;
+	m_pCpuFramebuffer->putPixel( x, y, color );
 }
 
 void Graphics::putPixel( const int x,
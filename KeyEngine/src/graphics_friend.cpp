@@ -4,7 +4,7 @@
 
 ID3D11DeviceContext* GraphicsFriend::getDeviceContext( Graphics &gfx ) noexcept
 {
-	return gfx.m_pImmediateContext.Get();
+	return gfx.getCurrentContext();
 }
 
 ID3D11Device* GraphicsFriend::getDevice( Graphics &gfx ) noexcept
@@ -17,26 +17,55 @@ IndexBuffer::IndexBuffer( Graphics &gfx,
 	const std::string &tag,
 	const std::vector<unsigned> &indices )
 	:
+	IndexBuffer(gfx, tag, indices.data(), static_cast<unsigned>( indices.size() ), sizeof( unsigned ))
+{
+
+}
+
+IndexBuffer::IndexBuffer( Graphics &gfx,
+	const std::string &tag,
+	const std::vector<std::uint16_t> &indices )
+	:
+	IndexBuffer(gfx, tag, indices.data(), static_cast<unsigned>( indices.size() ), sizeof( std::uint16_t ))
+{
+
+}
+
+IndexBuffer::IndexBuffer( Graphics &gfx,
+	const std::string &tag,
+	const void *pIndices,
+	const unsigned count,
+	const unsigned indexSize,
+	const mesh_opt::Lod *pLods /*= nullptr*/,
+	const unsigned nLods /*= 0u*/ )
+	:
 	m_tag(tag),
-	m_count{static_cast<unsigned>( indices.size() )}
+	m_count{count},
+	m_indexSize{indexSize}
 {
+	if ( nLods > 1 )
+	{
+		m_lods.assign( pLods, pLods + nLods );
+	}
+
+	ASSERT( indexSize == sizeof( std::uint16_t ) || indexSize == sizeof( unsigned ), "Indices are either 16 or 32 bit!" );
 	D3D11_BUFFER_DESC bd{};
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bd.Usage = D3D11_USAGE_DEFAULT;
 	bd.CPUAccessFlags = 0u;
 	bd.MiscFlags = 0u;
-	bd.ByteWidth = static_cast<unsigned>( m_count * sizeof( unsigned ) );	// pitch
-	bd.StructureByteStride = sizeof( unsigned );							// stride
+	bd.ByteWidth = m_count * m_indexSize;	// pitch
+	bd.StructureByteStride = m_indexSize;	// stride
 
 	D3D11_SUBRESOURCE_DATA subRscData{};
-	subRscData.pSysMem = indices.data();
+	subRscData.pSysMem = pIndices;
 	HRESULT hres = getDevice( gfx )->CreateBuffer( &bd, &subRscData, &m_pIndexBuffer );
 	ASSERT_HRES_IF_FAILED;
 }
 
 void IndexBuffer::bind( Graphics &gfx ) cond_noex
 {
-	getDeviceContext( gfx )->IASetIndexBuffer( m_pIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0u );
+	getDeviceContext( gfx )->IASetIndexBuffer( m_pIndexBuffer.Get(), m_indexSize == sizeof( std::uint16_t ) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0u );
 	DXGI_GET_QUEUE_INFO( gfx );
 }
 
@@ -45,6 +74,11 @@ unsigned IndexBuffer::getIndexCount() const noexcept
 	return m_count;
 }
 
+const std::vector<mesh_opt::Lod>& IndexBuffer::getLods() const noexcept
+{
+	return m_lods;
+}
+
 std::shared_ptr<IndexBuffer> IndexBuffer::fetch( Graphics &gfx,
 	const std::string &tag,
 	const std::vector<unsigned> &indices )
@@ -53,6 +87,31 @@ std::shared_ptr<IndexBuffer> IndexBuffer::fetch( Graphics &gfx,
 	return BindableRegistry::fetch<IndexBuffer>( gfx, tag, indices );
 }
 
+std::shared_ptr<IndexBuffer> IndexBuffer::fetch( Graphics &gfx,
+	const std::string &tag,
+	const std::vector<std::uint16_t> &indices )
+{
+	ASSERT( tag != "?", "Invalid tag!" );
+	return BindableRegistry::fetch<IndexBuffer>( gfx, tag, indices );
+}
+
+std::shared_ptr<IndexBuffer> IndexBuffer::fetch( Graphics &gfx,
+	const std::string &tag,
+	const void *pIndices,
+	const unsigned count,
+	const unsigned indexSize,
+	const mesh_opt::Lod *pLods /*= nullptr*/,
+	const unsigned nLods /*= 0u*/ )
+{
+	ASSERT( tag != "?", "Invalid tag!" );
+	return BindableRegistry::fetch<IndexBuffer>( gfx, tag, pIndices, count, indexSize, pLods, nLods );
+}
+
+std::shared_ptr<IndexBuffer> IndexBuffer::find( const std::string &tag )
+{
+	return BindableRegistry::find<IndexBuffer>( tag );
+}
+
 std::string IndexBuffer::getUid() const noexcept
 {
 	return calcUid( m_tag );
@@ -0,0 +1,95 @@
+#include "instance_batcher.h"
+#include "assertions_console.h"
+
+
+namespace ren
+{
+
+void InstanceBatcher::clear() noexcept
+{
+	m_candidates.clear();
+	m_keyToBatch.clear();
+	m_batches.clear();
+	m_jobBatches.clear();
+	m_instanceData.clear();
+}
+
+void InstanceBatcher::add( const std::uint64_t key,
+	const std::uint32_t jobIndex,
+	const DirectX::XMFLOAT4X4 &worldTransform )
+{
+	ASSERT( key != 0, "Key 0 is reserved for non instanced Jobs!" );
+	m_candidates.push_back( {key, jobIndex, worldTransform} );
+}
+
+void InstanceBatcher::build( const std::size_t nJobs )
+{
+	m_keyToBatch.clear();
+	m_batches.clear();
+	m_instanceData.clear();
+	m_jobBatches.assign( nJobs, s_notBatched );
+
+	// count the instances of every key, Batches are ordered by their first Job
+	for ( const auto &candidate : m_candidates )
+	{
+		const auto [it, bInserted] = m_keyToBatch.try_emplace( candidate.m_key, static_cast<std::uint32_t>( m_batches.size() ) );
+		if ( bInserted )
+		{
+			m_batches.push_back( {candidate.m_jobIndex, 0u, 0u} );
+		}
+		++m_batches[it->second].m_nInstances;
+	}
+
+	// single instance keys are drawn as regular Jobs; the rest get a range of the instance data
+	std::uint32_t nInstances = 0u;
+	std::vector<std::uint32_t> batchRemap( m_batches.size(), s_notBatched );
+	std::size_t nBatches = 0;
+	for ( std::size_t i = 0; i < m_batches.size(); ++i )
+	{
+		Batch batch = m_batches[i];
+		if ( batch.m_nInstances < 2 )
+		{
+			continue;
+		}
+		batch.m_firstInstance = nInstances;
+		nInstances += batch.m_nInstances;
+		batch.m_nInstances = 0u;	// used as the fill cursor below
+		batchRemap[i] = static_cast<std::uint32_t>( nBatches );
+		m_batches[nBatches++] = batch;
+	}
+	m_batches.resize( nBatches );
+
+	m_instanceData.resize( nInstances );
+	for ( const auto &candidate : m_candidates )
+	{
+		const std::uint32_t batchIndex = batchRemap[m_keyToBatch[candidate.m_key]];
+		if ( batchIndex == s_notBatched )
+		{
+			continue;
+		}
+		Batch &batch = m_batches[batchIndex];
+		m_instanceData[batch.m_firstInstance + batch.m_nInstances++] = candidate.m_worldTransform;
+		m_jobBatches[candidate.m_jobIndex] = batchIndex;
+	}
+	m_candidates.clear();
+}
+
+std::uint32_t InstanceBatcher::getBatch( const std::uint32_t jobIndex ) const noexcept
+{
+	return jobIndex < m_jobBatches.size() ?
+		m_jobBatches[jobIndex] :
+		s_notBatched;
+}
+
+const std::vector<InstanceBatcher::Batch>& InstanceBatcher::getBatches() const noexcept
+{
+	return m_batches;
+}
+
+const std::vector<DirectX::XMFLOAT4X4>& InstanceBatcher::getInstanceData() const noexcept
+{
+	return m_instanceData;
+}
+
+
+}//namespace ren
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "instance_buffer.h"
+#include <cstring>
+#include "graphics.h"
+#include "dynamic_vertex_buffer.h"
+#include "os_utils.h"
+#include "dxgi_info_queue.h"
+#include "assertions_console.h"
+
+
+InstanceBuffer::InstanceBuffer( Graphics &gfx,
+	const unsigned stride,
+	const unsigned initialCapacity /*= 256u*/ )
+	:
+	m_stride{stride}
+{
+	ASSERT( stride > 0, "Invalid instance stride!" );
+	createBuffer( gfx, initialCapacity );
+}
+
+void InstanceBuffer::update( Graphics &gfx,
+	const void *pData,
+	const unsigned nInstances ) cond_noex
+{
+	if ( nInstances == 0 )
+	{
+		return;
+	}
+	if ( nInstances > m_capacity )
+	{
+		unsigned capacity = m_capacity;
+		while ( capacity < nInstances )
+		{
+			capacity *= 2;
+		}
+		createBuffer( gfx, capacity );
+	}
+
+	D3D11_MAPPED_SUBRESOURCE msr{};
+	HRESULT hres = getDeviceContext( gfx )->Map( m_pInstanceBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &msr );
+	ASSERT_HRES_IF_FAILED;
+	DXGI_GET_QUEUE_INFO( gfx );
+
+	std::memcpy( msr.pData, pData, static_cast<size_t>( nInstances ) * m_stride );
+
+	getDeviceContext( gfx )->Unmap( m_pInstanceBuffer.Get(), 0u );
+}
+
+void InstanceBuffer::bind( Graphics &gfx ) cond_noex
+{
+	const unsigned offset = 0u;
+	getDeviceContext( gfx )->IASetVertexBuffers( ver::VertexInputLayout::s_instanceInputSlot, 1u, m_pInstanceBuffer.GetAddressOf(), &m_stride, &offset );
+	DXGI_GET_QUEUE_INFO( gfx );
+}
+
+unsigned InstanceBuffer::getStride() const noexcept
+{
+	return m_stride;
+}
+
+void InstanceBuffer::createBuffer( Graphics &gfx,
+	const unsigned capacity )
+{
+	m_capacity = capacity > 0 ? capacity : 1u;
+
+	D3D11_BUFFER_DESC ibDesc{};
+	ibDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	ibDesc.Usage = D3D11_USAGE_DYNAMIC;
+	ibDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	ibDesc.MiscFlags = 0u;
+	ibDesc.ByteWidth = m_capacity * m_stride;
+	ibDesc.StructureByteStride = m_stride;
+
+	m_pInstanceBuffer.Reset();
+	HRESULT hres = getDevice( gfx )->CreateBuffer( &ibDesc, nullptr, &m_pInstanceBuffer );
+	ASSERT_HRES_IF_FAILED;
+}
\ No newline at end of file
@@ -16,12 +16,36 @@ Job::Job( const Mesh *pMesh, const Material *pMaterial )
 
 }
 
-void Job::run( Graphics &gfx ) const cond_noex
+unsigned Job::run( Graphics &gfx,
+	const Job *pPreviousJob /*= nullptr*/ ) const cond_noex
 {
-	m_pMesh->bind( gfx );		// bind P.T., V.B., I.B., TransformVSCB
-	m_pMaterial->bind( gfx );	// bind other bindables
-	gfx.drawIndexed( m_pMesh->getIndicesCount() );
+	unsigned nSkippedBinds = 0u;
+	nSkippedBinds += m_pMesh->bind( gfx, pPreviousJob ? pPreviousJob->m_pMesh : nullptr );		// bind P.T., V.B., I.B., TransformVSCB
+	nSkippedBinds += m_pMaterial->bind( gfx, pPreviousJob ? pPreviousJob->m_pMaterial : nullptr );	// bind other bindables
+	m_pMesh->draw( gfx );
 	DXGI_GET_QUEUE_INFO( gfx );
+	return nSkippedBinds;
+}
+
+void Job::runInstanced( Graphics &gfx,
+	const unsigned nInstances,
+	const unsigned firstInstance,
+	const unsigned lod ) const cond_noex
+{
+	m_pMesh->bindGeometry( gfx );
+	m_pMaterial->bindInstanced( gfx );
+	gfx.drawIndexedInstanced( m_pMesh->getIndicesCount( lod ), nInstances, firstInstance, m_pMesh->getStartIndex( lod ) );
+	DXGI_GET_QUEUE_INFO( gfx );
+}
+
+const Mesh* Job::getMesh() const noexcept
+{
+	return m_pMesh;
+}
+
+const Material* Job::getMaterial() const noexcept
+{
+	return m_pMaterial;
 }
 
 
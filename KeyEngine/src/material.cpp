@@ -3,9 +3,31 @@
 #include "mesh.h"
 #include "renderer.h"
 #include "render_queue_pass.h"
+#include "render_queue_sort.h"
+#include "primitive_topology.h"
+#include "vertex_shader.h"
+#include "input_layout.h"
+#include "pixel_shader.h"
+#include "texture.h"
+#include "cube_texture.h"
 #include "assertions_console.h"
 
 
+namespace
+{
+
+std::uint32_t hashBindable( const IBindable *pBindable ) noexcept
+{
+	std::uint64_t x = reinterpret_cast<std::uintptr_t>( pBindable );
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	return static_cast<std::uint32_t>( x );
+}
+
+}// namespace
+
+
 Material::Material( const size_t channels,
 	const std::string &targetPassName,
 	const bool bStartActive ) noexcept
@@ -22,7 +44,16 @@ Material::Material( const Material &rhs )
 	m_renderingChannels{rhs.m_renderingChannels},
 	m_bActive{rhs.m_bActive},
 	m_targetPassName{rhs.m_targetPassName},
-	m_pTargetPass{rhs.m_pTargetPass}
+	m_pTargetPass{rhs.m_pTargetPass},
+	m_bindSkippable{rhs.m_bindSkippable},
+	m_shaderSortId{rhs.m_shaderSortId},
+	m_textureSortId{rhs.m_textureSortId},
+	m_bindablesHash{rhs.m_bindablesHash},
+	m_bHasClonedBindables{rhs.m_bHasClonedBindables},
+	m_vertexShaderIndex{rhs.m_vertexShaderIndex},
+	m_inputLayoutIndex{rhs.m_inputLayoutIndex},
+	m_pInstancedVertexShader{rhs.m_pInstancedVertexShader},
+	m_pInstancedInputLayout{rhs.m_pInstancedInputLayout}
 {
 	m_bindables.reserve( rhs.m_bindables.size() );
 	for ( auto &pBindable : rhs.m_bindables )
@@ -43,9 +74,18 @@ Material::Material( Material &&rhs ) noexcept
 	m_renderingChannels{rhs.m_renderingChannels},
 	m_bActive{rhs.m_bActive},
 	m_targetPassName{std::move( rhs.m_targetPassName )},
-	m_pTargetPass{rhs.m_pTargetPass}
+	m_pTargetPass{rhs.m_pTargetPass},
+	m_shaderSortId{rhs.m_shaderSortId},
+	m_textureSortId{rhs.m_textureSortId},
+	m_bindablesHash{rhs.m_bindablesHash},
+	m_bHasClonedBindables{rhs.m_bHasClonedBindables},
+	m_vertexShaderIndex{rhs.m_vertexShaderIndex},
+	m_inputLayoutIndex{rhs.m_inputLayoutIndex},
+	m_pInstancedVertexShader{std::move( rhs.m_pInstancedVertexShader )},
+	m_pInstancedInputLayout{std::move( rhs.m_pInstancedInputLayout )}
 {
 	std::swap( m_bindables, rhs.m_bindables );
+	std::swap( m_bindSkippable, rhs.m_bindSkippable );
 
 	rhs.m_renderingChannels = 0u;
 	rhs.m_bActive = false;
@@ -54,6 +94,31 @@ Material::Material( Material &&rhs ) noexcept
 
 void Material::addBindable( std::shared_ptr<IBindable> pBindable ) noexcept
 {
+	const IBindable *p = pBindable.get();
+	const int index = static_cast<int>( m_bindables.size() );
+	if ( dynamic_cast<const VertexShader*>( p ) )
+	{
+		m_shaderSortId ^= hashBindable( p );
+		m_vertexShaderIndex = index;
+	}
+	else if ( dynamic_cast<const PixelShader*>( p ) )
+	{
+		m_shaderSortId ^= hashBindable( p );
+	}
+	else if ( dynamic_cast<const InputLayout*>( p ) )
+	{
+		m_inputLayoutIndex = index;
+	}
+	else if ( dynamic_cast<const Texture*>( p ) || dynamic_cast<const CubeTexture*>( p ) )
+	{
+		m_textureSortId ^= hashBindable( p );
+	}
+	// cloned bindables (eg. transform VSCBs) are per Mesh & the topology may have been overridden by the Mesh
+	const bool bCloned = dynamic_cast<const IBindableCloning*>( p ) != nullptr;
+	const bool bSkippable = !bCloned && !dynamic_cast<const PrimitiveTopology*>( p );
+	m_bindSkippable.emplace_back( bSkippable ? 1u : 0u );
+	m_bHasClonedBindables = m_bHasClonedBindables || bCloned;
+	m_bindablesHash = ( m_bindablesHash ^ hashBindable( p ) ) * 0x100000001B3ull;
 	m_bindables.emplace_back( std::move( pBindable ) );
 }
 
@@ -67,12 +132,15 @@ void Material::render( const Mesh &mesh,
 	}
 }
 
-void Material::bind( Graphics &gfx ) const cond_noex
+unsigned Material::bind( Graphics &gfx,
+	const Material *pPreviousMaterial /*= nullptr*/ ) const cond_noex
 {
-	for ( const auto &bindable : m_bindables )
-	{
-		bindable->bind( gfx );
-	}
+	// a shared bindable is bound to a fixed slot, if the previous Job bound it the pipeline still holds it
+	return ren::bindSkippingShared( m_bindables, m_bindSkippable, pPreviousMaterial ? &pPreviousMaterial->m_bindables : nullptr,
+		[&gfx] ( IBindable &bindable )
+		{
+			bindable.bind( gfx );
+		} );
 }
 
 bool Material::isEnabled() const noexcept
@@ -137,3 +205,51 @@ size_t Material::getChannelMask() const noexcept
 {
 	return m_renderingChannels;
 }
+
+std::uint32_t Material::getShaderSortId() const noexcept
+{
+	return m_shaderSortId;
+}
+
+std::uint32_t Material::getTextureSortId() const noexcept
+{
+	return m_textureSortId;
+}
+
+void Material::setInstancing( std::shared_ptr<IBindable> pInstancedVertexShader,
+	std::shared_ptr<IBindable> pInstancedInputLayout ) noexcept
+{
+	m_pInstancedVertexShader = std::move( pInstancedVertexShader );
+	m_pInstancedInputLayout = std::move( pInstancedInputLayout );
+}
+
+std::uint64_t Material::getInstancingKey() const noexcept
+{
+	// the instanced shader & layout substitute the Material's own
+	if ( !m_pInstancedVertexShader || m_bHasClonedBindables || m_vertexShaderIndex < 0 || m_inputLayoutIndex < 0 )
+	{
+		return 0u;
+	}
+	const std::uint64_t key = ( m_bindablesHash ^ hashBindable( m_pInstancedVertexShader.get() ) ) * 0x100000001B3ull;
+	return key != 0u ? key : 1u;
+}
+
+void Material::bindInstanced( Graphics &gfx ) const cond_noex
+{
+	ASSERT( m_pInstancedVertexShader && m_pInstancedInputLayout, "Material isn't instanced!" );
+	for ( int i = 0; i < static_cast<int>( m_bindables.size() ); ++i )
+	{
+		if ( i == m_vertexShaderIndex )
+		{
+			m_pInstancedVertexShader->bind( gfx );
+		}
+		else if ( i == m_inputLayoutIndex )
+		{
+			m_pInstancedInputLayout->bind( gfx );
+		}
+		else
+		{
+			m_bindables[i]->bind( gfx );
+		}
+	}
+}
\ No newline at end of file
@@ -15,6 +15,10 @@
 #include "rendering_channel.h"
 #include "assertions_console.h"
 #include "lighting_mode.h"
+#include "mesh_optimizer_vbuffer.h"
+#include "console.h"
+#include <sstream>
+#include <iomanip>
 
 
 // #TODO: PBR Metallic Renderer (UE4 based)
@@ -24,15 +28,19 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 	const aiMaterial &aimaterial,
 	const std::filesystem::path &modelPath ) cond_noex
 	:
-	m_modelPath{modelPath.string()}
+	MaterialLoader(gfx, makeDesc( aimaterial ), modelPath)
 {
-	const auto rootPath = modelPath.parent_path().string() + "/";
-	{
-		aiString matName;
-		aimaterial.Get( AI_MATKEY_NAME, matName );
-		m_name = matName.C_Str();
-	}
 
+}
+
+MaterialLoader::MaterialLoader( Graphics &gfx,
+	Desc desc,
+	const std::filesystem::path &modelPath ) cond_noex
+	:
+	m_modelPath{modelPath.string()},
+	m_desc(std::move( desc ))
+{
+	const auto rootPath = modelPath.parent_path().string() + "/";
 	std::string shaderFileName;
 
 	if constexpr ( lgh_mode::get() == lgh_mode::LightingMode::BlinnPhong )
@@ -44,7 +52,6 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 			opaque.addBindable( PrimitiveTopology::fetch( gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST ) );
 
 			shaderFileName = "phong_";
-			aiString textureFileName;
 
 			m_vertexLayout.add( ver::VertexInputLayout::Position3D );
 			m_vertexLayout.add( ver::VertexInputLayout::Normal );
@@ -53,12 +60,12 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 			bool bSpecularTextureAlpha = false;
 			{// does aiMaterial have a diffuse/albedo texture?
 				bool bTextureAlphaChannel = false;
-				if ( aimaterial.GetTexture( aiTextureType_DIFFUSE, 0u, &textureFileName ) == aiReturn_SUCCESS )
+				if ( !m_desc.diffuseTexture.empty() )
 				{
 					bTexture = true;
 					shaderFileName += "Dif";
 					m_vertexLayout.add( ver::VertexInputLayout::Texture2D );
-					auto tex = Texture::fetch( gfx, rootPath + textureFileName.C_Str(), 0u );
+					auto tex = Texture::fetch( gfx, rootPath + m_desc.diffuseTexture, 0u );
 					if ( tex->hasAlpha() )
 					{
 						bTextureAlphaChannel = true;
@@ -77,12 +84,12 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 				opaque.addBindable( RasterizerState::fetch( gfx, RasterizerState::RasterizerMode::DefaultRS, RasterizerState::FillMode::Solid, faceMode ) );
 			}
 			{// how about specular texture?
-				if ( aimaterial.GetTexture( aiTextureType_SPECULAR, 0u, &textureFileName ) == aiReturn_SUCCESS )
+				if ( !m_desc.specularTexture.empty() )
 				{
 					bTexture = true;
 					shaderFileName += "Spc";
 					m_vertexLayout.add( ver::VertexInputLayout::Texture2D );
-					auto tex = Texture::fetch( gfx, rootPath + textureFileName.C_Str(), 1u );
+					auto tex = Texture::fetch( gfx, rootPath + m_desc.specularTexture, 1u, nullptr, TextureContent::Specular );
 					bSpecularTextureAlpha = tex->hasAlpha();
 					opaque.addBindable( std::move( tex ) );
 					// in our system of specular maps the alpha channel contains the gloss (specular power)
@@ -93,14 +100,14 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 				cbLayout.add<con::Float>( "cb_modelSpecularGloss" );
 			}
 			{// how about normal texture?
-				if ( aimaterial.GetTexture( aiTextureType_NORMALS, 0, &textureFileName ) == aiReturn_SUCCESS )
+				if ( !m_desc.normalTexture.empty() )
 				{
 					bTexture = true;
 					shaderFileName += "Nrm";
 					m_vertexLayout.add( ver::VertexInputLayout::Texture2D );
 					m_vertexLayout.add( ver::VertexInputLayout::Tangent );
 					m_vertexLayout.add( ver::VertexInputLayout::Bitangent );
-					opaque.addBindable( Texture::fetch( gfx, rootPath + textureFileName.C_Str(), 2u ) );
+					opaque.addBindable( Texture::fetch( gfx, rootPath + m_desc.normalTexture, 2u, nullptr, TextureContent::NormalMap ) );
 					cbLayout.add<con::Bool>( "cb_bNormalMap" );
 					cbLayout.add<con::Float>( "cb_normalMapStrength" );
 				}
@@ -117,26 +124,11 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 
 				// Assembling the Pixel Shader Constant Buffer
 				con::CBuffer pscb{std::move( cbLayout )};
-				if ( auto cbElem = pscb["cb_materialColor"]; cbElem.isValid() )
-				{
-					aiColor4D difCol = {0.45f, 0.45f, 0.85f, 1.0f};
-					aimaterial.Get( AI_MATKEY_COLOR_DIFFUSE, difCol );
-					cbElem = reinterpret_cast<dx::XMFLOAT4&>( difCol );
-				}
+				pscb["cb_materialColor"].setIfValid( m_desc.diffuseColor );
 				pscb["cb_bSpecularMap"].setIfValid( true );
 				pscb["cb_bSpecularMapAlpha"].setIfValid( bSpecularTextureAlpha );
-				if ( auto cbElem = pscb["cb_modelSpecularColor"]; cbElem.isValid() )
-				{
-					aiColor3D specCol = {0.18f, 0.18f, 0.18f};
-					aimaterial.Get( AI_MATKEY_COLOR_SPECULAR, specCol );
-					cbElem = reinterpret_cast<dx::XMFLOAT3&>( specCol );
-				}
-				if ( auto cbElem = pscb["cb_modelSpecularGloss"]; cbElem.isValid() )
-				{
-					float specGloss = 8.0f;
-					aimaterial.Get( AI_MATKEY_SHININESS, specGloss );
-					cbElem = specGloss;
-				}
+				pscb["cb_modelSpecularColor"].setIfValid( m_desc.specularColor );
+				pscb["cb_modelSpecularGloss"].setIfValid( m_desc.specularGloss );
 				pscb["cb_bNormalMap"].setIfValid( true );
 				pscb["cb_normalMapStrength"].setIfValid( 1.0f );
 				opaque.addBindable( std::make_unique<PixelShaderConstantBufferEx>( gfx, 0u, std::move( pscb ) ) );
@@ -201,9 +193,9 @@ MaterialLoader::MaterialLoader( Graphics &gfx,
 	}
 }
 
-std::shared_ptr<VertexBuffer> MaterialLoader::makeVertexBuffer( Graphics &gfx,
-	const aiMesh &aimesh,
-	float scale ) const cond_noex
+MaterialLoader::Geometry MaterialLoader::makeGeometry( const aiMesh &aimesh,
+	const float scale /*= 1.0f*/,
+	const mesh_opt::LodSettings &lodSettings /*= {}*/ ) const cond_noex
 {
 	auto vb = makeVertexBuffer_impl( aimesh );
 	if ( scale != 1.0f )
@@ -216,13 +208,30 @@ std::shared_ptr<VertexBuffer> MaterialLoader::makeVertexBuffer( Graphics &gfx,
 			pos.z *= scale;
 		}
 	}
-	return VertexBuffer::fetch( gfx, calcMeshTag( aimesh ), vb );
-}
+	auto indices = makeIndexBuffer_impl( aimesh );
 
-std::shared_ptr<IndexBuffer> MaterialLoader::makeIndexBuffer( Graphics &gfx,
-	const aiMesh &aimesh ) const cond_noex
-{
-	return IndexBuffer::fetch( gfx, calcMeshTag( aimesh ), makeIndexBuffer_impl( aimesh ) );
+	const auto reports = mesh_opt::optimize( vb, indices );
+	auto lods = mesh_opt::generateLods( vb, indices, lodSettings );
+#if defined _DEBUG && !defined NDEBUG
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision( 3 ) << "Mesh optimization [" << calcMeshTag( aimesh.mName.C_Str() ) << "]\n";
+		for ( const auto &report : reports )
+		{
+			oss << "\t" << report.name << ": ACMR " << report.acmrBefore << " -> " << report.acmrAfter
+				<< ", vertex bytes " << report.vertexBytesBefore << " -> " << report.vertexBytesAfter
+				<< ", index bytes " << report.indexBytesBefore << " -> " << report.indexBytesAfter << "\n";
+		}
+		for ( size_t i = 0; i < lods.size(); ++i )
+		{
+			oss << "\tLOD" << i << ": " << lods[i].nIndices / 3 << " triangles, error " << lods[i].error << "\n";
+		}
+		KeyConsole::getInstance().log( oss.str(), KeyConsole::LogCategory::Graphics );
+	}
+#else
+	(void)reports;
+#endif
+	return Geometry{std::move( vb ), std::move( indices ), std::move( lods )};
 }
 
 ver::VBuffer MaterialLoader::makeVertexBuffer_impl( const aiMesh &aimesh ) const noexcept
@@ -245,12 +254,53 @@ std::vector<unsigned> MaterialLoader::makeIndexBuffer_impl( const aiMesh &aimesh
 	return indices;
 }
 
-std::string MaterialLoader::calcMeshTag( const aiMesh &aimesh ) const noexcept
+std::string MaterialLoader::calcMeshTag( const std::string &meshName ) const noexcept
 {
-	return m_modelPath + "%" + aimesh.mName.C_Str();
+	return m_modelPath + "%" + meshName;
 }
 
 std::vector<Material> MaterialLoader::getMaterial() const noexcept
 {
 	return m_materials;
+}
+
+const MaterialLoader::Desc& MaterialLoader::getDesc() const noexcept
+{
+	return m_desc;
+}
+
+const ver::VertexInputLayout& MaterialLoader::getVertexLayout() const noexcept
+{
+	return m_vertexLayout;
+}
+
+MaterialLoader::Desc MaterialLoader::makeDesc( const aiMaterial &aimaterial )
+{
+	Desc desc;
+	aiString str;
+	if ( aimaterial.Get( AI_MATKEY_NAME, str ) == aiReturn_SUCCESS )
+	{
+		desc.name = str.C_Str();
+	}
+	if ( aimaterial.GetTexture( aiTextureType_DIFFUSE, 0u, &str ) == aiReturn_SUCCESS )
+	{
+		desc.diffuseTexture = str.C_Str();
+	}
+	if ( aimaterial.GetTexture( aiTextureType_SPECULAR, 0u, &str ) == aiReturn_SUCCESS )
+	{
+		desc.specularTexture = str.C_Str();
+	}
+	if ( aimaterial.GetTexture( aiTextureType_NORMALS, 0u, &str ) == aiReturn_SUCCESS )
+	{
+		desc.normalTexture = str.C_Str();
+	}
+
+	aiColor4D difCol = {desc.diffuseColor.x, desc.diffuseColor.y, desc.diffuseColor.z, desc.diffuseColor.w};
+	aimaterial.Get( AI_MATKEY_COLOR_DIFFUSE, difCol );
+	desc.diffuseColor = reinterpret_cast<dx::XMFLOAT4&>( difCol );
+	aiColor3D specCol = {desc.specularColor.x, desc.specularColor.y, desc.specularColor.z};
+	aimaterial.Get( AI_MATKEY_COLOR_SPECULAR, specCol );
+	desc.specularColor = reinterpret_cast<dx::XMFLOAT3&>( specCol );
+	aimaterial.Get( AI_MATKEY_SHININESS, desc.specularGloss );
+	return desc;
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #include "mesh.h"
+#include <cmath>
+#include <algorithm>
+#include "graphics.h"
 #include "node.h"
 #include "vertex_buffer.h"
 #include "index_buffer.h"
 #include "primitive_topology.h"
 #include "material_loader.h"
+#include "model_cache.h"
 #include "camera_manager.h"
 #include "camera.h"
-#include "settings_manager.h"
 #include "utils.h"
 #include "d3d_utils.h"
 #include "global_constants.h"
@@ -23,20 +26,23 @@ namespace dx = DirectX;
 
 Mesh::Mesh( Graphics &gfx,
 	const MaterialLoader &mat,
-	const aiMesh &aimesh,
-	const float initialScale /*= 1.0f*/ )
+	const model_cache::MeshData &meshData )
+	:
+	m_aabb{meshData.aabbMin, meshData.aabbMax}
 {
-	m_pVertexBuffer = mat.makeVertexBuffer( gfx, aimesh, initialScale );
-	m_pIndexBuffer = mat.makeIndexBuffer( gfx, aimesh );
+	const auto tag = mat.calcMeshTag( std::string{meshData.name} );
+	m_pVertexBuffer = VertexBuffer::fetch( gfx, tag, mat.getVertexLayout(), meshData.pVertices, meshData.nVertices );
+	m_pIndexBuffer = IndexBuffer::fetch( gfx, tag, meshData.pIndices, meshData.nIndices, meshData.indexSize, meshData.pLods, meshData.nLods );
 	m_pPrimitiveTopology = PrimitiveTopology::fetch( gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
 	m_pTransformVscb = std::make_unique<TransformVSCB>( gfx, g_modelVscbSlot, *this );
 
+	// the LOD ranges of the index buffer that was fetched, which may have been registered by another Mesh
+	m_lods = m_pIndexBuffer->getLods();
+
 	for ( auto &material : mat.getMaterial() )
 	{
 		addMaterial( std::move( material ) );
 	}
-
-	createAabb( aimesh );
 	setMeshId();
 }
 
@@ -48,6 +54,8 @@ Mesh::~Mesh() noexcept
 	m_pIndexBuffer.reset();
 	m_pVertexBuffer.reset();
 	m_pNode = nullptr;
+	FrustumCuller::getInstance().releaseSlot( m_cullingSlot );
+	m_cullingSlot = FrustumCuller::s_invalidSlot;
 	m_meshId = 0u;
 	m_bRenderedThisFrame = false;
 	m_distanceFromActiveCamera = -1.0f;
@@ -58,15 +66,19 @@ Mesh::Mesh( Mesh &&rhs ) noexcept
 	m_distanceFromActiveCamera{rhs.m_distanceFromActiveCamera},
 	m_bRenderedThisFrame{rhs.m_bRenderedThisFrame},
 	m_meshId{rhs.m_meshId},
+	m_cullingSlot{rhs.m_cullingSlot},
 	m_pNode{rhs.m_pNode},
 	m_aabb{rhs.m_aabb},
 	m_pVertexBuffer{std::move( rhs.m_pVertexBuffer )},		// #TODO: ???
 	m_pIndexBuffer{std::move( rhs.m_pIndexBuffer )},
 	m_pPrimitiveTopology{std::move( rhs.m_pPrimitiveTopology )},
 	m_pTransformVscb{std::move( rhs.m_pTransformVscb )},
-	m_materials{std::move( rhs.m_materials )}
+	m_materials{std::move( rhs.m_materials )},
+	m_lods{std::move( rhs.m_lods )},
+	m_lod{rhs.m_lod.load( std::memory_order_relaxed )}
 {
 	rhs.m_pNode = nullptr;
+	rhs.m_cullingSlot = FrustumCuller::s_invalidSlot;
 	rhs.m_pVertexBuffer = nullptr;
 	rhs.m_pIndexBuffer = nullptr;
 	rhs.m_pPrimitiveTopology = nullptr;
@@ -81,6 +93,7 @@ void Mesh::update( const float dt,
 	const float lerpBetweenFrames ) cond_noex
 {
 	setDistanceFromActiveCamera();
+	updateCullingBounds();
 }
 
 void Mesh::render( const size_t channels /* = rch::all*/ ) const noexcept
@@ -98,12 +111,88 @@ void Mesh::render( const size_t channels /* = rch::all*/ ) const noexcept
 	}
 }
 
-void Mesh::bind( Graphics &gfx ) const cond_noex
+unsigned Mesh::bind( Graphics &gfx,
+	const Mesh *pPreviousMesh /*= nullptr*/ ) const cond_noex
+{
+	unsigned nSkippedBinds = 0u;
+	if ( pPreviousMesh && pPreviousMesh->m_pVertexBuffer == m_pVertexBuffer )
+	{
+		++nSkippedBinds;
+	}
+	else
+	{
+		m_pVertexBuffer->bind( gfx );
+	}
+	if ( pPreviousMesh && pPreviousMesh->m_pIndexBuffer == m_pIndexBuffer )
+	{
+		++nSkippedBinds;
+	}
+	else
+	{
+		m_pIndexBuffer->bind( gfx );
+	}
+	// Materials may bind their own topology & transform-like VSCBs in between, so these are always bound
+	m_pPrimitiveTopology->bind( gfx );
+	m_pTransformVscb->bind( gfx );
+	return nSkippedBinds;
+}
+
+void Mesh::bindGeometry( Graphics &gfx ) const cond_noex
 {
 	m_pVertexBuffer->bind( gfx );
 	m_pIndexBuffer->bind( gfx );
 	m_pPrimitiveTopology->bind( gfx );
-	m_pTransformVscb->bind( gfx );
+}
+
+void Mesh::draw( Graphics &gfx ) const cond_noex
+{
+	const unsigned lod = selectLod( gfx );
+	gfx.drawIndexed( getIndicesCount( lod ), getStartIndex( lod ) );
+}
+
+std::uint64_t Mesh::getGeometryKey() const noexcept
+{
+	std::uint64_t key = 0xCBF29CE484222325ull;
+	for ( const void *p : {static_cast<const void*>( m_pVertexBuffer.get() ), static_cast<const void*>( m_pIndexBuffer.get() ), static_cast<const void*>( m_pPrimitiveTopology.get() )} )
+	{
+		key = ( key ^ reinterpret_cast<std::uintptr_t>( p ) ) * 0x100000001B3ull;
+	}
+	return key;
+}
+
+unsigned Mesh::selectLod( const Graphics &gfx ) const noexcept
+{
+	if ( m_lods.size() < 2 || m_pNode == nullptr )
+	{
+		return 0u;
+	}
+
+	// the LOD errors are relative to the Mesh's largest extent, so the error in pixels is the LOD's error times that extent projected at the Mesh's distance
+	//	the view matrix is rigid, so world view carries the Node's scale
+	dx::XMFLOAT4X4 worldView;
+	dx::XMStoreFloat4x4( &worldView, m_pNode->getWorldTransform() * gfx.getViewMatrix() );
+	const float maxScale = std::sqrt( std::max( {worldView._11 * worldView._11 + worldView._12 * worldView._12 + worldView._13 * worldView._13,
+		worldView._21 * worldView._21 + worldView._22 * worldView._22 + worldView._23 * worldView._23,
+		worldView._31 * worldView._31 + worldView._32 * worldView._32 + worldView._33 * worldView._33} ) );
+	const float extent = std::max( {m_aabb.second.x - m_aabb.first.x, m_aabb.second.y - m_aabb.first.y, m_aabb.second.z - m_aabb.first.z} ) * maxScale;
+
+	// _22 is 1 / tan( fovY / 2 ) for perspective & 2 / viewHeight for orthographic projections
+	//	shadow maps are taken to have about the resolution of the back buffer
+	dx::XMFLOAT4X4 projection;
+	dx::XMStoreFloat4x4( &projection, gfx.getProjectionMatrix() );
+	const float projectionScale = 0.5f * static_cast<float>( gfx.getClientHeight() ) * projection._22;
+	float pixelSize = extent * projectionScale;
+	if ( projection._34 != 0.0f )
+	{
+		// the eye is the origin of view space
+		const dx::XMFLOAT3 localCenter{( m_aabb.first.x + m_aabb.second.x ) * 0.5f, ( m_aabb.first.y + m_aabb.second.y ) * 0.5f, ( m_aabb.first.z + m_aabb.second.z ) * 0.5f};
+		const float distance = dx::XMVectorGetX( dx::XMVector3Length( dx::XMVector3TransformCoord( dx::XMLoadFloat3( &localCenter ), dx::XMLoadFloat4x4( &worldView ) ) ) );
+		pixelSize /= std::max( distance - extent * 0.5f, 0.001f );
+	}
+
+	const unsigned lod = mesh_opt::selectLod( m_lods.data(), m_lods.size(), pixelSize, m_lod.load( std::memory_order_relaxed ) );
+	m_lod.store( lod, std::memory_order_relaxed );
+	return lod;
 }
 
 void Mesh::addMaterial( Material material ) noexcept
@@ -132,9 +221,18 @@ void Mesh::accept( IImGuiConstantBufferVisitor &ev )
 }
 #endif
 
-unsigned Mesh::getIndicesCount() const cond_noex
+unsigned Mesh::getIndicesCount( const unsigned lod /*= 0u*/ ) const cond_noex
 {
-	return m_pIndexBuffer->getIndexCount();
+	return m_lods.empty() ?
+		m_pIndexBuffer->getIndexCount() :
+		m_lods[lod].nIndices;
+}
+
+unsigned Mesh::getStartIndex( const unsigned lod /*= 0u*/ ) const noexcept
+{
+	return m_lods.empty() ?
+		0u :
+		m_lods[lod].startIndex;
 }
 
 void Mesh::connectMaterialsToRenderer( ren::Renderer &r )
@@ -182,6 +280,10 @@ void Mesh::createAabb( const ver::VBuffer &verts )
 	}
 
 	m_aabb = std::make_pair( minVertex, maxVertex );
+	if ( m_pNode != nullptr )
+	{
+		updateCullingBounds();
+	}
 }
 
 const Node* Mesh::getNode() const noexcept
@@ -209,10 +311,14 @@ float Mesh::getDistanceFromActiveCamera( const DirectX::XMFLOAT3 &pos ) const no
 	return util::distance( pos, cameraPos );
 }
 
-void Mesh::setMeshId() noexcept
+void Mesh::setMeshId()
 {
 	++g_nMeshes;
 	m_meshId = g_nMeshes;
+	if ( m_cullingSlot == FrustumCuller::s_invalidSlot )
+	{
+		m_cullingSlot = FrustumCuller::getInstance().acquireSlot();
+	}
 }
 
 void Mesh::setDistanceFromActiveCamera() noexcept
@@ -222,94 +328,16 @@ void Mesh::setDistanceFromActiveCamera() noexcept
 	m_distanceFromActiveCamera = util::distance( pos, cameraPos );
 }
 
-void Mesh::createAabb( const aiMesh &aiMesh )
+bool Mesh::isFrustumCulled() const noexcept
 {
-	dx::XMFLOAT3 minVertex{FLT_MAX, FLT_MAX, FLT_MAX};
-	dx::XMFLOAT3 maxVertex{-FLT_MAX, -FLT_MAX, -FLT_MAX};
-
-	unsigned int n = aiMesh.mNumVertices;
-	for ( unsigned int i = 0; i < n; ++i )
-	{
-		// the minVertex and maxVertex will most likely not be actual vertices in the model, but vertices that use the smallest and largest x, y, z coords
-		// from the model to make sure ALL vertices are covered by the bounding volume
-
-		// get the smallest vertex
-		minVertex.x = std::min(minVertex.x, aiMesh.mVertices[i].x);
-		minVertex.y = std::min(minVertex.y, aiMesh.mVertices[i].y);
-		minVertex.z = std::min(minVertex.z, aiMesh.mVertices[i].z);
-
-		// get the largest vertex
-		maxVertex.x = std::max(maxVertex.x, aiMesh.mVertices[i].x);
-		maxVertex.y = std::max(maxVertex.y, aiMesh.mVertices[i].y);
-		maxVertex.z = std::max(maxVertex.z, aiMesh.mVertices[i].z);
-	}
-
-	m_aabb = std::make_pair( minVertex, maxVertex );
+	return !FrustumCuller::getInstance().isVisible( m_cullingSlot );
 }
 
-bool Mesh::isFrustumCulled() const noexcept
+void Mesh::updateCullingBounds() const noexcept
 {
-	static auto &s = SettingsManager::getInstance();
-	if ( !s.getSettings().bEnableFrustumCuling )
+	if ( m_cullingSlot == FrustumCuller::s_invalidSlot )
 	{
-		return false;
+		return;
 	}
-
-	const std::vector<DirectX::XMFLOAT4> &frustumPlanes = CameraManager::getInstance().getActiveCamera().getFrustumPlanes();
-	const int numPlanes = static_cast<const int>( frustumPlanes.size() );
-	ASSERT( numPlanes == 6, "Invalid number of planes!" );
-
-	const auto &minVertex = m_aabb.first;
-	const auto &maxVertex = m_aabb.second;
-
-	const auto pos = m_pNode->getPosition();
-
-	for ( int i = 0; i < numPlanes; ++i )
-	{
-		// AABB vertex furthest away from the direction the plane normal is facing
-		dx::XMFLOAT3 axisVert{};
-
-		// along the ...
-		// ... x-axis
-		if ( frustumPlanes[i].x < 0.0f )
-		{
-			axisVert.x = minVertex.x + pos.x;
-		}
-		else
-		{
-			axisVert.x = maxVertex.x + pos.x;
-		}
-
-		// ... y-axis
-		if ( frustumPlanes[i].y < 0.0f )
-		{
-			axisVert.y = minVertex.y + pos.y;
-		}
-		else
-		{
-			axisVert.y = maxVertex.y + pos.y;
-		}
-
-		// ... z-axis
-		if ( frustumPlanes[i].z < 0.0f )
-		{
-			axisVert.z = minVertex.z + pos.z;
-		}
-		else
-		{
-			axisVert.z = maxVertex.z + pos.z;
-		}
-
-		const dx::XMVECTOR planeNormal{dx::XMVectorSet( frustumPlanes[i].x, frustumPlanes[i].y, frustumPlanes[i].z, 0.0f )};
-		const float planeConstant = frustumPlanes[i].w;
-
-		// get the signed distance from the AABB vertex that's furthest down the frustum planes normal, and if the signed distance is negative
-		//	then the entire bounding box is behind the frustum plane, which means that it should be culled
-		if ( dx::XMVectorGetX( dx::XMVector3Dot( planeNormal, dx::XMLoadFloat3( &axisVert ) ) ) + planeConstant < 0.0f )
-		{
-			return true;
-		}
-	}
-
-	return false;
-}
+	FrustumCuller::getInstance().setBounds( m_cullingSlot, m_aabb.first, m_aabb.second, m_pNode->getWorldTransform4x4() );
+}
\ No newline at end of file
@@ -0,0 +1,970 @@
+#include "mesh_optimizer.h"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include "assertions_console.h"
+
+
+namespace mesh_opt
+{
+
+namespace
+{
+
+// Forsyth's tuning
+static constexpr float s_cacheDecayPower = 1.5f;
+static constexpr float s_lastTriangleScore = 0.75f;
+static constexpr float s_valenceBoostScale = 2.0f;
+static constexpr float s_valenceBoostPower = 0.5f;
+static constexpr unsigned s_maxTabulatedValence = 32u;
+static constexpr unsigned s_invalidTriangle = ~0u;
+
+struct VertexScoreTable final
+{
+	std::array<float, s_lruCacheSize> cacheScores;
+	std::array<float, s_maxTabulatedValence + 1> valenceScores;
+
+	VertexScoreTable()
+	{
+		for ( unsigned i = 0; i < s_lruCacheSize; ++i )
+		{
+			// the vertices of the last triangle get a fixed score so the next one doesn't just reuse 2 of them & then turn back
+			cacheScores[i] = i < 3 ?
+				s_lastTriangleScore :
+				std::pow( 1.0f - float( i - 3 ) / float( s_lruCacheSize - 3 ), s_cacheDecayPower );
+		}
+		valenceScores[0] = 0.0f;
+		for ( unsigned i = 1; i <= s_maxTabulatedValence; ++i )
+		{
+			valenceScores[i] = s_valenceBoostScale * std::pow( float( i ), -s_valenceBoostPower );
+		}
+	}
+
+	/// \brief	cachePosition is -1 for vertices out of the cache; vertices with no triangles left to emit score -1
+	float calcScore( const int cachePosition,
+		const unsigned nRemainingTriangles ) const noexcept
+	{
+		if ( nRemainingTriangles == 0 )
+		{
+			return -1.0f;
+		}
+		const float cacheScore = cachePosition >= 0 && cachePosition < static_cast<int>( s_lruCacheSize ) ?
+			cacheScores[cachePosition] :
+			0.0f;
+		const float valenceScore = nRemainingTriangles <= s_maxTabulatedValence ?
+			valenceScores[nRemainingTriangles] :
+			s_valenceBoostScale * std::pow( float( nRemainingTriangles ), -s_valenceBoostPower );
+		return cacheScore + valenceScore;
+	}
+};
+
+/// \brief	FIFO cache emulation with timestamps, a vertex is cached while fewer than cacheSize misses happened since its own
+/// \brief	bumping timestamp by cacheSize + 1 flushes the cache
+struct FifoCache final
+{
+	std::vector<unsigned> cacheTimestamps;
+	unsigned timestamp;
+	unsigned cacheSize;
+
+	FifoCache( const std::size_t nVertices,
+		const unsigned cacheSize )
+		:
+		cacheTimestamps(nVertices, 0u),
+		timestamp{cacheSize + 1},
+		cacheSize{cacheSize}
+	{
+
+	}
+
+	unsigned access( const unsigned v ) noexcept
+	{
+		if ( timestamp - cacheTimestamps[v] > cacheSize )
+		{
+			cacheTimestamps[v] = timestamp++;
+			return 1u;
+		}
+		return 0u;
+	}
+
+	unsigned accessTriangle( const unsigned *triangle ) noexcept
+	{
+		return access( triangle[0] ) + access( triangle[1] ) + access( triangle[2] );
+	}
+
+	void flush() noexcept
+	{
+		timestamp += cacheSize + 1;
+	}
+};
+
+std::array<float, 3> loadPosition( const char *pVertices,
+	const std::size_t stride,
+	const std::size_t positionOffset,
+	const unsigned v ) noexcept
+{
+	std::array<float, 3> position;
+	std::memcpy( position.data(), pVertices + v * stride + positionOffset, sizeof( position ) );
+	return position;
+}
+
+
+/// \brief	error( p ) = ( p^T A p + 2 b.p + c ) / weight, the area weighted mean squared distance of p to the accumulated planes
+struct Quadric final
+{
+	double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;
+
+	/// \brief	n must be unit length, the plane is n.p + d = 0
+	static Quadric fromPlane( const std::array<double, 3> &n,
+		const double d,
+		const double weight ) noexcept
+	{
+		Quadric q;
+		q.a00 = weight * n[0] * n[0];
+		q.a01 = weight * n[0] * n[1];
+		q.a02 = weight * n[0] * n[2];
+		q.a11 = weight * n[1] * n[1];
+		q.a12 = weight * n[1] * n[2];
+		q.a22 = weight * n[2] * n[2];
+		q.b0 = weight * n[0] * d;
+		q.b1 = weight * n[1] * d;
+		q.b2 = weight * n[2] * d;
+		q.c = weight * d * d;
+		q.weight = weight;
+		return q;
+	}
+
+	Quadric& operator+=( const Quadric &rhs ) noexcept
+	{
+		a00 += rhs.a00;
+		a01 += rhs.a01;
+		a02 += rhs.a02;
+		a11 += rhs.a11;
+		a12 += rhs.a12;
+		a22 += rhs.a22;
+		b0 += rhs.b0;
+		b1 += rhs.b1;
+		b2 += rhs.b2;
+		c += rhs.c;
+		weight += rhs.weight;
+		return *this;
+	}
+
+	double calcError( const float *p ) const noexcept
+	{
+		if ( weight <= 0.0 )
+		{
+			return 0.0;
+		}
+		const double x = p[0];
+		const double y = p[1];
+		const double z = p[2];
+		const double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * ( a01 * x * y + a02 * x * z + a12 * y * z ) + 2.0 * ( b0 * x + b1 * y + b2 * z ) + c;
+		return std::max( error, 0.0 ) / weight;
+	}
+};
+
+std::array<float, 3> calcTriangleNormal( const float *p0,
+	const float *p1,
+	const float *p2 ) noexcept
+{
+	const std::array<float, 3> ab{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+	const std::array<float, 3> ac{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+	return {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+}
+
+float dot3( const std::array<float, 3> &lhs,
+	const std::array<float, 3> &rhs ) noexcept
+{
+	return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+}
+
+/// \brief	sorted, unique edges of the triangle list, each packed as ( smaller vertex << 32 ) | larger vertex
+std::vector<std::uint64_t> collectEdges( const unsigned *indices,
+	const std::size_t nIndices,
+	const bool bUnique )
+{
+	std::vector<std::uint64_t> edges;
+	edges.reserve( nIndices );
+	for ( std::size_t i = 0; i < nIndices; i += 3 )
+	{
+		for ( unsigned corner = 0; corner < 3; ++corner )
+		{
+			const unsigned a = indices[i + corner];
+			const unsigned b = indices[i + ( corner + 1 ) % 3];
+			edges.push_back( static_cast<std::uint64_t>( std::min( a, b ) ) << 32 | std::max( a, b ) );
+		}
+	}
+	std::sort( edges.begin(), edges.end() );
+	if ( bUnique )
+	{
+		edges.erase( std::unique( edges.begin(), edges.end() ), edges.end() );
+	}
+	return edges;
+}
+
+
+}//namespace
+
+float calcAcmr( const unsigned *indices,
+	const std::size_t nIndices,
+	const std::size_t nVertices,
+	const unsigned cacheSize /*= s_fifoCacheSize*/ )
+{
+	if ( nIndices < 3 )
+	{
+		return 0.0f;
+	}
+
+	FifoCache cache{nVertices, cacheSize};
+	std::size_t nMisses = 0;
+	for ( std::size_t i = 0; i < nIndices; ++i )
+	{
+		nMisses += cache.access( indices[i] );
+	}
+	return float( nMisses ) / float( nIndices / 3 );
+}
+
+std::size_t deduplicateVertices( char *pVertices,
+	const std::size_t nVertices,
+	const std::size_t stride,
+	unsigned *indices,
+	const std::size_t nIndices )
+{
+	// keys view the vertices' final place, in front of the one being looked up, so compacting never invalidates them
+	std::unordered_map<std::string_view, unsigned> uniqueVertices;
+	uniqueVertices.reserve( nVertices );
+	std::vector<unsigned> remap( nVertices );
+	std::size_t nUniqueVertices = 0;
+	for ( std::size_t v = 0; v < nVertices; ++v )
+	{
+		const char *pVertex = pVertices + v * stride;
+		const auto it = uniqueVertices.find( std::string_view{pVertex, stride} );
+		if ( it != uniqueVertices.end() )
+		{
+			remap[v] = it->second;
+			continue;
+		}
+
+		char *pUniqueVertex = pVertices + nUniqueVertices * stride;
+		if ( pUniqueVertex != pVertex )
+		{
+			std::memcpy( pUniqueVertex, pVertex, stride );
+		}
+		remap[v] = static_cast<unsigned>( nUniqueVertices );
+		uniqueVertices.emplace( std::string_view{pUniqueVertex, stride}, remap[v] );
+		++nUniqueVertices;
+	}
+
+	for ( std::size_t i = 0; i < nIndices; ++i )
+	{
+		indices[i] = remap[indices[i]];
+	}
+	return nUniqueVertices;
+}
+
+void optimizeVertexCache( unsigned *indices,
+	const std::size_t nIndices,
+	const std::size_t nVertices )
+{
+	ASSERT( nIndices % 3 == 0, "Not a triangle list!" );
+	const std::size_t nTriangles = nIndices / 3;
+	if ( nTriangles < 2 )
+	{
+		return;
+	}
+	static const VertexScoreTable scoreTable;
+
+	// the triangles of each vertex that are yet to be emitted are kept at the front of its adjacency range
+	std::vector<unsigned> nRemainingTriangles( nVertices, 0u );
+	for ( std::size_t i = 0; i < nIndices; ++i )
+	{
+		++nRemainingTriangles[indices[i]];
+	}
+	std::vector<unsigned> adjacencyOffsets( nVertices + 1, 0u );
+	for ( std::size_t v = 0; v < nVertices; ++v )
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + nRemainingTriangles[v];
+	}
+	std::vector<unsigned> adjacency( nIndices );
+	{
+		std::vector<unsigned> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for ( std::size_t i = 0; i < nIndices; ++i )
+		{
+			adjacency[fill[indices[i]]++] = static_cast<unsigned>( i / 3 );
+		}
+	}
+
+	std::vector<float> vertexScores( nVertices );
+	for ( std::size_t v = 0; v < nVertices; ++v )
+	{
+		vertexScores[v] = scoreTable.calcScore( -1, nRemainingTriangles[v] );
+	}
+	std::vector<float> triangleScores( nTriangles );
+	unsigned bestTriangle = 0;
+	for ( std::size_t t = 0; t < nTriangles; ++t )
+	{
+		const unsigned *triangle = indices + t * 3;
+		triangleScores[t] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+		if ( triangleScores[t] > triangleScores[bestTriangle] )
+		{
+			bestTriangle = static_cast<unsigned>( t );
+		}
+	}
+
+	const std::vector<unsigned> sourceIndices(indices, indices + nIndices);
+	std::vector<bool> emitted( nTriangles, false );
+	std::array<unsigned, s_lruCacheSize + 3> cache;
+	std::array<unsigned, s_lruCacheSize + 3> newCache;
+	std::size_t cacheCount = 0;
+	std::size_t nextUnemittedTriangle = 0;
+	for ( std::size_t nEmitted = 0; nEmitted < nTriangles; ++nEmitted )
+	{
+		if ( bestTriangle == s_invalidTriangle )
+		{
+			// dead end, none of the cached vertices has triangles left; restart from the next triangle in input order
+			while ( emitted[nextUnemittedTriangle] )
+			{
+				++nextUnemittedTriangle;
+			}
+			bestTriangle = static_cast<unsigned>( nextUnemittedTriangle );
+		}
+
+		const unsigned *triangle = sourceIndices.data() + bestTriangle * 3;
+		std::copy_n( triangle, 3, indices + nEmitted * 3 );
+		emitted[bestTriangle] = true;
+
+		// the emitted triangle's vertices go to the front of the LRU cache
+		std::size_t newCacheCount = 0;
+		for ( unsigned corner = 0; corner < 3; ++corner )
+		{
+			const unsigned v = triangle[corner];
+			if ( std::find( newCache.begin(), newCache.begin() + newCacheCount, v ) == newCache.begin() + newCacheCount )
+			{
+				newCache[newCacheCount++] = v;
+			}
+
+			unsigned *pFirst = adjacency.data() + adjacencyOffsets[v];
+			unsigned *pLast = pFirst + nRemainingTriangles[v];
+			*std::find( pFirst, pLast, bestTriangle ) = *( pLast - 1 );
+			--nRemainingTriangles[v];
+		}
+		for ( std::size_t i = 0; i < cacheCount; ++i )
+		{
+			const unsigned v = cache[i];
+			if ( std::find( newCache.begin(), newCache.begin() + newCacheCount, v ) == newCache.begin() + newCacheCount )
+			{
+				newCache[newCacheCount++] = v;
+			}
+		}
+		cache = newCache;
+		cacheCount = std::min<std::size_t>( newCacheCount, s_lruCacheSize );
+
+		// rescore the vertices that moved in the cache or fell out of it & their triangles; the next triangle is the best of those
+		bestTriangle = s_invalidTriangle;
+		float bestScore = -1.0f;
+		for ( std::size_t i = 0; i < newCacheCount; ++i )
+		{
+			const unsigned v = newCache[i];
+			const int cachePosition = i < s_lruCacheSize ?
+				static_cast<int>( i ) :
+				-1;
+			const float score = scoreTable.calcScore( cachePosition, nRemainingTriangles[v] );
+			const float scoreDelta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			const unsigned *pFirst = adjacency.data() + adjacencyOffsets[v];
+			for ( const unsigned *pTriangle = pFirst; pTriangle != pFirst + nRemainingTriangles[v]; ++pTriangle )
+			{
+				triangleScores[*pTriangle] += scoreDelta;
+				if ( triangleScores[*pTriangle] > bestScore )
+				{
+					bestScore = triangleScores[*pTriangle];
+					bestTriangle = *pTriangle;
+				}
+			}
+		}
+	}
+}
+
+void optimizeOverdraw( unsigned *indices,
+	const std::size_t nIndices,
+	const char *pVertices,
+	const std::size_t nVertices,
+	const std::size_t stride,
+	const std::size_t positionOffset,
+	const float threshold /*= s_overdrawAcmrThreshold*/ )
+{
+	ASSERT( nIndices % 3 == 0, "Not a triangle list!" );
+	const std::size_t nTriangles = nIndices / 3;
+	if ( nTriangles < 2 )
+	{
+		return;
+	}
+
+	// hard boundaries: triangles whose vertices all miss, ie the cache optimizer jumped elsewhere
+	FifoCache cache{nVertices, s_fifoCacheSize};
+	std::vector<unsigned> hardClusters;
+	for ( std::size_t t = 0; t < nTriangles; ++t )
+	{
+		if ( cache.accessTriangle( indices + t * 3 ) == 3 || t == 0 )
+		{
+			hardClusters.push_back( static_cast<unsigned>( t ) );
+		}
+	}
+	hardClusters.push_back( static_cast<unsigned>( nTriangles ) );
+
+	// soft boundaries: a new cluster starts as soon as the current one's ACMR, from a flushed cache, is within threshold of its hard cluster's
+	std::vector<unsigned> clusters;
+	for ( std::size_t c = 0; c + 1 < hardClusters.size(); ++c )
+	{
+		const unsigned first = hardClusters[c];
+		const unsigned last = hardClusters[c + 1];
+
+		cache.flush();
+		unsigned nClusterMisses = 0;
+		for ( unsigned t = first; t < last; ++t )
+		{
+			nClusterMisses += cache.accessTriangle( indices + t * 3 );
+		}
+		const float clusterThreshold = threshold * float( nClusterMisses ) / float( last - first );
+
+		clusters.push_back( first );
+		cache.flush();
+		unsigned nRunningMisses = 0;
+		unsigned nRunningTriangles = 0;
+		for ( unsigned t = first; t + 1 < last; ++t )
+		{
+			nRunningMisses += cache.accessTriangle( indices + t * 3 );
+			++nRunningTriangles;
+			if ( float( nRunningMisses ) <= clusterThreshold * float( nRunningTriangles ) )
+			{
+				clusters.push_back( t + 1 );
+				cache.flush();
+				nRunningMisses = 0;
+				nRunningTriangles = 0;
+			}
+		}
+	}
+	clusters.push_back( static_cast<unsigned>( nTriangles ) );
+	const std::size_t nClusters = clusters.size() - 1;
+	if ( nClusters < 2 )
+	{
+		return;
+	}
+
+	std::array<float, 3> meshCentroid{0.0f, 0.0f, 0.0f};
+	for ( unsigned v = 0; v < nVertices; ++v )
+	{
+		const auto position = loadPosition( pVertices, stride, positionOffset, v );
+		for ( unsigned axis = 0; axis < 3; ++axis )
+		{
+			meshCentroid[axis] += position[axis];
+		}
+	}
+	for ( float &coordinate : meshCentroid )
+	{
+		coordinate /= float( nVertices );
+	}
+
+	// clusters facing away from the centroid are drawn first
+	std::vector<float> sortKeys( nClusters );
+	for ( std::size_t c = 0; c < nClusters; ++c )
+	{
+		std::array<float, 3> centroid{0.0f, 0.0f, 0.0f};
+		std::array<float, 3> normal{0.0f, 0.0f, 0.0f};
+		float area = 0.0f;
+		for ( unsigned t = clusters[c]; t < clusters[c + 1]; ++t )
+		{
+			const auto p0 = loadPosition( pVertices, stride, positionOffset, indices[t * 3] );
+			const auto p1 = loadPosition( pVertices, stride, positionOffset, indices[t * 3 + 1] );
+			const auto p2 = loadPosition( pVertices, stride, positionOffset, indices[t * 3 + 2] );
+			const std::array<float, 3> ab{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+			const std::array<float, 3> ac{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+			const std::array<float, 3> cross{ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+			const float triangleArea = std::sqrt( cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2] );
+			for ( unsigned axis = 0; axis < 3; ++axis )
+			{
+				centroid[axis] += ( p0[axis] + p1[axis] + p2[axis] ) * ( triangleArea / 3.0f );
+				normal[axis] += cross[axis];
+			}
+			area += triangleArea;
+		}
+
+		const float invArea = area > 0.0f ?
+			1.0f / area :
+			0.0f;
+		const float normalLength = std::sqrt( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+		const float invNormalLength = normalLength > 0.0f ?
+			1.0f / normalLength :
+			0.0f;
+		float key = 0.0f;
+		for ( unsigned axis = 0; axis < 3; ++axis )
+		{
+			key += ( centroid[axis] * invArea - meshCentroid[axis] ) * normal[axis] * invNormalLength;
+		}
+		sortKeys[c] = key;
+	}
+
+	std::vector<unsigned> clusterOrder( nClusters );
+	for ( unsigned c = 0; c < nClusters; ++c )
+	{
+		clusterOrder[c] = c;
+	}
+	std::stable_sort( clusterOrder.begin(), clusterOrder.end(),
+		[&sortKeys] ( const unsigned lhs, const unsigned rhs )
+		{
+			return sortKeys[lhs] > sortKeys[rhs];
+		} );
+
+	const std::vector<unsigned> sourceIndices(indices, indices + nIndices);
+	unsigned *pOut = indices;
+	for ( const unsigned c : clusterOrder )
+	{
+		pOut = std::copy( sourceIndices.begin() + clusters[c] * 3, sourceIndices.begin() + clusters[c + 1] * 3, pOut );
+	}
+}
+
+std::size_t optimizeVertexFetch( char *pVertices,
+	const std::size_t nVertices,
+	const std::size_t stride,
+	unsigned *indices,
+	const std::size_t nIndices )
+{
+	static constexpr unsigned s_unused = ~0u;
+
+	std::vector<unsigned> remap( nVertices, s_unused );
+	unsigned nUsedVertices = 0;
+	for ( std::size_t i = 0; i < nIndices; ++i )
+	{
+		unsigned &newIndex = remap[indices[i]];
+		if ( newIndex == s_unused )
+		{
+			newIndex = nUsedVertices++;
+		}
+		indices[i] = newIndex;
+	}
+
+	std::vector<char> reorderedVertices( nUsedVertices * stride );
+	for ( std::size_t v = 0; v < nVertices; ++v )
+	{
+		if ( remap[v] != s_unused )
+		{
+			std::memcpy( reorderedVertices.data() + remap[v] * stride, pVertices + v * stride, stride );
+		}
+	}
+	std::memcpy( pVertices, reorderedVertices.data(), reorderedVertices.size() );
+	return nUsedVertices;
+}
+
+bool canUse16BitIndices( const std::size_t nVertices ) noexcept
+{
+	// 0xFFFF is left out, it's the strip cut value
+	return nVertices <= 0xFFFFu;
+}
+
+std::vector<StepReport> optimize( char *pVertices,
+	std::size_t &nVertices,
+	const std::size_t stride,
+	const std::size_t positionOffset,
+	std::vector<unsigned> &indices )
+{
+	std::vector<StepReport> reports;
+	reports.reserve( 5 );
+	const auto beginStep = [&] ( const char *name ) -> StepReport&
+		{
+			const float acmr = calcAcmr( indices.data(), indices.size(), nVertices );
+			reports.push_back( StepReport{name, acmr, acmr, nVertices * stride, nVertices * stride, indices.size() * sizeof( unsigned ), indices.size() * sizeof( unsigned )} );
+			return reports.back();
+		};
+	const auto endStep = [&] ( StepReport &report ) -> void
+		{
+			report.acmrAfter = calcAcmr( indices.data(), indices.size(), nVertices );
+			report.vertexBytesAfter = nVertices * stride;
+			report.indexBytesAfter = indices.size() * sizeof( unsigned );
+		};
+
+	{
+		auto &report = beginStep( "vertex deduplication" );
+		nVertices = deduplicateVertices( pVertices, nVertices, stride, indices.data(), indices.size() );
+		endStep( report );
+	}
+	{
+		auto &report = beginStep( "vertex cache" );
+		optimizeVertexCache( indices.data(), indices.size(), nVertices );
+		endStep( report );
+	}
+	{
+		auto &report = beginStep( "overdraw" );
+		optimizeOverdraw( indices.data(), indices.size(), pVertices, nVertices, stride, positionOffset );
+		endStep( report );
+	}
+	{
+		auto &report = beginStep( "vertex fetch" );
+		nVertices = optimizeVertexFetch( pVertices, nVertices, stride, indices.data(), indices.size() );
+		endStep( report );
+	}
+	{
+		auto &report = beginStep( "index format" );
+		endStep( report );
+		if ( canUse16BitIndices( nVertices ) )
+		{
+			report.indexBytesAfter = indices.size() * sizeof( std::uint16_t );
+		}
+	}
+	return reports;
+}
+
+std::size_t simplify( unsigned *indices,
+	const std::size_t nIndices,
+	const char *pVertices,
+	const std::size_t nVertices,
+	const std::size_t stride,
+	const std::size_t positionOffset,
+	const std::size_t targetIndexCount,
+	const float targetError,
+	const Attribute *pAttributes /*= nullptr*/,
+	const std::size_t nAttributes /*= 0*/,
+	float *pResultError /*= nullptr*/ )
+{
+	ASSERT( nIndices % 3 == 0, "Not a triangle list!" );
+	if ( pResultError != nullptr )
+	{
+		*pResultError = 0.0f;
+	}
+	if ( nIndices <= targetIndexCount || nVertices == 0 )
+	{
+		return nIndices;
+	}
+
+	// positions are normalized to the unit cube so the error doesn't depend on the mesh's scale
+	std::vector<float> positions( nVertices * 3 );
+	std::array<float, 3> minPosition{FLT_MAX, FLT_MAX, FLT_MAX};
+	std::array<float, 3> maxPosition{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for ( unsigned v = 0; v < nVertices; ++v )
+	{
+		const auto position = loadPosition( pVertices, stride, positionOffset, v );
+		for ( unsigned axis = 0; axis < 3; ++axis )
+		{
+			positions[v * 3 + axis] = position[axis];
+			minPosition[axis] = std::min( minPosition[axis], position[axis] );
+			maxPosition[axis] = std::max( maxPosition[axis], position[axis] );
+		}
+	}
+	const float extent = std::max( {maxPosition[0] - minPosition[0], maxPosition[1] - minPosition[1], maxPosition[2] - minPosition[2]} );
+	const float invExtent = extent > 0.0f ?
+		1.0f / extent :
+		0.0f;
+	for ( std::size_t v = 0; v < nVertices; ++v )
+	{
+		for ( unsigned axis = 0; axis < 3; ++axis )
+		{
+			positions[v * 3 + axis] = ( positions[v * 3 + axis] - minPosition[axis] ) * invExtent;
+		}
+	}
+
+	// the area weighted normals of the original surface around each vertex
+	std::vector<Quadric> quadrics( nVertices );
+	std::vector<std::array<float, 3>> vertexNormals( nVertices, std::array<float, 3>{0.0f, 0.0f, 0.0f} );
+	for ( std::size_t i = 0; i < nIndices; i += 3 )
+	{
+		const float *p0 = &positions[indices[i] * 3];
+		const auto normal = calcTriangleNormal( p0, &positions[indices[i + 1] * 3], &positions[indices[i + 2] * 3] );
+		const double length = std::sqrt( double( dot3( normal, normal ) ) );
+		if ( length <= 0.0 )
+		{
+			continue;
+		}
+		for ( unsigned corner = 0; corner < 3; ++corner )
+		{
+			for ( unsigned axis = 0; axis < 3; ++axis )
+			{
+				vertexNormals[indices[i + corner]][axis] += normal[axis];
+			}
+		}
+		const std::array<double, 3> n{normal[0] / length, normal[1] / length, normal[2] / length};
+		const auto quadric = Quadric::fromPlane( n, -( n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2] ), length * 0.5 );
+		for ( unsigned corner = 0; corner < 3; ++corner )
+		{
+			quadrics[indices[i + corner]] += quadric;
+		}
+	}
+
+	// an edge with a single triangle is on the border or on a seam, where the vertices were split for their attributes; edges with more are non manifold
+	std::vector<bool> locked( nVertices, false );
+	{
+		const auto edges = collectEdges( indices, nIndices, false );
+		for ( std::size_t first = 0, last = 0; first < edges.size(); first = last )
+		{
+			while ( last < edges.size() && edges[last] == edges[first] )
+			{
+				++last;
+			}
+			if ( last - first != 2 )
+			{
+				locked[edges[first] >> 32] = true;
+				locked[edges[first] & 0xFFFFFFFFu] = true;
+			}
+		}
+	}
+
+	struct Collapse final
+	{
+		unsigned from;
+		unsigned to;
+		float error;	// squared, geometric only
+		float cost;		// error + the attributes' penalty
+	};
+	const auto calcCollapse = [&] ( const unsigned from,
+		const unsigned to ) -> Collapse
+		{
+			Quadric quadric = quadrics[from];
+			quadric += quadrics[to];
+			const float error = static_cast<float>( quadric.calcError( &positions[to * 3] ) );
+			float penalty = 0.0f;
+			for ( std::size_t a = 0; a < nAttributes; ++a )
+			{
+				const float *pFrom = reinterpret_cast<const float*>( pVertices + from * stride + pAttributes[a].offset );
+				const float *pTo = reinterpret_cast<const float*>( pVertices + to * stride + pAttributes[a].offset );
+				float difference = 0.0f;
+				for ( unsigned component = 0; component < pAttributes[a].nComponents; ++component )
+				{
+					difference += ( pFrom[component] - pTo[component] ) * ( pFrom[component] - pTo[component] );
+				}
+				penalty += difference * pAttributes[a].weight;
+			}
+			return Collapse{from, to, error, error + penalty};
+		};
+
+	const float maxError = targetError * targetError;
+	float resultError = 0.0f;
+	std::size_t indexCount = nIndices;
+	std::vector<unsigned> nTriangles( nVertices );
+	std::vector<unsigned> adjacencyOffsets( nVertices + 1 );
+	std::vector<unsigned> adjacency;
+	std::vector<unsigned> remap( nVertices );
+	std::vector<bool> touched( nVertices );
+	std::vector<Collapse> collapses;
+	while ( indexCount > targetIndexCount )
+	{
+		std::fill( nTriangles.begin(), nTriangles.end(), 0u );
+		for ( std::size_t i = 0; i < indexCount; ++i )
+		{
+			++nTriangles[indices[i]];
+		}
+		adjacencyOffsets[0] = 0u;
+		for ( std::size_t v = 0; v < nVertices; ++v )
+		{
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + nTriangles[v];
+		}
+		adjacency.resize( indexCount );
+		{
+			std::vector<unsigned> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for ( std::size_t i = 0; i < indexCount; ++i )
+			{
+				adjacency[fill[indices[i]]++] = static_cast<unsigned>( i / 3 );
+			}
+		}
+
+		// the cheaper direction of each edge, onto a locked vertex is fine
+		collapses.clear();
+		for ( const std::uint64_t edge : collectEdges( indices, indexCount, true ) )
+		{
+			const unsigned a = static_cast<unsigned>( edge >> 32 );
+			const unsigned b = static_cast<unsigned>( edge & 0xFFFFFFFFu );
+			if ( locked[a] && locked[b] )
+			{
+				continue;
+			}
+			const Collapse collapse = locked[a] ?
+				calcCollapse( b, a ) :
+				locked[b] ?
+					calcCollapse( a, b ) :
+					std::min( calcCollapse( a, b ), calcCollapse( b, a ),
+						[] ( const Collapse &lhs, const Collapse &rhs )
+						{
+							return lhs.cost < rhs.cost;
+						} );
+			if ( collapse.error <= maxError )
+			{
+				collapses.push_back( collapse );
+			}
+		}
+		std::sort( collapses.begin(), collapses.end(),
+			[] ( const Collapse &lhs, const Collapse &rhs )
+			{
+				return lhs.cost < rhs.cost;
+			} );
+
+		// greedily collapse the cheapest edges whose neighborhoods haven't changed in this pass yet
+		std::iota( remap.begin(), remap.end(), 0u );
+		std::fill( touched.begin(), touched.end(), false );
+		const std::size_t nTrianglesToRemove = ( indexCount - targetIndexCount + 2 ) / 3;
+		std::size_t nRemovedTriangles = 0;
+		for ( const Collapse &collapse : collapses )
+		{
+			if ( nRemovedTriangles >= nTrianglesToRemove )
+			{
+				break;
+			}
+			if ( touched[collapse.from] || touched[collapse.to] )
+			{
+				continue;
+			}
+
+			// moving `from` onto `to` must not flip any of the remaining triangles around it, nor turn one away from the original surface there
+			//	which small turns over several passes would otherwise add up to
+			const unsigned *pFirst = adjacency.data() + adjacencyOffsets[collapse.from];
+			const unsigned *pLast = adjacency.data() + adjacencyOffsets[collapse.from + 1];
+			bool bFlips = false;
+			unsigned nCollapsedTriangles = 0;
+			for ( const unsigned *pTriangle = pFirst; pTriangle != pLast && !bFlips; ++pTriangle )
+			{
+				const unsigned *triangle = indices + *pTriangle * 3;
+				if ( triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to )
+				{
+					++nCollapsedTriangles;
+					continue;
+				}
+				std::array<const float*, 3> corners;
+				std::array<const float*, 3> movedCorners;
+				for ( unsigned corner = 0; corner < 3; ++corner )
+				{
+					corners[corner] = &positions[triangle[corner] * 3];
+					movedCorners[corner] = triangle[corner] == collapse.from ?
+						&positions[collapse.to * 3] :
+						corners[corner];
+				}
+				const auto normal = calcTriangleNormal( corners[0], corners[1], corners[2] );
+				const auto movedNormal = calcTriangleNormal( movedCorners[0], movedCorners[1], movedCorners[2] );
+				bFlips = dot3( normal, movedNormal ) <= 0.25f * std::sqrt( dot3( normal, normal ) * dot3( movedNormal, movedNormal ) )
+					|| dot3( vertexNormals[collapse.to], movedNormal ) <= 0.0f;
+			}
+			if ( bFlips )
+			{
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			resultError = std::max( resultError, collapse.error );
+			nRemovedTriangles += nCollapsedTriangles;
+			for ( const unsigned *pTriangle = pFirst; pTriangle != pLast; ++pTriangle )
+			{
+				for ( unsigned corner = 0; corner < 3; ++corner )
+				{
+					touched[indices[*pTriangle * 3 + corner]] = true;
+				}
+			}
+		}
+		if ( nRemovedTriangles == 0 )
+		{
+			break;
+		}
+
+		std::size_t newIndexCount = 0;
+		for ( std::size_t i = 0; i < indexCount; i += 3 )
+		{
+			const unsigned a = remap[indices[i]];
+			const unsigned b = remap[indices[i + 1]];
+			const unsigned c = remap[indices[i + 2]];
+			if ( a != b && b != c && a != c )
+			{
+				indices[newIndexCount++] = a;
+				indices[newIndexCount++] = b;
+				indices[newIndexCount++] = c;
+			}
+		}
+		indexCount = newIndexCount;
+	}
+
+	if ( pResultError != nullptr )
+	{
+		*pResultError = std::sqrt( resultError );
+	}
+	return indexCount;
+}
+
+std::vector<Lod> generateLods( std::vector<unsigned> &indices,
+	const char *pVertices,
+	const std::size_t nVertices,
+	const std::size_t stride,
+	const std::size_t positionOffset,
+	const Attribute *pAttributes,
+	const std::size_t nAttributes,
+	const LodSettings &settings /*= {}*/ )
+{
+	const std::size_t nBaseIndices = indices.size();
+	std::vector<Lod> lods;
+	lods.reserve( settings.nLods );
+	lods.push_back( Lod{0u, static_cast<unsigned>( nBaseIndices ), 0.0f} );
+
+	// every LOD is simplified from the full detail indices, so its error is against the original surface
+	std::vector<unsigned> lodIndices;
+	for ( unsigned lod = 1; lod < settings.nLods; ++lod )
+	{
+		const std::size_t targetIndexCount = static_cast<std::size_t>( lods.back().nIndices * settings.reduction ) / 3 * 3;
+		if ( targetIndexCount < 3 )
+		{
+			break;
+		}
+		lodIndices.assign( indices.begin(), indices.begin() + nBaseIndices );
+		float error = 0.0f;
+		const std::size_t nLodIndices = simplify( lodIndices.data(), lodIndices.size(), pVertices, nVertices, stride, positionOffset, targetIndexCount, settings.targetError, pAttributes, nAttributes, &error );
+		if ( nLodIndices == 0 || float( nLodIndices ) > float( lods.back().nIndices ) * s_minLodReduction )
+		{
+			break;
+		}
+
+		optimizeVertexCache( lodIndices.data(), nLodIndices, nVertices );
+		lods.push_back( Lod{static_cast<unsigned>( indices.size() ), static_cast<unsigned>( nLodIndices ), std::max( error, lods.back().error )} );
+		indices.insert( indices.end(), lodIndices.begin(), lodIndices.begin() + nLodIndices );
+	}
+	return lods;
+}
+
+unsigned selectLod( const Lod *pLods,
+	const std::size_t nLods,
+	const float pixelSize,
+	const unsigned currentLod,
+	const float maxPixelError /*= s_lodMaxPixelError*/,
+	const float hysteresis /*= s_lodHysteresis*/ ) noexcept
+{
+	if ( nLods < 2 )
+	{
+		return 0u;
+	}
+
+	// LOD errors never decrease, so the acceptable LODs are a prefix
+	const auto findCoarsestLod = [pLods, nLods, pixelSize] ( const float maxError ) -> unsigned
+		{
+			unsigned lod = 0u;
+			while ( lod + 1 < nLods && pLods[lod + 1].error * pixelSize <= maxError )
+			{
+				++lod;
+			}
+			return lod;
+		};
+	const unsigned lod = std::min( currentLod, static_cast<unsigned>( nLods - 1 ) );
+	const unsigned coarserLod = findCoarsestLod( maxPixelError * ( 1.0f - hysteresis ) );
+	if ( coarserLod > lod )
+	{
+		return coarserLod;
+	}
+	if ( pLods[lod].error * pixelSize <= maxPixelError * ( 1.0f + hysteresis ) )
+	{
+		return lod;
+	}
+	return findCoarsestLod( maxPixelError );
+}
+
+
+}//namespace mesh_opt
\ No newline at end of file
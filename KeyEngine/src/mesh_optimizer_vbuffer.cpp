@@ -0,0 +1,39 @@
+#include "mesh_optimizer_vbuffer.h"
+#include "dynamic_vertex_buffer.h"
+
+
+namespace mesh_opt
+{
+
+std::vector<StepReport> optimize( ver::VBuffer &vb,
+	std::vector<unsigned> &indices )
+{
+	using Type = ver::VertexInputLayout::ILEementType;
+
+	const auto &layout = vb.getLayout();
+	std::size_t nVertices = vb.getVertexCount();
+	std::vector<StepReport> reports = optimize( vb.data(), nVertices, layout.getSizeInBytes(), layout.fetch<Type::Position3D>().getOffset(), indices );
+	vb.resize( nVertices );
+	return reports;
+}
+
+std::vector<Lod> generateLods( const ver::VBuffer &vb,
+	std::vector<unsigned> &indices,
+	const LodSettings &settings /*= {}*/ )
+{
+	using Type = ver::VertexInputLayout::ILEementType;
+
+	const auto &layout = vb.getLayout();
+	std::vector<Attribute> attributes;
+	if ( layout.hasType( Type::Normal ) )
+	{
+		attributes.push_back( Attribute{layout.fetch<Type::Normal>().getOffset(), 3u, settings.normalWeight} );
+	}
+	if ( layout.hasType( Type::Texture2D ) )
+	{
+		attributes.push_back( Attribute{layout.fetch<Type::Texture2D>().getOffset(), 2u, settings.texcoordWeight} );
+	}
+	return generateLods( indices, vb.data(), vb.getVertexCount(), layout.getSizeInBytes(), layout.fetch<Type::Position3D>().getOffset(), attributes.data(), attributes.size(), settings );
+}
+
+}//namespace mesh_opt
\ No newline at end of file
@@ -1,166 +1,241 @@
+#include <cstring>
 #include "message_queue_bus_dispatcher.h"
-#include "message.h"
 #include "entity.h"
 #include "assertions_console.h"
 
 
-void MessageBus::removeFrontByBackSwap()
+namespace
 {
-	std::swap( m_vec.front(), m_vec.back() );
-	m_vec.pop_back();
-}
 
-MessageBus::MessageBus( const int initialCapacity )
-	:
-	m_vec(initialCapacity)
+std::size_t roundUpToPowerOf2( std::size_t n ) noexcept
 {
-
+	std::size_t p = 2u;
+	while ( p < n )
+	{
+		p <<= 1;
+	}
+	return p;
 }
 
-MessageBus::MessageBus( MessageBus &&rhs ) noexcept
+}// namespace
+
+MessageBus::MessageBus( const std::size_t capacity )
 	:
-	m_vec{std::move( rhs.m_vec )},
-	m_size(rhs.m_size)
+	m_mask{roundUpToPowerOf2( capacity ) - 1},
+	m_cells{std::make_unique<Cell[]>( m_mask + 1 )},
+	m_nPayloadBlocks{( m_mask + 1 ) / 4 < 64u ? 64u : ( m_mask + 1 ) / 4},
+	m_payloadBlocksMemory{std::make_unique<unsigned char[]>( m_nPayloadBlocks * s_payloadBlockSize + s_payloadBlockAlignment )},
+	m_freePayloadBlocks{roundUpToPowerOf2( m_nPayloadBlocks )}
 {
+	for ( std::size_t i = 0; i <= m_mask; ++i )
+	{
+		m_cells[i].m_sequence.store( i, std::memory_order_relaxed );
+	}
 
+	void *pMemory = m_payloadBlocksMemory.get();
+	std::size_t space = m_nPayloadBlocks * s_payloadBlockSize + s_payloadBlockAlignment;
+	m_pPayloadBlocks = static_cast<unsigned char*>( std::align( s_payloadBlockAlignment, m_nPayloadBlocks * s_payloadBlockSize, pMemory, space ) );
+	for ( std::size_t i = 0; i < m_nPayloadBlocks; ++i )
+	{
+		m_freePayloadBlocks.tryPush( static_cast<std::uint32_t>( i ) );
+	}
 }
 
-MessageBus& MessageBus::operator=( MessageBus &&rhs ) noexcept
-{
-	MessageBus tmp{std::move( rhs )};
-	std::swap( *this, tmp );
-	return *this;
-}
-
-void MessageBus::enqueue( Message *msg )
+MessageBus::~MessageBus() noexcept
 {
-	std::unique_lock<std::mutex> lg{m_mu};
-	m_vec.emplace_back( msg );
-	++m_size;
-	m_cond.notify_one();
+	clear();
 }
 
-std::unique_ptr<Message> MessageBus::dequeue()
+MessageBus::Cell* MessageBus::claimCell( std::size_t &pos ) noexcept
 {
-	std::unique_lock<std::mutex> ul{m_mu};
-
-	if ( m_vec.empty() )
+	pos = m_enqueuePos.load( std::memory_order_relaxed );
+	while ( true )
 	{
-		throw std::runtime_error{"Attempted to pop from empty Queue."};
-	}
-	while ( m_vec.empty() )
-	{
-		m_cond.wait( ul );
+		Cell &cell = m_cells[pos & m_mask];
+		const std::size_t seq = cell.m_sequence.load( std::memory_order_acquire );
+		const std::intptr_t diff = static_cast<std::intptr_t>( seq ) - static_cast<std::intptr_t>( pos );
+		if ( diff == 0 )
+		{
+			if ( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+			{
+				return &cell;
+			}
+		}
+		else if ( diff < 0 )
+		{
+			// the consumer has not released this cell yet - full
+			return nullptr;
+		}
+		else
+		{
+			pos = m_enqueuePos.load( std::memory_order_relaxed );
+		}
 	}
-	std::unique_ptr<Message> pOut = std::move( m_vec.back() );
-	m_vec.pop_back();
-	--m_size;
-	return pOut;
 }
 
-const Message* MessageBus::peekFront() const noexcept
+void MessageBus::publish( Cell &cell,
+	const std::size_t pos ) noexcept
 {
-	std::lock_guard<std::mutex> lg{m_mu};
-	return m_vec.front().get();
+	cell.m_sequence.store( pos + 1, std::memory_order_release );
 }
 
-const Message* MessageBus::peekBack() const noexcept
+void* MessageBus::acquirePayloadBlock() noexcept
 {
-	std::lock_guard<std::mutex> lg{m_mu};
-	return m_vec.back().get();
+	std::uint32_t blockIndex;
+	if ( !m_freePayloadBlocks.tryPop( blockIndex ) )
+	{
+		return nullptr;
+	}
+	return m_pPayloadBlocks + blockIndex * s_payloadBlockSize;
 }
 
-MessageBus::operator bool()
+void MessageBus::releasePayloadBlock( void *pBlock ) noexcept
 {
-	std::lock_guard<std::mutex> lg{m_mu};
-	return !m_vec.empty();
+	const std::size_t offset = static_cast<unsigned char*>( pBlock ) - m_pPayloadBlocks;
+	ASSERT( offset % s_payloadBlockSize == 0 && offset / s_payloadBlockSize < m_nPayloadBlocks, "Invalid payload block!" );
+	m_freePayloadBlocks.tryPush( static_cast<std::uint32_t>( offset / s_payloadBlockSize ) );
 }
 
-Message* MessageBus::operator[]( const std::size_t index )
+void MessageBus::releasePayload( Message &msg ) noexcept
 {
-	std::lock_guard<std::mutex> lg{m_mu};
-	if ( m_vec.empty() || index < 0 || index >= m_vec.size() )
+	if ( msg.m_pPayload == nullptr )
 	{
-		throw std::out_of_range( "Invalid index." );
+		return;
 	}
-	return m_vec[index].get();
-}
 
-const Message* MessageBus::operator[]( const std::size_t index ) const
-{
-	std::lock_guard<std::mutex> lg{m_mu};
-	if ( m_vec.empty() || index < 0 || index >= m_vec.size() )
+	if ( msg.m_pfnDestroyPayload != nullptr )
 	{
-		throw std::out_of_range( "Invalid index." );
+		msg.m_pfnDestroyPayload( msg.m_pPayload );
 	}
-	return m_vec[index].get();
+	if ( msg.m_payloadStorage == Message::Pooled )
+	{
+		releasePayloadBlock( msg.m_pPayload );
+	}
+	msg.m_pPayload = nullptr;
+	msg.m_pPayloadTag = nullptr;
+	msg.m_pfnDestroyPayload = nullptr;
+	msg.m_pfnRelocatePayload = nullptr;
+	msg.m_payloadStorage = Message::None;
 }
 
-bool MessageBus::isEmpty() const noexcept
+void MessageBus::relocate( Message &dst,
+	Message &src ) noexcept
 {
-	return m_vec.empty();
+	ASSERT( dst.m_pPayload == nullptr, "Overwriting a live payload!" );
+	dst.m_type = src.m_type;
+	dst.m_pSender = src.m_pSender;
+	dst.m_pRecipient = src.m_pRecipient;
+	dst.m_bHandled = src.m_bHandled;
+	dst.m_pPayloadTag = src.m_pPayloadTag;
+	dst.m_pfnDestroyPayload = src.m_pfnDestroyPayload;
+	dst.m_pfnRelocatePayload = src.m_pfnRelocatePayload;
+	dst.m_payloadStorage = src.m_payloadStorage;
+	if ( src.m_payloadStorage == Message::Inline )
+	{
+		if ( src.m_pfnRelocatePayload != nullptr )
+		{
+			src.m_pfnRelocatePayload( dst.m_inlinePayload, src.m_inlinePayload );
+		}
+		else
+		{
+			std::memcpy( dst.m_inlinePayload, src.m_inlinePayload, Message::s_inlinePayloadSize );
+		}
+		dst.m_pPayload = dst.m_inlinePayload;
+	}
+	else
+	{
+		dst.m_pPayload = src.m_pPayload;
+	}
+
+	src.m_bHandled = true;
+	src.m_pPayload = nullptr;
+	src.m_pPayloadTag = nullptr;
+	src.m_pfnDestroyPayload = nullptr;
+	src.m_pfnRelocatePayload = nullptr;
+	src.m_payloadStorage = Message::None;
 }
 
 void MessageBus::clear()
 {
-	m_vec.clear();
+	consume( [] ( const Message & ) { return true; },
+		[] ( Message & ) {},
+		~std::size_t{0} );
 }
 
 std::size_t MessageBus::getSize() const noexcept
 {
-	return m_size;
+	return m_enqueuePos.load( std::memory_order_relaxed ) - m_dequeuePos.load( std::memory_order_relaxed );
 }
 
 std::size_t MessageBus::getCapacity() const noexcept
 {
-	return m_vec.capacity();
+	return m_mask + 1;
 }
 
-
-MessageDispatcher::MessageDispatcher( const int initialCapacity )
-	:
-	m_mb(initialCapacity)
+bool MessageBus::isEmpty() const noexcept
 {
+	return getSize() == 0;
+}
 
+std::size_t MessageBus::getHeapPayloadCount() const noexcept
+{
+	return m_nHeapPayloads.load( std::memory_order_relaxed );
 }
 
-MessageDispatcher::MessageDispatcher( MessageDispatcher &&rhs ) noexcept
+
+MessageDispatcher::MessageDispatcher( const std::size_t capacity )
 	:
-	m_mb{std::move( rhs.m_mb )}
+	m_mb(capacity)
 {
 
 }
 
-MessageDispatcher& MessageDispatcher::operator=( MessageDispatcher &&rhs ) noexcept
+MessageDispatcher& MessageDispatcher::getInstance( const std::size_t capacity )
 {
-	MessageDispatcher tmp{std::move( rhs )};
-	std::swap( *this, tmp );
-	return *this;
+	static MessageDispatcher instance{capacity};
+	return instance;
 }
 
-MessageDispatcher& MessageDispatcher::getInstance( const int initialCapacity )
+bool MessageDispatcher::post( const Message::Type type,
+	Entity *pSender,
+	Entity *pRecipient )
 {
-	static MessageDispatcher instance{initialCapacity};
-	return instance;
+	return m_mb.post<void>( type, pSender, pRecipient );
 }
 
-void MessageDispatcher::addMessage( Message *msg )
+std::size_t MessageDispatcher::dispatchAll( const std::size_t maxCount )
 {
-	m_mb.enqueue( msg );
+	return m_mb.consume( [] ( const Message & ) { return true; },
+		[] ( Message &msg )
+		{
+			ASSERT( msg.getRecipient() != nullptr, "No recipient!" );
+			msg.getRecipient()->onMessageReceived( msg );
+		},
+		maxCount );
 }
 
-void MessageDispatcher::dispatchAll()
+std::size_t MessageDispatcher::dispatchByEventType( const Message::Type type,
+	const std::size_t maxCount )
 {
-	while ( m_mb.getSize() > 0 )
-	{
-		auto msg = m_mb.dequeue();
-		auto& recipients = msg->getRecipients();
-		ASSERT( recipients.size() != 0, "No recipients!" );
-		for ( Entity *entity : recipients )
+	return m_mb.consume( [type] ( const Message &msg ) { return msg.getType() == type; },
+		[] ( Message &msg )
 		{
-			entity->onMessageReceived( std::move( msg ) );
-		}
-	}
+			ASSERT( msg.getRecipient() != nullptr, "No recipient!" );
+			msg.getRecipient()->onMessageReceived( msg );
+		},
+		maxCount );
+}
+
+std::size_t MessageDispatcher::dispatchEventsTargetedTo( const Entity *pRecipient,
+	const std::size_t maxCount )
+{
+	ASSERT( pRecipient != nullptr, "No recipient!" );
+	return m_mb.consume( [pRecipient] ( const Message &msg ) { return msg.getRecipient() == pRecipient; },
+		[] ( Message &msg )
+		{
+			msg.getRecipient()->onMessageReceived( msg );
+		},
+		maxCount );
 }
 
 std::size_t MessageDispatcher::getSize() const noexcept
@@ -173,6 +248,11 @@ std::size_t MessageDispatcher::getCapacity() const noexcept
 	return m_mb.getCapacity();
 }
 
+std::size_t MessageDispatcher::getHeapPayloadCount() const noexcept
+{
+	return m_mb.getHeapPayloadCount();
+}
+
 void MessageDispatcher::clear()
 {
 	m_mb.clear();
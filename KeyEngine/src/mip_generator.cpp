@@ -0,0 +1,656 @@
+#include "mip_generator.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <immintrin.h>
+#include "winner.h"
+#include "thread_poolj.h"
+#include "utils.h"
+#include "assertions_console.h"
+
+
+namespace mip_gen
+{
+
+namespace
+{
+
+constexpr std::uint32_t s_magic = 0x50494D4Bu;	// "KMIP"
+constexpr unsigned s_srgbEncodeLutSize = 1u << 14;
+constexpr unsigned s_alphaHistogramSize = 4096u;
+constexpr std::size_t s_rowsPerBand = 32u;		// destination rows filtered together, sharing their horizontally filtered source rows
+constexpr double s_sincRadius = 3.0;
+constexpr double s_kaiserAlpha = 4.0;
+constexpr double s_pi = 3.14159265358979323846;
+
+// on disk layout, little endian; the levels' texels or blocks follow the header tightly packed, level 0 first
+struct FileHeader final
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t sourceHash;
+	std::uint64_t settingsHash;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t format;		// bc::Format
+	std::uint32_t flags;		// 1: bAlpha
+	std::uint64_t fileSize;
+};
+
+static_assert( std::is_trivially_copyable_v<FileHeader> && sizeof( ColorBGRA ) == 4, "Cooked mips are copied as raw bytes!" );
+
+std::uint64_t mix( std::uint64_t h ) noexcept
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+std::uint64_t calcSettingsHash( const Settings &settings ) noexcept
+{
+	std::uint32_t cutoffBits;
+	std::memcpy( &cutoffBits, &settings.alphaCutoff, sizeof( cutoffBits ) );
+	const std::uint64_t flags = ( settings.bSrgb ? 1u : 0u ) | ( settings.bNormalMap ? 2u : 0u ) | ( settings.bWrap ? 4u : 0u ) | ( settings.bMask ? 8u : 0u );
+	const std::uint64_t compression = settings.bCompress ?
+		1u + static_cast<std::uint64_t>( settings.quality ) :
+		0u;
+	std::uint64_t h = mix( s_version );
+	h = mix( h ^ static_cast<std::uint64_t>( settings.filter ) );
+	h = mix( h ^ flags );
+	h = mix( h ^ compression );
+	return mix( h ^ cutoffBits );
+}
+
+struct SrgbTables final
+{
+	float decode[256];
+	Byte encode[s_srgbEncodeLutSize];	// indexed by linear * s_srgbEncodeLutSize
+
+	SrgbTables() noexcept
+	{
+		for ( unsigned i = 0; i < 256; ++i )
+		{
+			const double c = i / 255.0;
+			decode[i] = static_cast<float>( c <= 0.04045 ?
+				c / 12.92 :
+				std::pow( ( c + 0.055 ) / 1.055, 2.4 ) );
+		}
+		for ( unsigned i = 0; i < s_srgbEncodeLutSize; ++i )
+		{
+			const double l = ( i + 0.5 ) / s_srgbEncodeLutSize;
+			const double c = l <= 0.0031308 ?
+				l * 12.92 :
+				1.055 * std::pow( l, 1.0 / 2.4 ) - 0.055;
+			encode[i] = static_cast<Byte>( c * 255.0 + 0.5 );
+		}
+	}
+};
+
+const SrgbTables& getSrgbTables() noexcept
+{
+	static const SrgbTables s_tables;
+	return s_tables;
+}
+
+double besselI0( const double x ) noexcept
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for ( int k = 1; k < 64 && term > sum * 1e-12; ++k )
+	{
+		const double t = x / ( 2.0 * k );
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+double sinc( const double x ) noexcept
+{
+	if ( std::abs( x ) < 1e-9 )
+	{
+		return 1.0;
+	}
+	return std::sin( s_pi * x ) / ( s_pi * x );
+}
+
+/// \brief	x in destination texels
+double evalSincFilter( const Filter filter,
+	const double x ) noexcept
+{
+	if ( std::abs( x ) >= s_sincRadius )
+	{
+		return 0.0;
+	}
+	if ( filter == Filter::Lanczos )
+	{
+		return sinc( x ) * sinc( x / s_sincRadius );
+	}
+	const double t = x / s_sincRadius;
+	return sinc( x ) * besselI0( s_kaiserAlpha * std::sqrt( 1.0 - t * t ) ) / besselI0( s_kaiserAlpha );
+}
+
+/// \brief	the weights of a 1D resampling from srcSize to dstSize texels
+struct Taps final
+{
+	unsigned nTaps = 0;
+	std::vector<int> indices;		// nTaps per destination texel, already wrapped or clamped into the source
+	std::vector<float> weights;		// normalized per destination texel, padded with 0s
+};
+
+Taps calcTaps( const unsigned srcSize,
+	const unsigned dstSize,
+	const Filter filter,
+	const bool bWrap )
+{
+	const double scale = double( srcSize ) / dstSize;
+	const double radius = ( filter == Filter::Box ? 0.5 : s_sincRadius ) * scale;
+	const int maxTaps = static_cast<int>( std::ceil( 2.0 * radius ) ) + 1;
+
+	// gather each destination texel's non zero weights first, the widest one decides nTaps
+	std::vector<int> firsts( dstSize );
+	std::vector<double> weights( static_cast<std::size_t>( dstSize ) * maxTaps, 0.0 );
+	std::vector<int> counts( dstSize );
+	Taps taps;
+	for ( unsigned i = 0; i < dstSize; ++i )
+	{
+		const double center = ( i + 0.5 ) * scale;
+		const int start = static_cast<int>( std::floor( center - radius ) );
+		double *pWeights = weights.data() + static_cast<std::size_t>( i ) * maxTaps;
+		int first = -1;
+		int last = -1;
+		double sum = 0.0;
+		for ( int t = 0; t < maxTaps; ++t )
+		{
+			const int j = start + t;
+			const double w = filter == Filter::Box ?
+				std::max( 0.0, std::min( j + 1.0, center + radius ) - std::max( double( j ), center - radius ) ) :
+				evalSincFilter( filter, ( j + 0.5 - center ) / scale );
+			if ( w != 0.0 )
+			{
+				first = first < 0 ? t : first;
+				last = t;
+			}
+			pWeights[t] = w;
+			sum += w;
+		}
+		ASSERT( first >= 0 && sum > 0.0, "No texel under the filter!" );
+		for ( int t = first; t <= last; ++t )
+		{
+			pWeights[t - first] = pWeights[t] / sum;
+		}
+		firsts[i] = start + first;
+		counts[i] = last - first + 1;
+		taps.nTaps = std::max( taps.nTaps, static_cast<unsigned>( counts[i] ) );
+	}
+
+	taps.indices.resize( static_cast<std::size_t>( dstSize ) * taps.nTaps );
+	taps.weights.resize( static_cast<std::size_t>( dstSize ) * taps.nTaps, 0.0f );
+	const int size = static_cast<int>( srcSize );
+	for ( unsigned i = 0; i < dstSize; ++i )
+	{
+		for ( unsigned t = 0; t < taps.nTaps; ++t )
+		{
+			const std::size_t k = static_cast<std::size_t>( i ) * taps.nTaps + t;
+			const int j = firsts[i] + std::min( static_cast<int>( t ), counts[i] - 1 );
+			taps.indices[k] = bWrap ?
+				( j % size + size ) % size :
+				std::clamp( j, 0, size - 1 );
+			if ( static_cast<int>( t ) < counts[i] )
+			{
+				taps.weights[k] = static_cast<float>( weights[static_cast<std::size_t>( i ) * maxTaps + t] );
+			}
+		}
+	}
+	return taps;
+}
+
+/// \brief	to b, g, r, a floats: linear colors in [0,1] or normals in [-1,1]
+void decodeRow( const ColorBGRA *pTexels,
+	const unsigned width,
+	const Settings &settings,
+	float *pOut ) noexcept
+{
+	const auto &srgb = getSrgbTables();
+	for ( unsigned x = 0; x < width; ++x, pOut += 4 )
+	{
+		const ColorBGRA col = pTexels[x];
+		if ( settings.bNormalMap )
+		{
+			pOut[0] = col.getBlue() * ( 2.0f / 255.0f ) - 1.0f;
+			pOut[1] = col.getGreen() * ( 2.0f / 255.0f ) - 1.0f;
+			pOut[2] = col.getRed() * ( 2.0f / 255.0f ) - 1.0f;
+		}
+		else if ( settings.bSrgb && !settings.bMask )
+		{
+			pOut[0] = srgb.decode[col.getBlue()];
+			pOut[1] = srgb.decode[col.getGreen()];
+			pOut[2] = srgb.decode[col.getRed()];
+		}
+		else
+		{
+			pOut[0] = col.getBlue() * ( 1.0f / 255.0f );
+			pOut[1] = col.getGreen() * ( 1.0f / 255.0f );
+			pOut[2] = col.getRed() * ( 1.0f / 255.0f );
+		}
+		pOut[3] = col.getAlpha() * ( 1.0f / 255.0f );
+	}
+}
+
+/// \brief	one float4 texel per SSE register
+void filterRow( const float *pSrc,
+	const Taps &taps,
+	const unsigned dstWidth,
+	float *pDst ) noexcept
+{
+	const unsigned n = taps.nTaps;
+	const int *pIndices = taps.indices.data();
+	const float *pWeights = taps.weights.data();
+	for ( unsigned x = 0; x < dstWidth; ++x, pIndices += n, pWeights += n, pDst += 4 )
+	{
+		__m128 acc = _mm_setzero_ps();
+		for ( unsigned t = 0; t < n; ++t )
+		{
+			acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( pWeights[t] ), _mm_loadu_ps( pSrc + 4 * static_cast<std::size_t>( pIndices[t] ) ) ) );
+		}
+		_mm_storeu_ps( pDst, acc );
+	}
+}
+
+/// \brief	weighted sum of n rows of nFloats floats, 2 texels at a time
+void filterColumn( const float *const *ppRows,
+	const float *pWeights,
+	const unsigned n,
+	const std::size_t nFloats,
+	float *pDst ) noexcept
+{
+	std::size_t i = 0;
+	for ( ; i + 8 <= nFloats; i += 8 )
+	{
+		__m128 acc0 = _mm_setzero_ps();
+		__m128 acc1 = _mm_setzero_ps();
+		for ( unsigned t = 0; t < n; ++t )
+		{
+			const __m128 w = _mm_set1_ps( pWeights[t] );
+			acc0 = _mm_add_ps( acc0, _mm_mul_ps( w, _mm_loadu_ps( ppRows[t] + i ) ) );
+			acc1 = _mm_add_ps( acc1, _mm_mul_ps( w, _mm_loadu_ps( ppRows[t] + i + 4 ) ) );
+		}
+		_mm_storeu_ps( pDst + i, acc0 );
+		_mm_storeu_ps( pDst + i + 4, acc1 );
+	}
+	for ( ; i < nFloats; i += 4 )
+	{
+		__m128 acc = _mm_setzero_ps();
+		for ( unsigned t = 0; t < n; ++t )
+		{
+			acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( pWeights[t] ), _mm_loadu_ps( ppRows[t] + i ) ) );
+		}
+		_mm_storeu_ps( pDst + i, acc );
+	}
+}
+
+/// \brief	clamps (or renormalizes) the filtered floats in place, so the next level is filtered from valid texels, & encodes them
+void encodeRow( float *pRow,
+	const unsigned width,
+	const Settings &settings,
+	const float alphaScale,
+	ColorBGRA *pOut ) noexcept
+{
+	const auto &srgb = getSrgbTables();
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const auto toByte = [] ( const float v ) -> Byte
+		{
+			return static_cast<Byte>( std::clamp( v, 0.0f, 1.0f ) * 255.0f + 0.5f );
+		};
+	for ( unsigned x = 0; x < width; ++x, pRow += 4 )
+	{
+		if ( settings.bNormalMap )
+		{
+			// b, g, r hold z, y, x
+			const float lengthSq = pRow[0] * pRow[0] + pRow[1] * pRow[1] + pRow[2] * pRow[2];
+			if ( lengthSq > 1e-12f )
+			{
+				const float invLength = 1.0f / std::sqrt( lengthSq );
+				pRow[0] *= invLength;
+				pRow[1] *= invLength;
+				pRow[2] *= invLength;
+			}
+			else
+			{
+				pRow[0] = 1.0f;
+				pRow[1] = 0.0f;
+				pRow[2] = 0.0f;
+			}
+			pRow[3] = std::clamp( pRow[3], 0.0f, 1.0f );
+			pOut[x] = ColorBGRA{toByte( pRow[2] * 0.5f + 0.5f ), toByte( pRow[1] * 0.5f + 0.5f ), toByte( pRow[0] * 0.5f + 0.5f ), toByte( pRow[3] * alphaScale )};
+			continue;
+		}
+
+		_mm_storeu_ps( pRow, _mm_min_ps( _mm_max_ps( _mm_loadu_ps( pRow ), zero ), one ) );
+		const Byte a = toByte( pRow[3] * alphaScale );
+		if ( settings.bSrgb && !settings.bMask )
+		{
+			const auto lutIndex = [] ( const float v ) -> unsigned
+				{
+					return std::min( static_cast<unsigned>( v * s_srgbEncodeLutSize ), s_srgbEncodeLutSize - 1 );
+				};
+			pOut[x] = ColorBGRA{srgb.encode[lutIndex( pRow[2] )], srgb.encode[lutIndex( pRow[1] )], srgb.encode[lutIndex( pRow[0] )], a};
+		}
+		else
+		{
+			pOut[x] = ColorBGRA{toByte( pRow[2] ), toByte( pRow[1] ), toByte( pRow[0] ), a};
+		}
+	}
+}
+
+/// \brief	the fraction of texels that pass the alpha test
+float calcCoverage( const ColorBGRA *pTexels,
+	const std::size_t nTexels,
+	const float alphaCutoff ) noexcept
+{
+	std::size_t nCovered = 0;
+	for ( std::size_t i = 0; i < nTexels; ++i )
+	{
+		nCovered += pTexels[i].getAlpha() * ( 1.0f / 255.0f ) >= alphaCutoff ? 1u : 0u;
+	}
+	return float( double( nCovered ) / nTexels );
+}
+
+/// \brief	the scale that brings the coverage of the level's alpha back to targetCoverage, found on a histogram of the alpha
+float calcAlphaScale( const float *pTexels,
+	const std::size_t nTexels,
+	const float targetCoverage,
+	const float alphaCutoff )
+{
+	std::vector<std::size_t> histogram( s_alphaHistogramSize, 0u );
+	for ( std::size_t i = 0; i < nTexels; ++i )
+	{
+		const float a = std::clamp( pTexels[4 * i + 3], 0.0f, 1.0f );
+		++histogram[std::min( static_cast<unsigned>( a * s_alphaHistogramSize ), s_alphaHistogramSize - 1 )];
+	}
+	// the highest bin the coverage is reached at is the alpha that is scaled to alphaCutoff
+	const double targetCount = double( targetCoverage ) * nTexels;
+	std::size_t count = 0;
+	for ( unsigned bin = s_alphaHistogramSize - 1; bin > 0; --bin )
+	{
+		count += histogram[bin];
+		if ( double( count ) >= targetCount )
+		{
+			return alphaCutoff * s_alphaHistogramSize / bin;
+		}
+	}
+	return alphaCutoff * s_alphaHistogramSize;
+}
+
+
+}//namespace
+
+const std::uint8_t* MipChain::getLevel( const std::size_t i ) const noexcept
+{
+	return data.data() + levels[i].offset;
+}
+
+unsigned calcMipCount( const unsigned width,
+	const unsigned height ) noexcept
+{
+	unsigned nLevels = 1u;
+	for ( unsigned size = std::max( width, height ); size > 1u; size >>= 1u )
+	{
+		++nLevels;
+	}
+	return nLevels;
+}
+
+std::vector<Level> calcLevels( const unsigned width,
+	const unsigned height,
+	const bc::Format format /*= bc::Format::BGRA8*/ )
+{
+	std::vector<Level> levels( calcMipCount( width, height ) );
+	std::size_t offset = 0;
+	for ( unsigned i = 0; i < levels.size(); ++i )
+	{
+		const unsigned levelWidth = std::max( width >> i, 1u );
+		const unsigned levelHeight = std::max( height >> i, 1u );
+		levels[i] = Level{levelWidth, levelHeight, offset, bc::calcRowPitch( levelWidth, format )};
+		offset += bc::calcSize( levelWidth, levelHeight, format );
+	}
+	return levels;
+}
+
+MipChain generate( const ColorBGRA *pTexels,
+	const unsigned width,
+	const unsigned height,
+	const std::size_t pitch,
+	const Settings &settings )
+{
+	ASSERT( !settings.bNormalMap || settings.alphaCutoff == 0.0f, "Normal maps aren't alpha tested!" );
+	ASSERT( !settings.bNormalMap || !settings.bMask, "A texture is either a normal map or a mask!" );
+
+	// the levels are filtered as BGRA8 texels & only block compressed once they're all done
+	const std::vector<Level> levels = calcLevels( width, height );
+	std::vector<ColorBGRA> texels( ( levels.back().offset + bc::calcSize( levels.back().width, levels.back().height, bc::Format::BGRA8 ) ) / sizeof( ColorBGRA ) );
+	const auto getTexels = [&texels] ( const Level &level ) -> ColorBGRA*
+		{
+			return texels.data() + level.offset / sizeof( ColorBGRA );
+		};
+
+	// level 0 is the image itself
+	const Byte *pBytes = reinterpret_cast<const Byte*>( pTexels );
+	for ( unsigned y = 0; y < height; ++y )
+	{
+		std::memcpy( texels.data() + static_cast<std::size_t>( y ) * width, pBytes + static_cast<std::size_t>( y ) * pitch, width * sizeof( ColorBGRA ) );
+	}
+
+	MipChain chain;
+	chain.bAlpha = std::any_of( texels.data(), texels.data() + static_cast<std::size_t>( width ) * height,
+		[] ( const ColorBGRA col )
+		{
+			return col.getAlpha() != 255;
+		} );
+	const float targetCoverage = settings.alphaCutoff > 0.0f ?
+		calcCoverage( texels.data(), static_cast<std::size_t>( width ) * height, settings.alphaCutoff ) :
+		1.0f;
+	const bool bPreserveCoverage = targetCoverage > 0.0f && targetCoverage < 1.0f;
+
+	auto &threadPool = ThreadPoolJ::getInstance();
+	std::vector<float> previous;	// the float texels of the previous level; level 0's are decoded from its bytes as needed
+	std::vector<float> current;
+	for ( std::size_t l = 1; l < levels.size(); ++l )
+	{
+		const Level &src = levels[l - 1];
+		const Level &dst = levels[l];
+		const Taps tapsX = calcTaps( src.width, dst.width, settings.filter, settings.bWrap );
+		const Taps tapsY = calcTaps( src.height, dst.height, settings.filter, settings.bWrap );
+		const std::size_t dstRowFloats = static_cast<std::size_t>( dst.width ) * 4;
+		current.resize( dstRowFloats * dst.height );
+
+		// bands of destination rows: their source rows are filtered horizontally once, into their own slot, then the band is filtered vertically
+		threadPool.parallelFor( 0u, dst.height, s_rowsPerBand,
+			[&] ( const std::size_t first, const std::size_t last )
+			{
+				std::vector<int> slots( src.height, -1 );
+				std::vector<unsigned> rows;
+				for ( std::size_t y = first; y < last; ++y )
+				{
+					for ( unsigned t = 0; t < tapsY.nTaps; ++t )
+					{
+						const int row = tapsY.indices[y * tapsY.nTaps + t];
+						if ( slots[row] < 0 )
+						{
+							slots[row] = static_cast<int>( rows.size() );
+							rows.push_back( static_cast<unsigned>( row ) );
+						}
+					}
+				}
+
+				std::vector<float> filtered( rows.size() * dstRowFloats );
+				std::vector<float> decoded( l == 1 ? static_cast<std::size_t>( src.width ) * 4 : 0u );
+				for ( std::size_t s = 0; s < rows.size(); ++s )
+				{
+					const float *pSrcRow;
+					if ( l == 1 )
+					{
+						decodeRow( texels.data() + static_cast<std::size_t>( rows[s] ) * src.width, src.width, settings, decoded.data() );
+						pSrcRow = decoded.data();
+					}
+					else
+					{
+						pSrcRow = previous.data() + static_cast<std::size_t>( rows[s] ) * src.width * 4;
+					}
+					filterRow( pSrcRow, tapsX, dst.width, filtered.data() + s * dstRowFloats );
+				}
+
+				std::vector<const float*> pRows( tapsY.nTaps );
+				for ( std::size_t y = first; y < last; ++y )
+				{
+					for ( unsigned t = 0; t < tapsY.nTaps; ++t )
+					{
+						pRows[t] = filtered.data() + slots[tapsY.indices[y * tapsY.nTaps + t]] * dstRowFloats;
+					}
+					filterColumn( pRows.data(), tapsY.weights.data() + y * tapsY.nTaps, tapsY.nTaps, dstRowFloats, current.data() + y * dstRowFloats );
+				}
+			} );
+
+		const float alphaScale = bPreserveCoverage ?
+			calcAlphaScale( current.data(), static_cast<std::size_t>( dst.width ) * dst.height, targetCoverage, settings.alphaCutoff ) :
+			1.0f;
+		threadPool.parallelFor( 0u, dst.height, 0u,
+			[&] ( const std::size_t first, const std::size_t last )
+			{
+				for ( std::size_t y = first; y < last; ++y )
+				{
+					encodeRow( current.data() + y * dstRowFloats, dst.width, settings, alphaScale, getTexels( dst ) + y * dst.width );
+				}
+			} );
+		std::swap( previous, current );
+	}
+
+	// D3D only accepts block compressed textures whose level 0 is made of whole blocks
+	chain.format = settings.bCompress && width % 4 == 0 && height % 4 == 0 ?
+		bc::chooseFormat( settings.bNormalMap ? bc::Usage::NormalMap : settings.bMask ? bc::Usage::Mask : bc::Usage::Color, chain.bAlpha, settings.quality ) :
+		bc::Format::BGRA8;
+	chain.levels = calcLevels( width, height, chain.format );
+	chain.data.resize( chain.levels.back().offset + bc::calcSize( chain.levels.back().width, chain.levels.back().height, chain.format ) );
+	for ( std::size_t l = 0; l < levels.size(); ++l )
+	{
+		bc::encode( getTexels( levels[l] ), levels[l].width, levels[l].height, chain.format, settings.quality, chain.data.data() + chain.levels[l].offset );
+	}
+	return chain;
+}
+
+std::string calcCookedPath( const std::string &sourcePath,
+	const Settings &settings )
+{
+	const std::uint64_t settingsHash = calcSettingsHash( settings );
+	static constexpr const char *s_hexDigits = "0123456789abcdef";
+	std::string hex( 16, '0' );
+	for ( int i = 0; i < 16; ++i )
+	{
+		hex[15 - i] = s_hexDigits[( settingsHash >> ( i * 4 ) ) & 0xF];
+	}
+	return sourcePath + "." + hex + ".kmip";
+}
+
+bool readCooked( const std::string &cookedPath,
+	const std::uint64_t sourceHash,
+	const Settings &settings,
+	MipChain &chain ) noexcept
+{
+	try
+	{
+		HANDLE hFile = CreateFileW( util::s2ws( cookedPath ).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+		if ( hFile == INVALID_HANDLE_VALUE )
+		{
+			return false;
+		}
+		FileHeader header{};
+		LARGE_INTEGER size{};
+		DWORD nRead = 0;
+		bool bValid = ReadFile( hFile, &header, sizeof( header ), &nRead, nullptr ) && nRead == sizeof( header )
+			&& GetFileSizeEx( hFile, &size ) && header.fileSize == static_cast<std::uint64_t>( size.QuadPart )
+			&& header.magic == s_magic && header.version == s_version && header.sourceHash == sourceHash && header.settingsHash == calcSettingsHash( settings )
+			&& header.width > 0 && header.height > 0 && header.format <= static_cast<std::uint32_t>( bc::Format::BC7 );
+		if ( bValid )
+		{
+			chain.format = static_cast<bc::Format>( header.format );
+			chain.bAlpha = ( header.flags & 1u ) != 0;
+			chain.levels = calcLevels( header.width, header.height, chain.format );
+			const Level &smallest = chain.levels.back();
+			const std::uint64_t nBytes = smallest.offset + bc::calcSize( smallest.width, smallest.height, chain.format );
+			bValid = header.fileSize == sizeof( header ) + nBytes && nBytes <= MAXDWORD;
+			if ( bValid )
+			{
+				chain.data.resize( static_cast<std::size_t>( nBytes ) );
+				bValid = ReadFile( hFile, chain.data.data(), static_cast<DWORD>( nBytes ), &nRead, nullptr ) && nRead == nBytes;
+			}
+		}
+		CloseHandle( hFile );
+		if ( !bValid )
+		{
+			chain = MipChain{};
+		}
+		return bValid;
+	}
+	catch ( ... )
+	{
+		chain = MipChain{};
+		return false;
+	}
+}
+
+bool writeCooked( const std::string &cookedPath,
+	const std::uint64_t sourceHash,
+	const Settings &settings,
+	const MipChain &chain ) noexcept
+{
+	try
+	{
+		const std::uint64_t nBytes = chain.data.size();
+		if ( chain.levels.empty() || nBytes > MAXDWORD )
+		{
+			return false;
+		}
+		FileHeader header{};
+		header.magic = s_magic;
+		header.version = s_version;
+		header.sourceHash = sourceHash;
+		header.settingsHash = calcSettingsHash( settings );
+		header.width = chain.levels[0].width;
+		header.height = chain.levels[0].height;
+		header.format = static_cast<std::uint32_t>( chain.format );
+		header.flags = chain.bAlpha ?
+			1u :
+			0u;
+		header.fileSize = sizeof( header ) + nBytes;
+
+		const std::wstring tempPath = util::s2ws( cookedPath + ".tmp" );
+		HANDLE hFile = CreateFileW( tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if ( hFile == INVALID_HANDLE_VALUE )
+		{
+			return false;
+		}
+		DWORD nHeaderWritten = 0;
+		DWORD nDataWritten = 0;
+		const BOOL bWritten = WriteFile( hFile, &header, sizeof( header ), &nHeaderWritten, nullptr )
+			&& WriteFile( hFile, chain.data.data(), static_cast<DWORD>( nBytes ), &nDataWritten, nullptr );
+		CloseHandle( hFile );
+		if ( !bWritten || nHeaderWritten != sizeof( header ) || nDataWritten != nBytes || !MoveFileExW( tempPath.c_str(), util::s2ws( cookedPath ).c_str(), MOVEFILE_REPLACE_EXISTING ) )
+		{
+			DeleteFileW( tempPath.c_str() );
+			return false;
+		}
+		return true;
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+}
+
+
+}//namespace mip_gen
\ No newline at end of file
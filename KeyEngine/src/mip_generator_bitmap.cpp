@@ -0,0 +1,41 @@
+#include "mip_generator.h"
+#include "bitmap.h"
+#include "model_cache.h"
+#include "console.h"
+
+
+// mip_gen's Bitmap entry points; mip_generator.cpp itself only deals in texels so it builds without DirectXTex
+
+namespace mip_gen
+{
+
+MipChain generate( const Bitmap &bitmap,
+	const Settings &settings )
+{
+	return generate( bitmap.getData(), bitmap.getWidth(), bitmap.getHeight(), bitmap.getPitch(), settings );
+}
+
+MipChain loadOrCook( const std::string &path,
+	const Settings &settings )
+{
+	const std::uint64_t sourceHash = model_cache::hashFile( path );
+	const std::string cookedPath = calcCookedPath( path, settings );
+	MipChain chain;
+	if ( readCooked( cookedPath, sourceHash, settings, chain ) )
+	{
+		return chain;
+	}
+
+	chain = generate( Bitmap::loadFromFile( path ), settings );
+	// a failed write is not an error, the mips are simply generated again next time
+	const bool bCooked = writeCooked( cookedPath, sourceHash, settings, chain );
+#if defined _DEBUG && !defined NDEBUG
+	KeyConsole::getInstance().log( ( bCooked ? "Cooked mips " : "Failed to cook mips " ) + cookedPath + "\n", KeyConsole::LogCategory::Graphics );
+#else
+	(void)bCooked;
+#endif
+	return chain;
+}
+
+
+}//namespace mip_gen
\ No newline at end of file
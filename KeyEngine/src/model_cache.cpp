@@ -0,0 +1,650 @@
+#include "model_cache.h"
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include "utils.h"
+#include "util_exception.h"
+#include "assertions_console.h"
+
+
+namespace model_cache
+{
+
+namespace
+{
+
+constexpr std::uint32_t s_magic = 0x4C444D4Bu;	// "KMDL"
+constexpr std::size_t s_blobAlignment = 16u;
+
+// on disk layout, little endian; every offset is from the start of the file, string offsets from the start of the string table
+struct StringRef final
+{
+	std::uint32_t offset;
+	std::uint32_t length;
+};
+
+struct FileHeader final
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t checksum;				// of the whole file, this field taken as 0
+	std::uint64_t sourceHash;
+	std::uint64_t dependenciesHash;		// hashFiles of the dependencies
+	std::uint32_t importerFlags;
+	float scale;
+	std::uint32_t nMaterials;
+	std::uint32_t nMeshes;
+	std::uint32_t nNodes;
+	std::uint32_t nMeshRefs;
+	std::uint32_t nDependencies;
+	std::uint32_t padding;
+	std::uint64_t materialsOffset;
+	std::uint64_t meshesOffset;
+	std::uint64_t nodesOffset;
+	std::uint64_t meshRefsOffset;
+	std::uint64_t dependenciesOffset;	// a StringRef per dependency path
+	std::uint64_t stringsOffset;
+	std::uint64_t stringsSize;
+	std::uint64_t fileSize;
+};
+
+struct MaterialRecord final
+{
+	StringRef name;
+	StringRef diffuseTexture;
+	StringRef specularTexture;
+	StringRef normalTexture;
+	DirectX::XMFLOAT4 diffuseColor;
+	DirectX::XMFLOAT3 specularColor;
+	float specularGloss;
+};
+
+struct MeshRecord final
+{
+	StringRef name;
+	StringRef layoutSignature;
+	std::uint32_t materialIndex;
+	std::uint32_t nVertices;
+	std::uint32_t vertexStride;
+	std::uint32_t nIndices;
+	std::uint32_t indexSize;
+	std::uint32_t nLods;
+	std::uint64_t verticesOffset;
+	std::uint64_t indicesOffset;
+	std::uint64_t lodsOffset;
+	DirectX::XMFLOAT3 aabbMin;
+	DirectX::XMFLOAT3 aabbMax;
+};
+
+struct NodeRecord final
+{
+	StringRef name;
+	DirectX::XMFLOAT4X4 transform;
+	std::uint32_t firstMeshRef;
+	std::uint32_t nMeshes;
+	std::uint32_t nChildren;
+	std::uint32_t padding;
+};
+
+static_assert( std::is_trivially_copyable_v<FileHeader> && std::is_trivially_copyable_v<MaterialRecord> && std::is_trivially_copyable_v<MeshRecord> && std::is_trivially_copyable_v<NodeRecord> && std::is_trivially_copyable_v<mesh_opt::Lod>, "Cooked records are copied as raw bytes!" );
+
+template<typename T>
+T readRecord( const std::uint8_t *pData,
+	const std::uint64_t offset ) noexcept
+{
+	T record;
+	std::memcpy( &record, pData + offset, sizeof( T ) );
+	return record;
+}
+
+bool isInside( const std::uint64_t offset,
+	const std::uint64_t size,
+	const std::uint64_t nBytes ) noexcept
+{
+	return offset <= nBytes && size <= nBytes - offset;
+}
+
+std::uint64_t mix( std::uint64_t h ) noexcept
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+/// \brief	8 bytes at a time, not cryptographic - it only has to notice an edited source
+std::uint64_t hashBytes( const std::uint8_t *pData,
+	const std::size_t nBytes,
+	std::uint64_t seed ) noexcept
+{
+	std::uint64_t h = seed ^ ( nBytes * 0x9E3779B97F4A7C15ull );
+	std::size_t i = 0;
+	for ( ; i + 8 <= nBytes; i += 8 )
+	{
+		std::uint64_t word;
+		std::memcpy( &word, pData + i, 8 );
+		h = ( h ^ mix( word ) ) * 0x9E3779B97F4A7C15ull;
+	}
+	std::uint64_t tail = 0;
+	std::memcpy( &tail, pData + i, nBytes - i );
+	return mix( h ^ mix( tail ) );
+}
+
+/// \brief	catches any corruption the structural checks can't, eg. in the blobs; a change to a single 8 byte word always changes the hash
+std::uint64_t calcChecksum( const std::uint8_t *pData,
+	const std::size_t nBytes ) noexcept
+{
+	auto header = readRecord<FileHeader>( pData, 0u );
+	header.checksum = 0u;
+	const std::uint64_t headerHash = hashBytes( reinterpret_cast<const std::uint8_t*>( &header ), sizeof( header ), s_magic );
+	return hashBytes( pData + sizeof( FileHeader ), nBytes - sizeof( FileHeader ), headerHash );
+}
+
+std::size_t alignUp( const std::size_t offset ) noexcept
+{
+	return ( offset + s_blobAlignment - 1 ) & ~( s_blobAlignment - 1 );
+}
+
+
+}//namespace
+
+std::uint64_t hashFile( const std::string &filename )
+{
+	HANDLE hFile = CreateFileW( util::s2ws( filename ).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		THROW_UTIL_EXCEPTION( "Failed to open \"" + filename + "\"!" );
+	}
+	LARGE_INTEGER size{};
+	if ( !GetFileSizeEx( hFile, &size ) )
+	{
+		CloseHandle( hFile );
+		THROW_UTIL_EXCEPTION( "Failed to read \"" + filename + "\"!" );
+	}
+	if ( size.QuadPart == 0 )
+	{
+		// empty files can't be mapped
+		CloseHandle( hFile );
+		return hashBytes( nullptr, 0u, s_version );
+	}
+
+	HANDLE hMapping = CreateFileMappingW( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	const auto *pData = hMapping != nullptr ?
+		static_cast<const std::uint8_t*>( MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 ) ) :
+		nullptr;
+	if ( pData == nullptr )
+	{
+		if ( hMapping != nullptr )
+		{
+			CloseHandle( hMapping );
+		}
+		CloseHandle( hFile );
+		THROW_UTIL_EXCEPTION( "Failed to map \"" + filename + "\"!" );
+	}
+
+	const std::uint64_t hash = hashBytes( pData, static_cast<std::size_t>( size.QuadPart ), s_version );
+	UnmapViewOfFile( pData );
+	CloseHandle( hMapping );
+	CloseHandle( hFile );
+	return hash;
+}
+
+std::uint64_t hashFiles( const std::vector<std::string> &filenames ) noexcept
+{
+	std::uint64_t h = mix( filenames.size() ^ mix( s_version ) );
+	for ( const std::string &filename : filenames )
+	{
+		std::uint64_t fileHash;
+		try
+		{
+			fileHash = hashFile( filename );
+		}
+		catch ( ... )
+		{
+			// a missing dependency may be back later, with the contents it was cooked with or not
+			fileHash = mix( s_magic );
+		}
+		h = ( h ^ fileHash ) * 0x9E3779B97F4A7C15ull;
+	}
+	return mix( h );
+}
+
+std::string calcCookedPath( const std::string &sourcePath,
+	const unsigned importerFlags,
+	const float scale )
+{
+	std::uint32_t scaleBits;
+	std::memcpy( &scaleBits, &scale, sizeof( scale ) );
+	const std::uint64_t optionsHash = mix( ( static_cast<std::uint64_t>( importerFlags ) << 32 | scaleBits ) ^ mix( s_version ) );
+
+	static constexpr const char *s_hexDigits = "0123456789abcdef";
+	std::string hex( 16, '0' );
+	for ( int i = 0; i < 16; ++i )
+	{
+		hex[15 - i] = s_hexDigits[( optionsHash >> ( i * 4 ) ) & 0xF];
+	}
+	return sourcePath + "." + hex + ".kcm";
+}
+
+std::unique_ptr<CookedModel> CookedModel::open( const std::string &cookedPath,
+	const std::uint64_t sourceHash,
+	const unsigned importerFlags,
+	const float scale ) noexcept
+{
+	auto pCooked = std::make_unique<CookedModel>();
+	if ( !pCooked->map( cookedPath ) || !pCooked->validate( sourceHash, importerFlags, scale ) )
+	{
+		return nullptr;
+	}
+
+	const auto header = readRecord<FileHeader>( pCooked->m_pData, 0u );
+	const auto *pStrings = reinterpret_cast<const char*>( pCooked->m_pData + header.stringsOffset );
+	std::vector<std::string> dependencies;
+	try
+	{
+		dependencies.reserve( header.nDependencies );
+		for ( unsigned i = 0; i < header.nDependencies; ++i )
+		{
+			const auto ref = readRecord<StringRef>( pCooked->m_pData, header.dependenciesOffset + i * sizeof( StringRef ) );
+			dependencies.emplace_back( pStrings + ref.offset, ref.length );
+		}
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+	if ( hashFiles( dependencies ) != header.dependenciesHash )
+	{
+		return nullptr;
+	}
+
+	pCooked->m_nMaterials = header.nMaterials;
+	pCooked->m_nMeshes = header.nMeshes;
+	pCooked->m_nNodes = header.nNodes;
+	return pCooked;
+}
+
+CookedModel::~CookedModel() noexcept
+{
+	close();
+}
+
+unsigned CookedModel::getMaterialCount() const noexcept
+{
+	return m_nMaterials;
+}
+
+unsigned CookedModel::getMeshCount() const noexcept
+{
+	return m_nMeshes;
+}
+
+unsigned CookedModel::getNodeCount() const noexcept
+{
+	return m_nNodes;
+}
+
+MaterialLoader::Desc CookedModel::getMaterial( const unsigned i ) const
+{
+	ASSERT( i < m_nMaterials, "Material index out of range!" );
+	const auto header = readRecord<FileHeader>( m_pData, 0u );
+	const auto record = readRecord<MaterialRecord>( m_pData, header.materialsOffset + i * sizeof( MaterialRecord ) );
+	const auto *pStrings = reinterpret_cast<const char*>( m_pData + header.stringsOffset );
+	const auto toString = [pStrings] ( const StringRef &ref ) -> std::string
+		{
+			return {pStrings + ref.offset, ref.length};
+		};
+
+	MaterialLoader::Desc desc;
+	desc.name = toString( record.name );
+	desc.diffuseTexture = toString( record.diffuseTexture );
+	desc.specularTexture = toString( record.specularTexture );
+	desc.normalTexture = toString( record.normalTexture );
+	desc.diffuseColor = record.diffuseColor;
+	desc.specularColor = record.specularColor;
+	desc.specularGloss = record.specularGloss;
+	return desc;
+}
+
+MeshData CookedModel::getMesh( const unsigned i ) const noexcept
+{
+	ASSERT( i < m_nMeshes, "Mesh index out of range!" );
+	const auto header = readRecord<FileHeader>( m_pData, 0u );
+	const auto record = readRecord<MeshRecord>( m_pData, header.meshesOffset + i * sizeof( MeshRecord ) );
+	const auto *pStrings = reinterpret_cast<const char*>( m_pData + header.stringsOffset );
+	return MeshData{{pStrings + record.name.offset, record.name.length},
+		record.materialIndex,
+		{pStrings + record.layoutSignature.offset, record.layoutSignature.length},
+		m_pData + record.verticesOffset,
+		record.nVertices,
+		record.vertexStride,
+		m_pData + record.indicesOffset,
+		record.nIndices,
+		record.indexSize,
+		record.aabbMin,
+		record.aabbMax,
+		reinterpret_cast<const mesh_opt::Lod*>( m_pData + record.lodsOffset ),
+		record.nLods};
+}
+
+NodeData CookedModel::getNode( const unsigned i ) const noexcept
+{
+	ASSERT( i < m_nNodes, "Node index out of range!" );
+	const auto header = readRecord<FileHeader>( m_pData, 0u );
+	const auto record = readRecord<NodeRecord>( m_pData, header.nodesOffset + i * sizeof( NodeRecord ) );
+	const auto *pStrings = reinterpret_cast<const char*>( m_pData + header.stringsOffset );
+	return NodeData{{pStrings + record.name.offset, record.name.length},
+		record.transform,
+		reinterpret_cast<const std::uint32_t*>( m_pData + header.meshRefsOffset ) + record.firstMeshRef,
+		record.nMeshes,
+		record.nChildren};
+}
+
+bool CookedModel::map( const std::string &cookedPath ) noexcept
+{
+	m_hFile = CreateFileW( util::s2ws( cookedPath ).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( m_hFile == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	LARGE_INTEGER size{};
+	if ( !GetFileSizeEx( m_hFile, &size ) || size.QuadPart < static_cast<LONGLONG>( sizeof( FileHeader ) ) )
+	{
+		return false;
+	}
+	m_nBytes = static_cast<std::size_t>( size.QuadPart );
+
+	m_hMapping = CreateFileMappingW( m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( m_hMapping == nullptr )
+	{
+		return false;
+	}
+	m_pData = static_cast<const std::uint8_t*>( MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 ) );
+	return m_pData != nullptr;
+}
+
+bool CookedModel::validate( const std::uint64_t sourceHash,
+	const unsigned importerFlags,
+	const float scale ) const noexcept
+{
+	const auto header = readRecord<FileHeader>( m_pData, 0u );
+	if ( header.magic != s_magic || header.version != s_version || header.sourceHash != sourceHash || header.importerFlags != importerFlags || header.scale != scale || header.fileSize != m_nBytes )
+	{
+		return false;
+	}
+	if ( calcChecksum( m_pData, m_nBytes ) != header.checksum )
+	{
+		return false;
+	}
+	if ( !isInside( header.materialsOffset, static_cast<std::uint64_t>( header.nMaterials ) * sizeof( MaterialRecord ), m_nBytes )
+		|| !isInside( header.meshesOffset, static_cast<std::uint64_t>( header.nMeshes ) * sizeof( MeshRecord ), m_nBytes )
+		|| !isInside( header.nodesOffset, static_cast<std::uint64_t>( header.nNodes ) * sizeof( NodeRecord ), m_nBytes )
+		|| !isInside( header.meshRefsOffset, static_cast<std::uint64_t>( header.nMeshRefs ) * sizeof( std::uint32_t ), m_nBytes )
+		|| !isInside( header.dependenciesOffset, static_cast<std::uint64_t>( header.nDependencies ) * sizeof( StringRef ), m_nBytes )
+		|| !isInside( header.stringsOffset, header.stringsSize, m_nBytes )
+		|| header.meshRefsOffset % alignof( std::uint32_t ) != 0
+		|| header.nNodes == 0 )
+	{
+		return false;
+	}
+
+	const auto isString = [&header] ( const StringRef &ref ) -> bool
+		{
+			return isInside( ref.offset, ref.length, header.stringsSize );
+		};
+	for ( unsigned i = 0; i < header.nDependencies; ++i )
+	{
+		if ( !isString( readRecord<StringRef>( m_pData, header.dependenciesOffset + i * sizeof( StringRef ) ) ) )
+		{
+			return false;
+		}
+	}
+	for ( unsigned i = 0; i < header.nMaterials; ++i )
+	{
+		const auto record = readRecord<MaterialRecord>( m_pData, header.materialsOffset + i * sizeof( MaterialRecord ) );
+		if ( !isString( record.name ) || !isString( record.diffuseTexture ) || !isString( record.specularTexture ) || !isString( record.normalTexture ) )
+		{
+			return false;
+		}
+	}
+	for ( unsigned i = 0; i < header.nMeshes; ++i )
+	{
+		const auto record = readRecord<MeshRecord>( m_pData, header.meshesOffset + i * sizeof( MeshRecord ) );
+		if ( !isString( record.name ) || !isString( record.layoutSignature ) || record.materialIndex >= header.nMaterials
+			|| ( record.indexSize != sizeof( std::uint16_t ) && record.indexSize != sizeof( std::uint32_t ) )
+			|| !isInside( record.verticesOffset, static_cast<std::uint64_t>( record.nVertices ) * record.vertexStride, m_nBytes )
+			|| !isInside( record.indicesOffset, static_cast<std::uint64_t>( record.nIndices ) * record.indexSize, m_nBytes )
+			|| !isInside( record.lodsOffset, static_cast<std::uint64_t>( record.nLods ) * sizeof( mesh_opt::Lod ), m_nBytes )
+			|| record.lodsOffset % alignof( mesh_opt::Lod ) != 0 )
+		{
+			return false;
+		}
+		for ( unsigned i = 0; i < record.nLods; ++i )
+		{
+			const auto lod = readRecord<mesh_opt::Lod>( m_pData, record.lodsOffset + i * sizeof( mesh_opt::Lod ) );
+			if ( !isInside( lod.startIndex, lod.nIndices, record.nIndices ) || lod.nIndices % 3 != 0 || !( lod.error >= 0.0f && lod.error <= 1.0f ) )
+			{
+				return false;
+			}
+		}
+	}
+	// the depth first node tree must be complete: every node's children have to be there
+	std::uint64_t nPendingNodes = 1;
+	for ( unsigned i = 0; i < header.nNodes; ++i )
+	{
+		const auto record = readRecord<NodeRecord>( m_pData, header.nodesOffset + i * sizeof( NodeRecord ) );
+		if ( !isString( record.name ) || !isInside( record.firstMeshRef, record.nMeshes, header.nMeshRefs ) || nPendingNodes == 0 )
+		{
+			return false;
+		}
+		nPendingNodes += record.nChildren;
+		--nPendingNodes;
+	}
+	if ( nPendingNodes != 0 )
+	{
+		return false;
+	}
+	const auto *pMeshRefs = reinterpret_cast<const std::uint32_t*>( m_pData + header.meshRefsOffset );
+	return std::all_of( pMeshRefs, pMeshRefs + header.nMeshRefs,
+		[&header] ( const std::uint32_t meshRef )
+		{
+			return meshRef < header.nMeshes;
+		} );
+}
+
+void CookedModel::close() noexcept
+{
+	if ( m_pData != nullptr )
+	{
+		UnmapViewOfFile( m_pData );
+		m_pData = nullptr;
+	}
+	if ( m_hMapping != nullptr )
+	{
+		CloseHandle( m_hMapping );
+		m_hMapping = nullptr;
+	}
+	if ( m_hFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( m_hFile );
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+void CookedModelWriter::addMaterial( const MaterialLoader::Desc &desc )
+{
+	m_materials.push_back( desc );
+}
+
+void CookedModelWriter::addMesh( const MeshData &mesh )
+{
+	const auto *pVertices = static_cast<const std::uint8_t*>( mesh.pVertices );
+	const auto *pIndices = static_cast<const std::uint8_t*>( mesh.pIndices );
+	m_meshes.push_back( PendingMesh{std::string{mesh.name},
+		std::string{mesh.layoutSignature},
+		mesh.materialIndex,
+		mesh.nVertices,
+		mesh.vertexStride,
+		mesh.nIndices,
+		mesh.indexSize,
+		{pVertices, pVertices + static_cast<std::size_t>( mesh.nVertices ) * mesh.vertexStride},
+		{pIndices, pIndices + static_cast<std::size_t>( mesh.nIndices ) * mesh.indexSize},
+		mesh.aabbMin,
+		mesh.aabbMax,
+		{mesh.pLods, mesh.pLods + mesh.nLods}} );
+}
+
+void CookedModelWriter::addNode( const std::string_view name,
+	const DirectX::XMFLOAT4X4 &transform,
+	const unsigned *pMeshes,
+	const unsigned nMeshes,
+	const unsigned nChildren )
+{
+	m_nodes.push_back( PendingNode{std::string{name}, transform, {pMeshes, pMeshes + nMeshes}, nChildren} );
+}
+
+void CookedModelWriter::addDependency( const std::string &path )
+{
+	if ( std::find( m_dependencies.begin(), m_dependencies.end(), path ) == m_dependencies.end() )
+	{
+		m_dependencies.push_back( path );
+	}
+}
+
+bool CookedModelWriter::write( const std::string &cookedPath,
+	const std::uint64_t sourceHash,
+	const unsigned importerFlags,
+	const float scale ) const noexcept
+{
+	try
+	{
+		std::string strings;
+		const auto addString = [&strings] ( const std::string_view str ) -> StringRef
+			{
+				const StringRef ref{static_cast<std::uint32_t>( strings.size() ), static_cast<std::uint32_t>( str.size() )};
+				strings += str;
+				return ref;
+			};
+
+		FileHeader header{};
+		header.magic = s_magic;
+		header.version = s_version;
+		header.sourceHash = sourceHash;
+		header.dependenciesHash = hashFiles( m_dependencies );
+		header.importerFlags = importerFlags;
+		header.scale = scale;
+		header.nMaterials = static_cast<std::uint32_t>( m_materials.size() );
+		header.nMeshes = static_cast<std::uint32_t>( m_meshes.size() );
+		header.nNodes = static_cast<std::uint32_t>( m_nodes.size() );
+
+		std::vector<MaterialRecord> materials;
+		materials.reserve( m_materials.size() );
+		for ( const auto &desc : m_materials )
+		{
+			materials.push_back( MaterialRecord{addString( desc.name ), addString( desc.diffuseTexture ), addString( desc.specularTexture ), addString( desc.normalTexture ), desc.diffuseColor, desc.specularColor, desc.specularGloss} );
+		}
+
+		std::vector<NodeRecord> nodes;
+		std::vector<std::uint32_t> meshRefs;
+		nodes.reserve( m_nodes.size() );
+		for ( const auto &node : m_nodes )
+		{
+			nodes.push_back( NodeRecord{addString( node.name ), node.transform, static_cast<std::uint32_t>( meshRefs.size() ), static_cast<std::uint32_t>( node.meshes.size() ), node.nChildren, 0u} );
+			meshRefs.insert( meshRefs.end(), node.meshes.begin(), node.meshes.end() );
+		}
+		header.nMeshRefs = static_cast<std::uint32_t>( meshRefs.size() );
+
+		std::vector<StringRef> dependencies;
+		dependencies.reserve( m_dependencies.size() );
+		for ( const auto &path : m_dependencies )
+		{
+			dependencies.push_back( addString( path ) );
+		}
+		header.nDependencies = static_cast<std::uint32_t>( dependencies.size() );
+
+		// records first, then the strings & finally the blobs, each blob aligned for SIMD friendly reads
+		std::size_t offset = sizeof( FileHeader );
+		header.materialsOffset = offset;
+		offset += materials.size() * sizeof( MaterialRecord );
+		header.meshesOffset = offset;
+		offset += m_meshes.size() * sizeof( MeshRecord );
+		header.nodesOffset = offset;
+		offset += nodes.size() * sizeof( NodeRecord );
+		header.meshRefsOffset = offset;
+		offset += meshRefs.size() * sizeof( std::uint32_t );
+		header.dependenciesOffset = offset;
+		offset += dependencies.size() * sizeof( StringRef );
+
+		std::vector<MeshRecord> meshes;
+		meshes.reserve( m_meshes.size() );
+		for ( const auto &mesh : m_meshes )
+		{
+			meshes.push_back( MeshRecord{addString( mesh.name ), addString( mesh.layoutSignature ), mesh.materialIndex, mesh.nVertices, mesh.vertexStride, mesh.nIndices, mesh.indexSize, static_cast<std::uint32_t>( mesh.lods.size() ), 0u, 0u, 0u, mesh.aabbMin, mesh.aabbMax} );
+		}
+		header.stringsOffset = offset;
+		header.stringsSize = strings.size();
+		offset += strings.size();
+		for ( std::size_t i = 0; i < meshes.size(); ++i )
+		{
+			offset = alignUp( offset );
+			meshes[i].verticesOffset = offset;
+			offset += m_meshes[i].vertices.size();
+			offset = alignUp( offset );
+			meshes[i].indicesOffset = offset;
+			offset += m_meshes[i].indices.size();
+			offset = alignUp( offset );
+			meshes[i].lodsOffset = offset;
+			offset += m_meshes[i].lods.size() * sizeof( mesh_opt::Lod );
+		}
+		header.fileSize = offset;
+
+		std::vector<std::uint8_t> file( offset, 0u );
+		const auto put = [&file] ( const std::uint64_t at, const void *pSrc, const std::size_t nBytes ) -> void
+			{
+				if ( nBytes != 0 )
+				{
+					std::memcpy( file.data() + at, pSrc, nBytes );
+				}
+			};
+		put( 0u, &header, sizeof( header ) );
+		put( header.materialsOffset, materials.data(), materials.size() * sizeof( MaterialRecord ) );
+		put( header.meshesOffset, meshes.data(), meshes.size() * sizeof( MeshRecord ) );
+		put( header.nodesOffset, nodes.data(), nodes.size() * sizeof( NodeRecord ) );
+		put( header.meshRefsOffset, meshRefs.data(), meshRefs.size() * sizeof( std::uint32_t ) );
+		put( header.dependenciesOffset, dependencies.data(), dependencies.size() * sizeof( StringRef ) );
+		put( header.stringsOffset, strings.data(), strings.size() );
+		for ( std::size_t i = 0; i < meshes.size(); ++i )
+		{
+			put( meshes[i].verticesOffset, m_meshes[i].vertices.data(), m_meshes[i].vertices.size() );
+			put( meshes[i].indicesOffset, m_meshes[i].indices.data(), m_meshes[i].indices.size() );
+			put( meshes[i].lodsOffset, m_meshes[i].lods.data(), m_meshes[i].lods.size() * sizeof( mesh_opt::Lod ) );
+		}
+		header.checksum = calcChecksum( file.data(), file.size() );
+		put( 0u, &header, sizeof( header ) );
+
+		const std::wstring tempPath = util::s2ws( cookedPath + ".tmp" );
+		HANDLE hFile = CreateFileW( tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if ( hFile == INVALID_HANDLE_VALUE )
+		{
+			return false;
+		}
+		DWORD nWritten = 0;
+		const BOOL bWritten = WriteFile( hFile, file.data(), static_cast<DWORD>( file.size() ), &nWritten, nullptr );
+		CloseHandle( hFile );
+		if ( !bWritten || nWritten != file.size() || !MoveFileExW( tempPath.c_str(), util::s2ws( cookedPath ).c_str(), MOVEFILE_REPLACE_EXISTING ) )
+		{
+			DeleteFileW( tempPath.c_str() );
+			return false;
+		}
+		return true;
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+}
+
+
+}//namespace model_cache
\ No newline at end of file
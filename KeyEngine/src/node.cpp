@@ -1,5 +1,6 @@
 #include "node.h"
 #include "mesh.h"
+#include "transform_hierarchy.h"
 #include "d3d_utils.h"
 #include "assertions_console.h"
 
@@ -17,12 +18,13 @@ Node::Node( Node *pParent,
 	m_name{name},
 	m_pParent{pParent}
 {
-	dx::XMStoreFloat4x4( &m_localTransform, localTransform );
-	dx::XMStoreFloat4x4( &m_worldTransform, dx::XMMatrixIdentity() );
+	dx::XMFLOAT4X4 localTransform4x4;
+	dx::XMStoreFloat4x4( &localTransform4x4, localTransform );
 
 	//using namespace util;
 
-	const auto &[scale, rot, pos] = util::decomposeAffineMatrix( m_localTransform );
+	// the local matrix is rebuilt from these once the Node is part of a TransformHierarchy
+	const auto &[scale, rot, pos] = util::decomposeAffineMatrix( localTransform4x4 );
 
 	m_scalePrev = m_scale = scale;
 	m_rotPrev = m_rot = rot;
@@ -42,7 +44,6 @@ Node::~Node() noexcept
 
 Node::Node( Node &&rhs ) noexcept
 	:
-	m_bTransformNeedsUpdate{rhs.m_bTransformNeedsUpdate},
 	m_imguiId{rhs.m_imguiId},
 	m_name{std::move( rhs.m_name )},
 	m_scale{rhs.m_scale},
@@ -51,8 +52,8 @@ Node::Node( Node &&rhs ) noexcept
 	m_scalePrev{rhs.m_scalePrev},
 	m_rotPrev{rhs.m_rotPrev},
 	m_posPrev{rhs.m_posPrev},
-	m_localTransform{rhs.m_localTransform},
-	m_worldTransform{rhs.m_worldTransform},
+	m_pTransformHierarchy{rhs.m_pTransformHierarchy},
+	m_hierarchyIndex{rhs.m_hierarchyIndex},
 	m_pParent{rhs.m_pParent},
 	m_children{std::move( rhs.m_children )},
 	m_meshes{std::move( rhs.m_meshes )}
@@ -74,7 +75,6 @@ Node& Node::operator=( Node &&rhs ) noexcept
 void swap( Node &lhs,
 	Node &rhs )
 {
-	lhs.m_bTransformNeedsUpdate = rhs.m_bTransformNeedsUpdate;
 	lhs.m_imguiId = rhs.m_imguiId;
 	std::swap(lhs.m_name, rhs. m_name );
 	lhs.m_scale = rhs.m_scale;
@@ -83,57 +83,31 @@ void swap( Node &lhs,
 	lhs.m_scalePrev = rhs.m_scalePrev;
 	lhs.m_rotPrev = rhs.m_rotPrev;
 	lhs.m_posPrev = rhs.m_posPrev;
-	lhs.m_localTransform = rhs.m_localTransform;
-	lhs.m_worldTransform = rhs.m_worldTransform;
+	std::swap( lhs.m_pTransformHierarchy, rhs.m_pTransformHierarchy );
+	std::swap( lhs.m_hierarchyIndex, rhs.m_hierarchyIndex );
 	std::swap( lhs.m_pParent, rhs.m_pParent );
 	std::swap(lhs.m_children, rhs. m_children );
 	std::swap( lhs.m_meshes, rhs.m_meshes );
 }
 
-void Node::update( const float dt,
-	const dx::XMMATRIX &parentWorldTransform,
-	const float lerpBetweenFrames,
-	const bool bEnableSmoothMovement /*= false*/ ) cond_noex
-{
-	static dx::XMMATRIX worldTransform;
-	if ( m_bTransformNeedsUpdate )
-	{
-		updateLocalTransform( dt, lerpBetweenFrames, bEnableSmoothMovement );
-
-		worldTransform = dx::XMLoadFloat4x4( &m_localTransform ) * parentWorldTransform;
-
-		setWorldTransform( worldTransform );
-		for ( const auto pMesh : m_meshes )
-		{
-			pMesh->update( dt, lerpBetweenFrames );
-		}
-	}
-
-	for ( const auto &pNode : m_children )
-	{
-		pNode->update( dt, worldTransform, lerpBetweenFrames, bEnableSmoothMovement );
-	}
-}
-
 void Node::addChild( std::unique_ptr<Node> pChild ) cond_noex
 {
 	ASSERT( pChild, "Invalid Node!" );
 	m_children.emplace_back( std::move( pChild ) );
 }
 
-void Node::invalidateChildrenTransform() noexcept
+void Node::invalidateTransform() noexcept
 {
-	m_bTransformNeedsUpdate = true;
-	for ( auto &pNode : m_children )
+	if ( m_pTransformHierarchy != nullptr )
 	{
-		pNode->invalidateChildrenTransform();
+		m_pTransformHierarchy->markDirty( m_hierarchyIndex );
 	}
 }
 
 void Node::setWorldTransform( const dx::XMMATRIX &worldTransform ) cond_noex
 {
-	dx::XMStoreFloat4x4( &m_worldTransform, worldTransform );
-	m_bTransformNeedsUpdate = false;
+	ASSERT( m_pTransformHierarchy, "Node is not part of a TransformHierarchy!" );
+	m_pTransformHierarchy->setWorldTransform( m_hierarchyIndex, worldTransform );
 }
 
 void Node::setTransform( const float scale,
@@ -174,7 +148,7 @@ void Node::setScale( const float scale ) cond_noex
 	if ( m_scale.x != scale )
 	{
 		dx::XMVectorReplicate( scale );
-		invalidateChildrenTransform();
+		invalidateTransform();
 	}
 }
 
@@ -184,7 +158,7 @@ void Node::setScale( const DirectX::XMFLOAT3 &scale ) cond_noex
 	if ( m_scale != scale )
 	{
 		m_scale = scale;
-		invalidateChildrenTransform();
+		invalidateTransform();
 	}
 }
 
@@ -194,7 +168,7 @@ void Node::scaleRel( const DirectX::XMFLOAT3 &scale ) cond_noex
 	m_scale.x += scale.x;
 	m_scale.y += scale.y;
 	m_scale.z += scale.z;
-	invalidateChildrenTransform();
+	invalidateTransform();
 }
 
 void Node::setRotation( const DirectX::XMFLOAT3 &rotAnglesRadians ) cond_noex
@@ -203,7 +177,7 @@ void Node::setRotation( const DirectX::XMFLOAT3 &rotAnglesRadians ) cond_noex
 	if ( m_rot != rotAnglesRadians )
 	{
 		m_rot = rotAnglesRadians;
-		invalidateChildrenTransform();
+		invalidateTransform();
 	}
 }
 
@@ -213,7 +187,7 @@ void Node::rotateRel( const DirectX::XMFLOAT3 &rotAnglesRadians ) cond_noex
 	m_rot.x += rotAnglesRadians.x;
 	m_rot.y += rotAnglesRadians.y;
 	m_rot.z += rotAnglesRadians.z;
-	invalidateChildrenTransform();
+	invalidateTransform();
 }
 
 void Node::setTranslation( const DirectX::XMFLOAT3 &pos ) cond_noex
@@ -224,7 +198,7 @@ void Node::setTranslation( const DirectX::XMFLOAT3 &pos ) cond_noex
 		m_pos.x = pos.x;
 		m_pos.y = pos.y;
 		m_pos.z = pos.z;
-		invalidateChildrenTransform();
+		invalidateTransform();
 	}
 }
 
@@ -234,7 +208,7 @@ void Node::translateRel( const DirectX::XMFLOAT3 &pos ) cond_noex
 	m_pos.x += pos.x;
 	m_pos.y += pos.y;
 	m_pos.z += pos.z;
-	invalidateChildrenTransform();
+	invalidateTransform();
 }
 
 void Node::updateLocalTransform( const float dt,
@@ -276,17 +250,30 @@ void Node::updateLocalTransform( const float dt,
 	const dx::XMMATRIX rotMat = dx::XMMatrixRotationQuaternion( rotQuatVec );
 	const dx::XMMATRIX posMat = dx::XMMatrixTranslationFromVector( posVec );
 
-	dx::XMStoreFloat4x4( &m_localTransform, scaleMat * rotMat * posMat );
+	if ( m_pTransformHierarchy != nullptr )
+	{
+		m_pTransformHierarchy->setLocalTransform( m_hierarchyIndex, scaleMat * rotMat * posMat );
+	}
 }
 
 DirectX::XMMATRIX Node::getWorldTransform() const noexcept
 {
-	return dx::XMLoadFloat4x4( &m_worldTransform );
+	if ( m_pTransformHierarchy == nullptr )
+	{
+		return dx::XMMatrixIdentity();
+	}
+	return dx::XMLoadFloat4x4( &m_pTransformHierarchy->getWorldTransform( m_hierarchyIndex ) );
 }
 
 DirectX::XMFLOAT4X4 Node::getWorldTransform4x4() const noexcept
 {
-	return m_worldTransform;
+	if ( m_pTransformHierarchy == nullptr )
+	{
+		dx::XMFLOAT4X4 identity;
+		dx::XMStoreFloat4x4( &identity, dx::XMMatrixIdentity() );
+		return identity;
+	}
+	return m_pTransformHierarchy->getWorldTransform( m_hierarchyIndex );
 }
 
 float Node::getScale() const noexcept
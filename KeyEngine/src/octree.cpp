@@ -1,161 +1,734 @@
 #include "octree.h"
+#include <algorithm>
+#include <cmath>
+#include "assertions_console.h"
 
 
 namespace dx = DirectX;
 
-Octree::Octree( const dx::XMFLOAT3 &m_center,
-	const dx::XMFLOAT3 &halfDim )
+namespace
+{
+
+/// \brief	spread the lower 10 bits of v so that there are 2 zero bits between each
+std::uint32_t expandBits( std::uint32_t v ) noexcept
+{
+	v = ( v * 0x00010001u ) & 0xFF0000FFu;
+	v = ( v * 0x00000101u ) & 0x0F00F00Fu;
+	v = ( v * 0x00000011u ) & 0xC30C30C3u;
+	v = ( v * 0x00000005u ) & 0x49249249u;
+	return v;
+}
+
+float distanceSqPointAabb( const dx::XMFLOAT3 &p,
+	const dx::XMFLOAT3 &bmin,
+	const dx::XMFLOAT3 &bmax ) noexcept
+{
+	const float dx = std::max( { bmin.x - p.x, 0.0f, p.x - bmax.x } );
+	const float dy = std::max( { bmin.y - p.y, 0.0f, p.y - bmax.y } );
+	const float dz = std::max( { bmin.z - p.z, 0.0f, p.z - bmax.z } );
+	return dx * dx + dy * dy + dz * dz;
+}
+
+float distanceSq( const dx::XMFLOAT3 &a,
+	const dx::XMFLOAT3 &b ) noexcept
+{
+	const float dx = a.x - b.x;
+	const float dy = a.y - b.y;
+	const float dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+}// namespace
+
+
+bool Octree::Node::isLeaf() const noexcept
+{
+	return m_firstChild == s_invalid;
+}
+
+Octree::Octree( const dx::XMFLOAT3 &center,
+	const dx::XMFLOAT3 &halfDim,
+	const unsigned leafCapacity /*= 16u*/,
+	const unsigned maxDepth /*= s_mortonLevels*/ )
 	:
-	m_center( m_center ),
-	m_half( halfDim ),
-	m_data( nullptr )
+	m_leafCapacity{std::max( leafCapacity, 1u )},
+	m_maxDepth{std::min( maxDepth, s_mortonLevels )},
+	m_min{center.x - halfDim.x, center.y - halfDim.y, center.z - halfDim.z}
 {
-	// initially there are no m_children
-	for ( int i = 0; i < 8; ++i )
+	constexpr float cells = static_cast<float>( 1u << s_mortonLevels );
+	m_quantizationScale = {cells / ( 2.0f * halfDim.x ), cells / ( 2.0f * halfDim.y ), cells / ( 2.0f * halfDim.z )};
+
+	m_halfExtents[0] = halfDim;
+	for ( unsigned d = 1; d <= s_mortonLevels; ++d )
 	{
-		m_children[i] = nullptr;
+		m_halfExtents[d] = {m_halfExtents[d - 1].x * 0.5f, m_halfExtents[d - 1].y * 0.5f, m_halfExtents[d - 1].z * 0.5f};
 	}
+
+	clear();
+	m_nodes.front().m_center = center;
 }
 
-Octree::Octree( const Octree &rhs )
-	:
-	m_center( rhs.m_center ),
-	m_half( rhs.m_half ),
-	m_data( rhs.m_data )
+void Octree::clear()
 {
-
+	const dx::XMFLOAT3 center = m_nodes.empty() ?
+		dx::XMFLOAT3{} :
+		m_nodes.front().m_center;
+	m_nodes.clear();
+	m_nodes.emplace_back();
+	m_nodes.front().m_center = center;
+	m_freeNodeBlocks.clear();
+	m_bucketItems.clear();
+	m_bucketNext.clear();
+	m_freeBuckets.clear();
+	m_positions.clear();
+	m_codes.clear();
+	m_itemLeaf.clear();
+	m_itemSlot.clear();
+	m_freeItemIds.clear();
+	m_nItems = 0;
 }
 
-Octree::~Octree()
+void Octree::build( const std::vector<dx::XMFLOAT3> &points )
 {
-	for ( int i = 0; i < 8; ++i )
+	clear();
+
+	const std::size_t n = points.size();
+	m_positions = points;
+	m_codes.resize( n );
+	m_itemLeaf.resize( n );
+	m_itemSlot.resize( n );
+	m_nItems = n;
+
+	std::vector<std::pair<std::uint32_t, ItemId>> sorted( n );
+	for ( std::size_t i = 0; i < n; ++i )
 	{
-		delete m_children[i];
+		m_codes[i] = calcMortonCode( points[i] );
+		sorted[i] = {m_codes[i], static_cast<ItemId>( i )};
 	}
+	std::sort( sorted.begin(), sorted.end() );
+
+	m_nodes.reserve( 1 + 8 * ( n / m_leafCapacity + 1 ) );
+	m_bucketItems.reserve( ( n / m_leafCapacity + 1 ) * m_leafCapacity * 2 );
+	buildNode( 0, sorted, 0, n );
 }
 
-int Octree::getOctantContainingPoint( const dx::XMFLOAT3 &point ) const
+void Octree::buildNode( const std::uint32_t nodeIndex,
+	const std::vector<std::pair<std::uint32_t, ItemId>> &sorted,
+	const std::size_t begin,
+	const std::size_t end )
 {
-	int oct = 0;
-	if ( point.x >= m_center.x )
+	const unsigned depth = m_nodes[nodeIndex].m_depth;
+	if ( end - begin <= m_leafCapacity || depth == m_maxDepth )
 	{
-		oct |= 4;	// 0b 100
+		for ( std::size_t i = begin; i < end; ++i )
+		{
+			appendToLeaf( nodeIndex, sorted[i].second );
+		}
+		return;
 	}
-	if ( point.y >= m_center.y )
+
+	m_nodes[nodeIndex].m_count = static_cast<std::uint32_t>( end - begin );
+	const std::uint32_t firstChild = allocateChildren( nodeIndex );
+	// the range is sorted by Morton code, so each child's items are a contiguous sub-range
+	std::size_t childBegin = begin;
+	for ( unsigned c = 0; c < 8; ++c )
 	{
-		oct |= 2;	// 0b 010
+		const std::size_t childEnd = std::partition_point( sorted.begin() + childBegin, sorted.begin() + end,
+			[depth, c] ( const std::pair<std::uint32_t, ItemId> &item )
+			{
+				return getChildIndex( item.first, depth ) <= c;
+			} ) - sorted.begin();
+		buildNode( firstChild + c, sorted, childBegin, childEnd );
+		childBegin = childEnd;
 	}
-	if ( point.z >= m_center.z )
+}
+
+Octree::ItemId Octree::insert( const dx::XMFLOAT3 &position )
+{
+	const ItemId id = allocateItemId();
+	m_positions[id] = position;
+	m_codes[id] = calcMortonCode( position );
+	insertItem( id );
+	++m_nItems;
+	return id;
+}
+
+bool Octree::remove( const ItemId id )
+{
+	if ( id >= m_itemLeaf.size() || m_itemLeaf[id] == s_invalid )
 	{
-		oct |= 1;	// 0b 001
+		return false;
 	}
-	return oct;
+
+	removeItem( id );
+	m_freeItemIds.push_back( id );
+	--m_nItems;
+	return true;
 }
 
-bool Octree::isLeafNode() const
+void Octree::move( const ItemId id,
+	const dx::XMFLOAT3 &newPosition )
 {
-	/*
-	// This is correct, but overkill
-	for( int i = 0; i < 8; ++i )
+	ASSERT( id < m_itemLeaf.size() && m_itemLeaf[id] != s_invalid, "Invalid Octree item!" );
+	const std::uint32_t newCode = calcMortonCode( newPosition );
+	const Node &leaf = m_nodes[m_itemLeaf[id]];
+	m_positions[id] = newPosition;
+	if ( isSameCell( newCode, m_codes[id], leaf.m_depth ) )
 	{
-		if( m_children[i] != nullptr )
+		m_codes[id] = newCode;
+		return;
+	}
+
+	removeItem( id );
+	m_codes[id] = newCode;
+	insertItem( id );
+}
+
+const dx::XMFLOAT3& Octree::getPosition( const ItemId id ) const noexcept
+{
+	return m_positions[id];
+}
+
+std::size_t Octree::getItemCount() const noexcept
+{
+	return m_nItems;
+}
+
+std::size_t Octree::getNodeCount() const noexcept
+{
+	return m_nodes.size() - m_freeNodeBlocks.size() * 8;
+}
+
+void Octree::getEntitiesWithinBBox( const dx::XMFLOAT3 &bmin,
+	const dx::XMFLOAT3 &bmax,
+	std::vector<ItemId> &resultsOut ) const
+{
+	std::uint32_t stack[8 * s_mortonLevels + 1];
+	unsigned top = 0;
+	stack[top++] = 0;
+	while ( top > 0 )
+	{
+		const Node &node = m_nodes[stack[--top]];
+		if ( node.m_count == 0 )
+		{
+			continue;
+		}
+
+		dx::XMFLOAT3 nodeMin;
+		dx::XMFLOAT3 nodeMax;
+		getNodeBounds( node, nodeMin, nodeMax );
+		// check if the node's {min,max} lie out of requested bounds
+		if ( nodeMax.x < bmin.x || nodeMax.y < bmin.y || nodeMax.z < bmin.z
+			|| nodeMin.x > bmax.x || nodeMin.y > bmax.y || nodeMin.z > bmax.z )
+		{
+			continue;
+		}
+
+		if ( !node.isLeaf() )
 		{
-			return false;
+			for ( unsigned c = 0; c < 8; ++c )
+			{
+				stack[top++] = node.m_firstChild + c;
+			}
+			continue;
 		}
+
+		forEachLeafItem( node, [&] ( const ItemId id )
+			{
+				const dx::XMFLOAT3 &p = m_positions[id];
+				if ( p.x >= bmin.x && p.y >= bmin.y && p.z >= bmin.z && p.x <= bmax.x && p.y <= bmax.y && p.z <= bmax.z )
+				{
+					resultsOut.push_back( id );
+				}
+			} );
 	}
-	return true;
-	 */
-	return m_children[0] == nullptr;
 }
 
-void Octree::insert( OctreeData *data )
+void Octree::getEntitiesWithinSphere( const dx::XMFLOAT3 &center,
+	const float radius,
+	std::vector<ItemId> &resultsOut ) const
 {
-	// If this node doesn't have a m_data node yet assigned
-	// and it is a leaf, then we're done!
-	if ( isLeafNode() )
+	const float radiusSq = radius * radius;
+	std::uint32_t stack[8 * s_mortonLevels + 1];
+	unsigned top = 0;
+	stack[top++] = 0;
+	while ( top > 0 )
 	{
-		if ( m_data == nullptr )
+		const Node &node = m_nodes[stack[--top]];
+		if ( node.m_count == 0 )
 		{
-			m_data = data;
-			return;
+			continue;
 		}
-		else
+
+		dx::XMFLOAT3 nodeMin;
+		dx::XMFLOAT3 nodeMax;
+		getNodeBounds( node, nodeMin, nodeMax );
+		if ( distanceSqPointAabb( center, nodeMin, nodeMax ) > radiusSq )
 		{
-			// we're at a leaf, but there's already something here
-			// we will split this node so that it has 8 children octants
-			// and then insert `m_data` and `data` to children nodes
+			continue;
+		}
+
+		if ( !node.isLeaf() )
+		{
+			for ( unsigned c = 0; c < 8; ++c )
+			{
+				stack[top++] = node.m_firstChild + c;
+			}
+			continue;
+		}
+
+		forEachLeafItem( node, [&] ( const ItemId id )
+			{
+				if ( distanceSq( m_positions[id], center ) <= radiusSq )
+				{
+					resultsOut.push_back( id );
+				}
+			} );
+	}
+}
+
+void Octree::raycast( const dx::XMFLOAT3 &origin,
+	const dx::XMFLOAT3 &dir,
+	const float maxDistance,
+	const float hitRadius,
+	std::vector<std::pair<ItemId, float>> &resultsOut ) const
+{
+	const std::size_t firstResult = resultsOut.size();
+	const float hitRadiusSq = hitRadius * hitRadius;
+	const float invDir[3] = {1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z};
+	const float o[3] = {origin.x, origin.y, origin.z};
 
-			// save the data for a later re-insert
-			OctreeData *oldData = m_data;
-			m_data = nullptr;
+	std::uint32_t stack[8 * s_mortonLevels + 1];
+	unsigned top = 0;
+	stack[top++] = 0;
+	while ( top > 0 )
+	{
+		const Node &node = m_nodes[stack[--top]];
+		if ( node.m_count == 0 )
+		{
+			continue;
+		}
 
-			// split the current node and create new empty trees for each child octant
-			// compute bounding boxes for each child
-			for ( int i = 0; i < 8; ++i )
+		// slab test against the node's box inflated by the hit radius
+		dx::XMFLOAT3 nodeMin;
+		dx::XMFLOAT3 nodeMax;
+		getNodeBounds( node, nodeMin, nodeMax );
+		const float bmin[3] = {nodeMin.x - hitRadius, nodeMin.y - hitRadius, nodeMin.z - hitRadius};
+		const float bmax[3] = {nodeMax.x + hitRadius, nodeMax.y + hitRadius, nodeMax.z + hitRadius};
+		float tNear = 0.0f;
+		float tFar = maxDistance;
+		for ( int axis = 0; axis < 3; ++axis )
+		{
+			float t0 = ( bmin[axis] - o[axis] ) * invDir[axis];
+			float t1 = ( bmax[axis] - o[axis] ) * invDir[axis];
+			if ( t0 > t1 )
 			{
-				dx::XMFLOAT3 newCenter = m_center;
-				newCenter.x += m_half.x * ( i & 4 ? 0.5f : -0.5f );
-				newCenter.y += m_half.y * ( i & 2 ? 0.5f : -0.5f );
-				newCenter.z += m_half.z * ( i & 1 ? 0.5f : -0.5f );
-				m_children[i] = new Octree{ newCenter, m_half * 0.5f };
+				std::swap( t0, t1 );
 			}
+			// NaNs (0 * inf on a parallel ray starting on a slab plane) are ignored by this form of comparison
+			tNear = t0 > tNear ? t0 : tNear;
+			tFar = t1 < tFar ? t1 : tFar;
+		}
+		if ( tNear > tFar )
+		{
+			continue;
+		}
 
-			// re-insert
-			// (we wouldn't need to insert from the root, because we already
-			// know it's guaranteed to be in this section of the tree)
-			m_children[getOctantContainingPoint( oldData->getPosition() )]->insert( oldData );
-			m_children[getOctantContainingPoint( data->getPosition() )]->insert( data );
+		if ( !node.isLeaf() )
+		{
+			for ( unsigned c = 0; c < 8; ++c )
+			{
+				stack[top++] = node.m_firstChild + c;
+			}
+			continue;
 		}
+
+		forEachLeafItem( node, [&] ( const ItemId id )
+			{
+				const dx::XMFLOAT3 &p = m_positions[id];
+				const float t = std::clamp( ( p.x - origin.x ) * dir.x + ( p.y - origin.y ) * dir.y + ( p.z - origin.z ) * dir.z, 0.0f, maxDistance );
+				const dx::XMFLOAT3 closest{origin.x + dir.x * t, origin.y + dir.y * t, origin.z + dir.z * t};
+				if ( distanceSq( p, closest ) <= hitRadiusSq )
+				{
+					resultsOut.emplace_back( id, t );
+				}
+			} );
+	}
+
+	std::sort( resultsOut.begin() + firstResult, resultsOut.end(),
+		[] ( const std::pair<ItemId, float> &lhs, const std::pair<ItemId, float> &rhs )
+		{
+			return lhs.second < rhs.second;
+		} );
+}
+
+void Octree::getKNearest( const dx::XMFLOAT3 &point,
+	const std::size_t k,
+	std::vector<ItemId> &resultsOut ) const
+{
+	if ( k == 0 || m_nItems == 0 )
+	{
+		return;
+	}
+
+	using Candidate = std::pair<float, std::uint32_t>;	// {distanceSq, node or item}
+	// best-first traversal; nodes are visited in order of distance so we can stop once the nearest node is further than the k-th best item
+	std::vector<Candidate> nodeHeap;
+	std::vector<Candidate> best;	// max-heap of the k nearest items found so far
+	best.reserve( k + 1 );
+	nodeHeap.emplace_back( 0.0f, 0u );
+	while ( !nodeHeap.empty() )
+	{
+		std::pop_heap( nodeHeap.begin(), nodeHeap.end(), std::greater<Candidate>{} );
+		const Candidate nearest = nodeHeap.back();
+		nodeHeap.pop_back();
+		if ( best.size() == k && nearest.first > best.front().first )
+		{
+			break;
+		}
+
+		const Node &node = m_nodes[nearest.second];
+		if ( !node.isLeaf() )
+		{
+			for ( unsigned c = 0; c < 8; ++c )
+			{
+				const Node &child = m_nodes[node.m_firstChild + c];
+				if ( child.m_count == 0 )
+				{
+					continue;
+				}
+				dx::XMFLOAT3 childMin;
+				dx::XMFLOAT3 childMax;
+				getNodeBounds( child, childMin, childMax );
+				nodeHeap.emplace_back( distanceSqPointAabb( point, childMin, childMax ), node.m_firstChild + c );
+				std::push_heap( nodeHeap.begin(), nodeHeap.end(), std::greater<Candidate>{} );
+			}
+			continue;
+		}
+
+		forEachLeafItem( node, [&] ( const ItemId id )
+			{
+				const float dSq = distanceSq( m_positions[id], point );
+				if ( best.size() < k )
+				{
+					best.emplace_back( dSq, id );
+					std::push_heap( best.begin(), best.end() );
+				}
+				else if ( dSq < best.front().first )
+				{
+					std::pop_heap( best.begin(), best.end() );
+					best.back() = {dSq, id};
+					std::push_heap( best.begin(), best.end() );
+				}
+			} );
+	}
+
+	std::sort_heap( best.begin(), best.end() );
+	for ( const Candidate &candidate : best )
+	{
+		resultsOut.push_back( candidate.second );
+	}
+}
+
+std::uint32_t Octree::calcMortonCode( const dx::XMFLOAT3 &p ) const noexcept
+{
+	constexpr float maxCell = static_cast<float>( ( 1u << s_mortonLevels ) - 1u );
+	const auto quantize = [maxCell] ( const float v, const float min, const float scale ) -> std::uint32_t
+		{
+			return static_cast<std::uint32_t>( std::clamp( ( v - min ) * scale, 0.0f, maxCell ) );
+		};
+	ASSERT( p.x >= m_min.x && p.y >= m_min.y && p.z >= m_min.z, "Point out of Octree bounds!" );
+	return ( expandBits( quantize( p.x, m_min.x, m_quantizationScale.x ) ) << 2 )
+		| ( expandBits( quantize( p.y, m_min.y, m_quantizationScale.y ) ) << 1 )
+		| expandBits( quantize( p.z, m_min.z, m_quantizationScale.z ) );
+}
+
+unsigned Octree::getChildIndex( const std::uint32_t code,
+	const unsigned parentDepth ) noexcept
+{
+	return ( code >> ( 3 * ( s_mortonLevels - 1 - parentDepth ) ) ) & 7u;
+}
+
+bool Octree::isSameCell( const std::uint32_t codeA,
+	const std::uint32_t codeB,
+	const unsigned depth ) noexcept
+{
+	const unsigned shift = 3 * ( s_mortonLevels - depth );
+	return ( static_cast<std::uint64_t>( codeA ) >> shift ) == ( static_cast<std::uint64_t>( codeB ) >> shift );
+}
+
+void Octree::getNodeBounds( const Node &node,
+	dx::XMFLOAT3 &bmin,
+	dx::XMFLOAT3 &bmax ) const noexcept
+{
+	// slightly inflated so that float rounding in the quantization can never make us prune a node that holds a point on its border
+	const dx::XMFLOAT3 &half = m_halfExtents[node.m_depth];
+	const float ex = half.x * 1.0001f;
+	const float ey = half.y * 1.0001f;
+	const float ez = half.z * 1.0001f;
+	bmin = {node.m_center.x - ex, node.m_center.y - ey, node.m_center.z - ez};
+	bmax = {node.m_center.x + ex, node.m_center.y + ey, node.m_center.z + ez};
+}
+
+Octree::ItemId Octree::allocateItemId()
+{
+	if ( !m_freeItemIds.empty() )
+	{
+		const ItemId id = m_freeItemIds.back();
+		m_freeItemIds.pop_back();
+		return id;
+	}
+
+	const ItemId id = static_cast<ItemId>( m_positions.size() );
+	m_positions.emplace_back();
+	m_codes.emplace_back();
+	m_itemLeaf.emplace_back( s_invalid );
+	m_itemSlot.emplace_back( s_invalid );
+	return id;
+}
+
+std::uint32_t Octree::allocateBucket()
+{
+	std::uint32_t bucket;
+	if ( !m_freeBuckets.empty() )
+	{
+		bucket = m_freeBuckets.back();
+		m_freeBuckets.pop_back();
 	}
 	else
 	{
-		// We are at an interior node.
-		// Insert recursively into the appropriate child octant until we reach a leaf
-		int octant = getOctantContainingPoint( data->getPosition() );
-		m_children[octant]->insert( data );
+		bucket = static_cast<std::uint32_t>( m_bucketNext.size() );
+		m_bucketNext.emplace_back();
+		m_bucketItems.resize( m_bucketItems.size() + m_leafCapacity );
 	}
+	m_bucketNext[bucket] = s_invalid;
+	return bucket;
 }
 
-void Octree::getEntitiesWithinBBox( const dx::XMFLOAT3 &requestedMin,
-	const dx::XMFLOAT3 &requestedMax,
-	std::vector<OctreeData*>& resultsOut )
+std::uint32_t Octree::allocateChildren( const std::uint32_t parentIndex )
 {
-	// if we're at a leaf node, check to see whether the point is inside the BBox
-	if ( isLeafNode() )
+	std::uint32_t firstChild;
+	if ( !m_freeNodeBlocks.empty() )
 	{
-		if ( m_data != nullptr )
+		firstChild = m_freeNodeBlocks.back();
+		m_freeNodeBlocks.pop_back();
+	}
+	else
+	{
+		firstChild = static_cast<std::uint32_t>( m_nodes.size() );
+		m_nodes.resize( m_nodes.size() + 8 );
+	}
+
+	// compute the bounding box of each child
+	const Node &parent = m_nodes[parentIndex];
+	const unsigned childDepth = parent.m_depth + 1;
+	const dx::XMFLOAT3 &half = m_halfExtents[childDepth];
+	for ( unsigned c = 0; c < 8; ++c )
+	{
+		Node &child = m_nodes[firstChild + c];
+		child = Node{};
+		child.m_center = {parent.m_center.x + ( c & 4 ? half.x : -half.x ),
+			parent.m_center.y + ( c & 2 ? half.y : -half.y ),
+			parent.m_center.z + ( c & 1 ? half.z : -half.z )};
+		child.m_parent = parentIndex;
+		child.m_depth = childDepth;
+	}
+	m_nodes[parentIndex].m_firstChild = firstChild;
+	return firstChild;
+}
+
+Octree::ItemId& Octree::getLeafItem( const Node &leaf,
+	const std::uint32_t slot )
+{
+	std::uint32_t bucket = leaf.m_firstBucket;
+	for ( std::uint32_t i = slot / m_leafCapacity; i > 0; --i )
+	{
+		bucket = m_bucketNext[bucket];
+	}
+	return m_bucketItems[bucket * m_leafCapacity + slot % m_leafCapacity];
+}
+
+Octree::ItemId Octree::getLeafItem( const Node &leaf,
+	const std::uint32_t slot ) const
+{
+	return const_cast<Octree*>( this )->getLeafItem( leaf, slot );
+}
+
+template<typename TFunc>
+void Octree::forEachLeafItem( const Node &leaf,
+	const TFunc &f ) const
+{
+	std::uint32_t remaining = leaf.m_count;
+	for ( std::uint32_t bucket = leaf.m_firstBucket; remaining > 0; bucket = m_bucketNext[bucket] )
+	{
+		const ItemId *pItems = &m_bucketItems[bucket * m_leafCapacity];
+		const std::uint32_t n = std::min( remaining, m_leafCapacity );
+		for ( std::uint32_t i = 0; i < n; ++i )
 		{
-			const dx::XMFLOAT3 p = m_data->getPosition();
-			if ( p.x > requestedMax.x || p.y > requestedMax.y || p.z > requestedMax.z || p.x < requestedMin.x || p.y < requestedMin.y || p.z < requestedMin.z )
+			f( pItems[i] );
+		}
+		remaining -= n;
+	}
+}
+
+void Octree::appendToLeaf( const std::uint32_t leafIndex,
+	const ItemId id )
+{
+	Node &leaf = m_nodes[leafIndex];
+	const std::uint32_t slot = leaf.m_count;
+	if ( slot % m_leafCapacity == 0 )
+	{
+		// the last bucket of the chain is full (or there is none)
+		const std::uint32_t bucket = allocateBucket();
+		if ( slot == 0 )
+		{
+			leaf.m_firstBucket = bucket;
+		}
+		else
+		{
+			std::uint32_t last = leaf.m_firstBucket;
+			while ( m_bucketNext[last] != s_invalid )
 			{
-				return;
+				last = m_bucketNext[last];
 			}
-			resultsOut.push_back( m_data );
+			m_bucketNext[last] = bucket;
 		}
 	}
-	else
+
+	getLeafItem( leaf, slot ) = id;
+	++leaf.m_count;
+	m_itemLeaf[id] = leafIndex;
+	m_itemSlot[id] = slot;
+}
+
+void Octree::detachLeafItems( const std::uint32_t leafIndex )
+{
+	Node &leaf = m_nodes[leafIndex];
+	forEachLeafItem( leaf, [this] ( const ItemId id )
+		{
+			m_scratch.push_back( id );
+		} );
+	for ( std::uint32_t bucket = leaf.m_firstBucket; bucket != s_invalid; bucket = m_bucketNext[bucket] )
+	{
+		m_freeBuckets.push_back( bucket );
+	}
+	leaf.m_firstBucket = s_invalid;
+	leaf.m_count = 0;
+}
+
+void Octree::insertItem( const ItemId id )
+{
+	const std::uint32_t code = m_codes[id];
+	std::uint32_t nodeIndex = 0;
+	while ( true )
+	{
+		Node &node = m_nodes[nodeIndex];
+		if ( !node.isLeaf() )
+		{
+			++node.m_count;
+			nodeIndex = node.m_firstChild + getChildIndex( code, node.m_depth );
+			continue;
+		}
+
+		if ( node.m_count < m_leafCapacity || node.m_depth == m_maxDepth )
+		{
+			appendToLeaf( nodeIndex, id );
+			return;
+		}
+
+		// a full leaf - split it & keep descending
+		split( nodeIndex );
+	}
+}
+
+void Octree::split( const std::uint32_t leafIndex )
+{
+	// stash the items, the bucket goes back to the pool
+	m_scratch.clear();
+	const std::uint32_t count = m_nodes[leafIndex].m_count;
+	detachLeafItems( leafIndex );
+	m_nodes[leafIndex].m_count = count;
+
+	const std::uint32_t firstChild = allocateChildren( leafIndex );
+	const unsigned depth = m_nodes[leafIndex].m_depth;
+	for ( const ItemId id : m_scratch )
 	{
-		// We're at an interior node of the tree. We will check to see if
-		// the query bounding box lies outside the octants of this node.
-		for ( int i = 0; i < 8; ++i )
-		{
-			// Compute the min/max corners of this child octant
-			dx::XMFLOAT3 childMax = m_children[i]->m_center + m_children[i]->m_half;
-			dx::XMFLOAT3 childMin = m_children[i]->m_center - m_children[i]->m_half;
-
-			// check if child's {min,max} lie out of requested bounds
-			if ( childMax.x < requestedMin.x
-				|| childMax.y < requestedMin.y
-				|| childMax.z < requestedMin.z
-				|| childMin.x > requestedMax.x
-				|| childMin.y > requestedMax.y
-				|| childMin.z > requestedMax.z )
+		appendToLeaf( firstChild + getChildIndex( m_codes[id], depth ), id );
+	}
+}
+
+void Octree::removeItem( const ItemId id )
+{
+	const std::uint32_t leafIndex = m_itemLeaf[id];
+	Node &leaf = m_nodes[leafIndex];
+	const std::uint32_t slot = m_itemSlot[id];
+	const std::uint32_t lastSlot = leaf.m_count - 1;
+
+	// swap-remove within the leaf's bucket chain
+	const ItemId lastId = getLeafItem( leaf, lastSlot );
+	if ( lastId != id )
+	{
+		getLeafItem( leaf, slot ) = lastId;
+		m_itemSlot[lastId] = slot;
+	}
+
+	if ( lastSlot % m_leafCapacity == 0 )
+	{
+		// the last bucket is empty now - unlink it
+		if ( lastSlot == 0 )
+		{
+			m_freeBuckets.push_back( leaf.m_firstBucket );
+			leaf.m_firstBucket = s_invalid;
+		}
+		else
+		{
+			std::uint32_t bucket = leaf.m_firstBucket;
+			while ( m_bucketNext[m_bucketNext[bucket]] != s_invalid )
 			{
-				continue;
+				bucket = m_bucketNext[bucket];
 			}
+			m_freeBuckets.push_back( m_bucketNext[bucket] );
+			m_bucketNext[bucket] = s_invalid;
+		}
+	}
 
-			// we've determined that this child contains the requested bounding box
-			m_children[i]->getEntitiesWithinBBox( requestedMin, requestedMax, resultsOut );
+	m_itemLeaf[id] = s_invalid;
+	m_itemSlot[id] = s_invalid;
+	for ( std::uint32_t nodeIndex = leafIndex; nodeIndex != s_invalid; nodeIndex = m_nodes[nodeIndex].m_parent )
+	{
+		--m_nodes[nodeIndex].m_count;
+	}
+
+	tryCollapse( leaf.m_parent );
+}
+
+void Octree::tryCollapse( std::uint32_t nodeIndex )
+{
+	while ( nodeIndex != s_invalid && m_nodes[nodeIndex].m_count <= m_leafCapacity )
+	{
+		const std::uint32_t firstChild = m_nodes[nodeIndex].m_firstChild;
+		for ( unsigned c = 0; c < 8; ++c )
+		{
+			if ( !m_nodes[firstChild + c].isLeaf() )
+			{
+				return;
+			}
 		}
+
+		// merge the children back into this node
+		m_scratch.clear();
+		for ( unsigned c = 0; c < 8; ++c )
+		{
+			detachLeafItems( firstChild + c );
+		}
+		m_freeNodeBlocks.push_back( firstChild );
+		m_nodes[nodeIndex].m_firstChild = s_invalid;
+		m_nodes[nodeIndex].m_count = 0;
+		for ( const ItemId id : m_scratch )
+		{
+			appendToLeaf( nodeIndex, id );
+		}
+
+		nodeIndex = m_nodes[nodeIndex].m_parent;
 	}
 }
\ No newline at end of file
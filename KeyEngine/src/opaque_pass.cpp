@@ -41,6 +41,13 @@ void OpaquePass::run( Graphics &gfx ) const cond_noex
 	RenderQueuePass::run( gfx );
 }
 
+void OpaquePass::bindSharedState( Graphics &gfx ) const cond_noex
+{
+	RenderQueuePass::bindSharedState( gfx );
+	ASSERT( m_pActiveCamera, "Main camera is absent!!!" );
+	m_pActiveCamera->makeActive( gfx );
+}
+
 void OpaquePass::setActiveCamera( const Camera &cam ) noexcept
 {
 	m_pActiveCamera = &cam;
@@ -42,6 +42,16 @@ const bool IPass::isActive() const noexcept
 	return m_bActive;
 }
 
+void IPass::bindSharedState( Graphics &gfx ) const cond_noex
+{
+	pass_;
+}
+
+bool IPass::isRecordable() const noexcept
+{
+	return false;
+}
+
 void IPass::recreateRtvsAndDsvs( Graphics &gfx )
 {
 	pass_;
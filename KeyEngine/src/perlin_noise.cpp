@@ -1,9 +1,79 @@
 #include "perlin_noise.h"
 #include <numeric>
 #include <ctime>
+#include <cmath>
 #include <random>
 #include <algorithm>
+#include "perlin_noise_kernel.h"
+#include "cpu_features.h"
 #include "math_utils.h"
+#include "thread_poolj.h"
+
+
+namespace
+{
+
+//	float batches run on AVX2 if the CPU has it & on SSE2 otherwise
+//	with only 2 or 4 lanes the vector arithmetic doesn't make up for transposing the per lane lattice hashes
+//		so doubles are evaluated one at a time by the callers' scalar loops
+std::size_t sampleSimd( const int *perm,
+	const float *xs,
+	const float *ys,
+	const float *zs,
+	float *out,
+	const std::size_t n,
+	const PerlinNoise::Fractal &fractal,
+	const Params<float> &params ) noexcept
+{
+	if ( util::getCpuFeatures().bAvx2 )
+	{
+		return perlin_noise_avx2::sample( perm, xs, ys, zs, out, n, fractal );
+	}
+	return sampleLanes<Sse2Float>( perm, xs, ys, zs, out, n, params );
+}
+
+std::size_t sampleSimd( const int *,
+	const double *,
+	const double *,
+	const double *,
+	double *,
+	const std::size_t,
+	const PerlinNoise::Fractal &,
+	const Params<double> & ) noexcept
+{
+	return 0u;
+}
+
+std::size_t sampleRowSimd( const int *perm,
+	const float *xs,
+	const float y,
+	const float z,
+	float *out,
+	const std::size_t n,
+	const PerlinNoise::Fractal &fractal,
+	const Params<float> &params ) noexcept
+{
+	if ( util::getCpuFeatures().bAvx2 )
+	{
+		return perlin_noise_avx2::sampleRow( perm, xs, y, z, out, n, fractal );
+	}
+	return sampleRowLanes<Sse2Float>( perm, xs, y, z, out, n, params );
+}
+
+std::size_t sampleRowSimd( const int *,
+	const double *,
+	const double,
+	const double,
+	double *,
+	const std::size_t,
+	const PerlinNoise::Fractal &,
+	const Params<double> & ) noexcept
+{
+	return 0u;
+}
+
+
+}// namespace
 
 
 PerlinNoise::PerlinNoise( unsigned int seed /*= 0*/ )
@@ -13,79 +83,109 @@ PerlinNoise::PerlinNoise( unsigned int seed /*= 0*/ )
 
 	seed = (seed == 0) ? t : seed;
 
-	m_permutationVec.resize( 256 );
-
 	// fill p with values from 0 to 255
-	std::iota( m_permutationVec.begin(), m_permutationVec.end(), 0 );
+	std::iota( m_permutation.begin(), m_permutation.begin() + 256, 0 );
 
 	// initialize a random engine with seed
 	std::default_random_engine engine( seed );
 
 	// shuffle using the above random engine
-	std::shuffle( m_permutationVec.begin(), m_permutationVec.end(), engine );
+	std::shuffle( m_permutation.begin(), m_permutation.begin() + 256, engine );
 
 	// duplicate the permutation vector
-	m_permutationVec.insert( m_permutationVec.end(), m_permutationVec.begin(), m_permutationVec.end() );
+	std::copy( m_permutation.begin(), m_permutation.begin() + 256, m_permutation.begin() + 256 );
 }
 
 double PerlinNoise::noise( double x,
 	double y,
-	double z )
+	double z ) const noexcept
+{
+	// same as sample<double>( x, y, z ) minus the Fractal bookkeeping
+	return ( Kernel<ScalarLanes<double>>::signedNoise( m_permutation.data(), x, y, z, 256 ) + 1.0 ) * 0.5;
+}
+
+template<typename T>
+T PerlinNoise::sample( const T x,
+	const T y,
+	const T z,
+	const Fractal &fractal /*= {}*/ ) const noexcept
+{
+	return Kernel<ScalarLanes<T>>::sample( m_permutation.data(), x, y, z, Params<T>{fractal} );
+}
+
+template<typename T>
+void PerlinNoise::sample( const T *xs,
+	const T *ys,
+	const T *zs,
+	T *out,
+	const std::size_t n,
+	const Fractal &fractal /*= {}*/ ) const noexcept
 {
-	// Find the unit cube that contains the point
-	int X = (int) floor( x ) & 255;
-	int Y = (int) floor( y ) & 255;
-	int Z = (int) floor( z ) & 255;
-
-	// Find relative x, y, z of point in cube
-	x -= floor(x);
-	y -= floor(y);
-	z -= floor(z);
-
-	// Compute fade curves for each of x, y, z
-	double u = fade(x);
-	double v = fade(y);
-	double w = fade(z);
-
-	// Hash coordinates of the 8 cube corners
-	int A = m_permutationVec[X] + Y;
-	int AA = m_permutationVec[A] + Z;
-	int AB = m_permutationVec[A + 1] + Z;
-	int B = m_permutationVec[X + 1] + Y;
-	int BA = m_permutationVec[B] + Z;
-	int BB = m_permutationVec[B + 1] + Z;
-
-	// Add blended results from 8 corners of cube
-	double res = util::lerp(
-		util::lerp(
-				util::lerp(grad(m_permutationVec[AA], x, y, z), grad(m_permutationVec[BA], x - 1, y, z), u),
-				util::lerp(grad(m_permutationVec[AB], x, y - 1, z), grad(m_permutationVec[BB], x - 1, y - 1, z), u),
-			v),
-		util::lerp(
-				util::lerp(grad(m_permutationVec[AA + 1], x, y, z - 1), grad(m_permutationVec[BA + 1], x - 1, y, z - 1), u),
-				util::lerp(grad(m_permutationVec[AB + 1], x, y - 1, z - 1),	grad(m_permutationVec[BB + 1], x - 1, y - 1, z - 1), u),
-				v),
-		w);
-	return ( res + 1.0 ) / 2.0;
+	const Params<T> params{fractal};
+	std::size_t i = sampleSimd( m_permutation.data(), xs, ys, zs, out, n, fractal, params );
+	for ( ; i < n; ++i )
+	{
+		out[i] = Kernel<ScalarLanes<T>>::sample( m_permutation.data(), xs[i], ys[i], zs[i], params );
+	}
 }
 
-double PerlinNoise::fade( const double t )
+template<typename T>
+void PerlinNoise::fillGrid( T *out,
+	const Grid &grid,
+	const Fractal &fractal /*= {}*/,
+	const bool bParallel /*= false*/ ) const
 {
-	return t * t * t * ( t * ( t * 6 - 15 ) + 10 );
+	const std::size_t nRows = static_cast<std::size_t>( grid.height ) * grid.depth;
+	if ( !bParallel )
+	{
+		fillGridRows( out, grid, fractal, 0, nRows );
+		return;
+	}
+
+	ThreadPoolJ::getInstance().parallelFor( 0, nRows, 0,
+		[this, out, &grid, &fractal] ( const std::size_t firstRow, const std::size_t lastRow )
+		{
+			fillGridRows( out, grid, fractal, firstRow, lastRow );
+		} );
 }
 
-double PerlinNoise::grad( const int hash,
-	const double x,
-	const double y,
-	const double z )
+template<typename T>
+void PerlinNoise::fillGridRows( T *out,
+	const Grid &grid,
+	const Fractal &fractal,
+	const std::size_t firstRow,
+	const std::size_t lastRow ) const noexcept
 {
-	int h = hash & 15;
-	// Convert lower 4 bits of hash into 12 gradient directions
-	double u = h < 8 ?
-		x :
-		y;
-	double v = h < 4 ?
-		y :
-		h == 12 || h == 14 ? x : z;
-	return ( (h & 1) == 0 ? u : -u ) + ( (h & 2) == 0 ? v : -v );
-}
\ No newline at end of file
+	const Params<T> params{fractal};
+	// every row samples the same x coordinates, a block of them at a time
+	constexpr std::size_t nBlockColumns = 256u;
+	alignas( 32 ) T xs[nBlockColumns];
+	for ( std::size_t row = firstRow; row < lastRow; ++row )
+	{
+		const T y = static_cast<T>( grid.y0 + grid.dy * static_cast<unsigned>( row % grid.height ) );
+		const T z = static_cast<T>( grid.z0 + grid.dz * static_cast<unsigned>( row / grid.height ) );
+		T *pRow = out + row * grid.width;
+
+		for ( std::size_t firstColumn = 0; firstColumn < grid.width; firstColumn += nBlockColumns )
+		{
+			const std::size_t nColumns = std::min( nBlockColumns, grid.width - firstColumn );
+			for ( std::size_t i = 0; i < nColumns; ++i )
+			{
+				xs[i] = static_cast<T>( grid.x0 + grid.dx * static_cast<unsigned>( firstColumn + i ) );
+			}
+
+			std::size_t i = sampleRowSimd( m_permutation.data(), xs, y, z, pRow + firstColumn, nColumns, fractal, params );
+			for ( ; i < nColumns; ++i )
+			{
+				pRow[firstColumn + i] = Kernel<ScalarLanes<T>>::sample( m_permutation.data(), xs[i], y, z, params );
+			}
+		}
+	}
+}
+
+template float PerlinNoise::sample<float>( const float x, const float y, const float z, const Fractal &fractal ) const noexcept;
+template double PerlinNoise::sample<double>( const double x, const double y, const double z, const Fractal &fractal ) const noexcept;
+template void PerlinNoise::sample<float>( const float *xs, const float *ys, const float *zs, float *out, const std::size_t n, const Fractal &fractal ) const noexcept;
+template void PerlinNoise::sample<double>( const double *xs, const double *ys, const double *zs, double *out, const std::size_t n, const Fractal &fractal ) const noexcept;
+template void PerlinNoise::fillGrid<float>( float *out, const Grid &grid, const Fractal &fractal, const bool bParallel ) const;
+template void PerlinNoise::fillGrid<double>( double *out, const Grid &grid, const Fractal &fractal, const bool bParallel ) const;
\ No newline at end of file
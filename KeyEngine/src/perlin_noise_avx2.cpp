@@ -0,0 +1,69 @@
+#include "perlin_noise_kernel.h"
+
+
+// built with AVX2 code generation (/arch:AVX2, -mavx2) but no FMA contraction, so the results match the SSE2 & scalar paths bit for bit
+//	PerlinNoise only calls in here if the CPU supports AVX2
+
+namespace
+{
+
+struct Avx2Float final
+{
+	using T = float;
+	using V = __m256;
+	static constexpr std::size_t s_nLanes = 8u;
+
+	static V load( const T *p ) noexcept { return _mm256_loadu_ps( p ); }
+	static void store( T *p, const V a ) noexcept { _mm256_storeu_ps( p, a ); }
+	static V set1( const T t ) noexcept { return _mm256_set1_ps( t ); }
+	static V add( const V a, const V b ) noexcept { return _mm256_add_ps( a, b ); }
+	static V sub( const V a, const V b ) noexcept { return _mm256_sub_ps( a, b ); }
+	static V mul( const V a, const V b ) noexcept { return _mm256_mul_ps( a, b ); }
+	static V abs( const V a ) noexcept { return _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a ); }
+	static V floor( const V a ) noexcept { return _mm256_floor_ps( a ); }
+	static void toInt( const V a, int *p ) noexcept { _mm256_storeu_si256( reinterpret_cast<__m256i*>( p ), _mm256_cvttps_epi32( a ) ); }
+
+	static V grad( const int *hash, const V x, const V y, const V z ) noexcept
+	{
+		const __m256i h = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( hash ) );
+		const V bUx = _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_set1_epi32( 8 ), h ) );
+		const V bVy = _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_set1_epi32( 4 ), h ) );
+		const V bVx = _mm256_castsi256_ps( _mm256_or_si256( _mm256_cmpeq_epi32( h, _mm256_set1_epi32( 12 ) ), _mm256_cmpeq_epi32( h, _mm256_set1_epi32( 14 ) ) ) );
+		const V u = _mm256_blendv_ps( y, x, bUx );
+		const V v = _mm256_blendv_ps( _mm256_blendv_ps( z, x, bVx ), y, bVy );
+		const V uSign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_and_si256( h, _mm256_set1_epi32( 1 ) ), 31 ) );
+		const V vSign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_and_si256( h, _mm256_set1_epi32( 2 ) ), 30 ) );
+		return _mm256_add_ps( _mm256_xor_ps( u, uSign ), _mm256_xor_ps( v, vSign ) );
+	}
+};
+
+
+}// namespace
+
+namespace perlin_noise_avx2
+{
+
+std::size_t sample( const int *perm,
+	const float *xs,
+	const float *ys,
+	const float *zs,
+	float *out,
+	const std::size_t n,
+	const PerlinNoise::Fractal &fractal ) noexcept
+{
+	return sampleLanes<Avx2Float>( perm, xs, ys, zs, out, n, Params<float>{fractal} );
+}
+
+std::size_t sampleRow( const int *perm,
+	const float *xs,
+	const float y,
+	const float z,
+	float *out,
+	const std::size_t n,
+	const PerlinNoise::Fractal &fractal ) noexcept
+{
+	return sampleRowLanes<Avx2Float>( perm, xs, y, z, out, n, Params<float>{fractal} );
+}
+
+
+}//namespace perlin_noise_avx2
\ No newline at end of file
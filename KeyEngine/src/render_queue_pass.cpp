@@ -1,6 +1,11 @@
 #include "render_queue_pass.h"
 #include <algorithm>
-#include <iterator>
+#include "material.h"
+#include "mesh.h"
+#include "node.h"
+#include "instance_buffer.h"
+#include "transform_vscb.h"
+#include "global_constants.h"
 
 
 namespace ren
@@ -16,27 +21,83 @@ RenderQueuePass::RenderQueuePass( const std::string &name,
 
 }
 
+RenderQueuePass::~RenderQueuePass() noexcept
+{
+
+}
+
 void RenderQueuePass::addJob( Job job,
 	const float meshDistanceFromActiveCamera ) noexcept
 {
-	m_jobs.emplace_back( job, meshDistanceFromActiveCamera );
+	m_sortEntries.push_back( {makeSortKey( job, meshDistanceFromActiveCamera ), static_cast<std::uint32_t>( m_jobs.size() )} );
+	m_jobs.emplace_back( job );
+	m_bSorted = false;
 }
 
 void RenderQueuePass::run( Graphics &gfx ) const cond_noex
 {
 	IBindablePass::bind( gfx );
 
-	const_cast<RenderQueuePass*>( this )->sortJobs();
+	// some Passes (eg. ShadowPass) run multiple times per frame
+	if ( !m_bSorted )
+	{
+		sortJobs();
+		if ( !m_bTransparent )
+		{
+			formInstanceBatches( gfx );
+		}
+		m_bSorted = true;
+	}
 
-	for ( const auto &job : m_jobs )
+	m_batchLods.assign( m_instanceBatcher.getBatches().size(), ~0u );
+	for ( const auto &entry : m_sortEntries )
 	{
-		job.first.run( gfx );
+		const std::uint32_t batchIndex = m_instanceBatcher.getBatch( entry.m_jobIndex );
+		if ( batchIndex != InstanceBatcher::s_notBatched )
+		{
+			m_batchLods[batchIndex] = std::min( m_batchLods[batchIndex], m_jobs[entry.m_jobIndex].getMesh()->selectLod( gfx ) );
+		}
+	}
+
+	m_nSkippedBinds = 0u;
+	m_nDrawCalls = 0u;
+	const Job *pPreviousJob = nullptr;
+	for ( const auto &entry : m_sortEntries )
+	{
+		const Job &job = m_jobs[entry.m_jobIndex];
+		const std::uint32_t batchIndex = m_instanceBatcher.getBatch( entry.m_jobIndex );
+		if ( batchIndex == InstanceBatcher::s_notBatched )
+		{
+			m_nSkippedBinds += job.run( gfx, pPreviousJob );
+			pPreviousJob = &job;
+			++m_nDrawCalls;
+			continue;
+		}
+
+		const auto &batch = m_instanceBatcher.getBatches()[batchIndex];
+		if ( batch.m_firstJob == entry.m_jobIndex )
+		{
+			m_pInstanceBuffer->bind( gfx );
+			m_pInstancedTransformVscb->bind( gfx );
+			job.runInstanced( gfx, batch.m_nInstances, batch.m_firstInstance, m_batchLods[batchIndex] );
+			// the pipeline now holds the instanced shader & layout
+			pPreviousJob = nullptr;
+			++m_nDrawCalls;
+		}
 	}
 }
 
 void RenderQueuePass::reset() cond_noex
 {
 	m_jobs.clear();
+	m_sortEntries.clear();
+	m_instanceBatcher.clear();
+	m_bSorted = true;
+}
+
+bool RenderQueuePass::isRecordable() const noexcept
+{
+	return true;
 }
 
 size_t RenderQueuePass::getNumMeshes() const noexcept
@@ -44,38 +105,61 @@ size_t RenderQueuePass::getNumMeshes() const noexcept
 	return m_jobs.size();
 }
 
-void RenderQueuePass::sortJobs()
+unsigned RenderQueuePass::getNumSkippedBinds() const noexcept
+{
+	return m_nSkippedBinds;
+}
+
+unsigned RenderQueuePass::getNumDrawCalls() const noexcept
+{
+	return m_nDrawCalls;
+}
+
+std::uint64_t RenderQueuePass::makeSortKey( const Job &job,
+	const float meshDistanceFromActiveCamera ) const noexcept
 {
+	const Material &material = *job.getMaterial();
 	if ( m_bTransparent )
 	{
-		// if meshes are transparent sort them back to front (those with the largest distance from camera are rendered first)
-		std::sort( m_jobs.begin(), m_jobs.end(),
-		[] ( const auto &itLeft, const auto &itRight ) -> bool
-			{
-				const float distLeft = itLeft.second;
-				const float distRight = itRight.second;
-				if ( distLeft != distRight )
-				{
-					return distLeft > distRight;
-				}
-				return false;
-			} );
+		// transparent meshes must be blended back to front (those with the largest distance from camera are rendered first)
+		return makeTransparentSortKey( material.getShaderSortId(), material.getTextureSortId(), meshDistanceFromActiveCamera );
+	}
+	// opaque meshes are grouped by state & then sorted front to back (those with least distance from camera are rendered first) to maximize early-z rejection
+	return makeOpaqueSortKey( material.getShaderSortId(), material.getTextureSortId(), meshDistanceFromActiveCamera );
+}
+
+void RenderQueuePass::sortJobs() const
+{
+	sortByKey( m_sortEntries, m_sortScratch );
+}
+
+void RenderQueuePass::formInstanceBatches( Graphics &gfx ) const
+{
+	m_instanceBatcher.clear();
+	for ( const auto &entry : m_sortEntries )
+	{
+		const Job &job = m_jobs[entry.m_jobIndex];
+		const std::uint64_t materialKey = job.getMaterial()->getInstancingKey();
+		if ( materialKey == 0 )
+		{
+			continue;
+		}
+		const std::uint64_t key = ( materialKey ^ job.getMesh()->getGeometryKey() ) * 0x100000001B3ull;
+		m_instanceBatcher.add( key != 0 ? key : 1u, entry.m_jobIndex, job.getMesh()->getNode()->getWorldTransform4x4() );
+	}
+	m_instanceBatcher.build( m_jobs.size() );
+
+	const auto &instanceData = m_instanceBatcher.getInstanceData();
+	if ( instanceData.empty() )
+	{
+		return;
 	}
-	else
+	if ( !m_pInstanceBuffer )
 	{
-		// if meshes are opaque sort them front to back (those with least distance from camera are rendered first)
-		std::sort( m_jobs.begin(), m_jobs.end(),
-		[] ( const auto &itLeft, const auto &itRight ) -> bool
-			{
-				const float distLeft = itLeft.second;
-				const float distRight = itRight.second;
-				if ( distLeft != distRight )
-				{
-					return distLeft < distRight;
-				}
-				return false;
-			} );
+		m_pInstanceBuffer = std::make_unique<InstanceBuffer>( gfx, static_cast<unsigned>( sizeof( DirectX::XMFLOAT4X4 ) ) );
+		m_pInstancedTransformVscb = std::make_unique<InstancedTransformVSCB>( gfx, g_modelVscbSlot );
 	}
+	m_pInstanceBuffer->update( gfx, instanceData.data(), static_cast<unsigned>( instanceData.size() ) );
 }
 
 
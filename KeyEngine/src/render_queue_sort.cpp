@@ -0,0 +1,98 @@
+#include "render_queue_sort.h"
+#include <algorithm>
+#include <cstring>
+
+
+namespace ren
+{
+
+namespace
+{
+
+/// \brief	monotonic 24bit quantization of a non negative distance (the top bits of its IEEE-754 representation)
+std::uint64_t quantizeDepth( const float distance ) noexcept
+{
+	std::uint32_t bits = 0u;
+	if ( distance > 0.0f )
+	{
+		std::memcpy( &bits, &distance, sizeof( float ) );
+	}
+	return bits >> 8;
+}
+
+}// namespace
+
+std::uint64_t makeOpaqueSortKey( const std::uint32_t shaderId,
+	const std::uint32_t textureId,
+	const float distance ) noexcept
+{
+	return ( ( shaderId & 0xFFFFFFull ) << 40 ) | ( ( textureId & 0xFFFFull ) << 24 ) | quantizeDepth( distance );
+}
+
+std::uint64_t makeTransparentSortKey( const std::uint32_t shaderId,
+	const std::uint32_t textureId,
+	const float distance ) noexcept
+{
+	return ( ( ~quantizeDepth( distance ) & 0xFFFFFFull ) << 40 ) | ( ( shaderId & 0xFFFFFFull ) << 16 ) | ( textureId & 0xFFFFull );
+}
+
+void sortByKey( std::vector<SortEntry> &entries,
+	std::vector<SortEntry> &scratch )
+{
+	const std::size_t n = entries.size();
+	if ( n < s_radixSortThreshold )
+	{
+		// stable like the radix sort, so Jobs with equal keys keep their order frame to frame
+		std::stable_sort( entries.begin(), entries.end(),
+			[] ( const SortEntry &lhs, const SortEntry &rhs ) -> bool
+			{
+				return lhs.m_key < rhs.m_key;
+			} );
+		return;
+	}
+
+	// LSD radix sort, 8 passes of 8 bits; histograms for all passes are gathered in a single sweep
+	std::uint32_t histograms[8][256]{};
+	for ( const auto &entry : entries )
+	{
+		for ( unsigned pass = 0; pass < 8; ++pass )
+		{
+			++histograms[pass][( entry.m_key >> ( pass * 8 ) ) & 0xFFu];
+		}
+	}
+
+	scratch.resize( n );
+	SortEntry *pSrc = entries.data();
+	SortEntry *pDst = scratch.data();
+	for ( unsigned pass = 0; pass < 8; ++pass )
+	{
+		std::uint32_t *pHistogram = histograms[pass];
+		const unsigned shift = pass * 8;
+		// every key has the same byte here - the pass wouldn't reorder anything
+		if ( pHistogram[( pSrc[0].m_key >> shift ) & 0xFFu] == n )
+		{
+			continue;
+		}
+
+		std::uint32_t offset = 0u;
+		for ( unsigned bucket = 0; bucket < 256; ++bucket )
+		{
+			const std::uint32_t count = pHistogram[bucket];
+			pHistogram[bucket] = offset;
+			offset += count;
+		}
+		for ( std::size_t i = 0; i < n; ++i )
+		{
+			pDst[pHistogram[( pSrc[i].m_key >> shift ) & 0xFFu]++] = pSrc[i];
+		}
+		std::swap( pSrc, pDst );
+	}
+
+	if ( pSrc != entries.data() )
+	{
+		entries.swap( scratch );
+	}
+}
+
+
+}//namespace ren
\ No newline at end of file
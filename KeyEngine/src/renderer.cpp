@@ -24,6 +24,8 @@
 #include "pass_through.h"
 #include "pass_2d.h"
 #include "render_target_view.h"
+#include "command_list.h"
+#include "settings_manager.h"
 #ifndef FINAL_RELEASE
 #	include "imgui/imgui.h"
 #endif
@@ -34,9 +36,55 @@
 namespace ren
 {
 
+namespace
+{
+
+///=============================================================
+/// \class	GraphicsCommandListBackend
+/// \author	KeyC0de
+/// \date	2026/10/17 20:40
+/// \brief	records command lists on the Graphics' d3d11 deferred contexts
+///=============================================================
+class GraphicsCommandListBackend final
+	: public ICommandListBackend
+{
+	Graphics &m_gfx;
+public:
+	GraphicsCommandListBackend( Graphics &gfx )
+		:
+		m_gfx(gfx)
+	{
+
+	}
+
+	void reserve( const std::size_t nCommandLists ) override
+	{
+		m_gfx.reserveDeferredContexts( nCommandLists );
+	}
+
+	void beginRecording( const std::size_t index ) override
+	{
+		m_gfx.beginRecording( index );
+	}
+
+	void finishRecording( const std::size_t index ) override
+	{
+		m_gfx.finishRecording( index );
+	}
+
+	void execute( const std::size_t index ) override
+	{
+		m_gfx.executeCommandList( index );
+	}
+};
+
+}// namespace
+
 Renderer::Renderer( Graphics &gfx,
 	const bool drawToOffscreen )
 	:
+	m_pCommandListBackend{std::make_unique<GraphicsCommandListBackend>( gfx )},
+	m_pCommandListScheduler{std::make_unique<CommandListScheduler>( *m_pCommandListBackend, SettingsManager::getInstance().getSettings().nRenderingThreads )},
 	m_bUsesOffscreen{drawToOffscreen}
 {
 	recreate( gfx );
@@ -96,20 +144,28 @@ void Renderer::run( Graphics &gfx ) cond_noex
 		gfx.getDepthBufferFromBackBuffer()->clear( gfx );
 	}
 
-	for ( auto &pass : m_passes )
+	IConstantBufferEx::updateDirtyBuffers( gfx );
+	if ( SettingsManager::getInstance().getSettings().bMultithreadedRendering )
 	{
-		if ( pass->isActive() )
+		runPassesMultithreaded( gfx );
+	}
+	else
+	{
+		for ( auto &pass : m_passes )
 		{
-			pass->run( gfx );
+			if ( pass->isActive() )
+			{
+				pass->run( gfx );
 #if defined _DEBUG && !defined NDEBUG
-//			const auto *renderQueuePass = dynamic_cast<RenderQueuePass*>( pass.get() );
-//			if ( renderQueuePass != nullptr )
-//			{
-//				using namespace std::string_literals;
-//				KeyConsole &console = KeyConsole::getInstance();
-//				console.print( pass->getName() + " "s + std::to_string( renderQueuePass->getJobCount() ) + "\n"s );
-//			}
+//				const auto *renderQueuePass = dynamic_cast<RenderQueuePass*>( pass.get() );
+//				if ( renderQueuePass != nullptr )
+//				{
+//					using namespace std::string_literals;
+//					KeyConsole &console = KeyConsole::getInstance();
+//					console.print( pass->getName() + " "s + std::to_string( renderQueuePass->getJobCount() ) + "\n"s );
+//				}
 #endif
+			}
 		}
 	}
 
@@ -120,6 +176,32 @@ void Renderer::run( Graphics &gfx ) cond_noex
 	}
 }
 
+void Renderer::runPassesMultithreaded( Graphics &gfx ) cond_noex
+{
+	m_activePasses.clear();
+	for ( auto &pass : m_passes )
+	{
+		if ( pass->isActive() )
+		{
+			m_activePasses.push_back( pass.get() );
+		}
+	}
+
+	m_pCommandListScheduler->run( m_activePasses.size(),
+		[this] ( const std::size_t i ) -> bool
+		{
+			return m_activePasses[i]->isRecordable();
+		},
+		[this, &gfx] ( const std::size_t i ) -> void
+		{
+			m_activePasses[i]->run( gfx );
+		},
+		[this, &gfx] ( const std::size_t i ) -> void
+		{
+			m_activePasses[i]->bindSharedState( gfx );
+		} );
+}
+
 void Renderer::reset() noexcept
 {
 	ASSERT( m_bValidatedPasses, "Renderer is not validated!" );
@@ -547,7 +629,7 @@ void ren::Renderer3d::setActiveCamera( const Camera &cam )
 }
 
 void ren::Renderer3d::bindShadowCastingLights( Graphics &gfx,
-	const std::vector<ILightSource*> &shadowCastingLights )
+	const std::pmr::vector<ILightSource*> &shadowCastingLights )
 {
 	dynamic_cast<ShadowPass&>( getPass( "shadow" ) ).bindShadowCastingLights( gfx, shadowCastingLights );
 }
@@ -62,6 +62,7 @@ void SettingsManager::loadFromFile( const std::string &filePath )
 	m_settings.bAllowWindowResize = ini.GetBoolean( "Graphics", "bAllowWindowResize", false );
 	m_settings.bEnableFrustumCuling = ini.GetBoolean( "Graphics", "bEnableFrustumCuling", true );
 	m_settings.bEnableSmoothMovement = ini.GetBoolean( "Graphics", "bEnableSmoothMovement", true );
+	m_settings.bDoubleBufferedCpuFramebuffer = ini.GetBoolean( "Graphics", "bDoubleBufferedCpuFramebuffer", false );
 	m_settings.iPresentInterval = util::clamp( ini.GetInteger( "Graphics", "iPresentInterval", 1 ), 0l, 4l );
 	
 	m_settings.sSkyboxFileName = ini.Get( "Assets", "sSkyboxFileName", "" );
@@ -0,0 +1,575 @@
+#include "software_rasterizer.h"
+#include <cmath>
+#include <algorithm>
+#include <immintrin.h>
+#include "cpu_framebuffer.h"
+#include "bitmap.h"
+#include "rectangle.h"
+#include "thread_poolj.h"
+#include "assertions_console.h"
+
+
+namespace
+{
+
+/// \brief	the pixels of a command within a tile
+struct PixelRect final
+{
+	int left;
+	int top;
+	int right;
+	int bottom;
+};
+
+/// \brief	src over dst for 4 pixels, by each src pixel's alpha: rgb = src * a + dst * (1 - a) & alpha = a + dstAlpha * (1 - a)
+/// \brief	exact rounding division by 255, so an alpha of 0 leaves dst untouched & 255 replaces it
+__m128i blendOver( const __m128i src,
+	const __m128i dst ) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c255 = _mm_set1_epi16( 255 );
+	const __m128i c128 = _mm_set1_epi16( 128 );
+	// blending 255 instead of a in the alpha lanes gives a + dstAlpha * (1 - a)
+	const __m128i opaqueAlpha = _mm_setr_epi16( 0, 0, 0, 255, 0, 0, 0, 255 );
+	const auto blendHalf = [&] ( const __m128i s, const __m128i d ) -> __m128i
+		{
+			const __m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( s, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+			const __m128i t = _mm_add_epi16( _mm_add_epi16( _mm_mullo_epi16( _mm_or_si128( s, opaqueAlpha ), a ), _mm_mullo_epi16( d, _mm_sub_epi16( c255, a ) ) ), c128 );
+			return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+		};
+	return _mm_packus_epi16( blendHalf( _mm_unpacklo_epi8( src, zero ), _mm_unpacklo_epi8( dst, zero ) ),
+		blendHalf( _mm_unpackhi_epi8( src, zero ), _mm_unpackhi_epi8( dst, zero ) ) );
+}
+
+/// \brief	per channel multiplication of 4 pixels, rounded
+__m128i modulate( const __m128i a,
+	const __m128i b ) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c128 = _mm_set1_epi16( 128 );
+	const auto modulateHalf = [&] ( const __m128i x, const __m128i y ) -> __m128i
+		{
+			const __m128i t = _mm_add_epi16( _mm_mullo_epi16( x, y ), c128 );
+			return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+		};
+	return _mm_packus_epi16( modulateHalf( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ),
+		modulateHalf( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) ) );
+}
+
+__m128i select( const __m128i mask,
+	const __m128i a,
+	const __m128i b ) noexcept
+{
+	return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+/// \brief	calls shade( pixelCentersX, pixelCenterY, dst, inRect ) -> the new dst, for groups of 4 pixels of the row segments of rect
+/// \brief	groups are aligned to 4 pixels, never crossing the tile's right edge (a multiple of 4 unless it's the framebuffer's) so other tiles' pixels are never written
+/// \brief	inRect masks the pixels of a group within rect, the others must be returned unchanged
+template<typename TShade>
+void forEachPixelGroup( ColorBGRA *pPixels,
+	const unsigned width,
+	const PixelRect &rect,
+	const int tileRight,
+	const TShade &shade ) noexcept
+{
+	const __m128 laneOffsets = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+	const __m128i lanes = _mm_setr_epi32( 0, 1, 2, 3 );
+	const __m128i left = _mm_set1_epi32( rect.left - 1 );
+	const __m128i right = _mm_set1_epi32( rect.right );
+	for ( int y = rect.top; y < rect.bottom; ++y )
+	{
+		const float pixelY = float( y ) + 0.5f;
+		ColorBGRA *pRow = pPixels + static_cast<std::size_t>( y ) * width;
+		int x = rect.left & ~3;
+		for ( ; x < rect.right && x + 4 <= tileRight; x += 4 )
+		{
+			const __m128i xs = _mm_add_epi32( _mm_set1_epi32( x ), lanes );
+			const __m128i inRect = _mm_and_si128( _mm_cmpgt_epi32( xs, left ), _mm_cmplt_epi32( xs, right ) );
+			__m128i *p = reinterpret_cast<__m128i*>( pRow + x );
+			_mm_storeu_si128( p, shade( _mm_add_ps( _mm_set1_ps( float( x ) ), laneOffsets ), pixelY, _mm_loadu_si128( p ), inRect ) );
+		}
+		// the framebuffer's right edge, if its width isn't a multiple of 4
+		for ( x = std::max( x, rect.left ); x < rect.right; ++x )
+		{
+			const __m128i result = shade( _mm_set1_ps( float( x ) + 0.5f ), pixelY, _mm_cvtsi32_si128( static_cast<int>( pRow[x].m_dword ) ), _mm_setr_epi32( -1, 0, 0, 0 ) );
+			pRow[x].m_dword = static_cast<unsigned>( _mm_cvtsi128_si32( result ) );
+		}
+	}
+}
+
+/// \brief	the shading of solid primitives from their coverage
+struct SolidPaint final
+{
+	__m128i color;		// without alpha
+	__m128 alpha;		// the color's alpha for BlendMode::Alpha, otherwise 255
+	bool bReplace;		// opaque & aliased: covered pixels are replaced by the color
+
+	SolidPaint( const ColorBGRA color,
+		const SoftwareRasterizer::BlendMode blend,
+		const bool bAntiAliased ) noexcept
+		:
+		color{_mm_set1_epi32( static_cast<int>( color.m_dword & 0x00FFFFFFu ) )},
+		alpha{_mm_set1_ps( blend == SoftwareRasterizer::BlendMode::Alpha ? float( color.getAlpha() ) : 255.0f )},
+		bReplace{blend == SoftwareRasterizer::BlendMode::Opaque && !bAntiAliased}
+	{
+		if ( bReplace )
+		{
+			this->color = _mm_set1_epi32( static_cast<int>( color.m_dword ) );
+		}
+	}
+
+	/// \brief	covered: the aliased coverage mask
+	__m128i apply( const __m128i dst,
+		const __m128i covered ) const noexcept
+	{
+		if ( bReplace )
+		{
+			return select( covered, color, dst );
+		}
+		return apply( dst, _mm_and_ps( _mm_castsi128_ps( covered ), _mm_set1_ps( 1.0f ) ) );
+	}
+
+	/// \brief	coverage in [0,1]
+	__m128i apply( const __m128i dst,
+		const __m128 coverage ) const noexcept
+	{
+		const __m128i alphas = _mm_slli_epi32( _mm_cvtps_epi32( _mm_mul_ps( coverage, alpha ) ), 24 );
+		return blendOver( _mm_or_si128( color, alphas ), dst );
+	}
+};
+
+__m128 saturate( const __m128 v ) noexcept
+{
+	return _mm_min_ps( _mm_max_ps( v, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+}
+
+
+}//namespace
+
+SoftwareRasterizer::SoftwareRasterizer( CpuFramebuffer &framebuffer )
+	:
+	m_framebuffer{framebuffer}
+{
+
+}
+
+void SoftwareRasterizer::fillRect( const float left,
+	const float top,
+	const float right,
+	const float bottom,
+	const ColorBGRA color,
+	const BlendMode blend /*= BlendMode::Opaque*/,
+	const bool bAntiAliased /*= false*/ )
+{
+	Command command{CommandType::Rect, blend, bAntiAliased, color, {}, {left, top, right, bottom}, nullptr};
+	queue( command, left, top, right, bottom );
+}
+
+void SoftwareRasterizer::fillRect( const RectangleF &rect,
+	const ColorBGRA color,
+	const BlendMode blend /*= BlendMode::Opaque*/,
+	const bool bAntiAliased /*= false*/ )
+{
+	fillRect( rect.getLeft(), rect.getTop(), rect.getRight(), rect.getBottom(), color, blend, bAntiAliased );
+}
+
+void SoftwareRasterizer::fillTriangle( const float x0,
+	const float y0,
+	const float x1,
+	const float y1,
+	const float x2,
+	const float y2,
+	const ColorBGRA color,
+	const BlendMode blend /*= BlendMode::Opaque*/,
+	const bool bAntiAliased /*= false*/ )
+{
+	if ( ( x1 - x0 ) * ( y2 - y0 ) - ( y1 - y0 ) * ( x2 - x0 ) == 0.0f )
+	{
+		return;
+	}
+	Command command{CommandType::Triangle, blend, bAntiAliased, color, {}, {x0, y0, x1, y1, x2, y2}, nullptr};
+	queue( command, std::min( {x0, x1, x2} ), std::min( {y0, y1, y2} ), std::max( {x0, x1, x2} ), std::max( {y0, y1, y2} ) );
+}
+
+void SoftwareRasterizer::fillCircle( const float centerX,
+	const float centerY,
+	const float radius,
+	const ColorBGRA color,
+	const BlendMode blend /*= BlendMode::Opaque*/,
+	const bool bAntiAliased /*= false*/ )
+{
+	Command command{CommandType::Circle, blend, bAntiAliased, color, {}, {centerX, centerY, radius}, nullptr};
+	queue( command, centerX - radius, centerY - radius, centerX + radius, centerY + radius );
+}
+
+void SoftwareRasterizer::drawLine( const float x0,
+	const float y0,
+	const float x1,
+	const float y1,
+	const ColorBGRA color,
+	const float width /*= 1.0f*/,
+	const BlendMode blend /*= BlendMode::Opaque*/,
+	const bool bAntiAliased /*= false*/ )
+{
+	const float halfWidth = width * 0.5f;
+	Command command{CommandType::Line, blend, bAntiAliased, color, {}, {x0, y0, x1, y1, halfWidth}, nullptr};
+	queue( command, std::min( x0, x1 ) - halfWidth, std::min( y0, y1 ) - halfWidth, std::max( x0, x1 ) + halfWidth, std::max( y0, y1 ) + halfWidth );
+}
+
+void SoftwareRasterizer::drawSprite( const Bitmap &bitmap,
+	const float left,
+	const float top,
+	const float right,
+	const float bottom,
+	const BlendMode blend /*= BlendMode::Alpha*/,
+	const ColorBGRA tint /*= ColorBGRA{255, 255, 255, 255}*/ )
+{
+	drawSprite( bitmap, 0u, 0u, bitmap.getWidth(), bitmap.getHeight(), left, top, right, bottom, blend, tint );
+}
+
+void SoftwareRasterizer::drawSprite( const Bitmap &bitmap,
+	const unsigned srcLeft,
+	const unsigned srcTop,
+	const unsigned srcWidth,
+	const unsigned srcHeight,
+	const float left,
+	const float top,
+	const float right,
+	const float bottom,
+	const BlendMode blend /*= BlendMode::Alpha*/,
+	const ColorBGRA tint /*= ColorBGRA{255, 255, 255, 255}*/ )
+{
+	ASSERT( srcWidth > 0 && srcHeight > 0 && srcLeft + srcWidth <= bitmap.getWidth() && srcTop + srcHeight <= bitmap.getHeight(), "Sprite source rect out of its Bitmap!" );
+	if ( right <= left || bottom <= top )
+	{
+		return;
+	}
+	Command command{CommandType::Sprite, blend, false, tint, {}, {left, top, right, bottom, float( srcLeft ), float( srcTop ), float( srcWidth ), float( srcHeight )}, &bitmap};
+	queue( command, left, top, right, bottom );
+}
+
+void SoftwareRasterizer::flush()
+{
+	if ( m_commands.empty() )
+	{
+		return;
+	}
+
+	// bin the commands into tiles, in submission order: count, prefix sum, then fill
+	const unsigned nTilesX = m_framebuffer.getTileCountX();
+	const unsigned nTiles = nTilesX * m_framebuffer.getTileCountY();
+	constexpr unsigned tileSize = CpuFramebuffer::s_tileSize;
+	m_tileCommandOffsets.assign( nTiles + 1, 0u );
+	for ( const Command &command : m_commands )
+	{
+		for ( int ty = command.bounds[1] / tileSize; ty <= ( command.bounds[3] - 1 ) / static_cast<int>( tileSize ); ++ty )
+		{
+			for ( int tx = command.bounds[0] / tileSize; tx <= ( command.bounds[2] - 1 ) / static_cast<int>( tileSize ); ++tx )
+			{
+				++m_tileCommandOffsets[ty * nTilesX + tx + 1];
+			}
+		}
+		m_framebuffer.markDirty( CpuFramebuffer::Rect{static_cast<unsigned>( command.bounds[0] ), static_cast<unsigned>( command.bounds[1] ), static_cast<unsigned>( command.bounds[2] ), static_cast<unsigned>( command.bounds[3] )} );
+	}
+	m_activeTiles.clear();
+	for ( unsigned i = 0; i < nTiles; ++i )
+	{
+		if ( m_tileCommandOffsets[i + 1] > 0 )
+		{
+			m_activeTiles.push_back( i );
+		}
+		m_tileCommandOffsets[i + 1] += m_tileCommandOffsets[i];
+	}
+	m_tileCommands.resize( m_tileCommandOffsets[nTiles] );
+	{
+		std::vector<std::uint32_t> cursors( m_tileCommandOffsets.begin(), m_tileCommandOffsets.end() - 1 );
+		for ( std::uint32_t i = 0; i < m_commands.size(); ++i )
+		{
+			const Command &command = m_commands[i];
+			for ( int ty = command.bounds[1] / tileSize; ty <= ( command.bounds[3] - 1 ) / static_cast<int>( tileSize ); ++ty )
+			{
+				for ( int tx = command.bounds[0] / tileSize; tx <= ( command.bounds[2] - 1 ) / static_cast<int>( tileSize ); ++tx )
+				{
+					m_tileCommands[cursors[ty * nTilesX + tx]++] = i;
+				}
+			}
+		}
+	}
+
+	// tiles don't share pixels, so they're rasterized without synchronization
+	ThreadPoolJ::getInstance().parallelFor( 0u, m_activeTiles.size(), 1u,
+		[this] ( const std::size_t first, const std::size_t last )
+		{
+			for ( std::size_t i = first; i < last; ++i )
+			{
+				rasterizeTile( m_activeTiles[i] );
+			}
+		} );
+	m_commands.clear();
+}
+
+std::size_t SoftwareRasterizer::getQueuedCount() const noexcept
+{
+	return m_commands.size();
+}
+
+void SoftwareRasterizer::queue( Command &command,
+	const float left,
+	const float top,
+	const float right,
+	const float bottom )
+{
+	// NaN bounds don't convert to ints & infinities or NaNs in the params poison the kernels' math
+	if ( !std::all_of( std::begin( command.params ), std::end( command.params ),
+		[] ( const float param )
+		{
+			return std::isfinite( param );
+		} ) )
+	{
+		return;
+	}
+	// aliased primitives cover the pixels whose centers they contain, anti-aliased ones also those their 1 pixel ramp touches
+	const bool bRamp = command.bAntiAliased;
+	const float l = bRamp ? std::floor( left - 0.5f ) : std::ceil( left - 0.5f );
+	const float t = bRamp ? std::floor( top - 0.5f ) : std::ceil( top - 0.5f );
+	const float r = bRamp ? std::ceil( right + 0.5f ) : std::ceil( right - 0.5f ) + ( command.type == CommandType::Rect || command.type == CommandType::Sprite ? 0.0f : 1.0f );
+	const float b = bRamp ? std::ceil( bottom + 0.5f ) : std::ceil( bottom - 0.5f ) + ( command.type == CommandType::Rect || command.type == CommandType::Sprite ? 0.0f : 1.0f );
+	const float width = float( m_framebuffer.getWidth() );
+	const float height = float( m_framebuffer.getHeight() );
+	command.bounds[0] = static_cast<int>( std::clamp( l, 0.0f, width ) );
+	command.bounds[1] = static_cast<int>( std::clamp( t, 0.0f, height ) );
+	command.bounds[2] = static_cast<int>( std::clamp( r, 0.0f, width ) );
+	command.bounds[3] = static_cast<int>( std::clamp( b, 0.0f, height ) );
+	if ( command.bounds[0] < command.bounds[2] && command.bounds[1] < command.bounds[3] )
+	{
+		m_commands.push_back( command );
+	}
+}
+
+void SoftwareRasterizer::rasterizeTile( const unsigned tileIndex ) const noexcept
+{
+	constexpr int tileSize = static_cast<int>( CpuFramebuffer::s_tileSize );
+	const unsigned width = m_framebuffer.getWidth();
+	const int tileLeft = static_cast<int>( tileIndex % m_framebuffer.getTileCountX() ) * tileSize;
+	const int tileTop = static_cast<int>( tileIndex / m_framebuffer.getTileCountX() ) * tileSize;
+	const int tileRight = std::min( tileLeft + tileSize, static_cast<int>( width ) );
+	const int tileBottom = std::min( tileTop + tileSize, static_cast<int>( m_framebuffer.getHeight() ) );
+	ColorBGRA *pPixels = m_framebuffer.getBackBuffer();
+
+	for ( std::uint32_t i = m_tileCommandOffsets[tileIndex]; i < m_tileCommandOffsets[tileIndex + 1]; ++i )
+	{
+		const Command &command = m_commands[m_tileCommands[i]];
+		const PixelRect rect{std::max( command.bounds[0], tileLeft ), std::max( command.bounds[1], tileTop ), std::min( command.bounds[2], tileRight ), std::min( command.bounds[3], tileBottom )};
+		const float *p = command.params;
+		switch ( command.type )
+		{
+		case CommandType::Rect:
+		{
+			const SolidPaint paint{command.color, command.blend, command.bAntiAliased};
+			if ( !command.bAntiAliased )
+			{
+				// the bounds are exactly the covered pixels
+				forEachPixelGroup( pPixels, width, rect, tileRight,
+					[&paint] ( const __m128, const float, const __m128i dst, const __m128i inRect )
+					{
+						return paint.apply( dst, inRect );
+					} );
+				break;
+			}
+			// the area of each pixel inside the rect
+			const __m128 left = _mm_set1_ps( p[0] );
+			const __m128 right = _mm_set1_ps( p[2] );
+			const __m128 half = _mm_set1_ps( 0.5f );
+			forEachPixelGroup( pPixels, width, rect, tileRight,
+				[&] ( const __m128 px, const float py, const __m128i dst, const __m128i inRect )
+				{
+					const float coverageY = std::clamp( std::min( py + 0.5f, p[3] ) - std::max( py - 0.5f, p[1] ), 0.0f, 1.0f );
+					const __m128 coverageX = saturate( _mm_sub_ps( _mm_min_ps( _mm_add_ps( px, half ), right ), _mm_max_ps( _mm_sub_ps( px, half ), left ) ) );
+					const __m128 coverage = _mm_and_ps( _mm_mul_ps( coverageX, _mm_set1_ps( coverageY ) ), _mm_castsi128_ps( inRect ) );
+					return paint.apply( dst, coverage );
+				} );
+			break;
+		}
+		case CommandType::Triangle:
+		{
+			const SolidPaint paint{command.color, command.blend, command.bAntiAliased};
+			if ( command.bAntiAliased )
+			{
+				// edge distances a * x + b * y + c, positive inside whatever the winding
+				const float orientation = ( p[2] - p[0] ) * ( p[5] - p[1] ) - ( p[3] - p[1] ) * ( p[4] - p[0] ) < 0.0f ?
+					-1.0f :
+					1.0f;
+				__m128 edgeA[3];
+				float edgeB[3];
+				float edgeC[3];
+				for ( int e = 0; e < 3; ++e )
+				{
+					const float *v0 = p + 2 * e;
+					const float *v1 = p + 2 * ( ( e + 1 ) % 3 );
+					const float a = v0[1] - v1[1];
+					const float b = v1[0] - v0[0];
+					const float scale = orientation / std::sqrt( a * a + b * b );
+					edgeA[e] = _mm_set1_ps( a * scale );
+					edgeB[e] = b * scale;
+					edgeC[e] = -( a * v0[0] + b * v0[1] ) * scale;
+				}
+				forEachPixelGroup( pPixels, width, rect, tileRight,
+					[&] ( const __m128 px, const float py, const __m128i dst, const __m128i inRect )
+					{
+						__m128 distance = _mm_add_ps( _mm_mul_ps( edgeA[0], px ), _mm_set1_ps( edgeB[0] * py + edgeC[0] ) );
+						for ( int e = 1; e < 3; ++e )
+						{
+							distance = _mm_min_ps( distance, _mm_add_ps( _mm_mul_ps( edgeA[e], px ), _mm_set1_ps( edgeB[e] * py + edgeC[e] ) ) );
+						}
+						const __m128 coverage = _mm_and_ps( saturate( _mm_add_ps( distance, _mm_set1_ps( 0.5f ) ) ), _mm_castsi128_ps( inRect ) );
+						return paint.apply( dst, coverage );
+					} );
+				break;
+			}
+
+			// exact edge functions a * ( x - x0 ) + b * ( y - y0 ): doubles on vertices snapped to 1/256 pixel
+			// an edge shared by 2 triangles gives exactly opposite values in each, so with the top-left rule no pixel is drawn twice or missed
+			double x[3];
+			double y[3];
+			for ( int v = 0; v < 3; ++v )
+			{
+				x[v] = std::round( p[2 * v] * 256.0 ) / 256.0;
+				y[v] = std::round( p[2 * v + 1] * 256.0 ) / 256.0;
+			}
+			const double area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( y[1] - y[0] ) * ( x[2] - x[0] );
+			if ( area == 0.0 )
+			{
+				break;
+			}
+			__m128d edgeA[3];
+			__m128d edgeX0[3];
+			__m128d topLeft[3];
+			double edgeB[3];
+			for ( int e = 0; e < 3; ++e )
+			{
+				const int f = ( e + 1 ) % 3;
+				const double a = area < 0.0 ? y[f] - y[e] : y[e] - y[f];
+				const double b = area < 0.0 ? x[e] - x[f] : x[f] - x[e];
+				edgeA[e] = _mm_set1_pd( a );
+				edgeX0[e] = _mm_set1_pd( x[e] );
+				edgeB[e] = b;
+				// pixel centers exactly on a left edge, or a top edge, belong to this triangle
+				topLeft[e] = _mm_castsi128_pd( _mm_set1_epi32( a > 0.0 || ( a == 0.0 && b > 0.0 ) ? -1 : 0 ) );
+			}
+			forEachPixelGroup( pPixels, width, rect, tileRight,
+				[&] ( const __m128 px, const float py, const __m128i dst, const __m128i inRect )
+				{
+					const __m128d zero = _mm_setzero_pd();
+					const __m128d pxLo = _mm_cvtps_pd( px );
+					const __m128d pxHi = _mm_cvtps_pd( _mm_movehl_ps( px, px ) );
+					__m128i covered = inRect;
+					for ( int e = 0; e < 3; ++e )
+					{
+						const __m128d rowTerm = _mm_set1_pd( edgeB[e] * ( py - y[e] ) );
+						const __m128d edgeLo = _mm_add_pd( _mm_mul_pd( edgeA[e], _mm_sub_pd( pxLo, edgeX0[e] ) ), rowTerm );
+						const __m128d edgeHi = _mm_add_pd( _mm_mul_pd( edgeA[e], _mm_sub_pd( pxHi, edgeX0[e] ) ), rowTerm );
+						const __m128d insideLo = _mm_or_pd( _mm_cmpgt_pd( edgeLo, zero ), _mm_and_pd( _mm_cmpeq_pd( edgeLo, zero ), topLeft[e] ) );
+						const __m128d insideHi = _mm_or_pd( _mm_cmpgt_pd( edgeHi, zero ), _mm_and_pd( _mm_cmpeq_pd( edgeHi, zero ), topLeft[e] ) );
+						// the 64bit masks to 32bit ones
+						covered = _mm_and_si128( covered, _mm_castps_si128( _mm_shuffle_ps( _mm_castpd_ps( insideLo ), _mm_castpd_ps( insideHi ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) ) );
+					}
+					return paint.apply( dst, covered );
+				} );
+			break;
+		}
+		case CommandType::Circle:
+		{
+			const __m128 centerX = _mm_set1_ps( p[0] );
+			const __m128 radius = _mm_set1_ps( p[2] );
+			const SolidPaint paint{command.color, command.blend, command.bAntiAliased};
+			const bool bAntiAliased = command.bAntiAliased;
+			forEachPixelGroup( pPixels, width, rect, tileRight,
+				[&] ( const __m128 px, const float py, const __m128i dst, const __m128i inRect )
+				{
+					const __m128 dx = _mm_sub_ps( px, centerX );
+					const float dy = py - p[1];
+					const __m128 distanceSq = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_set1_ps( dy * dy ) );
+					if ( bAntiAliased )
+					{
+						const __m128 coverage = saturate( _mm_sub_ps( _mm_add_ps( radius, _mm_set1_ps( 0.5f ) ), _mm_sqrt_ps( distanceSq ) ) );
+						return paint.apply( dst, _mm_and_ps( coverage, _mm_castsi128_ps( inRect ) ) );
+					}
+					return paint.apply( dst, _mm_and_si128( inRect, _mm_castps_si128( _mm_cmple_ps( distanceSq, _mm_mul_ps( radius, radius ) ) ) ) );
+				} );
+			break;
+		}
+		case CommandType::Line:
+		{
+			// distance to the segment, the pixel's projection on it clamped to its end points
+			const float abX = p[2] - p[0];
+			const float abY = p[3] - p[1];
+			const float lengthSq = abX * abX + abY * abY;
+			const __m128 invLengthSq = _mm_set1_ps( lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f );
+			const __m128 startX = _mm_set1_ps( p[0] );
+			const __m128 dirX = _mm_set1_ps( abX );
+			const __m128 halfWidth = _mm_set1_ps( p[4] );
+			const SolidPaint paint{command.color, command.blend, command.bAntiAliased};
+			const bool bAntiAliased = command.bAntiAliased;
+			forEachPixelGroup( pPixels, width, rect, tileRight,
+				[&] ( const __m128 px, const float py, const __m128i dst, const __m128i inRect )
+				{
+					const __m128 apX = _mm_sub_ps( px, startX );
+					const __m128 apY = _mm_set1_ps( py - p[1] );
+					const __m128 dirY = _mm_set1_ps( abY );
+					const __m128 t = saturate( _mm_mul_ps( _mm_add_ps( _mm_mul_ps( apX, dirX ), _mm_mul_ps( apY, dirY ) ), invLengthSq ) );
+					const __m128 dx = _mm_sub_ps( apX, _mm_mul_ps( t, dirX ) );
+					const __m128 dy = _mm_sub_ps( apY, _mm_mul_ps( t, dirY ) );
+					const __m128 distance = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ) );
+					if ( bAntiAliased )
+					{
+						const __m128 coverage = saturate( _mm_sub_ps( _mm_add_ps( halfWidth, _mm_set1_ps( 0.5f ) ), distance ) );
+						return paint.apply( dst, _mm_and_ps( coverage, _mm_castsi128_ps( inRect ) ) );
+					}
+					return paint.apply( dst, _mm_and_si128( inRect, _mm_castps_si128( _mm_cmple_ps( distance, halfWidth ) ) ) );
+				} );
+			break;
+		}
+		case CommandType::Sprite:
+		{
+			const Bitmap &bitmap = *command.pBitmap;
+			const ColorBGRA *pTexels = bitmap.getData();
+			const unsigned texelPitch = bitmap.getPitch() / sizeof( ColorBGRA );
+			const int srcLeft = static_cast<int>( p[4] );
+			const int srcTop = static_cast<int>( p[5] );
+			const int srcRight = srcLeft + static_cast<int>( p[6] ) - 1;
+			const int srcBottom = srcTop + static_cast<int>( p[7] ) - 1;
+			const float scaleX = p[6] / ( p[2] - p[0] );
+			const float scaleY = p[7] / ( p[3] - p[1] );
+			const __m128 offsetX = _mm_set1_ps( p[4] - p[0] * scaleX );
+			const __m128 texelsPerPixel = _mm_set1_ps( scaleX );
+			const bool bTinted = command.color.m_dword != 0xFFFFFFFFu;
+			const __m128i tint = _mm_set1_epi32( static_cast<int>( command.color.m_dword ) );
+			const bool bBlend = command.blend == BlendMode::Alpha;
+			forEachPixelGroup( pPixels, width, rect, tileRight,
+				[&] ( const __m128 px, const float py, const __m128i dst, const __m128i inRect )
+				{
+					const int v = std::min( static_cast<int>( p[5] + ( py - p[1] ) * scaleY ), srcBottom );
+					const ColorBGRA *pRow = pTexels + static_cast<std::size_t>( v ) * texelPitch;
+					alignas( 16 ) int us[4];
+					_mm_store_si128( reinterpret_cast<__m128i*>( us ), _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( px, texelsPerPixel ), offsetX ) ) );
+					__m128i texels = _mm_setr_epi32( static_cast<int>( pRow[std::clamp( us[0], srcLeft, srcRight )].m_dword ),
+						static_cast<int>( pRow[std::clamp( us[1], srcLeft, srcRight )].m_dword ),
+						static_cast<int>( pRow[std::clamp( us[2], srcLeft, srcRight )].m_dword ),
+						static_cast<int>( pRow[std::clamp( us[3], srcLeft, srcRight )].m_dword ) );
+					if ( bTinted )
+					{
+						texels = modulate( texels, tint );
+					}
+					if ( bBlend )
+					{
+						// zero alpha leaves the pixels outside the rect untouched
+						return blendOver( _mm_and_si128( texels, inRect ), dst );
+					}
+					return select( inRect, texels, dst );
+				} );
+			break;
+		}
+		}
+	}
+}
\ No newline at end of file
@@ -18,6 +18,8 @@
 #include "math_utils.h"
 #include "d3d_utils.h"
 #include "global_constants.h"
+#include "node.h"
+#include "settings_manager.h"
 
 
 namespace dx = DirectX;
@@ -41,8 +43,11 @@ Terrain::Terrain( Graphics &gfx,
 		diffuseTexturePath = std::get<std::string>( colorOrTexturePath );
 	}
 
-	const int lengthVerts = util::ceil( length ) * 2;
-	const int widthVerts = util::ceil( width ) * 2;
+	// whole chunks only
+	const int nChunksX = std::max( ( util::ceil( length ) * 2 + s_chunkQuads - 1 ) / s_chunkQuads, 1 );
+	const int nChunksY = std::max( ( util::ceil( width ) * 2 + s_chunkQuads - 1 ) / s_chunkQuads, 1 );
+	const int lengthVerts = nChunksX * s_chunkQuads;
+	const int widthVerts = nChunksY * s_chunkQuads;
 
 	auto planarGrid = heightMapfilename.empty() ?
 		geometry::makePlanarGridTextured( length, width, lengthVerts, widthVerts ) :
@@ -53,17 +58,44 @@ Terrain::Terrain( Graphics &gfx,
 		planarGrid.transform( dx::XMMatrixScaling( initialScale, initialScale, initialScale ) );
 	}
 
+	using Type = ver::VertexInputLayout::ILEementType;
+	const std::size_t nVerticesX = static_cast<std::size_t>( lengthVerts ) + 1;
+	{
+		std::vector<float> heights( planarGrid.m_vb.getVertexCount() );
+		for ( std::size_t i = 0; i < heights.size(); ++i )
+		{
+			heights[i] = planarGrid.m_vb[i].getElement<Type::Position3D>().z;
+		}
+		const auto &origin = planarGrid.m_vb[0].getElement<Type::Position3D>();
+		const auto &diagonal = planarGrid.m_vb[nVerticesX + 1].getElement<Type::Position3D>();
+		m_pQuadtree = std::make_unique<TerrainQuadtree>( heights.data(), nChunksX, nChunksY, s_chunkQuads, s_nLods, origin.x, origin.y, diagonal.x - origin.x, diagonal.y - origin.y );
+	}
+
+	// one vertex block per chunk, neighbouring blocks duplicate the vertices of their shared edge
+	ver::VBuffer chunkedVb{planarGrid.m_vb.getLayout()};
+	for ( const auto &chunk : m_pQuadtree->getChunks() )
+	{
+		for ( int j = 0; j <= s_chunkQuads; ++j )
+		{
+			for ( int i = 0; i <= s_chunkQuads; ++i )
+			{
+				auto vertex = planarGrid.m_vb[( chunk.y * s_chunkQuads + j ) * nVerticesX + chunk.x * s_chunkQuads + i];
+				chunkedVb.emplaceVertex( vertex.getElement<Type::Position3D>(), vertex.getElement<Type::Normal>(), vertex.getElement<Type::Texture2D>() );
+			}
+		}
+	}
+
 	{
 		using namespace std::string_literals;
-		const auto geometryTag = s_geometryTag + "#len"s + std::to_string( length ) + "#wid"s + std::to_string( width ) + "#scale"s + std::to_string( (int)initialScale );
+		const auto geometryTag = s_geometryTag + "#len"s + std::to_string( length ) + "#wid"s + std::to_string( width ) + "#scale"s + std::to_string( (int)initialScale ) + "#chunk"s + std::to_string( s_chunkQuads );
 
-		m_pVertexBuffer = VertexBuffer::fetch( gfx, geometryTag, planarGrid.m_vb );
-		m_pIndexBuffer = IndexBuffer::fetch( gfx, geometryTag, planarGrid.m_indices );
+		m_pVertexBuffer = VertexBuffer::fetch( gfx, geometryTag, chunkedVb );
+		m_pIndexBuffer = IndexBuffer::fetch( gfx, geometryTag, m_pQuadtree->getIndices() );
 		m_pPrimitiveTopology = PrimitiveTopology::fetch( gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
 		m_pTransformVscb = std::make_unique<TransformVSCB>( gfx, g_modelVscbSlot, *this );
 	}
 
-	createAabb( planarGrid.m_vb );
+	createAabb( chunkedVb );
 	setMeshId();
 
 	{// opaque reflectance material
@@ -83,11 +115,14 @@ Terrain::Terrain( Graphics &gfx,
 		}
 		else
 		{
-			auto lightenTexture = [] ( Bitmap::Texel col ) -> dx::XMVECTOR
+			auto lightenTexture = [] ( const TexelSpan &span ) -> void
 				{
-					const auto v = Bitmap::colorToVector( col );
-					const auto lighter = dx::XMVectorReplicate( 1.2f );
-					return dx::XMVectorMultiply( v, lighter );
+					for ( unsigned i = 0; i < span.count; ++i )
+					{
+						span.r[i] *= 1.2f;
+						span.g[i] *= 1.2f;
+						span.b[i] *= 1.2f;
+					}
 				};
 
 			opaque.addBindable( Texture::fetch( gfx, diffuseTexturePath, 0u, lightenTexture ) );
@@ -158,6 +193,66 @@ Terrain::Terrain( Graphics &gfx,
 	}
 }
 
+void Terrain::draw( Graphics &gfx ) const cond_noex
+{
+	// passes can be recorded on several threads at once, each thread keeps its own selection
+	static thread_local TerrainQuadtree::SelectionResult s_selection;
+	std::array<dx::XMFLOAT4, 6> localPlanes;
+	m_pQuadtree->select( makeSelectionParams( gfx, localPlanes ), s_selection );
+
+	const int nChunkVertices = static_cast<int>( m_pQuadtree->getChunkVertexCount() );
+	for ( const auto &chunk : s_selection.selection )
+	{
+		const auto &range = m_pQuadtree->getIndexRange( chunk.lod, chunk.stitchMask );
+		gfx.drawIndexed( range.nIndices, range.startIndex, static_cast<int>( chunk.chunk ) * nChunkVertices );
+	}
+}
+
+const TerrainQuadtree& Terrain::getQuadtree() const noexcept
+{
+	return *m_pQuadtree;
+}
+
+TerrainQuadtree::SelectionParams Terrain::makeSelectionParams( const Graphics &gfx,
+	std::array<DirectX::XMFLOAT4, 6> &localPlanes ) const noexcept
+{
+	const dx::XMMATRIX worldView = m_pNode->getWorldTransform() * gfx.getViewMatrix();
+	dx::XMFLOAT4X4 projection;
+	dx::XMStoreFloat4x4( &projection, gfx.getProjectionMatrix() );
+
+	TerrainQuadtree::SelectionParams params;
+	// the eye is the origin of view space
+	dx::XMStoreFloat3( &params.viewPosition, dx::XMMatrixInverse( nullptr, worldView ).r[3] );
+	// _22 is 1 / tan( fovY / 2 ) for perspective & 2 / viewHeight for orthographic projections
+	//	shadow maps are taken to have about the resolution of the back buffer
+	params.projectionScale = 0.5f * static_cast<float>( gfx.getClientHeight() ) * projection._22;
+	params.maxPixelError = s_maxPixelError;
+	params.bOrthographic = projection._34 == 0.0f;
+
+	if ( SettingsManager::getInstance().getSettings().bEnableFrustumCuling )
+	{
+		// the planes of the clip space cube, in the Terrain's local space: left, right, top, bottom, near, far
+		dx::XMFLOAT4X4 m;
+		dx::XMStoreFloat4x4( &m, worldView * gfx.getProjectionMatrix() );
+		localPlanes = {dx::XMFLOAT4{m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41},
+			dx::XMFLOAT4{m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41},
+			dx::XMFLOAT4{m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42},
+			dx::XMFLOAT4{m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42},
+			dx::XMFLOAT4{m._13, m._23, m._33, m._43},
+			dx::XMFLOAT4{m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43}};
+		for ( auto &plane : localPlanes )
+		{
+			const float length = std::sqrt( plane.x * plane.x + plane.y * plane.y + plane.z * plane.z );
+			// eg. the far plane of an infinite projection, which culls nothing
+			plane = length > 0.0f ?
+				dx::XMFLOAT4{plane.x / length, plane.y / length, plane.z / length, plane.w / length} :
+				dx::XMFLOAT4{0.0f, 0.0f, 0.0f, 1.0f};
+		}
+		params.pFrustumPlanes = localPlanes.data();
+	}
+	return params;
+}
+
 void Terrain::transformVerticesPosition( ver::VBuffer &vb,
 	const DirectX::XMMATRIX &matrix ) noexcept
 {
@@ -0,0 +1,401 @@
+#include "terrain_quadtree.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include "frustum_culler.h"
+#include "assertions_console.h"
+
+
+TerrainQuadtree::TerrainQuadtree( const float *heights,
+	const unsigned nChunksX,
+	const unsigned nChunksY,
+	const unsigned chunkQuads,
+	const unsigned nLods,
+	const float x0,
+	const float y0,
+	const float dx,
+	const float dy )
+	:
+	m_nChunksX{nChunksX},
+	m_nChunksY{nChunksY},
+	m_chunkQuads{chunkQuads},
+	m_nLods{nLods}
+{
+	ASSERT( nChunksX > 0 && nChunksY > 0, "Empty terrain!" );
+	ASSERT( chunkQuads > 0 && ( chunkQuads & ( chunkQuads - 1 ) ) == 0, "Chunk size must be a power of 2!" );
+	ASSERT( nLods > 0 && nLods <= s_maxLods && ( chunkQuads >> ( nLods - 1 ) ) > 0, "Too many LODs for the chunk size!" );
+
+	m_chunks.reserve( static_cast<std::size_t>( nChunksX ) * nChunksY );
+	for ( unsigned cy = 0; cy < nChunksY; ++cy )
+	{
+		for ( unsigned cx = 0; cx < nChunksX; ++cx )
+		{
+			computeChunk( heights, cx, cy, x0, y0, dx, dy );
+		}
+	}
+
+	m_nodes.push_back( {} );
+	buildNode( 0u, 0u, 0u, nChunksX, nChunksY );
+	buildIndices();
+	m_lastSelection.lods.resize( m_chunks.size() );
+	m_lastSelection.selection.reserve( m_chunks.size() );
+}
+
+const std::vector<TerrainQuadtree::Selection>& TerrainQuadtree::select( const SelectionParams &params )
+{
+	select( params, m_lastSelection );
+	return m_lastSelection.selection;
+}
+
+void TerrainQuadtree::select( const SelectionParams &params,
+	SelectionResult &result ) const
+{
+	std::vector<unsigned> &lods = result.lods;
+	lods.resize( m_chunks.size() );
+	// the coarsest LOD whose error covers at most maxPixelError pixels at the distance of the chunk's closest point
+	for ( std::size_t i = 0; i < m_chunks.size(); ++i )
+	{
+		const Chunk &chunk = m_chunks[i];
+		const float cx = std::clamp( params.viewPosition.x, chunk.aabbMin.x, chunk.aabbMax.x ) - params.viewPosition.x;
+		const float cy = std::clamp( params.viewPosition.y, chunk.aabbMin.y, chunk.aabbMax.y ) - params.viewPosition.y;
+		const float cz = std::clamp( params.viewPosition.z, chunk.aabbMin.z, chunk.aabbMax.z ) - params.viewPosition.z;
+		// orthographic projections don't shrink the error with distance
+		const float distance = params.bOrthographic ?
+			1.0f :
+			std::sqrt( cx * cx + cy * cy + cz * cz );
+
+		unsigned lod = 0;
+		for ( unsigned l = m_nLods - 1; l > 0; --l )
+		{
+			if ( chunk.geometricErrors[l] * params.projectionScale <= params.maxPixelError * distance )
+			{
+				lod = l;
+				break;
+			}
+		}
+		lods[i] = lod;
+	}
+
+	// refine until no two neighbours are more than one LOD apart; LODs only ever decrease so this terminates in at most nLods sweeps
+	bool bChanged = true;
+	while ( bChanged )
+	{
+		bChanged = false;
+		for ( unsigned cy = 0; cy < m_nChunksY; ++cy )
+		{
+			for ( unsigned cx = 0; cx < m_nChunksX; ++cx )
+			{
+				unsigned &lod = lods[cy * m_nChunksX + cx];
+				unsigned minNeighbourLod = lod;
+				if ( cx > 0 )
+				{
+					minNeighbourLod = std::min( minNeighbourLod, lods[cy * m_nChunksX + cx - 1] );
+				}
+				if ( cx + 1 < m_nChunksX )
+				{
+					minNeighbourLod = std::min( minNeighbourLod, lods[cy * m_nChunksX + cx + 1] );
+				}
+				if ( cy > 0 )
+				{
+					minNeighbourLod = std::min( minNeighbourLod, lods[( cy - 1 ) * m_nChunksX + cx] );
+				}
+				if ( cy + 1 < m_nChunksY )
+				{
+					minNeighbourLod = std::min( minNeighbourLod, lods[( cy + 1 ) * m_nChunksX + cx] );
+				}
+				if ( lod > minNeighbourLod + 1 )
+				{
+					lod = minNeighbourLod + 1;
+					bChanged = true;
+				}
+			}
+		}
+	}
+
+	result.selection.clear();
+	cullNode( 0u, params.pFrustumPlanes, result );
+}
+
+const std::vector<TerrainQuadtree::Selection>& TerrainQuadtree::getSelection() const noexcept
+{
+	return m_lastSelection.selection;
+}
+
+const std::vector<unsigned>& TerrainQuadtree::getIndices() const noexcept
+{
+	return m_indices;
+}
+
+const TerrainQuadtree::IndexRange& TerrainQuadtree::getIndexRange( const unsigned lod,
+	const unsigned stitchMask ) const noexcept
+{
+	ASSERT( lod < m_nLods && stitchMask < s_nStitchMasks, "Invalid LOD!" );
+	return m_indexRanges[lod * s_nStitchMasks + stitchMask];
+}
+
+const std::vector<TerrainQuadtree::Chunk>& TerrainQuadtree::getChunks() const noexcept
+{
+	return m_chunks;
+}
+
+unsigned TerrainQuadtree::getChunkVertexCount() const noexcept
+{
+	return ( m_chunkQuads + 1 ) * ( m_chunkQuads + 1 );
+}
+
+unsigned TerrainQuadtree::getChunkQuads() const noexcept
+{
+	return m_chunkQuads;
+}
+
+unsigned TerrainQuadtree::getLodCount() const noexcept
+{
+	return m_nLods;
+}
+
+const std::vector<unsigned>& TerrainQuadtree::getLods() const noexcept
+{
+	return m_lastSelection.lods;
+}
+
+void TerrainQuadtree::computeChunk( const float *heights,
+	const unsigned chunkX,
+	const unsigned chunkY,
+	const float x0,
+	const float y0,
+	const float dx,
+	const float dy )
+{
+	const unsigned n = m_chunkQuads;
+	const std::size_t rowPitch = static_cast<std::size_t>( m_nChunksX ) * n + 1;
+	const auto height = [&] ( const unsigned i, const unsigned j ) -> float
+		{
+			return heights[( static_cast<std::size_t>( chunkY ) * n + j ) * rowPitch + static_cast<std::size_t>( chunkX ) * n + i];
+		};
+
+	Chunk chunk{};
+	chunk.x = chunkX;
+	chunk.y = chunkY;
+
+	float minZ = FLT_MAX;
+	float maxZ = -FLT_MAX;
+	for ( unsigned j = 0; j <= n; ++j )
+	{
+		for ( unsigned i = 0; i <= n; ++i )
+		{
+			minZ = std::min( minZ, height( i, j ) );
+			maxZ = std::max( maxZ, height( i, j ) );
+		}
+	}
+	const float xA = x0 + static_cast<float>( chunkX * n ) * dx;
+	const float xB = x0 + static_cast<float>( ( chunkX + 1 ) * n ) * dx;
+	const float yA = y0 + static_cast<float>( chunkY * n ) * dy;
+	const float yB = y0 + static_cast<float>( ( chunkY + 1 ) * n ) * dy;
+	chunk.aabbMin = {std::min( xA, xB ), std::min( yA, yB ), minZ};
+	chunk.aabbMax = {std::max( xA, xB ), std::max( yA, yB ), maxZ};
+
+	// the error of a LOD is how far the full detail vertices are from the coarse triangles they are dropped into
+	// the quads are split along the diagonal from (x + s, y) to (x, y + s), the same way buildIndices triangulates them
+	chunk.geometricErrors[0] = 0.0f;
+	for ( unsigned lod = 1; lod < m_nLods; ++lod )
+	{
+		const unsigned s = 1u << lod;
+		const unsigned nCells = n / s;
+		float error = chunk.geometricErrors[lod - 1];
+		for ( unsigned j = 0; j <= n; ++j )
+		{
+			const unsigned cj = std::min( j / s, nCells - 1 );
+			const float v = static_cast<float>( j - cj * s ) / s;
+			for ( unsigned i = 0; i <= n; ++i )
+			{
+				const unsigned ci = std::min( i / s, nCells - 1 );
+				const float u = static_cast<float>( i - ci * s ) / s;
+				const float ha = height( ci * s, cj * s );
+				const float hb = height( ci * s + s, cj * s );
+				const float hc = height( ci * s, cj * s + s );
+				const float hd = height( ci * s + s, cj * s + s );
+				const float coarse = u + v <= 1.0f ?
+					ha + u * ( hb - ha ) + v * ( hc - ha ) :
+					hd + ( 1.0f - u ) * ( hc - hd ) + ( 1.0f - v ) * ( hb - hd );
+				error = std::max( error, std::abs( height( i, j ) - coarse ) );
+			}
+		}
+		chunk.geometricErrors[lod] = error;
+	}
+	for ( unsigned lod = m_nLods; lod < s_maxLods; ++lod )
+	{
+		chunk.geometricErrors[lod] = FLT_MAX;
+	}
+
+	m_chunks.emplace_back( chunk );
+}
+
+void TerrainQuadtree::buildNode( const unsigned nodeIndex,
+	const unsigned cx0,
+	const unsigned cy0,
+	const unsigned cx1,
+	const unsigned cy1 )
+{
+	if ( cx1 - cx0 == 1 && cy1 - cy0 == 1 )
+	{
+		const unsigned chunkIndex = cy0 * m_nChunksX + cx0;
+		Node &node = m_nodes[nodeIndex];
+		node.aabbMin = m_chunks[chunkIndex].aabbMin;
+		node.aabbMax = m_chunks[chunkIndex].aabbMax;
+		node.firstChild = 0u;
+		node.nChildren = 0u;
+		node.chunk = chunkIndex;
+		return;
+	}
+
+	// halve both axes; an axis one chunk wide isn't split
+	const unsigned mx = cx1 - cx0 > 1 ?
+		( cx0 + cx1 ) / 2 :
+		cx1;
+	const unsigned my = cy1 - cy0 > 1 ?
+		( cy0 + cy1 ) / 2 :
+		cy1;
+	std::array<std::array<unsigned, 4>, 4> childRanges{};
+	unsigned nChildren = 0;
+	for ( const auto &[yA, yB] : {std::make_pair( cy0, my ), std::make_pair( my, cy1 )} )
+	{
+		for ( const auto &[xA, xB] : {std::make_pair( cx0, mx ), std::make_pair( mx, cx1 )} )
+		{
+			if ( xA < xB && yA < yB )
+			{
+				childRanges[nChildren++] = {xA, yA, xB, yB};
+			}
+		}
+	}
+
+	const unsigned firstChild = static_cast<unsigned>( m_nodes.size() );
+	m_nodes.resize( m_nodes.size() + nChildren );
+	DirectX::XMFLOAT3 aabbMin{FLT_MAX, FLT_MAX, FLT_MAX};
+	DirectX::XMFLOAT3 aabbMax{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for ( unsigned i = 0; i < nChildren; ++i )
+	{
+		const auto &range = childRanges[i];
+		buildNode( firstChild + i, range[0], range[1], range[2], range[3] );
+		const Node &child = m_nodes[firstChild + i];
+		aabbMin = {std::min( aabbMin.x, child.aabbMin.x ), std::min( aabbMin.y, child.aabbMin.y ), std::min( aabbMin.z, child.aabbMin.z )};
+		aabbMax = {std::max( aabbMax.x, child.aabbMax.x ), std::max( aabbMax.y, child.aabbMax.y ), std::max( aabbMax.z, child.aabbMax.z )};
+	}
+
+	Node &node = m_nodes[nodeIndex];
+	node.aabbMin = aabbMin;
+	node.aabbMax = aabbMax;
+	node.firstChild = firstChild;
+	node.nChildren = nChildren;
+	node.chunk = 0u;
+}
+
+void TerrainQuadtree::buildIndices()
+{
+	const unsigned n = m_chunkQuads;
+	m_indexRanges.resize( m_nLods * s_nStitchMasks );
+	for ( unsigned lod = 0; lod < m_nLods; ++lod )
+	{
+		const unsigned s = 1u << lod;
+		const unsigned nCells = n / s;
+		for ( unsigned stitchMask = 0; stitchMask < s_nStitchMasks; ++stitchMask )
+		{
+			// a single cell has no odd edge vertices to collapse & its neighbours can't be coarser anyway
+			if ( nCells < 2 && stitchMask != 0 )
+			{
+				m_indexRanges[lod * s_nStitchMasks + stitchMask] = m_indexRanges[lod * s_nStitchMasks];
+				continue;
+			}
+
+			// on a stitched edge the coarser neighbour only has the even vertices, so the odd ones collapse onto the preceding even one
+			// the triangles that degenerate are dropped, the rest fan out over the coarse edge
+			const auto vertex = [n, s, stitchMask] ( unsigned x, unsigned y ) -> unsigned
+				{
+					if ( ( ( x / s ) & 1u ) && ( ( y == 0 && ( stitchMask & Bottom ) ) || ( y == n && ( stitchMask & Top ) ) ) )
+					{
+						x -= s;
+					}
+					if ( ( ( y / s ) & 1u ) && ( ( x == 0 && ( stitchMask & Left ) ) || ( x == n && ( stitchMask & Right ) ) ) )
+					{
+						y -= s;
+					}
+					return y * ( n + 1 ) + x;
+				};
+			const auto addTriangle = [this] ( const unsigned a, const unsigned b, const unsigned c )
+				{
+					if ( a != b && b != c && a != c )
+					{
+						m_indices.push_back( a );
+						m_indices.push_back( b );
+						m_indices.push_back( c );
+					}
+				};
+
+			const unsigned startIndex = static_cast<unsigned>( m_indices.size() );
+			for ( unsigned cy = 0; cy < nCells; ++cy )
+			{
+				for ( unsigned cx = 0; cx < nCells; ++cx )
+				{
+					const unsigned x = cx * s;
+					const unsigned y = cy * s;
+					const unsigned a = vertex( x, y );
+					const unsigned b = vertex( x + s, y );
+					const unsigned c = vertex( x, y + s );
+					const unsigned d = vertex( x + s, y + s );
+					// same winding as geometry::makePlanarGridTextured
+					// except in the top right cell with both of its edges stitched: b & c collapse away from each other, leaving a on the b-c diagonal
+					if ( cx == nCells - 1 && cy == nCells - 1 && ( stitchMask & Top ) && ( stitchMask & Right ) )
+					{
+						addTriangle( a, c, d );
+						addTriangle( a, d, b );
+						continue;
+					}
+					addTriangle( a, c, b );
+					addTriangle( b, c, d );
+				}
+			}
+			m_indexRanges[lod * s_nStitchMasks + stitchMask] = {startIndex, static_cast<unsigned>( m_indices.size() ) - startIndex};
+		}
+	}
+}
+
+void TerrainQuadtree::cullNode( const unsigned nodeIndex,
+	const DirectX::XMFLOAT4 *pFrustumPlanes,
+	SelectionResult &result ) const
+{
+	const Node &node = m_nodes[nodeIndex];
+	if ( pFrustumPlanes != nullptr && FrustumCuller::isAabbCulled( pFrustumPlanes, node.aabbMin, node.aabbMax ) )
+	{
+		return;
+	}
+
+	if ( node.nChildren == 0 )
+	{
+		const Chunk &chunk = m_chunks[node.chunk];
+		const std::vector<unsigned> &lods = result.lods;
+		const unsigned lod = lods[node.chunk];
+		unsigned stitchMask = 0u;
+		if ( chunk.x > 0 && lods[node.chunk - 1] > lod )
+		{
+			stitchMask |= Left;
+		}
+		if ( chunk.x + 1 < m_nChunksX && lods[node.chunk + 1] > lod )
+		{
+			stitchMask |= Right;
+		}
+		if ( chunk.y > 0 && lods[node.chunk - m_nChunksX] > lod )
+		{
+			stitchMask |= Bottom;
+		}
+		if ( chunk.y + 1 < m_nChunksY && lods[node.chunk + m_nChunksX] > lod )
+		{
+			stitchMask |= Top;
+		}
+		result.selection.push_back( {node.chunk, lod, stitchMask} );
+		return;
+	}
+
+	for ( unsigned i = 0; i < node.nChildren; ++i )
+	{
+		cullNode( node.firstChild + i, pFrustumPlanes, result );
+	}
+}
\ No newline at end of file
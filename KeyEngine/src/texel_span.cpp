@@ -0,0 +1,82 @@
+#include "texel_span.h"
+#include <algorithm>
+#include <emmintrin.h>
+#include "cpu_features.h"
+
+
+namespace texel_span
+{
+
+void unpack( const std::uint32_t *pTexels,
+	const unsigned count,
+	float *pR,
+	float *pG,
+	float *pB ) noexcept
+{
+	unsigned i = 0;
+	if ( util::getCpuFeatures().bAvx2 )
+	{
+		i = texel_span_avx2::unpack( pTexels, count, pR, pG, pB );
+	}
+	const __m128i mask = _mm_set1_epi32( 0xFF );
+	const __m128 scale = _mm_set1_ps( 2.0f / 255.0f );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		const __m128i texels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pTexels + i ) );
+		_mm_storeu_ps( pB + i, _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( texels, mask ) ), scale ), one ) );
+		_mm_storeu_ps( pG + i, _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( texels, 8 ), mask ) ), scale ), one ) );
+		_mm_storeu_ps( pR + i, _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( texels, 16 ), mask ) ), scale ), one ) );
+	}
+	for ( ; i < count; ++i )
+	{
+		pB[i] = float( pTexels[i] & 0xFFu ) * ( 2.0f / 255.0f ) - 1.0f;
+		pG[i] = float( ( pTexels[i] >> 8 ) & 0xFFu ) * ( 2.0f / 255.0f ) - 1.0f;
+		pR[i] = float( ( pTexels[i] >> 16 ) & 0xFFu ) * ( 2.0f / 255.0f ) - 1.0f;
+	}
+}
+
+void pack( const float *pR,
+	const float *pG,
+	const float *pB,
+	const unsigned count,
+	std::uint32_t *pTexels ) noexcept
+{
+	// (v + 1) * 127.5 clamped to [0,255] and rounded half up like round() does for non-negative values
+	unsigned i = 0;
+	if ( util::getCpuFeatures().bAvx2 )
+	{
+		i = texel_span_avx2::pack( pR, pG, pB, count, pTexels );
+	}
+	{
+		const __m128 one = _mm_set1_ps( 1.0f );
+		const __m128 scale = _mm_set1_ps( 255.0f / 2.0f );
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 max = _mm_set1_ps( 255.0f );
+		const __m128 half = _mm_set1_ps( 0.5f );
+		const __m128i alphaMask = _mm_set1_epi32( static_cast<int>( 0xFF000000u ) );
+		const auto toByte = [&] ( const float *p ) -> __m128i
+			{
+				const __m128 v = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( p ), one ), scale );
+				return _mm_cvttps_epi32( _mm_add_ps( _mm_min_ps( _mm_max_ps( v, zero ), max ), half ) );
+			};
+		for ( ; i + 4 <= count; i += 4 )
+		{
+			__m128i *pOut = reinterpret_cast<__m128i*>( pTexels + i );
+			const __m128i alpha = _mm_and_si128( _mm_loadu_si128( pOut ), alphaMask );
+			const __m128i texels = _mm_or_si128( _mm_or_si128( alpha, toByte( pB + i ) ), _mm_or_si128( _mm_slli_epi32( toByte( pG + i ), 8 ), _mm_slli_epi32( toByte( pR + i ), 16 ) ) );
+			_mm_storeu_si128( pOut, texels );
+		}
+	}
+	const auto toByte = [] ( const float v ) -> std::uint32_t
+		{
+			return static_cast<std::uint32_t>( std::clamp( ( v + 1.0f ) * ( 255.0f / 2.0f ), 0.0f, 255.0f ) + 0.5f );
+		};
+	for ( ; i < count; ++i )
+	{
+		pTexels[i] = ( pTexels[i] & 0xFF000000u ) | ( toByte( pR[i] ) << 16 ) | ( toByte( pG[i] ) << 8 ) | toByte( pB[i] );
+	}
+}
+
+
+}//namespace texel_span
\ No newline at end of file
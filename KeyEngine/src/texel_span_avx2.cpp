@@ -0,0 +1,60 @@
+#include "texel_span.h"
+#include <immintrin.h>
+
+
+// built with AVX2 code generation (/arch:AVX2, -mavx2); the arithmetic is the SSE2 path's, so both paths convert texels identically
+//	texel_span.cpp only calls in here if the CPU supports AVX2
+
+namespace texel_span_avx2
+{
+
+unsigned unpack( const std::uint32_t *pTexels,
+	const unsigned count,
+	float *pR,
+	float *pG,
+	float *pB ) noexcept
+{
+	const __m256i mask = _mm256_set1_epi32( 0xFF );
+	const __m256 scale = _mm256_set1_ps( 2.0f / 255.0f );
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	unsigned i = 0;
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		const __m256i texels = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pTexels + i ) );
+		_mm256_storeu_ps( pB + i, _mm256_sub_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_and_si256( texels, mask ) ), scale ), one ) );
+		_mm256_storeu_ps( pG + i, _mm256_sub_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_and_si256( _mm256_srli_epi32( texels, 8 ), mask ) ), scale ), one ) );
+		_mm256_storeu_ps( pR + i, _mm256_sub_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_and_si256( _mm256_srli_epi32( texels, 16 ), mask ) ), scale ), one ) );
+	}
+	return i;
+}
+
+unsigned pack( const float *pR,
+	const float *pG,
+	const float *pB,
+	const unsigned count,
+	std::uint32_t *pTexels ) noexcept
+{
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	const __m256 scale = _mm256_set1_ps( 255.0f / 2.0f );
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 max = _mm256_set1_ps( 255.0f );
+	const __m256 half = _mm256_set1_ps( 0.5f );
+	const __m256i alphaMask = _mm256_set1_epi32( static_cast<int>( 0xFF000000u ) );
+	const auto toByte = [&] ( const float *p ) -> __m256i
+		{
+			const __m256 v = _mm256_mul_ps( _mm256_add_ps( _mm256_loadu_ps( p ), one ), scale );
+			return _mm256_cvttps_epi32( _mm256_add_ps( _mm256_min_ps( _mm256_max_ps( v, zero ), max ), half ) );
+		};
+	unsigned i = 0;
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		__m256i *pOut = reinterpret_cast<__m256i*>( pTexels + i );
+		const __m256i alpha = _mm256_and_si256( _mm256_loadu_si256( pOut ), alphaMask );
+		const __m256i texels = _mm256_or_si256( _mm256_or_si256( alpha, toByte( pB + i ) ), _mm256_or_si256( _mm256_slli_epi32( toByte( pG + i ), 8 ), _mm256_slli_epi32( toByte( pR + i ), 16 ) ) );
+		_mm256_storeu_si256( pOut, texels );
+	}
+	return i;
+}
+
+
+}//namespace texel_span_avx2
\ No newline at end of file
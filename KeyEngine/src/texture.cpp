@@ -1,11 +1,14 @@
 #include "texture.h"
 #include "texture_desc.h"
 #include "texture_processor.h"
+#include "mip_generator.h"
+#include "cpu_framebuffer.h"
 #include "graphics.h"
 #include "bindable_registry.h"
 #include "os_utils.h"
 #include "dxgi_info_queue.h"
 #include "assertions_console.h"
+#include "global_constants.h"
 
 
 namespace mwrl = Microsoft::WRL;
@@ -14,38 +17,63 @@ namespace dx = DirectX;
 Texture::Texture( Graphics &gfx,
 	const std::string &filepath,
 	const unsigned slot,
-	TextureOp op /*= nullptr*/  )
+	TexelSpanOp op /*= nullptr*/,
+	const TextureContent content /*= TextureContent::Color*/ )
 	:
+	m_content{content},
 	m_path{filepath},
 	m_slot(slot),
 	m_op(op)
 {
 	// #TODO: the rendering pipeline should not involve code paths that require loading assets from disk.
 	// so preload bitmaps & shaders
-	auto bitmap = Bitmap::loadFromFile( filepath );
-	m_bAlpha = bitmap.hasAlpha();
-	m_width = bitmap.getWidth();
-	m_height = bitmap.getHeight();
-
+	mip_gen::Settings mipSettings;
+	mipSettings.bNormalMap = content == TextureContent::NormalMap;
+	mipSettings.bMask = content == TextureContent::Mask;
+	// a specular map's alpha is its gloss & UI images are blended, so only color maps' alpha is coverage
+	mipSettings.alphaCutoff = content == TextureContent::Color ?
+		g_alphaTestCutoff :
+		0.0f;
+	mipSettings.bWrap = content != TextureContent::Ui;
+
+	mip_gen::MipChain mips;
 	if ( op )
 	{
-		TextureProcessor::transformBitmap( bitmap, op );
+		// ops aren't identifiable across runs, so transformed textures aren't cooked
+		auto bitmap = Bitmap::loadFromFile( filepath );
+		TextureProcessor::transformSpans( bitmap, op );
+		mips = mip_gen::generate( bitmap, mipSettings );
+	}
+	else
+	{
+		// block compression is only worth its encoding time if it's done once, when cooking
+		mipSettings.bCompress = true;
+		mips = mip_gen::loadOrCook( filepath, mipSettings );
 	}
+	m_width = mips.levels[0].width;
+	m_height = mips.levels[0].height;
+	m_bAlpha = mips.bAlpha;
 
-	D3D11_TEXTURE2D_DESC texDesc = createTextureDescriptor( m_width, m_height, DXGI_FORMAT_B8G8R8A8_UNORM, BindFlags::RenderTargetTexture, CpuAccessFlags::NoCpuAccess, TextureUsage::Default, false );
+	D3D11_TEXTURE2D_DESC texDesc = createTextureDescriptor( m_width, m_height, getFormatTexture( mips.format ), BindFlags::TextureOnly, CpuAccessFlags::NoCpuAccess, TextureUsage::Const, false );
+	texDesc.MipLevels = static_cast<unsigned>( mips.levels.size() );
 
-	HRESULT hres = getDevice( gfx )->CreateTexture2D( &texDesc, nullptr, &m_pTex );
+	std::vector<D3D11_SUBRESOURCE_DATA> levels( mips.levels.size() );
+	for ( std::size_t i = 0; i < levels.size(); ++i )
+	{
+		levels[i].pSysMem = mips.getLevel( i );
+		levels[i].SysMemPitch = static_cast<unsigned>( mips.levels[i].rowPitch );
+		levels[i].SysMemSlicePitch = 0u;
+	}
+	HRESULT hres = getDevice( gfx )->CreateTexture2D( &texDesc, levels.data(), &m_pTex );
 	ASSERT_HRES_IF_FAILED;
 
-	paintTextureWithBitmap( gfx, m_pTex.Get(), bitmap );
-
 	// create the resource view on the texture
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
 	srvDesc.Format = texDesc.Format;
 	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 	srvDesc.Texture2D.MostDetailedMip = 0u;
 #pragma warning( disable: 4146 )
-	srvDesc.Texture2D.MipLevels = -1u;	// generate all Mips from #(MostDetailedMip) down to least detailed
+	srvDesc.Texture2D.MipLevels = -1u;	// all Mips from #(MostDetailedMip) down to least detailed
 #pragma warning( default: 4146 )
 	hres = getDevice( gfx )->CreateShaderResourceView( m_pTex.Get(), &srvDesc, &m_pD3dSrv );
 	ASSERT_HRES_IF_FAILED;
@@ -56,8 +84,6 @@ Texture::Texture( Graphics &gfx,
 	const auto cstr = srvName.c_str();
 	m_pD3dSrv->SetPrivateData( WKPDID_D3DDebugObjectName, (UINT) strlen( cstr ), cstr );
 #endif
-
-	getDeviceContext( gfx )->GenerateMips( m_pD3dSrv.Get() );
 	DXGI_GET_QUEUE_INFO( gfx );
 }
 
@@ -65,7 +91,7 @@ Texture::Texture( Graphics &gfx,
 	const unsigned width,
 	const unsigned height,
 	const unsigned slot,
-	TextureOp op /*= nullptr*/  )
+	TexelSpanOp op /*= nullptr*/  )
 	:
 	m_bDynamic{true},
 	m_width(width),
@@ -73,7 +99,8 @@ Texture::Texture( Graphics &gfx,
 	m_slot(slot),
 	m_op(op)
 {
-	D3D11_TEXTURE2D_DESC texDesc = createTextureDescriptor( width, height, DXGI_FORMAT_B8G8R8A8_UNORM, BindFlags::TextureOnly, CpuAccessFlags::CpuWriteAccess, TextureUsage::Dynamic, false );
+	// a default usage texture keeps its contents across frames so only the changed parts of the CPU framebuffer have to be uploaded; mapping with WRITE_DISCARD would lose them
+	D3D11_TEXTURE2D_DESC texDesc = createTextureDescriptor( width, height, DXGI_FORMAT_B8G8R8A8_UNORM, BindFlags::TextureOnly, CpuAccessFlags::NoCpuAccess, TextureUsage::Default, false );
 
 	HRESULT hres = getDevice( gfx )->CreateTexture2D( &texDesc, nullptr, &m_pTex );
 	ASSERT_HRES_IF_FAILED;
@@ -104,22 +131,17 @@ void Texture::paintTextureWithBitmap( Graphics &gfx,
 
 void Texture::update( Graphics &gfx ) cond_noex
 {
-	HRESULT hres;
-	D3D11_MAPPED_SUBRESOURCE msr{};
-	hres = getDeviceContext( gfx )->Map( m_pTex.Get(), 0u, D3D11_MAP::D3D11_MAP_WRITE_DISCARD, 0u, &msr );
-	ASSERT_HRES_IF_FAILED;
-
-	ColorBGRA *pDst = static_cast<ColorBGRA*>( msr.pData );
-	const unsigned dstWidth = msr.RowPitch / sizeof ColorBGRA;
-	const unsigned srcWidth = m_width;
-	const unsigned nRowBytes = srcWidth * sizeof ColorBGRA;
-	ColorBGRA *pSrc = gfx.cpuBuffer();
-	// copy 1 line at a time from cpuBuffer to dynamic GPU texture
-	for ( unsigned y = 0u; y < m_height; ++y )
+	const CpuFramebuffer &framebuffer = gfx.cpuFramebuffer();
+	ASSERT( framebuffer.getWidth() == m_width && framebuffer.getHeight() == m_height, "CPU framebuffer & dynamic texture sizes differ!" );
+	const ColorBGRA *pSrc = framebuffer.getFrontBuffer();
+	const unsigned srcPitch = m_width * sizeof( ColorBGRA );
+	// only the parts that changed since the previous frame's upload
+	for ( const CpuFramebuffer::Rect &rect : framebuffer.getUploadRects() )
 	{
-		memcpy( &pDst[y * dstWidth], &pSrc[y * srcWidth], nRowBytes );
+		const D3D11_BOX box{rect.left, rect.top, 0u, rect.right, rect.bottom, 1u};
+		getDeviceContext( gfx )->UpdateSubresource( m_pTex.Get(), 0u, &box, pSrc + static_cast<std::size_t>( rect.top ) * m_width + rect.left, srcPitch, 0u );
 	}
-	getDeviceContext( gfx )->Unmap( m_pTex.Get(), 0u );
+	DXGI_GET_QUEUE_INFO( gfx );
 }
 
 void Texture::bind( Graphics &gfx ) cond_noex
@@ -160,22 +182,24 @@ Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& Texture::getD3dSrv()
 std::shared_ptr<Texture> Texture::fetch( Graphics &gfx,
 	const std::string &filepath,
 	const unsigned slot,
-	TextureOp op /*= nullptr*/  )
+	TexelSpanOp op /*= nullptr*/,
+	const TextureContent content /*= TextureContent::Color*/ )
 {
-	return BindableRegistry::fetch<Texture>( gfx, filepath, slot, op );
+	return BindableRegistry::fetch<Texture>( gfx, filepath, slot, op, content );
 }
 
 std::string Texture::calcUid( const std::string &filepath,
 	const unsigned slot,
-	TextureOp op /*= nullptr*/ )
+	TexelSpanOp op /*= nullptr*/,
+	const TextureContent content /*= TextureContent::Color*/ )
 {
 	using namespace std::string_literals;
-	return typeid( Texture ).name() + "#"s + filepath + "#"s + std::to_string( slot ) + ( op != nullptr ? "#" + std::to_string( util::pointerToInt( std::addressof(op) ) ) : "" );
+	return typeid( Texture ).name() + "#"s + filepath + "#"s + std::to_string( slot ) + ( op != nullptr ? "#" + std::to_string( util::pointerToInt( std::addressof(op) ) ) : "" ) + "#"s + std::to_string( static_cast<int>( content ) );
 }
 
 std::string Texture::getUid() const noexcept
 {
-	return calcUid( m_path, m_slot, m_op );
+	return calcUid( m_path, m_slot, m_op, m_content );
 }
 
 unsigned Texture::getSlot() const noexcept
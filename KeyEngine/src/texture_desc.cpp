@@ -48,6 +48,26 @@ const DXGI_FORMAT getFormatRtv( const RenderTargetViewMode mode )
 	THROW_BINDABLE_EXCEPTION( "Invalid Render Target View mode DXGI format." );
 }
 
+const DXGI_FORMAT getFormatTexture( const bc::Format format )
+{
+	switch ( format )
+	{
+	case bc::Format::BGRA8:
+		return DXGI_FORMAT::DXGI_FORMAT_B8G8R8A8_UNORM;
+	case bc::Format::BC1:
+		return DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM;
+	case bc::Format::BC3:
+		return DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM;
+	case bc::Format::BC4:
+		return DXGI_FORMAT::DXGI_FORMAT_BC4_UNORM;
+	case bc::Format::BC5:
+		return DXGI_FORMAT::DXGI_FORMAT_BC5_UNORM;
+	case bc::Format::BC7:
+		return DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM;
+	}
+	THROW_BINDABLE_EXCEPTION( "Invalid block compression format for Texture DXGI format." );
+}
+
 const DXGI_FORMAT getTypelessFormatDsv( const DepthStencilViewMode mode )
 {
 	switch ( mode )
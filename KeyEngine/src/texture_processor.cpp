@@ -4,8 +4,12 @@
 #include "assimp/scene.h"
 #include "console.h"
 #include "assertions_console.h"
+#include "texel_span.h"
 #include <filesystem>
+#include <cmath>
 #include <sstream>
+#include <vector>
+#include <immintrin.h>
 
 
 namespace dx = DirectX;
@@ -45,12 +49,12 @@ void TextureProcessor::flipModelNormalMapsGreenChannel( const std::string &objPa
 void TextureProcessor::flipNormalMapGreenChannel( const std::string &pathIn,
 	const std::string &pathOut )
 {
-	const auto normalOp = []( dx::XMVECTOR v, int x, int y ) -> dx::XMVECTOR
+	// in [-1,1] the flip is g' = -g, ie 255 - g in bytes, so there's no need to unpack
+	const auto flipOp = [] ( Bitmap::Texel *pRow, const unsigned width, const unsigned y )
 	{
-		const auto flipY = dx::XMVectorSet( 1.0f, -1.0f, 1.0f, 1.0f );
-		return dx::XMVectorMultiply( v, flipY );
+		flipGreenChannel( pRow, width );
 	};
-	transformFile( pathIn, pathOut, normalOp );
+	transformFile( pathIn, pathOut, flipOp );
 }
 
 void TextureProcessor::validateNormalMap( const std::string &pathIn,
@@ -61,46 +65,55 @@ void TextureProcessor::validateNormalMap( const std::string &pathIn,
 	auto &console = KeyConsole::getInstance();
 	console.log( "Validating normal map [" + pathIn + "]\n" );
 #endif
-	auto sum = dx::XMVectorZero();
-	// function for processing each normal Texel
-	const auto normalOp = [thresholdMin, thresholdMax, &sum]
-		( dx::XMVECTOR v, int x, int y )
-		-> dx::XMVECTOR
+	const auto bitmap = Bitmap::loadFromFile( pathIn );
+	// rows are validated concurrently, so each one keeps its own sum & report which are gathered in row order afterwards
+	std::vector<dx::XMFLOAT2> rowSums( bitmap.getHeight(), dx::XMFLOAT2{0.0f, 0.0f} );
+	std::vector<std::string> rowReports( bitmap.getHeight() );
+	// function for processing each span of normal Texels
+	const auto normalOp = [thresholdMin, thresholdMax, &rowSums, &rowReports] ( const TexelSpan &span )
 	{
-		const float len = dx::XMVectorGetX( dx::XMVector3Length( v ) );
-		const float z = dx::XMVectorGetZ( v );
-		if ( len < thresholdMin || len > thresholdMax )
+		float sumX = 0.0f;
+		float sumY = 0.0f;
+		for ( unsigned i = 0; i < span.count; ++i )
 		{
-			dx::XMFLOAT3 vec{};
-			dx::XMStoreFloat3( &vec, v );
-			std::ostringstream oss;
-			oss << "Bad normal length: " << len << " at: (" << x << ", " << y << ") normal: (" << vec.x << ", " << vec.y << ", " << vec.z << ")\n";
-#if defined _DEBUG && !defined NDEBUG
-			auto &console = KeyConsole::getInstance();
-			console.log( oss.str() );
-#endif
-		}
-		if ( z < 0.0f )
-		{
-			dx::XMFLOAT3 vec{};
-			dx::XMStoreFloat3( &vec, v );
-			std::ostringstream oss;
-			oss << "Bad normal Z direction at: (" << x << ", " << y << ") normal: (" << vec.x << ", " << vec.y << ", " << vec.z << ")\n";
-#if defined _DEBUG && !defined NDEBUG
-			auto &console = KeyConsole::getInstance();
-			console.log( oss.str() );
-#endif
+			const float x = span.r[i];
+			const float y = span.g[i];
+			const float z = span.b[i];
+			sumX += x;
+			sumY += y;
+			const float len = std::sqrt( x * x + y * y + z * z );
+			if ( len < thresholdMin || len > thresholdMax )
+			{
+				std::ostringstream oss;
+				oss << "Bad normal length: " << len << " at: (" << span.x + i << ", " << span.y << ") normal: (" << x << ", " << y << ", " << z << ")\n";
+				rowReports[span.y] += oss.str();
+			}
+			if ( z < 0.0f )
+			{
+				std::ostringstream oss;
+				oss << "Bad normal Z direction at: (" << span.x + i << ", " << span.y << ") normal: (" << x << ", " << y << ", " << z << ")\n";
+				rowReports[span.y] += oss.str();
+			}
 		}
-		sum = dx::XMVectorAdd( sum, v );
-		return v;
+		rowSums[span.y].x += sumX;
+		rowSums[span.y].y += sumY;
 	};
 	// execute the validation for each texel
-	auto bitmap = Bitmap::loadFromFile( pathIn );
-	transformBitmap( bitmap, normalOp );
-	// output bias
+	visitSpans( bitmap, normalOp );
+	// output bad normals & bias
+	dx::XMFLOAT2 sumv{0.0f, 0.0f};
+	for ( unsigned y = 0; y < bitmap.getHeight(); ++y )
+	{
+		sumv.x += rowSums[y].x;
+		sumv.y += rowSums[y].y;
+#if defined _DEBUG && !defined NDEBUG
+		if ( !rowReports[y].empty() )
+		{
+			console.log( rowReports[y] );
+		}
+#endif
+	}
 	{
-		dx::XMFLOAT2 sumv{};
-		dx::XMStoreFloat2( &sumv, sum );
 		std::ostringstream oss;
 		oss << "Normal map biases: (" << sumv.x << ", " << sumv.y << ")\n";
 #if defined _DEBUG && !defined NDEBUG
@@ -147,3 +160,39 @@ void TextureProcessor::transformBitmap( Bitmap &bitmap,
 		}
 	}
 }
+
+void TextureProcessor::unpackSpan( const Bitmap::Texel *pTexels,
+	const unsigned count,
+	float *pR,
+	float *pG,
+	float *pB ) noexcept
+{
+	static_assert( sizeof( Bitmap::Texel ) == 4, "Texels are unpacked as 32bit lanes!" );
+	texel_span::unpack( reinterpret_cast<const std::uint32_t*>( pTexels ), count, pR, pG, pB );
+}
+
+void TextureProcessor::packSpan( const float *pR,
+	const float *pG,
+	const float *pB,
+	const unsigned count,
+	Bitmap::Texel *pTexels ) noexcept
+{
+	texel_span::pack( pR, pG, pB, count, reinterpret_cast<std::uint32_t*>( pTexels ) );
+}
+
+void TextureProcessor::flipGreenChannel( Bitmap::Texel *pTexels,
+	const unsigned count ) noexcept
+{
+	constexpr unsigned greenMask = 0x0000FF00u;
+	unsigned i = 0;
+	const __m128i mask = _mm_set1_epi32( static_cast<int>( greenMask ) );
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		__m128i *p = reinterpret_cast<__m128i*>( pTexels + i );
+		_mm_storeu_si128( p, _mm_xor_si128( _mm_loadu_si128( p ), mask ) );
+	}
+	for ( ; i < count; ++i )
+	{
+		pTexels[i].m_dword ^= greenMask;
+	}
+}
\ No newline at end of file
@@ -2,10 +2,80 @@
 #include "assertions_console.h"
 
 
+void ThreadPoolJ::Task::destroyPayload() noexcept
+{
+	if ( m_pfnDestroy )
+	{
+		m_pfnDestroy( *this );
+		m_pfnDestroy = nullptr;
+		m_pfnInvoke = nullptr;
+	}
+}
+
+void ThreadPoolJ::Task::lockContinuations() noexcept
+{
+	while ( m_continuationLock.test_and_set( std::memory_order_acquire ) )
+	{
+		std::this_thread::yield();
+	}
+}
+
+void ThreadPoolJ::Task::unlockContinuations() noexcept
+{
+	m_continuationLock.clear( std::memory_order_release );
+}
+
+ThreadPoolJ::TaskHandle::TaskHandle( Task *pTask,
+	const std::uint64_t generation ) noexcept
+	:
+	m_pTask{pTask},
+	m_generation{generation}
+{
+
+}
+
+bool ThreadPoolJ::TaskHandle::isValid() const noexcept
+{
+	return m_pTask != nullptr;
+}
+
+bool ThreadPoolJ::TaskHandle::isDone() const noexcept
+{
+	if ( !isValid() )
+	{
+		return true;
+	}
+
+	const std::uint64_t genState = m_pTask->m_genState.load( std::memory_order_acquire );
+	if ( Task::getGeneration( genState ) != m_generation )
+	{
+		// the slot has been recycled
+		return true;
+	}
+	const Task::State state = Task::getState( genState );
+	return state != Task::Pending && state != Task::Running;
+}
+
+ThreadPoolJ::Worker::Worker( const std::uint32_t seed )
+	:
+	m_rngState{seed | 1u}
+{
+
+}
+
 ThreadPoolJ::ThreadPoolJ( const std::size_t nthreads,
 	const bool bStart )
+	:
+	m_nThreads{std::clamp<std::size_t>( nthreads, 1u, s_maxWorkers )},
+	m_tasks{std::make_unique<Task[]>( m_nThreads * s_tasksPerWorker + s_tasksExternal )}
 {
-	m_pool.reserve( nthreads );
+	m_pool.reserve( m_nThreads );
+	m_workers.reserve( m_nThreads );
+	for ( std::size_t i = 0; i < m_nThreads; ++i )
+	{
+		m_workers.emplace_back( std::make_unique<Worker>( static_cast<std::uint32_t>( 0x9E3779B9u * ( i + 1 ) ) ) );
+	}
+
 	if ( bStart )
 	{
 		start();
@@ -37,28 +107,19 @@ ThreadPoolJ::~ThreadPoolJ() noexcept
 {
 	stop();
 	m_pool.clear();	// needed for "extraordinary circumstances"
-}
 
-ThreadPoolJ::ThreadPoolJ( ThreadPoolJ &&rhs ) noexcept
-	:
-	m_pool{std::move( rhs.m_pool )},
-	m_tasks{std::move( rhs.m_tasks )}
-{
-	m_bEnabled = rhs.m_bEnabled;
-	rhs.m_bEnabled = false;
-}
-
-ThreadPoolJ& ThreadPoolJ::operator=( ThreadPoolJ &&rhs ) noexcept
-{
-	ThreadPoolJ tmp{std::move( rhs )};
-	std::swap( *this, tmp );
-	return *this;
+	// Tasks that never got to run still own their payloads
+	for ( std::size_t i = 0; i < m_nThreads * s_tasksPerWorker + s_tasksExternal; ++i )
+	{
+		m_tasks[i].destroyPayload();
+	}
 }
 
 void ThreadPoolJ::start()
 {
 	if ( !m_bEnabled )
 	{
+		m_stopSource = nonstd::stop_source{};
 		enable();
 
 		run();
@@ -70,8 +131,17 @@ void ThreadPoolJ::stop() noexcept
 	if ( m_bEnabled )
 	{
 		disable();
+		m_stopSource.request_stop();
+
+		for ( auto &pWorker : m_workers )
+		{
+			{
+				std::unique_lock<std::mutex> ul{pWorker->m_parkMu};
+				pWorker->m_bNotified = true;
+			}
+			pWorker->m_parkCond.notify_one();
+		}
 
-		m_cond.notify_all();
 		for ( auto &t : m_pool )
 		{
 			ASSERT( t.get_stop_token().stop_possible(), "Stop is not possible!" )
@@ -81,61 +151,357 @@ void ThreadPoolJ::stop() noexcept
 				t.join();
 			}
 		}
+		m_pool.clear();
+		m_idleMask.store( 0, std::memory_order_relaxed );
 	}
 }
 
 void ThreadPoolJ::enable() noexcept
 {
-	m_bEnabled = true;
+	m_bEnabled.store( true, std::memory_order_release );
 }
 
 void ThreadPoolJ::disable() noexcept
 {
-	m_bEnabled = false;
+	m_bEnabled.store( false, std::memory_order_release );
 }
 
 bool ThreadPoolJ::isEnabled() const noexcept
 {
-	return m_bEnabled;
+	return m_bEnabled.load( std::memory_order_acquire );
+}
+
+std::size_t ThreadPoolJ::getThreadCount() const noexcept
+{
+	return m_nThreads;
 }
 
 void ThreadPoolJ::run()
 {
-	std::size_t nthreads = m_pool.capacity();
+	for ( std::size_t ti = 0; ti < m_nThreads; ++ti )
+	{
+		// the Tasks are handed the pool's stop_token instead of jthread's own so that Tasks run by helping threads can be interrupted too
+		m_pool.emplace_back( nonstd::jthread{[this, ti] () -> void
+			{
+				threadMain( ti );
+			}} );
+	}
+}
 
-	// this `stop_token st` is jthread's own stop_token (not some random argument being passed to the thread's function)
-	auto threadMain = [this] ( nonstd::stop_token st ) -> void
+void ThreadPoolJ::threadMain( const std::size_t workerIndex )
+{
+	s_pCurrentPool = this;
+	s_currentWorkerIndex = workerIndex;
+	Worker &worker = *m_workers[workerIndex];
+
+	while ( isEnabled() )
 	{
-		// thread sleeps forever until there's a task available
-		while ( true )
+		Task *pTask = findTask( &worker );
+		// spin for a while before giving up the core, Tasks tend to arrive in bursts
+		for ( unsigned spin = 0; pTask == nullptr && spin < s_spinsBeforeParking; ++spin )
+		{
+			std::this_thread::yield();
+			pTask = findTask( &worker );
+		}
+
+		if ( pTask )
 		{
-			std::unique_lock<std::mutex> ul{m_mu};
-			while ( m_tasks.empty() && m_bEnabled )
+			execute( *pTask );
+		}
+		else
+		{
+			park( worker, workerIndex );
+		}
+	}
+
+	s_pCurrentPool = nullptr;
+}
+
+ThreadPoolJ::Worker* ThreadPoolJ::getCurrentWorker() const noexcept
+{
+	return s_pCurrentPool == this ?
+		m_workers[s_currentWorkerIndex].get() :
+		nullptr;
+}
+
+ThreadPoolJ::Task& ThreadPoolJ::allocateTask()
+{
+	Worker *pWorker = getCurrentWorker();
+	Task *pPartition = pWorker ?
+		&m_tasks[s_currentWorkerIndex * s_tasksPerWorker] :
+		&m_tasks[m_nThreads * s_tasksPerWorker];
+	const std::size_t partitionSize = pWorker ?
+		s_tasksPerWorker :
+		s_tasksExternal;
+
+	while ( true )
+	{
+		for ( std::size_t attempt = 0; attempt < partitionSize; ++attempt )
+		{
+			const std::size_t cursor = pWorker ?
+				pWorker->m_taskCursor++ :
+				m_externalTaskCursor.fetch_add( 1, std::memory_order_relaxed );
+			Task &task = pPartition[cursor % partitionSize];
+
+			std::uint64_t genState = task.m_genState.load( std::memory_order_acquire );
+			if ( Task::getState( genState ) == Task::Free
+				&& task.m_genState.compare_exchange_strong( genState, Task::packGenState( Task::getGeneration( genState ) + 1, Task::Pending ), std::memory_order_acq_rel ) )
 			{
-				m_cond.wait( ul );
+				task.m_nPendingDependencies.store( 1, std::memory_order_relaxed );
+				task.m_nContinuations = 0;
+				return task;
 			}
+		}
 
-			if ( !m_bEnabled )
+		// every slot is in flight; apply back-pressure until some Tasks retire
+		if ( pWorker )
+		{
+			if ( Task *pTask = findTask( pWorker ) )
 			{
-				break;
+				execute( *pTask );
+				continue;
 			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+void ThreadPoolJ::submit( Task &task,
+	std::initializer_list<TaskHandle> dependencies )
+{
+	// the Task starts with 1 pending dependency which guards against it being scheduled while we're still registering its dependencies
+	for ( const TaskHandle &dependency : dependencies )
+	{
+		task.m_nPendingDependencies.fetch_add( 1, std::memory_order_relaxed );
+		if ( !addContinuation( dependency, task ) )
+		{
+			task.m_nPendingDependencies.fetch_sub( 1, std::memory_order_relaxed );
+		}
+	}
+
+	if ( task.m_nPendingDependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	{
+		schedule( task );
+	}
+}
+
+bool ThreadPoolJ::addContinuation( const TaskHandle &dependency,
+	Task &dependent )
+{
+	if ( !dependency.isValid() )
+	{
+		return false;
+	}
+
+	Task &task = *dependency.m_pTask;
+	task.lockContinuations();
+	const std::uint64_t genState = task.m_genState.load( std::memory_order_acquire );
+	const Task::State state = Task::getState( genState );
+	if ( Task::getGeneration( genState ) != dependency.m_generation
+		|| ( state != Task::Pending && state != Task::Running ) )
+	{
+		task.unlockContinuations();
+		return false;
+	}
+
+	if ( task.m_nContinuations == Task::s_maxContinuations )
+	{
+		task.unlockContinuations();
+		THROW_KEY_EXCEPTION( "Too many continuations on a single Task!" );
+	}
+	task.m_continuations[task.m_nContinuations++] = &dependent;
+	task.unlockContinuations();
+	return true;
+}
+
+void ThreadPoolJ::schedule( Task &task )
+{
+	bool bQueued;
+	if ( Worker *pWorker = getCurrentWorker() )
+	{
+		bQueued = pWorker->m_deque.push( &task ) || m_injectionQueue.tryPush( &task );
+	}
+	else
+	{
+		bQueued = m_injectionQueue.tryPush( &task );
+	}
+
+	if ( !bQueued )
+	{
+		// every queue is full, execute it right here rather than dropping it
+		execute( task );
+		return;
+	}
 
-			if ( !m_tasks.empty() )
+	// pairs with the fence in park(); either the parking worker sees the Task or we see the worker
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	wakeOne();
+}
+
+ThreadPoolJ::Task* ThreadPoolJ::findTask( Worker *pWorker )
+{
+	Task *pTask = nullptr;
+	if ( pWorker && pWorker->m_deque.pop( pTask ) )
+	{
+		return pTask;
+	}
+
+	if ( m_injectionQueue.tryPop( pTask ) )
+	{
+		return pTask;
+	}
+
+	// steal from a random victim and then go round-robin
+	std::size_t victim;
+	if ( pWorker )
+	{
+		std::uint32_t &x = pWorker->m_rngState;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		victim = x % m_nThreads;
+	}
+	else
+	{
+		victim = 0;
+	}
+
+	for ( std::size_t i = 0; i < m_nThreads; ++i, victim = ( victim + 1 ) % m_nThreads )
+	{
+		Worker *pVictim = m_workers[victim].get();
+		if ( pVictim != pWorker && pVictim->m_deque.steal( pTask ) )
+		{
+			return pTask;
+		}
+	}
+	return nullptr;
+}
+
+void ThreadPoolJ::execute( Task &task )
+{
+	std::uint64_t genState = task.m_genState.load( std::memory_order_acquire );
+	const std::uint64_t generation = Task::getGeneration( genState );
+	genState = Task::packGenState( generation, Task::Pending );
+	if ( task.m_genState.compare_exchange_strong( genState, Task::packGenState( generation, Task::Running ), std::memory_order_acq_rel ) )
+	{
+		task.m_pfnInvoke( task, m_stopSource.get_token() );
+	}
+	// else it has been cancelled
+
+	task.destroyPayload();
+	retire( task );
+}
+
+void ThreadPoolJ::retire( Task &task )
+{
+	std::array<Task*, Task::s_maxContinuations> continuations;
+
+	task.lockContinuations();
+	const std::uint64_t genState = task.m_genState.load( std::memory_order_relaxed );
+	const std::uint64_t generation = Task::getGeneration( genState );
+	if ( Task::getState( genState ) == Task::Running )
+	{
+		task.m_genState.store( Task::packGenState( generation, Task::Finished ), std::memory_order_release );
+	}
+	const unsigned nContinuations = task.m_nContinuations;
+	std::copy_n( task.m_continuations.begin(), nContinuations, continuations.begin() );
+	task.m_nContinuations = 0;
+	task.unlockContinuations();
+
+	for ( unsigned i = 0; i < nContinuations; ++i )
+	{
+		if ( continuations[i]->m_nPendingDependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+		{
+			schedule( *continuations[i] );
+		}
+	}
+
+	// the slot can now be recycled
+	task.m_genState.store( Task::packGenState( generation, Task::Free ), std::memory_order_release );
+}
+
+void ThreadPoolJ::park( Worker &worker,
+	const std::size_t workerIndex )
+{
+	const std::uint64_t bit = std::uint64_t{1} << workerIndex;
+	m_idleMask.fetch_or( bit, std::memory_order_seq_cst );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+
+	// re-check after announcing ourselves idle so that a Task pushed in the meantime is not missed
+	if ( Task *pTask = findTask( &worker ) )
+	{
+		m_idleMask.fetch_and( ~bit, std::memory_order_relaxed );
+		execute( *pTask );
+		return;
+	}
+
+	std::unique_lock<std::mutex> ul{worker.m_parkMu};
+	worker.m_parkCond.wait( ul, [this, &worker] ()
+		{
+			return worker.m_bNotified || !isEnabled();
+		} );
+	worker.m_bNotified = false;
+	ul.unlock();
+
+	m_idleMask.fetch_and( ~bit, std::memory_order_relaxed );
+}
+
+void ThreadPoolJ::wakeOne() noexcept
+{
+	std::uint64_t mask = m_idleMask.load( std::memory_order_seq_cst );
+	while ( mask != 0 )
+	{
+		std::size_t workerIndex = 0;
+		while ( ( ( mask >> workerIndex ) & 1u ) == 0 )
+		{
+			++workerIndex;
+		}
+
+		if ( m_idleMask.compare_exchange_weak( mask, mask & ~( std::uint64_t{1} << workerIndex ), std::memory_order_acq_rel ) )
+		{
+			Worker &worker = *m_workers[workerIndex];
 			{
-				Task task = std::move( m_tasks.front() );
-				m_tasks.pop();
-				ul.unlock();
-				task( st );
+				std::unique_lock<std::mutex> ul{worker.m_parkMu};
+				worker.m_bNotified = true;
 			}
+			worker.m_parkCond.notify_one();
+			return;
 		}
-	};
+	}
+}
 
-	for ( std::size_t ti = 0; ti < nthreads; ++ti )
+void ThreadPoolJ::wait( const TaskHandle &handle )
+{
+	Worker *pWorker = getCurrentWorker();
+	while ( !handle.isDone() )
 	{
-		m_pool.emplace_back( nonstd::jthread{std::move( threadMain )});
+		if ( pWorker )
+		{
+			if ( Task *pTask = findTask( pWorker ) )
+			{
+				execute( *pTask );
+				continue;
+			}
+		}
+		std::this_thread::yield();
 	}
 }
 
+void ThreadPoolJ::cancelOrWait( const TaskHandle &handle )
+{
+	Task &task = *handle.m_pTask;
+	std::uint64_t genState = Task::packGenState( handle.m_generation, Task::Pending );
+	if ( task.m_genState.compare_exchange_strong( genState, Task::packGenState( handle.m_generation, Task::Cancelled ), std::memory_order_acq_rel ) )
+	{
+		return;
+	}
+
+	// it is running, spin until it's done - it only has to finish its current chunk
+	while ( !handle.isDone() )
+	{
+		std::this_thread::yield();
+	}
+}
 
 namespace func_async
 {
@@ -0,0 +1,139 @@
+#include "transform_hierarchy.h"
+#include "node.h"
+#include "mesh.h"
+#include "thread_poolj.h"
+#include "assertions_console.h"
+
+
+namespace dx = DirectX;
+
+void TransformHierarchy::build( Node &root )
+{
+	m_nodes.clear();
+	m_parents.clear();
+	m_subtreeEnds.clear();
+	addNode( root, s_noParent );
+
+	const std::size_t nNodes = m_nodes.size();
+	dx::XMFLOAT4X4 identity;
+	dx::XMStoreFloat4x4( &identity, dx::XMMatrixIdentity() );
+	m_localTransforms.assign( nNodes, identity );
+	m_worldTransforms.assign( nNodes, identity );
+	m_dirty.assign( nNodes, 1u );
+	m_worldChanged.assign( nNodes, 0u );
+}
+
+void TransformHierarchy::markDirty( const std::uint32_t index ) noexcept
+{
+	m_dirty[index] = 1u;
+}
+
+void TransformHierarchy::update( const float dt,
+	const float lerpBetweenFrames,
+	const bool bEnableSmoothMovement /*= false*/ ) cond_noex
+{
+	const std::uint32_t nNodes = static_cast<std::uint32_t>( m_nodes.size() );
+	if ( nNodes < s_parallelThreshold )
+	{
+		updateRange( 0, nNodes, dt, lerpBetweenFrames, bEnableSmoothMovement );
+		return;
+	}
+
+	// the root first, then the subtrees of its children are independent of each other
+	updateRange( 0, 1, dt, lerpBetweenFrames, bEnableSmoothMovement );
+	std::vector<std::uint32_t> subtrees;
+	for ( std::uint32_t child = 1; child < nNodes; child = m_subtreeEnds[child] )
+	{
+		subtrees.push_back( child );
+	}
+	ThreadPoolJ::getInstance().parallelFor( 0, subtrees.size(), 1,
+		[&] ( const std::size_t first, const std::size_t last )
+		{
+			for ( std::size_t i = first; i < last; ++i )
+			{
+				updateRange( subtrees[i], m_subtreeEnds[subtrees[i]], dt, lerpBetweenFrames, bEnableSmoothMovement );
+			}
+		} );
+}
+
+void TransformHierarchy::setLocalTransform( const std::uint32_t index,
+	const dx::XMMATRIX &localTransform ) noexcept
+{
+	dx::XMStoreFloat4x4( &m_localTransforms[index], localTransform );
+}
+
+void TransformHierarchy::setWorldTransform( const std::uint32_t index,
+	const dx::XMMATRIX &worldTransform ) noexcept
+{
+	dx::XMStoreFloat4x4( &m_worldTransforms[index], worldTransform );
+	m_dirty[index] = 0u;
+	// the children have to pick up the new world transform
+	for ( std::uint32_t child = index + 1; child < m_subtreeEnds[index]; child = m_subtreeEnds[child] )
+	{
+		m_dirty[child] = 1u;
+	}
+}
+
+const dx::XMFLOAT4X4& TransformHierarchy::getWorldTransform( const std::uint32_t index ) const noexcept
+{
+	return m_worldTransforms[index];
+}
+
+std::size_t TransformHierarchy::getNodeCount() const noexcept
+{
+	return m_nodes.size();
+}
+
+void TransformHierarchy::addNode( Node &node,
+	const std::uint32_t parentIndex )
+{
+	const std::uint32_t index = static_cast<std::uint32_t>( m_nodes.size() );
+	node.m_pTransformHierarchy = this;
+	node.m_hierarchyIndex = index;
+	m_nodes.push_back( &node );
+	m_parents.push_back( parentIndex );
+	m_subtreeEnds.push_back( 0 );
+	for ( auto &pChild : node.m_children )
+	{
+		addNode( *pChild, index );
+	}
+	m_subtreeEnds[index] = static_cast<std::uint32_t>( m_nodes.size() );
+}
+
+void TransformHierarchy::updateRange( const std::uint32_t first,
+	const std::uint32_t last,
+	const float dt,
+	const float lerpBetweenFrames,
+	const bool bEnableSmoothMovement ) cond_noex
+{
+	for ( std::uint32_t i = first; i < last; ++i )
+	{
+		const std::uint32_t parent = m_parents[i];
+		const bool bParentChanged = parent != s_noParent && m_worldChanged[parent];
+		if ( !m_dirty[i] && !bParentChanged )
+		{
+			m_worldChanged[i] = 0u;
+			continue;
+		}
+
+		Node &node = *m_nodes[i];
+		if ( m_dirty[i] )
+		{
+			node.updateLocalTransform( dt, lerpBetweenFrames, bEnableSmoothMovement );
+		}
+
+		dx::XMMATRIX worldTransform = dx::XMLoadFloat4x4( &m_localTransforms[i] );
+		if ( parent != s_noParent )
+		{
+			worldTransform = worldTransform * dx::XMLoadFloat4x4( &m_worldTransforms[parent] );
+		}
+		dx::XMStoreFloat4x4( &m_worldTransforms[i], worldTransform );
+		m_dirty[i] = 0u;
+		m_worldChanged[i] = 1u;
+
+		for ( const auto pMesh : node.m_meshes )
+		{
+			pMesh->update( dt, lerpBetweenFrames );
+		}
+	}
+}
\ No newline at end of file
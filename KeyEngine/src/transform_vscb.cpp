@@ -80,7 +80,6 @@ void TransformVSCB::update( Graphics &gfx,
 
 void TransformVSCB::bindCb( Graphics &gfx ) cond_noex
 {
-	ASSERT( m_pMesh != nullptr, "No Mesh set!" );
 	m_pVscb->bind( gfx );
 }
 
@@ -173,3 +172,30 @@ con::RawLayout TransformScaleVSCB::calcCbLayout()
 	layout.add<con::Float>( "scale" );
 	return layout;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+InstancedTransformVSCB::InstancedTransformVSCB( Graphics &gfx,
+	const unsigned slot )
+	:
+	TransformVSCB{gfx, slot}
+{
+
+}
+
+void InstancedTransformVSCB::bind( Graphics &gfx ) cond_noex
+{
+	const auto view = gfx.getViewMatrix();
+	const auto viewProjection = view * gfx.getProjectionMatrix();
+	update( gfx, {dx::XMMatrixIdentity(), dx::XMMatrixTranspose( view ), dx::XMMatrixTranspose( viewProjection )} );
+	bindCb( gfx );
+}
+
+std::unique_ptr<IBindableCloning> InstancedTransformVSCB::clone() const noexcept
+{
+	return std::make_unique<InstancedTransformVSCB>( *this );
+}
+
+std::unique_ptr<IBindableCloning> InstancedTransformVSCB::clone() noexcept
+{
+	return std::make_unique<InstancedTransformVSCB>( std::move( *this ) );
+}
@@ -30,6 +30,13 @@ void TransparentPass::run( Graphics &gfx ) const cond_noex
 	RenderQueuePass::run( gfx );
 }
 
+void TransparentPass::bindSharedState( Graphics &gfx ) const cond_noex
+{
+	RenderQueuePass::bindSharedState( gfx );
+	ASSERT( m_pActiveCamera, "Main camera is absent!!!" );
+	m_pActiveCamera->makeActive( gfx );
+}
+
 void TransparentPass::setActiveCamera( const Camera &cam ) noexcept
 {
 	m_pActiveCamera = &cam;
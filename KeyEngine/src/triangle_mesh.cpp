@@ -14,6 +14,17 @@ TriangleMesh::TriangleMesh( const ver::VBuffer &vertices,
 	ASSERT( !bMultimesh ? m_indices.size() % 3 == 0 : true, "indices not a multiple of 3!" );
 }
 
+TriangleMesh::TriangleMesh( ver::VBuffer &&vertices,
+	std::vector<unsigned> &&indices,
+	const bool bMultimesh /*= false*/ )
+	:
+	m_vb{std::move( vertices )},
+	m_indices(std::move( indices ))
+{
+	ASSERT( m_vb.getVertexCount() > 2 || ( m_vb.getVertexCount() > 1 && m_indices.size() == 3 /*for line rendering*/), "Insufficient vertices!" );
+	ASSERT( !bMultimesh ? m_indices.size() % 3 == 0 : true, "indices not a multiple of 3!" );
+}
+
 void TriangleMesh::transform( const dx::XMMATRIX &matrix )
 {
 	for ( int i = 0; i < m_vb.getVertexCount(); ++i )
@@ -53,7 +53,7 @@ Component::Component_State::Component_State( Graphics &gfx,
 		{
 			m_color = *color;
 		}
-		m_texture = std::make_shared<Texture>( gfx, image_path, s_texture_slot );
+		m_texture = std::make_shared<Texture>( gfx, image_path, s_texture_slot, nullptr, TextureContent::Ui );
 		++s_texture_slot;
 	}
 
@@ -7,6 +7,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cctype>
+#include <cmath>
 
 
 namespace util
@@ -18,20 +18,31 @@ VertexBuffer::VertexBuffer( Graphics &gfx,
 	const std::string &tag,
 	const ver::VBuffer &vb )
 	:
-	m_stride{static_cast<unsigned>( vb.getLayout().getSizeInBytes() )},
+	VertexBuffer(gfx, tag, vb.getLayout(), vb.data(), vb.getVertexCount())
+{
+
+}
+
+VertexBuffer::VertexBuffer( Graphics &gfx,
+	const std::string &tag,
+	const ver::VertexInputLayout &layout,
+	const void *pVertices,
+	const std::size_t nVertices )
+	:
+	m_stride{static_cast<unsigned>( layout.getSizeInBytes() )},
 	m_tag{tag},
-	m_vertexLayout(vb.getLayout())
+	m_vertexLayout(layout)
 {
 	D3D11_BUFFER_DESC vbDesc{};
 	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vbDesc.Usage = D3D11_USAGE_DEFAULT;
 	vbDesc.CPUAccessFlags = 0u;
 	vbDesc.MiscFlags = 0u;
-	vbDesc.ByteWidth = static_cast<unsigned>( vb.getSizeInBytes() );
+	vbDesc.ByteWidth = static_cast<unsigned>( m_stride * nVertices );
 	vbDesc.StructureByteStride = m_stride;
 
 	D3D11_SUBRESOURCE_DATA subRscData{};
-	subRscData.pSysMem = vb.data();
+	subRscData.pSysMem = pVertices;
 	HRESULT hres = getDevice( gfx )->CreateBuffer( &vbDesc, &subRscData, &m_pVertexBuffer );
 	ASSERT_HRES_IF_FAILED;
 }
@@ -56,6 +67,21 @@ std::shared_ptr<VertexBuffer> VertexBuffer::fetch( Graphics &gfx,
 	return BindableRegistry::fetch<VertexBuffer>( gfx, tag, vb );
 }
 
+std::shared_ptr<VertexBuffer> VertexBuffer::fetch( Graphics &gfx,
+	const std::string &tag,
+	const ver::VertexInputLayout &layout,
+	const void *pVertices,
+	const std::size_t nVertices )
+{
+	ASSERT( tag != "?", "No VertexBuffer tag available!" );
+	return BindableRegistry::fetch<VertexBuffer>( gfx, tag, layout, pVertices, nVertices );
+}
+
+std::shared_ptr<VertexBuffer> VertexBuffer::find( const std::string &tag )
+{
+	return BindableRegistry::find<VertexBuffer>( tag );
+}
+
 std::string VertexBuffer::getUid() const noexcept
 {
 	return calcUid( m_tag );
@@ -0,0 +1,306 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <typeinfo>
+#include <cstdio>
+#include "bindable_registry.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	a Bindable that needs no device; its uid looks like a Texture's
+template<int Tag>
+class MockBindable final
+	: public IBindable
+{
+public:
+	static inline std::atomic<int> s_nConstructed{0};
+	std::string m_path;
+
+	MockBindable( Graphics &,
+		const std::string &path )
+		:
+		m_path{path}
+	{
+		++s_nConstructed;
+	}
+
+	void bind( Graphics & ) cond_noex override
+	{
+
+	}
+
+	static std::string calcUid( const std::string &path )
+	{
+		return typeid( MockBindable ).name() + std::string{"#"} + path;
+	}
+};
+
+using MockTexture = MockBindable<0>;
+using MockSampler = MockBindable<1>;
+
+/// \brief	the mock Bindables never touch the Graphics object, so any storage will do
+Graphics& getGraphics()
+{
+	alignas( std::max_align_t ) static unsigned char s_storage[64];
+	return reinterpret_cast<Graphics&>( s_storage );
+}
+
+/// \brief	releases every Bindable the registry holds; it takes two collections for the ones fetched in the current generation
+void emptyRegistry()
+{
+	BindableRegistry::garbageCollect();
+	BindableRegistry::garbageCollect();
+}
+
+std::vector<std::string> makePaths( const std::size_t n,
+	const std::size_t first = 0u )
+{
+	std::vector<std::string> paths;
+	for ( std::size_t i = first; i < first + n; ++i )
+	{
+		paths.push_back( "assets/models/level/textures/prop_" + std::to_string( i ) + "_diffuse.dds" );
+	}
+	return paths;
+}
+
+/// \brief	the registry BindableRegistry replaced: one string keyed map of every type, dynamic casts on hits & a garbage collection that restarts after every erase
+class StringKeyedRegistry final
+{
+	std::unordered_map<std::string, std::shared_ptr<IBindable>> m_bindableMap;
+public:
+	template<class T>
+	std::shared_ptr<T> fetch( Graphics &gfx,
+		const std::string &path )
+	{
+		const std::string bindableId = T::calcUid( path );
+		const auto elem = m_bindableMap.find( bindableId );
+		if ( elem == m_bindableMap.cend() )
+		{
+			std::shared_ptr<T> bindable = std::make_shared<T>( gfx, path );
+			m_bindableMap[bindableId] = bindable;
+			return bindable;
+		}
+		return std::dynamic_pointer_cast<T>( elem->second );
+	}
+
+	void garbageCollect()
+	{
+		for ( auto it = m_bindableMap.begin(); it != m_bindableMap.end(); ++it )
+		{
+			if ( it->second.use_count() <= 1 )
+			{
+				m_bindableMap.erase( it );
+				it = m_bindableMap.begin();
+				if ( it == m_bindableMap.end() )
+				{
+					break;
+				}
+			}
+		}
+	}
+};
+
+
+}//namespace
+
+TEST_CASE( "BindableRegistry shares Bindables by type & uid", "[bindable_registry]" )
+{
+	Graphics &gfx = getGraphics();
+	const auto pTexture = BindableRegistry::fetch<MockTexture>( gfx, std::string{"a.dds"} );
+	REQUIRE( BindableRegistry::fetch<MockTexture>( gfx, std::string{"a.dds"} ) == pTexture );
+	REQUIRE( BindableRegistry::fetch<MockTexture>( gfx, std::string{"b.dds"} ) != pTexture );
+	// the same arguments of another type get their own Bindable
+	const auto pSampler = BindableRegistry::fetch<MockSampler>( gfx, std::string{"a.dds"} );
+	REQUIRE( pSampler->m_path == "a.dds" );
+	REQUIRE( BindableRegistry::fetch<MockSampler>( gfx, std::string{"a.dds"} ) == pSampler );
+	emptyRegistry();
+}
+
+TEST_CASE( "BindableRegistry find returns registered Bindables without constructing any", "[bindable_registry]" )
+{
+	Graphics &gfx = getGraphics();
+	emptyRegistry();
+	const int nConstructed = MockTexture::s_nConstructed.load();
+	REQUIRE( BindableRegistry::find<MockTexture>( std::string{"found.dds"} ) == nullptr );
+	REQUIRE( MockTexture::s_nConstructed.load() == nConstructed );
+
+	std::weak_ptr<MockTexture> pFound = BindableRegistry::fetch<MockTexture>( gfx, std::string{"found.dds"} );
+	REQUIRE( BindableRegistry::find<MockTexture>( std::string{"found.dds"} ) == pFound.lock() );
+	REQUIRE( BindableRegistry::find<MockSampler>( std::string{"found.dds"} ) == nullptr );
+
+	// a find counts as a fetch for garbage collection
+	BindableRegistry::garbageCollect();
+	REQUIRE( BindableRegistry::find<MockTexture>( std::string{"found.dds"} ) != nullptr );
+	BindableRegistry::garbageCollect();
+	REQUIRE_FALSE( pFound.expired() );
+	emptyRegistry();
+}
+
+TEST_CASE( "BindableRegistry collects unreferenced Bindables a generation after their last fetch", "[bindable_registry]" )
+{
+	Graphics &gfx = getGraphics();
+	emptyRegistry();
+	const auto pHeld = BindableRegistry::fetch<MockTexture>( gfx, std::string{"held.dds"} );
+	std::weak_ptr<MockTexture> pReleased = BindableRegistry::fetch<MockTexture>( gfx, std::string{"released.dds"} );
+	std::weak_ptr<MockTexture> pRefetched = BindableRegistry::fetch<MockTexture>( gfx, std::string{"refetched.dds"} );
+
+	// fetched in the generation that just ended
+	BindableRegistry::garbageCollect();
+	REQUIRE_FALSE( pReleased.expired() );
+	REQUIRE_FALSE( pRefetched.expired() );
+
+	BindableRegistry::fetch<MockTexture>( gfx, std::string{"refetched.dds"} );
+	BindableRegistry::garbageCollect();
+	REQUIRE( pReleased.expired() );
+	REQUIRE_FALSE( pRefetched.expired() );
+	REQUIRE( BindableRegistry::fetch<MockTexture>( gfx, std::string{"held.dds"} ) == pHeld );
+
+	BindableRegistry::garbageCollect();
+	BindableRegistry::garbageCollect();
+	REQUIRE( pRefetched.expired() );
+	REQUIRE( pHeld.use_count() == 2 );
+	emptyRegistry();
+}
+
+TEST_CASE( "BindableRegistry concurrent fetches of a uid return a single Bindable", "[bindable_registry]" )
+{
+	Graphics &gfx = getGraphics();
+	emptyRegistry();
+	constexpr std::size_t nThreads = 8u;
+	const std::vector<std::string> paths = makePaths( 200u );
+	std::vector<std::vector<std::shared_ptr<MockTexture>>> fetched( nThreads );
+	std::atomic<bool> bGarbageCollecting{true};
+	std::vector<std::thread> threads;
+	for ( std::size_t t = 0; t < nThreads; ++t )
+	{
+		threads.emplace_back( [&, t] ()
+			{
+				for ( int rep = 0; rep < 20; ++rep )
+				{
+					fetched[t].clear();
+					for ( std::size_t i = 0; i < paths.size(); ++i )
+					{
+						// every thread walks the uids from a different start, so misses race with each other
+						fetched[t].push_back( BindableRegistry::fetch<MockTexture>( gfx, paths[( i + t * 25 ) % paths.size()] ) );
+					}
+				}
+			} );
+	}
+	// collections don't reclaim Bindables that are referenced
+	std::thread collector{[&] ()
+		{
+			while ( bGarbageCollecting )
+			{
+				BindableRegistry::garbageCollect();
+			}
+		}};
+	for ( auto &thread : threads )
+	{
+		thread.join();
+	}
+	bGarbageCollecting = false;
+	collector.join();
+
+	std::size_t nMismatches = 0;
+	for ( std::size_t t = 0; t < nThreads; ++t )
+	{
+		for ( std::size_t i = 0; i < paths.size(); ++i )
+		{
+			const auto &pBindable = fetched[t][( i + paths.size() - ( t * 25 ) % paths.size() ) % paths.size()];
+			nMismatches += pBindable != fetched[0][i] || pBindable->m_path != paths[i];
+		}
+	}
+	REQUIRE( nMismatches == 0u );
+	fetched.clear();
+	emptyRegistry();
+}
+
+TEST_CASE( "BindableRegistry fetch hit & miss and garbage collection", "[.][benchmark][bindable_registry]" )
+{
+	Graphics &gfx = getGraphics();
+	for ( const std::size_t nBindables : {1000u, 10000u} )
+	{
+		const std::vector<std::string> paths = makePaths( nBindables );
+		std::vector<std::shared_ptr<MockTexture>> held;
+		held.reserve( nBindables );
+
+		// every run misses on new uids
+		constexpr int nMissRuns = 5;
+		std::vector<std::vector<std::string>> missPaths;
+		for ( int i = 0; i < nMissRuns; ++i )
+		{
+			missPaths.push_back( makePaths( nBindables, ( i + 1 ) * nBindables ) );
+		}
+		emptyRegistry();
+		int missRun = 0;
+		const double missMs = test::timeBestOf( nMissRuns,
+			[&] ()
+			{
+				for ( const std::string &path : missPaths[missRun] )
+				{
+					held.push_back( BindableRegistry::fetch<MockTexture>( gfx, path ) );
+				}
+				++missRun;
+			} );
+		held.clear();
+		emptyRegistry();
+		for ( const std::string &path : paths )
+		{
+			held.push_back( BindableRegistry::fetch<MockTexture>( gfx, path ) );
+		}
+		const double hitMs = test::timeBestOf( 10,
+			[&] ()
+			{
+				for ( const std::string &path : paths )
+				{
+					BindableRegistry::fetch<MockTexture>( gfx, path );
+				}
+			} );
+		// half the Bindables are garbage
+		for ( std::size_t i = 0; i < held.size(); i += 2 )
+		{
+			held[i].reset();
+		}
+		BindableRegistry::garbageCollect();
+		const double gcMs = test::timeBestOf( 1,
+			[&] ()
+			{
+				BindableRegistry::garbageCollect();
+			} );
+		held.clear();
+		emptyRegistry();
+
+		StringKeyedRegistry legacy;
+		std::vector<std::shared_ptr<MockTexture>> legacyHeld;
+		for ( const std::string &path : paths )
+		{
+			legacyHeld.push_back( legacy.fetch<MockTexture>( gfx, path ) );
+		}
+		const double legacyHitMs = test::timeBestOf( 10,
+			[&] ()
+			{
+				for ( const std::string &path : paths )
+				{
+					legacy.fetch<MockTexture>( gfx, path );
+				}
+			} );
+		for ( std::size_t i = 0; i < legacyHeld.size(); i += 2 )
+		{
+			legacyHeld[i].reset();
+		}
+		const double legacyGcMs = test::timeBestOf( 1,
+			[&] ()
+			{
+				legacy.garbageCollect();
+			} );
+		std::printf( "%5zu Bindables | fetch hit: hashed %7.3f ms, string keyed %7.3f ms | fetch miss: hashed %7.3f ms | collect half: hashed %7.3f ms, string keyed %9.3f ms\n",
+			nBindables, hitMs, legacyHitMs, missMs, gcMs, legacyGcMs );
+	}
+}
\ No newline at end of file
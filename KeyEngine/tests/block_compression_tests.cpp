@@ -0,0 +1,204 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include "block_compression.h"
+#include "thread_poolj.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+constexpr bc::Format s_compressedFormats[] = {bc::Format::BC1, bc::Format::BC3, bc::Format::BC4, bc::Format::BC5, bc::Format::BC7};
+constexpr bc::Quality s_qualities[] = {bc::Quality::Fast, bc::Quality::Normal, bc::Quality::High};
+
+const char* getFormatName( const bc::Format format )
+{
+	static constexpr const char *s_names[] = {"BGRA8", "BC1", "BC3", "BC4", "BC5", "BC7"};
+	return s_names[static_cast<int>( format )];
+}
+
+const char* getQualityName( const bc::Quality quality )
+{
+	static constexpr const char *s_names[] = {"Fast", "Normal", "High"};
+	return s_names[static_cast<int>( quality )];
+}
+
+/// \brief	smooth gradients with some noise & a varying alpha, like a photo of foliage
+std::vector<ColorBGRA> makePhoto( const unsigned width,
+	const unsigned height,
+	std::mt19937 &rng )
+{
+	std::vector<ColorBGRA> texels( static_cast<std::size_t>( width ) * height );
+	for ( unsigned y = 0; y < height; ++y )
+	{
+		for ( unsigned x = 0; x < width; ++x )
+		{
+			const double v = 0.5 + 0.25 * std::sin( x * 0.05 ) * std::cos( y * 0.07 ) + 0.15 * std::sin( ( x + y ) * 0.31 );
+			const int noise = static_cast<int>( rng() % 11u ) - 5;
+			const auto channel = [v, noise] ( const double scale ) -> Byte
+				{
+					return static_cast<Byte>( std::clamp( static_cast<int>( v * 255 * scale ) + noise, 0, 255 ) );
+				};
+			const Byte alpha = static_cast<Byte>( std::clamp( static_cast<int>( 128 + 120 * std::sin( x * 0.02 + y * 0.03 ) ), 0, 255 ) );
+			texels[static_cast<std::size_t>( y ) * width + x] = ColorBGRA{channel( 1.0 ), channel( 0.8 ), channel( 0.6 ), alpha};
+		}
+	}
+	return texels;
+}
+
+/// \brief	a bumpy surface's unit normals
+std::vector<ColorBGRA> makeNormalMap( const unsigned width,
+	const unsigned height )
+{
+	std::vector<ColorBGRA> texels( static_cast<std::size_t>( width ) * height );
+	for ( unsigned y = 0; y < height; ++y )
+	{
+		for ( unsigned x = 0; x < width; ++x )
+		{
+			const double nx = 0.4 * std::sin( x * 0.09 );
+			const double ny = 0.4 * std::cos( y * 0.11 );
+			const double nz = std::sqrt( 1.0 - nx * nx - ny * ny );
+			const auto toByte = [] ( const double n ) -> Byte
+				{
+					return static_cast<Byte>( std::lround( ( n * 0.5 + 0.5 ) * 255.0 ) );
+				};
+			texels[static_cast<std::size_t>( y ) * width + x] = ColorBGRA{toByte( nx ), toByte( ny ), toByte( nz ), 255};
+		}
+	}
+	return texels;
+}
+
+double calcRoundTripPsnr( const std::vector<ColorBGRA> &texels,
+	const unsigned width,
+	const unsigned height,
+	const bc::Format format,
+	const bc::Quality quality )
+{
+	std::vector<std::uint8_t> blocks( bc::calcSize( width, height, format ) );
+	bc::encode( texels.data(), width, height, format, quality, blocks.data() );
+	std::vector<ColorBGRA> decoded( texels.size() );
+	bc::decode( blocks.data(), width, height, format, decoded.data() );
+	return bc::calcPsnr( texels.data(), decoded.data(), texels.size(), format );
+}
+
+
+}//namespace
+
+TEST_CASE( "bc sizes pad partial blocks", "[block_compression]" )
+{
+	REQUIRE( bc::calcRowPitch( 37u, bc::Format::BGRA8 ) == 37u * 4u );
+	REQUIRE( bc::calcSize( 37u, 21u, bc::Format::BGRA8 ) == 37u * 21u * 4u );
+	// 10x6 blocks
+	REQUIRE( bc::calcRowPitch( 37u, bc::Format::BC1 ) == 10u * 8u );
+	REQUIRE( bc::calcSize( 37u, 21u, bc::Format::BC1 ) == 10u * 6u * 8u );
+	REQUIRE( bc::calcSize( 37u, 21u, bc::Format::BC4 ) == 10u * 6u * 8u );
+	REQUIRE( bc::calcSize( 37u, 21u, bc::Format::BC3 ) == 10u * 6u * 16u );
+	REQUIRE( bc::calcSize( 37u, 21u, bc::Format::BC5 ) == 10u * 6u * 16u );
+	REQUIRE( bc::calcSize( 1u, 1u, bc::Format::BC7 ) == 16u );
+}
+
+TEST_CASE( "bc chooses formats by usage, alpha & quality", "[block_compression]" )
+{
+	REQUIRE( bc::chooseFormat( bc::Usage::Color, false, bc::Quality::Normal ) == bc::Format::BC1 );
+	REQUIRE( bc::chooseFormat( bc::Usage::Color, true, bc::Quality::Normal ) == bc::Format::BC3 );
+	REQUIRE( bc::chooseFormat( bc::Usage::Color, false, bc::Quality::High ) == bc::Format::BC7 );
+	REQUIRE( bc::chooseFormat( bc::Usage::Color, true, bc::Quality::High ) == bc::Format::BC7 );
+	REQUIRE( bc::chooseFormat( bc::Usage::NormalMap, false, bc::Quality::High ) == bc::Format::BC5 );
+	REQUIRE( bc::chooseFormat( bc::Usage::Mask, false, bc::Quality::Normal ) == bc::Format::BC4 );
+}
+
+TEST_CASE( "bc flat blocks round trip losslessly, BC7 to 7 bits", "[block_compression]" )
+{
+	// not a multiple of the block size, so the edge blocks are padded
+	const std::vector<ColorBGRA> texels( 37u * 21u, ColorBGRA{77, 130, 200, 255} );
+	for ( const bc::Format format : s_compressedFormats )
+	{
+		for ( const bc::Quality quality : s_qualities )
+		{
+			INFO( getFormatName( format ) << " " << getQualityName( quality ) );
+			const double psnr = calcRoundTripPsnr( texels, 37u, 21u, format, quality );
+			if ( format == bc::Format::BC7 )
+			{
+				REQUIRE( psnr >= 50.0 );
+			}
+			else
+			{
+				REQUIRE( std::isinf( psnr ) );
+			}
+		}
+	}
+}
+
+TEST_CASE( "bc round trip PSNR of photos & normal maps", "[block_compression]" )
+{
+	ThreadPoolJ::getInstance( 4u );
+	std::mt19937 rng{3u};
+	const std::vector<ColorBGRA> photo = makePhoto( 256u, 256u, rng );
+	const std::vector<ColorBGRA> normalMap = makeNormalMap( 256u, 256u );
+	struct Expectation final
+	{
+		const std::vector<ColorBGRA> &texels;
+		bc::Format format;
+		double minPsnr[3];	// per Quality
+	};
+	const Expectation expectations[] = {
+		{photo, bc::Format::BC1, {36.0, 36.0, 36.0}},
+		{photo, bc::Format::BC3, {37.5, 37.5, 37.5}},
+		{photo, bc::Format::BC4, {42.0, 42.5, 42.5}},
+		{photo, bc::Format::BC5, {42.5, 43.0, 43.0}},
+		{photo, bc::Format::BC7, {38.5, 44.5, 44.5}},
+		{normalMap, bc::Format::BC5, {55.0, 55.0, 55.0}},
+	};
+	for ( const Expectation &expectation : expectations )
+	{
+		double fastPsnr = 0.0;
+		for ( const bc::Quality quality : s_qualities )
+		{
+			const double psnr = calcRoundTripPsnr( expectation.texels, 256u, 256u, expectation.format, quality );
+			INFO( getFormatName( expectation.format ) << " " << getQualityName( quality ) );
+			REQUIRE( psnr >= expectation.minPsnr[static_cast<int>( quality )] );
+			// slower searches never do noticeably worse
+			if ( quality == bc::Quality::Fast )
+			{
+				fastPsnr = psnr;
+			}
+			REQUIRE( psnr >= fastPsnr - 0.05 );
+		}
+	}
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "bc 4k encode & decode throughput", "[.][benchmark][block_compression]" )
+{
+	ThreadPoolJ::getInstance( 1u );
+	constexpr unsigned size = 4096u;
+	constexpr double nTexels = double( size ) * size;
+	std::mt19937 rng{5u};
+	const std::vector<ColorBGRA> photo = makePhoto( size, size, rng );
+	std::vector<ColorBGRA> decoded( photo.size() );
+	for ( const bc::Format format : s_compressedFormats )
+	{
+		std::vector<std::uint8_t> blocks( bc::calcSize( size, size, format ) );
+		for ( const bc::Quality quality : s_qualities )
+		{
+			const double encodeMs = test::timeBestOf( 1,
+				[&] ()
+				{
+					bc::encode( photo.data(), size, size, format, quality, blocks.data() );
+				} );
+			std::printf( "%ux%u on 1 thread | %s %-6s encode %8.1f ms, %7.1f Mtexels/s\n", size, size, getFormatName( format ), getQualityName( quality ), encodeMs, nTexels / encodeMs / 1e3 );
+		}
+		const double decodeMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				bc::decode( blocks.data(), size, size, format, decoded.data() );
+			} );
+		std::printf( "%ux%u on 1 thread | %s decode %8.1f ms, %7.1f Mtexels/s\n", size, size, getFormatName( format ), decodeMs, nTexels / decodeMs / 1e3 );
+	}
+	ThreadPoolJ::resetInstance();
+}
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include "bmp_codec.h"
+#include "cpu_features.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+std::string getTempPath( const std::string &filename )
+{
+	return ( std::filesystem::temp_directory_path() / filename ).string();
+}
+
+std::vector<ColorBGRA> makeImage( const unsigned width,
+	const unsigned height,
+	const std::uint32_t seed )
+{
+	std::mt19937 rng{seed};
+	std::vector<ColorBGRA> image( static_cast<std::size_t>( width ) * height );
+	for ( ColorBGRA &texel : image )
+	{
+		texel = ColorBGRA{static_cast<unsigned>( rng() )};
+	}
+	return image;
+}
+
+std::vector<ColorBGRA> readImage( const std::string &filename )
+{
+	const bmp::BmpReader reader{filename};
+	std::vector<ColorBGRA> image( static_cast<std::size_t>( reader.getWidth() ) * reader.getHeight() );
+	reader.read( image.data() );
+	return image;
+}
+
+/// \brief	a .bmp with a 40 byte info header followed by the bitfield masks & palette, if any
+/// \brief	texel( x, y ) is the bitCount / 8 byte texel of row y, 0 being the top row
+std::vector<std::uint8_t> makeBmp( const unsigned width,
+	const unsigned height,
+	const unsigned bitCount,
+	const std::uint32_t compression,
+	const std::vector<std::uint32_t> &masks,
+	const std::vector<std::uint32_t> &palette,
+	const bool bTopDown,
+	const std::function<std::uint32_t( unsigned, unsigned )> &texel )
+{
+	const std::size_t rowStride = ( ( static_cast<std::size_t>( width ) * bitCount + 31 ) / 32 ) * 4;
+	const std::size_t dataOffset = 54u + 4u * ( masks.size() + palette.size() );
+	std::vector<std::uint8_t> file( dataOffset + rowStride * height );
+	const auto writeU32 = [&file] ( const std::size_t offset, const std::uint32_t value )
+		{
+			for ( int i = 0; i < 4; ++i )
+			{
+				file[offset + i] = static_cast<std::uint8_t>( value >> ( 8 * i ) );
+			}
+		};
+	file[0] = 'B';
+	file[1] = 'M';
+	writeU32( 2, static_cast<std::uint32_t>( file.size() ) );
+	writeU32( 10, static_cast<std::uint32_t>( dataOffset ) );
+	writeU32( 14, 40u );
+	writeU32( 18, width );
+	writeU32( 22, bTopDown ? static_cast<std::uint32_t>( -static_cast<std::int32_t>( height ) ) : height );
+	file[26] = 1;
+	file[28] = static_cast<std::uint8_t>( bitCount );
+	writeU32( 30, compression );
+	writeU32( 46, static_cast<std::uint32_t>( palette.size() ) );
+	for ( std::size_t i = 0; i < masks.size(); ++i )
+	{
+		writeU32( 54 + 4 * i, masks[i] );
+	}
+	for ( std::size_t i = 0; i < palette.size(); ++i )
+	{
+		writeU32( 54 + 4 * ( masks.size() + i ), palette[i] );
+	}
+	for ( unsigned y = 0; y < height; ++y )
+	{
+		const std::size_t fileRow = bTopDown ?
+			y :
+			height - 1 - y;
+		for ( unsigned x = 0; x < width; ++x )
+		{
+			const std::uint32_t value = texel( x, y );
+			for ( unsigned i = 0; i < bitCount / 8; ++i )
+			{
+				file[dataOffset + fileRow * rowStride + x * bitCount / 8 + i] = static_cast<std::uint8_t>( value >> ( 8 * i ) );
+			}
+		}
+	}
+	return file;
+}
+
+void writeFile( const std::string &filename,
+	const std::vector<std::uint8_t> &bytes )
+{
+	std::ofstream file{filename, std::ios::binary};
+	file.write( reinterpret_cast<const char*>( bytes.data() ), bytes.size() );
+}
+
+/// \brief	the bit replication of an nBits wide channel value to 8 bits
+unsigned expand( const unsigned value,
+	const unsigned nBits )
+{
+	return ( value << ( 8 - nBits ) ) | ( value >> ( 2 * nBits - 8 ) );
+}
+
+/// \brief	the 24 bit codec paths the CPU can run: SSSE3 & scalar or just scalar
+std::vector<util::CpuFeatures> makeCodecPaths()
+{
+	std::vector<util::CpuFeatures> paths{util::CpuFeatures{false, false, false}};
+	if ( util::getCpuFeatures().bSsse3 )
+	{
+		paths.push_back( util::CpuFeatures{true, true, true} );
+	}
+	return paths;
+}
+
+
+}//namespace
+
+TEST_CASE( "bmp 24 & 32 bit images round trip on every path", "[bmp_codec]" )
+{
+	const std::string filename = getTempPath( "key_engine_bmp_codec_round_trip.bmp" );
+	for ( const util::CpuFeatures &path : makeCodecPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		for ( const unsigned width : {1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u, 13u, 16u, 17u, 31u, 64u, 101u} )
+		{
+			for ( const unsigned height : {1u, 3u, 7u} )
+			{
+				const std::vector<ColorBGRA> image = makeImage( width, height, width * 31 + height );
+				bmp::write( filename, width, height, image.data(), 24u );
+				const std::vector<ColorBGRA> image24 = readImage( filename );
+				bmp::write( filename, width, height, image.data(), 32u );
+				const std::vector<ColorBGRA> image32 = readImage( filename );
+				std::size_t nMismatches = 0;
+				for ( std::size_t i = 0; i < image.size(); ++i )
+				{
+					nMismatches += image24[i].m_dword != ( image[i].m_dword | 0xFF000000u );
+					nMismatches += image32[i].m_dword != image[i].m_dword;
+				}
+				REQUIRE( nMismatches == 0u );
+			}
+		}
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+	std::filesystem::remove( filename );
+}
+
+TEST_CASE( "bmp rows decode in any order", "[bmp_codec]" )
+{
+	const std::string filename = getTempPath( "key_engine_bmp_codec_rows.bmp" );
+	constexpr unsigned width = 37u;
+	constexpr unsigned height = 29u;
+	const std::vector<ColorBGRA> image = makeImage( width, height, 8u );
+	bmp::write( filename, width, height, image.data(), 24u );
+	{
+		const bmp::BmpReader reader{filename};
+		REQUIRE( reader.getHeader().bitCount == 24u );
+		REQUIRE_FALSE( reader.getHeader().bTopDown );
+		std::vector<ColorBGRA> row( width );
+		std::size_t nMismatches = 0;
+		for ( unsigned i = 0; i < height; ++i )
+		{
+			const unsigned y = ( i * 11 ) % height;
+			reader.readRow( y, row.data() );
+			for ( unsigned x = 0; x < width; ++x )
+			{
+				nMismatches += row[x].m_dword != ( image[y * width + x].m_dword | 0xFF000000u );
+			}
+		}
+		REQUIRE( nMismatches == 0u );
+	}
+	std::filesystem::remove( filename );
+}
+
+TEST_CASE( "bmp 32 bit BI_RGB files are opaque unless a texel has alpha", "[bmp_codec]" )
+{
+	const std::string filename = getTempPath( "key_engine_bmp_codec_alpha.bmp" );
+	constexpr unsigned width = 19u;
+	constexpr unsigned height = 5u;
+	std::vector<ColorBGRA> image = makeImage( width, height, 3u );
+	for ( ColorBGRA &texel : image )
+	{
+		texel.m_dword &= 0x00FFFFFFu;
+	}
+	bmp::write( filename, width, height, image.data(), 32u );
+	{
+		const bmp::BmpReader reader{filename};
+		REQUIRE( reader.getHeader().alphaMask == 0u );
+	}
+	std::vector<ColorBGRA> decoded = readImage( filename );
+	std::size_t nMismatches = 0;
+	for ( std::size_t i = 0; i < image.size(); ++i )
+	{
+		nMismatches += decoded[i].m_dword != ( image[i].m_dword | 0xFF000000u );
+	}
+	REQUIRE( nMismatches == 0u );
+
+	// a single translucent texel in the last row makes the 0 alphas transparent
+	image.back().m_dword |= 0x80000000u;
+	bmp::write( filename, width, height, image.data(), 32u );
+	{
+		const bmp::BmpReader reader{filename};
+		REQUIRE( reader.getHeader().alphaMask == 0xFF000000u );
+	}
+	decoded = readImage( filename );
+	for ( std::size_t i = 0; i < image.size(); ++i )
+	{
+		nMismatches += decoded[i].m_dword != image[i].m_dword;
+	}
+	REQUIRE( nMismatches == 0u );
+	std::filesystem::remove( filename );
+}
+
+TEST_CASE( "bmp decodes palettized, 16 bit & bitfield files", "[bmp_codec]" )
+{
+	const std::string filename = getTempPath( "key_engine_bmp_codec_formats.bmp" );
+	// wide enough for the 8 texel SSE2 16 bit decode & a scalar tail
+	constexpr unsigned width = 21u;
+	constexpr unsigned height = 6u;
+	const auto hash = [] ( const unsigned x, const unsigned y ) -> std::uint32_t
+		{
+			return ( x * 2654435761u ) ^ ( y * 40503u + 0x9E37u );
+		};
+
+	for ( const bool bTopDown : {false, true} )
+	{
+		std::vector<std::uint32_t> palette;
+		for ( std::uint32_t i = 0; i < 200u; ++i )
+		{
+			palette.push_back( i * 0x00010203u );
+		}
+		writeFile( filename, makeBmp( width, height, 8u, 0u, {}, palette, bTopDown,
+			[&] ( const unsigned x, const unsigned y ) { return hash( x, y ) % 200u; } ) );
+		std::vector<ColorBGRA> decoded = readImage( filename );
+		std::size_t nMismatches = 0;
+		for ( unsigned y = 0; y < height; ++y )
+		{
+			for ( unsigned x = 0; x < width; ++x )
+			{
+				nMismatches += decoded[y * width + x].m_dword != ( palette[hash( x, y ) % 200u] | 0xFF000000u );
+			}
+		}
+		REQUIRE( nMismatches == 0u );
+
+		// BI_RGB 16 bit is 555
+		writeFile( filename, makeBmp( width, height, 16u, 0u, {}, {}, bTopDown,
+			[&] ( const unsigned x, const unsigned y ) { return hash( x, y ) & 0x7FFFu; } ) );
+		decoded = readImage( filename );
+		for ( unsigned y = 0; y < height; ++y )
+		{
+			for ( unsigned x = 0; x < width; ++x )
+			{
+				const std::uint32_t texel = hash( x, y );
+				const std::uint32_t expected = 0xFF000000u | ( expand( ( texel >> 10 ) & 31, 5 ) << 16 ) | ( expand( ( texel >> 5 ) & 31, 5 ) << 8 ) | expand( texel & 31, 5 );
+				nMismatches += decoded[y * width + x].m_dword != expected;
+			}
+		}
+		REQUIRE( nMismatches == 0u );
+
+		// BI_BITFIELDS 565
+		writeFile( filename, makeBmp( width, height, 16u, 3u, {0xF800u, 0x07E0u, 0x001Fu}, {}, bTopDown,
+			[&] ( const unsigned x, const unsigned y ) { return hash( x, y ) & 0xFFFFu; } ) );
+		decoded = readImage( filename );
+		for ( unsigned y = 0; y < height; ++y )
+		{
+			for ( unsigned x = 0; x < width; ++x )
+			{
+				const std::uint32_t texel = hash( x, y );
+				const std::uint32_t expected = 0xFF000000u | ( expand( ( texel >> 11 ) & 31, 5 ) << 16 ) | ( expand( ( texel >> 5 ) & 63, 6 ) << 8 ) | expand( texel & 31, 5 );
+				nMismatches += decoded[y * width + x].m_dword != expected;
+			}
+		}
+		REQUIRE( nMismatches == 0u );
+
+		// BI_ALPHABITFIELDS RGBA byte order
+		writeFile( filename, makeBmp( width, height, 32u, 6u, {0x000000FFu, 0x0000FF00u, 0x00FF0000u, 0xFF000000u}, {}, bTopDown,
+			[&] ( const unsigned x, const unsigned y ) { return hash( x, y ); } ) );
+		decoded = readImage( filename );
+		for ( unsigned y = 0; y < height; ++y )
+		{
+			for ( unsigned x = 0; x < width; ++x )
+			{
+				const std::uint32_t texel = hash( x, y );
+				const std::uint32_t expected = ( texel & 0xFF00FF00u ) | ( ( texel & 0xFFu ) << 16 ) | ( ( texel >> 16 ) & 0xFFu );
+				nMismatches += decoded[y * width + x].m_dword != expected;
+			}
+		}
+		REQUIRE( nMismatches == 0u );
+	}
+	std::filesystem::remove( filename );
+}
+
+TEST_CASE( "bmp 4k encode & decode throughput", "[.][benchmark][bmp_codec]" )
+{
+	const std::string filename = getTempPath( "key_engine_bmp_codec_benchmark.bmp" );
+	constexpr unsigned width = 4096u;
+	constexpr unsigned height = 4096u;
+	const double nMegabytes = double( width ) * height * sizeof( ColorBGRA ) / ( 1024.0 * 1024.0 );
+	std::vector<ColorBGRA> image = makeImage( width, height, 1u );
+	std::vector<ColorBGRA> decoded( image.size() );
+	const auto run = [&] ( const unsigned bitCount, const char *description )
+		{
+			const double writeMs = test::timeBestOf( 3,
+				[&] ()
+				{
+					bmp::write( filename, width, height, image.data(), bitCount );
+				} );
+			double openMs = 0.0;
+			double readMs = 0.0;
+			{
+				const auto start = std::chrono::steady_clock::now();
+				const bmp::BmpReader reader{filename};
+				openMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+				readMs = test::timeBestOf( 5,
+					[&] ()
+					{
+						reader.read( decoded.data() );
+					} );
+			}
+			std::printf( "4096x4096 %s | write %7.2f ms | open %6.2f ms | decode %7.2f ms, %7.1f MB/s of BGRA8\n",
+				description, writeMs, openMs, readMs, nMegabytes / readMs * 1e3 );
+		};
+
+	for ( const util::CpuFeatures &path : makeCodecPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		run( 24u, path.bSsse3 ? "24 bit SSSE3          " : "24 bit scalar         " );
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+	run( 32u, "32 bit alpha          " );
+	// the open scans every texel for alpha
+	for ( ColorBGRA &texel : image )
+	{
+		texel.m_dword &= 0x00FFFFFFu;
+	}
+	run( 32u, "32 bit BI_RGB opaque  " );
+	std::filesystem::remove( filename );
+}
\ No newline at end of file
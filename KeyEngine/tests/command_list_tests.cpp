@@ -0,0 +1,239 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <random>
+#include "command_list.h"
+
+
+namespace
+{
+
+/// \brief	a backend that emulates a d3d11 context's state: every task binds its shared state to a slot & then draws
+/// \brief	a deferred context starts from the default state & executing a command list resets the immediate context to it
+/// \brief	draws are checked against the state a serial run on the immediate context would have left at that point
+class StateTrackingBackend final
+	: public ren::ICommandListBackend
+{
+	struct Command final
+	{
+		bool bDraw;
+		int slot;
+		int value;	// the task that drew or bound the slot
+	};
+
+	static inline thread_local std::vector<Command> *s_pRecordingList = nullptr;
+
+	std::vector<std::vector<Command>> m_commandLists;
+	std::vector<int> m_immediateState;
+	int m_nSlots;
+public:
+	std::vector<int> draws;
+	std::size_t nWrongStates = 0u;
+
+	explicit StateTrackingBackend( const int nSlots )
+		:
+		m_immediateState( nSlots, -1 ),
+		m_nSlots{nSlots}
+	{
+
+	}
+
+	void reserve( const std::size_t nCommandLists ) override
+	{
+		if ( m_commandLists.size() < nCommandLists )
+		{
+			m_commandLists.resize( nCommandLists );
+		}
+	}
+
+	void beginRecording( const std::size_t index ) override
+	{
+		m_commandLists[index].clear();
+		s_pRecordingList = &m_commandLists[index];
+	}
+
+	void finishRecording( const std::size_t ) override
+	{
+		s_pRecordingList = nullptr;
+	}
+
+	void execute( const std::size_t index ) override
+	{
+		m_immediateState.assign( m_nSlots, -1 );
+		for ( const Command &command : m_commandLists[index] )
+		{
+			issue( command );
+		}
+		m_immediateState.assign( m_nSlots, -1 );
+	}
+
+	int getSlot( const int task ) const noexcept
+	{
+		return task % m_nSlots;
+	}
+
+	void bindTaskState( const int task )
+	{
+		submit( {false, getSlot( task ), task} );
+	}
+
+	void draw( const int task )
+	{
+		submit( {true, getSlot( task ), task} );
+	}
+
+	/// \brief	the state after running tasks [0, nTasks) one by one
+	std::vector<int> getSerialState( const int nTasks ) const
+	{
+		std::vector<int> state( m_nSlots, -1 );
+		for ( int i = 0; i < nTasks; ++i )
+		{
+			state[getSlot( i )] = i;
+		}
+		return state;
+	}
+
+	const std::vector<int>& getImmediateState() const noexcept
+	{
+		return m_immediateState;
+	}
+private:
+	void submit( const Command &command )
+	{
+		if ( s_pRecordingList != nullptr )
+		{
+			s_pRecordingList->push_back( command );
+		}
+		else
+		{
+			issue( command );
+		}
+	}
+
+	void issue( const Command &command )
+	{
+		if ( !command.bDraw )
+		{
+			m_immediateState[command.slot] = command.value;
+			return;
+		}
+		draws.push_back( command.value );
+		nWrongStates += m_immediateState != getSerialState( command.value + 1 );
+	}
+};
+
+
+}//namespace
+
+TEST_CASE( "CommandListScheduler replays tasks in order with the state of a serial run", "[command_list]" )
+{
+	ThreadPoolJ::getInstance( 4u );
+	std::mt19937 rng{1u};
+	for ( int rep = 0; rep < 500; ++rep )
+	{
+		const int nTasks = rng() % 13;
+		StateTrackingBackend backend{1 + static_cast<int>( rng() % 3 )};
+		ren::CommandListScheduler scheduler{backend, 1u + static_cast<unsigned>( rng() % 4 )};
+		std::vector<bool> recordable( nTasks );
+		std::size_t nRecordable = 0;
+		for ( int i = 0; i < nTasks; ++i )
+		{
+			recordable[i] = rng() % 2 == 0;
+			nRecordable += recordable[i];
+		}
+
+		const std::size_t nRecorded = scheduler.run( nTasks,
+			[&] ( const std::size_t i ) -> bool
+			{
+				return recordable[i];
+			},
+			[&] ( const std::size_t i ) -> void
+			{
+				backend.bindTaskState( static_cast<int>( i ) );
+				backend.draw( static_cast<int>( i ) );
+			},
+			[&] ( const std::size_t i ) -> void
+			{
+				backend.bindTaskState( static_cast<int>( i ) );
+			} );
+
+		REQUIRE( nRecorded == ( nRecordable < 2 ? 0u : nRecordable ) );
+		REQUIRE( backend.draws.size() == static_cast<std::size_t>( nTasks ) );
+		for ( int i = 0; i < nTasks; ++i )
+		{
+			REQUIRE( backend.draws[i] == i );
+		}
+		REQUIRE( backend.nWrongStates == 0u );
+		// the Passes after the scheduled ones (eg. the final post process) find the immediate context as a serial run leaves it
+		REQUIRE( backend.getImmediateState() == backend.getSerialState( nTasks ) );
+	}
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "CommandListScheduler runs everything on the immediate context unless two tasks can overlap", "[command_list]" )
+{
+	ThreadPoolJ::getInstance( 4u );
+	ren::NullCommandListBackend backend;
+	ren::CommandListScheduler scheduler{backend, 4u};
+	for ( const std::size_t recordableTask : {0u, 2u, 5u} )
+	{
+		backend.clear();
+		const std::size_t nRecorded = scheduler.run( 4u,
+			[&] ( const std::size_t i ) -> bool
+			{
+				return i == recordableTask;
+			},
+			[&] ( const std::size_t i ) -> void
+			{
+				backend.submit( static_cast<std::uint32_t>( i ) );
+			},
+			[&] ( const std::size_t i ) -> void
+			{
+				backend.submit( 1000u + static_cast<std::uint32_t>( i ) );
+			} );
+		REQUIRE( nRecorded == 0u );
+		REQUIRE( backend.getNumStateResets() == 0u );
+		REQUIRE( backend.getImmediateCommands() == std::vector<std::uint32_t>{0u, 1u, 2u, 3u} );
+	}
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "CommandListScheduler records many Passes on every thread", "[command_list]" )
+{
+	ThreadPoolJ::getInstance( 4u );
+	ren::NullCommandListBackend backend;
+	ren::CommandListScheduler scheduler{backend, 4u};
+	constexpr std::uint32_t nTasks = 64u;
+	for ( int rep = 0; rep < 20; ++rep )
+	{
+		backend.clear();
+		const std::size_t nRecorded = scheduler.run( nTasks,
+			[] ( const std::size_t i ) -> bool
+			{
+				return i % 8 != 7;
+			},
+			[&] ( const std::size_t i ) -> void
+			{
+				// a Pass' draw calls
+				for ( std::uint32_t draw = 0; draw < 100u; ++draw )
+				{
+					backend.submit( static_cast<std::uint32_t>( i ) * 100u + draw );
+				}
+			},
+			[] ( const std::size_t ) -> void
+			{
+
+			} );
+		REQUIRE( nRecorded == nTasks / 8 * 7 );
+		// one reset per executed command list
+		REQUIRE( backend.getNumStateResets() == nRecorded );
+		const auto &commands = backend.getImmediateCommands();
+		REQUIRE( commands.size() == nTasks * 100u );
+		std::size_t nMisordered = 0;
+		for ( std::uint32_t i = 0; i < commands.size(); ++i )
+		{
+			nMisordered += commands[i] != i;
+		}
+		REQUIRE( nMisordered == 0u );
+	}
+	ThreadPoolJ::resetInstance();
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include "cpu_framebuffer.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	copies the front buffer's upload rects into gpu, as Texture::update does
+void upload( const CpuFramebuffer &fb,
+	std::vector<ColorBGRA> &gpu )
+{
+	const unsigned width = fb.getWidth();
+	for ( const CpuFramebuffer::Rect &rect : fb.getUploadRects() )
+	{
+		for ( unsigned y = rect.top; y < rect.bottom; ++y )
+		{
+			const std::size_t row = static_cast<std::size_t>( y ) * width;
+			std::copy_n( fb.getFrontBuffer() + row + rect.left, rect.right - rect.left, &gpu[row + rect.left] );
+		}
+	}
+}
+
+bool isCleared( CpuFramebuffer &fb )
+{
+	const ColorBGRA *pPixels = fb.getBackBuffer();
+	return std::all_of( pPixels, pPixels + static_cast<std::size_t>( fb.getWidth() ) * fb.getHeight(),
+		[] ( const ColorBGRA color )
+		{
+			return color.m_dword == 0u;
+		} );
+}
+
+/// \brief	40 scattered 24x24 squares, like a HUD
+template<typename F>
+void drawHud( const unsigned width,
+	const unsigned height,
+	F &&putPixel )
+{
+	for ( unsigned i = 0; i < 40u; ++i )
+	{
+		const unsigned x0 = i * 397u % ( width - 64u );
+		const unsigned y0 = i * 211u % ( height - 64u );
+		for ( unsigned y = y0; y < y0 + 24u; ++y )
+		{
+			for ( unsigned x = x0; x < x0 + 24u; ++x )
+			{
+				putPixel( x, y );
+			}
+		}
+	}
+}
+
+
+}//namespace
+
+TEST_CASE( "cpu framebuffer uploads reproduce randomized frames", "[cpu_framebuffer]" )
+{
+	struct Config final
+	{
+		unsigned width;
+		unsigned height;
+		bool bDoubleBuffered;
+	};
+	// not multiples of the tile size, so the edge tiles are partial
+	const Config configs[] = {
+		{333u, 257u, false},
+		{333u, 257u, true},
+		{2640u, 1480u, false},
+		{2640u, 1480u, true},
+	};
+	std::mt19937 rng{1u};
+	for ( const Config &config : configs )
+	{
+		const unsigned width = config.width;
+		const unsigned height = config.height;
+		INFO( width << "x" << height << ( config.bDoubleBuffered ? " double buffered" : " single buffered" ) );
+		CpuFramebuffer fb{width, height, config.bDoubleBuffered};
+		// garbage, the GPU texture's initial contents aren't known
+		std::vector<ColorBGRA> gpu( static_cast<std::size_t>( width ) * height, ColorBGRA{0xDEADBEEFu} );
+		for ( int frame = 0; frame < 200; ++frame )
+		{
+			INFO( "frame " << frame );
+			fb.beginFrame();
+			REQUIRE( isCleared( fb ) );
+			std::vector<ColorBGRA> expected( gpu.size() );
+			// every 3rd frame is busy enough to overflow the upload rects
+			const unsigned nRects = frame % 3 == 2 ? 400u : rng() % 6u;
+			for ( unsigned i = 0; i < nRects; ++i )
+			{
+				const bool bDirect = rng() % 2u != 0;
+				const unsigned x0 = rng() % width;
+				const unsigned y0 = rng() % height;
+				const unsigned w = 1u + rng() % 90u;
+				const unsigned h = 1u + rng() % 90u;
+				const ColorBGRA color{static_cast<unsigned>( rng() | 1u )};
+				for ( unsigned y = y0; y < std::min( height, y0 + h ); ++y )
+				{
+					for ( unsigned x = x0; x < std::min( width, x0 + w ); ++x )
+					{
+						const std::size_t index = static_cast<std::size_t>( y ) * width + x;
+						if ( bDirect )
+						{
+							fb.getBackBuffer()[index] = color;
+						}
+						else
+						{
+							fb.putPixel( x, y, color );
+						}
+						expected[index] = color;
+					}
+				}
+				if ( bDirect )
+				{
+					// may hang off the bottom right
+					fb.markDirty( {x0, y0, x0 + w, y0 + h} );
+				}
+			}
+			fb.endFrame();
+
+			REQUIRE( fb.getUploadRects().size() <= CpuFramebuffer::s_maxUploadRects );
+			for ( const CpuFramebuffer::Rect &rect : fb.getUploadRects() )
+			{
+				REQUIRE( rect.left < rect.right );
+				REQUIRE( rect.top < rect.bottom );
+				REQUIRE( rect.right <= width );
+				REQUIRE( rect.bottom <= height );
+			}
+			upload( fb, gpu );
+			REQUIRE( gpu == expected );
+		}
+	}
+}
+
+TEST_CASE( "cpu framebuffer merges adjacent dirty tiles into one rect", "[cpu_framebuffer]" )
+{
+	CpuFramebuffer fb{1000u, 1000u};
+	// the first frame uploads everything
+	fb.beginFrame();
+	fb.endFrame();
+	REQUIRE( fb.getUploadRects().size() == 1u );
+	REQUIRE( fb.getUploadRects()[0].right == 1000u );
+	REQUIRE( fb.getUploadRects()[0].bottom == 1000u );
+
+	fb.beginFrame();
+	// a solid 3x2 block of tiles & a lone pixel
+	fb.markDirty( {64u, 64u, 256u, 192u} );
+	fb.markDirty( {600u, 600u, 601u, 601u} );
+	fb.endFrame();
+	const std::vector<CpuFramebuffer::Rect> &rects = fb.getUploadRects();
+	REQUIRE( rects.size() == 2u );
+	REQUIRE( rects[0].left == 64u );
+	REQUIRE( rects[0].top == 64u );
+	REQUIRE( rects[0].right == 256u );
+	REQUIRE( rects[0].bottom == 192u );
+	REQUIRE( rects[1].left == 576u );
+	REQUIRE( rects[1].top == 576u );
+	REQUIRE( rects[1].right == 640u );
+	REQUIRE( rects[1].bottom == 640u );
+	REQUIRE( fb.isTileDirty( 1u, 1u ) );
+	REQUIRE( fb.isTileDirty( 9u, 9u ) );
+	REQUIRE_FALSE( fb.isTileDirty( 0u, 0u ) );
+}
+
+TEST_CASE( "cpu framebuffer 4k sparse frame upload", "[.][benchmark][cpu_framebuffer]" )
+{
+	constexpr unsigned width = 3840u;
+	constexpr unsigned height = 2160u;
+	constexpr int nFrames = 100;
+	constexpr std::size_t nPixels = static_cast<std::size_t>( width ) * height;
+	const ColorBGRA green{0xFF00FF00u};
+	std::vector<ColorBGRA> pixels( nPixels );
+	std::vector<ColorBGRA> gpu( nPixels );
+
+	const double fullMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			for ( int frame = 0; frame < nFrames; ++frame )
+			{
+				std::fill_n( pixels.data(), nPixels, ColorBGRA{} );
+				drawHud( width, height,
+					[&] ( const unsigned x, const unsigned y )
+					{
+						pixels[static_cast<std::size_t>( y ) * width + x] = green;
+					} );
+				std::copy_n( pixels.data(), nPixels, gpu.data() );
+			}
+		} ) / nFrames;
+
+	CpuFramebuffer fb{width, height};
+	std::size_t nUploaded = 0;
+	const double tiledMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			nUploaded = 0;
+			for ( int frame = 0; frame < nFrames; ++frame )
+			{
+				fb.beginFrame();
+				drawHud( width, height,
+					[&] ( const unsigned x, const unsigned y )
+					{
+						fb.putPixel( x, y, green );
+					} );
+				fb.endFrame();
+				upload( fb, gpu );
+				for ( const CpuFramebuffer::Rect &rect : fb.getUploadRects() )
+				{
+					nUploaded += static_cast<std::size_t>( rect.right - rect.left ) * ( rect.bottom - rect.top );
+				}
+			}
+		} ) / nFrames;
+	std::printf( "%ux%u per frame | full clear & copy %6.3f ms, tiled %6.3f ms uploading %4.1f%% of the pixels\n", width, height, fullMs, tiledMs, 100.0 * nUploaded / nFrames / nPixels );
+}
\ No newline at end of file
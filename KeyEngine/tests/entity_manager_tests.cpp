@@ -0,0 +1,219 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <new>
+#include <algorithm>
+#include <cstdio>
+#include "entity_manager.h"
+#include "archetype.h"
+#include "thread_poolj.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	a component that keeps count of its live instances; moved-from instances still count until destroyed
+struct Counted final
+{
+	static inline int s_nAlive = 0;
+	int value;
+	std::string name;
+
+	explicit Counted( const int val )
+		:
+		value{val},
+		name{"counted " + std::to_string( val )}
+	{
+		++s_nAlive;
+	}
+
+	Counted( Counted &&rhs ) noexcept
+		:
+		value{rhs.value},
+		name{std::move( rhs.name )}
+	{
+		++s_nAlive;
+	}
+
+	Counted& operator=( Counted &&rhs ) noexcept
+	{
+		value = rhs.value;
+		name = std::move( rhs.name );
+		return *this;
+	}
+
+	~Counted() noexcept
+	{
+		--s_nAlive;
+	}
+};
+
+struct Position final
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct Velocity final
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct Health final
+{
+	float hp;
+	float regen;
+};
+
+/// \brief	resets the EntityManager singleton when the test case ends, whatever its outcome
+struct ManagerScope final
+{
+	EntityManager &em = EntityManager::getInstance();
+
+	~ManagerScope() noexcept
+	{
+		EntityManager::resetInstance();
+	}
+};
+
+
+}//namespace
+
+TEST_CASE( "Archetype destroys the components of its live rows", "[ecs]" )
+{
+	Counted::s_nAlive = 0;
+	{
+		Archetype archetype{ComponentRegistry::getMask<Counted, Position>()};
+		const ComponentTypeId countedId = ComponentRegistry::getId<Counted>();
+		// spans several chunks
+		const std::size_t nRows = archetype.getChunkCapacity() * 3 + 5;
+		for ( std::size_t i = 0; i < nRows; ++i )
+		{
+			const std::uint32_t row = archetype.allocateRow( static_cast<EntityId>( i ) );
+			new( archetype.getComponent( countedId, row ) ) Counted( static_cast<int>( i ) );
+			new( archetype.getComponent( ComponentRegistry::getId<Position>(), row ) ) Position{};
+		}
+		REQUIRE( archetype.getChunkCount() == 4u );
+		REQUIRE( Counted::s_nAlive == static_cast<int>( nRows ) );
+
+		archetype.destroyRowComponents( 0u );
+		archetype.removeRow( 0u );
+		REQUIRE( Counted::s_nAlive == static_cast<int>( nRows - 1 ) );
+	}
+	REQUIRE( Counted::s_nAlive == 0 );
+}
+
+TEST_CASE( "EntityManager destroys every component on reset", "[ecs]" )
+{
+	Counted::s_nAlive = 0;
+	{
+		ManagerScope scope;
+		std::vector<EntityId> ids;
+		for ( int i = 0; i < 3000; ++i )
+		{
+			ids.push_back( scope.em.spawnEntity( "e" + std::to_string( i ), 0 ) );
+			scope.em.addComponent<Counted>( ids.back(), i );
+			if ( i % 2 == 0 )
+			{
+				scope.em.addComponent<Position>( ids.back(), Position{float( i ), 0.0f, 0.0f} );
+			}
+		}
+		REQUIRE( Counted::s_nAlive == 3000 );
+
+		// structural changes move components between archetypes without leaking or double destroying them
+		int nExpected = 3000;
+		for ( int i = 0; i < 3000; i += 3 )
+		{
+			REQUIRE( scope.em.removeComponent<Counted>( ids[i] ) );
+			--nExpected;
+		}
+		for ( int i = 1; i < 3000; i += 3 )
+		{
+			scope.em.recycleEntityId( ids[i] );
+			--nExpected;
+		}
+		for ( int i = 2; i < 3000; i += 6 )
+		{
+			scope.em.removeComponent<Position>( ids[i] );
+		}
+		REQUIRE( Counted::s_nAlive == nExpected );
+
+		int nVisited = 0;
+		bool bValuesIntact = true;
+		scope.em.forEach<const Counted>( [&] ( const EntityId, const Counted &counted )
+			{
+				++nVisited;
+				bValuesIntact = bValuesIntact && counted.name == "counted " + std::to_string( counted.value );
+			} );
+		REQUIRE( nVisited == nExpected );
+		REQUIRE( bValuesIntact );
+	}
+	REQUIRE( Counted::s_nAlive == 0 );
+}
+
+#ifdef _64_BIT_ENTITY
+TEST_CASE( "EntityManager 1M entities forEach & parallelForEach mutation", "[.][benchmark][ecs]" )
+{
+	constexpr std::size_t nEntities = 1000000u;
+	constexpr float dt = 1.0f / 60.0f;
+	ManagerScope scope;
+	ThreadPoolJ::getInstance( 4u );
+
+	// 2 archetypes: every entity moves, every other one also heals
+	const double spawnMs = test::timeBestOf( 1,
+		[&] ()
+		{
+			for ( std::size_t i = 0; i < nEntities; ++i )
+			{
+				const EntityId id = scope.em.spawnEntity( "e", 0 );
+				scope.em.addComponent<Position>( id, Position{float( i ), 0.0f, 0.0f} );
+				scope.em.addComponent<Velocity>( id, Velocity{1.0f, 2.0f, 3.0f} );
+				if ( i % 2 == 0 )
+				{
+					scope.em.addComponent<Health>( id, Health{50.0f, 6.0f} );
+				}
+			}
+		} );
+	REQUIRE( scope.em.count<Position, const Velocity>() == nEntities );
+	REQUIRE( scope.em.count<Health>() == nEntities / 2 );
+
+	const auto integrate = [dt] ( const EntityId, Position &position, const Velocity &velocity )
+		{
+			position.x += velocity.x * dt;
+			position.y += velocity.y * dt;
+			position.z += velocity.z * dt;
+		};
+	const auto heal = [dt] ( const EntityId, Health &health )
+		{
+			health.hp = std::min( health.hp + health.regen * dt, 100.0f );
+		};
+	constexpr int nRuns = 10;
+	const double forEachMs = test::timeBestOf( nRuns,
+		[&] ()
+		{
+			scope.em.forEach<Position, const Velocity>( integrate );
+			scope.em.forEach<Health>( heal );
+		} );
+	const double parallelForEachMs = test::timeBestOf( nRuns,
+		[&] ()
+		{
+			scope.em.parallelForEach<Position, const Velocity>( integrate );
+			scope.em.parallelForEach<Health>( heal );
+		} );
+
+	// every run mutated every entity once
+	double ySum = 0.0;
+	scope.em.forEach<const Position>( [&ySum] ( const EntityId, const Position &position )
+		{
+			ySum += position.y;
+		} );
+	REQUIRE( ySum == Approx( 2.0 * dt * 2 * nRuns * nEntities ).epsilon( 1e-3 ) );
+
+	std::printf( "%zu entities in 2 archetypes | spawn & add components %7.1f ms, forEach %6.2f ms (%6.1f M entities/s), parallelForEach on %zu threads %6.2f ms (%6.1f M entities/s)\n", nEntities, spawnMs, forEachMs, nEntities / forEachMs / 1e3, ThreadPoolJ::getInstance().getThreadCount(), parallelForEachMs, nEntities / parallelForEachMs / 1e3 );
+	ThreadPoolJ::resetInstance();
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include "frame_arena.h"
+#include "key_exception.h"
+
+
+// counts every general heap allocation of the test executable
+namespace
+{
+
+std::atomic<std::size_t> s_nHeapAllocations{0u};
+
+
+}//namespace
+
+void* operator new( const std::size_t nBytes )
+{
+	++s_nHeapAllocations;
+	if ( void *p = std::malloc( nBytes == 0 ? 1 : nBytes ) )
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete( void *p ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void *p,
+	const std::size_t ) noexcept
+{
+	std::free( p );
+}
+
+// std::pmr::new_delete_resource goes through the aligned forms; the malloc'ed block's address is stored right before the aligned memory
+void* operator new( const std::size_t nBytes,
+	const std::align_val_t alignment )
+{
+	++s_nHeapAllocations;
+	const std::size_t align = static_cast<std::size_t>( alignment );
+	if ( void *pBlock = std::malloc( nBytes + align + sizeof( void* ) ) )
+	{
+		const std::uintptr_t p = ( reinterpret_cast<std::uintptr_t>( pBlock ) + sizeof( void* ) + align - 1 ) & ~( align - 1 );
+		reinterpret_cast<void**>( p )[-1] = pBlock;
+		return reinterpret_cast<void*>( p );
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete( void *p,
+	const std::align_val_t ) noexcept
+{
+	if ( p != nullptr )
+	{
+		std::free( static_cast<void**>( p )[-1] );
+	}
+}
+
+void operator delete( void *p,
+	const std::size_t,
+	const std::align_val_t alignment ) noexcept
+{
+	operator delete( p, alignment );
+}
+
+namespace
+{
+
+struct FrustumPlane final
+{
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+struct Job final
+{
+	const void *pMesh;
+	std::uint64_t sortKey;
+	float distance;
+};
+
+/// \brief	a frame's transient data, all of it from the calling thread's FrameArena:
+/// \brief		the camera's frustum planes, the shadow casting lights that survived culling & a RenderQueuePass' jobs
+/// \brief	returns a checksum so the work isn't optimized away
+std::uint64_t simulateFrame( const std::size_t nJobs,
+	const std::uint64_t seed )
+{
+	FrameArena &arena = FrameAllocator::getInstance().getThreadArena();
+	// not braces, a vector of pointers would take &arena for its first element
+	std::pmr::vector<FrustumPlane> frustumPlanes( &arena );
+	for ( int i = 0; i < 6; ++i )
+	{
+		frustumPlanes.push_back( {float( i ), 0.0f, 1.0f, float( seed )} );
+	}
+
+	std::pmr::vector<const void*> unculledLights( &arena );
+	for ( std::size_t i = 0; i < 16; ++i )
+	{
+		if ( ( seed + i ) % 3 != 0 )
+		{
+			unculledLights.push_back( &frustumPlanes[i % 6] );
+		}
+	}
+
+	std::pmr::vector<Job> jobs( &arena );
+	for ( std::size_t i = 0; i < nJobs; ++i )
+	{
+		jobs.push_back( {unculledLights.data(), seed * 31 + i, float( i )} );
+	}
+
+	std::uint64_t checksum = unculledLights.size();
+	for ( const Job &job : jobs )
+	{
+		checksum += job.sortKey;
+	}
+	return checksum;
+}
+
+
+}//namespace
+
+TEST_CASE( "FrameAllocator steady state frames make no heap allocations", "[frame_arena]" )
+{
+	FrameAllocator &frameAllocator = FrameAllocator::getInstance();
+	constexpr int nWarmupFrames = 10;
+	constexpr int nFrames = 200;
+
+	// a worker thread that renders its share of every frame from its own arena
+	std::atomic<int> workerFrame{-1};
+	std::atomic<int> workerDoneFrame{-1};
+	std::atomic<std::uint64_t> workerChecksum{0u};
+	std::thread worker{[&] ()
+		{
+			for ( int frame = 0; frame < nWarmupFrames + nFrames; ++frame )
+			{
+				while ( workerFrame.load() < frame )
+				{
+					std::this_thread::yield();
+				}
+				// the first frames have a heavier load than the arenas start with
+				workerChecksum += simulateFrame( frame < nWarmupFrames ? 50000u : 20000u, frame );
+				workerDoneFrame.store( frame );
+			}
+		}};
+
+	std::uint64_t checksum = 0;
+	std::size_t nWarmupAllocations = 0;
+	for ( int frame = 0; frame < nWarmupFrames + nFrames; ++frame )
+	{
+		if ( frame == nWarmupFrames )
+		{
+			nWarmupAllocations = s_nHeapAllocations.exchange( 0u );
+		}
+		workerFrame.store( frame );
+		checksum += simulateFrame( frame < nWarmupFrames ? 80000u : 30000u, frame );
+		while ( workerDoneFrame.load() < frame )
+		{
+			std::this_thread::yield();
+		}
+		frameAllocator.endFrame();
+	}
+	const std::size_t nSteadyStateAllocations = s_nHeapAllocations.load();
+	worker.join();
+
+	REQUIRE( checksum != 0u );
+	REQUIRE( workerChecksum != 0u );
+	// the warm up frames overflowed the arenas, which grew to fit them
+	REQUIRE( nWarmupAllocations > 0u );
+	REQUIRE( nSteadyStateAllocations == 0u );
+}
+
+TEST_CASE( "FrameArena overflows upstream & grows on reset", "[frame_arena]" )
+{
+	FrameArena arena{1024u};
+	void *pAligned = arena.allocate( 100u, 256u );
+	REQUIRE( reinterpret_cast<std::uintptr_t>( pAligned ) % 256u == 0u );
+	std::size_t nFailed = 0;
+	for ( int i = 0; i < 10; ++i )
+	{
+		nFailed += arena.allocate( 500u, 16u ) == nullptr;
+	}
+	FrameArena::Stats stats = arena.getStats();
+	REQUIRE( stats.m_nOverflows > 0u );
+	REQUIRE( stats.m_nBytesUsed + stats.m_nOverflowBytes >= 5100u );
+
+	arena.reset();
+	REQUIRE( arena.getCapacity() >= 5100u );
+	const std::size_t nAllocations = s_nHeapAllocations.load();
+	nFailed += arena.allocate( 100u, 256u ) == nullptr;
+	for ( int i = 0; i < 10; ++i )
+	{
+		nFailed += arena.allocate( 500u, 16u ) == nullptr;
+	}
+	stats = arena.getStats();
+	REQUIRE( s_nHeapAllocations.load() == nAllocations );
+	REQUIRE( nFailed == 0u );
+	REQUIRE( stats.m_nOverflows == 0u );
+	REQUIRE( stats.m_highWaterMark >= 5100u );
+}
+
+TEST_CASE( "FrameAllocator keeps frame data for the frames in flight", "[frame_arena]" )
+{
+	FrameAllocator &frameAllocator = FrameAllocator::getInstance();
+	FrameArena &arena = frameAllocator.getThreadArena();
+	unsigned char *p = static_cast<unsigned char*>( arena.allocate( 4096u, 16u ) );
+	for ( int i = 0; i < 4096; ++i )
+	{
+		p[i] = static_cast<unsigned char>( i * 7 );
+	}
+
+	// the following frames allocate from the other arenas & leave this one alone
+	for ( unsigned frame = 1; frame < FrameAllocator::s_nFramesInFlight; ++frame )
+	{
+		frameAllocator.endFrame();
+		FrameArena &frameArena = frameAllocator.getThreadArena();
+		REQUIRE( &frameArena != &arena );
+		std::memset( frameArena.allocate( 4096u, 16u ), 0xAB, 4096u );
+	}
+	std::size_t nClobbered = 0;
+	for ( int i = 0; i < 4096; ++i )
+	{
+		nClobbered += p[i] != static_cast<unsigned char>( i * 7 );
+	}
+	REQUIRE( nClobbered == 0u );
+
+	// & then it's reset for reuse
+	frameAllocator.endFrame();
+	REQUIRE( &frameAllocator.getThreadArena() == &arena );
+	REQUIRE( arena.getStats().m_nBytesUsed == 0u );
+}
+
+TEST_CASE( "FrameAllocator reuses the slots of exited threads", "[frame_arena]" )
+{
+	// many more threads than slots, one at a time
+	std::size_t nFailed = 0;
+	for ( std::size_t i = 0; i < 3 * FrameAllocator::s_maxThreads; ++i )
+	{
+		std::thread thread{[&nFailed] ()
+			{
+				try
+				{
+					nFailed += FrameAllocator::getInstance().getThreadArena().allocate( 64u, 16u ) == nullptr;
+				}
+				catch ( const KeyException & )
+				{
+					++nFailed;
+				}
+			}};
+		thread.join();
+	}
+	REQUIRE( nFailed == 0u );
+}
+
+TEST_CASE( "FrameAllocator throws once every slot is held", "[frame_arena]" )
+{
+	enum Result : int
+	{
+		Pending,
+		Allocated,
+		Threw,
+	};
+
+	// threads take slots & hold them until released, until one finds none left
+	std::atomic<bool> bRelease{false};
+	std::vector<std::thread> threads;
+	bool bThrew = false;
+	while ( !bThrew && threads.size() <= FrameAllocator::s_maxThreads )
+	{
+		std::atomic<int> result{Pending};
+		threads.emplace_back( [&bRelease, &result] ()
+			{
+				try
+				{
+					FrameAllocator::getInstance().getThreadArena();
+					result.store( Allocated );
+				}
+				catch ( const KeyException & )
+				{
+					result.store( Threw );
+					return;
+				}
+				while ( !bRelease.load() )
+				{
+					std::this_thread::yield();
+				}
+			} );
+		while ( result.load() == Pending )
+		{
+			std::this_thread::yield();
+		}
+		bThrew = result.load() == Threw;
+	}
+	bRelease.store( true );
+	for ( std::thread &thread : threads )
+	{
+		thread.join();
+	}
+	REQUIRE( bThrew );
+	REQUIRE( threads.size() <= FrameAllocator::s_maxThreads + 1 );
+
+	// the held slots are free again
+	bool bAllocated = false;
+	std::thread thread{[&bAllocated] ()
+		{
+			bAllocated = FrameAllocator::getInstance().getThreadArena().allocate( 64u, 16u ) != nullptr;
+		}};
+	thread.join();
+	REQUIRE( bAllocated );
+}
\ No newline at end of file
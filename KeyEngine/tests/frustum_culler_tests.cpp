@@ -0,0 +1,231 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <array>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include "frustum_culler.h"
+#include "test_utils.h"
+
+
+namespace dx = DirectX;
+
+namespace
+{
+
+struct Box final
+{
+	dx::XMFLOAT3 localMin;
+	dx::XMFLOAT3 localMax;
+	dx::XMFLOAT4X4 world;
+};
+
+/// \brief	rotation about z & y, non uniform scale & translation, row vector convention
+dx::XMFLOAT4X4 makeWorld( std::mt19937 &rng )
+{
+	std::uniform_real_distribution<float> angle{0.0f, 6.2831853f};
+	std::uniform_real_distribution<float> scale{0.25f, 3.0f};
+	std::uniform_real_distribution<float> position{-60.0f, 60.0f};
+	const float a = angle( rng );
+	const float b = angle( rng );
+	const float sx = scale( rng );
+	const float sy = scale( rng );
+	const float sz = scale( rng );
+	const float rz[3][3] = {{std::cos( a ), std::sin( a ), 0.0f}, {-std::sin( a ), std::cos( a ), 0.0f}, {0.0f, 0.0f, 1.0f}};
+	const float ry[3][3] = {{std::cos( b ), 0.0f, -std::sin( b )}, {0.0f, 1.0f, 0.0f}, {std::sin( b ), 0.0f, std::cos( b )}};
+	dx::XMFLOAT4X4 m{};
+	const float s[3] = {sx, sy, sz};
+	for ( int i = 0; i < 3; ++i )
+	{
+		for ( int j = 0; j < 3; ++j )
+		{
+			float sum = 0.0f;
+			for ( int k = 0; k < 3; ++k )
+			{
+				sum += rz[i][k] * ry[k][j];
+			}
+			m.m[i][j] = s[i] * sum;
+		}
+	}
+	m.m[3][0] = position( rng );
+	m.m[3][1] = position( rng );
+	m.m[3][2] = position( rng );
+	m.m[3][3] = 1.0f;
+	return m;
+}
+
+/// \brief	the world AABB of the box's 8 transformed corners
+void calcWorldBounds( const Box &box,
+	dx::XMFLOAT3 &bmin,
+	dx::XMFLOAT3 &bmax ) noexcept
+{
+	bmin = {1e30f, 1e30f, 1e30f};
+	bmax = {-1e30f, -1e30f, -1e30f};
+	for ( int corner = 0; corner < 8; ++corner )
+	{
+		const float p[3] = {corner & 1 ? box.localMax.x : box.localMin.x, corner & 2 ? box.localMax.y : box.localMin.y, corner & 4 ? box.localMax.z : box.localMin.z};
+		float w[3];
+		for ( int j = 0; j < 3; ++j )
+		{
+			w[j] = p[0] * box.world.m[0][j] + p[1] * box.world.m[1][j] + p[2] * box.world.m[2][j] + box.world.m[3][j];
+		}
+		bmin = {std::min( bmin.x, w[0] ), std::min( bmin.y, w[1] ), std::min( bmin.z, w[2] )};
+		bmax = {std::max( bmax.x, w[0] ), std::max( bmax.y, w[1] ), std::max( bmax.z, w[2] )};
+	}
+}
+
+/// \brief	a perspective-like frustum looking down +z from the origin, with inward facing normalized planes
+std::array<dx::XMFLOAT4, 6> makeFrustum()
+{
+	const float c = 0.70710678f;
+	return {dx::XMFLOAT4{c, 0.0f, c, 0.0f}, dx::XMFLOAT4{-c, 0.0f, c, 0.0f}, dx::XMFLOAT4{0.0f, c, c, 0.0f}, dx::XMFLOAT4{0.0f, -c, c, 0.0f}, dx::XMFLOAT4{0.0f, 0.0f, 1.0f, -1.0f}, dx::XMFLOAT4{0.0f, 0.0f, -1.0f, 50.0f}};
+}
+
+std::vector<Box> makeBoxes( const std::size_t n,
+	std::mt19937 &rng )
+{
+	std::uniform_real_distribution<float> extent{0.1f, 4.0f};
+	std::uniform_real_distribution<float> offset{-2.0f, 2.0f};
+	std::vector<Box> boxes( n );
+	for ( Box &box : boxes )
+	{
+		const dx::XMFLOAT3 center{offset( rng ), offset( rng ), offset( rng )};
+		box.localMin = {center.x - extent( rng ), center.y - extent( rng ), center.z - extent( rng )};
+		box.localMax = {center.x + extent( rng ), center.y + extent( rng ), center.z + extent( rng )};
+		box.world = makeWorld( rng );
+	}
+	return boxes;
+}
+
+/// \brief	releases the FrustumCuller singleton's slots it acquired, whatever the test's outcome
+struct SlotsScope final
+{
+	std::vector<std::uint32_t> slots;
+
+	~SlotsScope() noexcept
+	{
+		for ( const std::uint32_t slot : slots )
+		{
+			FrustumCuller::getInstance().releaseSlot( slot );
+		}
+	}
+};
+
+
+}//namespace
+
+TEST_CASE( "FrustumCuller batched culling matches the scalar test on transformed bounds", "[frustum_culler]" )
+{
+	std::mt19937 rng{1u};
+	FrustumCuller &culler = FrustumCuller::getInstance();
+	const auto planes = makeFrustum();
+	// past s_parallelThreshold, so the ThreadPoolJ split is exercised too
+	for ( const std::size_t nBoxes : {37u, 1000u, 20000u} )
+	{
+		const std::vector<Box> boxes = makeBoxes( nBoxes, rng );
+		SlotsScope scope;
+		for ( const Box &box : boxes )
+		{
+			scope.slots.push_back( culler.acquireSlot() );
+			culler.setBounds( scope.slots.back(), box.localMin, box.localMax, box.world );
+		}
+		culler.cull( planes );
+
+		std::size_t nMismatches = 0;
+		std::size_t nVisible = 0;
+		for ( std::size_t i = 0; i < boxes.size(); ++i )
+		{
+			dx::XMFLOAT3 bmin;
+			dx::XMFLOAT3 bmax;
+			calcWorldBounds( boxes[i], bmin, bmax );
+			const bool bVisible = !FrustumCuller::isAabbCulled( planes.data(), bmin, bmax );
+			nMismatches += culler.isVisible( scope.slots[i] ) != bVisible;
+			nVisible += bVisible;
+		}
+		REQUIRE( nMismatches == 0 );
+		// the frustum cuts through the scene
+		REQUIRE( nVisible > 0 );
+		REQUIRE( nVisible < boxes.size() );
+	}
+}
+
+TEST_CASE( "FrustumCuller released & reused slots", "[frustum_culler]" )
+{
+	FrustumCuller &culler = FrustumCuller::getInstance();
+	const auto planes = makeFrustum();
+	dx::XMFLOAT4X4 identity{};
+	identity.m[0][0] = identity.m[1][1] = identity.m[2][2] = identity.m[3][3] = 1.0f;
+	SlotsScope scope;
+	for ( int i = 0; i < 300; ++i )
+	{
+		scope.slots.push_back( culler.acquireSlot() );
+		culler.setBounds( scope.slots.back(), {-1.0f, -1.0f, 9.0f}, {1.0f, 1.0f, 11.0f}, identity );
+	}
+	for ( std::size_t i = 0; i < scope.slots.size(); i += 3 )
+	{
+		culler.releaseSlot( scope.slots[i] );
+	}
+	culler.cull( planes );
+	for ( std::size_t i = 0; i < scope.slots.size(); ++i )
+	{
+		REQUIRE( culler.isVisible( scope.slots[i] ) == ( i % 3 != 0 ) );
+	}
+
+	// a slot is visible until it has bounds
+	std::vector<std::uint32_t> live;
+	for ( std::size_t i = 0; i < scope.slots.size(); ++i )
+	{
+		if ( i % 3 != 0 )
+		{
+			live.push_back( scope.slots[i] );
+		}
+	}
+	const std::uint32_t reused = culler.acquireSlot();
+	live.push_back( reused );
+	scope.slots = live;
+	culler.cull( planes );
+	REQUIRE( culler.isVisible( reused ) );
+	culler.setBounds( reused, {-1.0f, -1.0f, -11.0f}, {1.0f, 1.0f, -9.0f}, identity );
+	culler.cull( planes );
+	REQUIRE_FALSE( culler.isVisible( reused ) );
+
+	culler.setAllVisible();
+	for ( const std::uint32_t slot : live )
+	{
+		REQUIRE( culler.isVisible( slot ) );
+	}
+}
+
+TEST_CASE( "FrustumCuller batched vs per mesh culling", "[.][benchmark][frustum_culler]" )
+{
+	std::mt19937 rng{2u};
+	FrustumCuller &culler = FrustumCuller::getInstance();
+	const auto planes = makeFrustum();
+	for ( const std::size_t nBoxes : {1000u, 10000u, 100000u} )
+	{
+		const std::vector<Box> boxes = makeBoxes( nBoxes, rng );
+		std::vector<std::pair<dx::XMFLOAT3, dx::XMFLOAT3>> worldBounds( nBoxes );
+		SlotsScope scope;
+		for ( std::size_t i = 0; i < nBoxes; ++i )
+		{
+			scope.slots.push_back( culler.acquireSlot() );
+			culler.setBounds( scope.slots.back(), boxes[i].localMin, boxes[i].localMax, boxes[i].world );
+			calcWorldBounds( boxes[i], worldBounds[i].first, worldBounds[i].second );
+		}
+		std::size_t nVisible = 0;
+		const double scalarMs = test::timeBestOf( 5,
+			[&] ()
+			{
+				nVisible = 0;
+				for ( const auto &bounds : worldBounds )
+				{
+					// the per mesh path copied the camera's planes on every call
+					const std::vector<dx::XMFLOAT4> planesCopy( planes.begin(), planes.end() );
+					nVisible += !FrustumCuller::isAabbCulled( planesCopy.data(), bounds.first, bounds.second );
+				}
+			} );
+		const double batchedMs = test::timeBestOf( 5, [&] () { culler.cull( planes ); } );
+		std::printf( "%7zu boxes (%zu visible) | per mesh %7.3f ms | batched %7.3f ms\n", nBoxes, nVisible, scalarMs, batchedMs );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+#include <cmath>
+#include <cstdio>
+#include "geometry.h"
+#include "bmp_codec.h"
+#include "color.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+std::string getTempPath( const std::string &filename )
+{
+	return ( std::filesystem::temp_directory_path() / filename ).string();
+}
+
+/// \brief	a grey heightmap of random heights
+std::vector<ColorBGRA> makeHeightmap( const unsigned width,
+	const unsigned height,
+	std::mt19937 &rng )
+{
+	std::vector<ColorBGRA> image( static_cast<std::size_t>( width ) * height );
+	for ( ColorBGRA &texel : image )
+	{
+		const unsigned grey = rng() & 0xFFu;
+		texel = ColorBGRA{0xFF000000u | grey << 16 | grey << 8 | grey};
+	}
+	return image;
+}
+
+/// \brief	the heightmap's height under grid vertex (x, y), clamped to the grid, in double precision
+double sampleHeight( const std::vector<ColorBGRA> &image,
+	const unsigned width,
+	const unsigned height,
+	const int nDivisionsX,
+	const int nDivisionsY,
+	const bool bBilinearFiltering,
+	const int normalizeAmount,
+	long x,
+	long y )
+{
+	x = std::clamp( x, 0L, static_cast<long>( nDivisionsX ) );
+	y = std::clamp( y, 0L, static_cast<long>( nDivisionsY ) );
+	const double fx = x * double( width - 1 ) / nDivisionsX;
+	const double fy = y * double( height - 1 ) / nDivisionsY;
+	const auto texel = [&] ( const unsigned tx, const unsigned ty )
+		{
+			return image[static_cast<std::size_t>( ty ) * width + tx].getBlue() / double( normalizeAmount );
+		};
+	if ( !bBilinearFiltering )
+	{
+		return texel( std::min( static_cast<unsigned>( fx + 0.5 ), width - 1 ), std::min( static_cast<unsigned>( fy + 0.5 ), height - 1 ) );
+	}
+	const unsigned x0 = std::min( static_cast<unsigned>( fx ), width - 1 );
+	const unsigned x1 = std::min( x0 + 1, width - 1 );
+	const unsigned y0 = std::min( static_cast<unsigned>( fy ), height - 1 );
+	const unsigned y1 = std::min( y0 + 1, height - 1 );
+	const double top = texel( x0, y0 ) + ( texel( x1, y0 ) - texel( x0, y0 ) ) * ( fx - x0 );
+	const double bottom = texel( x0, y1 ) + ( texel( x1, y1 ) - texel( x0, y1 ) ) * ( fx - x0 );
+	return top + ( bottom - top ) * ( fy - y0 );
+}
+
+
+}//namespace
+
+TEST_CASE( "makePlanarGridTexturedFromHeighmap samples, shades & indexes the grid", "[geometry]" )
+{
+	constexpr int normalizeAmount = 4;
+	constexpr int multiplier = 10;
+	constexpr int length = 3;
+	constexpr int width = 5;
+	const std::string filename = getTempPath( "key_engine_tests_heightmap.bmp" );
+	std::mt19937 rng{3u};
+	for ( const unsigned imageWidth : {5u, 64u, 257u} )
+	{
+		for ( const unsigned imageHeight : {3u, 130u} )
+		{
+			const std::vector<ColorBGRA> image = makeHeightmap( imageWidth, imageHeight, rng );
+			bmp::write( filename, imageWidth, imageHeight, image.data(), 24u );
+			for ( const int nDivisionsX : {1, 2, 5, 63, 100} )
+			{
+				for ( const int nDivisionsY : {1, 3, 64} )
+				{
+					for ( const bool bBilinearFiltering : {false, true} )
+					{
+						const TriangleMesh mesh = geometry::makePlanarGridTexturedFromHeighmap( filename, normalizeAmount, multiplier, length, width, nDivisionsX, nDivisionsY, bBilinearFiltering );
+						// a single division is bumped to 2 x 2
+						const int nx = nDivisionsX == 1 && nDivisionsY == 1 ? 2 : nDivisionsX;
+						const int ny = nDivisionsX == 1 && nDivisionsY == 1 ? 2 : nDivisionsY;
+						const std::size_t nVerticesX = static_cast<std::size_t>( nx ) + 1;
+						const std::size_t nVerticesY = static_cast<std::size_t>( ny ) + 1;
+						REQUIRE( mesh.m_vb.getVertexCount() == nVerticesX * nVerticesY );
+						REQUIRE( mesh.m_indices.size() == static_cast<std::size_t>( nx ) * ny * 6 );
+
+						const auto h = [&] ( const long x, const long y )
+							{
+								return sampleHeight( image, imageWidth, imageHeight, nx, ny, bBilinearFiltering, normalizeAmount, x, y );
+							};
+						// P3N3T2, the normal from the central differences of the heights
+						const float *pVertices = reinterpret_cast<const float*>( mesh.m_vb.data() );
+						const double segmentLength = double( length ) / nx;
+						const double segmentWidth = double( width ) / ny;
+						double maxError = 0.0;
+						for ( std::size_t y = 0; y < nVerticesY; ++y )
+						{
+							for ( std::size_t x = 0; x < nVerticesX; ++x )
+							{
+								const long lx = static_cast<long>( x );
+								const long ly = static_cast<long>( y );
+								const double hx = ( h( lx + 1, ly ) - h( lx - 1, ly ) ) / ( 2 * segmentLength * multiplier );
+								const double hy = ( h( lx, ly + 1 ) - h( lx, ly - 1 ) ) / ( 2 * segmentWidth * multiplier );
+								const double invNormalLength = 1.0 / std::sqrt( hx * hx + hy * hy + 1.0 );
+								const double expected[8] = {( x * segmentLength - length / 2.0 ) * multiplier,
+									( y * segmentWidth - width / 2.0 ) * multiplier,
+									h( lx, ly ),
+									hx * invNormalLength,
+									hy * invNormalLength,
+									-invNormalLength,
+									double( x ) / nx,
+									1.0 - double( y ) / ny};
+								const float *pVertex = pVertices + ( y * nVerticesX + x ) * 8;
+								for ( int i = 0; i < 8; ++i )
+								{
+									maxError = std::max( maxError, std::abs( expected[i] - pVertex[i] ) );
+								}
+							}
+						}
+						REQUIRE( maxError < 5e-3 );
+
+						std::size_t nWrongIndices = 0;
+						for ( std::size_t quad = 0; quad < static_cast<std::size_t>( nx ) * ny; ++quad )
+						{
+							const unsigned a = static_cast<unsigned>( ( quad / nx ) * nVerticesX + quad % nx );
+							const unsigned c = a + static_cast<unsigned>( nVerticesX );
+							const unsigned expected[6] = {a, c, a + 1, a + 1, c, c + 1};
+							nWrongIndices += !std::equal( expected, expected + 6, mesh.m_indices.begin() + quad * 6 );
+						}
+						REQUIRE( nWrongIndices == 0u );
+					}
+				}
+			}
+		}
+	}
+	std::filesystem::remove( filename );
+}
+
+TEST_CASE( "makePlanarGridTexturedFromHeighmap vs emplacing every vertex, 2048x2048 heightmap", "[.][benchmark][geometry]" )
+{
+	constexpr unsigned imageSize = 2048u;
+	constexpr int nDivisions = static_cast<int>( imageSize ) - 1;
+	const std::string filename = getTempPath( "key_engine_tests_heightmap_2048.bmp" );
+	std::mt19937 rng{3u};
+	{
+		const std::vector<ColorBGRA> image = makeHeightmap( imageSize, imageSize, rng );
+		bmp::write( filename, imageSize, imageSize, image.data(), 24u );
+	}
+
+	std::size_t nVertices = 0;
+	const double gridMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			const TriangleMesh mesh = geometry::makePlanarGridTexturedFromHeighmap( filename, 4, 10, imageSize, imageSize, nDivisions, nDivisions );
+			nVertices = mesh.m_vb.getVertexCount();
+		} );
+	std::size_t nEmplacedVertices = 0;
+	// what the builder did before: decode the whole image, emplace a vertex at a time & push back the indices
+	const double emplaceMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			const bmp::BmpReader reader{filename};
+			std::vector<ColorBGRA> texels( static_cast<std::size_t>( imageSize ) * imageSize );
+			reader.read( texels.data() );
+			ver::VertexInputLayout layout;
+			layout.add( ver::VertexInputLayout::Position3D ).add( ver::VertexInputLayout::Normal ).add( ver::VertexInputLayout::Texture2D );
+			ver::VBuffer vb{std::move( layout )};
+			const unsigned nVerticesX = imageSize;
+			for ( unsigned y = 0; y < nVerticesX; ++y )
+			{
+				for ( unsigned x = 0; x < nVerticesX; ++x )
+				{
+					vb.emplaceVertex( DirectX::XMFLOAT3{( float( x ) - imageSize / 2.0f ) * 10.0f, ( float( y ) - imageSize / 2.0f ) * 10.0f, texels[y * imageSize + x].getBlue() / 4.0f},
+						DirectX::XMFLOAT3{0.0f, 0.0f, -1.0f},
+						DirectX::XMFLOAT2{float( x ) / nDivisions, 1.0f - float( y ) / nDivisions} );
+				}
+			}
+			std::vector<unsigned> indices;
+			for ( unsigned y = 0; y < nVerticesX - 1; ++y )
+			{
+				for ( unsigned x = 0; x < nVerticesX - 1; ++x )
+				{
+					const unsigned a = y * nVerticesX + x;
+					indices.push_back( a );
+					indices.push_back( a + nVerticesX );
+					indices.push_back( a + 1 );
+					indices.push_back( a + 1 );
+					indices.push_back( a + nVerticesX );
+					indices.push_back( a + nVerticesX + 1 );
+				}
+			}
+			const TriangleMesh mesh{std::move( vb ), std::move( indices )};
+			nEmplacedVertices = mesh.m_vb.getVertexCount();
+		} );
+	REQUIRE( nEmplacedVertices == nVertices );
+	std::printf( "%zu vertices | makePlanarGridTexturedFromHeighmap %7.2f ms | emplace per vertex %7.2f ms\n",
+		nVertices, gridMs, emplaceMs );
+	std::filesystem::remove( filename );
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <map>
+#include <random>
+#include <cstdio>
+#include "instance_batcher.h"
+#include "test_utils.h"
+
+
+namespace dx = DirectX;
+
+namespace
+{
+
+/// \brief	the Job index in m[3][0] identifies the instance's transform
+dx::XMFLOAT4X4 makeTransform( const std::uint32_t jobIndex ) noexcept
+{
+	dx::XMFLOAT4X4 m{};
+	m.m[0][0] = m.m[1][1] = m.m[2][2] = m.m[3][3] = 1.0f;
+	m.m[3][0] = static_cast<float>( jobIndex );
+	return m;
+}
+
+/// \brief	returns the number of Jobs whose batching differs from a std::map grouping of the keys
+std::size_t countMismatches( const ren::InstanceBatcher &batcher,
+	const std::vector<std::uint64_t> &keys )
+{
+	// key 0 = Job that can't be instanced
+	std::map<std::uint64_t, std::vector<std::uint32_t>> jobsOfKey;
+	for ( std::uint32_t j = 0; j < keys.size(); ++j )
+	{
+		if ( keys[j] != 0 )
+		{
+			jobsOfKey[keys[j]].push_back( j );
+		}
+	}
+
+	std::size_t nMismatches = 0;
+	std::size_t nBatches = 0;
+	std::size_t nInstances = 0;
+	const auto &batches = batcher.getBatches();
+	const auto &instanceData = batcher.getInstanceData();
+	for ( std::uint32_t j = 0; j < keys.size(); ++j )
+	{
+		const std::uint32_t batchIndex = batcher.getBatch( j );
+		if ( keys[j] == 0 || jobsOfKey[keys[j]].size() < 2 )
+		{
+			nMismatches += batchIndex != ren::InstanceBatcher::s_notBatched;
+			continue;
+		}
+		if ( batchIndex >= batches.size() )
+		{
+			++nMismatches;
+			continue;
+		}
+
+		// the Batch is drawn in place of its first Job & holds its Jobs' transforms in draw order
+		const auto &jobs = jobsOfKey[keys[j]];
+		const auto &batch = batches[batchIndex];
+		if ( jobs.front() == j )
+		{
+			++nBatches;
+			nInstances += batch.m_nInstances;
+			nMismatches += batch.m_firstJob != j || batch.m_nInstances != jobs.size();
+			for ( std::size_t i = 0; i < jobs.size() && batch.m_firstInstance + i < instanceData.size(); ++i )
+			{
+				nMismatches += instanceData[batch.m_firstInstance + i].m[3][0] != static_cast<float>( jobs[i] );
+			}
+		}
+	}
+	nMismatches += nBatches != batches.size();
+	nMismatches += nInstances != instanceData.size();
+	return nMismatches;
+}
+
+/// \brief	adds the Jobs with a non zero key in draw order
+void addJobs( ren::InstanceBatcher &batcher,
+	const std::vector<std::uint64_t> &keys )
+{
+	for ( std::uint32_t j = 0; j < keys.size(); ++j )
+	{
+		if ( keys[j] != 0 )
+		{
+			batcher.add( keys[j], j, makeTransform( j ) );
+		}
+	}
+}
+
+
+}//namespace
+
+TEST_CASE( "InstanceBatcher groups Jobs by key in draw order", "[instance_batcher]" )
+{
+	// keys A B A C A B D, & a Job that can't be instanced
+	const std::vector<std::uint64_t> keys{1u, 2u, 1u, 3u, 1u, 2u, 4u, 0u};
+	ren::InstanceBatcher batcher;
+	addJobs( batcher, keys );
+	batcher.build( keys.size() );
+
+	const auto &batches = batcher.getBatches();
+	REQUIRE( batches.size() == 2u );
+	REQUIRE( batches[0].m_firstJob == 0u );
+	REQUIRE( batches[0].m_firstInstance == 0u );
+	REQUIRE( batches[0].m_nInstances == 3u );
+	REQUIRE( batches[1].m_firstJob == 1u );
+	REQUIRE( batches[1].m_firstInstance == 3u );
+	REQUIRE( batches[1].m_nInstances == 2u );
+
+	const float expectedInstances[] = {0.0f, 2.0f, 4.0f, 1.0f, 5.0f};
+	REQUIRE( batcher.getInstanceData().size() == 5u );
+	for ( std::size_t i = 0; i < 5; ++i )
+	{
+		REQUIRE( batcher.getInstanceData()[i].m[3][0] == expectedInstances[i] );
+	}
+
+	const std::uint32_t notBatched = ren::InstanceBatcher::s_notBatched;
+	const std::uint32_t expectedBatches[] = {0u, 1u, 0u, notBatched, 0u, 1u, notBatched, notBatched};
+	for ( std::uint32_t j = 0; j < keys.size(); ++j )
+	{
+		REQUIRE( batcher.getBatch( j ) == expectedBatches[j] );
+	}
+	REQUIRE( batcher.getBatch( 100u ) == notBatched );
+	REQUIRE( countMismatches( batcher, keys ) == 0u );
+
+	// a new frame starts empty
+	batcher.clear();
+	batcher.build( 3u );
+	REQUIRE( batcher.getBatches().empty() );
+	REQUIRE( batcher.getInstanceData().empty() );
+	REQUIRE( batcher.getBatch( 0u ) == notBatched );
+}
+
+TEST_CASE( "InstanceBatcher matches a reference grouping on random queues", "[instance_batcher]" )
+{
+	std::mt19937_64 rng{1u};
+	ren::InstanceBatcher batcher;
+	for ( int rep = 0; rep < 50; ++rep )
+	{
+		const std::size_t nJobs = 1 + rng() % 3000;
+		const std::uint64_t nKeys = 1 + rng() % 200;
+		std::vector<std::uint64_t> keys( nJobs );
+		for ( auto &key : keys )
+		{
+			// a tenth of the Jobs can't be instanced; large keys as the RenderQueuePass hashes them
+			key = rng() % 10 == 0 ? 0u : ( 1 + rng() % nKeys ) * 0x9E3779B97F4A7C15ull;
+		}
+		batcher.clear();
+		addJobs( batcher, keys );
+		batcher.build( nJobs );
+		REQUIRE( countMismatches( batcher, keys ) == 0u );
+	}
+}
+
+TEST_CASE( "InstanceBatcher batch formation & packing of 10k props", "[.][benchmark][instance_batcher]" )
+{
+	std::mt19937 rng{2u};
+	// trees, rocks & bricks of a few kinds, plus unique props
+	constexpr std::uint32_t nJobs = 10000u;
+	std::vector<std::uint64_t> keys( nJobs );
+	for ( auto &key : keys )
+	{
+		const std::uint32_t r = rng() % 100;
+		key = r < 95 ? 1u + r % 8 : 1000u + rng();
+	}
+	ren::InstanceBatcher batcher;
+	const double ms = test::timeBestOf( 20,
+		[&] ()
+		{
+			batcher.clear();
+			addJobs( batcher, keys );
+			batcher.build( nJobs );
+		} );
+	std::size_t nDrawCalls = batcher.getBatches().size();
+	for ( std::uint32_t j = 0; j < nJobs; ++j )
+	{
+		nDrawCalls += batcher.getBatch( j ) == ren::InstanceBatcher::s_notBatched;
+	}
+	std::printf( "%u Jobs -> %zu draw calls (%zu instanced batches, %zu instances) | batching & packing %.3f ms\n",
+		nJobs, nDrawCalls, batcher.getBatches().size(), batcher.getInstanceData().size(), ms );
+}
\ No newline at end of file
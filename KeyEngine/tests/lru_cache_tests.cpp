@@ -0,0 +1,318 @@
+#include "catch/catch.hpp"
+#include <list>
+#include <tuple>
+#include <string>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdio>
+#include "lru_cache.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	a plain std::list LRU cache to check LRUCache against; front is the most recently used
+class ReferenceCache final
+{
+	std::list<std::tuple<int, int, std::size_t>> m_entries;
+	std::size_t m_maxEntries;
+	std::size_t m_maxBytes;
+public:
+	ReferenceCache( const std::size_t maxEntries,
+		const std::size_t maxBytes )
+		:
+		m_maxEntries{maxEntries},
+		m_maxBytes{maxBytes}
+	{
+
+	}
+
+	const int* get( const int key )
+	{
+		const auto it = find( key );
+		if ( it == m_entries.end() )
+		{
+			return nullptr;
+		}
+		m_entries.splice( m_entries.begin(), m_entries, it );
+		return &std::get<1>( m_entries.front() );
+	}
+
+	void put( const int key,
+		const int value,
+		const std::size_t nBytes )
+	{
+		erase( key );
+		m_entries.emplace_front( key, value, nBytes );
+		while ( m_entries.size() > m_maxEntries || getBytes() > m_maxBytes )
+		{
+			m_entries.pop_back();
+		}
+	}
+
+	void erase( const int key )
+	{
+		const auto it = find( key );
+		if ( it != m_entries.end() )
+		{
+			m_entries.erase( it );
+		}
+	}
+
+	std::size_t getCount() const noexcept
+	{
+		return m_entries.size();
+	}
+
+	std::size_t getBytes() const noexcept
+	{
+		std::size_t nBytes = 0;
+		for ( const auto &entry : m_entries )
+		{
+			nBytes += std::get<2>( entry );
+		}
+		return nBytes;
+	}
+private:
+	std::list<std::tuple<int, int, std::size_t>>::iterator find( const int key )
+	{
+		return std::find_if( m_entries.begin(), m_entries.end(), [key] ( const auto &entry ) { return std::get<0>( entry ) == key; } );
+	}
+};
+
+/// \brief	the LRUCache this one replaced: keys only, a std::list node per entry & two lookups per access
+template<typename T>
+class KeyOnlyLruCache final
+{
+	std::list<T> m_list;
+	std::unordered_map<T, typename std::list<T>::const_iterator> m_map;
+	std::size_t m_maxSize;
+public:
+	explicit KeyOnlyLruCache( const std::size_t maxSize )
+		:
+		m_maxSize{maxSize}
+	{
+
+	}
+
+	void find( const T x )
+	{
+		if ( m_map.find( x ) == m_map.end() )
+		{
+			if ( m_list.size() == m_maxSize )
+			{
+				m_map.erase( m_list.back() );
+				m_list.pop_back();
+			}
+		}
+		else
+		{
+			m_list.erase( m_map[x] );
+		}
+		m_list.push_front( x );
+		m_map[x] = m_list.cbegin();
+	}
+};
+
+/// \brief	asset keys with a skewed popularity; a few hot assets & a long tail
+std::vector<int> makeAccesses( const std::size_t nAccesses,
+	const int nKeys,
+	const std::uint32_t seed )
+{
+	std::mt19937 rng{seed};
+	std::exponential_distribution<double> rank{8.0 / nKeys};
+	std::vector<int> accesses( nAccesses );
+	for ( int &key : accesses )
+	{
+		key = static_cast<int>( rank( rng ) ) % nKeys;
+	}
+	return accesses;
+}
+
+
+}//namespace
+
+TEST_CASE( "LRUCache evicts in least recently used order across shards", "[lru_cache]" )
+{
+	std::mt19937 rng{5u};
+	for ( int rep = 0; rep < 200; ++rep )
+	{
+		const std::size_t maxEntries = 1 + rng() % 8;
+		const std::size_t maxBytes = 5 + rng() % 40;
+		const std::size_t nShards = rep % 2 == 0 ? 1u : 8u;
+		LRUCache<int, int> cache{maxEntries, maxBytes, nShards};
+		ReferenceCache reference{maxEntries, maxBytes};
+		std::size_t nMismatches = 0;
+		for ( int op = 0; op < 300; ++op )
+		{
+			const int key = rng() % 12;
+			switch ( rng() % 5 )
+			{
+			case 0:
+			case 1:
+			{
+				const auto pValue = cache.get( key );
+				const int *pExpected = reference.get( key );
+				nMismatches += ( pValue == nullptr ) != ( pExpected == nullptr ) || ( pValue && *pValue != *pExpected );
+				break;
+			}
+			case 2:
+			case 3:
+			{
+				const int value = static_cast<int>( rng() );
+				const std::size_t nBytes = rng() % 10;
+				const bool bCached = cache.put( key, std::make_shared<const int>( value ), nBytes );
+				nMismatches += bCached != ( nBytes <= maxBytes );
+				if ( bCached )
+				{
+					reference.put( key, value, nBytes );
+				}
+				break;
+			}
+			default:
+				cache.erase( key );
+				reference.erase( key );
+			}
+			const auto stats = cache.getStats();
+			nMismatches += stats.m_nEntries != reference.getCount() || stats.m_nBytes != reference.getBytes();
+		}
+		REQUIRE( nMismatches == 0u );
+	}
+}
+
+TEST_CASE( "LRUCache budgets span all shards", "[lru_cache]" )
+{
+	LRUCache<int, std::string> cache{10u, 1000u, 8u};
+	// a value larger than an eighth of the byte budget is cached
+	REQUIRE( cache.put( 0, std::make_shared<const std::string>( "large" ), 900u ) );
+	REQUIRE( cache.get( 0 ) != nullptr );
+	REQUIRE_FALSE( cache.put( 1, std::make_shared<const std::string>( "too large" ), 1001u ) );
+	REQUIRE( cache.get( 1 ) == nullptr );
+
+	// the other entries evict the large one before their own
+	for ( int key = 1; key <= 200; ++key )
+	{
+		REQUIRE( cache.put( key, std::make_shared<const std::string>( std::to_string( key ) ), 50u ) );
+		const auto stats = cache.getStats();
+		REQUIRE( stats.m_nEntries <= 10u );
+		REQUIRE( stats.m_nBytes <= 1000u );
+	}
+	REQUIRE( cache.get( 0 ) == nullptr );
+	// the most recent 10 remain, whatever shards they hashed to
+	for ( int key = 191; key <= 200; ++key )
+	{
+		REQUIRE( cache.get( key ) != nullptr );
+	}
+	const auto stats = cache.getStats();
+	REQUIRE( stats.m_nEntries == 10u );
+	REQUIRE( stats.m_nEvictions == 191u );
+}
+
+TEST_CASE( "LRUCache concurrent loads stay within budget", "[lru_cache]" )
+{
+	constexpr std::size_t maxEntries = 1000u;
+	constexpr std::size_t maxBytes = 8000u;
+	constexpr int nThreads = 8;
+	constexpr int nAccessesPerThread = 20000;
+	LRUCache<std::string, std::string> cache{maxEntries, maxBytes, 8u};
+	std::atomic<int> nWrongValues{0};
+	std::vector<std::thread> threads;
+	for ( int t = 0; t < nThreads; ++t )
+	{
+		threads.emplace_back( [&, t] ()
+			{
+				for ( int i = 0; i < nAccessesPerThread; ++i )
+				{
+					const std::string key = std::to_string( ( i * 7 + t ) % 3000 );
+					const auto pValue = cache.getOrLoad( key,
+						[] ( const std::string &key )
+						{
+							return std::make_pair( std::make_shared<const std::string>( "asset " + key ), key.size() + 6u );
+						} );
+					if ( *pValue != "asset " + key )
+					{
+						++nWrongValues;
+					}
+				}
+			} );
+	}
+	for ( auto &thread : threads )
+	{
+		thread.join();
+	}
+	REQUIRE( nWrongValues == 0 );
+	const auto stats = cache.getStats();
+	REQUIRE( stats.m_nHits + stats.m_nMisses == static_cast<std::uint64_t>( nThreads ) * nAccessesPerThread );
+	REQUIRE( stats.m_nEntries <= maxEntries );
+	REQUIRE( stats.m_nBytes <= maxBytes );
+	REQUIRE( stats.m_nEvictions > 0u );
+}
+
+TEST_CASE( "LRUCache vs the key only std::list cache", "[.][benchmark][lru_cache]" )
+{
+	constexpr int nKeys = 100000;
+	constexpr std::size_t capacity = 10000u;
+	const std::vector<int> accesses = makeAccesses( 1000000u, nKeys, 1u );
+	const auto pValue = std::make_shared<const int>( 0 );
+
+	KeyOnlyLruCache<int> keyOnly{capacity};
+	const double keyOnlyMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			for ( const int key : accesses )
+			{
+				keyOnly.find( key );
+			}
+		} );
+
+	for ( const std::size_t nShards : {1u, 8u} )
+	{
+		LRUCache<int, int> cache{capacity, std::numeric_limits<std::size_t>::max(), nShards};
+		const double ms = test::timeBestOf( 3,
+			[&] ()
+			{
+				for ( const int key : accesses )
+				{
+					if ( !cache.get( key ) )
+					{
+						cache.put( key, pValue, sizeof( int ) );
+					}
+				}
+			} );
+		const auto stats = cache.getStats();
+		std::printf( "%zu accesses, capacity %zu | key only std::list %7.2f ms | LRUCache %zu shards %7.2f ms, hit rate %.3f\n",
+			accesses.size(), capacity, keyOnlyMs, nShards, ms, double( stats.m_nHits ) / double( stats.m_nHits + stats.m_nMisses ) );
+	}
+
+	// the same accesses split over 4 threads
+	for ( const std::size_t nShards : {1u, 8u} )
+	{
+		LRUCache<int, int> cache{capacity, std::numeric_limits<std::size_t>::max(), nShards};
+		const double ms = test::timeBestOf( 3,
+			[&] ()
+			{
+				std::vector<std::thread> threads;
+				for ( std::size_t t = 0; t < 4u; ++t )
+				{
+					threads.emplace_back( [&, t] ()
+						{
+							for ( std::size_t i = t; i < accesses.size(); i += 4u )
+							{
+								if ( !cache.get( accesses[i] ) )
+								{
+									cache.put( accesses[i], pValue, sizeof( int ) );
+								}
+							}
+						} );
+				}
+				for ( auto &thread : threads )
+				{
+					thread.join();
+				}
+			} );
+		std::printf( "4 threads | LRUCache %zu shards %7.2f ms\n", nShards, ms );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,487 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <array>
+#include <set>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "mesh_optimizer.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	P3 N3 T2, 32 bytes a vertex
+using Vertex = std::array<float, 8>;
+using Triangle = std::array<Vertex, 3>;
+
+constexpr std::size_t s_normalOffset = 3 * sizeof( float );
+constexpr std::size_t s_texcoordOffset = 6 * sizeof( float );
+
+/// \brief	mesh_opt::optimize on the vertices, shrinking them to the ones left
+std::vector<mesh_opt::StepReport> optimize( std::vector<Vertex> &vertices,
+	std::vector<unsigned> &indices )
+{
+	std::size_t nVertices = vertices.size();
+	const std::vector<mesh_opt::StepReport> reports = mesh_opt::optimize( reinterpret_cast<char*>( vertices.data() ), nVertices, sizeof( Vertex ), 0u, indices );
+	vertices.resize( nVertices );
+	return reports;
+}
+
+/// \brief	mesh_opt::generateLods with the normal & texture coordinates as the attributes
+std::vector<mesh_opt::Lod> generateLods( const std::vector<Vertex> &vertices,
+	std::vector<unsigned> &indices,
+	const mesh_opt::LodSettings &settings = {} )
+{
+	const mesh_opt::Attribute attributes[2] = {{s_normalOffset, 3u, settings.normalWeight}, {s_texcoordOffset, 2u, settings.texcoordWeight}};
+	return mesh_opt::generateLods( indices, reinterpret_cast<const char*>( vertices.data() ), vertices.size(), sizeof( Vertex ), 0u, attributes, 2u, settings );
+}
+
+/// \brief	the points of a latitude/longitude sphere of radius 1 & its triangles, in ring order
+void makeSphere( const unsigned nRings,
+	std::vector<std::array<float, 3>> &positions,
+	std::vector<unsigned> &indices )
+{
+	const unsigned nSegments = 2 * nRings;
+	for ( unsigned ring = 0; ring <= nRings; ++ring )
+	{
+		for ( unsigned segment = 0; segment < nSegments; ++segment )
+		{
+			const float theta = 3.14159265f * ring / nRings;
+			const float phi = 6.28318531f * segment / nSegments;
+			positions.push_back( {std::sin( theta ) * std::cos( phi ), std::sin( theta ) * std::sin( phi ), std::cos( theta )} );
+		}
+	}
+	for ( unsigned ring = 0; ring < nRings; ++ring )
+	{
+		for ( unsigned segment = 0; segment < nSegments; ++segment )
+		{
+			const unsigned a = ring * nSegments + segment;
+			const unsigned b = ring * nSegments + ( segment + 1 ) % nSegments;
+			const unsigned c = a + nSegments;
+			const unsigned d = b + nSegments;
+			indices.insert( indices.end(), {a, c, b, b, c, d} );
+		}
+	}
+}
+
+/// \brief	the sphere's triangles in random order, every corner with its own vertex, as an importer without vertex welding leaves them
+std::vector<Vertex> makeShuffledUnsharedSphere( const unsigned nRings,
+	std::vector<unsigned> &indices,
+	std::mt19937 &rng )
+{
+	std::vector<std::array<float, 3>> positions;
+	std::vector<unsigned> sphereIndices;
+	makeSphere( nRings, positions, sphereIndices );
+	std::vector<std::size_t> order( sphereIndices.size() / 3 );
+	for ( std::size_t i = 0; i < order.size(); ++i )
+	{
+		order[i] = i;
+	}
+	std::shuffle( order.begin(), order.end(), rng );
+
+	std::vector<Vertex> vertices;
+	for ( const std::size_t triangle : order )
+	{
+		for ( int corner = 0; corner < 3; ++corner )
+		{
+			const auto &p = positions[sphereIndices[triangle * 3 + corner]];
+			indices.push_back( static_cast<unsigned>( vertices.size() ) );
+			vertices.push_back( {p[0], p[1], p[2], p[0], p[1], p[2], 0.0f, 0.0f} );
+		}
+	}
+	return vertices;
+}
+
+/// \brief	the triangles by the values of their vertices, each rotated to start with its smallest vertex; winding is kept
+std::multiset<Triangle> collectTriangles( const std::vector<Vertex> &vertices,
+	const std::vector<unsigned> &indices )
+{
+	std::multiset<Triangle> triangles;
+	for ( std::size_t i = 0; i < indices.size(); i += 3 )
+	{
+		const Triangle triangle{vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]};
+		Triangle canonical = triangle;
+		for ( int rotation = 1; rotation < 3; ++rotation )
+		{
+			const Triangle rotated{triangle[rotation], triangle[( rotation + 1 ) % 3], triangle[( rotation + 2 ) % 3]};
+			canonical = std::min( canonical, rotated );
+		}
+		triangles.insert( canonical );
+	}
+	return triangles;
+}
+
+bool areIndicesInRange( const std::vector<Vertex> &vertices,
+	const std::vector<unsigned> &indices )
+{
+	return std::all_of( indices.begin(), indices.end(), [&vertices] ( const unsigned i ) { return i < vertices.size(); } );
+}
+
+/// \brief	a uv sphere of radius 3 around (10, 0, 0): the seam column is duplicated for its texture coordinates & the pole rings have a triangle per segment
+std::vector<Vertex> makeUvSphere( const unsigned nRings,
+	const unsigned nSegments,
+	std::vector<unsigned> &indices )
+{
+	std::vector<Vertex> vertices;
+	for ( unsigned ring = 0; ring <= nRings; ++ring )
+	{
+		for ( unsigned segment = 0; segment <= nSegments; ++segment )
+		{
+			const float theta = 3.14159265f * ring / nRings;
+			const float phi = 6.28318531f * segment / nSegments;
+			const float n[3] = {std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi )};
+			vertices.push_back( {n[0] * 3.0f + 10.0f, n[1] * 3.0f, n[2] * 3.0f, n[0], n[1], n[2], float( segment ) / nSegments, float( ring ) / nRings} );
+		}
+	}
+	for ( unsigned ring = 0; ring < nRings; ++ring )
+	{
+		for ( unsigned segment = 0; segment < nSegments; ++segment )
+		{
+			const unsigned a = ring * ( nSegments + 1 ) + segment;
+			const unsigned c = a + nSegments + 1;
+			if ( ring > 0 )
+			{
+				indices.insert( indices.end(), {a, a + 1, c} );
+			}
+			if ( ring + 1 < nRings )
+			{
+				indices.insert( indices.end(), {a + 1, c + 1, c} );
+			}
+		}
+	}
+	return vertices;
+}
+
+/// \brief	an n x n quad grid on the y = 0 plane, 1 unit a quad
+std::vector<Vertex> makeGrid( const unsigned n,
+	std::vector<unsigned> &indices )
+{
+	std::vector<Vertex> vertices;
+	for ( unsigned y = 0; y <= n; ++y )
+	{
+		for ( unsigned x = 0; x <= n; ++x )
+		{
+			vertices.push_back( {float( x ), 0.0f, float( y ), 0.0f, 1.0f, 0.0f, float( x ) / n, float( y ) / n} );
+		}
+	}
+	for ( unsigned y = 0; y < n; ++y )
+	{
+		for ( unsigned x = 0; x < n; ++x )
+		{
+			const unsigned a = y * ( n + 1 ) + x;
+			const unsigned c = a + n + 1;
+			indices.insert( indices.end(), {a, c, a + 1, a + 1, c, c + 1} );
+		}
+	}
+	return vertices;
+}
+
+/// \brief	the LOD's range lies within the indices, which address the vertices & make no degenerate triangles
+bool isValidLod( const std::vector<Vertex> &vertices,
+	const std::vector<unsigned> &indices,
+	const mesh_opt::Lod &lod )
+{
+	if ( lod.nIndices % 3 != 0 || lod.startIndex + lod.nIndices > indices.size() )
+	{
+		return false;
+	}
+	for ( unsigned i = lod.startIndex; i < lod.startIndex + lod.nIndices; i += 3 )
+	{
+		const unsigned a = indices[i];
+		const unsigned b = indices[i + 1];
+		const unsigned c = indices[i + 2];
+		if ( a >= vertices.size() || b >= vertices.size() || c >= vertices.size() || a == b || b == c || a == c )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::set<unsigned> collectUsedVertices( const std::vector<unsigned> &indices,
+	const mesh_opt::Lod &lod )
+{
+	return {indices.begin() + lod.startIndex, indices.begin() + lod.startIndex + lod.nIndices};
+}
+
+
+}//namespace
+
+TEST_CASE( "mesh_opt::optimize keeps the triangles & welds, reorders & compacts the vertices", "[mesh_optimizer]" )
+{
+	std::mt19937 rng{1u};
+	for ( const unsigned nRings : {8u, 64u} )
+	{
+		std::vector<unsigned> indices;
+		std::vector<Vertex> vertices = makeShuffledUnsharedSphere( nRings, indices, rng );
+		const std::multiset<Triangle> triangles = collectTriangles( vertices, indices );
+		const std::size_t nVertices = vertices.size();
+
+		const std::vector<mesh_opt::StepReport> reports = optimize( vertices, indices );
+		REQUIRE( collectTriangles( vertices, indices ) == triangles );
+		REQUIRE( areIndicesInRange( vertices, indices ) );
+		REQUIRE( reports.size() == 5u );
+		// no sharing at all is an ACMR of 3; the welded & cache ordered sphere gets close to a regular grid's
+		REQUIRE( reports.front().acmrBefore == Approx( 3.0f ) );
+		REQUIRE( reports.back().acmrAfter < 0.9f );
+		// a vertex per grid point & a few more at the poles, where sin( theta ) * cos( phi ) can be -0
+		REQUIRE( vertices.size() * 5 < nVertices );
+		REQUIRE( vertices.size() >= 2u * nRings * ( nRings - 1 ) + 2u );
+		REQUIRE( reports.back().vertexBytesAfter == vertices.size() * sizeof( Vertex ) );
+		REQUIRE( reports.back().indexBytesAfter == indices.size() * sizeof( std::uint16_t ) );
+
+		// the fetch order is the order of first use
+		unsigned nextVertex = 0;
+		bool bFirstUseOrder = true;
+		for ( const unsigned i : indices )
+		{
+			bFirstUseOrder = bFirstUseOrder && i <= nextVertex;
+			nextVertex = std::max( nextVertex, i + 1 );
+		}
+		REQUIRE( bFirstUseOrder );
+		REQUIRE( nextVertex == vertices.size() );
+	}
+}
+
+TEST_CASE( "mesh_opt::optimize drops unreferenced vertices & keeps ordered meshes efficient", "[mesh_optimizer]" )
+{
+	std::vector<std::array<float, 3>> positions;
+	std::vector<unsigned> indices;
+	makeSphere( 32u, positions, indices );
+	std::vector<Vertex> vertices;
+	for ( std::size_t i = 0; i < positions.size(); ++i )
+	{
+		const auto &p = positions[i];
+		vertices.push_back( {p[0], p[1], p[2], 0.0f, 0.0f, 0.0f, float( i ), 0.0f} );
+	}
+	// vertices no triangle uses
+	for ( int i = 0; i < 5; ++i )
+	{
+		vertices.push_back( {9.0f, 9.0f, 9.0f, 9.0f, 9.0f, 9.0f, float( i ), 1.0f} );
+	}
+	const std::multiset<Triangle> triangles = collectTriangles( vertices, indices );
+	const float acmrBefore = mesh_opt::calcAcmr( indices.data(), indices.size(), vertices.size() );
+
+	optimize( vertices, indices );
+	REQUIRE( collectTriangles( vertices, indices ) == triangles );
+	REQUIRE( vertices.size() == positions.size() );
+	// overdraw ordering may cost up to its threshold
+	REQUIRE( mesh_opt::calcAcmr( indices.data(), indices.size(), vertices.size() ) <= acmrBefore * mesh_opt::s_overdrawAcmrThreshold );
+}
+
+TEST_CASE( "mesh_opt::optimize handles single & degenerate triangles", "[mesh_optimizer]" )
+{
+	{
+		std::vector<Vertex> vertices{Vertex{}, Vertex{1.0f}, Vertex{0.0f, 1.0f}};
+		std::vector<unsigned> indices{0u, 1u, 2u};
+		const std::multiset<Triangle> triangles = collectTriangles( vertices, indices );
+		optimize( vertices, indices );
+		REQUIRE( collectTriangles( vertices, indices ) == triangles );
+		REQUIRE( vertices.size() == 3u );
+	}
+	{
+		std::vector<Vertex> vertices{Vertex{}, Vertex{1.0f}, Vertex{0.0f, 1.0f}, Vertex{}};
+		std::vector<unsigned> indices{0u, 0u, 1u, 0u, 1u, 2u, 3u, 3u, 3u};
+		const std::multiset<Triangle> triangles = collectTriangles( vertices, indices );
+		optimize( vertices, indices );
+		REQUIRE( collectTriangles( vertices, indices ) == triangles );
+		REQUIRE( areIndicesInRange( vertices, indices ) );
+		// vertex 3 is a copy of vertex 0
+		REQUIRE( vertices.size() == 3u );
+	}
+}
+
+TEST_CASE( "mesh_opt::canUse16BitIndices leaves out the strip cut index", "[mesh_optimizer]" )
+{
+	REQUIRE( mesh_opt::canUse16BitIndices( 0u ) );
+	REQUIRE( mesh_opt::canUse16BitIndices( 0xFFFFu ) );
+	REQUIRE_FALSE( mesh_opt::canUse16BitIndices( 0x10000u ) );
+}
+
+TEST_CASE( "mesh_opt::generateLods stays within the error target & keeps the sphere's shape & seam", "[mesh_optimizer]" )
+{
+	const mesh_opt::LodSettings settings;
+	for ( const unsigned nRings : {64u, 128u} )
+	{
+		std::vector<unsigned> indices;
+		const std::vector<Vertex> vertices = makeUvSphere( nRings, nRings * 2, indices );
+		const std::size_t nIndices = indices.size();
+		const std::vector<mesh_opt::Lod> lods = generateLods( vertices, indices, settings );
+		REQUIRE( lods.size() == settings.nLods );
+		REQUIRE( lods[0].startIndex == 0u );
+		REQUIRE( lods[0].nIndices == nIndices );
+		REQUIRE( lods[0].error == 0.0f );
+
+		for ( std::size_t i = 1; i < lods.size(); ++i )
+		{
+			const mesh_opt::Lod &lod = lods[i];
+			REQUIRE( isValidLod( vertices, indices, lod ) );
+			REQUIRE( lod.error >= lods[i - 1].error );
+			REQUIRE( lod.error <= settings.targetError );
+			REQUIRE( lod.nIndices <= lods[i - 1].nIndices * mesh_opt::s_minLodReduction );
+
+			// the triangles' centroids stay close to the sphere, relative to its extent of 6, & none is folded over
+			double maxDeviation = 0.0;
+			std::size_t nFlipped = 0;
+			for ( unsigned t = lod.startIndex; t < lod.startIndex + lod.nIndices; t += 3 )
+			{
+				const Vertex &a = vertices[indices[t]];
+				const Vertex &b = vertices[indices[t + 1]];
+				const Vertex &c = vertices[indices[t + 2]];
+				const double centroid[3] = {( a[0] + b[0] + c[0] ) / 3.0 - 10.0, ( a[1] + b[1] + c[1] ) / 3.0, ( a[2] + b[2] + c[2] ) / 3.0};
+				const double centroidLength = std::sqrt( centroid[0] * centroid[0] + centroid[1] * centroid[1] + centroid[2] * centroid[2] );
+				maxDeviation = std::max( maxDeviation, std::abs( centroidLength - 3.0 ) / 6.0 );
+				const double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+				const double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+				const double normal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+				const double normalLength = std::sqrt( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+				nFlipped += normalLength > 1e-9 && ( normal[0] * centroid[0] + normal[1] * centroid[1] + normal[2] * centroid[2] ) < -0.5 * normalLength * centroidLength;
+			}
+			REQUIRE( maxDeviation <= settings.targetError * 1.5 );
+			REQUIRE( nFlipped == 0u );
+
+			// the seam is an attribute border, so both of its columns stay
+			const std::set<unsigned> usedVertices = collectUsedVertices( indices, lod );
+			std::size_t nDroppedSeamVertices = 0;
+			for ( unsigned ring = 1; ring < nRings; ++ring )
+			{
+				const unsigned seam = ring * ( nRings * 2 + 1 );
+				nDroppedSeamVertices += usedVertices.count( seam ) == 0 || usedVertices.count( seam + nRings * 2 ) == 0;
+			}
+			REQUIRE( nDroppedSeamVertices == 0u );
+		}
+	}
+}
+
+TEST_CASE( "mesh_opt::generateLods collapses a planar grid's interior & keeps its border & area", "[mesh_optimizer]" )
+{
+	constexpr unsigned n = 100u;
+	std::vector<unsigned> indices;
+	const std::vector<Vertex> vertices = makeGrid( n, indices );
+	const std::vector<mesh_opt::Lod> lods = generateLods( vertices, indices, mesh_opt::LodSettings{6u, 0.25f, 0.02f} );
+	REQUIRE( lods.size() >= 3u );
+
+	for ( std::size_t i = 1; i < lods.size(); ++i )
+	{
+		const mesh_opt::Lod &lod = lods[i];
+		REQUIRE( isValidLod( vertices, indices, lod ) );
+		REQUIRE( lod.error < 1e-3f );
+
+		const std::set<unsigned> usedVertices = collectUsedVertices( indices, lod );
+		std::size_t nDroppedBorderVertices = 0;
+		for ( unsigned j = 0; j <= n; ++j )
+		{
+			for ( const unsigned border : {j, n * ( n + 1 ) + j, j * ( n + 1 ), j * ( n + 1 ) + n} )
+			{
+				nDroppedBorderVertices += usedVertices.count( border ) == 0;
+			}
+		}
+		REQUIRE( nDroppedBorderVertices == 0u );
+
+		double area = 0.0;
+		for ( unsigned t = lod.startIndex; t < lod.startIndex + lod.nIndices; t += 3 )
+		{
+			const Vertex &a = vertices[indices[t]];
+			const Vertex &b = vertices[indices[t + 1]];
+			const Vertex &c = vertices[indices[t + 2]];
+			area += 0.5 * std::abs( ( b[0] - a[0] ) * ( c[2] - a[2] ) - ( c[0] - a[0] ) * ( b[2] - a[2] ) );
+		}
+		REQUIRE( area == Approx( double( n * n ) ).epsilon( 1e-6 ) );
+	}
+}
+
+TEST_CASE( "mesh_opt::simplify removes nothing at a target error of 0 & reaches the triangle target without an error bound", "[mesh_optimizer]" )
+{
+	std::vector<unsigned> sphereIndices;
+	const std::vector<Vertex> vertices = makeUvSphere( 32u, 64u, sphereIndices );
+	const std::size_t targetIndexCount = sphereIndices.size() / 4;
+
+	std::vector<unsigned> indices = sphereIndices;
+	float error = 1.0f;
+	REQUIRE( mesh_opt::simplify( indices.data(), indices.size(), reinterpret_cast<const char*>( vertices.data() ), vertices.size(), sizeof( Vertex ), 0u, targetIndexCount, 0.0f, nullptr, 0u, &error ) == sphereIndices.size() );
+	REQUIRE( error == 0.0f );
+
+	indices = sphereIndices;
+	const std::size_t nIndices = mesh_opt::simplify( indices.data(), indices.size(), reinterpret_cast<const char*>( vertices.data() ), vertices.size(), sizeof( Vertex ), 0u, targetIndexCount, 1.0f, nullptr, 0u, &error );
+	// a collapse removes up to 2 triangles, so it may stop a triangle short
+	REQUIRE( nIndices <= targetIndexCount + 3 );
+	REQUIRE( error > 0.0f );
+}
+
+TEST_CASE( "mesh_opt::selectLod picks the coarsest LOD within the pixel error & keeps it within the hysteresis band", "[mesh_optimizer]" )
+{
+	const mesh_opt::Lod lods[4] = {{0u, 0u, 0.0f}, {0u, 0u, 0.005f}, {0u, 0u, 0.01f}, {0u, 0u, 0.02f}};
+	constexpr float maxError = mesh_opt::s_lodMaxPixelError;
+	REQUIRE( mesh_opt::selectLod( lods, 4u, 1e6f, 0u ) == 0u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, maxError / 0.02f * 0.5f, 0u ) == 3u );
+	REQUIRE( mesh_opt::selectLod( lods, 1u, 0.0f, 0u ) == 0u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, 0.0f, 7u ) == 3u );
+	// the max error is in pixels, so a Mesh of the same size needs a finer LOD on a taller render target
+	REQUIRE( mesh_opt::selectLod( lods, 4u, 60.0f, 0u, 2.0f ) == 3u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, 120.0f, 0u, 2.0f ) == 2u );
+
+	// right at LOD 2's threshold: coming from LOD 1 it takes a 25% margin to switch, coming from LOD 2 it's kept
+	const float pixelSize = maxError / 0.01f;
+	REQUIRE( mesh_opt::selectLod( lods, 4u, pixelSize, 1u ) == 1u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, pixelSize, 2u ) == 2u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, pixelSize * 1.2f, 2u ) == 2u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, pixelSize * 1.3f, 2u ) == 1u );
+	REQUIRE( mesh_opt::selectLod( lods, 4u, pixelSize * 0.7f, 1u ) == 2u );
+
+	// a size oscillating by 5% around the switch point settles on a LOD instead of toggling every frame
+	unsigned lod = 0u;
+	unsigned nSwitches = 0u;
+	for ( int frame = 0; frame < 1000; ++frame )
+	{
+		const unsigned newLod = mesh_opt::selectLod( lods, 4u, pixelSize * ( 1.0f + 0.05f * std::sin( frame * 0.3f ) ), lod );
+		nSwitches += newLod != lod;
+		lod = newLod;
+	}
+	REQUIRE( nSwitches <= 1u );
+}
+
+TEST_CASE( "mesh_opt::optimize, shuffled unshared sphere", "[.][benchmark][mesh_optimizer]" )
+{
+	std::mt19937 rng{1u};
+	std::vector<unsigned> shuffledIndices;
+	const std::vector<Vertex> shuffled = makeShuffledUnsharedSphere( 200u, shuffledIndices, rng );
+	std::vector<mesh_opt::StepReport> reports;
+	const double ms = test::timeBestOf( 3,
+		[&] ()
+		{
+			std::vector<Vertex> vertices = shuffled;
+			std::vector<unsigned> indices = shuffledIndices;
+			reports = optimize( vertices, indices );
+		} );
+	std::printf( "%zu triangles | mesh_opt::optimize %7.2f ms\n", shuffledIndices.size() / 3, ms );
+	for ( const mesh_opt::StepReport &report : reports )
+	{
+		std::printf( "\t%-22s ACMR %.3f -> %.3f | vertex bytes %zu -> %zu | index bytes %zu -> %zu\n",
+			report.name, report.acmrBefore, report.acmrAfter, report.vertexBytesBefore, report.vertexBytesAfter, report.indexBytesBefore, report.indexBytesAfter );
+	}
+}
+
+TEST_CASE( "mesh_opt::generateLods, uv spheres", "[.][benchmark][mesh_optimizer]" )
+{
+	for ( const unsigned nRings : {64u, 256u, 512u} )
+	{
+		std::vector<unsigned> sphereIndices;
+		const std::vector<Vertex> vertices = makeUvSphere( nRings, nRings * 2, sphereIndices );
+		std::vector<mesh_opt::Lod> lods;
+		const double ms = test::timeBestOf( 3,
+			[&] ()
+			{
+				std::vector<unsigned> indices = sphereIndices;
+				lods = generateLods( vertices, indices );
+			} );
+		std::printf( "%7zu triangles | mesh_opt::generateLods %8.2f ms |", sphereIndices.size() / 3, ms );
+		for ( const mesh_opt::Lod &lod : lods )
+		{
+			std::printf( " %u (%.4f)", lod.nIndices / 3, lod.error );
+		}
+		std::printf( "\n" );
+	}
+}
\ No newline at end of file
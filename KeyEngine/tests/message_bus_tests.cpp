@@ -0,0 +1,390 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <array>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include "message_queue_bus_dispatcher.h"
+#include "entity_manager.h"
+#include "entity.h"
+#include "operation.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+// MessageDispatcher is a singleton which takes its capacity on the first call; every test case here uses this one
+constexpr std::size_t s_capacity = 64u;
+
+/// \brief	records the order in which Messages were received through their Operation payloads
+struct Log final
+{
+	std::vector<int> received;
+
+	void record( const int seq )
+	{
+		received.push_back( seq );
+	}
+};
+
+/// \brief	payloads that log their text when destroyed, one small enough to be stored inline & one that goes to a pool block
+struct Named final
+{
+	static inline std::vector<std::string> s_destroyed;
+	std::string text;
+
+	explicit Named( std::string str )
+		:
+		text{std::move( str )}
+	{
+
+	}
+
+	Named( Named &&rhs ) noexcept = default;
+
+	~Named() noexcept
+	{
+		if ( !text.empty() )
+		{
+			s_destroyed.push_back( text );
+		}
+	}
+};
+
+struct Padded final
+{
+	static inline int s_nAlive = 0;
+	std::string text;
+	std::array<char, 200> padding{};
+
+	explicit Padded( std::string str )
+		:
+		text{std::move( str )}
+	{
+		++s_nAlive;
+	}
+
+	~Padded() noexcept
+	{
+		--s_nAlive;
+		Named::s_destroyed.push_back( text );
+	}
+};
+
+/// \brief	a gameplay payload small enough to be stored inline
+struct DamageInfo final
+{
+	float amount;
+	int kind;
+};
+
+/// \brief	a physics payload that goes to a pool block
+struct CollisionInfo final
+{
+	float contact[3];
+	float normal[3];
+	float impulse;
+	float penetration;
+	std::array<float, 16> features;
+};
+
+MessageDispatcher& getDispatcher()
+{
+	MessageDispatcher &dispatcher = MessageDispatcher::getInstance( s_capacity );
+	dispatcher.clear();
+	return dispatcher;
+}
+
+Entity* spawn( const std::string &name )
+{
+	EntityManager &em = EntityManager::getInstance();
+	return em.getEntityById( em.spawnEntity( name, 0 ) );
+}
+
+bool postRecorded( MessageDispatcher &dispatcher,
+	const Message::Type type,
+	Entity *pRecipient,
+	Log &log,
+	const int seq )
+{
+	return dispatcher.post<std::unique_ptr<Operation>>( type, nullptr, pRecipient, Operation::setup( &Log::record, &log, seq ) );
+}
+
+
+}//namespace
+
+TEST_CASE( "MessageBus dispatches in FIFO order", "[message_bus]" )
+{
+	MessageDispatcher &dispatcher = getDispatcher();
+	REQUIRE( dispatcher.getCapacity() == s_capacity );
+	Entity *pEnt = spawn( "fifo" );
+	Log log;
+	for ( int i = 0; i < 40; ++i )
+	{
+		REQUIRE( postRecorded( dispatcher, Message::Idle, pEnt, log, i ) );
+	}
+	REQUIRE( dispatcher.dispatchAll( 10u ) == 10u );
+	REQUIRE( dispatcher.getSize() == 30u );
+	REQUIRE( dispatcher.dispatchAll() == 30u );
+	REQUIRE( dispatcher.getSize() == 0u );
+	REQUIRE( log.received.size() == 40u );
+	for ( int i = 0; i < 40; ++i )
+	{
+		REQUIRE( log.received[i] == i );
+	}
+}
+
+TEST_CASE( "MessageBus filtered dispatch does not let an unmatched Message pin the ring", "[message_bus]" )
+{
+	MessageDispatcher &dispatcher = getDispatcher();
+	Entity *pIdle = spawn( "idle" );
+	Entity *pBusy = spawn( "busy" );
+	Log idleLog;
+	Log busyLog;
+	// Messages nobody dispatches yet, at the head of the ring & interleaved with the ones that are
+	REQUIRE( postRecorded( dispatcher, Message::Damage, pIdle, idleLog, 0 ) );
+	int nIdle = 1;
+	int nBusy = 0;
+	for ( int round = 0; round < 100; ++round )
+	{
+		for ( int i = 0; i < 20; ++i )
+		{
+			REQUIRE( postRecorded( dispatcher, Message::Idle, pBusy, busyLog, nBusy++ ) );
+		}
+		if ( round % 10 == 0 )
+		{
+			REQUIRE( postRecorded( dispatcher, Message::Damage, pIdle, idleLog, nIdle++ ) );
+		}
+		if ( round % 2 == 0 )
+		{
+			REQUIRE( dispatcher.dispatchEventsTargetedTo( pBusy ) == 20u );
+		}
+		else
+		{
+			REQUIRE( dispatcher.dispatchByEventType( Message::Idle ) == 20u );
+		}
+		REQUIRE( dispatcher.getSize() == static_cast<std::size_t>( nIdle ) );
+	}
+	REQUIRE( busyLog.received.size() == static_cast<std::size_t>( nBusy ) );
+	for ( int i = 0; i < nBusy; ++i )
+	{
+		REQUIRE( busyLog.received[i] == i );
+	}
+
+	// the pinned Messages kept their order & payloads across the compactions
+	REQUIRE( idleLog.received.empty() );
+	REQUIRE( dispatcher.dispatchByEventType( Message::Damage ) == static_cast<std::size_t>( nIdle ) );
+	REQUIRE( idleLog.received.size() == static_cast<std::size_t>( nIdle ) );
+	for ( int i = 0; i < nIdle; ++i )
+	{
+		REQUIRE( idleLog.received[i] == i );
+	}
+	REQUIRE( dispatcher.getSize() == 0u );
+}
+
+TEST_CASE( "MessageBus fills up only with pending Messages", "[message_bus]" )
+{
+	MessageDispatcher &dispatcher = getDispatcher();
+	Entity *pIdle = spawn( "idle" );
+	Entity *pBusy = spawn( "busy" );
+	Log log;
+	// each handled Message sits behind a pending one
+	for ( std::size_t i = 0; i < s_capacity; ++i )
+	{
+		REQUIRE( postRecorded( dispatcher, Message::Idle, pBusy, log, 0 ) );
+		REQUIRE( dispatcher.dispatchEventsTargetedTo( pBusy ) == 1u );
+		REQUIRE( dispatcher.post( Message::Idle, nullptr, pIdle ) );
+	}
+	REQUIRE( dispatcher.getSize() == s_capacity );
+	REQUIRE_FALSE( postRecorded( dispatcher, Message::Idle, pBusy, log, 0 ) );
+	REQUIRE( dispatcher.dispatchEventsTargetedTo( pIdle, 1u ) == 1u );
+	REQUIRE( dispatcher.post( Message::Idle, nullptr, pIdle ) );
+	REQUIRE_FALSE( dispatcher.post( Message::Idle, nullptr, pIdle ) );
+	REQUIRE( dispatcher.dispatchAll() == s_capacity );
+	REQUIRE( log.received.size() == s_capacity );
+}
+
+TEST_CASE( "MessageBus relocates inline & pooled payloads when compacting", "[message_bus]" )
+{
+	MessageDispatcher &dispatcher = getDispatcher();
+	Entity *pIdle = spawn( "idle" );
+	Entity *pBusy = spawn( "busy" );
+	Named::s_destroyed.clear();
+	std::vector<std::string> expected;
+	for ( int i = 0; i < 8; ++i )
+	{
+		REQUIRE( dispatcher.post<Named>( Message::Idle, nullptr, pIdle, "inline " + std::to_string( i ) ) );
+		REQUIRE( dispatcher.post<Padded>( Message::Idle, nullptr, pIdle, "pooled " + std::to_string( i ) ) );
+		REQUIRE( dispatcher.post( Message::Idle, nullptr, pBusy ) );
+		expected.push_back( "inline " + std::to_string( i ) );
+		expected.push_back( "pooled " + std::to_string( i ) );
+	}
+	REQUIRE( Padded::s_nAlive == 8 );
+	REQUIRE( dispatcher.dispatchEventsTargetedTo( pBusy ) == 8u );
+	REQUIRE( dispatcher.getSize() == 16u );
+	// the moved-from inline payloads were destroyed without logging
+	REQUIRE( Named::s_destroyed.empty() );
+
+	// payloads are released in dispatch order, with the text they were posted with
+	for ( int i = 0; i < 16; ++i )
+	{
+		REQUIRE( dispatcher.dispatchEventsTargetedTo( pIdle, 1u ) == 1u );
+	}
+	REQUIRE( Named::s_destroyed == expected );
+	REQUIRE( Padded::s_nAlive == 0 );
+	REQUIRE( dispatcher.getSize() == 0u );
+}
+
+TEST_CASE( "MessageBus many producers, filtered consumer", "[message_bus]" )
+{
+	MessageDispatcher &dispatcher = getDispatcher();
+	Entity *pIdle = spawn( "idle" );
+	Entity *pBusy = spawn( "busy" );
+	REQUIRE( dispatcher.post( Message::Damage, nullptr, pIdle ) );
+	constexpr int nProducers = 3;
+	constexpr int nPerProducer = 2000;
+	// a pinned ring would starve the producers; give up instead of hanging
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+	std::vector<Log> logs( nProducers );
+	std::atomic<int> nProducersDone{0};
+	std::atomic<int> nStarved{0};
+	std::vector<std::thread> producers;
+	for ( int p = 0; p < nProducers; ++p )
+	{
+		producers.emplace_back( [&, p] ()
+			{
+				for ( int i = 0; i < nPerProducer && nStarved.load() == 0; ++i )
+				{
+					while ( !postRecorded( dispatcher, Message::Idle, pBusy, logs[p], i ) )
+					{
+						if ( std::chrono::steady_clock::now() > deadline )
+						{
+							nStarved.fetch_add( 1 );
+							break;
+						}
+						std::this_thread::yield();
+					}
+				}
+				nProducersDone.fetch_add( 1 );
+			} );
+	}
+	std::size_t nDispatched = 0;
+	while ( nProducersDone.load() < nProducers || ( nDispatched < nProducers * nPerProducer && nStarved.load() == 0 ) )
+	{
+		nDispatched += dispatcher.dispatchEventsTargetedTo( pBusy );
+	}
+	for ( auto &producer : producers )
+	{
+		producer.join();
+	}
+	REQUIRE( nStarved.load() == 0 );
+	REQUIRE( nDispatched == nProducers * nPerProducer );
+	for ( const Log &log : logs )
+	{
+		REQUIRE( log.received.size() == nPerProducer );
+		bool bOrdered = true;
+		for ( int i = 0; i < nPerProducer; ++i )
+		{
+			bOrdered = bOrdered && log.received[i] == i;
+		}
+		REQUIRE( bOrdered );
+	}
+	REQUIRE( dispatcher.getSize() == 1u );
+	REQUIRE( dispatcher.dispatchByEventType( Message::Damage ) == 1u );
+}
+
+TEST_CASE( "MessageBus counts the payloads that fall back to the heap", "[message_bus]" )
+{
+	MessageDispatcher &dispatcher = getDispatcher();
+	Entity *pIdle = spawn( "idle" );
+	const std::size_t nHeapPayloads = dispatcher.getHeapPayloadCount();
+	REQUIRE( dispatcher.post<DamageInfo>( Message::Idle, nullptr, pIdle, 5.0f, 1 ) );
+	REQUIRE( dispatcher.post<CollisionInfo>( Message::Idle, nullptr, pIdle ) );
+	REQUIRE( dispatcher.getHeapPayloadCount() == nHeapPayloads );
+	// larger than a pool block
+	REQUIRE( dispatcher.post<std::array<char, MessageBus::s_payloadBlockSize + 1>>( Message::Idle, nullptr, pIdle ) );
+	REQUIRE( dispatcher.getHeapPayloadCount() == nHeapPayloads + 1 );
+	REQUIRE( dispatcher.dispatchAll() == 3u );
+}
+
+TEST_CASE( "MessageBus multithreaded producers throughput", "[.][benchmark][message_bus]" )
+{
+	static_assert( sizeof( DamageInfo ) <= Message::s_inlinePayloadSize && sizeof( CollisionInfo ) > Message::s_inlinePayloadSize, "One inline & one pooled payload!" );
+	MessageDispatcher &dispatcher = getDispatcher();
+	Entity *pTarget = spawn( "target" );
+	// Entity::onMessageReceived logs Damage & PhysicsCollision Messages to std::cout
+	std::streambuf *pCoutBuffer = std::cout.rdbuf( nullptr );
+
+	// nProducers threads post nPerProducer Damage & PhysicsCollision Messages, retrying while the ring is full, as the consumer drains them by type
+	const auto run = [&] ( const int nProducers,
+		const int nPerProducer )
+		{
+			std::atomic<int> nProducersDone{0};
+			std::vector<std::thread> producers;
+			for ( int p = 0; p < nProducers; ++p )
+			{
+				producers.emplace_back( [&] ()
+					{
+						for ( int i = 0; i < nPerProducer; ++i )
+						{
+							if ( i % 2 == 0 )
+							{
+								while ( !dispatcher.post<DamageInfo>( Message::Damage, nullptr, pTarget, float( i ), p ) )
+								{
+									std::this_thread::yield();
+								}
+							}
+							else
+							{
+								while ( !dispatcher.post<CollisionInfo>( Message::PhysicsCollision, nullptr, pTarget, CollisionInfo{{}, {0.0f, 1.0f, 0.0f}, float( i )} ) )
+								{
+									std::this_thread::yield();
+								}
+							}
+						}
+						nProducersDone.fetch_add( 1 );
+					} );
+			}
+			std::size_t nDispatched = 0;
+			const std::size_t nMessages = static_cast<std::size_t>( nProducers ) * nPerProducer;
+			while ( nDispatched < nMessages )
+			{
+				const std::size_t nBatch = dispatcher.dispatchByEventType( Message::Damage ) + dispatcher.dispatchByEventType( Message::PhysicsCollision );
+				if ( nBatch == 0 )
+				{
+					// let the producers run if they share the core
+					std::this_thread::yield();
+				}
+				nDispatched += nBatch;
+			}
+			for ( auto &producer : producers )
+			{
+				producer.join();
+			}
+			return nDispatched;
+		};
+
+	constexpr int nPerProducer = 200000;
+	for ( const int nProducers : {1, 2, 4} )
+	{
+		// warm up: the pool's blocks & the ring's cells have all been used once
+		run( nProducers, 10000 );
+		const std::size_t nHeapPayloads = dispatcher.getHeapPayloadCount();
+		std::size_t nDispatched = 0;
+		const double ms = test::timeBestOf( 1,
+			[&] ()
+			{
+				nDispatched = run( nProducers, nPerProducer );
+			} );
+		std::printf( "%d producers, %zu cell ring | %zu Messages in %7.1f ms, %6.2f M Messages/s, %zu heap payloads after warm up\n", nProducers, dispatcher.getCapacity(), nDispatched, ms, nDispatched / ms / 1e3, dispatcher.getHeapPayloadCount() - nHeapPayloads );
+	}
+
+	std::cout.rdbuf( pCoutBuffer );
+	std::cout.clear();
+	REQUIRE( dispatcher.getSize() == 0u );
+}
\ No newline at end of file
@@ -0,0 +1,552 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <random>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "mip_generator.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+constexpr double s_pi = 3.14159265358979323846;
+
+struct Image final
+{
+	unsigned width;
+	unsigned height;
+	std::vector<ColorBGRA> texels;
+
+	Image( const unsigned width,
+		const unsigned height )
+		:
+		width{width},
+		height{height},
+		texels(static_cast<std::size_t>( width ) * height)
+	{
+
+	}
+
+	mip_gen::MipChain generate( const mip_gen::Settings &settings ) const
+	{
+		return mip_gen::generate( texels.data(), width, height, width * sizeof( ColorBGRA ), settings );
+	}
+};
+
+std::string getTempPath( const std::string &filename )
+{
+	return ( std::filesystem::temp_directory_path() / filename ).string();
+}
+
+double srgbToLinear( const double c )
+{
+	return c <= 0.04045 ?
+		c / 12.92 :
+		std::pow( ( c + 0.055 ) / 1.055, 2.4 );
+}
+
+double linearToSrgb( double l )
+{
+	l = std::clamp( l, 0.0, 1.0 );
+	return l <= 0.0031308 ?
+		l * 12.92 :
+		1.055 * std::pow( l, 1.0 / 2.4 ) - 0.055;
+}
+
+Byte toByte( const double v )
+{
+	return static_cast<Byte>( std::lround( std::clamp( v, 0.0, 1.0 ) * 255.0 ) );
+}
+
+double getChannel( const ColorBGRA col,
+	const int c )
+{
+	return double( ( col.m_dword >> ( 8 * c ) ) & 0xFFu );
+}
+
+/// \brief	over b, g, r & a
+double calcPsnr( const ColorBGRA *pA,
+	const ColorBGRA *pB,
+	const std::size_t nTexels )
+{
+	double squaredError = 0.0;
+	for ( std::size_t i = 0; i < nTexels; ++i )
+	{
+		for ( int c = 0; c < 4; ++c )
+		{
+			const double d = getChannel( pA[i], c ) - getChannel( pB[i], c );
+			squaredError += d * d;
+		}
+	}
+	squaredError /= nTexels * 4.0;
+	return squaredError == 0.0 ?
+		999.0 :
+		10.0 * std::log10( 255.0 * 255.0 / squaredError );
+}
+
+double sinc( const double x )
+{
+	return std::abs( x ) < 1e-9 ?
+		1.0 :
+		std::sin( s_pi * x ) / ( s_pi * x );
+}
+
+double besselI0( const double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for ( int k = 1; k < 64; ++k )
+	{
+		term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+		sum += term;
+	}
+	return sum;
+}
+
+/// \brief	Lanczos 3 or Kaiser windowed sinc of radius 3 & alpha 4; x in destination texels
+double evalFilter( const mip_gen::Filter filter,
+	const double x )
+{
+	if ( std::abs( x ) >= 3.0 )
+	{
+		return 0.0;
+	}
+	if ( filter == mip_gen::Filter::Lanczos )
+	{
+		return sinc( x ) * sinc( x / 3.0 );
+	}
+	const double t = x / 3.0;
+	return sinc( x ) * besselI0( 4.0 * std::sqrt( 1.0 - t * t ) ) / besselI0( 4.0 );
+}
+
+/// \brief	the normalized weights of the source texels under destination texel i
+std::vector<std::pair<int, double>> calcWeights( const unsigned srcSize,
+	const unsigned dstSize,
+	const unsigned i,
+	const mip_gen::Settings &settings )
+{
+	const double scale = double( srcSize ) / dstSize;
+	const double center = ( i + 0.5 ) * scale;
+	const double radius = ( settings.filter == mip_gen::Filter::Box ? 0.5 : 3.0 ) * scale;
+	std::vector<std::pair<int, double>> weights;
+	double sum = 0.0;
+	for ( int j = static_cast<int>( std::floor( center - radius ) ) - 1; j <= static_cast<int>( std::ceil( center + radius ) ) + 1; ++j )
+	{
+		const double w = settings.filter == mip_gen::Filter::Box ?
+			std::max( 0.0, std::min( j + 1.0, center + radius ) - std::max( double( j ), center - radius ) ) :
+			evalFilter( settings.filter, ( j + 0.5 - center ) / scale );
+		if ( w != 0.0 )
+		{
+			const int size = static_cast<int>( srcSize );
+			weights.emplace_back( settings.bWrap ? ( j % size + size ) % size : std::clamp( j, 0, size - 1 ), w );
+			sum += w;
+		}
+	}
+	for ( auto &weight : weights )
+	{
+		weight.second /= sum;
+	}
+	return weights;
+}
+
+/// \brief	the chain in double precision with exact sRGB conversions, without coverage preservation
+std::vector<std::vector<ColorBGRA>> generateReference( const Image &image,
+	const mip_gen::Settings &settings )
+{
+	const std::vector<mip_gen::Level> levels = mip_gen::calcLevels( image.width, image.height );
+	std::vector<std::vector<ColorBGRA>> chain{image.texels};
+	std::vector<double> previous( image.texels.size() * 4 );
+	for ( std::size_t i = 0; i < image.texels.size(); ++i )
+	{
+		for ( int c = 0; c < 3; ++c )
+		{
+			const double v = getChannel( image.texels[i], c );
+			previous[4 * i + c] = settings.bNormalMap ?
+				v * 2.0 / 255.0 - 1.0 :
+				settings.bSrgb ?
+					srgbToLinear( v / 255.0 ) :
+					v / 255.0;
+		}
+		previous[4 * i + 3] = getChannel( image.texels[i], 3 ) / 255.0;
+	}
+	for ( std::size_t l = 1; l < levels.size(); ++l )
+	{
+		const unsigned srcWidth = levels[l - 1].width;
+		const unsigned srcHeight = levels[l - 1].height;
+		const unsigned dstWidth = levels[l].width;
+		const unsigned dstHeight = levels[l].height;
+		std::vector<double> horizontal( static_cast<std::size_t>( dstWidth ) * srcHeight * 4, 0.0 );
+		for ( unsigned x = 0; x < dstWidth; ++x )
+		{
+			for ( const auto &[j, w] : calcWeights( srcWidth, dstWidth, x, settings ) )
+			{
+				for ( unsigned y = 0; y < srcHeight; ++y )
+				{
+					for ( int c = 0; c < 4; ++c )
+					{
+						horizontal[( static_cast<std::size_t>( y ) * dstWidth + x ) * 4 + c] += w * previous[( static_cast<std::size_t>( y ) * srcWidth + j ) * 4 + c];
+					}
+				}
+			}
+		}
+		std::vector<double> current( static_cast<std::size_t>( dstWidth ) * dstHeight * 4, 0.0 );
+		for ( unsigned y = 0; y < dstHeight; ++y )
+		{
+			for ( const auto &[j, w] : calcWeights( srcHeight, dstHeight, y, settings ) )
+			{
+				for ( std::size_t k = 0; k < dstWidth * 4u; ++k )
+				{
+					current[y * dstWidth * 4u + k] += w * horizontal[j * dstWidth * 4u + k];
+				}
+			}
+		}
+
+		std::vector<ColorBGRA> level( static_cast<std::size_t>( dstWidth ) * dstHeight );
+		for ( std::size_t i = 0; i < level.size(); ++i )
+		{
+			// the next level is filtered from this one's renormalized or clamped values
+			double *p = &current[4 * i];
+			const double length = std::sqrt( p[0] * p[0] + p[1] * p[1] + p[2] * p[2] );
+			for ( int c = 0; c < 3; ++c )
+			{
+				p[c] = settings.bNormalMap ?
+					p[c] / length :
+					std::clamp( p[c], 0.0, 1.0 );
+			}
+			p[3] = std::clamp( p[3], 0.0, 1.0 );
+			const auto encode = [&settings] ( const double v ) -> Byte
+				{
+					return toByte( settings.bNormalMap ? v * 0.5 + 0.5 : settings.bSrgb ? linearToSrgb( v ) : v );
+				};
+			level[i] = ColorBGRA{encode( p[2] ), encode( p[1] ), encode( p[0] ), toByte( p[3] )};
+		}
+		chain.push_back( std::move( level ) );
+		previous = std::move( current );
+	}
+	return chain;
+}
+
+double calcWorstPsnr( const mip_gen::MipChain &chain,
+	const std::vector<std::vector<ColorBGRA>> &reference )
+{
+	double worst = 999.0;
+	for ( std::size_t l = 0; l < reference.size(); ++l )
+	{
+		worst = std::min( worst, calcPsnr( reinterpret_cast<const ColorBGRA*>( chain.getLevel( l ) ), reference[l].data(), reference[l].size() ) );
+	}
+	return worst;
+}
+
+/// \brief	smooth gradients with some noise, like a photo
+Image makePhoto( const unsigned width,
+	const unsigned height,
+	std::mt19937 &rng )
+{
+	Image image{width, height};
+	for ( unsigned y = 0; y < height; ++y )
+	{
+		for ( unsigned x = 0; x < width; ++x )
+		{
+			const double v = 0.5 + 0.25 * std::sin( x * 0.05 ) * std::cos( y * 0.07 ) + 0.15 * std::sin( ( x + y ) * 0.31 );
+			const int noise = static_cast<int>( rng() % 21u ) - 10;
+			const auto channel = [noise] ( const double c ) -> Byte
+				{
+					return static_cast<Byte>( std::clamp( static_cast<int>( c * 255 ) + noise, 0, 255 ) );
+				};
+			image.texels[static_cast<std::size_t>( y ) * width + x] = ColorBGRA{channel( v ), channel( ( 1.0 - v ) * 0.8 ), channel( v * v ), 255};
+		}
+	}
+	return image;
+}
+
+/// \brief	random unit normals with z >= 0
+Image makeNormalMap( const unsigned size,
+	std::mt19937 &rng )
+{
+	Image image{size, size};
+	std::uniform_real_distribution<double> distribution{-1.0, 1.0};
+	for ( ColorBGRA &texel : image.texels )
+	{
+		double x = distribution( rng );
+		double y = distribution( rng );
+		const double lengthXy = std::sqrt( x * x + y * y );
+		if ( lengthXy > 1.0 )
+		{
+			x /= lengthXy;
+			y /= lengthXy;
+		}
+		const double z = std::sqrt( std::max( 0.0, 1.0 - x * x - y * y ) );
+		texel = ColorBGRA{toByte( x * 0.5 + 0.5 ), toByte( y * 0.5 + 0.5 ), toByte( z * 0.5 + 0.5 ), 255};
+	}
+	return image;
+}
+
+float calcCoverage( const ColorBGRA *pTexels,
+	const std::size_t nTexels,
+	const float alphaCutoff )
+{
+	std::size_t nCovered = 0;
+	for ( std::size_t i = 0; i < nTexels; ++i )
+	{
+		nCovered += pTexels[i].getAlpha() >= alphaCutoff * 255.0f;
+	}
+	return float( nCovered ) / nTexels;
+}
+
+
+}//namespace
+
+TEST_CASE( "mip_gen chains are within 50dB PSNR of a double precision reference", "[mip_generator]" )
+{
+	std::mt19937 rng{5u};
+	for ( const mip_gen::Filter filter : {mip_gen::Filter::Box, mip_gen::Filter::Kaiser, mip_gen::Filter::Lanczos} )
+	{
+		for ( const bool bSrgb : {true, false} )
+		{
+			for ( const bool bWrap : {true, false} )
+			{
+				for ( const auto &[width, height] : {std::pair{256u, 256u}, {200u, 75u}, {33u, 64u}, {7u, 1u}, {1u, 1u}} )
+				{
+					mip_gen::Settings settings;
+					settings.filter = filter;
+					settings.bSrgb = bSrgb;
+					settings.bWrap = bWrap;
+					const Image image = makePhoto( width, height, rng );
+					const mip_gen::MipChain chain = image.generate( settings );
+					const auto reference = generateReference( image, settings );
+					REQUIRE( chain.levels.size() == reference.size() );
+					INFO( "filter " << static_cast<int>( filter ) << ", sRGB " << bSrgb << ", wrap " << bWrap << ", " << width << "x" << height );
+					REQUIRE( calcWorstPsnr( chain, reference ) >= 50.0 );
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE( "mip_gen filters sRGB colors in linear space", "[mip_generator]" )
+{
+	// a black & white checker averages to half the light, which sRGB encodes as 188 rather than 128
+	Image checker{16u, 16u};
+	for ( unsigned y = 0; y < 16u; ++y )
+	{
+		for ( unsigned x = 0; x < 16u; ++x )
+		{
+			const Byte v = ( x ^ y ) & 1u ? 255 : 0;
+			checker.texels[y * 16u + x] = ColorBGRA{v, v, v, 255};
+		}
+	}
+	mip_gen::Settings settings;
+	settings.filter = mip_gen::Filter::Box;
+	REQUIRE( reinterpret_cast<const ColorBGRA*>( checker.generate( settings ).getLevel( 1 ) )->getRed() == 188 );
+	settings.bSrgb = false;
+	REQUIRE( reinterpret_cast<const ColorBGRA*>( checker.generate( settings ).getLevel( 1 ) )->getRed() == 128 );
+}
+
+TEST_CASE( "mip_gen filters masks linearly & compresses them to BC4", "[mip_generator]" )
+{
+	Image checker{16u, 16u};
+	for ( unsigned y = 0; y < 16u; ++y )
+	{
+		for ( unsigned x = 0; x < 16u; ++x )
+		{
+			checker.texels[y * 16u + x] = ColorBGRA{static_cast<Byte>( ( x ^ y ) & 1u ? 255 : 0 ), 0, 0, 255};
+		}
+	}
+	mip_gen::Settings settings;
+	settings.filter = mip_gen::Filter::Box;
+	settings.bMask = true;
+	REQUIRE( reinterpret_cast<const ColorBGRA*>( checker.generate( settings ).getLevel( 1 ) )->getRed() == 128 );
+
+	settings.bCompress = true;
+	const mip_gen::MipChain chain = checker.generate( settings );
+	REQUIRE( chain.format == bc::Format::BC4 );
+	std::vector<ColorBGRA> decoded( checker.texels.size() );
+	bc::decode( chain.getLevel( 0 ), 16u, 16u, chain.format, decoded.data() );
+	REQUIRE( std::isinf( bc::calcPsnr( checker.texels.data(), decoded.data(), decoded.size(), chain.format ) ) );
+}
+
+TEST_CASE( "mip_gen keeps constant images constant", "[mip_generator]" )
+{
+	Image image{37u, 5u};
+	const ColorBGRA color{90, 17, 201, 77};
+	std::fill( image.texels.begin(), image.texels.end(), color );
+	for ( const mip_gen::Filter filter : {mip_gen::Filter::Box, mip_gen::Filter::Kaiser, mip_gen::Filter::Lanczos} )
+	{
+		for ( const bool bWrap : {true, false} )
+		{
+			mip_gen::Settings settings;
+			settings.filter = filter;
+			settings.bWrap = bWrap;
+			const mip_gen::MipChain chain = image.generate( settings );
+			std::size_t nDrifted = 0;
+			for ( std::size_t l = 0; l < chain.levels.size(); ++l )
+			{
+				const ColorBGRA *pLevel = reinterpret_cast<const ColorBGRA*>( chain.getLevel( l ) );
+				nDrifted += std::count_if( pLevel, pLevel + chain.levels[l].width * chain.levels[l].height,
+					[&color] ( const ColorBGRA texel )
+					{
+						return texel.m_dword != color.m_dword;
+					} );
+			}
+			REQUIRE( nDrifted == 0u );
+		}
+	}
+}
+
+TEST_CASE( "mip_gen clamped images don't bleed across their edges", "[mip_generator]" )
+{
+	// a UI image: red on the left half, blue on the right
+	Image image{64u, 64u};
+	for ( unsigned y = 0; y < 64u; ++y )
+	{
+		for ( unsigned x = 0; x < 64u; ++x )
+		{
+			image.texels[y * 64u + x] = x < 32u ?
+				ColorBGRA{255, 0, 0, 255} :
+				ColorBGRA{0, 0, 255, 255};
+		}
+	}
+	mip_gen::Settings settings;
+	settings.bWrap = false;
+	const mip_gen::MipChain chain = image.generate( settings );
+	const ColorBGRA *pLevel1 = reinterpret_cast<const ColorBGRA*>( chain.getLevel( 1 ) );
+	REQUIRE( pLevel1[0].getBlue() == 0 );
+	REQUIRE( pLevel1[31].getRed() == 0 );
+	settings.bWrap = true;
+	REQUIRE( reinterpret_cast<const ColorBGRA*>( image.generate( settings ).getLevel( 1 ) )[0].getBlue() > 0 );
+}
+
+TEST_CASE( "mip_gen preserves the alpha tested coverage of cutout textures", "[mip_generator]" )
+{
+	std::mt19937 rng{7u};
+	Image image{512u, 512u};
+	for ( unsigned y = 0; y < 512u; ++y )
+	{
+		for ( unsigned x = 0; x < 512u; ++x )
+		{
+			// foliage like blobs of opaque, translucent & clear texels
+			const double a = std::sin( ( x - 256.0 ) * 0.2 ) * std::cos( ( y - 256.0 ) * 0.2 );
+			image.texels[y * 512u + x] = ColorBGRA{static_cast<Byte>( rng() ), static_cast<Byte>( rng() ), static_cast<Byte>( rng() ), static_cast<Byte>( a > 0.3 ? 255 : a > 0.0 ? 128 : 0 )};
+		}
+	}
+	mip_gen::Settings tested;
+	tested.alphaCutoff = 0.5f;
+	mip_gen::Settings blended = tested;
+	blended.alphaCutoff = 0.0f;
+	const mip_gen::MipChain testedChain = image.generate( tested );
+	const mip_gen::MipChain blendedChain = image.generate( blended );
+	const float coverage = calcCoverage( image.texels.data(), image.texels.size(), tested.alphaCutoff );
+	double worstTestedDrift = 0.0;
+	double worstBlendedDrift = 0.0;
+	// the last few levels have too few texels to hit any coverage
+	for ( std::size_t l = 1; l + 3 < testedChain.levels.size(); ++l )
+	{
+		const std::size_t nTexels = static_cast<std::size_t>( testedChain.levels[l].width ) * testedChain.levels[l].height;
+		worstTestedDrift = std::max( worstTestedDrift, double( std::abs( calcCoverage( reinterpret_cast<const ColorBGRA*>( testedChain.getLevel( l ) ), nTexels, tested.alphaCutoff ) - coverage ) ) );
+		worstBlendedDrift = std::max( worstBlendedDrift, double( std::abs( calcCoverage( reinterpret_cast<const ColorBGRA*>( blendedChain.getLevel( l ) ), nTexels, tested.alphaCutoff ) - coverage ) ) );
+	}
+	REQUIRE( worstTestedDrift <= 0.02 );
+	REQUIRE( worstBlendedDrift > worstTestedDrift );
+
+	// only alpha is scaled
+	std::size_t nColorMismatches = 0;
+	for ( std::size_t i = 0; i < testedChain.data.size(); i += 4 )
+	{
+		nColorMismatches += testedChain.data[i] != blendedChain.data[i] || testedChain.data[i + 1] != blendedChain.data[i + 1] || testedChain.data[i + 2] != blendedChain.data[i + 2];
+	}
+	REQUIRE( nColorMismatches == 0u );
+}
+
+TEST_CASE( "mip_gen renormalizes normal maps on every level", "[mip_generator]" )
+{
+	std::mt19937 rng{9u};
+	const Image image = makeNormalMap( 128u, rng );
+	mip_gen::Settings settings;
+	settings.bNormalMap = true;
+	const mip_gen::MipChain chain = image.generate( settings );
+	double worstLengthError = 0.0;
+	for ( std::size_t l = 1; l < chain.levels.size(); ++l )
+	{
+		const ColorBGRA *pLevel = reinterpret_cast<const ColorBGRA*>( chain.getLevel( l ) );
+		for ( std::size_t i = 0; i < static_cast<std::size_t>( chain.levels[l].width ) * chain.levels[l].height; ++i )
+		{
+			double squaredLength = 0.0;
+			for ( int c = 0; c < 3; ++c )
+			{
+				const double v = getChannel( pLevel[i], c ) / 127.5 - 1.0;
+				squaredLength += v * v;
+			}
+			worstLengthError = std::max( worstLengthError, std::abs( std::sqrt( squaredLength ) - 1.0 ) );
+		}
+	}
+	REQUIRE( worstLengthError <= 0.012 );
+	REQUIRE( calcWorstPsnr( chain, generateReference( image, settings ) ) >= 45.0 );
+}
+
+TEST_CASE( "mip_gen cooked chains round trip & go stale", "[mip_generator]" )
+{
+	std::mt19937 rng{11u};
+	const Image image = makePhoto( 300u, 200u, rng );
+	mip_gen::Settings settings;
+	const mip_gen::MipChain chain = image.generate( settings );
+	const std::string path = getTempPath( "key_engine_mip_gen_test.png" );
+	mip_gen::Settings boxSettings = settings;
+	boxSettings.filter = mip_gen::Filter::Box;
+	REQUIRE( mip_gen::calcCookedPath( path, settings ) != mip_gen::calcCookedPath( path, boxSettings ) );
+
+	const std::string cookedPath = mip_gen::calcCookedPath( path, settings );
+	constexpr std::uint64_t sourceHash = 0x1234u;
+	REQUIRE( mip_gen::writeCooked( cookedPath, sourceHash, settings, chain ) );
+	mip_gen::MipChain cooked;
+	REQUIRE( mip_gen::readCooked( cookedPath, sourceHash, settings, cooked ) );
+	REQUIRE( cooked.data == chain.data );
+	REQUIRE( cooked.levels.size() == chain.levels.size() );
+	REQUIRE( cooked.format == chain.format );
+	REQUIRE( cooked.bAlpha == chain.bAlpha );
+
+	REQUIRE_FALSE( mip_gen::readCooked( cookedPath, sourceHash + 1u, settings, cooked ) );
+	REQUIRE_FALSE( mip_gen::readCooked( cookedPath, sourceHash, boxSettings, cooked ) );
+	std::filesystem::resize_file( cookedPath, 1000u );
+	REQUIRE_FALSE( mip_gen::readCooked( cookedPath, sourceHash, settings, cooked ) );
+	REQUIRE( cooked.data.empty() );
+	std::filesystem::remove( cookedPath );
+	REQUIRE_FALSE( mip_gen::readCooked( cookedPath, sourceHash, settings, cooked ) );
+}
+
+TEST_CASE( "mip_gen 4k chain generation", "[.][benchmark][mip_generator]" )
+{
+	std::mt19937 rng{13u};
+	const Image photo = makePhoto( 4096u, 4096u, rng );
+	for ( const mip_gen::Filter filter : {mip_gen::Filter::Box, mip_gen::Filter::Kaiser, mip_gen::Filter::Lanczos} )
+	{
+		mip_gen::Settings settings;
+		settings.filter = filter;
+		const double ms = test::timeBestOf( 3,
+			[&] ()
+			{
+				photo.generate( settings );
+			} );
+		std::printf( "4096x4096 sRGB | %-7s %8.1f ms\n", filter == mip_gen::Filter::Box ? "box" : filter == mip_gen::Filter::Kaiser ? "kaiser" : "lanczos", ms );
+	}
+	const Image normalMap = makeNormalMap( 4096u, rng );
+	mip_gen::Settings settings;
+	settings.bNormalMap = true;
+	const double normalMapMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			normalMap.generate( settings );
+		} );
+	std::printf( "4096x4096 normal map | kaiser %8.1f ms\n", normalMapMs );
+	settings = mip_gen::Settings{};
+	settings.bCompress = true;
+	const double compressedMs = test::timeBestOf( 1,
+		[&] ()
+		{
+			photo.generate( settings );
+		} );
+	std::printf( "4096x4096 sRGB | kaiser & BC1 %8.1f ms\n", compressedMs );
+}
\ No newline at end of file
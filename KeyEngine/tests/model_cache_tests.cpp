@@ -0,0 +1,336 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include "model_cache.h"
+#include "test_utils.h"
+#ifdef KEY_ENGINE_TESTS_ASSIMP
+#	include "assimp/Importer.hpp"
+#	include "assimp/scene.h"
+#	include "assimp/postprocess.h"
+#endif
+
+
+namespace
+{
+
+constexpr unsigned s_importerFlags = 0x1234u;
+
+std::string getTempPath( const std::string &filename )
+{
+	return ( std::filesystem::temp_directory_path() / filename ).string();
+}
+
+std::string readFile( const std::string &path )
+{
+	std::ifstream file{path, std::ios::binary};
+	std::stringstream ss;
+	ss << file.rdbuf();
+	return ss.str();
+}
+
+void writeFile( const std::string &path,
+	const std::string &bytes )
+{
+	std::ofstream file{path, std::ios::binary | std::ios::trunc};
+	file << bytes;
+}
+
+/// \brief	the blobs a Model's meshes are cooked from
+struct TestModel final
+{
+	std::vector<float> vertices0;
+	std::vector<std::uint16_t> indices0{0, 1, 2, 2, 1, 0};
+	std::vector<float> vertices1;
+	std::vector<unsigned> indices1{0, 1, 2, 3, 4, 5, 6, 6, 6};
+	std::string signature0{"P3N3T2"};
+	std::string signature1{"P3N3T2T3B3"};
+	mesh_opt::Lod lods0[2]{{0u, 6u, 0.0f}, {3u, 3u, 0.01f}};
+	DirectX::XMFLOAT4X4 transform{};
+
+	TestModel()
+		:
+		vertices0(5 * 8),
+		vertices1(7 * 14)
+	{
+		for ( std::size_t i = 0; i < vertices0.size(); ++i )
+		{
+			vertices0[i] = i * 0.5f;
+		}
+		for ( std::size_t i = 0; i < vertices1.size(); ++i )
+		{
+			vertices1[i] = -float( i );
+		}
+		transform.m[3][0] = 7.0f;
+	}
+
+	/// \brief	2 materials, 2 meshes & 4 nodes: root { a { aa }, b }
+	void addTo( model_cache::CookedModelWriter &writer ) const
+	{
+		MaterialLoader::Desc material0;
+		material0.name = "mat0";
+		material0.diffuseTexture = "a.png";
+		MaterialLoader::Desc material1;
+		material1.name = "mat1";
+		material1.normalTexture = "n.png";
+		material1.specularGloss = 33.0f;
+		writer.addMaterial( material0 );
+		writer.addMaterial( material1 );
+		writer.addMesh( model_cache::MeshData{"m0", 0u, signature0, vertices0.data(), 5u, 32u, indices0.data(), 6u, 2u, {0.0f, 0.0f, 0.0f}, {1.0f, 2.0f, 3.0f}, lods0, 2u} );
+		writer.addMesh( model_cache::MeshData{"m1", 1u, signature1, vertices1.data(), 7u, 56u, indices1.data(), 9u, 4u, {-1.0f, -1.0f, -1.0f}, {0.0f, 0.0f, 0.0f}, nullptr, 0u} );
+		const unsigned meshesA[] = {0u};
+		const unsigned meshesAa[] = {1u, 0u};
+		writer.addNode( "root", transform, nullptr, 0u, 2u );
+		writer.addNode( "a", transform, meshesA, 1u, 1u );
+		writer.addNode( "aa", transform, meshesAa, 2u, 0u );
+		writer.addNode( "b", transform, nullptr, 0u, 0u );
+	}
+};
+
+#ifdef KEY_ENGINE_TESTS_ASSIMP
+/// \brief	an n x n vertex grid with normals & texture coordinates as a Wavefront OBJ
+void writeGridObj( const std::string &path,
+	const unsigned n )
+{
+	std::string obj;
+	char line[128];
+	for ( unsigned y = 0; y < n; ++y )
+	{
+		for ( unsigned x = 0; x < n; ++x )
+		{
+			std::snprintf( line, sizeof line, "v %g %g %g\nvn 0 0 1\nvt %g %g\n", float( x ), float( y ), float( ( x * 7 + y * 13 ) % 17 ) * 0.1f, float( x ) / n, float( y ) / n );
+			obj += line;
+		}
+	}
+	for ( unsigned y = 0; y + 1 < n; ++y )
+	{
+		for ( unsigned x = 0; x + 1 < n; ++x )
+		{
+			const unsigned a = y * n + x + 1;
+			const unsigned c = a + n;
+			std::snprintf( line, sizeof line, "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, c, c, c, a + 1, a + 1, a + 1, a + 1, a + 1, a + 1, c, c, c, c + 1, c + 1, c + 1 );
+			obj += line;
+		}
+	}
+	writeFile( path, obj );
+}
+#endif
+
+
+}//namespace
+
+TEST_CASE( "CookedModelWriter & CookedModel round trip a Model", "[model_cache]" )
+{
+	const std::string sourcePath = getTempPath( "key_engine_tests_model.obj" );
+	writeFile( sourcePath, "v 1 2 3\nf 1 1 1\n" );
+	const std::uint64_t sourceHash = model_cache::hashFile( sourcePath );
+	REQUIRE( model_cache::hashFile( sourcePath ) == sourceHash );
+	writeFile( sourcePath, "v 1 2 4\nf 1 1 1\n" );
+	REQUIRE( model_cache::hashFile( sourcePath ) != sourceHash );
+
+	const std::string cookedPath = model_cache::calcCookedPath( sourcePath, s_importerFlags, 1.0f );
+	REQUIRE( cookedPath != model_cache::calcCookedPath( sourcePath, s_importerFlags + 1, 1.0f ) );
+	REQUIRE( cookedPath != model_cache::calcCookedPath( sourcePath, s_importerFlags, 2.0f ) );
+
+	const TestModel model;
+	model_cache::CookedModelWriter writer;
+	model.addTo( writer );
+	REQUIRE( writer.write( cookedPath, sourceHash, s_importerFlags, 1.0f ) );
+	{
+		const auto pCooked = model_cache::CookedModel::open( cookedPath, sourceHash, s_importerFlags, 1.0f );
+		REQUIRE( pCooked );
+		REQUIRE( pCooked->getMaterialCount() == 2u );
+		REQUIRE( pCooked->getMeshCount() == 2u );
+		REQUIRE( pCooked->getNodeCount() == 4u );
+
+		const auto material0 = pCooked->getMaterial( 0u );
+		const auto material1 = pCooked->getMaterial( 1u );
+		REQUIRE( material0.diffuseTexture == "a.png" );
+		REQUIRE( material0.diffuseColor.z == 0.85f );
+		REQUIRE( material1.name == "mat1" );
+		REQUIRE( material1.normalTexture == "n.png" );
+		REQUIRE( material1.diffuseTexture.empty() );
+		REQUIRE( material1.specularGloss == 33.0f );
+
+		const auto mesh0 = pCooked->getMesh( 0u );
+		const auto mesh1 = pCooked->getMesh( 1u );
+		REQUIRE( mesh0.name == "m0" );
+		REQUIRE( mesh0.layoutSignature == model.signature0 );
+		REQUIRE( mesh0.nVertices == 5u );
+		REQUIRE( mesh0.indexSize == 2u );
+		REQUIRE( mesh0.aabbMax.z == 3.0f );
+		REQUIRE( std::memcmp( mesh0.pVertices, model.vertices0.data(), 5 * 32 ) == 0 );
+		REQUIRE( std::memcmp( mesh0.pIndices, model.indices0.data(), 6 * 2 ) == 0 );
+		REQUIRE( mesh0.nLods == 2u );
+		REQUIRE( mesh0.pLods[1].startIndex == 3u );
+		REQUIRE( mesh0.pLods[1].error == 0.01f );
+		REQUIRE( mesh1.name == "m1" );
+		REQUIRE( mesh1.materialIndex == 1u );
+		REQUIRE( mesh1.nIndices == 9u );
+		REQUIRE( mesh1.nLods == 0u );
+		REQUIRE( std::memcmp( mesh1.pVertices, model.vertices1.data(), 7 * 56 ) == 0 );
+		REQUIRE( std::memcmp( mesh1.pIndices, model.indices1.data(), 9 * 4 ) == 0 );
+		// the blobs are aligned for SIMD reads
+		REQUIRE( reinterpret_cast<std::uintptr_t>( mesh0.pVertices ) % 16 == 0 );
+		REQUIRE( reinterpret_cast<std::uintptr_t>( mesh1.pIndices ) % 16 == 0 );
+
+		const auto nodeAa = pCooked->getNode( 2u );
+		REQUIRE( nodeAa.name == "aa" );
+		REQUIRE( nodeAa.nMeshes == 2u );
+		REQUIRE( nodeAa.pMeshes[0] == 1u );
+		REQUIRE( nodeAa.pMeshes[1] == 0u );
+		REQUIRE( nodeAa.transform.m[3][0] == 7.0f );
+		REQUIRE( pCooked->getNode( 0u ).nChildren == 2u );
+		REQUIRE( pCooked->getNode( 3u ).name == "b" );
+	}
+	std::filesystem::remove( cookedPath );
+	std::filesystem::remove( sourcePath );
+}
+
+TEST_CASE( "CookedModel rejects stale cooked files", "[model_cache]" )
+{
+	const std::string cookedPath = getTempPath( "key_engine_tests_stale.kcm" );
+	model_cache::CookedModelWriter writer;
+	TestModel{}.addTo( writer );
+	REQUIRE( writer.write( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	REQUIRE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath, 8u, s_importerFlags, 1.0f ) );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags + 1, 1.0f ) );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.5f ) );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath + "x", 7u, s_importerFlags, 1.0f ) );
+	std::filesystem::remove( cookedPath );
+}
+
+TEST_CASE( "CookedModel goes stale when a dependency changes", "[model_cache]" )
+{
+	const std::string cookedPath = getTempPath( "key_engine_tests_dependencies.kcm" );
+	const std::string materialLibraryPath = getTempPath( "key_engine_tests_dependencies.mtl" );
+	const std::string texturePath = getTempPath( "key_engine_tests_dependencies.png" );
+	writeFile( materialLibraryPath, "newmtl mat0\nKd 1 1 1\n" );
+	writeFile( texturePath, "texels" );
+
+	model_cache::CookedModelWriter writer;
+	TestModel{}.addTo( writer );
+	writer.addDependency( materialLibraryPath );
+	writer.addDependency( texturePath );
+	writer.addDependency( materialLibraryPath );
+	REQUIRE( writer.write( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	REQUIRE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+
+	writeFile( materialLibraryPath, "newmtl mat0\nKd 1 0 1\n" );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	writeFile( materialLibraryPath, "newmtl mat0\nKd 1 1 1\n" );
+	REQUIRE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+
+	std::filesystem::remove( texturePath );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	writeFile( texturePath, "other texels" );
+	REQUIRE_FALSE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	writeFile( texturePath, "texels" );
+	REQUIRE( model_cache::CookedModel::open( cookedPath, 7u, s_importerFlags, 1.0f ) );
+
+	REQUIRE( model_cache::hashFiles( {materialLibraryPath, texturePath} ) != model_cache::hashFiles( {texturePath, materialLibraryPath} ) );
+	REQUIRE( model_cache::hashFiles( {materialLibraryPath} ) != model_cache::hashFiles( {materialLibraryPath + "x"} ) );
+	std::filesystem::remove( cookedPath );
+	std::filesystem::remove( materialLibraryPath );
+	std::filesystem::remove( texturePath );
+}
+
+TEST_CASE( "CookedModel rejects every truncated or corrupted file", "[model_cache]" )
+{
+	const std::string cookedPath = getTempPath( "key_engine_tests_intact.kcm" );
+	const std::string corruptPath = getTempPath( "key_engine_tests_corrupt.kcm" );
+	model_cache::CookedModelWriter writer;
+	TestModel{}.addTo( writer );
+	REQUIRE( writer.write( cookedPath, 7u, s_importerFlags, 1.0f ) );
+	const std::string bytes = readFile( cookedPath );
+
+	for ( const std::size_t size : {std::size_t{0}, std::size_t{10}, bytes.size() / 2, bytes.size() - 1} )
+	{
+		writeFile( corruptPath, bytes.substr( 0, size ) );
+		REQUIRE_FALSE( model_cache::CookedModel::open( corruptPath, 7u, s_importerFlags, 1.0f ) );
+	}
+	writeFile( corruptPath, bytes + '\0' );
+	REQUIRE_FALSE( model_cache::CookedModel::open( corruptPath, 7u, s_importerFlags, 1.0f ) );
+
+	// a flipped byte anywhere - header, records, strings, padding or blobs
+	std::mt19937 rng{5u};
+	int nAccepted = 0;
+	for ( int i = 0; i < 2000; ++i )
+	{
+		std::string corrupt = bytes;
+		corrupt[rng() % corrupt.size()] ^= static_cast<char>( 1 + rng() % 255 );
+		writeFile( corruptPath, corrupt );
+		nAccepted += model_cache::CookedModel::open( corruptPath, 7u, s_importerFlags, 1.0f ) != nullptr;
+	}
+	REQUIRE( nAccepted == 0 );
+	std::filesystem::remove( cookedPath );
+	std::filesystem::remove( corruptPath );
+}
+
+#ifdef KEY_ENGINE_TESTS_ASSIMP
+TEST_CASE( "CookedModel load vs Assimp import, 512x512 vertex grid", "[.][benchmark][model_cache]" )
+{
+	constexpr unsigned n = 512u;
+	// Model's import flags
+	constexpr unsigned importerFlags = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded | aiProcess_GenNormals | aiProcess_CalcTangentSpace;
+	const std::string sourcePath = getTempPath( "key_engine_tests_grid.obj" );
+	writeGridObj( sourcePath, n );
+
+	std::size_t nImportedVertices = 0;
+	const double importMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			Assimp::Importer importer;
+			const aiScene *pScene = importer.ReadFile( sourcePath.c_str(), importerFlags );
+			REQUIRE( pScene != nullptr );
+			nImportedVertices = pScene->mMeshes[0]->mNumVertices;
+		} );
+
+	// what the import cooks: P3N3T2 vertices & 32 bit indices
+	std::vector<float> vertices( static_cast<std::size_t>( n ) * n * 8 );
+	std::vector<unsigned> indices( static_cast<std::size_t>( n - 1 ) * ( n - 1 ) * 6 );
+	for ( std::size_t i = 0; i < vertices.size(); ++i )
+	{
+		vertices[i] = float( i % 977 ) * 0.25f;
+	}
+	for ( std::size_t i = 0; i < indices.size(); ++i )
+	{
+		indices[i] = static_cast<unsigned>( ( i * 7 ) % ( n * n ) );
+	}
+	const std::string cookedPath = model_cache::calcCookedPath( sourcePath, importerFlags, 1.0f );
+	{
+		MaterialLoader::Desc material;
+		material.name = "grid";
+		model_cache::CookedModelWriter writer;
+		writer.addMaterial( material );
+		writer.addMesh( model_cache::MeshData{"grid", 0u, "P3N3T2", vertices.data(), n * n, 32u, indices.data(), static_cast<unsigned>( indices.size() ), 4u, {0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, nullptr, 0u} );
+		const unsigned meshes[] = {0u};
+		writer.addNode( "root", DirectX::XMFLOAT4X4{}, meshes, 1u, 0u );
+		REQUIRE( writer.write( cookedPath, model_cache::hashFile( sourcePath ), importerFlags, 1.0f ) );
+	}
+
+	double sum = 0.0;
+	const double cookedMs = test::timeBestOf( 5,
+		[&] ()
+		{
+			// what Model does on load: hash the source, open & validate the cooked file & upload every byte of the blobs
+			const auto pCooked = model_cache::CookedModel::open( cookedPath, model_cache::hashFile( sourcePath ), importerFlags, 1.0f );
+			REQUIRE( pCooked );
+			const auto mesh = pCooked->getMesh( 0u );
+			std::vector<std::uint8_t> upload( static_cast<std::size_t>( mesh.nVertices ) * mesh.vertexStride + static_cast<std::size_t>( mesh.nIndices ) * mesh.indexSize );
+			std::memcpy( upload.data(), mesh.pVertices, static_cast<std::size_t>( mesh.nVertices ) * mesh.vertexStride );
+			std::memcpy( upload.data() + static_cast<std::size_t>( mesh.nVertices ) * mesh.vertexStride, mesh.pIndices, static_cast<std::size_t>( mesh.nIndices ) * mesh.indexSize );
+			sum += upload[upload.size() / 2];
+		} );
+	std::printf( "%zu vertices | Assimp import %8.2f ms (before mesh_opt & LODs) | cooked load %7.2f ms (%g)\n",
+		nImportedVertices, importMs, cookedMs, sum );
+	std::filesystem::remove( cookedPath );
+	std::filesystem::remove( sourcePath );
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,4 @@
+#pragma once
+
+// force included by non MSVC builds of the tests, for the MSVC intrinsics the engine's headers use
+#define __debugbreak() ( (void) 0 )
\ No newline at end of file
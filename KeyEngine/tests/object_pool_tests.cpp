@@ -0,0 +1,238 @@
+#include "catch/catch.hpp"
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include "object_pool.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+struct alignas( 32 ) Particle final
+{
+	float position[4];
+	float velocity[4];
+	std::uint32_t owner;
+};
+
+/// \brief	takes its arguments by rvalue & lvalue reference, so it only compiles if construct forwards them
+struct Payload final
+{
+	std::unique_ptr<int> pValue;
+	std::string &name;
+
+	Payload( std::unique_ptr<int> &&pVal,
+		std::string &nam )
+		:
+		pValue{std::move( pVal )},
+		name{nam}
+	{
+
+	}
+};
+
+/// \brief	nThreads threads each allocate & free nObjsPerThread objects in rounds of 64
+template<typename TAllocate, typename TFree>
+void churn( const std::size_t nThreads,
+	const std::size_t nObjsPerThread,
+	const TAllocate &allocate,
+	const TFree &free )
+{
+	std::vector<std::thread> threads;
+	for ( std::size_t t = 0; t < nThreads; ++t )
+	{
+		threads.emplace_back( [&] ()
+			{
+				Particle *objs[64];
+				for ( std::size_t i = 0; i < nObjsPerThread; i += 64 )
+				{
+					for ( Particle *&pObj : objs )
+					{
+						pObj = allocate();
+					}
+					for ( Particle *pObj : objs )
+					{
+						free( pObj );
+					}
+				}
+			} );
+	}
+	for ( auto &thread : threads )
+	{
+		thread.join();
+	}
+}
+
+
+}//namespace
+
+TEST_CASE( "ObjectPool grows in chunks instead of running out", "[object_pool]" )
+{
+	ObjectPool<Particle> pool{4u};
+	std::set<Particle*> objs;
+	for ( int i = 0; i < 1000; ++i )
+	{
+		Particle *pObj = pool.construct( Particle{{0.0f}, {0.0f}, static_cast<std::uint32_t>( i )} );
+		REQUIRE( reinterpret_cast<std::uintptr_t>( pObj ) % alignof( Particle ) == 0u );
+		objs.insert( pObj );
+	}
+	REQUIRE( objs.size() == 1000u );
+	ObjectPool<Particle>::Stats stats = pool.getStats();
+	REQUIRE( stats.m_capacity >= 1000u );
+	// chunk sizes double: 4 + 8 + .. + 512
+	REQUIRE( stats.m_nChunks == 8u );
+
+	for ( Particle *pObj : objs )
+	{
+		pool.destroy( pObj );
+	}
+	pool.destroy( nullptr );
+	stats = pool.getStats();
+	// threads report their allocations to the pool once a batch
+	REQUIRE( stats.m_highWaterMark >= 1000u - 32u );
+	REQUIRE( stats.m_highWaterMark <= 1000u + 32u );
+	// freed objects are reused, so a second round doesn't grow the pool
+	objs.clear();
+	for ( int i = 0; i < 1000; ++i )
+	{
+		objs.insert( pool.allocate() );
+	}
+	REQUIRE( pool.getStats().m_nChunks == 8u );
+	REQUIRE( objs.size() == 1000u );
+}
+
+TEST_CASE( "ObjectPool construct forwards its arguments", "[object_pool]" )
+{
+	ObjectPool<Payload> pool{16u};
+	std::string name = "message";
+	Payload *pPayload = pool.construct( std::make_unique<int>( 42 ), name );
+	REQUIRE( *pPayload->pValue == 42 );
+	REQUIRE( &pPayload->name == &name );
+	pool.destroy( pPayload );
+}
+
+TEST_CASE( "ObjectPool objects can be freed on any thread", "[object_pool]" )
+{
+	ObjectPool<Particle> pool{8u};
+	constexpr std::uint32_t nThreads = 8u;
+	constexpr std::uint32_t nObjsPerThread = 1000u;
+	std::vector<Particle*> handedOver( nThreads * nObjsPerThread );
+	std::atomic<int> nCorrupted{0};
+	std::vector<std::thread> threads;
+	for ( std::uint32_t t = 0; t < nThreads; ++t )
+	{
+		threads.emplace_back( [&, t] ()
+			{
+				std::vector<Particle*> objs;
+				for ( int round = 0; round < 50; ++round )
+				{
+					for ( std::uint32_t i = 0; i < 500; ++i )
+					{
+						objs.push_back( pool.construct( Particle{{float( i )}, {0.0f}, t} ) );
+					}
+					// an object handed out twice would have been overwritten by its other owner
+					for ( std::uint32_t i = 0; i < objs.size(); ++i )
+					{
+						if ( objs[i]->owner != t || objs[i]->position[0] != float( i ) )
+						{
+							++nCorrupted;
+						}
+						pool.destroy( objs[i] );
+					}
+					objs.clear();
+				}
+				for ( std::uint32_t i = 0; i < nObjsPerThread; ++i )
+				{
+					handedOver[t * nObjsPerThread + i] = pool.construct( Particle{{0.0f}, {0.0f}, t} );
+				}
+			} );
+	}
+	for ( auto &thread : threads )
+	{
+		thread.join();
+	}
+	REQUIRE( nCorrupted == 0 );
+	REQUIRE( std::set<Particle*>( handedOver.begin(), handedOver.end() ).size() == handedOver.size() );
+
+	std::thread freeingThread{[&] ()
+		{
+			for ( Particle *pObj : handedOver )
+			{
+				pool.destroy( pObj );
+			}
+		}};
+	freeingThread.join();
+	// the exited threads returned their caches
+	const ObjectPool<Particle>::Stats stats = pool.getStats();
+	REQUIRE( stats.m_nLive == 0u );
+	REQUIRE( stats.m_highWaterMark >= nThreads * nObjsPerThread );
+	REQUIRE( stats.m_capacity <= 4u * nThreads * nObjsPerThread );
+}
+
+TEST_CASE( "PoolAllocator serves standard containers", "[object_pool]" )
+{
+	std::list<int, PoolAllocator<int>> list;
+	for ( int i = 0; i < 1000; ++i )
+	{
+		list.push_back( i );
+	}
+	int sum = 0;
+	for ( const int i : list )
+	{
+		sum += i;
+	}
+	REQUIRE( sum == 999 * 1000 / 2 );
+
+	std::map<int, std::string, std::less<int>, PoolAllocator<std::pair<const int, std::string>>> map;
+	for ( int i = 0; i < 1000; ++i )
+	{
+		map[i] = std::to_string( i );
+	}
+	map.erase( 500 );
+	REQUIRE( map.size() == 999u );
+	REQUIRE( map.at( 999 ) == "999" );
+
+	// arrays go to std::allocator
+	std::vector<int, PoolAllocator<int>> vector( 100u, 7 );
+	vector.push_back( 8 );
+	REQUIRE( vector.size() == 101u );
+	REQUIRE( vector.back() == 8 );
+
+	using Traits = std::allocator_traits<PoolAllocator<int>>;
+	static_assert( std::is_same_v<Traits::rebind_alloc<double>, PoolAllocator<double>> );
+	REQUIRE( PoolAllocator<int>{} == PoolAllocator<double>{} );
+}
+
+TEST_CASE( "ObjectPool vs new & delete, multithreaded alloc & free", "[.][benchmark][object_pool]" )
+{
+	constexpr std::size_t nObjsPerThread = 1u << 20;
+	for ( const std::size_t nThreads : {1u, 4u} )
+	{
+		ObjectPool<Particle> pool{1024u};
+		const double poolMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				churn( nThreads, nObjsPerThread,
+					[&pool] () { return pool.construct(); },
+					[&pool] ( Particle *p ) { pool.destroy( p ); } );
+			} );
+		const double heapMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				churn( nThreads, nObjsPerThread,
+					[] () { return new Particle{}; },
+					[] ( Particle *p ) { delete p; } );
+			} );
+		const ObjectPool<Particle>::Stats stats = pool.getStats();
+		std::printf( "%zu threads x %zu alloc & free | ObjectPool %7.2f ms (%zu objects in %zu chunks) | new & delete %7.2f ms\n",
+			nThreads, nObjsPerThread, poolMs, stats.m_capacity, stats.m_nChunks, heapMs );
+	}
+}
\ No newline at end of file
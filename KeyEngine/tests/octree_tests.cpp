@@ -0,0 +1,353 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <set>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include "octree.h"
+#include "test_utils.h"
+
+
+namespace dx = DirectX;
+
+namespace
+{
+
+struct Scene final
+{
+	std::vector<dx::XMFLOAT3> points;
+	std::vector<bool> alive;
+};
+
+float distanceSq( const dx::XMFLOAT3 &a,
+	const dx::XMFLOAT3 &b ) noexcept
+{
+	const float dx = a.x - b.x;
+	const float dy = a.y - b.y;
+	const float dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+/// \brief	compares every query of the tree against a brute force scan of the live points
+void checkQueries( const Octree &tree,
+	const Scene &scene,
+	std::mt19937 &rng )
+{
+	std::uniform_real_distribution<float> coord{-100.0f, 100.0f};
+	const dx::XMFLOAT3 center{coord( rng ), coord( rng ), coord( rng )};
+
+	std::vector<Octree::ItemId> results;
+	const float radius = 15.0f;
+	tree.getEntitiesWithinSphere( center, radius, results );
+	std::set<Octree::ItemId> expected;
+	for ( Octree::ItemId i = 0; i < scene.points.size(); ++i )
+	{
+		if ( scene.alive[i] && distanceSq( scene.points[i], center ) <= radius * radius )
+		{
+			expected.insert( i );
+		}
+	}
+	REQUIRE( std::set<Octree::ItemId>( results.begin(), results.end() ) == expected );
+	REQUIRE( results.size() == expected.size() );
+
+	results.clear();
+	expected.clear();
+	const dx::XMFLOAT3 bmin{center.x - 10.0f, center.y - 20.0f, center.z - 5.0f};
+	const dx::XMFLOAT3 bmax{center.x + 10.0f, center.y + 20.0f, center.z + 5.0f};
+	tree.getEntitiesWithinBBox( bmin, bmax, results );
+	for ( Octree::ItemId i = 0; i < scene.points.size(); ++i )
+	{
+		const dx::XMFLOAT3 &p = scene.points[i];
+		if ( scene.alive[i] && p.x >= bmin.x && p.y >= bmin.y && p.z >= bmin.z && p.x <= bmax.x && p.y <= bmax.y && p.z <= bmax.z )
+		{
+			expected.insert( i );
+		}
+	}
+	REQUIRE( std::set<Octree::ItemId>( results.begin(), results.end() ) == expected );
+
+	results.clear();
+	constexpr std::size_t k = 10u;
+	tree.getKNearest( center, k, results );
+	std::vector<float> nearest;
+	for ( Octree::ItemId i = 0; i < scene.points.size(); ++i )
+	{
+		if ( scene.alive[i] )
+		{
+			nearest.push_back( distanceSq( scene.points[i], center ) );
+		}
+	}
+	std::sort( nearest.begin(), nearest.end() );
+	REQUIRE( results.size() == std::min( k, nearest.size() ) );
+	for ( std::size_t i = 0; i < results.size(); ++i )
+	{
+		REQUIRE( distanceSq( scene.points[results[i]], center ) == nearest[i] );
+	}
+
+	const dx::XMFLOAT3 dir{0.6f, 0.8f, 0.0f};
+	const float maxDistance = 100.0f;
+	const float hitRadius = 3.0f;
+	std::vector<std::pair<Octree::ItemId, float>> hits;
+	tree.raycast( center, dir, maxDistance, hitRadius, hits );
+	std::size_t nExpectedHits = 0;
+	for ( Octree::ItemId i = 0; i < scene.points.size(); ++i )
+	{
+		const dx::XMFLOAT3 &p = scene.points[i];
+		const float t = std::clamp( ( p.x - center.x ) * dir.x + ( p.y - center.y ) * dir.y + ( p.z - center.z ) * dir.z, 0.0f, maxDistance );
+		const dx::XMFLOAT3 closest{center.x + dir.x * t, center.y + dir.y * t, center.z + dir.z * t};
+		nExpectedHits += scene.alive[i] && distanceSq( closest, p ) <= hitRadius * hitRadius;
+	}
+	REQUIRE( hits.size() == nExpectedHits );
+	REQUIRE( std::is_sorted( hits.begin(), hits.end(), [] ( const auto &a, const auto &b ) { return a.second < b.second; } ) );
+}
+
+Scene makeScene( const std::size_t nPoints,
+	const std::size_t nDuplicates,
+	std::mt19937 &rng )
+{
+	std::uniform_real_distribution<float> coord{-100.0f, 100.0f};
+	Scene scene;
+	scene.points.resize( nPoints );
+	for ( auto &p : scene.points )
+	{
+		p = {coord( rng ), coord( rng ), coord( rng )};
+	}
+	std::fill_n( scene.points.begin(), nDuplicates, dx::XMFLOAT3{1.0f, 1.0f, 1.0f} );
+	scene.alive.assign( nPoints, true );
+	return scene;
+}
+
+/// \brief	the Octree design it replaced: a heap allocated node per octant & a single point per leaf
+class PointerOctree final
+{
+	dx::XMFLOAT3 m_center;
+	dx::XMFLOAT3 m_half;
+	std::unique_ptr<PointerOctree> m_children[8];
+	const dx::XMFLOAT3 *m_pData = nullptr;
+	bool m_bLeaf = true;
+
+	int getOctant( const dx::XMFLOAT3 &p ) const noexcept
+	{
+		return ( p.x >= m_center.x ? 4 : 0 ) | ( p.y >= m_center.y ? 2 : 0 ) | ( p.z >= m_center.z ? 1 : 0 );
+	}
+public:
+	PointerOctree( const dx::XMFLOAT3 &center,
+		const dx::XMFLOAT3 &half )
+		:
+		m_center{center},
+		m_half{half}
+	{
+
+	}
+
+	void insert( const dx::XMFLOAT3 *pPoint )
+	{
+		if ( m_bLeaf )
+		{
+			if ( m_pData == nullptr )
+			{
+				m_pData = pPoint;
+				return;
+			}
+			m_bLeaf = false;
+			for ( int i = 0; i < 8; ++i )
+			{
+				const dx::XMFLOAT3 center{m_center.x + m_half.x * ( i & 4 ? 0.5f : -0.5f ), m_center.y + m_half.y * ( i & 2 ? 0.5f : -0.5f ), m_center.z + m_half.z * ( i & 1 ? 0.5f : -0.5f )};
+				m_children[i] = std::make_unique<PointerOctree>( center, dx::XMFLOAT3{m_half.x * 0.5f, m_half.y * 0.5f, m_half.z * 0.5f} );
+			}
+			m_children[getOctant( *m_pData )]->insert( m_pData );
+			m_pData = nullptr;
+		}
+		m_children[getOctant( *pPoint )]->insert( pPoint );
+	}
+
+	void getEntitiesWithinBBox( const dx::XMFLOAT3 &bmin,
+		const dx::XMFLOAT3 &bmax,
+		std::vector<const dx::XMFLOAT3*> &resultsOut ) const
+	{
+		if ( m_bLeaf )
+		{
+			if ( m_pData != nullptr )
+			{
+				const dx::XMFLOAT3 &p = *m_pData;
+				if ( p.x >= bmin.x && p.y >= bmin.y && p.z >= bmin.z && p.x <= bmax.x && p.y <= bmax.y && p.z <= bmax.z )
+				{
+					resultsOut.push_back( m_pData );
+				}
+			}
+			return;
+		}
+		for ( const auto &pChild : m_children )
+		{
+			const dx::XMFLOAT3 cmin{pChild->m_center.x - pChild->m_half.x, pChild->m_center.y - pChild->m_half.y, pChild->m_center.z - pChild->m_half.z};
+			const dx::XMFLOAT3 cmax{pChild->m_center.x + pChild->m_half.x, pChild->m_center.y + pChild->m_half.y, pChild->m_center.z + pChild->m_half.z};
+			if ( cmax.x >= bmin.x && cmax.y >= bmin.y && cmax.z >= bmin.z && cmin.x <= bmax.x && cmin.y <= bmax.y && cmin.z <= bmax.z )
+			{
+				pChild->getEntitiesWithinBBox( bmin, bmax, resultsOut );
+			}
+		}
+	}
+};
+
+
+}//namespace
+
+TEST_CASE( "Octree bulk build answers queries like a brute force scan", "[octree]" )
+{
+	std::mt19937 rng{1u};
+	const Scene scene = makeScene( 20000u, 500u, rng );
+	Octree tree{{0.0f, 0.0f, 0.0f}, {100.0f, 100.0f, 100.0f}, 8u};
+	tree.build( scene.points );
+	REQUIRE( tree.getItemCount() == scene.points.size() );
+	for ( int i = 0; i < 20; ++i )
+	{
+		checkQueries( tree, scene, rng );
+	}
+}
+
+TEST_CASE( "Octree incremental insert, remove & move", "[octree]" )
+{
+	std::mt19937 rng{2u};
+	Scene scene = makeScene( 5000u, 200u, rng );
+	Octree tree{{0.0f, 0.0f, 0.0f}, {100.0f, 100.0f, 100.0f}, 8u};
+	tree.build( scene.points );
+
+	std::uniform_real_distribution<float> coord{-100.0f, 100.0f};
+	std::uniform_real_distribution<float> nudge{-2.0f, 2.0f};
+	for ( int op = 0; op < 50000; ++op )
+	{
+		const Octree::ItemId id = rng() % scene.points.size();
+		switch ( rng() % 3 )
+		{
+		case 0:
+			REQUIRE( tree.remove( id ) == scene.alive[id] );
+			scene.alive[id] = false;
+			break;
+		case 1:
+			if ( scene.alive[id] )
+			{
+				dx::XMFLOAT3 &p = scene.points[id];
+				p = {std::clamp( p.x + nudge( rng ), -99.0f, 99.0f ), std::clamp( p.y + nudge( rng ), -99.0f, 99.0f ), p.z};
+				tree.move( id, p );
+				REQUIRE( tree.getPosition( id ).x == p.x );
+			}
+			break;
+		default:
+		{
+			const dx::XMFLOAT3 p{coord( rng ), coord( rng ), coord( rng )};
+			const Octree::ItemId newId = tree.insert( p );
+			if ( newId >= scene.points.size() )
+			{
+				scene.points.resize( newId + 1 );
+				scene.alive.resize( newId + 1, false );
+			}
+			REQUIRE_FALSE( scene.alive[newId] );
+			scene.points[newId] = p;
+			scene.alive[newId] = true;
+		}
+		}
+		if ( op % 5000 == 0 )
+		{
+			checkQueries( tree, scene, rng );
+		}
+	}
+	REQUIRE( tree.getItemCount() == static_cast<std::size_t>( std::count( scene.alive.begin(), scene.alive.end(), true ) ) );
+	checkQueries( tree, scene, rng );
+
+	// removing everything collapses the tree back to its root
+	for ( Octree::ItemId id = 0; id < scene.points.size(); ++id )
+	{
+		if ( scene.alive[id] )
+		{
+			REQUIRE( tree.remove( id ) );
+		}
+	}
+	REQUIRE( tree.getItemCount() == 0u );
+	REQUIRE( tree.getNodeCount() == 1u );
+}
+
+TEST_CASE( "Octree keeps duplicate points without splitting forever", "[octree]" )
+{
+	Octree tree{{0.0f, 0.0f, 0.0f}, {10.0f, 10.0f, 10.0f}, 4u, 6u};
+	std::vector<Octree::ItemId> ids;
+	for ( int i = 0; i < 1000; ++i )
+	{
+		ids.push_back( tree.insert( {2.0f, 2.0f, 2.0f} ) );
+	}
+	std::vector<Octree::ItemId> results;
+	tree.getEntitiesWithinSphere( {2.0f, 2.0f, 2.0f}, 0.01f, results );
+	REQUIRE( results.size() == 1000u );
+	REQUIRE( tree.getNodeCount() <= 1u + 8u * 6u );
+}
+
+TEST_CASE( "Octree vs pointer octree build & query", "[.][benchmark][octree]" )
+{
+	std::mt19937 rng{3u};
+	for ( const std::size_t nPoints : {10000u, 50000u, 200000u} )
+	{
+		const Scene scene = makeScene( nPoints, 0u, rng );
+		std::vector<dx::XMFLOAT3> boxCenters( 1000u );
+		std::uniform_real_distribution<float> coord{-90.0f, 90.0f};
+		for ( auto &c : boxCenters )
+		{
+			c = {coord( rng ), coord( rng ), coord( rng )};
+		}
+
+		std::unique_ptr<PointerOctree> pPointerTree;
+		const double pointerBuildMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				pPointerTree = std::make_unique<PointerOctree>( dx::XMFLOAT3{0.0f, 0.0f, 0.0f}, dx::XMFLOAT3{100.0f, 100.0f, 100.0f} );
+				for ( const auto &p : scene.points )
+				{
+					pPointerTree->insert( &p );
+				}
+			} );
+		std::size_t nPointerResults = 0;
+		const double pointerQueryMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				std::vector<const dx::XMFLOAT3*> results;
+				nPointerResults = 0;
+				for ( const auto &c : boxCenters )
+				{
+					results.clear();
+					pPointerTree->getEntitiesWithinBBox( {c.x - 5.0f, c.y - 5.0f, c.z - 5.0f}, {c.x + 5.0f, c.y + 5.0f, c.z + 5.0f}, results );
+					nPointerResults += results.size();
+				}
+			} );
+
+		Octree tree{{0.0f, 0.0f, 0.0f}, {100.0f, 100.0f, 100.0f}};
+		const double buildMs = test::timeBestOf( 3, [&] () { tree.build( scene.points ); } );
+		std::size_t nResults = 0;
+		const double queryMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				std::vector<Octree::ItemId> results;
+				nResults = 0;
+				for ( const auto &c : boxCenters )
+				{
+					results.clear();
+					tree.getEntitiesWithinBBox( {c.x - 5.0f, c.y - 5.0f, c.z - 5.0f}, {c.x + 5.0f, c.y + 5.0f, c.z + 5.0f}, results );
+					nResults += results.size();
+				}
+			} );
+		CHECK( nResults == nPointerResults );
+
+		// a frame of a dynamic scene: 10% of the items move a little
+		Scene moving = scene;
+		std::uniform_real_distribution<float> nudge{-0.5f, 0.5f};
+		const double moveMs = test::timeBestOf( 3,
+			[&] ()
+			{
+				for ( Octree::ItemId id = 0; id < moving.points.size(); id += 10 )
+				{
+					dx::XMFLOAT3 &p = moving.points[id];
+					p.x = std::clamp( p.x + nudge( rng ), -99.0f, 99.0f );
+					tree.move( id, p );
+				}
+			} );
+		std::printf( "%7zu points | pointer octree build %8.2f ms, 1000 box queries %7.2f ms | linear octree build %6.2f ms, 1000 box queries %6.2f ms, moving 10%% %6.2f ms\n",
+			nPoints, pointerBuildMs, pointerQueryMs, buildMs, queryMs, moveMs );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include "perlin_noise.h"
+#include "cpu_features.h"
+#include "thread_poolj.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	the PerlinNoise this one replaced: a std::vector permutation & a double at a time
+class OriginalNoise final
+{
+	std::vector<int> m_permutationVec;
+public:
+	explicit OriginalNoise( const unsigned seed )
+		:
+		m_permutationVec( 256 )
+	{
+		std::iota( m_permutationVec.begin(), m_permutationVec.end(), 0 );
+		std::default_random_engine engine( seed );
+		std::shuffle( m_permutationVec.begin(), m_permutationVec.end(), engine );
+		m_permutationVec.insert( m_permutationVec.end(), m_permutationVec.begin(), m_permutationVec.end() );
+	}
+
+	double noise( double x,
+		double y,
+		double z ) const
+	{
+		const int X = (int) std::floor( x ) & 255;
+		const int Y = (int) std::floor( y ) & 255;
+		const int Z = (int) std::floor( z ) & 255;
+		x -= std::floor( x );
+		y -= std::floor( y );
+		z -= std::floor( z );
+		const double u = fade( x );
+		const double v = fade( y );
+		const double w = fade( z );
+		const int A = m_permutationVec[X] + Y;
+		const int AA = m_permutationVec[A] + Z;
+		const int AB = m_permutationVec[A + 1] + Z;
+		const int B = m_permutationVec[X + 1] + Y;
+		const int BA = m_permutationVec[B] + Z;
+		const int BB = m_permutationVec[B + 1] + Z;
+		const double res = lerp(
+			lerp(
+				lerp( grad( m_permutationVec[AA], x, y, z ), grad( m_permutationVec[BA], x - 1, y, z ), u ),
+				lerp( grad( m_permutationVec[AB], x, y - 1, z ), grad( m_permutationVec[BB], x - 1, y - 1, z ), u ),
+				v ),
+			lerp(
+				lerp( grad( m_permutationVec[AA + 1], x, y, z - 1 ), grad( m_permutationVec[BA + 1], x - 1, y, z - 1 ), u ),
+				lerp( grad( m_permutationVec[AB + 1], x, y - 1, z - 1 ), grad( m_permutationVec[BB + 1], x - 1, y - 1, z - 1 ), u ),
+				v ),
+			w );
+		return ( res + 1.0 ) / 2.0;
+	}
+private:
+	static double fade( const double t )
+	{
+		return t * t * t * ( t * ( t * 6 - 15 ) + 10 );
+	}
+
+	static double lerp( const double a,
+		const double b,
+		const double t )
+	{
+		return a + t * ( b - a );
+	}
+
+	static double grad( const int hash,
+		const double x,
+		const double y,
+		const double z )
+	{
+		const int h = hash & 15;
+		const double u = h < 8 ?
+			x :
+			y;
+		const double v = h < 4 ?
+			y :
+			h == 12 || h == 14 ? x : z;
+		return ( ( h & 1 ) == 0 ? u : -u ) + ( ( h & 2 ) == 0 ? v : -v );
+	}
+};
+
+template<typename T>
+struct Points final
+{
+	std::vector<T> xs;
+	std::vector<T> ys;
+	std::vector<T> zs;
+};
+
+/// \brief	an odd count, so that the batches end with a scalar tail
+template<typename T>
+Points<T> makePoints( const std::size_t n,
+	const std::uint32_t seed )
+{
+	std::mt19937 rng{seed};
+	std::uniform_real_distribution<double> coordinate{-600.0, 600.0};
+	Points<T> points;
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+		points.xs.push_back( static_cast<T>( coordinate( rng ) ) );
+		points.ys.push_back( static_cast<T>( coordinate( rng ) ) );
+		points.zs.push_back( static_cast<T>( coordinate( rng ) ) );
+	}
+	return points;
+}
+
+std::vector<PerlinNoise::Fractal> makeFractals()
+{
+	std::vector<PerlinNoise::Fractal> fractals;
+	for ( const PerlinNoise::FractalType type : {PerlinNoise::FractalType::None, PerlinNoise::FractalType::Fbm, PerlinNoise::FractalType::Ridged, PerlinNoise::FractalType::Turbulence} )
+	{
+		for ( const double warpStrength : {0.0, 0.7} )
+		{
+			for ( const unsigned tilePeriod : {0u, 8u, 5u} )
+			{
+				PerlinNoise::Fractal fractal;
+				fractal.type = type;
+				fractal.nOctaves = 5u;
+				fractal.frequency = 0.37;
+				fractal.warpStrength = warpStrength;
+				fractal.tilePeriod = tilePeriod;
+				fractals.push_back( fractal );
+			}
+		}
+	}
+	return fractals;
+}
+
+/// \brief	the batch paths the CPU can run: AVX2 & SSE2 or just SSE2
+std::vector<util::CpuFeatures> makeBatchPaths()
+{
+	std::vector<util::CpuFeatures> paths{util::CpuFeatures{true, true, false}};
+	if ( util::getCpuFeatures().bAvx2 )
+	{
+		paths.push_back( util::CpuFeatures{true, true, true} );
+	}
+	return paths;
+}
+
+template<typename T>
+std::size_t countBatchMismatches( const PerlinNoise &perlin,
+	const Points<T> &points,
+	const PerlinNoise::Fractal &fractal )
+{
+	const std::size_t n = points.xs.size();
+	std::vector<T> out( n );
+	perlin.sample( points.xs.data(), points.ys.data(), points.zs.data(), out.data(), n, fractal );
+	std::size_t nMismatches = 0;
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+		const T expected = perlin.sample( points.xs[i], points.ys[i], points.zs[i], fractal );
+		nMismatches += std::memcmp( &expected, &out[i], sizeof( T ) ) != 0;
+	}
+	return nMismatches;
+}
+
+template<typename T>
+std::size_t countGridMismatches( const PerlinNoise &perlin,
+	const PerlinNoise::Grid &grid,
+	const PerlinNoise::Fractal &fractal,
+	const bool bParallel )
+{
+	std::vector<T> out( static_cast<std::size_t>( grid.width ) * grid.height * grid.depth );
+	perlin.fillGrid( out.data(), grid, fractal, bParallel );
+	std::size_t nMismatches = 0;
+	for ( unsigned k = 0; k < grid.depth; ++k )
+	{
+		for ( unsigned j = 0; j < grid.height; ++j )
+		{
+			for ( unsigned i = 0; i < grid.width; ++i )
+			{
+				const T expected = perlin.sample( static_cast<T>( grid.x0 + grid.dx * i ), static_cast<T>( grid.y0 + grid.dy * j ), static_cast<T>( grid.z0 + grid.dz * k ), fractal );
+				nMismatches += std::memcmp( &expected, &out[( static_cast<std::size_t>( k ) * grid.height + j ) * grid.width + i], sizeof( T ) ) != 0;
+			}
+		}
+	}
+	return nMismatches;
+}
+
+
+}//namespace
+
+TEST_CASE( "PerlinNoise matches the implementation it replaced", "[perlin_noise]" )
+{
+	const PerlinNoise perlin{1234u};
+	const OriginalNoise original{1234u};
+	const Points<double> points = makePoints<double>( 20001u, 7u );
+	std::vector<double> out( points.xs.size() );
+	perlin.sample( points.xs.data(), points.ys.data(), points.zs.data(), out.data(), out.size() );
+	std::size_t nMismatches = 0;
+	for ( std::size_t i = 0; i < out.size(); ++i )
+	{
+		const double expected = original.noise( points.xs[i], points.ys[i], points.zs[i] );
+		nMismatches += std::memcmp( &expected, &out[i], sizeof( double ) ) != 0;
+		nMismatches += perlin.noise( points.xs[i], points.ys[i], points.zs[i] ) != expected;
+	}
+	REQUIRE( nMismatches == 0u );
+}
+
+TEST_CASE( "PerlinNoise batches are bit identical to scalar samples on every path", "[perlin_noise]" )
+{
+	const PerlinNoise perlin{99u};
+	const Points<float> floatPoints = makePoints<float>( 4099u, 3u );
+	const Points<double> doublePoints = makePoints<double>( 4099u, 3u );
+	for ( const util::CpuFeatures &path : makeBatchPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		for ( const PerlinNoise::Fractal &fractal : makeFractals() )
+		{
+			REQUIRE( countBatchMismatches( perlin, floatPoints, fractal ) == 0u );
+			REQUIRE( countBatchMismatches( perlin, doublePoints, fractal ) == 0u );
+		}
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+}
+
+TEST_CASE( "PerlinNoise fillGrid is bit identical to scalar samples", "[perlin_noise]" )
+{
+	ThreadPoolJ::getInstance( 4u );
+	const PerlinNoise perlin{5u};
+	// wider than a block of columns & not a multiple of the lanes
+	const PerlinNoise::Grid grid{611u, 37u, 3u, 0.1, 0.2, 0.3, 0.013, 0.017, 0.5};
+	PerlinNoise::Fractal fractal;
+	fractal.type = PerlinNoise::FractalType::Fbm;
+	fractal.nOctaves = 4u;
+	fractal.warpStrength = 0.3;
+	for ( const util::CpuFeatures &path : makeBatchPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		for ( const bool bParallel : {false, true} )
+		{
+			REQUIRE( countGridMismatches<float>( perlin, grid, fractal, bParallel ) == 0u );
+			REQUIRE( countGridMismatches<double>( perlin, grid, fractal, bParallel ) == 0u );
+		}
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "PerlinNoise tiles every tilePeriod / frequency units", "[perlin_noise]" )
+{
+	const PerlinNoise perlin{42u};
+	const Points<double> points = makePoints<double>( 1000u, 11u );
+	for ( PerlinNoise::Fractal fractal : makeFractals() )
+	{
+		if ( fractal.tilePeriod == 0u )
+		{
+			continue;
+		}
+		const double period = fractal.tilePeriod / fractal.frequency;
+		std::size_t nMismatches = 0;
+		for ( std::size_t i = 0; i < points.xs.size(); ++i )
+		{
+			const double value = perlin.sample( points.xs[i], points.ys[i], points.zs[i], fractal );
+			const double tiled = perlin.sample( points.xs[i] + period, points.ys[i] - 2 * period, points.zs[i], fractal );
+			nMismatches += std::abs( value - tiled ) > 1e-9;
+		}
+		REQUIRE( nMismatches == 0u );
+	}
+}
+
+TEST_CASE( "PerlinNoise 4k grid samples per second", "[.][benchmark][perlin_noise]" )
+{
+	ThreadPoolJ::getInstance( 4u );
+	const PerlinNoise perlin{1u};
+	const OriginalNoise original{1u};
+	PerlinNoise::Grid grid{4096u, 4096u};
+	grid.dx = 1.0 / 64;
+	grid.dy = 1.0 / 64;
+	const double nSamples = double( grid.width ) * grid.height;
+	std::vector<float> image( static_cast<std::size_t>( grid.width ) * grid.height );
+
+	double checksum = 0.0;
+	const double originalMs = test::timeBestOf( 1,
+		[&] ()
+		{
+			for ( unsigned j = 0; j < grid.height; ++j )
+			{
+				for ( unsigned i = 0; i < grid.width; ++i )
+				{
+					checksum += original.noise( grid.dx * i, grid.dy * j, 0.0 );
+				}
+			}
+		} );
+	std::printf( "4096x4096 | original scalar %8.2f ms, %7.1f Msamples/s (checksum %g)\n", originalMs, nSamples / originalMs / 1e3, checksum );
+
+	for ( const unsigned nOctaves : {1u, 5u} )
+	{
+		PerlinNoise::Fractal fractal;
+		fractal.type = nOctaves == 1u ?
+			PerlinNoise::FractalType::None :
+			PerlinNoise::FractalType::Fbm;
+		fractal.nOctaves = nOctaves;
+		const double scalarMs = test::timeBestOf( 1,
+			[&] ()
+			{
+				for ( unsigned j = 0; j < grid.height; ++j )
+				{
+					for ( unsigned i = 0; i < grid.width; ++i )
+					{
+						image[j * grid.width + i] = perlin.sample( static_cast<float>( grid.dx * i ), static_cast<float>( grid.dy * j ), 0.0f, fractal );
+					}
+				}
+			} );
+		std::printf( "%u octaves | scalar float sample %8.2f ms, %7.1f Msamples/s\n", nOctaves, scalarMs, nSamples / scalarMs / 1e3 );
+		for ( const util::CpuFeatures &path : makeBatchPaths() )
+		{
+			util::restrictCpuFeatures( path );
+			for ( const bool bParallel : {false, true} )
+			{
+				const double ms = test::timeBestOf( 3,
+					[&] ()
+					{
+						perlin.fillGrid( image.data(), grid, fractal, bParallel );
+					} );
+				std::printf( "%u octaves | fillGrid %s%s %8.2f ms, %7.1f Msamples/s\n",
+					nOctaves, path.bAvx2 ? "AVX2" : "SSE2", bParallel ? " on 4 threads" : "", ms, nSamples / ms / 1e3 );
+			}
+		}
+		util::restrictCpuFeatures( {true, true, true} );
+	}
+	ThreadPoolJ::resetInstance();
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include "render_queue_sort.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	stands in for a bindable that occupies one pipeline slot; binding it is recorded instead of reaching a GPU
+struct MockBindable final
+{
+	int slot;
+};
+
+/// \brief	the pipeline state as the mock bindables leave it
+struct BindRecorder final
+{
+	std::vector<const MockBindable*> slots;
+	unsigned nBinds = 0u;
+
+	explicit BindRecorder( const int nSlots )
+		:
+		slots( nSlots, nullptr )
+	{
+
+	}
+
+	void bind( MockBindable &bindable )
+	{
+		slots[bindable.slot] = &bindable;
+		++nBinds;
+	}
+};
+
+/// \brief	a Material's worth of bindables: shared shader & texture bindables plus a per Mesh (cloned) one, which is never skipped
+struct MockJob final
+{
+	std::vector<std::shared_ptr<MockBindable>> bindables;
+	std::vector<std::uint8_t> skippable;
+	std::uint32_t shaderId;
+	std::uint32_t textureId;
+	float distance;
+};
+
+constexpr int s_shaderSlot = 0;
+constexpr int s_textureSlot = 1;
+constexpr int s_samplerSlot = 2;
+constexpr int s_clonedSlot = 3;
+
+std::vector<MockJob> makeJobs( const std::size_t nJobs,
+	const int nShaders,
+	const int nTextures,
+	std::mt19937 &rng )
+{
+	std::vector<std::shared_ptr<MockBindable>> shaders;
+	std::vector<std::shared_ptr<MockBindable>> textures;
+	for ( int i = 0; i < nShaders; ++i )
+	{
+		shaders.push_back( std::make_shared<MockBindable>( MockBindable{s_shaderSlot} ) );
+	}
+	for ( int i = 0; i < nTextures; ++i )
+	{
+		textures.push_back( std::make_shared<MockBindable>( MockBindable{s_textureSlot} ) );
+	}
+	const auto sampler = std::make_shared<MockBindable>( MockBindable{s_samplerSlot} );
+
+	std::vector<MockJob> jobs( nJobs );
+	for ( MockJob &job : jobs )
+	{
+		const int shader = rng() % nShaders;
+		const int texture = rng() % nTextures;
+		job.bindables = {shaders[shader], textures[texture], sampler, std::make_shared<MockBindable>( MockBindable{s_clonedSlot} )};
+		job.skippable = {1u, 1u, 1u, 0u};
+		job.shaderId = 0x9E3779B1u * ( shader + 1 );
+		job.textureId = 0x85EBCA77u * ( texture + 1 );
+		job.distance = std::uniform_real_distribution<float>{0.5f, 500.0f}( rng );
+	}
+	return jobs;
+}
+
+/// \brief	runs the Jobs in order & checks that every Job finds all of its bindables in place before drawing
+/// \return	the number of skipped binds
+unsigned runJobs( const std::vector<MockJob> &jobs,
+	const std::vector<ren::SortEntry> &order,
+	BindRecorder &recorder,
+	std::size_t &nWrongStates )
+{
+	unsigned nSkippedBinds = 0u;
+	const MockJob *pPrevious = nullptr;
+	for ( const auto &entry : order )
+	{
+		const MockJob &job = jobs[entry.m_jobIndex];
+		nSkippedBinds += ren::bindSkippingShared( job.bindables, job.skippable, pPrevious ? &pPrevious->bindables : nullptr,
+			[&recorder] ( MockBindable &bindable )
+			{
+				recorder.bind( bindable );
+			} );
+		for ( const auto &pBindable : job.bindables )
+		{
+			nWrongStates += recorder.slots[pBindable->slot] != pBindable.get();
+		}
+		pPrevious = &job;
+	}
+	return nSkippedBinds;
+}
+
+std::vector<ren::SortEntry> makeOrder( const std::vector<MockJob> &jobs,
+	const bool bTransparent )
+{
+	std::vector<ren::SortEntry> order;
+	for ( std::size_t i = 0; i < jobs.size(); ++i )
+	{
+		const MockJob &job = jobs[i];
+		const std::uint64_t key = bTransparent ?
+			ren::makeTransparentSortKey( job.shaderId, job.textureId, job.distance ) :
+			ren::makeOpaqueSortKey( job.shaderId, job.textureId, job.distance );
+		order.push_back( {key, static_cast<std::uint32_t>( i )} );
+	}
+	return order;
+}
+
+
+}//namespace
+
+TEST_CASE( "RenderQueue sortByKey is a stable sort by key", "[render_queue]" )
+{
+	std::mt19937_64 rng{1u};
+	std::vector<ren::SortEntry> scratch;
+	for ( const std::size_t n : {0u, 1u, 7u, 255u, 256u, 1000u, 70000u} )
+	{
+		// few distinct values in some bytes, so the radix passes over constant bytes are skipped & ties are common
+		for ( const std::uint64_t mask : {~0ull, 0xFF00000000FF00F0ull, 0x7ull} )
+		{
+			std::vector<ren::SortEntry> entries( n );
+			for ( std::size_t i = 0; i < n; ++i )
+			{
+				entries[i] = {rng() & mask, static_cast<std::uint32_t>( i )};
+			}
+			std::vector<ren::SortEntry> expected = entries;
+			std::stable_sort( expected.begin(), expected.end(), [] ( const ren::SortEntry &lhs, const ren::SortEntry &rhs ) { return lhs.m_key < rhs.m_key; } );
+
+			ren::sortByKey( entries, scratch );
+			REQUIRE( entries.size() == n );
+			std::size_t nMismatches = 0;
+			for ( std::size_t i = 0; i < n; ++i )
+			{
+				nMismatches += entries[i].m_key != expected[i].m_key;
+				nMismatches += entries[i].m_jobIndex != expected[i].m_jobIndex;
+			}
+			REQUIRE( nMismatches == 0u );
+		}
+	}
+}
+
+TEST_CASE( "RenderQueue sort keys group opaque state & order by depth", "[render_queue]" )
+{
+	const std::uint32_t shaderA = 0x00ABCDEFu;
+	const std::uint32_t shaderB = 0x00ABCDF0u;
+	const std::uint32_t texture = 0x1234u;
+	// opaque: state first, then front to back
+	REQUIRE( ren::makeOpaqueSortKey( shaderA, texture, 1000.0f ) < ren::makeOpaqueSortKey( shaderB, texture, 0.5f ) );
+	REQUIRE( ren::makeOpaqueSortKey( shaderA, texture, 1000.0f ) < ren::makeOpaqueSortKey( shaderA, texture + 1, 0.5f ) );
+	// transparent: back to front, whatever the state
+	REQUIRE( ren::makeTransparentSortKey( shaderB, texture, 10.0f ) < ren::makeTransparentSortKey( shaderA, texture, 9.0f ) );
+
+	std::mt19937 rng{2u};
+	std::uniform_real_distribution<float> distance{0.0f, 1e5f};
+	std::size_t nMisordered = 0;
+	for ( int i = 0; i < 100000; ++i )
+	{
+		const float d0 = distance( rng );
+		const float d1 = d0 + std::max( d0 * 1e-4f, 1e-3f );
+		nMisordered += !( ren::makeOpaqueSortKey( shaderA, texture, d0 ) < ren::makeOpaqueSortKey( shaderA, texture, d1 ) );
+		nMisordered += !( ren::makeTransparentSortKey( shaderA, texture, d0 ) > ren::makeTransparentSortKey( shaderB, texture, d1 ) );
+	}
+	REQUIRE( nMisordered == 0u );
+	// behind the camera counts as distance 0
+	REQUIRE( ren::makeOpaqueSortKey( shaderA, texture, -5.0f ) == ren::makeOpaqueSortKey( shaderA, texture, 0.0f ) );
+}
+
+TEST_CASE( "RenderQueue skipped binds leave the pipeline state of a full rebind", "[render_queue]" )
+{
+	std::mt19937 rng{3u};
+	for ( const bool bTransparent : {false, true} )
+	{
+		const std::vector<MockJob> jobs = makeJobs( 2000u, 6, 20, rng );
+		std::vector<ren::SortEntry> order = makeOrder( jobs, bTransparent );
+		std::vector<ren::SortEntry> scratch;
+		ren::sortByKey( order, scratch );
+
+		BindRecorder recorder{4};
+		std::size_t nWrongStates = 0;
+		const unsigned nSkipped = runJobs( jobs, order, recorder, nWrongStates );
+		REQUIRE( nWrongStates == 0u );
+		// every bindable was either bound or reported skipped
+		REQUIRE( recorder.nBinds + nSkipped == jobs.size() * 4u );
+		// the per Mesh bindable is bound by every Job
+		REQUIRE( nSkipped <= jobs.size() * 3u );
+
+		if ( !bTransparent )
+		{
+			// sorted by state only 6 shader & at most 6 * 20 texture changes remain; the sampler is bound once
+			REQUIRE( nSkipped >= ( jobs.size() - 6u ) + ( jobs.size() - 120u ) + ( jobs.size() - 1u ) );
+		}
+	}
+
+	// the first Job has no previous Job to share state with
+	const std::vector<MockJob> jobs = makeJobs( 1u, 1, 1, rng );
+	BindRecorder recorder{4};
+	std::size_t nWrongStates = 0;
+	REQUIRE( runJobs( jobs, makeOrder( jobs, false ), recorder, nWrongStates ) == 0u );
+	REQUIRE( recorder.nBinds == 4u );
+}
+
+TEST_CASE( "RenderQueue radix sort & state changes", "[.][benchmark][render_queue]" )
+{
+	std::mt19937 rng{4u};
+	for ( const std::size_t nJobs : {1000u, 10000u, 100000u} )
+	{
+		const std::vector<MockJob> jobs = makeJobs( nJobs, 16, 64, rng );
+		const std::vector<ren::SortEntry> unsorted = makeOrder( jobs, false );
+		std::vector<ren::SortEntry> order;
+		std::vector<ren::SortEntry> scratch;
+		const double radixMs = test::timeBestOf( 10,
+			[&] ()
+			{
+				order = unsorted;
+				ren::sortByKey( order, scratch );
+			} );
+
+		// the old queue: std::sort of ( Job, distance ) pairs by distance only
+		std::vector<std::pair<std::uint32_t, float>> byDistance;
+		const double stdSortMs = test::timeBestOf( 10,
+			[&] ()
+			{
+				byDistance.clear();
+				for ( std::uint32_t i = 0; i < nJobs; ++i )
+				{
+					byDistance.emplace_back( i, jobs[i].distance );
+				}
+				std::sort( byDistance.begin(), byDistance.end(), [] ( const auto &lhs, const auto &rhs ) { return lhs.second < rhs.second; } );
+			} );
+		std::vector<ren::SortEntry> distanceOrder;
+		for ( const auto &[jobIndex, distance] : byDistance )
+		{
+			distanceOrder.push_back( {0u, jobIndex} );
+		}
+
+		BindRecorder keyedRecorder{4};
+		BindRecorder distanceRecorder{4};
+		std::size_t nWrongStates = 0;
+		runJobs( jobs, order, keyedRecorder, nWrongStates );
+		runJobs( jobs, distanceOrder, distanceRecorder, nWrongStates );
+		std::printf( "%6zu Jobs | sort: keyed radix %7.3f ms, by distance std::sort %7.3f ms | binds: keyed %6u, by distance %6u, none skipped %6zu\n",
+			nJobs, radixMs, stdSortMs, keyedRecorder.nBinds, distanceRecorder.nBinds, nJobs * 4u );
+	}
+}
\ No newline at end of file
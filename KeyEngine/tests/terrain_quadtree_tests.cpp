@@ -0,0 +1,305 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <map>
+#include <random>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+#include "terrain_quadtree.h"
+
+
+namespace
+{
+
+struct TerrainSize final
+{
+	unsigned chunkQuads;
+	unsigned nChunksX;
+	unsigned nChunksY;
+
+	unsigned getLodCount() const noexcept
+	{
+		// down to a single quad per chunk
+		unsigned nLods = 0;
+		while ( ( chunkQuads >> nLods ) > 0 )
+		{
+			++nLods;
+		}
+		return nLods;
+	}
+
+	unsigned getVerticesX() const noexcept
+	{
+		return nChunksX * chunkQuads + 1;
+	}
+
+	unsigned getVerticesY() const noexcept
+	{
+		return nChunksY * chunkQuads + 1;
+	}
+};
+
+std::vector<TerrainSize> makeTerrainSizes()
+{
+	std::vector<TerrainSize> sizes;
+	for ( const unsigned chunkQuads : {4u, 8u, 32u} )
+	{
+		for ( const auto &[nChunksX, nChunksY] : {std::pair{1u, 1u}, {3u, 2u}, {7u, 7u}, {5u, 1u}} )
+		{
+			sizes.push_back( {chunkQuads, nChunksX, nChunksY} );
+		}
+	}
+	return sizes;
+}
+
+std::vector<float> makeHills( const TerrainSize &size )
+{
+	std::vector<float> heights( static_cast<std::size_t>( size.getVerticesX() ) * size.getVerticesY() );
+	for ( unsigned y = 0; y < size.getVerticesY(); ++y )
+	{
+		for ( unsigned x = 0; x < size.getVerticesX(); ++x )
+		{
+			heights[y * size.getVerticesX() + x] = std::sin( x * 0.3f ) * std::cos( y * 0.2f ) * 10.0f;
+		}
+	}
+	return heights;
+}
+
+/// \brief	counts the neighbouring chunks more than one LOD apart
+std::size_t countUnbalancedNeighbours( const TerrainSize &size,
+	const std::vector<unsigned> &lods )
+{
+	std::size_t nUnbalanced = 0;
+	for ( unsigned cy = 0; cy < size.nChunksY; ++cy )
+	{
+		for ( unsigned cx = 0; cx < size.nChunksX; ++cx )
+		{
+			const int lod = static_cast<int>( lods[cy * size.nChunksX + cx] );
+			if ( cx + 1 < size.nChunksX )
+			{
+				nUnbalanced += std::abs( lod - static_cast<int>( lods[cy * size.nChunksX + cx + 1] ) ) > 1;
+			}
+			if ( cy + 1 < size.nChunksY )
+			{
+				nUnbalanced += std::abs( lod - static_cast<int>( lods[( cy + 1 ) * size.nChunksX + cx] ) ) > 1;
+			}
+		}
+	}
+	return nUnbalanced;
+}
+
+/// \brief	counts the cracks & overlaps of the selected triangles, in the heightfield's vertex grid
+/// \brief	a watertight mesh uses every directed edge once, & the reverse of every interior edge too; its triangles are clockwise in xy & cover the whole grid
+std::size_t countCracks( const TerrainQuadtree &quadtree,
+	const TerrainSize &size,
+	const std::vector<TerrainQuadtree::Selection> &selection )
+{
+	const long verticesX = size.getVerticesX();
+	const long verticesY = size.getVerticesY();
+	const unsigned n = size.chunkQuads;
+	std::map<std::pair<long, long>, int> edges;
+	std::size_t nCracks = 0;
+	double area = 0.0;
+	for ( const TerrainQuadtree::Selection &selected : selection )
+	{
+		const TerrainQuadtree::IndexRange &range = quadtree.getIndexRange( selected.lod, selected.stitchMask );
+		const TerrainQuadtree::Chunk &chunk = quadtree.getChunks()[selected.chunk];
+		for ( unsigned t = 0; t < range.nIndices; t += 3 )
+		{
+			long vertices[3];
+			double x[3];
+			double y[3];
+			for ( int k = 0; k < 3; ++k )
+			{
+				const unsigned v = quadtree.getIndices()[range.startIndex + t + k];
+				const long gx = chunk.x * n + v % ( n + 1 );
+				const long gy = chunk.y * n + v / ( n + 1 );
+				vertices[k] = gy * verticesX + gx;
+				x[k] = double( gx );
+				y[k] = double( gy );
+			}
+			const double signedArea = ( ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( x[2] - x[0] ) * ( y[1] - y[0] ) ) / 2;
+			nCracks += !( signedArea < 0 );
+			area -= signedArea;
+			for ( int k = 0; k < 3; ++k )
+			{
+				++edges[{vertices[k], vertices[( k + 1 ) % 3]}];
+			}
+		}
+	}
+	nCracks += std::abs( area - double( size.nChunksX * n ) * ( size.nChunksY * n ) ) > 1e-6;
+	for ( const auto &[edge, count] : edges )
+	{
+		nCracks += count != 1;
+		if ( edges.find( {edge.second, edge.first} ) != edges.end() )
+		{
+			continue;
+		}
+		const long x0 = edge.first % verticesX;
+		const long y0 = edge.first / verticesX;
+		const long x1 = edge.second % verticesX;
+		const long y1 = edge.second / verticesX;
+		const bool bBorder = ( x0 == x1 && ( x0 == 0 || x0 == verticesX - 1 ) ) || ( y0 == y1 && ( y0 == 0 || y0 == verticesY - 1 ) );
+		nCracks += !bBorder;
+	}
+	return nCracks;
+}
+
+
+}//namespace
+
+TEST_CASE( "TerrainQuadtree selections are balanced & watertight", "[terrain_quadtree]" )
+{
+	std::mt19937 rng{1u};
+	std::uniform_real_distribution<float> position{-10.0f, 40.0f};
+	std::uniform_real_distribution<float> projectionScale{10.0f, 2000.0f};
+	for ( const TerrainSize &size : makeTerrainSizes() )
+	{
+		const std::vector<float> heights = makeHills( size );
+		TerrainQuadtree quadtree{heights.data(), size.nChunksX, size.nChunksY, size.chunkQuads, size.getLodCount(), -5.0f, -7.0f, 0.5f, 0.5f};
+		REQUIRE( quadtree.getChunks().size() == size.nChunksX * size.nChunksY );
+		for ( const TerrainQuadtree::Chunk &chunk : quadtree.getChunks() )
+		{
+			for ( unsigned lod = 1; lod < size.getLodCount(); ++lod )
+			{
+				REQUIRE( chunk.geometricErrors[lod] >= chunk.geometricErrors[lod - 1] );
+			}
+		}
+
+		for ( int view = 0; view < 30; ++view )
+		{
+			TerrainQuadtree::SelectionParams params;
+			params.viewPosition = {position( rng ), position( rng ), 20.0f};
+			params.projectionScale = projectionScale( rng );
+			const std::vector<TerrainQuadtree::Selection> &selection = quadtree.select( params );
+			REQUIRE( selection.size() == quadtree.getChunks().size() );
+			REQUIRE( countUnbalancedNeighbours( size, quadtree.getLods() ) == 0u );
+			REQUIRE( countCracks( quadtree, size, selection ) == 0u );
+		}
+	}
+}
+
+TEST_CASE( "TerrainQuadtree draws flat terrain at the coarsest LOD", "[terrain_quadtree]" )
+{
+	for ( const TerrainSize &size : makeTerrainSizes() )
+	{
+		const std::vector<float> heights( static_cast<std::size_t>( size.getVerticesX() ) * size.getVerticesY(), 3.0f );
+		TerrainQuadtree quadtree{heights.data(), size.nChunksX, size.nChunksY, size.chunkQuads, size.getLodCount(), 0.0f, 0.0f, 1.0f, 1.0f};
+		TerrainQuadtree::SelectionParams params;
+		params.viewPosition = {0.0f, 0.0f, 1.0f};
+		params.projectionScale = 1000.0f;
+		quadtree.select( params );
+		for ( const unsigned lod : quadtree.getLods() )
+		{
+			REQUIRE( lod == size.getLodCount() - 1 );
+		}
+	}
+}
+
+TEST_CASE( "TerrainQuadtree culls the chunks outside the frustum", "[terrain_quadtree]" )
+{
+	for ( const TerrainSize &size : makeTerrainSizes() )
+	{
+		const std::vector<float> heights( static_cast<std::size_t>( size.getVerticesX() ) * size.getVerticesY(), 3.0f );
+		TerrainQuadtree quadtree{heights.data(), size.nChunksX, size.nChunksY, size.chunkQuads, size.getLodCount(), 0.0f, 0.0f, 1.0f, 1.0f};
+		DirectX::XMFLOAT4 planes[6];
+		for ( DirectX::XMFLOAT4 &plane : planes )
+		{
+			plane = {0.0f, 0.0f, 0.0f, 1.0f};
+		}
+		TerrainQuadtree::SelectionParams params;
+		params.viewPosition = {0.0f, 0.0f, 1.0f};
+		params.projectionScale = 1000.0f;
+		params.pFrustumPlanes = planes;
+
+		// x >= 1000
+		planes[0] = {1.0f, 0.0f, 0.0f, -1000.0f};
+		REQUIRE( quadtree.select( params ).empty() );
+
+		// x >= half the width, which splits the chunk columns if there is more than one
+		const float halfWidth = float( size.nChunksX * size.chunkQuads ) / 2;
+		planes[0] = {1.0f, 0.0f, 0.0f, -halfWidth + 0.01f};
+		const std::vector<TerrainQuadtree::Selection> &selection = quadtree.select( params );
+		for ( const TerrainQuadtree::Selection &selected : selection )
+		{
+			REQUIRE( quadtree.getChunks()[selected.chunk].aabbMax.x >= halfWidth );
+		}
+		if ( size.nChunksX > 1 )
+		{
+			REQUIRE( selection.size() == ( size.nChunksX - size.nChunksX / 2 ) * size.nChunksY );
+		}
+	}
+}
+
+TEST_CASE( "TerrainQuadtree selects every view independently", "[terrain_quadtree]" )
+{
+	const TerrainSize size{32u, 7u, 7u};
+	const std::vector<float> heights = makeHills( size );
+	TerrainQuadtree quadtree{heights.data(), size.nChunksX, size.nChunksY, size.chunkQuads, size.getLodCount(), 0.0f, 0.0f, 1.0f, 1.0f};
+
+	// a camera on the terrain & a light far above it
+	TerrainQuadtree::SelectionParams cameraParams;
+	cameraParams.viewPosition = {5.0f, 5.0f, 12.0f};
+	cameraParams.projectionScale = 1000.0f;
+	TerrainQuadtree::SelectionParams lightParams;
+	lightParams.viewPosition = {112.0f, 112.0f, 2000.0f};
+	lightParams.projectionScale = 1000.0f;
+
+	TerrainQuadtree::SelectionResult camera;
+	TerrainQuadtree::SelectionResult light;
+	quadtree.select( cameraParams, camera );
+	quadtree.select( lightParams, light );
+	REQUIRE( camera.lods[0] < light.lods[0] );
+	REQUIRE( countUnbalancedNeighbours( size, camera.lods ) == 0u );
+	REQUIRE( countUnbalancedNeighbours( size, light.lods ) == 0u );
+	REQUIRE( countCracks( quadtree, size, light.selection ) == 0u );
+	// the stored selection matches & isn't touched by the const overload
+	quadtree.select( cameraParams );
+	quadtree.select( lightParams, light );
+	REQUIRE( quadtree.getLods() == camera.lods );
+
+	// passes recorded on several threads at once
+	std::vector<TerrainQuadtree::SelectionResult> results( 4u );
+	std::vector<std::thread> threads;
+	for ( std::size_t t = 0; t < results.size(); ++t )
+	{
+		threads.emplace_back( [&, t] ()
+			{
+				for ( int rep = 0; rep < 200; ++rep )
+				{
+					quadtree.select( t % 2 == 0 ? cameraParams : lightParams, results[t] );
+				}
+			} );
+	}
+	for ( auto &thread : threads )
+	{
+		thread.join();
+	}
+	for ( std::size_t t = 0; t < results.size(); ++t )
+	{
+		REQUIRE( results[t].lods == ( t % 2 == 0 ? camera.lods : light.lods ) );
+	}
+}
+
+TEST_CASE( "TerrainQuadtree orthographic selections don't depend on distance", "[terrain_quadtree]" )
+{
+	const TerrainSize size{8u, 5u, 5u};
+	const std::vector<float> heights = makeHills( size );
+	TerrainQuadtree quadtree{heights.data(), size.nChunksX, size.nChunksY, size.chunkQuads, size.getLodCount(), 0.0f, 0.0f, 1.0f, 1.0f};
+	TerrainQuadtree::SelectionParams params;
+	params.bOrthographic = true;
+	// pixels per unit
+	params.projectionScale = 1.5f;
+	params.viewPosition = {0.0f, 0.0f, 50.0f};
+	TerrainQuadtree::SelectionResult near;
+	quadtree.select( params, near );
+	params.viewPosition = {500.0f, -300.0f, 5000.0f};
+	TerrainQuadtree::SelectionResult far;
+	quadtree.select( params, far );
+	REQUIRE( near.lods == far.lods );
+	// every chunk's LOD 1 error is under 1.33 units & its LOD 2 error over 2, which come to under & over 2 pixels at 1.5 pixels per unit
+	for ( const unsigned lod : near.lods )
+	{
+		REQUIRE( lod == 1u );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,2 @@
+#define CATCH_CONFIG_MAIN	// catch writes its own main using this define
+#include "catch/catch.hpp"
\ No newline at end of file
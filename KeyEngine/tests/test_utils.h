@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+
+namespace test
+{
+
+/// \brief	the fastest of nRuns wall clock times of f(), in milliseconds
+template<typename F>
+double timeBestOf( const int nRuns,
+	F &&f )
+{
+	double best = 1e30;
+	for ( int i = 0; i < nRuns; ++i )
+	{
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		best = std::min( best, std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() );
+	}
+	return best;
+}
+
+
+}//namespace test
\ No newline at end of file
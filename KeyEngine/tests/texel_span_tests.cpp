@@ -0,0 +1,188 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include "texel_span.h"
+#include "cpu_features.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+std::vector<util::CpuFeatures> makeSpanPaths()
+{
+	std::vector<util::CpuFeatures> paths{util::CpuFeatures{true, true, false}};
+	if ( util::getCpuFeatures().bAvx2 )
+	{
+		paths.push_back( util::CpuFeatures{true, true, true} );
+	}
+	return paths;
+}
+
+/// \brief	Bitmap::colorToVector's mapping of a channel
+float unpackChannel( const std::uint32_t texel,
+	const unsigned shift )
+{
+	return float( ( texel >> shift ) & 0xFFu ) * ( 2.0f / 255.0f ) - 1.0f;
+}
+
+std::uint32_t packChannel( const float v )
+{
+	return static_cast<std::uint32_t>( std::clamp( ( v + 1.0f ) * ( 255.0f / 2.0f ), 0.0f, 255.0f ) + 0.5f );
+}
+
+std::vector<std::uint32_t> makeTexels( const std::size_t n,
+	const unsigned seed )
+{
+	std::mt19937 rng{seed};
+	std::vector<std::uint32_t> texels( n );
+	for ( std::uint32_t &texel : texels )
+	{
+		texel = rng();
+	}
+	return texels;
+}
+
+
+}//namespace
+
+TEST_CASE( "texel_span unpack matches Bitmap::colorToVector on every path", "[texel_span]" )
+{
+	// every byte value in every channel, at lengths that leave 0 to 7 texels past the AVX2 lanes
+	std::vector<std::uint32_t> texels( 256u );
+	for ( std::uint32_t i = 0; i < 256u; ++i )
+	{
+		texels[i] = ( ( 255u - i ) << 24 ) | ( i << 16 ) | ( ( ( i * 7u ) & 0xFFu ) << 8 ) | ( ( i * 13u ) & 0xFFu );
+	}
+	std::vector<float> r( 256u );
+	std::vector<float> g( 256u );
+	std::vector<float> b( 256u );
+	std::size_t nMismatches = 0;
+	for ( const util::CpuFeatures &path : makeSpanPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		for ( unsigned count = 249u; count <= 256u; ++count )
+		{
+			std::fill( r.begin(), r.end(), 9.0f );
+			texel_span::unpack( texels.data(), count, r.data(), g.data(), b.data() );
+			for ( unsigned i = 0; i < count; ++i )
+			{
+				nMismatches += r[i] != unpackChannel( texels[i], 16 ) || g[i] != unpackChannel( texels[i], 8 ) || b[i] != unpackChannel( texels[i], 0 );
+			}
+			nMismatches += std::count_if( r.begin() + count, r.end(), [] ( const float v ) { return v != 9.0f; } );
+		}
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+	REQUIRE( nMismatches == 0u );
+}
+
+TEST_CASE( "texel_span pack saturates, rounds half up & keeps alpha on every path", "[texel_span]" )
+{
+	constexpr unsigned n = 1003u;
+	std::mt19937 rng{3u};
+	std::uniform_real_distribution<float> distribution{-1.5f, 1.5f};
+	std::vector<float> r( n );
+	std::vector<float> g( n );
+	std::vector<float> b( n );
+	for ( unsigned i = 0; i < n; ++i )
+	{
+		r[i] = distribution( rng );
+		g[i] = distribution( rng );
+		b[i] = distribution( rng );
+	}
+	// the ends of the range & halfway between two bytes
+	r[0] = -1.0f;
+	g[0] = 1.0f;
+	b[0] = 100.5f / 127.5f - 1.0f;
+	const std::vector<std::uint32_t> original = makeTexels( n + 1u, 4u );
+	std::size_t nMismatches = 0;
+	for ( const util::CpuFeatures &path : makeSpanPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		std::vector<std::uint32_t> texels = original;
+		texel_span::pack( r.data(), g.data(), b.data(), n, texels.data() );
+		for ( unsigned i = 0; i < n; ++i )
+		{
+			const std::uint32_t expected = ( original[i] & 0xFF000000u ) | ( packChannel( r[i] ) << 16 ) | ( packChannel( g[i] ) << 8 ) | packChannel( b[i] );
+			nMismatches += texels[i] != expected;
+		}
+		// texels past count are untouched
+		nMismatches += texels[n] != original[n];
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+	REQUIRE( nMismatches == 0u );
+}
+
+TEST_CASE( "texel_span pack of unpack is the identity", "[texel_span]" )
+{
+	const std::vector<std::uint32_t> original = makeTexels( 4099u, 5u );
+	std::vector<float> r( original.size() );
+	std::vector<float> g( original.size() );
+	std::vector<float> b( original.size() );
+	for ( const util::CpuFeatures &path : makeSpanPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		std::vector<std::uint32_t> texels = original;
+		texel_span::unpack( texels.data(), static_cast<unsigned>( texels.size() ), r.data(), g.data(), b.data() );
+		texel_span::pack( r.data(), g.data(), b.data(), static_cast<unsigned>( texels.size() ), texels.data() );
+		REQUIRE( texels == original );
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+}
+
+TEST_CASE( "texel_span 4k texture unpack, transform & pack", "[.][benchmark][texel_span]" )
+{
+	// TextureProcessor::transformSpans' inner loop on one thread: 256 texel spans, brightened by 20%
+	constexpr unsigned size = 4096u;
+	constexpr unsigned spanLength = 256u;
+	constexpr double nTexels = double( size ) * size;
+	const std::vector<std::uint32_t> original = makeTexels( std::size_t( size ) * size, 6u );
+	std::vector<std::uint32_t> texels = original;
+	const auto brighten = [] ( float *p, const unsigned count )
+		{
+			for ( unsigned i = 0; i < count; ++i )
+			{
+				p[i] *= 1.2f;
+			}
+		};
+
+	// per texel like TextureProcessor::transformBitmap: unpack, transform & pack one texel at a time
+	const double perTexelMs = test::timeBestOf( 3,
+		[&] ()
+		{
+			for ( std::uint32_t &texel : texels )
+			{
+				float rgb[3] = {unpackChannel( texel, 16 ), unpackChannel( texel, 8 ), unpackChannel( texel, 0 )};
+				brighten( rgb, 3u );
+				texel = ( texel & 0xFF000000u ) | ( packChannel( rgb[0] ) << 16 ) | ( packChannel( rgb[1] ) << 8 ) | packChannel( rgb[2] );
+			}
+		} );
+	std::printf( "%ux%u | per texel %8.2f ms, %7.1f Mtexels/s\n", size, size, perTexelMs, nTexels / perTexelMs / 1e3 );
+	for ( const util::CpuFeatures &path : makeSpanPaths() )
+	{
+		util::restrictCpuFeatures( path );
+		texels = original;
+		const double ms = test::timeBestOf( 3,
+			[&] ()
+			{
+				alignas( 32 ) float r[spanLength];
+				alignas( 32 ) float g[spanLength];
+				alignas( 32 ) float b[spanLength];
+				for ( std::size_t x = 0; x < texels.size(); x += spanLength )
+				{
+					texel_span::unpack( texels.data() + x, spanLength, r, g, b );
+					brighten( r, spanLength );
+					brighten( g, spanLength );
+					brighten( b, spanLength );
+					texel_span::pack( r, g, b, spanLength, texels.data() + x );
+				}
+			} );
+		std::printf( "%ux%u | spans %s %8.2f ms, %7.1f Mtexels/s\n", size, size, path.bAvx2 ? "AVX2" : "SSE2", ms, nTexels / ms / 1e3 );
+	}
+	util::restrictCpuFeatures( {true, true, true} );
+}
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "catch/catch.hpp"
+#include <atomic>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include "thread_poolj.h"
+#include "test_utils.h"
+
+
+namespace
+{
+
+/// \brief	resets the ThreadPoolJ singleton when the test case ends, whatever its outcome
+struct PoolScope final
+{
+	ThreadPoolJ &pool;
+
+	PoolScope( const std::size_t nThreads,
+		const bool bEnabled = true )
+		:
+		pool{ThreadPoolJ::getInstance( nThreads, bEnabled )}
+	{
+
+	}
+
+	~PoolScope() noexcept
+	{
+		ThreadPoolJ::resetInstance();
+	}
+};
+
+/// \brief	the scheduler ThreadPoolJ replaced: a single std::queue of std::bind-ed std::functions, behind one mutex & condition variable
+class LockedQueuePool final
+{
+	using Task = std::function<void(nonstd::stop_token)>;
+
+	bool m_bEnabled = true;
+	std::vector<nonstd::jthread> m_pool;
+	std::queue<Task> m_tasks;
+	std::condition_variable m_cond;
+	std::mutex m_mu;
+public:
+	explicit LockedQueuePool( const std::size_t nThreads )
+	{
+		for ( std::size_t i = 0; i < nThreads; ++i )
+		{
+			m_pool.emplace_back( [this] ( nonstd::stop_token st )
+				{
+					while ( true )
+					{
+						Task task;
+						{
+							std::unique_lock<std::mutex> ul{m_mu};
+							m_cond.wait( ul, [this] { return !m_bEnabled || !m_tasks.empty(); } );
+							if ( !m_bEnabled && m_tasks.empty() )
+							{
+								return;
+							}
+							task = std::move( m_tasks.front() );
+							m_tasks.pop();
+						}
+						task( st );
+					}
+				} );
+		}
+	}
+
+	~LockedQueuePool() noexcept
+	{
+		{
+			std::unique_lock<std::mutex> ul{m_mu};
+			m_bEnabled = false;
+		}
+		m_cond.notify_all();
+	}
+
+	template<typename TCallable, typename... TArgs>
+	void enqueue( TCallable &&f,
+		TArgs &&...args )
+	{
+		auto task = std::bind( std::forward<TCallable>( f ), std::placeholders::_1, std::forward<TArgs>( args )... );
+		{
+			std::unique_lock<std::mutex> ul{m_mu};
+			m_tasks.emplace( std::move( task ) );
+		}
+		m_cond.notify_one();
+	}
+};
+
+struct LatencyStats final
+{
+	double tasksPerMs;
+	double p50Us;
+	double p99Us;
+	double maxUs;
+};
+
+/// \brief	enqueues nBatches of batchSize Tasks that record the delay from their enqueue to their start, waiting for each batch
+template<typename TEnqueue>
+LatencyStats measure( const std::size_t nBatches,
+	const std::size_t batchSize,
+	const TEnqueue &enqueue )
+{
+	using Clock = std::chrono::steady_clock;
+	std::vector<double> latenciesUs( nBatches * batchSize );
+	std::atomic<std::size_t> nDone{0};
+	const auto start = Clock::now();
+	for ( std::size_t b = 0; b < nBatches; ++b )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			double *pLatency = &latenciesUs[b * batchSize + i];
+			const auto enqueuedAt = Clock::now();
+			enqueue( [pLatency, enqueuedAt, &nDone] ( nonstd::stop_token )
+				{
+					*pLatency = std::chrono::duration<double, std::micro>( Clock::now() - enqueuedAt ).count();
+					nDone.fetch_add( 1u, std::memory_order_release );
+				} );
+		}
+		while ( nDone.load( std::memory_order_acquire ) < ( b + 1 ) * batchSize )
+		{
+			std::this_thread::yield();
+		}
+	}
+	const double elapsedMs = std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+	std::sort( latenciesUs.begin(), latenciesUs.end() );
+	return LatencyStats{latenciesUs.size() / elapsedMs, latenciesUs[latenciesUs.size() / 2], latenciesUs[latenciesUs.size() * 99 / 100], latenciesUs.back()};
+}
+
+
+}//namespace
+
+TEST_CASE( "ThreadPoolJ parallelFor visits every index once", "[thread_pool]" )
+{
+	PoolScope scope{4u};
+	constexpr std::size_t n = 100003u;
+	for ( const std::size_t grainSize : {0u, 1u, 7u, 4096u, 200000u} )
+	{
+		// Catch's assertions aren't thread safe, failures are counted & checked on this thread
+		std::vector<std::atomic<int>> hits( n );
+		std::atomic<int> nBadRanges{0};
+		scope.pool.parallelFor( 0u, n, grainSize,
+			[&hits, &nBadRanges, grainSize] ( const std::size_t first, const std::size_t last )
+			{
+				if ( first >= last || ( grainSize > 0 && last - first > grainSize ) )
+				{
+					nBadRanges.fetch_add( 1 );
+				}
+				for ( std::size_t i = first; i < last; ++i )
+				{
+					hits[i].fetch_add( 1 );
+				}
+			} );
+		REQUIRE( nBadRanges.load() == 0 );
+		std::size_t nWrong = 0;
+		for ( const auto &hit : hits )
+		{
+			nWrong += hit.load() != 1;
+		}
+		REQUIRE( nWrong == 0 );
+	}
+}
+
+TEST_CASE( "ThreadPoolJ parallelFor nests without deadlocking", "[thread_pool]" )
+{
+	PoolScope scope{4u};
+	std::atomic<std::size_t> sum{0};
+	scope.pool.parallelFor( 0u, 64u, 1u,
+		[&] ( const std::size_t first, const std::size_t last )
+		{
+			for ( std::size_t i = first; i < last; ++i )
+			{
+				scope.pool.parallelFor( 0u, 1000u, 10u,
+					[&sum] ( const std::size_t innerFirst, const std::size_t innerLast )
+					{
+						sum.fetch_add( innerLast - innerFirst );
+					} );
+			}
+		} );
+	REQUIRE( sum.load() == 64u * 1000u );
+}
+
+TEST_CASE( "ThreadPoolJ runs every enqueued Task", "[thread_pool]" )
+{
+	PoolScope scope{4u};
+	std::atomic<int> count{0};
+	for ( int batch = 0; batch < 50; ++batch )
+	{
+		std::vector<ThreadPoolJ::TaskHandle> handles;
+		for ( int i = 0; i < 400; ++i )
+		{
+			handles.push_back( scope.pool.enqueue( [&count] ( nonstd::stop_token, const int increment ) { count.fetch_add( increment ); }, 2 ) );
+		}
+		for ( const auto &handle : handles )
+		{
+			scope.pool.wait( handle );
+			REQUIRE( handle.isDone() );
+		}
+	}
+	REQUIRE( count.load() == 50 * 400 * 2 );
+	REQUIRE( ThreadPoolJ::TaskHandle{}.isDone() );
+}
+
+TEST_CASE( "ThreadPoolJ continuations run after all of their dependencies", "[thread_pool]" )
+{
+	PoolScope scope{4u};
+	for ( int rep = 0; rep < 200; ++rep )
+	{
+		std::atomic<int> nFinished{0};
+		std::atomic<int> nFinishedBeforeContinuation{-1};
+		std::vector<ThreadPoolJ::TaskHandle> dependencies;
+		for ( int i = 0; i < 3; ++i )
+		{
+			dependencies.push_back( scope.pool.enqueue( [&nFinished, i] ( nonstd::stop_token )
+				{
+					std::this_thread::sleep_for( std::chrono::microseconds( 50 * i ) );
+					nFinished.fetch_add( 1 );
+				} ) );
+		}
+		const auto continuation = scope.pool.enqueueAfter( {dependencies[0], dependencies[1], dependencies[2]},
+			[&] ( nonstd::stop_token )
+			{
+				nFinishedBeforeContinuation = nFinished.load();
+			} );
+		int chainResult = 0;
+		const auto chained = scope.pool.enqueueAfter( continuation, [&] ( nonstd::stop_token ) { chainResult = nFinishedBeforeContinuation.load() + 1; } );
+		scope.pool.wait( chained );
+		REQUIRE( nFinishedBeforeContinuation.load() == 3 );
+		REQUIRE( chainResult == 4 );
+	}
+}
+
+TEST_CASE( "ThreadPoolJ signals the stop_token of running Tasks on stop", "[thread_pool]" )
+{
+	std::atomic<bool> bStarted{false};
+	std::atomic<bool> bStopped{false};
+	{
+		PoolScope scope{2u};
+		scope.pool.enqueue( [&] ( nonstd::stop_token st )
+			{
+				bStarted = true;
+				while ( !st.stop_requested() )
+				{
+					std::this_thread::yield();
+				}
+				bStopped = true;
+			} );
+		while ( !bStarted )
+		{
+			std::this_thread::yield();
+		}
+	}
+	REQUIRE( bStopped.load() );
+}
+
+TEST_CASE( "ThreadPoolJ disabled rejects Tasks & runs parallelFor serially", "[thread_pool]" )
+{
+	PoolScope scope{2u, false};
+	REQUIRE_FALSE( scope.pool.isEnabled() );
+	REQUIRE_THROWS_AS( scope.pool.enqueue( [] ( nonstd::stop_token ) {} ), KeyException );
+
+	const auto caller = std::this_thread::get_id();
+	std::size_t nVisited = 0;
+	scope.pool.parallelFor( 0u, 1000u, 10u,
+		[&] ( const std::size_t first, const std::size_t last )
+		{
+			REQUIRE( std::this_thread::get_id() == caller );
+			nVisited += last - first;
+		} );
+	REQUIRE( nVisited == 1000u );
+}
+
+TEST_CASE( "ThreadPoolJ vs locked queue task throughput & latency", "[.][benchmark][thread_pool]" )
+{
+	constexpr std::size_t nBatches = 200u;
+	constexpr std::size_t batchSize = 1000u;
+	const std::size_t nMaxThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	std::printf( "%zu batches of %zu empty Tasks, latency = enqueue to start\n", nBatches, batchSize );
+	for ( std::size_t nThreads = 1; nThreads <= nMaxThreads; nThreads = nThreads < nMaxThreads ? std::min( nThreads * 2, nMaxThreads ) : nThreads + 1 )
+	{
+		LatencyStats locked;
+		{
+			LockedQueuePool pool{nThreads};
+			locked = measure( nBatches, batchSize, [&pool] ( auto &&task ) { pool.enqueue( task ); } );
+		}
+		LatencyStats stealing;
+		{
+			PoolScope scope{nThreads};
+			stealing = measure( nBatches, batchSize, [&scope] ( auto &&task ) { scope.pool.enqueue( task ); } );
+		}
+		std::printf( "%2zu threads | locked queue %8.0f tasks/ms p50 %7.1f us p99 %7.1f us max %8.1f us | work stealing %8.0f tasks/ms p50 %7.1f us p99 %7.1f us max %8.1f us\n",
+			nThreads, locked.tasksPerMs, locked.p50Us, locked.p99Us, locked.maxUs, stealing.tasksPerMs, stealing.p50Us, stealing.p99Us, stealing.maxUs );
+	}
+}
+
+TEST_CASE( "ThreadPoolJ parallelFor scaling", "[.][benchmark][thread_pool]" )
+{
+	std::vector<float> data( 1u << 24 );
+	for ( std::size_t i = 0; i < data.size(); ++i )
+	{
+		data[i] = float( i % 1000 );
+	}
+	const std::size_t nMaxThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	for ( std::size_t nThreads = 1; nThreads <= nMaxThreads; nThreads *= 2 )
+	{
+		PoolScope scope{nThreads};
+		const double ms = test::timeBestOf( 5,
+			[&] ()
+			{
+				scope.pool.parallelFor( 0u, data.size(), 0u,
+					[&data] ( const std::size_t first, const std::size_t last )
+					{
+						for ( std::size_t i = first; i < last; ++i )
+						{
+							data[i] = data[i] * 0.5f + 1.0f;
+						}
+					} );
+			} );
+		std::printf( "%2zu threads | parallelFor over %zu floats %.2f ms\n", nThreads, data.size(), ms );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "catch/catch.hpp"
+#include <vector>
+#include <memory>
+#include <string>
+#include <random>
+#include <cstdio>
+#include "transform_hierarchy.h"
+#include "node.h"
+#include "mesh.h"
+#include "thread_poolj.h"
+#include "test_utils.h"
+
+
+namespace dx = DirectX;
+
+// node.cpp & mesh.cpp pull in the renderer, so the Node & Mesh members TransformHierarchy relies on are defined here instead:
+//	a Node's imgui id is its creation order & its local transform is the translation s_translations[imguiId]
+namespace
+{
+
+std::vector<dx::XMFLOAT3> s_translations;
+std::vector<int> s_nLocalUpdates;
+std::vector<std::uint32_t> s_hierarchyIndices;
+
+
+}//namespace
+
+Node::Node( Node *pParent,
+	const int imguiId,
+	const std::string &name,
+	const dx::XMMATRIX &,
+	std::vector<Mesh*> meshes )
+	:
+	m_imguiId{imguiId},
+	m_name{name},
+	m_pParent{pParent},
+	m_meshes{std::move( meshes )}
+{
+	if ( pParent != nullptr )
+	{
+		pParent->m_children.emplace_back( this );
+	}
+}
+
+Node::~Node() noexcept
+{
+	m_children.clear();
+}
+
+int Node::getImguiId() const noexcept
+{
+	return m_imguiId;
+}
+
+void Node::updateLocalTransform( const float,
+	const float,
+	const bool ) cond_noex
+{
+	++s_nLocalUpdates[m_imguiId];
+	s_hierarchyIndices[m_imguiId] = m_hierarchyIndex;
+	const dx::XMFLOAT3 &t = s_translations[m_imguiId];
+	m_pTransformHierarchy->setLocalTransform( m_hierarchyIndex, dx::XMMatrixTranslation( t.x, t.y, t.z ) );
+}
+
+void Mesh::update( const float,
+	const float ) cond_noex
+{
+
+}
+
+namespace
+{
+
+/// \brief	a random tree whose Nodes have integer translations, so world translations are exact sums
+struct Scene final
+{
+	std::unique_ptr<Node> pRoot;
+	std::vector<Node*> nodes;
+	std::vector<int> parents;	// by creation order, -1 for the root
+
+	Scene( const std::size_t nNodes,
+		const std::uint32_t seed )
+	{
+		std::mt19937 rng{seed};
+		s_translations.assign( nNodes, dx::XMFLOAT3{0.0f, 0.0f, 0.0f} );
+		s_nLocalUpdates.assign( nNodes, 0 );
+		s_hierarchyIndices.assign( nNodes, 0u );
+		for ( std::size_t i = 0; i < nNodes; ++i )
+		{
+			// recent Nodes are preferred as parents, for hierarchies a few dozen levels deep
+			const int parent = i == 0 ? -1 : static_cast<int>( i - 1 - rng() % std::min<std::size_t>( i, 16u ) );
+			Node *pNode = new Node{parent < 0 ? nullptr : nodes[parent], static_cast<int>( i ), "node", dx::XMMatrixIdentity(), {}};
+			if ( parent < 0 )
+			{
+				pRoot.reset( pNode );
+			}
+			nodes.push_back( pNode );
+			parents.push_back( parent );
+			s_translations[i] = {float( rng() % 17 ) - 8.0f, float( rng() % 5 ), float( rng() % 9 ) - 4.0f};
+		}
+	}
+
+	dx::XMFLOAT3 getExpectedPosition( const int i ) const
+	{
+		dx::XMFLOAT3 sum = s_translations[i];
+		for ( int p = parents[i]; p >= 0; p = parents[p] )
+		{
+			sum = {sum.x + s_translations[p].x, sum.y + s_translations[p].y, sum.z + s_translations[p].z};
+		}
+		return sum;
+	}
+
+	/// \brief	returns the number of Nodes whose world translation isn't the sum of their ancestors'
+	std::size_t countWrongWorldTransforms( const TransformHierarchy &hierarchy ) const
+	{
+		std::size_t nWrong = 0;
+		for ( std::size_t i = 0; i < nodes.size(); ++i )
+		{
+			const dx::XMFLOAT4X4 &world = hierarchy.getWorldTransform( s_hierarchyIndices[i] );
+			const dx::XMFLOAT3 expected = getExpectedPosition( static_cast<int>( i ) );
+			nWrong += world.m[3][0] != expected.x || world.m[3][1] != expected.y || world.m[3][2] != expected.z || world.m[0][0] != 1.0f;
+		}
+		return nWrong;
+	}
+};
+
+/// \brief	the recursive scene graph TransformHierarchy replaced: matrices stored inline in every Node, next to its name & children
+struct RecursiveNode final
+{
+	std::string name;
+	std::vector<std::unique_ptr<RecursiveNode>> children;
+	dx::XMFLOAT4X4 localTransform;
+	dx::XMFLOAT4X4 worldTransform;
+
+	void update( const dx::XMMATRIX &parentWorld )
+	{
+		const dx::XMMATRIX world = dx::XMLoadFloat4x4( &localTransform ) * parentWorld;
+		dx::XMStoreFloat4x4( &worldTransform, world );
+		for ( auto &pChild : children )
+		{
+			pChild->update( world );
+		}
+	}
+};
+
+
+}//namespace
+
+TEST_CASE( "TransformHierarchy world transforms compose the ancestors' local transforms", "[transform_hierarchy]" )
+{
+	ThreadPoolJ::getInstance();
+	// below & above the parallel threshold
+	for ( const std::size_t nNodes : {100u, 3000u} )
+	{
+		Scene scene{nNodes, 1u};
+		TransformHierarchy hierarchy;
+		hierarchy.build( *scene.pRoot );
+		REQUIRE( hierarchy.getNodeCount() == nNodes );
+		hierarchy.update( 0.016f, 0.0f );
+		for ( const int n : s_nLocalUpdates )
+		{
+			REQUIRE( n == 1 );
+		}
+		REQUIRE( scene.countWrongWorldTransforms( hierarchy ) == 0u );
+	}
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "TransformHierarchy only recomputes dirty subtrees", "[transform_hierarchy]" )
+{
+	ThreadPoolJ::getInstance();
+	for ( const std::size_t nNodes : {100u, 3000u} )
+	{
+		Scene scene{nNodes, 2u};
+		TransformHierarchy hierarchy;
+		hierarchy.build( *scene.pRoot );
+		hierarchy.update( 0.016f, 0.0f );
+
+		// nothing changed
+		s_nLocalUpdates.assign( nNodes, 0 );
+		hierarchy.update( 0.016f, 0.0f );
+		std::size_t nUpdated = 0;
+		for ( const int n : s_nLocalUpdates )
+		{
+			nUpdated += n;
+		}
+		REQUIRE( nUpdated == 0u );
+
+		// a child whose parent is clean picks up the parent's current world transform, & its own descendants follow
+		std::mt19937 rng{3u};
+		for ( int rep = 0; rep < 20; ++rep )
+		{
+			s_nLocalUpdates.assign( nNodes, 0 );
+			const std::size_t changed = 1 + rng() % ( nNodes - 1 );
+			s_translations[changed].x += 3.0f;
+			hierarchy.markDirty( s_hierarchyIndices[changed] );
+			hierarchy.update( 0.016f, 0.0f );
+			for ( std::size_t i = 0; i < nNodes; ++i )
+			{
+				REQUIRE( s_nLocalUpdates[i] == ( i == changed ? 1 : 0 ) );
+			}
+			REQUIRE( scene.countWrongWorldTransforms( hierarchy ) == 0u );
+		}
+	}
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "TransformHierarchy world transform overrides propagate to the children", "[transform_hierarchy]" )
+{
+	ThreadPoolJ::getInstance();
+	Scene scene{200u, 4u};
+	TransformHierarchy hierarchy;
+	hierarchy.build( *scene.pRoot );
+	hierarchy.update( 0.016f, 0.0f );
+
+	// move the root by setting its world transform, as Model::setTransform does
+	const dx::XMFLOAT3 offset{100.0f, -50.0f, 25.0f};
+	s_translations[0] = {s_translations[0].x + offset.x, s_translations[0].y + offset.y, s_translations[0].z + offset.z};
+	hierarchy.setWorldTransform( s_hierarchyIndices[0], dx::XMMatrixTranslation( s_translations[0].x, s_translations[0].y, s_translations[0].z ) );
+	s_nLocalUpdates.assign( 200u, 0 );
+	hierarchy.update( 0.016f, 0.0f );
+	REQUIRE( s_nLocalUpdates[0] == 0 );
+	REQUIRE( scene.countWrongWorldTransforms( hierarchy ) == 0u );
+	ThreadPoolJ::resetInstance();
+}
+
+TEST_CASE( "TransformHierarchy vs recursive update of 10k animated Nodes", "[.][benchmark][transform_hierarchy]" )
+{
+	constexpr std::size_t nNodes = 10000u;
+	Scene scene{nNodes, 5u};
+	std::vector<RecursiveNode*> recursiveNodes( nNodes );
+	std::unique_ptr<RecursiveNode> pRecursiveRoot = std::make_unique<RecursiveNode>();
+	recursiveNodes[0] = pRecursiveRoot.get();
+	for ( std::size_t i = 1; i < nNodes; ++i )
+	{
+		auto &children = recursiveNodes[scene.parents[i]]->children;
+		children.push_back( std::make_unique<RecursiveNode>() );
+		children.back()->name = "node";
+		recursiveNodes[i] = children.back().get();
+	}
+
+	for ( const std::size_t nThreads : {1u, 4u} )
+	{
+		ThreadPoolJ::getInstance( nThreads );
+		TransformHierarchy hierarchy;
+		hierarchy.build( *scene.pRoot );
+		hierarchy.update( 0.016f, 0.0f );
+		float frame = 0.0f;
+		const double flatMs = test::timeBestOf( 20,
+			[&] ()
+			{
+				frame += 1.0f;
+				for ( std::size_t i = 0; i < nNodes; ++i )
+				{
+					s_translations[i].y = frame;
+					hierarchy.markDirty( s_hierarchyIndices[i] );
+				}
+				hierarchy.update( 0.016f, 0.0f );
+			} );
+		const double recursiveMs = test::timeBestOf( 20,
+			[&] ()
+			{
+				frame += 1.0f;
+				for ( std::size_t i = 0; i < nNodes; ++i )
+				{
+					s_translations[i].y = frame;
+					dx::XMStoreFloat4x4( &recursiveNodes[i]->localTransform, dx::XMMatrixTranslation( s_translations[i].x, s_translations[i].y, s_translations[i].z ) );
+				}
+				pRecursiveRoot->update( dx::XMMatrixIdentity() );
+			} );
+		// a single animated Node
+		const double oneDirtyMs = test::timeBestOf( 20,
+			[&] ()
+			{
+				s_translations[nNodes / 2].y += 1.0f;
+				hierarchy.markDirty( s_hierarchyIndices[nNodes / 2] );
+				hierarchy.update( 0.016f, 0.0f );
+			} );
+		std::printf( "%zu threads | %zu animated Nodes | recursive %7.3f ms | flattened %7.3f ms | one dirty Node %7.3f ms\n", nThreads, nNodes, recursiveMs, flatMs, oneDirtyMs );
+		ThreadPoolJ::resetInstance();
+	}
+}
\ No newline at end of file
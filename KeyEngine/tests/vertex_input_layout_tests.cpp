@@ -0,0 +1,47 @@
+#include "catch/catch.hpp"
+#include <string>
+#include <cstring>
+#include "dynamic_vertex_buffer.h"
+
+
+TEST_CASE( "VertexInputLayout per-instance elements", "[vertex_input_layout]" )
+{
+	using Layout = ver::VertexInputLayout;
+	Layout layout;
+	layout.add( Layout::Position3D ).add( Layout::Normal );
+	const std::string vertexOnlySignature = layout.calcSignature();
+	REQUIRE_FALSE( layout.hasInstanceElements() );
+	REQUIRE( layout.getInstanceSizeInBytes() == 0u );
+
+	// adding an instance element twice is a no-op
+	layout.addInstance( Layout::InstanceTransform ).addInstance( Layout::InstanceFloat4Color ).addInstance( Layout::InstanceTransform );
+	REQUIRE( layout.hasInstanceElements() );
+	REQUIRE( layout.getInstanceSizeInBytes() == 16u * 4u + 16u );
+	// instanced & non instanced layouts must not share an InputLayout
+	REQUIRE( layout.calcSignature() != vertexOnlySignature );
+
+	const auto descs = layout.getD3DInputElementDescs();
+	REQUIRE( descs.size() == 2u + 4u + 1u );
+	for ( unsigned i = 0; i < 2; ++i )
+	{
+		REQUIRE( descs[i].InputSlot == 0u );
+		REQUIRE( descs[i].InputSlotClass == D3D11_INPUT_PER_VERTEX_DATA );
+	}
+	// the transform takes a float4 per row, at consecutive semantic indices
+	for ( unsigned row = 0; row < 4; ++row )
+	{
+		const D3D11_INPUT_ELEMENT_DESC &desc = descs[2 + row];
+		REQUIRE( std::strcmp( desc.SemanticName, "InstanceTransform" ) == 0 );
+		REQUIRE( desc.SemanticIndex == row );
+		REQUIRE( desc.Format == DXGI_FORMAT_R32G32B32A32_FLOAT );
+		REQUIRE( desc.InputSlot == Layout::s_instanceInputSlot );
+		REQUIRE( desc.AlignedByteOffset == row * 16u );
+		REQUIRE( desc.InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA );
+		REQUIRE( desc.InstanceDataStepRate == 1u );
+	}
+	const D3D11_INPUT_ELEMENT_DESC &color = descs[6];
+	REQUIRE( std::strcmp( color.SemanticName, "InstanceColor" ) == 0 );
+	REQUIRE( color.SemanticIndex == 0u );
+	REQUIRE( color.AlignedByteOffset == 64u );
+	REQUIRE( color.InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA );
+}
\ No newline at end of file